@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+/**
+ * @file foedus/cache/warm_start_perf.cpp
+ * @brief Measures how fast read throughput recovers after restart, with and without warm-start
+ * @details
+ * This experiment first populates an array storage, takes a snapshot that drops all volatile
+ * pages, and runs random reads so that the snapshot cache holds the hot pages. Shutting down
+ * writes out the manifest of the snapshot cache. Then it restarts the engine twice:
+ *  \li First without CacheOptions::snapshot_cache_warm_start_, which starts with an empty cache.
+ *  \li Then with it, which loads the pages in the manifest in the background.
+ *
+ * The cold restart comes first because it does not overwrite the manifest.
+ * After each restart, one thread runs random reads and counts them in windows of --window_ms.
+ * The steady-state throughput is the average of the last quarter of the windows, and we report
+ * the time until the first window that reaches 90% of it.
+ */
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/assorted/assorted_func.hpp"
+#include "foedus/assorted/uniform_random.hpp"
+#include "foedus/debugging/stop_watch.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/impersonate_session.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace cache {
+
+DEFINE_int64(records, 1 << 18, "Number of records in the array storage.");
+DEFINE_int32(payload, 64, "Payload size of each record.");
+DEFINE_int32(duration_ms, 3000, "Duration of the reads after each restart in milliseconds.");
+DEFINE_int32(window_ms, 50, "Reads are counted in windows of this length in milliseconds.");
+DEFINE_int32(volatile_pool_size, 256, "Size of volatile memory pool per NUMA node in MB.");
+DEFINE_int32(snapshot_pool_size, 256, "Size of snapshot memory pool per NUMA node in MB.");
+DEFINE_int32(log_buffer_mb, 64, "Size of log buffer for each thread in MB.");
+DEFINE_string(folder, "/dev/shm/foedus_warm_start", "Folder to place logs and snapshots.");
+
+const uint32_t kRecordsPerXct = 64;
+const uint32_t kReadsPerXct = 16;
+
+ErrorStack populate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, "aaa");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  const uint64_t records = FLAGS_records;
+  Epoch commit_epoch;
+  for (uint64_t i = 0; i < records; i += kRecordsPerXct) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    const uint64_t end = std::min<uint64_t>(records, i + kRecordsPerXct);
+    for (uint64_t j = i; j < end; ++j) {
+      WRAP_ERROR_CODE(array.overwrite_record_primitive<uint64_t>(context, j, j, 0));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+/** Output is the number of reads in each window */
+ErrorStack read_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, "aaa");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  const uint32_t windows = FLAGS_duration_ms / FLAGS_window_ms;
+  uint64_t* counts = reinterpret_cast<uint64_t*>(args.output_buffer_);
+  ASSERT_ND(windows * sizeof(uint64_t) <= args.output_buffer_size_);
+  std::fill(counts, counts + windows, 0);
+  assorted::UniformRandom random(context->get_thread_id());
+  debugging::StopWatch watch;
+  while (true) {
+    const uint64_t window = watch.peek_elapsed_ns() / 1000000ULL / FLAGS_window_ms;
+    if (window >= windows) {
+      break;
+    }
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSnapshot));
+    for (uint32_t i = 0; i < kReadsPerXct; ++i) {
+      uint64_t value;
+      const storage::array::ArrayOffset offset = random.next_uint64() % FLAGS_records;
+      WRAP_ERROR_CODE(array.get_record_primitive<uint64_t>(context, offset, &value, 0));
+    }
+    Epoch commit_epoch;
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+    counts[window] += kReadsPerXct;
+  }
+  *args.output_used_ = windows * sizeof(uint64_t);
+  return kRetOk;
+}
+
+EngineOptions make_options(bool warm_start) {
+  EngineOptions options;
+  fs::Path savepoint_path(FLAGS_folder);
+  savepoint_path /= "savepoint.xml";
+  options.savepoint_.savepoint_path_.assign(savepoint_path.string());
+  options.snapshot_.folder_path_pattern_.assign(FLAGS_folder + "/snapshot/node_$NODE$");
+  options.snapshot_.snapshot_interval_milliseconds_ = 100000000U;
+  options.log_.folder_path_pattern_.assign(FLAGS_folder + "/log/node_$NODE$/logger_$LOGGER$");
+  options.log_.loggers_per_node_ = 1;
+  options.thread_.group_count_ = 1;
+  options.thread_.thread_count_per_group_ = 1;
+  options.memory_.page_pool_size_mb_per_node_ = FLAGS_volatile_pool_size;
+  options.cache_.snapshot_cache_size_mb_per_node_ = FLAGS_snapshot_pool_size;
+  options.cache_.snapshot_cache_warm_start_ = warm_start;
+  options.log_.log_buffer_kb_ = FLAGS_log_buffer_mb << 10;
+
+  options.debugging_.debug_log_min_threshold_ = debugging::DebuggingOptions::kDebugLogWarning;
+  options.debugging_.verbose_modules_ = "";
+  options.debugging_.verbose_log_level_ = -1;
+  return options;
+}
+
+std::vector<uint64_t> run_reads(Engine* engine) {
+  const uint32_t windows = FLAGS_duration_ms / FLAGS_window_ms;
+  std::vector<uint64_t> counts(windows);
+  thread::ImpersonateSession session;
+  if (!engine->get_thread_pool()->impersonate("read", nullptr, 0, &session)) {
+    COERCE_ERROR(ERROR_STACK(kErrorCodeThrNoThreadAvailable));
+  }
+  COERCE_ERROR(session.get_result());
+  session.get_output(counts.data());
+  session.release();
+  return counts;
+}
+
+/** Measures the reads after restart and returns the time to reach 90% of the steady state. */
+uint32_t measure_restart(bool warm_start) {
+  Engine engine(make_options(warm_start));
+  engine.get_proc_manager()->pre_register("read", read_task);
+  COERCE_ERROR(engine.initialize());
+  std::vector<uint64_t> counts;
+  {
+    UninitializeGuard guard(&engine);
+    counts = run_reads(&engine);
+    COERCE_ERROR(engine.uninitialize());
+  }
+
+  const uint32_t steady_from = counts.size() * 3U / 4U;
+  uint64_t steady_sum = 0;
+  for (uint32_t i = steady_from; i < counts.size(); ++i) {
+    steady_sum += counts[i];
+  }
+  const double steady = static_cast<double>(steady_sum) / (counts.size() - steady_from);
+  uint32_t reached = counts.size();
+  for (uint32_t i = 0; i < counts.size(); ++i) {
+    if (counts[i] >= steady * 0.9) {
+      reached = i;
+      break;
+    }
+  }
+  const double window_sec = FLAGS_window_ms / 1000.0;
+  std::cout << (warm_start ? "warm-start" : "cold start") << ": first window="
+    << counts[0] / window_sec
+    << " reads/sec, steady state=" << steady / window_sec << " reads/sec" << std::endl;
+  return (reached + 1U) * FLAGS_window_ms;
+}
+
+int main_impl(int argc, char **argv) {
+  gflags::SetUsageMessage("warm_start_perf");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  fs::Path folder(FLAGS_folder);
+  if (fs::exists(folder)) {
+    fs::remove_all(folder);
+  }
+  if (!fs::create_directories(folder)) {
+    std::cerr << "Couldn't create " << folder << ". err=" << assorted::os_error();
+    return 1;
+  }
+
+  {
+    Engine engine(make_options(true));
+    engine.get_proc_manager()->pre_register("populate", populate_task);
+    engine.get_proc_manager()->pre_register("read", read_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      std::cout << "populating..." << std::endl;
+      storage::array::ArrayMetadata meta("aaa", FLAGS_payload, FLAGS_records);
+      // drop all volatile pages in the snapshot so that reads go through the snapshot cache
+      meta.snapshot_drop_volatile_pages_threshold_ = 0;
+      storage::array::ArrayStorage target;
+      Epoch commit_epoch;
+      COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &target, &commit_epoch));
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("populate"));
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      // make the pages hot. shutting down writes out the manifest.
+      run_reads(&engine);
+      run_reads(&engine);
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+
+  const uint32_t cold_ms = measure_restart(false);
+  const uint32_t warm_ms = measure_restart(true);
+  std::cout << "time to 90% of steady state without warm-start:" << cold_ms << "ms" << std::endl;
+  std::cout << "time to 90% of steady state with warm-start:" << warm_ms << "ms" << std::endl;
+  return 0;
+}
+
+}  // namespace cache
+}  // namespace foedus
+
+int main(int argc, char **argv) {
+  return foedus::cache::main_impl(argc, argv);
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+/**
+ * @file foedus/restart/restart_perf.cpp
+ * @brief Measures the time to restart the engine with durable-but-unsnapshotted logs
+ * @details
+ * This experiment first populates logs on an array storage without taking any snapshot.
+ * Then it restarts the engine twice on the same log files and measures engine.initialize():
+ *  \li First with RestartOptions::enable_log_replay_, which replays the logs into volatile pages.
+ *  \li Then in the default mode, which takes a snapshot during start-up.
+ *
+ * The replay comes first because it does not advance the snapshot epoch, so the second restart
+ * sees exactly the same logs. Give a larger --rounds to compare the two modes on larger
+ * log volumes. Each round overwrites every record once, so the log volume is roughly
+ * rounds * records * (payload + 32) bytes.
+ */
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/error_stack_batch.hpp"
+#include "foedus/assorted/assorted_func.hpp"
+#include "foedus/debugging/stop_watch.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/impersonate_session.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_id.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace restart {
+
+DEFINE_int32(nodes, 1, "Number of NUMA nodes to use.");
+DEFINE_int32(threads_per_node, 2, "Number of threads per NUMA node.");
+DEFINE_int32(loggers_per_node, 2, "Number of loggers per NUMA node.");
+DEFINE_int32(replay_threads_per_node, 0, "Number of replay workers per node. 0 means all.");
+DEFINE_int64(records, 1 << 20, "Number of records in the array storage.");
+DEFINE_int32(payload, 64, "Payload size of each record.");
+DEFINE_int32(rounds, 4, "How many times each record is overwritten. Controls the log volume.");
+DEFINE_int32(volatile_pool_size, 4096, "Size of volatile memory pool per NUMA node in MB.");
+DEFINE_int32(snapshot_pool_size, 1024, "Size of snapshot memory pool per NUMA node in MB.");
+DEFINE_int32(log_buffer_mb, 64, "Size of log buffer for each thread in MB.");
+DEFINE_string(folder, "/dev/shm/foedus_restart", "Folder to place logs and snapshots.");
+
+const uint32_t kRecordsPerXct = 64;
+
+struct PopulateInput {
+  uint32_t worker_ordinal_;
+  uint32_t worker_count_;
+};
+
+ErrorStack populate_task(const proc::ProcArguments& args) {
+  const PopulateInput* input = reinterpret_cast<const PopulateInput*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, "aaa");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  const uint64_t records = FLAGS_records;
+  const uint64_t from = records * input->worker_ordinal_ / input->worker_count_;
+  const uint64_t to = records * (input->worker_ordinal_ + 1U) / input->worker_count_;
+  std::vector<char> payload(FLAGS_payload, 0);
+  Epoch commit_epoch;
+  for (int32_t round = 0; round < FLAGS_rounds; ++round) {
+    for (uint64_t i = from; i < to; i += kRecordsPerXct) {
+      WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+      const uint64_t end = std::min<uint64_t>(to, i + kRecordsPerXct);
+      for (uint64_t j = i; j < end; ++j) {
+        std::memcpy(payload.data(), &round, sizeof(round));
+        WRAP_ERROR_CODE(array.overwrite_record(context, j, payload.data()));
+      }
+      WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+    }
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+EngineOptions make_options() {
+  EngineOptions options;
+  fs::Path savepoint_path(FLAGS_folder);
+  savepoint_path /= "savepoint.xml";
+  options.savepoint_.savepoint_path_.assign(savepoint_path.string());
+  options.snapshot_.folder_path_pattern_.assign(FLAGS_folder + "/snapshot/node_$NODE$");
+  options.snapshot_.snapshot_interval_milliseconds_ = 100000000U;
+  options.log_.folder_path_pattern_.assign(FLAGS_folder + "/log/node_$NODE$/logger_$LOGGER$");
+  options.log_.loggers_per_node_ = FLAGS_loggers_per_node;
+  options.thread_.group_count_ = FLAGS_nodes;
+  options.thread_.thread_count_per_group_ = FLAGS_threads_per_node;
+  options.restart_.replay_threads_per_node_ = FLAGS_replay_threads_per_node;
+  options.memory_.page_pool_size_mb_per_node_ = FLAGS_volatile_pool_size;
+  options.cache_.snapshot_cache_size_mb_per_node_ = FLAGS_snapshot_pool_size;
+  options.log_.log_buffer_kb_ = FLAGS_log_buffer_mb << 10;
+
+  options.debugging_.debug_log_min_threshold_ = debugging::DebuggingOptions::kDebugLogInfo;
+  options.debugging_.verbose_modules_ = "";
+  options.debugging_.verbose_log_level_ = -1;
+  return options;
+}
+
+ErrorStack populate(Engine* engine) {
+  storage::array::ArrayMetadata meta("aaa", FLAGS_payload, FLAGS_records);
+  storage::array::ArrayStorage target;
+  Epoch commit_epoch;
+  CHECK_ERROR(engine->get_storage_manager()->create_array(&meta, &target, &commit_epoch));
+
+  thread::ThreadPool* pool = engine->get_thread_pool();
+  const uint32_t worker_count = FLAGS_nodes * FLAGS_threads_per_node;
+  std::vector<PopulateInput> inputs(worker_count);
+  std::vector<thread::ImpersonateSession> sessions(worker_count);
+  for (uint32_t i = 0; i < worker_count; ++i) {
+    inputs[i].worker_ordinal_ = i;
+    inputs[i].worker_count_ = worker_count;
+    thread::ThreadId core = thread::compose_thread_id(
+      i / FLAGS_threads_per_node,
+      i % FLAGS_threads_per_node);
+    if (!pool->impersonate_on_numa_core(core, "populate", &inputs[i], sizeof(PopulateInput),
+      &sessions[i])) {
+      return ERROR_STACK(kErrorCodeThrNoThreadAvailable);
+    }
+  }
+  ErrorStackBatch batch;
+  for (uint32_t i = 0; i < worker_count; ++i) {
+    batch.emprace_back(sessions[i].get_result());
+    sessions[i].release();
+  }
+  return SUMMARIZE_ERROR_BATCH(batch);
+}
+
+double measure_restart(bool enable_log_replay) {
+  EngineOptions options = make_options();
+  options.restart_.enable_log_replay_ = enable_log_replay;
+  Engine engine(options);
+  debugging::StopWatch watch;
+  COERCE_ERROR(engine.initialize());
+  watch.stop();
+  {
+    UninitializeGuard guard(&engine);
+    COERCE_ERROR(engine.uninitialize());
+  }
+  return watch.elapsed_ms();
+}
+
+int main_impl(int argc, char **argv) {
+  gflags::SetUsageMessage("restart_perf");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  fs::Path folder(FLAGS_folder);
+  if (fs::exists(folder)) {
+    fs::remove_all(folder);
+  }
+  if (!fs::create_directories(folder)) {
+    std::cerr << "Couldn't create " << folder << ". err=" << assorted::os_error();
+    return 1;
+  }
+
+  {
+    Engine engine(make_options());
+    engine.get_proc_manager()->pre_register("populate", populate_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      std::cout << "populating logs..." << std::endl;
+      debugging::StopWatch watch;
+      COERCE_ERROR(populate(&engine));
+      watch.stop();
+      std::cout << "populated logs in " << watch.elapsed_ms() << "ms" << std::endl;
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+
+  const double replay_ms = measure_restart(true);
+  const double snapshot_ms = measure_restart(false);
+  const uint64_t logs = static_cast<uint64_t>(FLAGS_records) * FLAGS_rounds;
+  std::cout << "logs:" << logs << std::endl;
+  std::cout << "restart with log replay:" << replay_ms << "ms" << std::endl;
+  std::cout << "restart with snapshot:" << snapshot_ms << "ms" << std::endl;
+  return 0;
+}
+
+}  // namespace restart
+}  // namespace foedus
+
+int main(int argc, char **argv) {
+  return foedus::restart::main_impl(argc, argv);
+}
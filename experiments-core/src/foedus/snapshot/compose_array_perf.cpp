@@ -24,13 +24,15 @@
  * \li performance before the improved merge-sort (~Dec14): 7-9M logs/sec/core.
  * \li performance after (Jan 1, 15 commit): 13-14M logs/sec/core.
  *
- * ohhhhhh! well, this benchmark gives just one input. if we really have to do merge-sort,
- * something else will be the bottleneck. but still.
+ * ohhhhhh! well, this benchmark gives just one input by default. if we really have to do
+ * merge-sort, something else will be the bottleneck. but still.
+ * Give --inputs=N to distribute the logs to N inputs and measure the merge-sort, too.
  */
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -64,6 +66,8 @@ namespace snapshot {
 
 DEFINE_bool(profile, false, "Whether to profile the execution with gperftools.");
 DEFINE_bool(papi, false, "Whether to profile with PAPI.");
+DEFINE_int32(inputs, 1, "Number of sorted inputs to compose from. Logs are distributed to them"
+  " in round-robin. More than 1 input measures the merge-sort in reducers.");
 
 const uint64_t kRecords = 1 << 22;
 const uint32_t kPayloadSize = 1 << 6;
@@ -73,7 +77,12 @@ void make_dummy_partitions(
   Engine* engine,
   storage::StorageId id,
   storage::PartitionerMetadata* metadata);
-void populate_logs(storage::StorageId id, char* buffer, uint64_t* size);
+void populate_logs(
+  storage::StorageId id,
+  uint16_t input,
+  uint16_t inputs_count,
+  char* buffer,
+  uint64_t* size);
 
 ErrorStack execute(
   Engine* engine,
@@ -98,12 +107,22 @@ ErrorStack execute(
 
   LOG(INFO) << "Populating logs to process...";
   debugging::StopWatch log_watch;
-  char* log_buffer = reinterpret_cast<char*>(log_memory.get_block());
-  uint64_t log_size = 0;
-  populate_logs(id, log_buffer, &log_size);
-  InMemorySortedBuffer buffer(log_buffer, log_size);
+  const uint16_t inputs_count = FLAGS_inputs;
+  ASSERT_ND(inputs_count > 0);
+  const uint64_t input_capacity = assorted::align<uint64_t, 1U << 12>(full_size / inputs_count);
+  std::vector< std::unique_ptr<InMemorySortedBuffer> > buffers;
+  std::vector< snapshot::SortedBuffer* > log_array;
   uint16_t key_len = sizeof(storage::array::ArrayOffset);
-  buffer.set_current_block(id, kRecords, 0, log_size, key_len, key_len);
+  for (uint16_t input = 0; input < inputs_count; ++input) {
+    char* log_buffer = reinterpret_cast<char*>(log_memory.get_block()) + input_capacity * input;
+    uint64_t log_size = 0;
+    populate_logs(id, input, inputs_count, log_buffer, &log_size);
+    ASSERT_ND(log_size <= input_capacity);
+    buffers.emplace_back(new InMemorySortedBuffer(log_buffer, log_size));
+    uint64_t records = kRecords / inputs_count + (input < kRecords % inputs_count ? 1U : 0);
+    buffers.back()->set_current_block(id, records, 0, log_size, key_len, key_len);
+    log_array.push_back(buffers.back().get());
+  }
   log_watch.stop();
   LOG(INFO) << "Populated logs to process in " << log_watch.elapsed_ms() << "ms";
 
@@ -115,13 +134,11 @@ ErrorStack execute(
   CHECK_ERROR(writer.open());
 
   storage::Page* root_page = reinterpret_cast<storage::Page*>(root_page_memory.get_block());
-  snapshot::SortedBuffer* log_array[1];
-  log_array[0] = &buffer;
   storage::Composer::ComposeArguments args = {
     &writer,
     &dummy_files,
-    log_array,
-    1,
+    &log_array[0],
+    inputs_count,
     &work_memory,
     Epoch(1),
     root_page
@@ -176,11 +193,16 @@ void make_dummy_partitions(
   metadata->valid_ = true;
 }
 
-void populate_logs(storage::StorageId id, char* buffer, uint64_t* size) {
+void populate_logs(
+  storage::StorageId id,
+  uint16_t input,
+  uint16_t inputs_count,
+  char* buffer,
+  uint64_t* size) {
   uint64_t cur = 0;
   char payload[kPayloadSize];
   std::memset(payload, 0, kPayloadSize);
-  for (uint64_t i = 0; i < kRecords; ++i) {
+  for (uint64_t i = input; i < kRecords; i += inputs_count) {
     storage::array::ArrayOverwriteLogType* log
       = reinterpret_cast<storage::array::ArrayOverwriteLogType*>(buffer + cur);
     std::memcpy(payload, &i, sizeof(i));
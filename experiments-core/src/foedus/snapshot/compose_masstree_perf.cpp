@@ -25,6 +25,7 @@
 #include <glog/logging.h>
 
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -60,13 +61,20 @@ namespace snapshot {
 
 DEFINE_bool(profile, false, "Whether to profile the execution with gperftools.");
 DEFINE_bool(papi, false, "Whether to profile with PAPI.");
+DEFINE_int32(inputs, 1, "Number of sorted inputs to compose from. Logs are distributed to them"
+  " in round-robin. More than 1 input measures the merge-sort in reducers.");
 
 const uint64_t kRecords = 1 << 22;
 const uint32_t kPayloadSize = 1 << 6;
 const uint32_t kSnapshotId = 1;
 
 void make_dummy_partitions(Engine* engine, storage::PartitionerMetadata* metadata);
-void populate_logs(storage::StorageId id, char* buffer, uint64_t* size);
+void populate_logs(
+  storage::StorageId id,
+  uint16_t input,
+  uint16_t inputs_count,
+  char* buffer,
+  uint64_t* size);
 
 ErrorStack execute(
   Engine* engine,
@@ -94,12 +102,22 @@ ErrorStack execute(
 
   LOG(INFO) << "Populating logs to process...";
   debugging::StopWatch log_watch;
-  char* log_buffer = reinterpret_cast<char*>(log_memory.get_block());
-  uint64_t log_size = 0;
-  populate_logs(id, log_buffer, &log_size);
-  InMemorySortedBuffer buffer(log_buffer, log_size);
+  const uint16_t inputs_count = FLAGS_inputs;
+  ASSERT_ND(inputs_count > 0);
+  const uint64_t input_capacity = assorted::align<uint64_t, 1U << 12>(full_size / inputs_count);
+  std::vector< std::unique_ptr<InMemorySortedBuffer> > buffers;
+  std::vector< snapshot::SortedBuffer* > log_masstree;
   uint16_t key_len = sizeof(storage::masstree::KeySlice);
-  buffer.set_current_block(id, kRecords, 0, log_size, key_len, key_len);
+  for (uint16_t input = 0; input < inputs_count; ++input) {
+    char* log_buffer = reinterpret_cast<char*>(log_memory.get_block()) + input_capacity * input;
+    uint64_t log_size = 0;
+    populate_logs(id, input, inputs_count, log_buffer, &log_size);
+    ASSERT_ND(log_size <= input_capacity);
+    buffers.emplace_back(new InMemorySortedBuffer(log_buffer, log_size));
+    uint64_t records = kRecords / inputs_count + (input < kRecords % inputs_count ? 1U : 0);
+    buffers.back()->set_current_block(id, records, 0, log_size, key_len, key_len);
+    log_masstree.push_back(buffers.back().get());
+  }
   log_watch.stop();
   LOG(INFO) << "Populated logs to process in " << log_watch.elapsed_ms() << "ms";
 
@@ -107,13 +125,11 @@ ErrorStack execute(
   CHECK_ERROR(writer.open());
 
   storage::Page* root_page = reinterpret_cast<storage::Page*>(root_page_memory.get_block());
-  snapshot::SortedBuffer* log_masstree[1];
-  log_masstree[0] = &buffer;
   storage::Composer::ComposeArguments args = {
     &writer,
     &dummy_files,
-    log_masstree,
-    1,
+    &log_masstree[0],
+    inputs_count,
     &work_memory,
     Epoch(1),
     root_page
@@ -162,12 +178,17 @@ void make_dummy_partitions(Engine* engine, storage::PartitionerMetadata* metadat
   metadata->valid_ = true;
 }
 
-void populate_logs(storage::StorageId id, char* buffer, uint64_t* size) {
+void populate_logs(
+  storage::StorageId id,
+  uint16_t input,
+  uint16_t inputs_count,
+  char* buffer,
+  uint64_t* size) {
   uint64_t cur = 0;
   char key[8];
   char payload[kPayloadSize];
   std::memset(payload, 0, kPayloadSize);
-  for (uint64_t i = 0; i < kRecords; ++i) {
+  for (uint64_t i = input; i < kRecords; i += inputs_count) {
     storage::masstree::MasstreeInsertLogType* log
       = reinterpret_cast<storage::masstree::MasstreeInsertLogType*>(buffer + cur);
     std::memcpy(payload, &i, sizeof(i));
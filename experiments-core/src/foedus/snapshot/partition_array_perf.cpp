@@ -24,6 +24,7 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -55,9 +56,12 @@ DEFINE_bool(papi, false, "Whether to profile with PAPI.");
 // usually, partitioning is negligible compared to sorting. so the default is sorting only
 DEFINE_bool(run_partition, false, "Whether to test partitioning.");
 DEFINE_bool(run_sort, true, "Whether to test sorting.");
+DEFINE_bool(run_group, false, "Whether to test grouping logs by partitions as mappers do."
+  " This also runs partitioning, and compares with std::sort by partitions we used to do.");
 
 const uint64_t kRecords = 1 << 24;
 const uint16_t kPayloadSize = 1 << 6;
+const uint16_t kPartitions = 16;
 
 void make_dummy_partitions(
   Engine* engine,
@@ -105,7 +109,7 @@ ErrorStack execute(
   ASSERT_ND(partitioner_base.is_valid());
   storage::array::ArrayPartitioner partitioner(&partitioner_base);
   LogBuffer buf(log_buffer);
-  if (FLAGS_run_partition) {
+  if (FLAGS_run_partition || FLAGS_run_group) {
     LOG(INFO) << "running partitioning...";
     storage::Partitioner::PartitionBatchArguments partition_args = {
       0,
@@ -116,6 +120,33 @@ ErrorStack execute(
     partitioner.partition_batch(partition_args);
   }
 
+  if (FLAGS_run_group) {
+    LOG(INFO) << "running grouping by partitions...";
+    const uint8_t* partitions = reinterpret_cast<const uint8_t*>(partitions_memory.get_block());
+    uint32_t partition_begins[kPartitions + 1U];
+    storage::Partitioner::GroupByPartitionArguments group_args = {
+      log_positions,
+      partitions,
+      kRecords,
+      kPartitions,
+      reinterpret_cast<BufferPosition*>(out_memory.get_block()),
+      partition_begins};
+    debugging::StopWatch group_watch;
+    storage::Partitioner::group_by_partition(group_args);
+    group_watch.stop();
+
+    // what mappers used to do: sort (partition, position) pairs
+    std::vector<uint64_t> sort_entries(kRecords);
+    debugging::StopWatch sort_watch;
+    for (uint64_t i = 0; i < kRecords; ++i) {
+      sort_entries[i] = (static_cast<uint64_t>(partitions[i]) << 32) | log_positions[i];
+    }
+    std::sort(sort_entries.begin(), sort_entries.end());
+    sort_watch.stop();
+    LOG(INFO) << "grouped by partitions in " << group_watch.elapsed_ms() << "ms. std::sort took "
+      << sort_watch.elapsed_ms() << "ms";
+  }
+
   if (FLAGS_run_sort) {
     LOG(INFO) << "running sorting...";
     uint32_t written_count;
@@ -164,8 +195,8 @@ void make_dummy_partitions(
   data->partitionable_ = true;
   data->array_levels_ = target.get_levels();
   data->array_size_ = kRecords;
-  data->bucket_size_ = kRecords / 16;
-  for (uint64_t i = 0; i < 16U; ++i) {
+  data->bucket_size_ = kRecords / kPartitions;
+  for (uint64_t i = 0; i < kPartitions; ++i) {
     data->bucket_owners_[i] = i;
   }
   metadata->valid_ = true;
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+/**
+ * @file foedus/storage/masstree/separator_search_perf.cpp
+ * @brief Microbenchmark of the separator search in intermediate pages
+ * @details
+ * Emulates point-lookup traversals through a deep tree of intermediate pages, where each level
+ * runs find_minipage() and then find_pointer() on the mini-page.
+ * Pages here mimic only the separators and pointers of MasstreeIntermediatePage, so this
+ * isolates the separator search and the cache misses it causes from the rest of masstree
+ * (page versions, foster twins, border pages, etc).
+ * Compares find_separator() against the loop find_minipage()/find_pointer() used to have.
+ * Use a small --pages to keep everything in cache and see only the search cost.
+ * No engine is needed. Compile with -mavx2 to see the AVX2 path.
+ */
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "foedus/assorted/uniform_random.hpp"
+#include "foedus/debugging/stop_watch.hpp"
+#include "foedus/storage/masstree/masstree_id.hpp"
+#include "foedus/storage/masstree/masstree_page_impl.hpp"
+#include "foedus/storage/masstree/masstree_slice_search.hpp"
+
+namespace foedus {
+namespace storage {
+namespace masstree {
+
+DEFINE_int32(pages, 1 << 14, "Number of intermediate pages in the emulated tree.");
+DEFINE_int32(levels, 6, "Number of intermediate pages each traversal goes through.");
+DEFINE_int32(searches, 1 << 22, "Number of traversals to run.");
+
+/** Only the separators and pointers of MasstreeIntermediatePage. */
+struct FakeIntermediatePage {
+  struct MiniPage {
+    uint8_t   key_count_;
+    KeySlice  separators_[kMaxIntermediateMiniSeparators];
+    uint32_t  pointers_[kMaxIntermediateMiniSeparators + 1U];
+  };
+  uint8_t   key_count_;
+  KeySlice  separators_[kMaxIntermediateSeparators];
+  MiniPage  mini_pages_[kMaxIntermediateSeparators + 1U];
+};
+
+typedef uint8_t (*SearchFunc)(const KeySlice* separators, uint8_t count, KeySlice slice);
+
+/** the loop find_minipage()/find_pointer() used to have */
+uint8_t search_loop(const KeySlice* separators, uint8_t count, KeySlice slice) {
+  for (uint8_t i = 0; i < count; ++i) {
+    if (slice < separators[i]) {
+      return i;
+    }
+  }
+  return count;
+}
+
+uint8_t search_scalar(const KeySlice* separators, uint8_t count, KeySlice slice) {
+  return find_separator_scalar(separators, count, slice);
+}
+
+uint8_t search_vectorized(const KeySlice* separators, uint8_t count, KeySlice slice) {
+  return find_separator(separators, count, slice);
+}
+
+KeySlice random_slice(assorted::UniformRandom* rnd) {
+  return (static_cast<KeySlice>(rnd->next_uint32()) << 32) | rnd->next_uint32();
+}
+
+/** fills random sorted separators in full pages, and random pointers to other pages */
+void populate(assorted::UniformRandom* rnd, std::vector<FakeIntermediatePage>* pages) {
+  for (FakeIntermediatePage& page : *pages) {
+    page.key_count_ = kMaxIntermediateSeparators;
+    for (uint16_t i = 0; i < kMaxIntermediateSeparators; ++i) {
+      page.separators_[i] = random_slice(rnd);
+    }
+    std::sort(page.separators_, page.separators_ + kMaxIntermediateSeparators);
+    for (uint16_t m = 0; m <= kMaxIntermediateSeparators; ++m) {
+      FakeIntermediatePage::MiniPage& mini = page.mini_pages_[m];
+      mini.key_count_ = kMaxIntermediateMiniSeparators;
+      for (uint16_t i = 0; i < kMaxIntermediateMiniSeparators; ++i) {
+        mini.separators_[i] = random_slice(rnd);
+      }
+      std::sort(mini.separators_, mini.separators_ + kMaxIntermediateMiniSeparators);
+      for (uint16_t i = 0; i <= kMaxIntermediateMiniSeparators; ++i) {
+        mini.pointers_[i] = rnd->next_uint32() % pages->size();
+      }
+    }
+  }
+}
+
+double run(
+  const char* name,
+  SearchFunc func,
+  const std::vector<FakeIntermediatePage>& pages,
+  const std::vector<KeySlice>& queries) {
+  uint64_t checksum = 0;
+  debugging::StopWatch watch;
+  for (uint32_t q = 0; q < queries.size(); ++q) {
+    const KeySlice slice = queries[q];
+    uint32_t page_index = q % pages.size();
+    for (int32_t level = 0; level < FLAGS_levels; ++level) {
+      const FakeIntermediatePage& page = pages[page_index];
+      const uint8_t minipage_index = func(page.separators_, page.key_count_, slice);
+      const FakeIntermediatePage::MiniPage& mini = page.mini_pages_[minipage_index];
+      const uint8_t pointer_index = func(mini.separators_, mini.key_count_, slice);
+      // the next page depends on the search result, like real traversals.
+      page_index = mini.pointers_[pointer_index];
+    }
+    checksum += page_index;
+  }
+  watch.stop();
+  std::cout << name << ": " << watch.elapsed_ms() << "ms (checksum=" << checksum << ")"
+    << std::endl;
+  return watch.elapsed_ms();
+}
+
+int main_impl(int argc, char **argv) {
+  gflags::SetUsageMessage("separator_search_perf");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  std::cout << "implementation: " << get_separator_search_implementation() << std::endl;
+
+  assorted::UniformRandom rnd(1234567L);
+  std::vector<FakeIntermediatePage> pages(FLAGS_pages);
+  populate(&rnd, &pages);
+  std::vector<KeySlice> queries(FLAGS_searches);
+  for (uint32_t i = 0; i < queries.size(); ++i) {
+    queries[i] = random_slice(&rnd);
+  }
+  std::cout << FLAGS_pages << " pages (" << (sizeof(FakeIntermediatePage) * pages.size() >> 20)
+    << "MB), " << FLAGS_levels << " levels per traversal" << std::endl;
+
+  const double loop_ms = run("early-exit loop", search_loop, pages, queries);
+  run("branchless scalar", search_scalar, pages, queries);
+  const double vectorized_ms = run("vectorized", search_vectorized, pages, queries);
+  std::cout << "speedup over early-exit loop: " << (loop_ms / vectorized_ms) << "x" << std::endl;
+  return 0;
+}
+
+}  // namespace masstree
+}  // namespace storage
+}  // namespace foedus
+
+int main(int argc, char **argv) {
+  return foedus::storage::masstree::main_impl(argc, argv);
+}
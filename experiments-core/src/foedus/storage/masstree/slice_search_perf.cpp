@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+/**
+ * @file foedus/storage/masstree/slice_search_perf.cpp
+ * @brief Microbenchmark of the slice search in border pages
+ * @details
+ * Compares match_slices() against match_slices_scalar() and the slot-by-slot loop we used to
+ * have, on a full border page worth of slices (kBorderPageMaxSlots).
+ * This is the innermost loop of point lookups in masstree.
+ * No engine is needed. Compile with -mavx2 to see the AVX2 path.
+ */
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "foedus/assorted/uniform_random.hpp"
+#include "foedus/debugging/stop_watch.hpp"
+#include "foedus/storage/masstree/masstree_id.hpp"
+#include "foedus/storage/masstree/masstree_slice_search.hpp"
+
+namespace foedus {
+namespace storage {
+namespace masstree {
+
+DEFINE_int32(pages, 1 << 10, "Number of border pages worth of slices to search in.");
+DEFINE_int32(searches, 1 << 24, "Number of searches to run.");
+
+typedef SlotIndex (*SearchFunc)(const KeySlice* slices, SlotIndex key_count, KeySlice slice);
+
+/** the slot-by-slot loop we used to have in MasstreeBorderPage::find_key_normalized() */
+SlotIndex search_loop(const KeySlice* slices, SlotIndex key_count, KeySlice slice) {
+  for (SlotIndex i = 0; i < key_count; ++i) {
+    if (slices[i] == slice) {
+      return i;
+    }
+  }
+  return kBorderPageMaxSlots;
+}
+
+/** same loop as MasstreeBorderPage::find_key_normalized(), but only slice comparison */
+template <bool kVectorized>
+SlotIndex search_batch(const KeySlice* slices, SlotIndex key_count, KeySlice slice) {
+  for (SlotIndex base = 0; base < key_count; base += kSliceSearchBatch) {
+    const SlotIndex count = std::min<SlotIndex>(key_count - base, kSliceSearchBatch);
+    const uint64_t matches = kVectorized
+      ? match_slices(slices + base, count, slice)
+      : match_slices_scalar(slices + base, count, slice);
+    if (matches != 0) {
+      return base + __builtin_ctzll(matches);
+    }
+  }
+  return kBorderPageMaxSlots;
+}
+
+double run(
+  const char* name,
+  SearchFunc func,
+  const std::vector<KeySlice>& slices,
+  const std::vector<uint32_t>& queries) {
+  const uint32_t pages = slices.size() / kBorderPageMaxSlots;
+  uint64_t found = 0;
+  debugging::StopWatch watch;
+  for (uint32_t i = 0; i < queries.size(); ++i) {
+    const uint32_t page = queries[i] % pages;
+    const KeySlice* page_slices = slices.data() + page * kBorderPageMaxSlots;
+    // search for a slice in the page, so on average the loop checks half of the slices.
+    const KeySlice key = page_slices[(queries[i] >> 10) % kBorderPageMaxSlots];
+    found += func(page_slices, kBorderPageMaxSlots, key);
+  }
+  watch.stop();
+  std::cout << name << ": " << watch.elapsed_ms() << "ms (checksum=" << found << ")" << std::endl;
+  return watch.elapsed_ms();
+}
+
+int main_impl(int argc, char **argv) {
+  gflags::SetUsageMessage("slice_search_perf");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  std::cout << "implementation: " << get_slice_search_implementation() << std::endl;
+
+  assorted::UniformRandom rnd(1234567L);
+  std::vector<KeySlice> slices(static_cast<uint64_t>(FLAGS_pages) * kBorderPageMaxSlots);
+  for (uint64_t i = 0; i < slices.size(); ++i) {
+    slices[i] = (static_cast<KeySlice>(rnd.next_uint32()) << 32) | rnd.next_uint32();
+  }
+  std::vector<uint32_t> queries(FLAGS_searches);
+  for (uint32_t i = 0; i < queries.size(); ++i) {
+    queries[i] = rnd.next_uint32();
+  }
+
+  const double loop_ms = run("slot-by-slot loop", search_loop, slices, queries);
+  run("scalar bitmask", search_batch<false>, slices, queries);
+  const double vectorized_ms = run("vectorized bitmask", search_batch<true>, slices, queries);
+  std::cout << "speedup over slot-by-slot loop: " << (loop_ms / vectorized_ms) << "x" << std::endl;
+  return 0;
+}
+
+}  // namespace masstree
+}  // namespace storage
+}  // namespace foedus
+
+int main(int argc, char **argv) {
+  return foedus::storage::masstree::main_impl(argc, argv);
+}
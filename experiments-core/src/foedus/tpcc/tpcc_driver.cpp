@@ -88,6 +88,11 @@ DEFINE_bool(mmap_hugepages, false, "Whether to use mmap for 1GB hugepages."
   " This requies special setup written in the readme.");
 DEFINE_int32(log_buffer_mb, 1024, "Size in MB of log buffer for each thread");
 DEFINE_bool(null_log_device, false, "Whether to disable log writing.");
+DEFINE_bool(pmem_log_device, false, "Whether to write logs via mmap as if the log folder is on"
+  " persistent memory (DAX), rather than with direct I/O and fsync.");
+DEFINE_bool(compress_logs, false, "Whether loggers compress logs before writing them out.");
+DEFINE_bool(logger_work_stealing, false, "Whether loggers in a NUMA node write out each other's"
+  " thread buffers to balance skewed log volumes.");
 DEFINE_bool(high_priority, false, "Set high priority to threads. Needs 'rtprio 99' in limits.conf");
 DEFINE_int32(warehouses, 16, "Number of warehouses.");
 DEFINE_int64(duration_micro, 10000000, "Duration of benchmark in microseconds.");
@@ -589,6 +594,18 @@ int driver_main(int argc, char **argv) {
     std::cout << "/dev/null log device" << std::endl;
     options.log_.emulation_.null_device_ = true;
   }
+  if (FLAGS_pmem_log_device) {
+    std::cout << "persistent-memory log device" << std::endl;
+    options.log_.device_type_ = log::kLogDevicePmem;
+  }
+  if (FLAGS_compress_logs) {
+    std::cout << "compressed logs" << std::endl;
+    options.log_.compress_logs_ = true;
+  }
+  if (FLAGS_logger_work_stealing) {
+    std::cout << "loggers steal work" << std::endl;
+    options.log_.logger_work_stealing_ = true;
+  }
 
   if (FLAGS_single_thread_test) {
     FLAGS_warehouses = 1;
@@ -662,6 +679,9 @@ std::ostream& operator<<(std::ostream& o, const TpccDriver::Result& v) {
     << "<unexpected_aborts_>" << v.unexpected_aborts_ << "</unexpected_aborts_>"
     << "<snapshot_cache_hits_>" << v.snapshot_cache_hits_ << "</snapshot_cache_hits_>"
     << "<snapshot_cache_misses_>" << v.snapshot_cache_misses_ << "</snapshot_cache_misses_>"
+    << "<snapshot_cache_hit_ratio_>" << (v.snapshot_cache_hits_ + v.snapshot_cache_misses_ == 0
+      ? 0.0 : static_cast<double>(v.snapshot_cache_hits_)
+        / (v.snapshot_cache_hits_ + v.snapshot_cache_misses_)) << "</snapshot_cache_hit_ratio_>"
     << "</total_result>";
   return o;
 }
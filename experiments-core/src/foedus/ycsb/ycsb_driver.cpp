@@ -80,6 +80,8 @@ DEFINE_bool(mmap_hugepages, false, "Whether to use mmap for 1GB hugepages."
 DEFINE_int32(log_buffer_mb, 512, "Size in MB of log buffer for each thread");
 DEFINE_bool(null_log_device, false, "Whether to disable log writing.");
 DEFINE_int64(duration_micro, 1000000, "Duration of benchmark in microseconds.");
+DEFINE_int32(hot_threshold, 256, "Page hotness above which serializable transactions lock"
+  " records they write during execution. 256 or larger disables it, 0 always locks.");
 
 // YCSB-specific options
 DEFINE_string(workload, "A", "YCSB workload; choose A/B/C/D/E/F.");
@@ -241,6 +243,9 @@ int driver_main(int argc, char **argv) {
   options.debugging_.verbose_modules_ = "";
   options.debugging_.verbose_log_level_ = -1;
 
+  options.xct_.hot_threshold_ = FLAGS_hot_threshold;
+  std::cout << "hot_threshold=" << FLAGS_hot_threshold << std::endl;
+
   options.log_.log_buffer_kb_ = FLAGS_log_buffer_mb << 10;
   std::cout << "log_buffer_mb=" << FLAGS_log_buffer_mb << "MB per thread" << std::endl;
   options.log_.log_file_size_mb_ = 1 << 15;
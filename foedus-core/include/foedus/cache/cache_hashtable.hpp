@@ -159,7 +159,10 @@ struct CacheBucket CXX11_FINAL {
   }
 };
 
-/** A loosely maintained reference count for CLOCK algorithm. */
+/**
+ * A loosely maintained reference count for CLOCK algorithm.
+ * The initial value depends on how the page was installed. See CacheHashtable::install().
+ */
 struct CacheRefCount CXX11_FINAL {
   uint16_t count_;
 
@@ -229,12 +232,30 @@ struct CacheOverflowEntry CXX11_FINAL {
  * Currently, we even don't do the bucket migration in hopscotch, so it's no longer correct to
  * call this a hop-scotch. Instead, we use an overflow linked list, which should be almost always
  * empty or close-to-empty.
+ *
+ * @par Replacement Policy
+ * evict() is a CLOCK sweep over refcounts_, but a plain CLOCK lets one analytical scan flush
+ * the hot OLTP working set. We thus vary the initial refcount of newly installed entries,
+ * which is essentially a 2Q-like admission on top of CLOCK:
+ *  \li New pages start at kInitialRefCount, so the very first pass of the next sweep evicts
+ * them unless someone accesses them again in the meantime. This is the lowest refcount a cached
+ * page can have because zero means an empty bucket.
+ *  \li Pages that were recently evicted and are now requested again start at
+ * kGhostInitialRefCount. We remember recently evicted pages in a small \e ghost history, which
+ * is a direct-mapped array of PageIdTag. It is as loosely maintained as everything else here.
+ * A false positive just gives a page a few more passes.
+ *  \li Pages read by scans (cursors etc, see thread::SnapshotCacheScanScope) always start at
+ * kInitialRefCount. They skip the ghost history, so a repeated scan does not promote its pages.
  */
 class CacheHashtable CXX11_FINAL {
  public:
   enum Constants {
     /** Max size for find_batch() */
     kMaxFindBatchSize = 32,
+    /** Initial refcount of a newly installed page. Evicted in the first pass of evict() */
+    kInitialRefCount = 1,
+    /** Initial refcount of a page that is found in the ghost history */
+    kGhostInitialRefCount = 8,
   };
   CacheHashtable(BucketId physical_buckets, uint16_t numa_node);
 
@@ -275,12 +296,16 @@ class CacheHashtable CXX11_FINAL {
 
   /**
    * @brief Called when a cached page is not found.
+   * @param[in] page_id Page ID of the new content
+   * @param[in] content offset of the page image
+   * @param[in] scan whether the page is read by a scan, which never uses the ghost history
    * @return the only possible error code is kErrorCodeCacheTooManyOverflow, which is super-rare.
    * @details
    * This method installs the new content to this hashtable.
    * We are anyway doing at least 4kb memory copy in this case, so no need for serious optimization.
+   * The initial refcount of the entry is determined as described in the class comment.
    */
-  ErrorCode install(storage::SnapshotPagePointer page_id, ContentId content);
+  ErrorCode install(storage::SnapshotPagePointer page_id, ContentId content, bool scan = false);
 
   /** Parameters for evict() */
   struct EvictArgs {
@@ -332,6 +357,27 @@ class CacheHashtable CXX11_FINAL {
   /** only for debugging. you can call this in a race, but the results are a bit inaccurate. */
   Stat  get_stat_single_thread() const;
 
+  /**
+   * @brief Collects contents of entries that are hot, at most max_count of them.
+   * @param[in] min_refcount entries whose refcount is smaller than this are not collected
+   * @param[in] max_count max number of contents to collect
+   * @param[out] out collected contents, size=max_count
+   * @return number of contents collected
+   * @details
+   * When there are more than max_count candidates, we raise the threshold of refcount by powers
+   * of 2 so that we keep the hottest ones. You can call this in a race, but the results are
+   * a bit inaccurate. The caller must check the page behind each content anyway.
+   */
+  uint32_t  collect_hot_contents(uint16_t min_refcount, uint32_t max_count, ContentId* out) const;
+
+  /** Number of entries in the ghost history of recently evicted pages */
+  uint32_t  get_ghost_count() const ALWAYS_INLINE { return ghost_mask_ + 1U; }
+  /**
+   * [statistics] Number of installs that found the page in the ghost history.
+   * Loosely maintained without atomic operations, so it might be a bit smaller than the truth.
+   */
+  uint64_t  get_ghost_admissions() const ALWAYS_INLINE { return ghost_admissions_; }
+
   friend std::ostream& operator<<(std::ostream& o, const CacheHashtable& v);
 
  protected:
@@ -341,6 +387,7 @@ class CacheHashtable CXX11_FINAL {
   memory::AlignedMemory     buckets_memory_;
   memory::AlignedMemory     refcounts_memory_;
   memory::AlignedMemory     overflow_buckets_memory_;
+  memory::AlignedMemory     ghost_memory_;
 
   // these two have the same indexes.
   CacheBucket*              buckets_;
@@ -377,8 +424,26 @@ class CacheHashtable CXX11_FINAL {
    */
   BucketId                  clockhand_;
 
+  /**
+   * Ghost history of recently evicted pages, indexed by (tag & ghost_mask_).
+   * Each entry is the tag of a recently evicted page, or 0.
+   */
+  PageIdTag*                ghost_tags_;
+  /** Number of ghost entries - 1. The number of ghost entries is a power of 2. */
+  uint32_t                  ghost_mask_;
+  /** @see get_ghost_admissions() */
+  uint64_t                  ghost_admissions_;
+
   BucketId  evict_main_loop(EvictArgs* args, BucketId cur, uint16_t loop);
   void      evict_overflow_loop(EvictArgs* args, uint16_t loop);
+  /** Remembers the evicted page in the ghost history */
+  void      add_ghost(PageIdTag tag) ALWAYS_INLINE {
+    if (tag != 0) {
+      ghost_tags_[tag & ghost_mask_] = tag;
+    }
+  }
+  /** Returns the initial refcount for a newly installed page, consuming its ghost entry if any */
+  uint16_t  determine_initial_refcount(PageIdTag tag, bool scan);
 };
 
 inline uint32_t HashFunc::get_hash(storage::SnapshotPagePointer page_id) {
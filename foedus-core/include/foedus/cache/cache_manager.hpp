@@ -51,6 +51,7 @@ class CacheManager : public DefaultInitializable {
    * @brief Stops internal eviction thread even before uninitialize() of this object is called.
    * @details
    * It is also automatically called from uninitialize().
+   * This also stops the warm-start thread if it is still running.
    * Currently, this is used to avoid the race condition between XctManager's uninitialize() and
    * this object's uninitialize(). Here is why:
    * The cache cleaner depends on XctManager because the eviction is based on epochs.
@@ -61,6 +62,15 @@ class CacheManager : public DefaultInitializable {
    */
   ErrorStack  stop_cleaner();
 
+  /**
+   * Whether the warm-start of the snapshot cache in this node has finished, including the case
+   * where we had nothing to warm up. Always true in a master engine.
+   * @see CacheOptions::snapshot_cache_warm_start_
+   */
+  bool        is_warm_start_done() const;
+  /** Number of pages the warm-start has loaded into the snapshot cache in this node so far. */
+  uint64_t    get_warm_start_page_count() const;
+
  private:
   CacheManagerPimpl* pimpl_;
 };
@@ -18,15 +18,22 @@
 #ifndef FOEDUS_CACHE_CACHE_MANAGER_PIMPL_HPP_
 #define FOEDUS_CACHE_CACHE_MANAGER_PIMPL_HPP_
 
+#include <stdint.h>
+
 #include <atomic>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "foedus/fwd.hpp"
 #include "foedus/initializable.hpp"
 #include "foedus/cache/fwd.hpp"
+#include "foedus/debugging/stop_watch.hpp"
+#include "foedus/fs/path.hpp"
 #include "foedus/memory/aligned_memory.hpp"
 #include "foedus/memory/page_pool.hpp"
+#include "foedus/snapshot/snapshot_id.hpp"
+#include "foedus/storage/storage_id.hpp"
 
 namespace foedus {
 namespace cache {
@@ -60,6 +67,18 @@ class CacheManagerPimpl final : public DefaultInitializable {
 
   ErrorStack  stop_cleaner();
 
+  /** Main routine of warmer_ */
+  void        handle_warmer();
+  /**
+   * Writes out the manifest of hot pages in this node's snapshot cache.
+   * Called only when there is no concurrent eviction, eg by the cleaner thread itself.
+   */
+  ErrorStack  save_manifest();
+  /** Reads the manifest of this node. Empty if there is no manifest. */
+  ErrorStack  load_manifest(std::vector<storage::SnapshotPagePointer>* page_ids) const;
+  /** 'folder_path'/snapshot_cache_manifest_node_'node-id'.bin */
+  fs::Path    get_manifest_path() const;
+
   Engine* const     engine_;
 
   /**
@@ -110,6 +129,47 @@ class CacheManagerPimpl final : public DefaultInitializable {
 
   /** Number of pages buffered so far. */
   uint64_t  reclaimed_pages_count_;
+
+  /**
+   * @brief The thread to warm up the snapshot cache from the manifest after restart.
+   * @details
+   * Launched only when CacheOptions::snapshot_cache_warm_start_ is ON and the manifest exists.
+   * It finishes as soon as it reads all pages in the manifest.
+   */
+  std::thread       warmer_;
+  /** @see CacheManager::is_warm_start_done() */
+  std::atomic<bool>     warm_start_done_;
+  /** @see CacheManager::get_warm_start_page_count() */
+  std::atomic<uint64_t> warm_start_page_count_;
+  /** Max number of pages in the manifest. The warm-start never triggers eviction. */
+  uint64_t              manifest_max_pages_;
+  /**
+   * @brief The snapshot that started the current snapshot interval.
+   * @details
+   * Right after a snapshot, the cache still holds the working set of the previous snapshot.
+   * So, the cleaner writes out the manifest late in the interval, shortly before the next
+   * snapshot, when the cache holds the pages of this snapshot the workload actually reads.
+   */
+  snapshot::SnapshotId  manifest_snapshot_id_;
+  /** Whether we have written out the manifest in the current snapshot interval. */
+  bool                  manifest_written_;
+  /** Started when the cleaner observed manifest_snapshot_id_. */
+  debugging::StopWatch  manifest_watch_;
+};
+
+/**
+ * @brief Header of the manifest of hot pages in a node's snapshot cache.
+ * @details
+ * The header is followed by page_count_ SnapshotPagePointer, sorted in ascending order so that
+ * the warm-start reads each snapshot file mostly sequentially.
+ */
+struct CacheManifestHeader {
+  enum Constants {
+    kMagic = 0x46434D46,  // "FMCF"
+  };
+  uint32_t  magic_;
+  uint32_t  node_;
+  uint64_t  page_count_;
 };
 }  // namespace cache
 }  // namespace foedus
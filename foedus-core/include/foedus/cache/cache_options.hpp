@@ -95,6 +95,18 @@ struct CacheOptions CXX11_FINAL : public virtual externalize::Externalizable {
    */
   float       snapshot_cache_urgent_threshold_;
 
+  /**
+   * @brief Whether to warm up the snapshot cache after restart.
+   * @details
+   * If this is ON, each node writes out a compact manifest of hot snapshot pages in its cache
+   * to the snapshot folder of the node once per snapshot interval, shortly before the next
+   * snapshot, and when the engine shuts down.
+   * When the engine starts up, a background thread in each node reads the pages listed in
+   * the manifest into the node's snapshot cache with batched reads, while transactions are
+   * already running. Default is ON.
+   */
+  bool        snapshot_cache_warm_start_;
+
   EXTERNALIZABLE(CacheOptions);
 };
 }  // namespace cache
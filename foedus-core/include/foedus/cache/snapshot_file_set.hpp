@@ -18,10 +18,13 @@
 #ifndef FOEDUS_CACHE_SNAPSHOT_FILE_SET_HPP_
 #define FOEDUS_CACHE_SNAPSHOT_FILE_SET_HPP_
 
+#include <stdint.h>
+
 #include <iosfwd>
 #include <map>
 
 #include "foedus/cxx11.hpp"
+#include "foedus/error_code.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/initializable.hpp"
 #include "foedus/fs/fwd.hpp"
@@ -45,12 +48,26 @@ namespace cache {
  * This design might hit the maximum number of file descriptors per process.
  * Check cat /proc/sys/fs/file-max if that happens. Google how to change it (soft AND hard limits).
  *
+ * This object also holds a per-thread Linux native AIO context for read_pages_batch(),
+ * which is lazily created upon the first batched read.
+ *
  * @todo So far we really use std::map. But, this is not ideal in terms of performance.
  * node-id is up to 256, snapshots are almost always very few, so we can do array-based
  * something.
  */
 class SnapshotFileSet CXX11_FINAL : public DefaultInitializable {
  public:
+  enum Constants {
+    /** Max number of reads read_pages_batch() keeps outstanding at the same time. */
+    kMaxAsyncReads = 32,
+  };
+  /**
+   * Invoked by read_pages_batch() for each page as soon as its read completes.
+   * The index is the position of the page in the batch.
+   * Returning an error stops invoking further callbacks.
+   */
+  typedef ErrorCode (*PageReadCompletion)(uint16_t index, void* arg);
+
   explicit SnapshotFileSet(Engine* engine);
   ErrorStack  initialize_once() CXX11_OVERRIDE;
   ErrorStack  uninitialize_once() CXX11_OVERRIDE;
@@ -77,10 +94,50 @@ class SnapshotFileSet CXX11_FINAL : public DefaultInitializable {
   /** Read contiguous pages in one shot */
   ErrorCode read_pages(storage::SnapshotPagePointer page_id_begin, uint32_t page_count, void* out);
 
+  /**
+   * @brief Reads non-contiguous pages, keeping all of the reads outstanding at the same time.
+   * @param[in] count number of pages to read. At most kMaxAsyncReads.
+   * @param[in] page_ids IDs of the snapshot pages to read
+   * @param[in] outs page-aligned buffers to read each page into
+   * @param[in] on_completion if not null, invoked for each page right after its read completes,
+   * in the order of completion, not in the order of page_ids
+   * @param[in] completion_arg passed to on_completion as it is
+   * @details
+   * read_page() blocks for a full device round trip per page.
+   * This method instead submits all reads to Linux native AIO at once, so the device sees
+   * \e count outstanding reads.
+   * When native AIO is not available (eg the kernel limit of aio-max-nr is reached), this
+   * method falls back to synchronous read_page() calls.
+   * Even when this method returns an error, it returns only after all outstanding reads have
+   * finished, so the caller can safely reuse the buffers. The pages for which on_completion
+   * was not invoked are not read.
+   */
+  ErrorCode read_pages_batch(
+    uint16_t count,
+    const storage::SnapshotPagePointer* page_ids,
+    void* const* outs,
+    PageReadCompletion on_completion,
+    void* completion_arg);
+
   friend std::ostream&    operator<<(std::ostream& o, const SnapshotFileSet& v);
 
  private:
+  /** Lazily creates aio_context_. @return whether native AIO is available */
+  bool      prepare_async_reads();
+  /** Synchronous version of read_pages_batch(), starting from the given index. */
+  ErrorCode read_pages_batch_sync(
+    uint16_t from,
+    uint16_t count,
+    const storage::SnapshotPagePointer* page_ids,
+    void* const* outs,
+    PageReadCompletion on_completion,
+    void* completion_arg);
+
   Engine* const engine_;
+  /** Linux native AIO context (aio_context_t). 0 if not created yet. */
+  uint64_t      aio_context_;
+  /** Whether we failed to create aio_context_, in which case we don't retry. */
+  bool          aio_unavailable_;
   std::map<snapshot::SnapshotId, std::map< thread::ThreadGroupId, fs::DirectIoFile* > > files_;
 };
 }  // namespace cache
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_DEBUGGING_ENGINE_STATISTICS_HPP_
+#define FOEDUS_DEBUGGING_ENGINE_STATISTICS_HPP_
+
+#include <stdint.h>
+
+#include <iosfwd>
+
+#include "foedus/fwd.hpp"
+#include "foedus/debugging/latency_histogram.hpp"
+#include "foedus/xct/xct_statistics.hpp"
+
+namespace foedus {
+namespace debugging {
+
+/**
+ * @brief A point-in-time summary of the statistics counters in the whole engine.
+ * @ingroup DEBUGGING
+ * @details
+ * The counters themselves are maintained by their owners without any synchronization:
+ * \li Each worker thread counts commits, aborts by reason, applied record logs per log type,
+ * precommit latency (see foedus::xct::XctStatistics), and snapshot cache hits/misses
+ * in its ThreadControlBlock.
+ * \li Each logger counts written bytes, fsync calls, and fsync latency in its LoggerControlBlock.
+ *
+ * All of them are placed in the shared memory. collect() just reads and sums them up,
+ * so it never blocks nor slows down the workers and it can be called from the master engine
+ * or any SOC engine at any time. Values are slightly stale while the engine is running.
+ */
+struct EngineStatistics {
+  EngineStatistics() { clear(); }
+
+  void      clear();
+  /** Reads the counters of all threads and loggers in all SOCs via the shared memory. */
+  void      collect(Engine* engine);
+
+  double    get_snapshot_cache_hit_ratio() const {
+    uint64_t total = snapshot_cache_hits_ + snapshot_cache_misses_;
+    return total == 0 ? 0 : static_cast<double>(snapshot_cache_hits_) / total;
+  }
+
+  /** Writes all statistics in XML. */
+  friend std::ostream& operator<<(std::ostream& o, const EngineStatistics& v);
+  /** Writes all statistics as a JSON object. */
+  void      describe_json(std::ostream* o) const;
+
+  uint32_t            thread_count_;
+  uint32_t            logger_count_;
+
+  /** Sum of XctStatistics of all threads. */
+  xct::XctStatistics  xct_;
+  uint64_t            snapshot_cache_hits_;
+  uint64_t            snapshot_cache_misses_;
+
+  uint64_t            log_written_bytes_;
+  uint64_t            log_raw_bytes_;
+  uint64_t            log_stolen_bytes_;
+  /** Max of all loggers, not sum. */
+  uint64_t            log_max_epoch_lag_;
+  uint64_t            log_fsyncs_;
+  LatencyHistogram    log_fsync_latency_ns_;
+};
+
+}  // namespace debugging
+}  // namespace foedus
+#endif  // FOEDUS_DEBUGGING_ENGINE_STATISTICS_HPP_
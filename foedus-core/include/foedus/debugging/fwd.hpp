@@ -26,6 +26,8 @@ namespace foedus {
 namespace debugging {
 class   DebuggingSupports;
 struct  DebuggingOptions;
+struct  EngineStatistics;
+struct  LatencyHistogram;
 }  // namespace debugging
 }  // namespace foedus
 #endif  // FOEDUS_DEBUGGING_FWD_HPP_
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_DEBUGGING_LATENCY_HISTOGRAM_HPP_
+#define FOEDUS_DEBUGGING_LATENCY_HISTOGRAM_HPP_
+
+#include <stdint.h>
+
+#include <cstring>
+#include <iosfwd>
+
+namespace foedus {
+namespace debugging {
+
+/**
+ * @brief A fixed-size, log-linear histogram of latency values (HDR-histogram style).
+ * @ingroup DEBUGGING
+ * @details
+ * Each power-of-two range of values is split into kSubBuckets linear buckets, so every
+ * bucket is at most 25% wide relative to its lower bound. The unit of values is up to the
+ * caller (nanoseconds, CPU cycles, ...).
+ *
+ * This is a POD without pointers so that it can be placed in shared memory and read from
+ * other SOCs. Only one thread should call add() on an instance. Readers in other threads or
+ * processes see slightly stale values, which is fine for statistics.
+ */
+struct LatencyHistogram {
+  enum Constants {
+    /** Number of linear buckets per power of two. */
+    kSubBucketBits = 2,
+    kSubBuckets = 1 << kSubBucketBits,
+    /** Covers the entire range of uint64_t. */
+    kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets,
+  };
+
+  void      reset() { std::memset(this, 0, sizeof(*this)); }
+
+  /** Records one value. Not atomic. Only the owner thread should call this. */
+  void      add(uint64_t value) {
+    ++buckets_[to_bucket(value)];
+    ++count_;
+    sum_ += value;
+    if (value > max_) {
+      max_ = value;
+    }
+  }
+
+  /** Adds all values recorded in the other histogram to this histogram. */
+  void      merge(const LatencyHistogram& other);
+
+  uint64_t  get_count() const { return count_; }
+  uint64_t  get_max() const { return max_; }
+  double    get_average() const {
+    return count_ == 0 ? 0 : static_cast<double>(sum_) / count_;
+  }
+  /**
+   * Returns an upper bound of the value at the given percentile (0-100).
+   * The error is bounded by the width of the bucket the percentile falls in.
+   */
+  uint64_t  get_percentile(double percentile) const;
+
+  static uint16_t to_bucket(uint64_t value) {
+    if (value < kSubBuckets) {
+      return value;
+    }
+    uint16_t msb = 63 - __builtin_clzll(value);
+    uint16_t sub = (value >> (msb - kSubBucketBits)) & (kSubBuckets - 1);
+    return (msb - kSubBucketBits + 1) * kSubBuckets + sub;
+  }
+  /** Inclusive lower bound of values that fall in the bucket. */
+  static uint64_t get_bucket_lower_bound(uint16_t bucket) {
+    if (bucket < kSubBuckets) {
+      return bucket;
+    }
+    uint16_t msb = bucket / kSubBuckets + kSubBucketBits - 1;
+    uint64_t sub = bucket % kSubBuckets;
+    return (kSubBuckets + sub) << (msb - kSubBucketBits);
+  }
+
+  /** Writes count/average/max and a few percentiles in XML. */
+  friend std::ostream& operator<<(std::ostream& o, const LatencyHistogram& v);
+  /** Same as above in a JSON object. */
+  void      describe_json(std::ostream* o) const;
+
+  uint64_t  count_;
+  uint64_t  sum_;
+  uint64_t  max_;
+  uint64_t  buckets_[kBuckets];
+};
+
+}  // namespace debugging
+}  // namespace foedus
+#endif  // FOEDUS_DEBUGGING_LATENCY_HISTOGRAM_HPP_
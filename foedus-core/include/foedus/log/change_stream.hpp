@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_LOG_CHANGE_STREAM_HPP_
+#define FOEDUS_LOG_CHANGE_STREAM_HPP_
+#include <stdint.h>
+
+#include <iosfwd>
+#include <utility>
+#include <vector>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/cxx11.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/fwd.hpp"
+#include "foedus/log/fwd.hpp"
+#include "foedus/log/log_id.hpp"
+#include "foedus/memory/aligned_memory.hpp"
+#include "foedus/storage/storage_id.hpp"
+#include "foedus/xct/xct_id.hpp"
+
+namespace foedus {
+namespace log {
+
+/**
+ * @brief A cursor over committed record logs (change data capture).
+ * @ingroup LOG
+ * @details
+ * An external consumer, such as a replica of a search index or an analytics store, uses
+ * this to follow committed changes as epochs become durable, rather than polling tables.
+ *
+ * @par Usage
+ * @code{.cpp}
+ * foedus::log::ChangeStream stream(engine, kMyConsumerId, my_storage_id);
+ * while (...) {
+ *   CHECK_ERROR(stream.fetch(16, 100000));  // wait up to 100ms for a new durable epoch
+ *   for (uint32_t i = 0; i < stream.get_change_count(); ++i) {
+ *     const foedus::log::RecordLogType* change = stream.get_change(i);
+ *     ... switch on change->header_.get_type(), eg kLogCodeArrayOverwrite ...
+ *   }
+ *   ... make the changes durable in the consumer ...
+ *   stream.ack();
+ * }
+ * @endcode
+ *
+ * @par Order and atomicity
+ * Each fetch() returns all committed record logs of one or more whole durable epochs, sorted
+ * by XctId. This is the serialization order of logs on the same record, and logs of one
+ * transaction are contiguous in the same order they were written.
+ * A fetch never returns a part of an epoch, so a consumer always sees transactionally
+ * consistent states at fetch boundaries.
+ *
+ * @par Cursors
+ * Each consumer has a ChangeStreamId and a cursor, the epoch up to which it has acknowledged
+ * changes via ack(). Cursors live in shared memory (so consumers can be in any SOC) and are
+ * persisted in the next savepoint. A new ChangeStream starts right after the cursor, so
+ * after a crash the consumer receives changes since its last persisted ack again
+ * (at-least-once). Use LogManager::set_change_stream_cursor() to (re)start from elsewhere.
+ *
+ * @par Where logs come from
+ * We read durable log files of all loggers, which survive restarts and are never modified.
+ * Record logs are handed out as pointers to our read buffers (or to decompressed blocks),
+ * without copying each log. They are valid until the next fetch() or destruction.
+ * Each fetch reads each logger's file sequentially from where the previous fetch ended.
+ * A new stream starts from the epoch marker after its cursor, which the logger's epoch history
+ * tells. The history does not survive restarts, so a new stream whose cursor is older than the
+ * logs of this run reads from the beginning of the log files and skips logs up to the cursor.
+ *
+ * This object is not thread-safe. Use one object per consumer thread.
+ */
+class ChangeStream CXX11_FINAL {
+ public:
+  enum Constants {
+    /** Default value of max_epochs in fetch(). */
+    kDefaultMaxEpochs = 16,
+    /** Initial size of the read buffer for each logger. It doubles if an epoch doesn't fit. */
+    kInitialReadBufferSize = 1 << 22,
+  };
+
+  /**
+   * @param[in] engine the engine in any SOC
+   * @param[in] id the consumer, which decides the cursor to start from
+   * @param[in] storage_id if non-zero, only changes in this storage are returned
+   */
+  ChangeStream(Engine* engine, ChangeStreamId id, storage::StorageId storage_id = 0);
+  ~ChangeStream() {}
+
+  ChangeStream() CXX11_FUNC_DELETE;
+  ChangeStream(const ChangeStream &other) CXX11_FUNC_DELETE;
+  ChangeStream& operator=(const ChangeStream &other) CXX11_FUNC_DELETE;
+
+  ChangeStreamId      get_id() const { return id_; }
+  storage::StorageId  get_storage_id() const { return storage_id_; }
+
+  /**
+   * Changes up to this epoch have been returned by fetch() (or acknowledged before this
+   * object was created). Always valid.
+   */
+  Epoch       get_fetched_epoch() const { return fetched_epoch_; }
+
+  /**
+   * @brief Reads committed changes after get_fetched_epoch().
+   * @param[in] max_epochs at most this number of epochs are returned at once
+   * @param[in] wait_microseconds if there is no new durable epoch, waits for one up to this
+   * duration. 0 returns immediately.
+   * @details
+   * On return, get_change_count() and get_change() give the changes in the epochs between
+   * the previous and the new get_fetched_epoch(). The new epochs might have no changes.
+   * If no new epoch became durable, get_fetched_epoch() does not change and there are no
+   * changes.
+   */
+  ErrorStack  fetch(uint32_t max_epochs = kDefaultMaxEpochs, uint64_t wait_microseconds = 0);
+
+  /** Number of changes returned by the last fetch(). */
+  uint32_t    get_change_count() const { return changes_.size(); }
+  /** Returns a change returned by the last fetch(), in serialization order. */
+  const RecordLogType* get_change(uint32_t index) const {
+    ASSERT_ND(index < changes_.size());
+    return changes_[index];
+  }
+
+  /**
+   * @brief Acknowledges all changes up to get_fetched_epoch().
+   * @details
+   * This moves the consumer's cursor, which is persisted in the next savepoint.
+   * Call this after the consumer made the changes durable on its side.
+   */
+  void        ack();
+
+  friend std::ostream& operator<<(std::ostream& o, const ChangeStream& v);
+
+ private:
+  /** Where we read next in a logger's files. */
+  struct LoggerPosition {
+    LogFileOrdinal  ordinal_;
+    uint64_t        offset_;
+  };
+  /** A log picked up in the current fetch. */
+  struct StagedChange {
+    xct::XctId  xct_id_;
+    /** Index of read_buffers_, or kDecompressed. */
+    uint32_t    source_;
+    /** Position in the source. */
+    uint64_t    position_;
+  };
+  /** Result of reading one logger in the current fetch. */
+  struct LoggerScan {
+    /** We have all logs of this logger up to this epoch. */
+    Epoch           complete_epoch_;
+    /** The largest epoch of the logs we picked up. */
+    Epoch           max_epoch_;
+    /** Whether we stopped because the read buffer is full. */
+    bool            buffer_full_;
+    /** Where we stopped. The next fetch starts here unless we rewind it. */
+    LoggerPosition  end_;
+    /** Where the first log of each epoch is, in epoch order. To rewind end_. */
+    std::vector< std::pair<Epoch, LoggerPosition> > epoch_begins_;
+  };
+  enum SourceConstants {
+    kDecompressed = 0xFFFFFFFFU,
+  };
+
+  /** Reads logs in (fetched_epoch_, until_epoch] from one logger into its read buffer. */
+  ErrorStack  read_logger(LoggerId logger_id, Epoch until_epoch, LoggerScan* scan);
+  /**
+   * Sub-routine of read_logger() to pick up logs in the read buffer.
+   * @param[in] begin where the first log starts in the read buffer
+   * @param[in] end where valid data ends in the read buffer
+   * @param[in] infile_base file offset of the beginning of the read buffer
+   * @param[out] consumed bytes of complete logs we went through
+   * @param[out] hit_until whether we hit a log after until_epoch, where we must stop
+   */
+  ErrorCode   scan_buffer(
+    LoggerId logger_id,
+    uint64_t begin,
+    uint64_t end,
+    uint64_t infile_base,
+    Epoch until_epoch,
+    LoggerScan* scan,
+    uint64_t* consumed,
+    bool* hit_until);
+  /** Picks up a record log if it is in the storage we follow. */
+  void        stage_change(uint32_t source, uint64_t position, const LogHeader* header);
+
+  Engine* const             engine_;
+  const ChangeStreamId      id_;
+  const storage::StorageId  storage_id_;
+  Epoch                     fetched_epoch_;
+
+  /** Index is LoggerId. */
+  std::vector<LoggerPosition>         positions_;
+  /** Index is LoggerId. Logs of a logger in the current fetch, as read from the file. */
+  std::vector<memory::AlignedMemory>  read_buffers_;
+  /** Logs decompressed from CompressedBlockLogType in the current fetch. */
+  std::vector<char>                   decompressed_;
+  std::vector<StagedChange>           staged_;
+  /** The result of the last fetch, pointing to read_buffers_ and decompressed_. */
+  std::vector<const RecordLogType*>   changes_;
+};
+
+}  // namespace log
+}  // namespace foedus
+#endif  // FOEDUS_LOG_CHANGE_STREAM_HPP_
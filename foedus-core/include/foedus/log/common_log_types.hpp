@@ -252,6 +252,70 @@ STATIC_SIZE_CHECK(sizeof(FillerLogType), 16)
 // NOTE: As a class, it's 16 bytes. However, it might be only 8 bytes in actual log.
 // In that case, xct_id is omitted.
 
+/**
+ * @brief A block of logs compressed by the logger.
+ * @ingroup LOG LOGTYPE
+ * @details
+ * When LogOptions::compress_logs_ is true, loggers compress the logs they write out in blocks
+ * of up to kMaxRawSize bytes and write this log type instead of the raw logs.
+ * A block always contains only complete logs, so readers (log mappers, log replayers, and
+ * foedus_dump_log) decompress each block with decompress_log_block() and process the logs in it
+ * as if they were in the file. The logs in a block share the block's file offset.
+ * Epoch markers are never compressed, so epoch histories and file offsets work as usual.
+ *
+ * The compressed data immediately follows this struct, then up to 7 bytes of padding
+ * to keep the log 8-byte aligned.
+ */
+struct CompressedBlockLogType : public BaseLogType {
+  /** Constant values. */
+  enum Constants {
+    /** Logger compresses logs in blocks of up to this size. */
+    kMaxRawSize = 1 << 15,
+  };
+
+  LOG_TYPE_NO_CONSTRUCT(CompressedBlockLogType)
+
+  // Like FillerLogType, this is valid and skipped in every context. Readers decompress it.
+  bool    is_engine_log()     const { return true; }
+  bool    is_storage_log()    const { return true; }
+  bool    is_record_log()     const { return true; }
+  void    apply_engine(thread::Thread* /*context*/) {}
+  void    apply_storage(Engine* /*engine*/, storage::StorageId /*storage_id*/) {}
+  void    apply_record(
+    thread::Thread* /*context*/,
+    storage::StorageId /*storage_id*/,
+    xct::LockableXctId* /*owner_id*/,
+    char* /*payload*/) {}
+
+  /** Byte size of the logs in this block after decompression. */
+  uint32_t    raw_length_;  // +4 => 20
+  /** Byte size of the compressed data, excluding the padding. */
+  uint32_t    compressed_length_;  // +4 => 24
+
+  const char* get_data() const { return reinterpret_cast<const char*>(this) + sizeof(*this); }
+  char*       get_data() { return reinterpret_cast<char*>(this) + sizeof(*this); }
+
+  /** Returns log_length_ of a block whose compressed data is of the given size. */
+  static uint32_t calculate_log_length(uint32_t compressed_length) ALWAYS_INLINE {
+    return assorted::align8<uint32_t>(sizeof(CompressedBlockLogType) + compressed_length);
+  }
+
+  /** Populate this log after compressed_length bytes of data are written to get_data(). */
+  void    populate(uint32_t raw_length, uint32_t compressed_length);
+
+  void    assert_valid() const ALWAYS_INLINE {
+    ASSERT_ND(header_.get_type() == kLogCodeCompressedBlock);
+    ASSERT_ND(header_.log_length_ == calculate_log_length(compressed_length_));
+    ASSERT_ND(header_.storage_id_ == 0);
+    ASSERT_ND(raw_length_ > 0);
+    ASSERT_ND(raw_length_ <= kMaxRawSize);
+    ASSERT_ND(compressed_length_ < raw_length_);
+  }
+
+  friend std::ostream& operator<<(std::ostream& o, const CompressedBlockLogType &v);
+};
+STATIC_SIZE_CHECK(sizeof(CompressedBlockLogType), 24)
+
 /**
  * @brief A log type to declare a switch of epoch in a logger or the engine.
  * @ingroup LOG LOGTYPE
@@ -25,10 +25,14 @@
 namespace foedus {
 namespace log {
 struct  BaseLogType;
+class   ChangeStream;
+struct  CompressedBlockLogType;
+class   DirectIoLogDevice;
 struct  EngineLogType;
 struct  EpochHistory;
 struct  EpochMarkerLogType;
 struct  FillerLogType;
+class   LogDevice;
 struct  LogHeader;
 class   LogManager;
 struct  LogManagerControlBlock;
@@ -40,6 +44,7 @@ struct  LoggerControlBlock;
 class   MetaLogBuffer;
 struct  MetaLogControlBlock;
 class   MetaLogger;
+class   PmemLogDevice;
 struct  RecordLogType;
 struct  StorageLogType;
 struct  ThreadEpockMark;
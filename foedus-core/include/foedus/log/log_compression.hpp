@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_LOG_LOG_COMPRESSION_HPP_
+#define FOEDUS_LOG_LOG_COMPRESSION_HPP_
+#include <stdint.h>
+
+/**
+ * @file foedus/log/log_compression.hpp
+ * @brief The block codec loggers use to compress logs.
+ * @ingroup LOG
+ * @details
+ * A small LZ77 codec in the spirit of LZ4, specialized for log blocks
+ * (CompressedBlockLogType::kMaxRawSize bytes or less). Logs compress well with it because
+ * consecutive logs repeat the same header fields, storage IDs, key prefixes, and often
+ * similar payloads. It favors speed over ratio so that the logger keeps up with SSDs.
+ *
+ * The compressed data is a series of sequences. Each sequence is:
+ *  \li 1 byte token: upper 4 bits for the literal length, lower 4 bits for the match length
+ *  minus kMinMatch. 15 in either half means that more length bytes follow (each adds up to 255,
+ *  the series ends with a byte less than 255).
+ *  \li the literals.
+ *  \li 2 bytes little-endian offset of the match, counted back from the current position.
+ *  \li more match length bytes, if any.
+ *
+ * The last sequence contains only literals, and no offset.
+ */
+namespace foedus {
+namespace log {
+
+/**
+ * @brief Compresses a block of logs.
+ * @param[in] raw the logs to compress
+ * @param[in] raw_size byte size of raw. At most CompressedBlockLogType::kMaxRawSize
+ * @param[out] out the compressed data is written to here
+ * @param[in] out_capacity byte size of out
+ * @return byte size of the compressed data. 0 if it does not fit in out_capacity, in which case
+ * the caller should write out the raw logs instead.
+ */
+uint32_t compress_log_block(
+  const char* raw,
+  uint32_t raw_size,
+  char* out,
+  uint32_t out_capacity);
+
+/**
+ * @brief Decompresses a block compressed by compress_log_block().
+ * @param[in] compressed the compressed data
+ * @param[in] compressed_size byte size of compressed
+ * @param[out] out the logs are written to here
+ * @param[in] raw_size exact byte size of the logs after decompression
+ * @return whether the data is well-formed and decompressed to exactly raw_size bytes.
+ * false means the log file is corrupted.
+ */
+bool decompress_log_block(
+  const char* compressed,
+  uint32_t compressed_size,
+  char* out,
+  uint32_t raw_size);
+
+}  // namespace log
+}  // namespace foedus
+#endif  // FOEDUS_LOG_LOG_COMPRESSION_HPP_
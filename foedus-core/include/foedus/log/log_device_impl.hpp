@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_LOG_LOG_DEVICE_IMPL_HPP_
+#define FOEDUS_LOG_LOG_DEVICE_IMPL_HPP_
+#include <stdint.h>
+
+#include <iosfwd>
+
+#include "foedus/error_code.hpp"
+#include "foedus/fs/device_emulation_options.hpp"
+#include "foedus/fs/direct_io_file.hpp"
+#include "foedus/fs/path.hpp"
+#include "foedus/log/fwd.hpp"
+
+namespace foedus {
+namespace log {
+
+/**
+ * @brief The device a logger appends its log file to.
+ * @ingroup LOG
+ * @details
+ * A logger appends log blocks to the current log file, then makes them durable before it
+ * advances its durable epoch. This class abstracts how these two are done.
+ *  \li DirectIoLogDevice (kLogDeviceDirectIo) writes via DirectIoFile and calls fsync.
+ *  \li PmemLogDevice (kLogDevicePmem) memcpy-s to an mmap-ed file on persistent memory and
+ * flushes cache lines. Making logs durable is just a store fence, no system calls.
+ *
+ * Regardless of the device, the content of log files is the same (blocks padded to
+ * FillerLogType::kLogWriteUnitSize), so log mappers and log replayers read them as usual.
+ *
+ * This is a private implementation-details of \ref LOG, thus file name ends with _impl.
+ * Do not include this header from a client program unless you know what you are doing.
+ */
+class LogDevice {
+ public:
+  /** Instantiates the device specified in the options. The caller is responsible to delete it. */
+  static LogDevice* create(const fs::Path& path, const LogOptions& options);
+
+  explicit LogDevice(const fs::Path& path) : path_(path), current_offset_(0) {}
+  virtual ~LogDevice() {}
+
+  LogDevice() = delete;
+  LogDevice(const LogDevice& other) = delete;
+  LogDevice& operator=(const LogDevice& other) = delete;
+
+  /**
+   * Opens the file to append, creating it and its folder if not exists.
+   * The current offset is set to the end of the file.
+   */
+  virtual ErrorCode   open() = 0;
+  virtual bool        is_opened() const = 0;
+  /** Closes the file. This does not make the appended logs durable. */
+  virtual bool        close() = 0;
+  /**
+   * Appends the given bytes at the current offset. The bytes are not yet durable.
+   * @pre bytes % FillerLogType::kLogWriteUnitSize == 0
+   */
+  virtual ErrorCode   append(uint64_t bytes, const void* buffer) = 0;
+  /** Durably discards everything after the given offset. */
+  virtual ErrorCode   truncate(uint64_t new_length) = 0;
+  /** Makes everything appended so far durable. */
+  virtual bool        make_durable() = 0;
+  virtual const char* get_device_name() const = 0;
+
+  const fs::Path&     get_path() const { return path_; }
+  uint64_t            get_current_offset() const { return current_offset_; }
+
+  friend std::ostream& operator<<(std::ostream& o, const LogDevice& v);
+
+ protected:
+  const fs::Path      path_;
+  /** Byte offset to append next logs to. */
+  uint64_t            current_offset_;
+};
+
+/**
+ * @brief The default log device that writes with (optionally) direct I/O and fsync.
+ * @ingroup LOG
+ */
+class DirectIoLogDevice final : public LogDevice {
+ public:
+  DirectIoLogDevice(const fs::Path& path, const fs::DeviceEmulationOptions& emulation)
+    : LogDevice(path), file_(path, emulation) {}
+
+  ErrorCode   open() override;
+  bool        is_opened() const override { return file_.is_opened(); }
+  bool        close() override { return file_.close(); }
+  ErrorCode   append(uint64_t bytes, const void* buffer) override;
+  ErrorCode   truncate(uint64_t new_length) override;
+  bool        make_durable() override;
+  const char* get_device_name() const override { return "DirectIo"; }
+
+ private:
+  fs::DirectIoFile  file_;
+};
+
+/**
+ * @brief Log device on byte-addressable persistent memory.
+ * @ingroup LOG
+ * @details
+ * The log file is preallocated and mmap-ed. append() is a memcpy followed by cache-line
+ * flushes (clwb if the CPU has it, otherwise clflushopt or clflush) of the written range,
+ * and make_durable() is an sfence. Thus, advancing the durable epoch needs no system call.
+ *
+ * This is durable only when the file is on a DAX filesystem (eg ext4/xfs mounted with -o dax
+ * on an NVDIMM or a DAX-emulated ramdisk) and the mapping succeeds with MAP_SYNC.
+ * Otherwise (eg /dev/shm for testing), the mapping is backed by page cache, so we fall back
+ * to msync() on the newly appended range in make_durable().
+ *
+ * The file is preallocated in chunks and remapped when it grows beyond the mapped size.
+ * close() trims the file to the actual log size. The emulation options are respected for
+ * throughput modeling (null_device_ and emulated_write_kb_cycles_).
+ */
+class PmemLogDevice final : public LogDevice {
+ public:
+  enum Constants {
+    /** We preallocate and map at least this size, or log_file_size_mb_ if it's smaller. */
+    kInitialMappedSize = 1 << 26,
+  };
+  PmemLogDevice(
+    const fs::Path& path,
+    uint64_t initial_mapped_size,
+    const fs::DeviceEmulationOptions& emulation);
+  ~PmemLogDevice();
+
+  ErrorCode   open() override;
+  bool        is_opened() const override { return descriptor_ >= 0; }
+  bool        close() override;
+  ErrorCode   append(uint64_t bytes, const void* buffer) override;
+  ErrorCode   truncate(uint64_t new_length) override;
+  bool        make_durable() override;
+  const char* get_device_name() const override { return dax_ ? "Pmem(DAX)" : "Pmem(msync)"; }
+
+  /** Whether the mapping is synchronous (MAP_SYNC), thus flushing cache lines suffices. */
+  bool        is_dax() const { return dax_; }
+
+ private:
+  /** Preallocates the file up to the given size and maps it. */
+  ErrorCode   map_file(uint64_t mapped_size);
+  void        unmap_file();
+
+  const fs::DeviceEmulationOptions emulation_;
+  const uint64_t  initial_mapped_size_;
+  int             descriptor_;
+  char*           mapped_;
+  uint64_t        mapped_size_;
+  /** Appended logs up to this offset are known to be durable. */
+  uint64_t        durable_offset_;
+  bool            dax_;
+};
+
+}  // namespace log
+}  // namespace foedus
+#endif  // FOEDUS_LOG_LOG_DEVICE_IMPL_HPP_
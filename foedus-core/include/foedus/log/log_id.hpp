@@ -45,6 +45,23 @@ typedef uint16_t LoggerId;
  */
 typedef uint32_t LogFileOrdinal;
 
+/**
+ * @typedef ChangeStreamId
+ * @brief Identifies a consumer of ChangeStream.
+ * @ingroup LOG
+ * @details
+ * The application assigns IDs to its consumers, from 0 to kMaxChangeStreams - 1.
+ * Each ID has a cursor, the epoch up to which the consumer has processed changes, and the
+ * cursors are persisted in the savepoint.
+ */
+typedef uint16_t ChangeStreamId;
+
+/**
+ * Maximum number of ChangeStream consumers.
+ * @ingroup LOG
+ */
+const uint16_t kMaxChangeStreams = 64;
+
 /**
  * a contiguous range of log entries that might span multiple files.
  * @ingroup LOG
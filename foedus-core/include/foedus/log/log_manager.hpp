@@ -53,6 +53,28 @@ class LogManager CXX11_FINAL : public virtual Initializable {
    * This is called as a part of taking a savepoint.
    */
   void        copy_logger_states(savepoint::Savepoint *new_savepoint);
+  /**
+   * @brief Fillup the given savepoint with the cursors of ChangeStream consumers.
+   * @details
+   * This is called as a part of taking a savepoint.
+   */
+  void        copy_change_stream_cursors(savepoint::Savepoint *new_savepoint);
+
+  /**
+   * @brief Returns the epoch up to which the given ChangeStream consumer has acknowledged.
+   * @details
+   * kEpochInvalid if the consumer has never acknowledged, meaning it starts from the oldest
+   * logs. The cursor survives restarts as far as a savepoint was taken after it was set.
+   */
+  Epoch       get_change_stream_cursor(ChangeStreamId id) const;
+  /**
+   * @brief Sets the cursor of the given ChangeStream consumer.
+   * @details
+   * ChangeStream::ack() calls this. The application can also call this to (re)start a
+   * consumer from an arbitrary epoch, eg the current durable epoch to skip existing logs.
+   * The new value is persisted in the next savepoint.
+   */
+  void        set_change_stream_cursor(ChangeStreamId id, Epoch epoch);
 
   /**
    * @brief Wake up loggers if they are sleeping.
@@ -102,6 +124,20 @@ class LogManager CXX11_FINAL : public virtual Initializable {
    */
   ErrorCode   wait_until_durable(Epoch commit_epoch, int64_t wait_microseconds = -1);
 
+  /**
+   * @brief Blocks until the durable global epoch becomes larger than the given epoch or the
+   * given duration elapses, whichever comes first.
+   * @param[in] observed_epoch The durable global epoch the caller has last observed.
+   * @param[in] wait_microseconds Maximum duration to block.
+   * @details
+   * Unlike wait_until_durable(), this method neither wakes up loggers nor reports a timeout.
+   * It is for background threads that react to every advancement of the durable epoch,
+   * such as the commit notifier in XctManager.
+   */
+  void        wait_for_durable_global_epoch_advance(
+    Epoch observed_epoch,
+    uint64_t wait_microseconds);
+
   /**
    * @brief Called whenever there is a chance that the global durable epoch advances.
    * @details
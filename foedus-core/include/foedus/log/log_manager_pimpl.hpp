@@ -22,10 +22,12 @@
 #include <atomic>
 #include <vector>
 
+#include "foedus/assert_nd.hpp"
 #include "foedus/epoch.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/initializable.hpp"
 #include "foedus/log/fwd.hpp"
+#include "foedus/log/log_id.hpp"
 #include "foedus/log/logger_ref.hpp"
 #include "foedus/log/meta_log_buffer.hpp"
 #include "foedus/savepoint/fwd.hpp"
@@ -67,6 +69,15 @@ struct LogManagerControlBlock {
 
   /** To-be-removed Serializes the thread to take savepoint to advance durable_global_epoch_. */
   soc::SharedMutex                    durable_global_epoch_savepoint_mutex_;
+
+  /**
+   * @brief Cursors of ChangeStream consumers. Index is ChangeStreamId.
+   * @details
+   * The epoch up to which each consumer has acknowledged changes. kEpochInvalid if never.
+   * Loaded from the savepoint on startup, and copied to each new savepoint.
+   * This is in shared memory so that consumers in any SOC can use ChangeStream.
+   */
+  std::atomic<Epoch::EpochInteger>    change_stream_cursors_[kMaxChangeStreams];
 };
 
 /**
@@ -85,8 +96,20 @@ class LogManagerPimpl final : public DefaultInitializable {
 
   void        wakeup_loggers();
   ErrorCode   wait_until_durable(Epoch commit_epoch, int64_t wait_microseconds);
+  void        wait_for_durable_global_epoch_advance(
+    Epoch observed_epoch,
+    uint64_t wait_microseconds);
   ErrorStack  refresh_global_durable_epoch();
   void        copy_logger_states(savepoint::Savepoint *new_savepoint);
+  void        copy_change_stream_cursors(savepoint::Savepoint *new_savepoint);
+  Epoch       get_change_stream_cursor(ChangeStreamId id) const {
+    ASSERT_ND(id < kMaxChangeStreams);
+    return Epoch(control_block_->change_stream_cursors_[id].load());
+  }
+  void        set_change_stream_cursor(ChangeStreamId id, Epoch epoch) {
+    ASSERT_ND(id < kMaxChangeStreams);
+    control_block_->change_stream_cursors_[id].store(epoch.value());
+  }
 
   Epoch       get_durable_global_epoch() const {
     return Epoch(control_block_->durable_global_epoch_.load());
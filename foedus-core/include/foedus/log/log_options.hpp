@@ -30,6 +30,21 @@
 
 namespace foedus {
 namespace log {
+/**
+ * @brief Type of the device loggers write log files to.
+ * @ingroup LOG
+ * @see LogDevice
+ */
+enum LogDeviceType {
+  /** Block devices such as SSD. Written with direct I/O and made durable with fsync. */
+  kLogDeviceDirectIo = 0,
+  /**
+   * Byte-addressable persistent memory. Log files must be on a DAX filesystem to be durable.
+   * Written via mmap and made durable with cache-line flushes, without system calls.
+   */
+  kLogDevicePmem = 1,
+};
+
 /**
  * @brief Set of options for log manager.
  * @ingroup LOG
@@ -100,6 +115,38 @@ struct LogOptions CXX11_FINAL : public virtual externalize::Externalizable {
    */
   bool                        flush_at_shutdown_;
 
+  /**
+   * @brief Type of the device loggers write log files to.
+   * @details
+   * Default is kLogDeviceDirectIo. When this is kLogDevicePmem, folder_path_pattern_ should
+   * point to a DAX filesystem. Any other filesystem works, too (eg /dev/shm for testing),
+   * but then loggers fall back to msync() to make logs durable.
+   */
+  LogDeviceType               device_type_;
+
+  /**
+   * @brief Whether loggers compress logs before writing them out.
+   * @details
+   * If true, loggers compress logs in blocks (CompressedBlockLogType) with a fast LZ codec,
+   * trading logger CPU for fewer bytes written. This helps when the log device is the
+   * bottleneck, especially with repetitive logs such as masstree keys.
+   * Log mappers and log replayers handle both compressed and raw logs regardless of this
+   * setting, so it can be changed on restart. Default is false.
+   */
+  bool                        compress_logs_;
+
+  /**
+   * @brief Whether loggers in the same NUMA node steal each other's per-thread log buffers.
+   * @details
+   * Each logger is assigned a fixed set of worker threads. When a few threads produce most of
+   * the logs, their logger saturates while others idle, and the durable epoch lags behind.
+   * If true, a logger that finished its own threads for an epoch picks up the not-yet-written
+   * buffers of other loggers in the node for the same epoch, and loggers in a node advance
+   * their durable epochs together so that idle loggers are there to help.
+   * Meaningful only when loggers_per_node_ > 1. Default is false.
+   */
+  bool                        logger_work_stealing_;
+
   /** Settings to emulate slower logging device. */
   foedus::fs::DeviceEmulationOptions emulation_;
 
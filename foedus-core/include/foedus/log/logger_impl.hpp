@@ -21,6 +21,7 @@
 
 #include <atomic>
 #include <iosfwd>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -30,6 +31,7 @@
 #include "foedus/epoch.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/initializable.hpp"
+#include "foedus/debugging/latency_histogram.hpp"
 #include "foedus/fs/fwd.hpp"
 #include "foedus/fs/path.hpp"
 #include "foedus/log/epoch_history.hpp"
@@ -67,6 +69,12 @@ struct LoggerControlBlock {
     stop_requested_ = false;
     epoch_history_head_ = 0;
     epoch_history_count_ = 0;
+    stat_written_bytes_ = 0;
+    stat_raw_log_bytes_ = 0;
+    stat_stolen_log_bytes_ = 0;
+    stat_max_epoch_lag_ = 0;
+    stat_fsyncs_ = 0;
+    stat_fsync_latency_ns_.reset();
   }
   void uninitialize() {
     epoch_history_mutex_.uninitialize();
@@ -142,6 +150,28 @@ struct LoggerControlBlock {
   /** Whether this logger should terminate */
   std::atomic<bool>               stop_requested_;
 
+  /** [statistics] Bytes this logger wrote out to log files and then fsync-ed. */
+  uint64_t                        stat_written_bytes_;
+  /**
+   * [statistics] Bytes of logs this logger copied from worker threads' buffers, before
+   * compression and padding. Compare with stat_written_bytes_ to see the compression ratio.
+   */
+  uint64_t                        stat_raw_log_bytes_;
+  /**
+   * [statistics] Part of stat_raw_log_bytes_ this logger wrote out on behalf of other loggers
+   * in the same node. Non-zero only with LogOptions::logger_work_stealing_.
+   */
+  uint64_t                        stat_stolen_log_bytes_;
+  /**
+   * [statistics] The largest number of epochs this logger has been behind the current global
+   * epoch when it started writing out an epoch. 2 means it was keeping up.
+   */
+  uint64_t                        stat_max_epoch_lag_;
+  /** [statistics] Number of fsync calls on log files. */
+  uint64_t                        stat_fsyncs_;
+  /** [statistics] Latency of each fsync call in nanoseconds. */
+  debugging::LatencyHistogram     stat_fsync_latency_ns_;
+
   /** the followings are covered this mutex */
   soc::SharedMutex  epoch_history_mutex_;
 
@@ -158,6 +188,25 @@ struct LoggerControlBlock {
   EpochHistory      epoch_histories_[kMaxEpochHistory];
 };
 
+/**
+ * @brief Claim on a worker thread's log buffer, shared by the loggers in the same node.
+ * @details
+ * With LogOptions::logger_work_stealing_, any logger in the node might write out the logs
+ * of a thread in an epoch, but only one of them may touch the buffer at a time because
+ * ThreadLogBuffer::get_logs_to_write() and on_log_written() modify the buffer's meta.
+ * A logger takes epoch E of the buffer by changing claimed_epoch_ from E-1 to E, and
+ * announces it is done by setting written_epoch_ to E.
+ * Both are kEpochInvalid until the owner logger writes out the buffer for the first time.
+ */
+struct ThreadLogClaim {
+  ThreadLogClaim() : claimed_epoch_(Epoch::kEpochInvalid), written_epoch_(Epoch::kEpochInvalid) {}
+
+  /** The latest epoch of the buffer a logger has taken (might be still writing it out). */
+  std::atomic< Epoch::EpochInteger >  claimed_epoch_;
+  /** The latest epoch of the buffer a logger has completely written out. */
+  std::atomic< Epoch::EpochInteger >  written_epoch_;
+};
+
 /**
  * @brief A log writer that writes out buffered logs to stable storages.
  * @ingroup LOG
@@ -174,13 +223,22 @@ class Logger final : public DefaultInitializable, public LoggerRef {
     thread::ThreadGroupId numa_node,
     uint8_t in_node_ordinal,
     const fs::Path &log_folder,
-    const std::vector< thread::ThreadId > &assigned_thread_ids)
+    const std::vector< thread::ThreadId > &assigned_thread_ids,
+    const std::vector< Logger* >* node_loggers)
   : LoggerRef(engine, control_block, id, numa_node, in_node_ordinal),
     log_folder_(log_folder),
-    assigned_thread_ids_(assigned_thread_ids) {}
+    assigned_thread_ids_(assigned_thread_ids),
+    node_loggers_(node_loggers) {}
   ErrorStack  initialize_once() override;
   ErrorStack  uninitialize_once() override;
 
+  /**
+   * Stops and joins the logger thread. Idempotent.
+   * With work stealing, a logger thread might touch other loggers in the node, so the log
+   * manager stops all of them before uninitializing any.
+   */
+  void        stop_logger_thread();
+
   Logger() = delete;
   Logger(const Logger &other) = delete;
   Logger& operator=(const Logger &other) = delete;
@@ -217,6 +275,12 @@ class Logger final : public DefaultInitializable, public LoggerRef {
    */
   ErrorStack  switch_file_if_required();
 
+  /**
+   * Makes the current file durable, recording its latency in the statistics.
+   * If the file is already closed, fsync it and its folder.
+   */
+  bool        fsync_current_file();
+
   /**
    * Makes sure no thread is still writing out logs in epochs older than the given epoch
    * (same epoch is fine). Waits (spins) if needed, and also writes out the logs of lagging
@@ -243,6 +307,29 @@ class Logger final : public DefaultInitializable, public LoggerRef {
    * @post logger's durable_epoch is updated to write_epoch if this method successfully returns
    */
   ErrorStack  write_one_epoch(Epoch write_epoch);
+  /**
+   * Sub-routine of write_one_epoch().
+   * Writes out the logs of the given thread in the given epoch, writing out an epoch mark
+   * first if this is the first non-empty buffer in the epoch.
+   * The caller must hold the thread's ThreadLogClaim for write_epoch.
+   */
+  ErrorStack  write_thread_logs(ThreadLogBuffer* buffer, Epoch write_epoch, bool* had_any_log);
+  /**
+   * Sub-routine of write_one_epoch() with LogOptions::logger_work_stealing_.
+   * Writes out the logs in write_epoch of other loggers' threads in the node that their
+   * owners have not claimed yet.
+   * Their owners can advance their durable epochs without waiting for us because the global
+   * durable epoch can't pass write_epoch until we make them durable, too.
+   */
+  ErrorStack  steal_node_logs(Epoch write_epoch, bool* had_any_log);
+  /**
+   * With LogOptions::logger_work_stealing_, a logger does not move on to the next epoch
+   * until all loggers in the node have caught up with its durable epoch. Otherwise a fast
+   * logger would run ahead and never find anything to steal in the same epoch.
+   */
+  bool        is_ahead_of_node_loggers(Epoch durable_epoch) const;
+  /** Wakes up other loggers in the node that might be waiting for us to catch up. */
+  void        wakeup_node_loggers();
   /**
    * Sub-routine of write_one_epoch().
    * Writes out the given piece of the given buffer.
@@ -255,6 +342,13 @@ class Logger final : public DefaultInitializable, public LoggerRef {
     uint64_t from_offset,
     uint64_t upto_offset);
 
+  /**
+   * Sub-routine of write_one_epoch_piece() when LogOptions::compress_logs_ is true.
+   * Writes out the given logs in CompressedBlockLogType blocks via compress_buffer_,
+   * padding the end to 4kb. A block that does not shrink is written out as raw logs.
+   */
+  ErrorStack  write_compressed_logs(const char* logs, uint64_t bytes);
+
   /** Check invariants. This method is wiped out in NDEBUG. */
   void        assert_consistent();
   /** Sanity check on logs to write out. This method is wiped out in NDEBUG. */
@@ -280,10 +374,20 @@ class Logger final : public DefaultInitializable, public LoggerRef {
    */
   memory::AlignedMemory           fill_buffer_;
 
+  /**
+   * @brief An aligned buffer to stage compressed blocks before writing them out.
+   * @details
+   * Allocated only when LogOptions::compress_logs_ is true.
+   * @see write_compressed_logs()
+   */
+  memory::AlignedMemory           compress_buffer_;
+
   /**
    * @brief The log file this logger is currently appending to.
+   * @details
+   * DirectIoLogDevice or PmemLogDevice depending on LogOptions::device_type_.
    */
-  fs::DirectIoFile*               current_file_;
+  LogDevice*                      current_file_;
   /**
    * [log_folder_]/[id_]_[current_ordinal_].log.
    */
@@ -291,6 +395,18 @@ class Logger final : public DefaultInitializable, public LoggerRef {
 
   std::vector< thread::Thread* >  assigned_threads_;
 
+  /**
+   * Claims on assigned_threads_, in the same order. Other loggers in the node touch them
+   * when they steal our threads' logs.
+   */
+  std::unique_ptr< ThreadLogClaim[] > claims_;
+
+  /**
+   * All loggers in this node including this, owned by LogManagerPimpl.
+   * Used only with LogOptions::logger_work_stealing_.
+   */
+  const std::vector< Logger* >* const node_loggers_;
+
   /** protects log_epoch_switch() from concurrent accesses. */
   std::mutex                      epoch_switch_mutex_;
 };
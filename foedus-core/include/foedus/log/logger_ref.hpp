@@ -18,9 +18,12 @@
 #ifndef FOEDUS_LOG_LOGGER_REF_HPP_
 #define FOEDUS_LOG_LOGGER_REF_HPP_
 
+#include <stdint.h>
+
 #include "foedus/attachable.hpp"
 #include "foedus/epoch.hpp"
 #include "foedus/fwd.hpp"
+#include "foedus/debugging/fwd.hpp"
 #include "foedus/log/fwd.hpp"
 #include "foedus/log/log_id.hpp"
 #include "foedus/savepoint/fwd.hpp"
@@ -45,6 +48,19 @@ class LoggerRef : public Attachable<LoggerControlBlock> {
   /** Returns this logger's durable epoch. */
   Epoch       get_durable_epoch() const;
 
+  /** [statistics] Bytes this logger wrote out to log files and then fsync-ed. */
+  uint64_t    get_stat_written_bytes() const;
+  /** [statistics] Bytes of logs this logger wrote out, before compression and padding. */
+  uint64_t    get_stat_raw_log_bytes() const;
+  /** [statistics] Bytes of logs this logger wrote out for threads of other loggers. */
+  uint64_t    get_stat_stolen_log_bytes() const;
+  /** [statistics] Largest lag in epochs between the current epoch and the epoch being written. */
+  uint64_t    get_stat_max_epoch_lag() const;
+  /** [statistics] Number of fsync calls on log files. */
+  uint64_t    get_stat_fsyncs() const;
+  /** [statistics] Latency of each fsync call in nanoseconds. */
+  const debugging::LatencyHistogram& get_stat_fsync_latency_ns() const;
+
   /**
    * @brief Wakes up this logger if it is sleeping.
    */
@@ -79,6 +95,20 @@ class LoggerRef : public Attachable<LoggerControlBlock> {
    */
   LogRange get_log_range(Epoch prev_epoch, Epoch until_epoch);
 
+  /**
+   * @brief Locates where to start reading logs after the given epoch.
+   * @param[in] prev_epoch Log entries until this epoch are skipped.
+   * @param[out] ordinal log file ordinal of the epoch marker to start from
+   * @param[out] offset offset of the epoch marker in the file
+   * @return whether the epoch history tells it. False if the history does not go back to
+   * prev_epoch, eg prev_epoch is before restart.
+   * @details
+   * This returns the first epoch marker after prev_epoch, or the last epoch marker if there is
+   * none yet. Logs after the position might still contain prev_epoch or older, so the reader
+   * must skip them. Unlike get_log_range(), this never fails when the epoch is not in the history.
+   */
+  bool     find_epoch_position(Epoch prev_epoch, LogFileOrdinal* ordinal, uint64_t* offset);
+
  protected:
   LoggerId  id_;
   uint16_t  numa_node_;
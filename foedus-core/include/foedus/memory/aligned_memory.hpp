@@ -57,6 +57,13 @@ namespace memory {
  *  \li to immediately finalize memory allocation, which (with big allocation size) strongly advises
  * Linux to use THP.
  *
+ * mmap-ed memory is zero-filled by the OS when it is first touched, so for such memory we just
+ * touch each page rather than memset the whole block, in parallel with threads on the NUMA node
+ * when the block is large. See prefault_memory(). Memory that is overwritten before it is read
+ * anyway, such as page pools and log buffers, can even skip it by giving prefault=false to
+ * alloc(). Then pages are faulted in when they are first used, and we mbind the block to the
+ * NUMA node so that they are still allocated on the node whichever thread touches them first.
+ *
  * To check if THP is actually used, check /proc/meminfo before/after the engine start-up.
  * AnonHugePages tells it. We at least confirmed that THP is used in Fedora 19/20.
  * For more details, see the section in README.markdown.
@@ -137,12 +144,18 @@ class AlignedMemory CXX11_FINAL {
   /** Automatically releases the memory. */
   ~AlignedMemory() { release_block(); }
 
-  /** Allocate a memory, releasing the current memory if exists. */
+  /**
+   * Allocate a memory, releasing the current memory if exists.
+   * @param[in] prefault whether to fault in all pages now. If false, pages are faulted in
+   * (zero-filled by OS) when first touched. Ignored for kPosixMemalign, which is always
+   * zero-cleared because the heap might reuse dirty memory.
+   */
   void        alloc(
     uint64_t size,
     uint64_t alignment,
     AllocType alloc_type,
-    int numa_node) CXX11_NOEXCEPT;
+    int numa_node,
+    bool prefault = true) CXX11_NOEXCEPT;
   /** Short for alloc(kNumaAllocOnnode) */
   void        alloc_onnode(uint64_t size, uint64_t alignment, int numa_node) CXX11_NOEXCEPT {
     alloc(size, alignment, kNumaAllocOnnode, numa_node);
@@ -245,6 +258,18 @@ struct AlignedMemorySlice CXX11_FINAL {
 /** Returns if 1GB hugepages were enabled. */
 bool is_1gb_hugepage_enabled();
 
+/**
+ * @brief Faults in all pages of a newly mapped memory block on the given NUMA node.
+ * @ingroup MEMORY
+ * @details
+ * Anonymous mmap and System-V shared memory are zero-filled by the OS, so we don't have to write
+ * every byte. Writing one byte per 4kb page is enough to make the OS allocate (and zero) the
+ * physical page. Large blocks are split to several threads that run on the NUMA node with
+ * the node as their preferred node, because the OS zeroes pages on the faulting thread.
+ * @pre the block is freshly mapped, thus all zeros. Never call this on heap memory.
+ */
+void prefault_memory(void* block, uint64_t size, int numa_node);
+
 }  // namespace memory
 }  // namespace foedus
 
@@ -48,6 +48,7 @@ class NumaCoreMemory CXX11_FINAL : public DefaultInitializable {
   struct SmallThreadLocalMemoryPieces {
     char* xct_pointer_access_memory_;
     char* xct_page_version_memory_;
+    char* xct_hot_lock_memory_;
     char* xct_read_access_memory_;
     char* xct_write_access_memory_;
     char* xct_lock_free_write_access_memory_;
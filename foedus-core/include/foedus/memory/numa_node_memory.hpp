@@ -78,15 +78,23 @@ class NumaNodeMemory CXX11_FINAL : public DefaultInitializable {
    * @param[out] out allocated memory is moved to object
    * @return Expect OUTOFMEMORY error.
    */
+  /** @param[in] prefault see AlignedMemory::alloc() */
   ErrorStack      allocate_numa_memory_general(
     uint64_t size,
     uint64_t alignment,
-    AlignedMemory *out) const;
-  ErrorStack      allocate_numa_memory(uint64_t size, AlignedMemory *out) const {
-    return allocate_numa_memory_general(size, 1 << 12, out);
+    AlignedMemory *out,
+    bool prefault = true) const;
+  ErrorStack      allocate_numa_memory(
+    uint64_t size,
+    AlignedMemory *out,
+    bool prefault = true) const {
+    return allocate_numa_memory_general(size, 1 << 12, out, prefault);
   }
-  ErrorStack      allocate_huge_numa_memory(uint64_t size, AlignedMemory *out) const {
-    return allocate_numa_memory_general(size, kHugepageSize, out);
+  ErrorStack      allocate_huge_numa_memory(
+    uint64_t size,
+    AlignedMemory *out,
+    bool prefault = true) const {
+    return allocate_numa_memory_general(size, kHugepageSize, out, prefault);
   }
 
   PagePoolOffsetChunk* get_volatile_offset_chunk_memory_piece(
@@ -24,6 +24,9 @@
  */
 namespace foedus {
 namespace restart {
+class   LogReplayer;
+struct  LogReplayerInput;
+struct  LogReplayerOutput;
 class   RestartManager;
 struct  RestartManagerControlBlock;
 class   RestartManagerPimpl;
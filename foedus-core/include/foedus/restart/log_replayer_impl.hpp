@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_RESTART_LOG_REPLAYER_IMPL_HPP_
+#define FOEDUS_RESTART_LOG_REPLAYER_IMPL_HPP_
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "foedus/epoch.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/fwd.hpp"
+#include "foedus/log/fwd.hpp"
+#include "foedus/log/log_id.hpp"
+#include "foedus/memory/aligned_memory.hpp"
+#include "foedus/proc/proc_id.hpp"
+#include "foedus/restart/fwd.hpp"
+#include "foedus/storage/storage_id.hpp"
+#include "foedus/thread/fwd.hpp"
+#include "foedus/xct/xct_id.hpp"
+
+namespace foedus {
+namespace restart {
+
+/** Name of the engine-internal procedure that runs LogReplayer. Registered in all SOCs. */
+const char kLogReplayProcName[] = "foedus.restart.log_replay";
+
+/** Input of the log-replay procedure. Passed from the master to each replay worker. */
+struct LogReplayerInput {
+  /** Ordinal of this worker among all replay workers, 0 to worker_count_ - 1. */
+  uint16_t            worker_ordinal_;
+  /** Total number of replay workers in all SOCs. */
+  uint16_t            worker_count_;
+  /** Logs in this epoch or before are already in the snapshot. Might be invalid. */
+  Epoch::EpochInteger snapshot_epoch_;
+  /** Logs until this epoch (inclusive) are replayed. */
+  Epoch::EpochInteger durable_epoch_;
+};
+
+/** Output of the log-replay procedure. Returned to the master for statistics. */
+struct LogReplayerOutput {
+  /** Number of record logs read from all log files, including other partitions' logs. */
+  uint64_t  read_logs_;
+  /** Number of record logs that belong to this worker's partition. */
+  uint64_t  partition_logs_;
+  /** Number of record logs applied to volatile pages. */
+  uint64_t  applied_logs_;
+};
+
+/**
+ * @brief Replays durable record logs onto volatile pages during restart.
+ * @ingroup RESTART
+ * @details
+ * This is used when RestartOptions::enable_log_replay_ is on, replacing the mandatory snapshot
+ * during start-up. Each replay worker runs as an impersonated thread in some SOC.
+ *
+ * @par Partitioning
+ * Logs of one logger might conflict with logs of another logger in the same epoch, and
+ * partial overwrites must be applied in the serialization order. Thus, we can't simply assign
+ * one worker to each logger. Instead, each worker reads logs of \e all loggers and picks up only
+ * the logs whose record (storage-ID and key) hashes to its own partition. The picked logs are
+ * sorted by XctId, which is the serialization order for logs of the same record, then applied.
+ * Workers thus never touch the same record and need no coordination with each other.
+ * The price is that each worker reads all log files, which is usually cheap compared to
+ * applying them (tree traversal, page installation, etc) and the sequential reads mostly
+ * hit the OS page cache.
+ *
+ * @par Memory
+ * Picked logs are copied to worker-local memory before sorting, so each worker needs
+ * roughly the volume of not-yet-snapshotted logs divided by the number of workers.
+ *
+ * @par Applying a log
+ * We locate (or physically create) the record via the storage's locate_record_for_replay(),
+ * lock it, and apply the log exactly like the pre-commit protocol. We can't compare the log's
+ * XctId with the record's current TID to skip logs because a volatile page created during
+ * restart stamps its records with the current epoch. Instead, we only pick up logs newer than
+ * the snapshot epoch and apply all of them in XctId order.
+ */
+class LogReplayer final {
+ public:
+  LogReplayer(Engine* engine, thread::Thread* context, const LogReplayerInput& input);
+  ~LogReplayer() {}
+
+  LogReplayer() = delete;
+  LogReplayer(const LogReplayer &other) = delete;
+  LogReplayer& operator=(const LogReplayer &other) = delete;
+
+  /** Reads logs of all loggers, picks up this worker's partition, and applies them. */
+  ErrorStack  replay(LogReplayerOutput* output);
+
+  std::string to_string() const;
+
+  /** The engine-internal procedure registered as kLogReplayProcName. */
+  static ErrorStack replay_proc(const proc::ProcArguments& args);
+
+ private:
+  /** A log copied to this worker, with the key to sort. */
+  struct StagedLog {
+    xct::XctId  xct_id_;
+    uint64_t    position_;
+  };
+
+  /** Reads all logs of one logger, staging logs of this partition. */
+  ErrorStack  stage_logger(log::LoggerId logger_id);
+  /**
+   * Stages logs in the read buffer, decompressing CompressedBlockLogType if any.
+   * @param[out] consumed read bytes, only complete logs are consumed.
+   */
+  ErrorCode   stage_buffer(const char* buffer, uint64_t buffer_size, uint64_t* consumed);
+  /** Stages the record log if it is in the epoch range and in this partition. */
+  void        stage_log(const log::LogHeader* header);
+  /** Which partition the record of the given log belongs to. */
+  uint16_t    get_partition(const log::RecordLogType* entry) const;
+  /** Applies one record log. */
+  ErrorCode   apply_log(const log::RecordLogType* entry);
+
+  Engine* const           engine_;
+  thread::Thread* const   context_;
+  const LogReplayerInput  input_;
+  const Epoch             snapshot_epoch_;
+  const Epoch             durable_epoch_;
+
+  LogReplayerOutput       stat_;
+
+  /** buffer to read from file. */
+  memory::AlignedMemory   io_buffer_;
+  /** Logs decompressed from a CompressedBlockLogType. */
+  std::vector<char>       decompress_buffer_;
+  /** Copies of logs in this partition. Grows as needed. */
+  std::vector<char>       staged_data_;
+  /** Points to staged_data_. Sorted before apply. */
+  std::vector<StagedLog>  staged_logs_;
+};
+
+}  // namespace restart
+}  // namespace foedus
+#endif  // FOEDUS_RESTART_LOG_REPLAYER_IMPL_HPP_
@@ -58,6 +58,11 @@ class RestartManagerPimpl final : public DefaultInitializable {
    * Essentially this is the only thing the restart manager has to do.
    */
   ErrorStack  redo_meta_logs(Epoch durable_epoch, Epoch snapshot_epoch);
+  /**
+   * Replays record logs since the latest snapshot onto volatile pages, launching LogReplayer
+   * in all SOCs. Used instead of the startup snapshot when RestartOptions::enable_log_replay_.
+   */
+  ErrorStack  replay_logs(Epoch durable_epoch, Epoch snapshot_epoch);
 
   Engine* const           engine_;
   RestartManagerControlBlock* control_block_;
@@ -17,6 +17,8 @@
  */
 #ifndef FOEDUS_RESTART_RESTART_OPTIONS_HPP_
 #define FOEDUS_RESTART_RESTART_OPTIONS_HPP_
+#include <stdint.h>
+
 #include "foedus/cxx11.hpp"
 #include "foedus/externalize/externalizable.hpp"
 namespace foedus {
@@ -27,12 +29,38 @@ namespace restart {
  * This is a POD struct. Default destructor/copy-constructor/assignment operator work fine.
  */
 struct RestartOptions CXX11_FINAL : public virtual externalize::Externalizable {
+  /** Constant values. */
+  enum Constants {
+    /** Default value for replay_threads_per_node_. 0 means all threads in the node. */
+    kDefaultReplayThreadsPerNode = 0,
+  };
+
   /**
    * Constructs option values with default values.
    */
   RestartOptions();
 
   EXTERNALIZABLE(RestartOptions);
+
+  /**
+   * @brief Whether to recover by replaying durable logs onto volatile pages.
+   * @details
+   * When false (default), restart takes a snapshot of the durable logs that are not yet
+   * snapshotted before accepting transactions, which might take long if there are lots of logs.
+   * When true, restart instead applies those logs directly to volatile pages in parallel and
+   * skips the mandatory startup snapshot. The logs are still there, so the next regular snapshot
+   * picks them up as usual.
+   */
+  bool        enable_log_replay_;
+
+  /**
+   * @brief Number of worker threads in each NUMA node to replay logs in parallel.
+   * @details
+   * Used only when enable_log_replay_ is true. Each replay worker reads all durable logs
+   * and applies the logs of its own key-partition, so that logs of one record are always applied
+   * by one worker in serialization order. 0 (default) means all threads in the node.
+   */
+  uint16_t    replay_threads_per_node_;
 };
 }  // namespace restart
 }  // namespace foedus
@@ -113,6 +113,14 @@ struct Savepoint CXX11_FINAL : public virtual externalize::Externalizable {
    */
   std::vector<uint64_t>               current_log_files_offset_durable_;
 
+  /**
+   * @brief The epoch up to which each ChangeStream consumer has acknowledged changes.
+   * @details
+   * Index is log::ChangeStreamId. Always kMaxChangeStreams entries, kEpochInvalid for
+   * consumers that have never acknowledged. Optional in the file for older savepoints.
+   */
+  std::vector<Epoch::EpochInteger>    change_stream_cursors_;
+
   EXTERNALIZABLE(Savepoint);
 
   /** Populate variables as an initial state. */
@@ -185,6 +193,9 @@ struct FixedSavepoint CXX11_FINAL {
   uint64_t                        meta_log_oldest_offset_;
   uint64_t                        meta_log_durable_offset_;
 
+  /** @copydoc Savepoint::change_stream_cursors_ */
+  Epoch::EpochInteger             change_stream_cursors_[log::kMaxChangeStreams];
+
   /**
    * Stores all loggers' information. We allocate memory enough for the largest number of loggers.
    * In reality, we are just reading/writing a small piece of it.
@@ -55,6 +55,9 @@ class SavepointManager CXX11_FINAL : public virtual Initializable {
   /** Returns the saved information of metadata logger in lateset savepoint */
   void get_meta_logger_offsets(uint64_t* oldest_offset, uint64_t* durable_offset) const;
 
+  /** Returns the cursor of the given ChangeStream consumer in latest savepoint. */
+  Epoch get_change_stream_cursor(log::ChangeStreamId id) const;
+
   Epoch get_initial_current_epoch() const;
   Epoch get_initial_durable_epoch() const;
   Epoch get_earliest_epoch() const;
@@ -102,6 +102,11 @@ class LogMapper final : public MapReduceBase {
      * Otherwise we need atomic operation at reducer's memory for every log entry to send!
      */
     kSendBufferSize = 1 << 20,
+    /**
+     * Size of the area at the end of io_buffer_ to decompress CompressedBlockLogType into.
+     * Decompressed logs are bucketized in the same way as logs read from the file.
+     */
+    kDecompressAreaSize = 1 << 21,
   };
 
   /**
@@ -138,44 +143,6 @@ class LogMapper final : public MapReduceBase {
     BucketHashList*     hashlist_next_;  // +8 => 32
   };
 
-  /**
-   * Used to sort log entries by partition.
-   * @todo we don't really have to sorting, and also the sort key here is just 1 byte.
-   * we should rather pre-alocate a sufficient memory for 256 buckets and just
-   * append to them, flushing when it gets full. by doing this, we can also batch-process
-   * multiple Bucket efficiently.
-   */
-  struct PartitionSortEntry {
-    inline void set(storage::PartitionId partition, BufferPosition position) ALWAYS_INLINE {
-      partition_ = partition;
-      position_ = position;
-    }
-
-    inline bool operator<(const PartitionSortEntry& other) const ALWAYS_INLINE {
-      return partition_ < other.partition_;
-    }
-    inline bool operator<=(const PartitionSortEntry& other) const ALWAYS_INLINE {
-      return partition_ <= other.partition_;
-    }
-    inline bool operator==(const PartitionSortEntry& other) const ALWAYS_INLINE {
-      return partition_ == other.partition_;
-    }
-    inline bool operator!=(const PartitionSortEntry& other) const ALWAYS_INLINE {
-      return partition_ != other.partition_;
-    }
-    inline bool operator>(const PartitionSortEntry& other) const ALWAYS_INLINE {
-      return partition_ > other.partition_;
-    }
-    inline bool operator>=(const PartitionSortEntry& other) const ALWAYS_INLINE {
-      return partition_ >= other.partition_;
-    }
-
-    uint16_t              filler1_;  // +2 => 2
-    uint8_t               filler2_;  // +1 => 3
-    storage::PartitionId  partition_;  // +1 => 4
-    BufferPosition        position_;  // +4 => 8
-  };
-
   struct IoBufStatus {
     uint64_t size_inbuf_aligned_;
     uint64_t size_infile_aligned_;
@@ -193,8 +160,16 @@ class LogMapper final : public MapReduceBase {
     uint64_t to_infile(uint64_t inbuf) const { return inbuf + buf_infile_aligned_; }
   };
 
-  /** buffer to read from file. */
+  /**
+   * Buffer to read from file. The first io_read_size_ bytes are for reading,
+   * followed by kDecompressAreaSize bytes for decompressed logs. Both are addressed by
+   * BufferPosition relative to the beginning of this buffer.
+   */
   memory::AlignedMemory   io_buffer_;
+  /** Bytes of io_buffer_ used for reading from file. */
+  uint64_t                io_read_size_;
+  /** Bytes used in the decompress area of io_buffer_. Cleared when buckets are flushed. */
+  uint64_t                decompressed_size_;
 
   /** memory for Bucket. */
   memory::AlignedMemory   buckets_memory_;
@@ -230,10 +205,10 @@ class LogMapper final : public MapReduceBase {
   memory::AlignedMemorySlice  tmp_position_array_slice_;
 
   /**
-   * Slice of tmp_memory_ used as sort array (PartitionSortEntry[]).
-   * Size is kBucketSize * 2 bytes.
+   * Slice of tmp_memory_ used as output of storage::Partitioner::group_by_partition()
+   * (BufferPosition[]). Size is kBucketSize bytes, same as tmp_position_array_slice_.
    */
-  memory::AlignedMemorySlice  tmp_sort_array_slice_;
+  memory::AlignedMemorySlice  tmp_grouped_array_slice_;
 
   /**
    * Slice of tmp_memory_ used as BucketHashList memory (BucketHashList[]).
@@ -286,6 +261,16 @@ class LogMapper final : public MapReduceBase {
    * When this returns false, it should be followed by add_new_bucket()
    */
   bool        bucket_log(storage::StorageId storage_id, uint64_t pos) ALWAYS_INLINE;
+  /** bucket_log(), followed by add_new_bucket() and flush_all_buckets() if needed. */
+  void        bucket_log_or_flush(storage::StorageId storage_id, uint64_t pos) ALWAYS_INLINE;
+
+  /**
+   * Decompresses the block to the decompress area of io_buffer_ and bucketizes the logs in it.
+   * This might flush buckets to make room in the decompress area.
+   */
+  ErrorStack  handle_compressed_block(
+    const fs::DirectIoFile &file,
+    const log::CompressedBlockLogType* block);
 
   /**
    * Add a new bucket for the specified storage.
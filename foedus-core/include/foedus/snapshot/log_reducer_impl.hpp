@@ -423,6 +423,12 @@ class LogReducer final : public MapReduceBase {
 
   fs::Path get_sorted_run_file_path(uint32_t sorted_run) const;
 
+  /**
+   * Allocates dump_io_buffer_. Called in initialize_once() and at the beginning of each
+   * snapshot because merge_sort() releases it.
+   */
+  void        alloc_dump_io_buffer();
+
   /**
    * Sorts and dumps another buffer (buffers_[sorted_runs_ % 2]).
    * @pre buffers_[sorted_runs_ % 2] is closed for new writers
@@ -70,6 +70,13 @@ namespace snapshot {
  * \li Another special condition: Obviously, this class does nothing when input_count is 1,
  * skipping all the overheads. This should hopefully happen often if reducers have large buffers.
  *
+ * @par Merging sorted runs
+ * Each input appends its logs to sort_entries_ in its own order, so a batch consists of
+ * inputs_count_ sorted runs. When the 16-byte SortEntry alone determines the order (array, and
+ * masstree whose keys are all 8 bytes), we merge the runs with a loser tree instead of sorting
+ * the batch from scratch. The loser tree has one leaf per input and its heads fit in L1, so it
+ * takes about log2(inputs_count_) branch-free comparisons per log. Other cases use std::sort.
+ *
  * @par Modularity
  * This class has no dependency to other modules. It receives buffers of logs, that's it.
  * We must keep this class in that way for easier testing and tuning.
@@ -445,6 +452,21 @@ class MergeSort CXX11_FINAL : public DefaultInitializable {
   storage::Page*                original_pages_;
   /** index is 0 to inputs_count_ - 1 */
   InputStatus*                  inputs_status_;
+  /** Output of batch_sort_merge_runs(). Same size as sort_entries_. */
+  SortEntry*                    merge_entries_;
+  /**
+   * Where each input's run begins in sort_entries_, set in batch_sort_prepare().
+   * Index is 0 to inputs_count_, the last one being current_count_.
+   */
+  MergedPosition*               run_begins_;
+  /** Next position to merge in each run. Index is 0 to inputs_count_ - 1 */
+  MergedPosition*               run_cursors_;
+  /** Current head of each run in the loser tree. Index is 0 to loser_tree_leaves_ - 1 */
+  __uint128_t*                  loser_heads_;
+  /** Loser of the match at each node. Node 1 is the root, node n's children are 2n, 2n+1. */
+  InputIndex*                   loser_tree_;
+  /** inputs_count_ rounded up to a power of 2 */
+  uint32_t                      loser_tree_leaves_;
 
   /** trivial case of next_batch(). */
   void next_batch_one_input();
@@ -491,6 +513,20 @@ class MergeSort CXX11_FINAL : public DefaultInitializable {
    * for key comparison. This is used only when the key length might not be 8 bytes.
    */
   void batch_sort_adjust_sort();
+  /**
+   * Subroutine of batch_sort to merge the sorted runs of all inputs with a loser tree.
+   * This is used only when the 16-byte SortEntry fully determines the order.
+   * @return false if some run turned out to be not sorted. Then the caller falls back to
+   * std::sort. This should not happen as long as the inputs are sorted.
+   */
+  bool batch_sort_merge_runs();
+  /** Whether batch_sort() can use batch_sort_merge_runs(). */
+  inline bool is_merge_runs_applicable() const ALWAYS_INLINE {
+    return type_ == storage::kArrayStorage
+      || (type_ == storage::kMasstreeStorage
+        && shortest_key_length_ == 8U
+        && longest_key_length_ == 8U);
+  }
 
   /**
    * Returns -1, 0, 1 when left is less than, same, larger than right in terms of key and xct_id.
@@ -521,14 +557,16 @@ inline bool is_hash_log_type(uint16_t log_type) {
     log_type == log::kLogCodeHashOverwrite
     || log_type == log::kLogCodeHashInsert
     || log_type == log::kLogCodeHashDelete
-    || log_type == log::kLogCodeHashUpdate;
+    || log_type == log::kLogCodeHashUpdate
+    || log_type == log::kLogCodeHashIncrement;
 }
 inline bool is_masstree_log_type(uint16_t log_type) {
   return
     log_type == log::kLogCodeMasstreeInsert
     || log_type == log::kLogCodeMasstreeDelete
     || log_type == log::kLogCodeMasstreeUpdate
-    || log_type == log::kLogCodeMasstreeOverwrite;
+    || log_type == log::kLogCodeMasstreeOverwrite
+    || log_type == log::kLogCodeMasstreeIncrement;
 }
 
 inline MergeSort::GroupifyResult MergeSort::groupify(uint32_t begin, uint32_t limit) const {
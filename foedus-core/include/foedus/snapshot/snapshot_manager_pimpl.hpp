@@ -127,9 +127,11 @@ struct SnapshotManagerControlBlock {
     snapshot_wakeup_.initialize();
     snapshot_children_wakeup_.initialize();
     gleaner_.initialize();
+    shape_mutex_.initialize();
     requested_snapshot_epoch_.store(Epoch::kEpochInvalid);
   }
   void uninitialize() {
+    shape_mutex_.uninitialize();
     gleaner_.uninitialize();
   }
 
@@ -190,6 +192,13 @@ struct SnapshotManagerControlBlock {
    */
   soc::SharedPolling              snapshot_children_wakeup_;
 
+  /**
+   * Held by snapshot_thread_ while it takes a snapshot or evicts volatile pages.
+   * Operations that change the shape of a storage, such as ArrayStorage::extend(), take this
+   * mutex so that they never run in the middle of these.
+   */
+  soc::SharedMutex                shape_mutex_;
+
   /** Gleaner-related variables */
   LogGleanerControlBlock          gleaner_;
 };
@@ -306,17 +315,48 @@ class SnapshotManagerPimpl final : public DefaultInitializable {
   ErrorStack  drop_volatile_pages(
     const Snapshot& new_snapshot,
     const std::map<storage::StorageId, storage::SnapshotPagePointer>& new_root_page_pointers);
-  /** subroutine invoked by one thread for one node. */
+  /**
+   * subroutine invoked by one thread for one node.
+   * evict_pressure is 0 when invoked after snapshot, positive when invoked by the evictor.
+   * @see storage::Composer::DropVolatilesArguments::evict_pressure_
+   */
   void        drop_volatile_pages_parallel(
     const Snapshot& new_snapshot,
     const std::map<storage::StorageId, storage::SnapshotPagePointer>& new_root_page_pointers,
     void* result_memory,
-    uint16_t parallel_id);
+    uint16_t parallel_id,
+    uint16_t evict_pressure);
 
   /**
-   * each snapshot has a snapshot-metadata file "snapshot_metadata_<SNAPSHOT_ID>.xml"
-   * in first node's first partition folder. */
+   * @brief Returns whether the volatile page pool of any node has less than the given percent
+   * of free pages.
+   */
+  bool        is_volatile_pool_short(uint16_t free_percent) const;
+  /**
+   * Sub-routine of handle_snapshot().
+   * Checks the volatile page pools against SnapshotOptions::volatile_page_evict_percent_, and
+   * evicts volatile pages if they are running out of free pages.
+   */
+  void        handle_volatile_page_eviction();
+  /**
+   * @brief Drops volatile pages whose content is the same as the latest snapshot.
+   * @details
+   * This is the volatile page evictor, which runs between snapshots.
+   * Unlike drop_volatile_pages(), this never drops root pages.
+   * This pauses transactions while it drops pages, just like drop_volatile_pages().
+   */
+  ErrorStack  evict_volatile_pages(const Snapshot& latest_snapshot, uint16_t evict_pressure);
+
+  /**
+   * each snapshot has a snapshot-metadata file "snapshot_metadata_<SNAPSHOT_ID>.bin"
+   * in first node's first partition folder. See SnapshotMetadata::save_to_binary_file().
+   */
   fs::Path    get_snapshot_metadata_file_path(SnapshotId snapshot_id) const;
+  /**
+   * "snapshot_metadata_<SNAPSHOT_ID>.xml" in the same folder, written only when
+   * SnapshotOptions::export_metadata_xml_ is true.
+   */
+  fs::Path    get_snapshot_metadata_xml_file_path(SnapshotId snapshot_id) const;
 
   Engine* const           engine_;
 
@@ -347,6 +387,19 @@ class SnapshotManagerPimpl final : public DefaultInitializable {
    */
   std::chrono::system_clock::time_point   previous_snapshot_time_;
 
+  /**
+   * When snapshot_thread_ evicted volatile pages last time.
+   * Read and written only by snapshot_thread_.
+   */
+  std::chrono::system_clock::time_point   previous_evict_time_;
+  /**
+   * How aggressively the volatile page evictor drops pages now.
+   * Incremented for each eviction pass as far as volatile pages are still short, and reset
+   * to 0 when they are not or when a new snapshot is taken.
+   * Read and written only by snapshot_thread_.
+   */
+  uint16_t                                evict_pressure_;
+
   /** Mappers in this node. Index is logger ordinal. Empty in master engine. */
   std::vector<LogMapper*>     local_mappers_;
   /** Reducer in this node. Null in master engine. */
@@ -22,6 +22,7 @@
 #include "foedus/cxx11.hpp"
 #include "foedus/epoch.hpp"
 #include "foedus/externalize/externalizable.hpp"
+#include "foedus/fs/fwd.hpp"
 #include "foedus/memory/aligned_memory.hpp"
 #include "foedus/snapshot/snapshot_id.hpp"
 #include "foedus/storage/fwd.hpp"
@@ -35,11 +36,22 @@ namespace snapshot {
  * @brief Represents the data in one snapshot metadata file.
  * @ingroup SNAPSHOT
  * @details
- * One snapshot metadata file is written for each snapshotting as an xml file.
+ * One snapshot metadata file is written for each snapshotting.
  * It contains metadata of all storages and a few other global things.
  *
  * We write it out as part of snapshotting.
  * We read it at restart.
+ *
+ * @par Binary format
+ * The primary format is a binary image of the storage control blocks, written by
+ * save_to_binary_file() and read by load_from_binary_file().
+ * The file begins with one 4kb header page (magic, format version, the fields of this object,
+ * and a checksum), followed by the control blocks exactly as they are laid out in shared memory.
+ * Every part is 4kb aligned, so the file can be read (or mmap-ed) as-is and its control blocks
+ * consumed without any parsing. Its cost is thus a sequential read/write even with tens of
+ * thousands of storages, while the xml format parses each storage one by one.
+ * The xml format (Externalizable) remains as an export/debugging format.
+ * See SnapshotOptions::export_metadata_xml_.
  */
 struct SnapshotMetadata CXX11_FINAL : public virtual externalize::Externalizable {
   void clear();
@@ -52,6 +64,23 @@ struct SnapshotMetadata CXX11_FINAL : public virtual externalize::Externalizable
   const char* get_tag_name() const CXX11_OVERRIDE { return "SnapshotMetadata"; }
   void assign(const foedus::externalize::Externalizable *other) CXX11_OVERRIDE;
 
+  /**
+   * @brief Writes out this object in the binary format.
+   * @details
+   * This object must have been populated by StorageManager::clone_all_storage_metadata()
+   * or load_from_binary_file(), so that the control blocks are 4kb aligned in
+   * storage_control_blocks_memory_. This method does not fsync.
+   */
+  ErrorStack save_to_binary_file(const fs::Path& path) const;
+  /**
+   * @brief Reads the binary format written by save_to_binary_file().
+   * @details
+   * Returns kErrorCodeSnapshotMetadataCorrupted if the magic number, the format version,
+   * the file size, or the checksum doesn't match.
+   * Runtime-only fields of control blocks (mutex, volatile pointers) are reset to zeros.
+   */
+  ErrorStack load_from_binary_file(const fs::Path& path);
+
   /** Equivalent to Snapshot::id_. */
   SnapshotId  id_;
 
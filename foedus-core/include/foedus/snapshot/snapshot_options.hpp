@@ -35,6 +35,7 @@ namespace snapshot {
 struct SnapshotOptions CXX11_FINAL : public virtual externalize::Externalizable {
   enum Constants {
     kDefaultSnapshotTriggerPagePoolPercent = 100,
+    kDefaultVolatilePageEvictPercent      = 0,
     kDefaultSnapshotIntervalMilliseconds  = 60000,
     kDefaultLogMapperBucketKb             = 1024,
     kDefaultLogMapperIoBufferMb           = 64,
@@ -73,6 +74,22 @@ struct SnapshotOptions CXX11_FINAL : public virtual externalize::Externalizable
    */
   uint16_t                            snapshot_trigger_page_pool_percent_;
 
+  /**
+   * @brief When the volatile page pool of any NUMA node runs under this percent (roughly
+   * calculated) of free pages, snapshot manager evicts volatile pages between snapshots.
+   * @details
+   * The evictor drops only volatile pages whose content is same as the latest snapshot,
+   * making the dual page pointer snapshot-only again, so it never loses data.
+   * As long as the pool stays under this watermark, each eviction pass drops one more level of
+   * pages that the per-storage keep-volatile thresholds would keep
+   * (eg ArrayMetadata::snapshot_drop_volatile_pages_threshold_), starting from leaf pages.
+   * Pages modified after the latest snapshot can be dropped only by snapshotting, so consider
+   * also setting snapshot_trigger_page_pool_percent_ to a larger value than this.
+   * Like dropping volatile pages after snapshot, each eviction pass briefly pauses transactions.
+   * Default is 0 (no eviction between snapshots).
+   */
+  uint16_t                            volatile_page_evict_percent_;
+
   /**
    * Interval in milliseconds to take snapshots.
    * Default is one minute.
@@ -143,6 +160,14 @@ struct SnapshotOptions CXX11_FINAL : public virtual externalize::Externalizable
    */
   uint32_t                            snapshot_writer_intermediate_pool_size_mb_;
 
+  /**
+   * Whether to additionally write out the snapshot metadata as an xml file.
+   * The binary snapshot metadata file is always written and is what we read at restart.
+   * The xml file is only for exporting/debugging, and writing it takes long with many storages.
+   * default is false.
+   */
+  bool                                export_metadata_xml_;
+
   /** Settings to emulate slower data device. */
   foedus::fs::DeviceEmulationOptions  emulation_;
 
@@ -412,6 +412,7 @@ struct ThreadMemoryAnchors {
     kTaskInputMemorySize = 1 << 19,
     kTaskOutputMemorySize = 1 << 19,
     kMcsLockMemorySize = 1 << 19,
+    kDispatchRingMemorySize = 1 << 18,
   };
   ThreadMemoryAnchors() { std::memset(this, 0, sizeof(*this)); }
   ~ThreadMemoryAnchors() {}
@@ -444,6 +445,12 @@ struct ThreadMemoryAnchors {
     * 512kb (==sizeof(McsBlock) * 64k) for each thread.
     */
   xct::McsBlock*  mcs_lock_memories_;
+
+  /**
+   * Queue of procedure invocations dispatched to this thread.
+   * Always 256kb.
+   */
+  thread::DispatchRing* dispatch_ring_memory_;
 };
 
 /**
@@ -77,7 +77,7 @@ class ArrayComposer final {
     const Composer::DropVolatilesArguments& args,
     DualPagePointer* pointer,
     ArrayPage* volatile_page);
-  bool is_to_keep_volatile(uint16_t level);
+  bool is_to_keep_volatile(const Composer::DropVolatilesArguments& args, uint16_t level);
   /** Used only from drop_root_volatile. Drop every volatile page. */
   void drop_all_recurse(
     const Composer::DropVolatilesArguments& args,
@@ -120,6 +120,8 @@ class ArrayComposeContext {
  private:
   ErrorStack initialize(ArrayOffset initial_offset);
   ErrorStack init_root_page();
+  /** reads the root page of the previous snapshot to set previous_size_/previous_levels_ */
+  ErrorStack read_previous_shape();
 
   /**
    * apply the range of logs in a tight loop.
@@ -146,9 +148,16 @@ class ArrayComposeContext {
 
   /**
    * creates empty snapshot pages that didn't receive any logs during the initial snapshot.
-   * We have to create snapshot pages even for such pages only for initial snapshot.
+   * We have to create snapshot pages even for such pages only for initial snapshot,
+   * or for the ranges added by ArrayStorage::extend() after the previous snapshot.
    */
   ErrorCode create_empty_pages(ArrayOffset from, ArrayOffset to);
+  /**
+   * Calls create_empty_pages() for the part of [from, to) the previous snapshot doesn't have.
+   * When it starts at the end of the previous snapshot, this also switches to the previously
+   * right-most pages so that they are written out with their new (extended) ranges.
+   */
+  ErrorCode fill_empty_pages(ArrayOffset from, ArrayOffset to);
   ErrorCode create_empty_pages_recurse(ArrayOffset from, ArrayOffset to, ArrayPage* page);
   ErrorCode create_empty_intermediate_page(ArrayPage* parent, uint16_t index, ArrayRange range);
   ErrorCode create_empty_leaf_page(ArrayPage* parent, uint16_t index, ArrayRange range);
@@ -184,6 +193,10 @@ class ArrayComposeContext {
     return ArrayRange(begin, begin + offset_intervals_[0], storage_.get_array_size());
   }
   bool is_initial_snapshot() const { return previous_root_page_pointer_ == 0; }
+  /** whether the previous snapshot has a page of the level that begins at the offset */
+  bool has_previous_page(uint8_t level, ArrayOffset begin) const {
+    return level < previous_levels_ && begin < previous_size_;
+  }
 
   uint16_t get_root_children() const;
 
@@ -209,6 +222,13 @@ class ArrayComposeContext {
    */
   uint64_t                        offset_intervals_[kMaxLevels];
 
+  /**
+   * Array size and levels as of the previous snapshot. Both 0 in initial snapshot.
+   * These differ from the current ones if ArrayStorage::extend() was called since then.
+   */
+  ArrayOffset                     previous_size_;
+  uint8_t                         previous_levels_;
+
   /**
   * cur_path_[0] points to leaf we are now modifying, cur_path_[1] points to its parent.
   * cur_path_[levels_-1] is always the root page, of course.
@@ -236,7 +256,8 @@ class ArrayComposeContext {
   ArrayPage*                intermediate_base_;
 
   /**
-   * we need partitioning information just for the initial filling.
+   * we need partitioning information just for the initial filling (or filling ranges added by
+   * ArrayStorage::extend()).
    * this is used only when there is a range of pages that received no logs so that we have to
    * create empty pages in this partition.
    */
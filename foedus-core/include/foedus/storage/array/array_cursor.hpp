@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_STORAGE_ARRAY_ARRAY_CURSOR_HPP_
+#define FOEDUS_STORAGE_ARRAY_ARRAY_CURSOR_HPP_
+
+#include <stdint.h>
+
+#include <iosfwd>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/compiler.hpp"
+#include "foedus/cxx11.hpp"
+#include "foedus/error_code.hpp"
+#include "foedus/storage/record.hpp"
+#include "foedus/storage/array/array_id.hpp"
+#include "foedus/storage/array/array_route.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/storage/array/fwd.hpp"
+#include "foedus/thread/fwd.hpp"
+#include "foedus/xct/fwd.hpp"
+
+namespace foedus {
+namespace storage {
+namespace array {
+
+/**
+ * @brief A callback to filter records in ArrayCursor::aggregate().
+ * @ingroup ARRAY
+ * @param[in] offset the array offset of the record.
+ * @param[in] payload the payload of the record. Directly points to the page memory.
+ * @param[in] user_data the opaque pointer given to ArrayCursor::aggregate().
+ * @return whether the record is aggregated.
+ * @details
+ * This is called for each record in the range, so it should be cheap and must not block.
+ */
+typedef bool (*ArrayRecordFilter)(ArrayOffset offset, const void* payload, void* user_data);
+
+/**
+ * @brief Result of ArrayCursor::aggregate().
+ * @ingroup ARRAY
+ * @details
+ * sum_ is calculated in T, so it wraps around on overflow just like increment_record().
+ * min_ and max_ are meaningful only when count_ > 0.
+ */
+template <typename T>
+struct ArrayAggregate {
+  /** Number of records that passed the filter. */
+  uint64_t  count_;
+  T         sum_;
+  T         min_;
+  T         max_;
+};
+
+/**
+ * @brief A cursor to scan a range of offsets in an array storage.
+ * @ingroup ARRAY
+ * @details
+ * @par Cursor Example
+ * @code{.cpp}
+ * ... (begin xct, etc)
+ * ArrayCursor cursor(storage, context);
+ * CHECK_ERROR_CODE(cursor.open(begin, end));
+ * while (cursor.is_valid_record()) {
+ *  ArrayOffset offset = cursor.get_cur_offset();
+ *  const MyData* payload = reinterpret_cast<const MyData*>(cursor.get_payload());
+ *  ...
+ *  CHECK_ERROR_CODE(cursor.next());
+ * }
+ * ... (commit xct, etc)
+ * @endcode
+ *
+ * @par Aggregation Example
+ * @code{.cpp}
+ * ArrayCursor cursor(storage, context);
+ * CHECK_ERROR_CODE(cursor.open(begin, end));
+ * ArrayAggregate<uint64_t> result;
+ * CHECK_ERROR_CODE(cursor.aggregate<uint64_t>(payload_offset, &result));
+ * @endcode
+ * aggregate() consumes the remaining records of the cursor in a tight loop over the page memory,
+ * without copying each record nor traversing from the root for each offset.
+ * An optional ArrayRecordFilter skips records that do not qualify.
+ *
+ * @par Order
+ * The cursor returns records in the order of offsets. Unlike other storages, every offset
+ * in the range has a record, so the cursor returns exactly end - begin records.
+ *
+ * @par Concurrency Control
+ * Like other read operations, the cursor reads volatile pages if exist, snapshot pages
+ * otherwise. In serializable isolation level, the cursor adds a read-set for each record in
+ * volatile pages it returns or aggregates. So, a serializable scan over a large volatile range
+ * might overflow the read set (XctOptions::max_read_set_size_). Analytic queries over large
+ * arrays should use snapshot isolation, where the scan involves no read-set at all.
+ * Array storage never inserts or deletes records, so the cursor needs no page-version sets.
+ *
+ * @par Prefetching
+ * When the cursor goes down from a level-1 page, it prefetches the following kPrefetchLeaves
+ * leaf pages. Volatile pages are prefetched to CPU cache, and pages only in snapshot are read
+ * to the snapshot cache in one batch (see thread::Thread::find_or_read_snapshot_pages_batch()).
+ * Snapshot pages the cursor newly reads are installed to the snapshot cache at a low priority.
+ * See thread::SnapshotCacheScanScope.
+ *
+ * @note
+ * This cursor is read-only so far. Use point operations of ArrayStorage to modify the records.
+ */
+class ArrayCursor CXX11_FINAL {
+ public:
+  enum Constants {
+    /** How many leaf pages we prefetch at a time, including the one we are going to read */
+    kPrefetchLeaves = 8,
+  };
+
+  ArrayCursor(ArrayStorage storage, thread::Thread* context);
+
+  thread::Thread*   get_context() { return context_; }
+  ArrayStorage&     get_storage() { return storage_; }
+
+  /**
+   * @brief Opens the cursor to scan offsets in the given range.
+   * @param[in] begin inclusive beginning of offsets to scan.
+   * @param[in] end exclusive end of offsets to scan. kMaxArrayOffset or any other value larger
+   * than the array size means until the last record.
+   * @details
+   * When this method returns kErrorCodeOk, the cursor points to the first record in the range
+   * or is_valid_record() is false.
+   */
+  ErrorCode   open(ArrayOffset begin = 0, ArrayOffset end = kMaxArrayOffset);
+
+  bool        is_valid_record() const ALWAYS_INLINE { return cur_page_ != CXX11_NULLPTR; }
+
+  /** @returns the offset of the current record */
+  ArrayOffset get_cur_offset() const ALWAYS_INLINE {
+    ASSERT_ND(is_valid_record());
+    return cur_offset_;
+  }
+  /** @returns the payload of the current record. Directly points to address in current page */
+  const char* get_payload() const ALWAYS_INLINE {
+    ASSERT_ND(is_valid_record());
+    return cur_record_->payload_;
+  }
+  uint16_t    get_payload_size() const ALWAYS_INLINE { return payload_size_; }
+
+  /**
+   * @brief Moves the cursor to next record.
+   * @details
+   * When the cursor already reached the end, it does nothing.
+   */
+  ErrorCode   next();
+
+  /**
+   * @brief Aggregates a primitive value in the remaining records, starting from the current one.
+   * @param[in] payload_offset the value is at this byte offset in each payload.
+   * @param[out] out the count, sum, min, and max of the value.
+   * @param[in] filter if given, only records for which this returns true are aggregated.
+   * @param[in] user_data passed to the filter as is.
+   * @pre payload_offset + sizeof(T) <= get_payload_size()
+   * @details
+   * When this method returns kErrorCodeOk, the cursor reached the end.
+   * T must be a primitive type, that is, an integer type, float, or double.
+   */
+  template <typename T>
+  ErrorCode   aggregate(
+    uint16_t payload_offset,
+    ArrayAggregate<T>* out,
+    ArrayRecordFilter filter = CXX11_NULLPTR,
+    void* user_data = CXX11_NULLPTR);
+
+  friend std::ostream& operator<<(std::ostream& o, const ArrayCursor& v);
+
+ private:
+  ArrayStorage          storage_;
+  thread::Thread* const context_;
+  xct::Xct* const       current_xct_;
+
+  /** Copy of the route finder of the storage. */
+  LookupRouteFinder     route_finder_;
+  uint16_t              payload_size_;
+  /** Whether we skip read-sets because of the isolation level. */
+  bool                  dirty_read_;
+
+  /** Inclusive beginning of offsets to scan. */
+  ArrayOffset           begin_;
+  /** Exclusive end of offsets to scan. Never larger than the array size. */
+  ArrayOffset           end_;
+
+  /** The offset we are currently reading. end_ if we reached the end */
+  ArrayOffset           cur_offset_;
+  /**
+   * Pages in the path to cur_offset_. path_[level] is the page of the level.
+   * Only path_[path_lowest_level_] to the root are valid.
+   */
+  ArrayPage*            path_[kMaxLevels];
+  uint8_t               path_lowest_level_;
+  uint8_t               levels_;
+
+  /** The leaf page we are currently reading. null if we reached the end. */
+  ArrayPage*            cur_page_;
+  /** Whether cur_page_ is a snapshot page. */
+  bool                  cur_page_snapshot_;
+  /** Index of the current record in cur_page_. */
+  uint16_t              cur_index_;
+  /** Exclusive end of indexes we read in cur_page_. */
+  uint16_t              cur_page_end_index_;
+  /** The current record. */
+  Record*               cur_record_;
+
+  /** The level-1 page we last prefetched leaf pages under. */
+  const ArrayPage*      prefetched_parent_;
+  /** Exclusive end of indexes in prefetched_parent_ we have prefetched. */
+  uint16_t              prefetched_end_index_;
+
+  /**
+   * Goes down to the leaf page that contains cur_offset_ and sets cur_page_.
+   * @pre cur_offset_ < end_
+   */
+  ErrorCode locate_page();
+  /** Moves on to the leaf page that follows cur_page_, or reaches the end. */
+  ErrorCode proceed_page();
+  /** Sets up cur_page_ and the indexes in it */
+  void      enter_page(ArrayPage* page);
+  /** Takes a read-set for the current record if needed. */
+  ErrorCode protect_record();
+  /** Prefetches the leaf pages under the level-1 page, starting from the given index */
+  ErrorCode prefetch_leaves(const ArrayPage* parent, uint16_t index);
+  /**
+   * Subroutine of aggregate() for the remaining records in cur_page_.
+   * cur_protected tells whether the current record already has its read-set.
+   */
+  template <typename T>
+  ErrorCode aggregate_page(
+    uint16_t payload_offset,
+    bool cur_protected,
+    ArrayAggregate<T>* out,
+    ArrayRecordFilter filter,
+    void* user_data);
+};
+
+}  // namespace array
+}  // namespace storage
+}  // namespace foedus
+#endif  // FOEDUS_STORAGE_ARRAY_ARRAY_CURSOR_HPP_
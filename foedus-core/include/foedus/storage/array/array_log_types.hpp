@@ -28,6 +28,7 @@
 #include "foedus/assorted/atomic_fences.hpp"
 #include "foedus/log/common_log_types.hpp"
 #include "foedus/log/log_type.hpp"
+#include "foedus/storage/increment.hpp"
 #include "foedus/storage/record.hpp"
 #include "foedus/storage/storage_id.hpp"
 #include "foedus/storage/array/array_id.hpp"
@@ -64,6 +65,25 @@ struct ArrayCreateLogType : public log::StorageLogType {
   friend std::ostream& operator<<(std::ostream& o, const ArrayCreateLogType& v);
 };
 
+/**
+ * @brief Log type of array-storage's extend operation.
+ * @ingroup ARRAY LOGTYPE
+ * @details
+ * This log corresponds to ArrayStorage::extend() operation.
+ * Like ArrayCreateLogType, this is a metadata operation.
+ * Applying it is idempotent because it only raises the array size.
+ *
+ * This log type is infrequently triggered, so no optimization. All methods defined in cpp.
+ */
+struct ArrayExtendLogType : public log::StorageLogType {
+  LOG_TYPE_NO_CONSTRUCT(ArrayExtendLogType)
+  ArrayOffset     new_array_size_;
+
+  void apply_storage(Engine* engine, StorageId storage_id);
+  void assert_valid();
+  friend std::ostream& operator<<(std::ostream& o, const ArrayExtendLogType& v);
+};
+
 /**
  * @brief A base class for ArrayOverwriteLogType/ArrayIncrementLogType.
  * @ingroup ARRAY LOGTYPE
@@ -143,35 +163,6 @@ struct ArrayOverwriteLogType : public ArrayCommonUpdateLogType {
   friend std::ostream& operator<<(std::ostream& o, const ArrayOverwriteLogType& v);
 };
 
-/** Used in ArrayIncrementLogType. */
-enum ValueType {
-  kUnknown = 0,
-  kI8 = 1,
-  kI16,
-  kI32,
-  kU8,
-  kU16,
-  kU32,
-  kFloat,
-  kBool,
-  // above are 32bits or less, below are 64 bits
-  kI64,
-  kU64,
-  kDouble,
-};
-template <typename T> ValueType to_value_type();
-template <> inline ValueType to_value_type<bool>() { return kBool; }
-template <> inline ValueType to_value_type<int8_t>() { return kI8; }
-template <> inline ValueType to_value_type<int16_t>() { return kI16; }
-template <> inline ValueType to_value_type<int32_t>() { return kI32; }
-template <> inline ValueType to_value_type<int64_t>() { return kI64; }
-template <> inline ValueType to_value_type<uint8_t>() { return kU8; }
-template <> inline ValueType to_value_type<uint16_t>() { return kU16; }
-template <> inline ValueType to_value_type<uint32_t>() { return kU32; }
-template <> inline ValueType to_value_type<uint64_t>() { return kU64; }
-template <> inline ValueType to_value_type<float>() { return kFloat; }
-template <> inline ValueType to_value_type<double>() { return kDouble ; }
-
 /**
  * @brief Log type of array-storage's increment operation.
  * @ingroup ARRAY LOGTYPE
@@ -366,11 +357,6 @@ inline void ArrayIncrementLogType::apply_record(
   }
 }
 
-template <typename T>
-inline void add_to(void* destination, const void* added) {
-  *(reinterpret_cast< T* >(destination)) += *(reinterpret_cast< const T* >(added));
-}
-
 inline void ArrayIncrementLogType::merge(const ArrayIncrementLogType& other) {
   ASSERT_ND(header_.storage_id_ == other.header_.storage_id_);
   ASSERT_ND(value_type_ == other.value_type_);
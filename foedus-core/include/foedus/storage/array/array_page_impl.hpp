@@ -87,6 +87,15 @@ class ArrayPage final {
     uint8_t level,
     const ArrayRange& array_range);
 
+  /**
+   * Raises the end of the range of a right-most page.
+   * Used only when the array is extended. See ArrayStorage::extend().
+   */
+  void                extend_array_range(ArrayOffset new_end) {
+    ASSERT_ND(new_end >= array_range_.end_);
+    array_range_.end_ = new_end;
+  }
+
   // Record accesses
   const Record*  get_leaf_record(uint16_t record, uint16_t payload_size) const ALWAYS_INLINE {
     ASSERT_ND(payload_size_ == payload_size);
@@ -134,7 +143,8 @@ class ArrayPage final {
    */
   ArrayRange          array_range_;   // +16 -> 64
 
-  // All variables up to here are immutable after the array storage is created.
+  // All variables up to here are immutable after the array storage is created,
+  // except array_range_.end_ of right-most pages, which grows when the array is extended.
 
   /** Dynamic records in this page. */
   Data                data_;
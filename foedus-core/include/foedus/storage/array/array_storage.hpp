@@ -101,6 +101,27 @@ class ArrayStorage CXX11_FINAL : public Storage<ArrayStorageControlBlock> {
   /** Returns the number of levels. */
   uint8_t     get_levels() const;
 
+  /**
+   * @brief Raises the number of records in this array storage.
+   * @param[in] new_array_size The new size of this array.
+   * @param[out] commit_epoch The epoch when the extension has happened.
+   * @pre new_array_size <= kMaxArrayOffset
+   * @post get_array_size() >= new_array_size
+   * @details
+   * New records are logically all-zero, just like a newly created array.
+   * If the current tree is too short to hold new_array_size records, this adds root levels
+   * on top of the current root. Lookups keep the same cost as they follow the same number of
+   * pages as an array of this size created from scratch.
+   *
+   * This is a metadata operation, which starts and ends its own meta-transaction.
+   * So it does NOT receive a Thread context, and you cannot invoke it as part of another
+   * transaction. It briefly pauses new transactions while it modifies the right-most pages,
+   * and it waits for an ongoing snapshot to complete.
+   * If new_array_size <= get_array_size(), this method does nothing (not an error).
+   */
+  ErrorStack  extend(ArrayOffset new_array_size, Epoch* commit_epoch);
+  void        apply_extend(const ArrayExtendLogType& the_log);
+
   /**
    * @brief Retrieves one record of the given offset in this array storage.
    * @param[in] context Thread context
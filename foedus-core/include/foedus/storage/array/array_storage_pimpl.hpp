@@ -27,6 +27,7 @@
 #include "foedus/cxx11.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/assorted/const_div.hpp"
+#include "foedus/log/fwd.hpp"
 #include "foedus/memory/fwd.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
 #include "foedus/storage/fwd.hpp"
@@ -40,6 +41,7 @@
 #include "foedus/storage/array/fwd.hpp"
 #include "foedus/thread/fwd.hpp"
 #include "foedus/thread/thread.hpp"
+#include "foedus/xct/fwd.hpp"
 
 namespace foedus {
 namespace storage {
@@ -103,6 +105,24 @@ class ArrayStoragePimpl final {
   ErrorStack  create(const Metadata& metadata);
   ErrorStack  load(const StorageControlBlock& snapshot_block);
   ErrorStack  load_empty();
+  ErrorStack  extend(ArrayOffset new_array_size, Epoch* commit_epoch);
+  void        apply_extend(const ArrayExtendLogType& the_log);
+
+  /**
+   * Sets levels_, route_finder_, and intervals_ in the control block for the given height.
+   */
+  void        set_levels(uint8_t levels);
+  /**
+   * @brief The volatile part of extend().
+   * @details
+   * Makes every right-most page that covers the current end of the array volatile,
+   * raises the end of their ranges, and puts new root pages on top of the current root if
+   * the new size needs more levels. Nothing is changed if this returns an error.
+   * The right-most pages lose their snapshot pointers because the snapshot pages still have
+   * the old ranges. The next snapshot rewrites them (see ArrayComposeContext).
+   * The caller must make sure no one is reading or writing this storage.
+   */
+  ErrorStack  extend_volatile_tree(ArrayOffset new_array_size);
 
   void        report_page_distribution();
 
@@ -146,6 +166,17 @@ class ArrayStoragePimpl final {
     ArrayOffset offset,
     Record** out) ALWAYS_INLINE;
 
+  /**
+   * Used only by log-replay restart. Locates the record the given overwrite/increment log
+   * applies to, installing volatile pages as needed.
+   * The caller is responsible for locking the record and applying the log.
+   */
+  ErrorCode   locate_record_for_replay(
+    thread::Thread* context,
+    const log::RecordLogType* log_entry,
+    xct::LockableXctId** owner_id,
+    char** payload_address);
+
   ErrorCode   get_record(
     thread::Thread* context,
     ArrayOffset offset,
@@ -161,6 +161,14 @@ class Composer CXX11_FINAL {
     memory::PagePoolOffsetChunk*  dropped_chunks_;
     /** [OUT] Number of volatile pages that were dropped */
     uint64_t*                     dropped_count_;
+    /**
+     * 0 when invoked right after taking the snapshot.
+     * Positive when invoked by the volatile page evictor between snapshots, in which case
+     * snapshot_ is the latest snapshot. The larger, the more levels of volatile pages
+     * we drop beyond what the storage's keep-volatile thresholds would keep.
+     * @see SnapshotOptions::volatile_page_evict_percent_
+     */
+    uint16_t                      evict_pressure_;
 
     /**
      * Returns (might cache) the given pointer to volatile pool.
@@ -213,6 +221,8 @@ class Composer CXX11_FINAL {
    * Also, this method is best-effort in many aspects. It might not drop some volatile pages
    * that were not logically modified. In long run, it will be done at next snapshot,
    * so it's okay to be opportunistic.
+   * The volatile page evictor also calls this method between snapshots with the latest
+   * snapshot, so this method must be safe to call again for the same snapshot.
    */
   DropResult drop_volatiles(const DropVolatilesArguments& args);
 
@@ -33,8 +33,10 @@ struct  HashCombo;
 class   HashComposer;
 struct  HashComposedBinsPage;
 struct  HashCreateLogType;
+class   HashCursor;
 class   HashDataPage;
 struct  HashDeleteLogType;
+struct  HashIncrementLogType;
 struct  HashInsertLogType;
 class   HashIntermediatePage;
 class   HashPartitioner;
@@ -36,6 +36,7 @@
 #include "foedus/storage/hash/hash_page_impl.hpp"
 #include "foedus/storage/hash/hash_storage.hpp"
 #include "foedus/storage/hash/hash_tmpbin.hpp"
+#include "foedus/thread/thread_id.hpp"
 #include "foedus/xct/xct_id.hpp"
 
 namespace foedus {
@@ -54,6 +55,18 @@ namespace hash {
  * @section HASH_COMPOSE_RESULTS HashRootInfoPage as the results
  * @copydetails foedus::storage::hash::HashRootInfoPage
  *
+ * @section HASH_COMPOSE_RESIZE Resizing
+ * When HashStorageControlBlock::resize_bin_bits_ is set (HashStorage::request_resize(), or
+ * the chain-length check at the end of construct_root()), the next snapshot composes the storage
+ * with the new bin_bits. Bin b in the old layout is split into bins b << d to ((b + 1) << d) - 1
+ * where d is the difference of bin_bits. As each new bin must be written out even if it
+ * received no logs, the compose() of the resizing snapshot reads all data pages of the
+ * previous snapshot, carrying over records to the new bins.
+ * The volatile pages stay in the old layout until drop_volatiles(), which runs while transactions
+ * are paused. It creates a new volatile root page, moves volatile records that are newer than
+ * the snapshot to volatile pages in the new layout, drops all old volatile pages,
+ * and then switches the storage to the new bin_bits.
+ *
  * @note
  * This is a private implementation-details of \ref HASH, thus file name ends with _impl.
  * Do not include this header from a client program. There is no case client program needs to
@@ -107,6 +120,17 @@ class HashComposer final {
     uint16_t numa_node,
     HashIntermediatePage* root_page);
 
+  /**
+   * Installs snapshot pointers to the new intermediate pages in volatile intermediate pages.
+   * compose() installs pointers to data pages, but drop_volatiles() might drop volatile
+   * intermediate pages, after which readers follow these pointers instead.
+   * Called in construct_root() unless the storage is resized in this snapshot.
+   */
+  ErrorStack install_snapshot_intermediate_pointers(
+    cache::SnapshotFileSet* fileset,
+    const HashIntermediatePage* snapshot_page,
+    HashIntermediatePage* volatile_page) const;
+
   void drop_volatiles_child(
     const Composer::DropVolatilesArguments& args,
     DualPagePointer* child_pointer,
@@ -127,11 +151,50 @@ class HashComposer final {
     const Composer::DropVolatilesArguments& args,
     DualPagePointer* pointer_to_head) const;
 
-  bool is_to_keep_volatile(uint16_t level);
+  bool is_to_keep_volatile(const Composer::DropVolatilesArguments& args, uint16_t level);
   /** Used only from drop_root_volatile. Drop every volatile page. */
   void drop_all_recurse(
     const Composer::DropVolatilesArguments& args,
     DualPagePointer* pointer);
+
+  /**
+   * Requests to double the bins if the bins composed in this snapshot have longer chains
+   * than HashMetadata::resize_chain_length_threshold_ on average. Called in construct_root().
+   */
+  void check_chain_length();
+
+  /**
+   * drop_volatiles() of the snapshot that resized the storage.
+   * @see HASH_COMPOSE_RESIZE
+   */
+  Composer::DropResult drop_volatiles_resized(const Composer::DropVolatilesArguments& args);
+  /** Rebuilds the volatile pages in the new layout and switches meta_.bin_bits_. */
+  ErrorStack rebuild_volatiles(const Composer::DropVolatilesArguments& args);
+  /**
+   * Goes down the old volatile pages to move newer records to new_root and to drop
+   * all old volatile pages under the page.
+   */
+  ErrorStack rebuild_volatiles_recurse(
+    const Composer::DropVolatilesArguments& args,
+    cache::SnapshotFileSet* fileset,
+    HashIntermediatePage* old_page,
+    HashIntermediatePage* new_root);
+  /** Copies all records in a volatile bin of the old layout to new volatile bins. */
+  ErrorStack split_volatile_bin(
+    cache::SnapshotFileSet* fileset,
+    const HashDataPage* old_head,
+    HashIntermediatePage* new_root);
+  /**
+   * Returns the tail volatile page of the bin in the new layout that has enough space for
+   * the given bytes, creating volatile intermediate/data pages if not exists.
+   */
+  ErrorStack locate_rebuilt_bin_tail(
+    cache::SnapshotFileSet* fileset,
+    HashIntermediatePage* new_root,
+    HashBin bin,
+    uint16_t required_space,
+    thread::ThreadGroupId node,
+    HashDataPage** tail);
 };
 
 /**
@@ -171,6 +234,16 @@ class HashComposeContext {
   HashIntermediatePage* resolve_intermediate(VolatilePagePointer pointer) const ALWAYS_INLINE;
 
   bool is_initial_snapshot() const { return previous_root_page_pointer_ == 0; }
+  /** @returns whether this snapshot composes bins in a larger bin_bits. @see HASH_COMPOSE_RESIZE */
+  bool is_resizing() const { return resize_shifts_ > 0; }
+
+  /**
+   * Used only while resizing. Composes the bins in [resize_next_bin_, until) that have
+   * records in the previous snapshot but received no logs.
+   * @pre cur_bin_ == kCurBinNotOpened
+   * @post resize_next_bin_ >= until
+   */
+  ErrorStack carry_over_bins(HashBin until);
 
   ///////////////////////////////////////////////////////////////
   //// cur_path_ related methods
@@ -185,6 +258,8 @@ class HashComposeContext {
    * @return page ID of a head-data page of the given bin in previous snapshot. 0 (null) if
    * the data page doesn't exist in previous snapshot.
    * @pre cur_path_valid_range_.contains(bin)
+   * @note cur_path_ is in the layout of the previous snapshot. When we are resizing, the
+   * caller must give the bin in that layout (bin >> resize_shifts_).
    */
   SnapshotPagePointer     get_cur_path_bin_head(HashBin bin) const;
 
@@ -227,7 +302,7 @@ class HashComposeContext {
   ErrorStack              init_intermediates();
   /** @returns the head of linked-list for each direct child in the root page. */
   HashComposedBinsPage*   get_intermediate_head(uint8_t root_index) const {
-    ASSERT_ND(root_index < storage_.get_root_children());
+    ASSERT_ND(root_index < root_children_);
     return intermediate_base_ + root_index;
   }
   /** @returns the tail of linked-list for each direct child in the root page. */
@@ -281,6 +356,7 @@ class HashComposeContext {
   HashRootInfoPage* const         root_info_page_;
 
   const bool                      partitionable_;
+  /** levels_, bin_bits_, etc are of this snapshot, which might be larger than current ones */
   const uint8_t                   levels_;
   const uint8_t                   bin_bits_;
   const uint8_t                   bin_shifts_;
@@ -288,6 +364,10 @@ class HashComposeContext {
   const uint16_t                  numa_node_;
   const HashBin                   total_bin_count_;
   const SnapshotPagePointer       previous_root_page_pointer_;
+  /** levels of the previous snapshot, thus of cur_path_ */
+  const uint8_t                   previous_levels_;
+  /** bin_bits_ minus bin_bits of the previous snapshot. 0 unless resizing. */
+  const uint8_t                   resize_shifts_;
 
   /** just because we use it frequently... */
   const memory::GlobalVolatilePageResolver& volatile_resolver_;
@@ -328,6 +408,16 @@ class HashComposeContext {
   HashBin                         cur_bin_;
   const HashBin                   kCurBinNotOpened = (1ULL << kHashMaxBinBits);
 
+  /**
+   * Used only while resizing. Bins before this value are already composed or known to be empty.
+   */
+  HashBin                         resize_next_bin_;
+
+  /** Number of bins we have composed. For the chain-length check in construct_root() */
+  uint64_t                        composed_bins_;
+  /** Number of data pages we have written out for composed_bins_ */
+  uint64_t                        composed_pages_;
+
   /**
    * Small hashtable of records being modified in cur_bin_.
    */
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_STORAGE_HASH_HASH_CURSOR_HPP_
+#define FOEDUS_STORAGE_HASH_HASH_CURSOR_HPP_
+
+#include <stdint.h>
+
+#include <iosfwd>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/compiler.hpp"
+#include "foedus/cxx11.hpp"
+#include "foedus/error_code.hpp"
+#include "foedus/fwd.hpp"
+#include "foedus/assorted/assorted_func.hpp"
+#include "foedus/storage/fwd.hpp"
+#include "foedus/storage/storage_id.hpp"
+#include "foedus/storage/hash/fwd.hpp"
+#include "foedus/storage/hash/hash_id.hpp"
+#include "foedus/storage/hash/hash_storage.hpp"
+#include "foedus/thread/fwd.hpp"
+#include "foedus/xct/fwd.hpp"
+#include "foedus/xct/xct_id.hpp"
+
+namespace foedus {
+namespace storage {
+namespace hash {
+/**
+ * @brief A cursor to scan all records in a hash storage, or in a range of hash bins.
+ * @ingroup HASH
+ * @details
+ * @par Cursor Example
+ * @code{.cpp}
+ * ... (begin xct, etc)
+ * HashCursor cursor(storage, context);
+ * CHECK_ERROR_CODE(cursor.open());
+ * while (cursor.is_valid_record()) {
+ *  const char* key = cursor.get_key();
+ *  const MyData* payload = reinterpret_cast<const MyData*>(cursor.get_payload());
+ *  ...
+ *  CHECK_ERROR_CODE(cursor.next());
+ * }
+ * ... (commit xct, etc)
+ * @endcode
+ *
+ * @par Order
+ * The cursor returns records in the order of hash bins, and in the physical order of
+ * records within each bin. In other words, the order is a total order of hash bins but not
+ * of keys nor of full hash values. It is deterministic as far as the storage is not modified.
+ *
+ * @par Partitioned Scan
+ * To scan a large hash storage with N threads, let each thread open its own cursor with
+ * open_partition(i, N). Each cursor then scans a disjoint, contiguous range of bins.
+ * See get_partition_range().
+ *
+ * @par Concurrency Control
+ * Like other read operations, the cursor reads volatile pages if exist, snapshot pages
+ * otherwise. In serializable isolation level, the cursor
+ * \li adds a read-set for each volatile record it returns or skips as logically deleted,
+ * \li adds a page-version set for the tail page of each volatile bin, which protects the
+ * scan from concurrent inserts to the bin,
+ * \li adds a pointer set for each null or snapshot pointer in volatile intermediate pages,
+ * which protects the scan from new bins and sub-trees.
+ * So, a serializable scan over a large volatile storage might overflow the page-version set
+ * (xct::kMaxPointerSets). Analytic queries over large tables should use snapshot isolation.
+ * In lower isolation levels, a concurrent record migration (expansion) might make the
+ * cursor return the same key twice. Serializable transactions abort in that case.
+ *
+ * @par Prefetching
+ * When the cursor moves on to a new bin, it prefetches the head pages of the following bins
+ * in the same level-0 intermediate page if they are volatile pages.
+ * When it moves on to a new data page, it prefetches the slots of the page.
+ * Data pages without records are skipped by just looking at their header.
+ *
+ * @note
+ * This cursor is read-only so far. Use point operations of HashStorage to modify the records.
+ */
+class HashCursor CXX11_FINAL {
+ public:
+  enum Constants {
+    /** How many following bins we prefetch in the level-0 intermediate page */
+    kPrefetchBins = 4,
+  };
+
+  HashCursor(HashStorage storage, thread::Thread* context);
+
+  thread::Thread*   get_context() { return context_; }
+  HashStorage&      get_storage() { return storage_; }
+
+  /**
+   * @brief Opens the cursor to scan hash bins in the given range.
+   * @param[in] begin_bin inclusive beginning of bins to scan.
+   * @param[in] end_bin exclusive end of bins to scan. kHashMaxBins[kHashMaxLevels] or any other
+   * value larger than the number of bins in this storage means until the last bin.
+   * @details
+   * When this method returns kErrorCodeOk, the cursor points to the first record in the range
+   * or is_valid_record() is false.
+   */
+  ErrorCode   open(HashBin begin_bin = 0, HashBin end_bin = kHashMaxBins[kHashMaxLevels]);
+
+  /**
+   * @brief Opens the cursor to scan one of partition_count disjoint ranges of bins.
+   * @param[in] partition the range to scan, 0 to partition_count - 1.
+   * @param[in] partition_count number of partitions, usually number of scanning threads.
+   * @see get_partition_range()
+   */
+  ErrorCode   open_partition(uint32_t partition, uint32_t partition_count);
+
+  /**
+   * @returns the range of bins open_partition(partition, partition_count) scans.
+   * @details
+   * Bins are evenly divided by contiguous ranges. If partition_count is larger than
+   * bin_count, some partitions receive an empty range.
+   */
+  static HashBinRange get_partition_range(
+    HashBin bin_count,
+    uint32_t partition,
+    uint32_t partition_count);
+
+  bool        is_valid_record() const ALWAYS_INLINE { return cur_record_ != CXX11_NULLPTR; }
+
+  /** @returns the bin of the current record */
+  HashBin     get_cur_bin() const ALWAYS_INLINE {
+    ASSERT_ND(is_valid_record());
+    return cur_bin_;
+  }
+  /** @returns the full hash value of the current record */
+  HashValue   get_hash() const ALWAYS_INLINE {
+    ASSERT_ND(is_valid_record());
+    return cur_hash_;
+  }
+  /** @returns the key of the current record. Directly points to address in the current page */
+  const char* get_key() const ALWAYS_INLINE {
+    ASSERT_ND(is_valid_record());
+    return cur_record_;
+  }
+  uint16_t    get_key_length() const ALWAYS_INLINE {
+    ASSERT_ND(is_valid_record());
+    return cur_key_length_;
+  }
+  /** @returns the payload of the current record. Directly points to address in current page */
+  const char* get_payload() const ALWAYS_INLINE {
+    ASSERT_ND(is_valid_record());
+    return cur_record_ + assorted::align8(cur_key_length_);
+  }
+  uint16_t    get_payload_length() const ALWAYS_INLINE {
+    ASSERT_ND(is_valid_record());
+    return cur_payload_length_;
+  }
+
+  /**
+   * @brief Moves the cursor to next record.
+   * @details
+   * When the cursor already reached the end, it does nothing.
+   */
+  ErrorCode   next();
+
+  friend std::ostream& operator<<(std::ostream& o, const HashCursor& v);
+
+ private:
+  HashStorage           storage_;
+  thread::Thread* const context_;
+  xct::Xct* const       current_xct_;
+
+  /** Inclusive beginning of bins to scan. */
+  HashBin               begin_bin_;
+  /** Exclusive end of bins to scan. Never larger than the number of bins. */
+  HashBin               end_bin_;
+
+  /** The bin we are currently reading. end_bin_ or larger if we reached the end */
+  HashBin               cur_bin_;
+  /**
+   * Intermediate pages in the path to cur_bin_. path_[level] is the page of the level.
+   * Only path_[path_lowest_level_] to the root are valid.
+   */
+  HashIntermediatePage* path_[kHashMaxLevels];
+  uint8_t               path_lowest_level_;
+  uint8_t               levels_;
+
+  /** The data page we are currently reading. null if we haven't located cur_bin_ yet. */
+  HashDataPage*         cur_page_;
+  /** Whether cur_page_ is a snapshot page. */
+  bool                  cur_page_snapshot_;
+  /** Index of the next slot to check in cur_page_ */
+  uint16_t              cur_slot_;
+  /** Record count of cur_page_ as of reading its slots */
+  uint16_t              cur_page_record_count_;
+
+  /** Current record. These are valid only when cur_record_ is non-null. */
+  const char*           cur_record_;
+  HashValue             cur_hash_;
+  uint16_t              cur_key_length_;
+  uint16_t              cur_payload_length_;
+
+  /**
+   * Moves on to the next bin that has a data page, starting from cur_bin_.
+   * Sets cur_page_, or makes cur_bin_ >= end_bin_ when there is no more bin.
+   */
+  ErrorCode locate_bin();
+  /**
+   * Moves on to the next valid record, starting from cur_slot_ in cur_page_.
+   * Sets cur_record_, or makes cur_bin_ >= end_bin_ when there is no more record.
+   */
+  ErrorCode locate_record();
+  /** Subroutine of locate_record() to move on to the next page in the bin or the next bin */
+  ErrorCode proceed_page();
+  /** Sets up cur_page_ and prefetches its slots */
+  void      enter_page(HashDataPage* page);
+  /** Prefetches head pages of the bins that follow the given index in the level-0 page */
+  void      prefetch_following_bins(const HashIntermediatePage* page, uint16_t index) const;
+};
+
+}  // namespace hash
+}  // namespace storage
+}  // namespace foedus
+#endif  // FOEDUS_STORAGE_HASH_HASH_CURSOR_HPP_
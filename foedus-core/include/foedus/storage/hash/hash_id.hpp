@@ -103,11 +103,26 @@ inline uint8_t bins_to_level(uint64_t bins) {
  */
 const uint8_t kHashMaxLevels = 8;
 
+/**
+ * @brief Number of 8-bit hash tags in a data page, which is also the max number of records
+ * in a data page.
+ * @ingroup HASH
+ * @details
+ * A record with a non-empty key consumes at least 40 bytes (32 bytes slot and 8 bytes key),
+ * so such records never fill up more than this number of tags.
+ * HashDataPage::available_space() also reports 0 once a page has this number of records.
+ * A multiple of 32 for match_tags().
+ */
+const uint16_t kHashDataPageTagCount = 96;
+
 /**
  * @brief Byte size of header in data page of hash storage.
  * @ingroup HASH
+ * @details
+ * 128 bytes of page header, bin, next-page pointer, and bloom filter,
+ * followed by kHashDataPageTagCount bytes of hash tags.
  */
-const uint16_t kHashDataPageHeaderSize  = 128;
+const uint16_t kHashDataPageHeaderSize  = 128 + kHashDataPageTagCount;
 
 /**
  * @brief Body data byte size in data page of hash storage.
@@ -27,6 +27,7 @@
 #include "foedus/assorted/assorted_func.hpp"
 #include "foedus/log/common_log_types.hpp"
 #include "foedus/log/log_type.hpp"
+#include "foedus/storage/increment.hpp"
 #include "foedus/storage/record.hpp"
 #include "foedus/storage/storage_id.hpp"
 #include "foedus/storage/hash/fwd.hpp"
@@ -64,22 +65,29 @@ struct HashCreateLogType : public log::StorageLogType {
 };
 
 /**
- * @brief A base class for HashInsertLogType/HashDeleteLogType/HashOverwriteLogType.
+ * @brief A base class for HashInsertLogType/HashDeleteLogType/HashOverwriteLogType
+ * and HashIncrementLogType.
  * @ingroup HASH LOGTYPE
  * @details
  * This defines a common layout for the log types so that composer/partitioner can easier
  * handle these log types. This means we waste a bit (eg delete log type doesn't need payload
  * offset/count), but we anyway have extra space if we want to have data_ 8-byte aligned.
- * data_ always starts with the key, followed by payload for insert/overwrite.
+ * data_ always starts with the key, followed by payload for insert/overwrite
+ * (addendum for increment).
  */
 struct HashCommonLogType : public log::RecordLogType {
   LOG_TYPE_NO_CONSTRUCT(HashCommonLogType)
   uint16_t        key_length_;        // +2 => 18
   uint16_t        payload_offset_;    // +2 => 20
   uint16_t        payload_count_;     // +2 => 22
-  /** this is not strictly needed here, but helps a bit. */
+  /**
+   * this is not strictly needed here, but helps a bit.
+   * This is the bin_bits of the storage when the log was written. The storage might have
+   * resized since then, so snapshot code should use get_sort_bin() instead.
+   */
   uint8_t         bin_bits_;          // +1 => 23
-  uint8_t         reserved_;          // +1 => 24
+  /** ValueType of the addendum. Used only in HashIncrementLogType, 0 otherwise */
+  uint8_t         value_type_;        // +1 => 24
   /**
    * Hash value of the key. We can always re-calculate this from the key, but it can be
    * quite expensive. Instead, we pay extra 8 bytes to save CPU cost.
@@ -96,6 +104,12 @@ struct HashCommonLogType : public log::RecordLogType {
     return 32U + assorted::align8(key_length) + assorted::align8(payload_count);
   }
 
+  /**
+   * Returns the bin of this log as if the storage had kHashMaxBinBits.
+   * The bin in any smaller bin_bits is a prefix of this, so sorting logs by this value
+   * sorts them by bins no matter which bin_bits they were written with (see HashStorage resize).
+   */
+  HashBin         get_sort_bin() const { return hash_ >> (64U - kHashMaxBinBits); }
   char*           get_key() { return aligned_data_; }
   const char*     get_key() const { return aligned_data_; }
   uint16_t        get_key_length_aligned() const { return assorted::align8(key_length_); }
@@ -118,7 +132,7 @@ struct HashCommonLogType : public log::RecordLogType {
     payload_offset_ = payload_offset;
     payload_count_ = payload_count;
     bin_bits_ = bin_bits;
-    reserved_ = 0;
+    value_type_ = kUnknown;
     ASSERT_ND(hash == hashinate(key, key_length));
     hash_ = hash;
 
@@ -163,7 +177,8 @@ struct HashCommonLogType : public log::RecordLogType {
     ASSERT_ND(header_.log_type_code_ == log::kLogCodeHashOverwrite
       || header_.log_type_code_ == log::kLogCodeHashInsert
       || header_.log_type_code_ == log::kLogCodeHashDelete
-      || header_.log_type_code_ == log::kLogCodeHashUpdate);
+      || header_.log_type_code_ == log::kLogCodeHashUpdate
+      || header_.log_type_code_ == log::kLogCodeHashIncrement);
     ASSERT_ND(hash_ == hashinate(get_key(), key_length_));
   }
 
@@ -179,14 +194,14 @@ struct HashCommonLogType : public log::RecordLogType {
     const HashCommonLogType* left,
     const HashCommonLogType* right) ALWAYS_INLINE {
     ASSERT_ND(left->header_.storage_id_ == right->header_.storage_id_);
-    ASSERT_ND(left->bin_bits_ == right->bin_bits_);
     ASSERT_ND(left->hash_ == hashinate(left->get_key(), left->key_length_));
     ASSERT_ND(right->hash_ == hashinate(right->get_key(), right->key_length_));
     if (left == right) {
       return 0;
     }
-    HashBin   left_bin = left->hash_ >> (64U - left->bin_bits_);
-    HashBin   right_bin = right->hash_ >> (64U - right->bin_bits_);
+    // bin_bits_ might differ if the storage was resized in between. compare in the finest bins.
+    HashBin   left_bin = left->get_sort_bin();
+    HashBin   right_bin = right->get_sort_bin();
     if (left_bin != right_bin) {
       if (left_bin < right_bin) {
         return -1;
@@ -431,6 +446,87 @@ struct HashOverwriteLogType : public HashCommonLogType {
   friend std::ostream& operator<<(std::ostream& o, const HashOverwriteLogType& v);
 };
 
+/**
+ * @brief Log type of hash-storage's blind increment operation.
+ * @ingroup HASH LOGTYPE
+ * @details
+ * Counterpart of ArrayIncrementLogType in hash, used by increment_record_oneshot().
+ * The payload part holds the addendum (payload_count_ is its size) and value_type_ tells its
+ * primitive type. This log doesn't rely on the current value, so the transaction takes only
+ * a write set and concurrent increments on the same record never abort each other.
+ */
+struct HashIncrementLogType : public HashCommonLogType {
+  LOG_TYPE_NO_CONSTRUCT(HashIncrementLogType)
+
+  template <typename PAYLOAD>
+  void            populate(
+    StorageId   storage_id,
+    const void* key,
+    uint16_t    key_length,
+    uint8_t     bin_bits,
+    HashValue   hash,
+    PAYLOAD     addendum,
+    uint16_t    payload_offset) {
+    log::LogCode type = log::kLogCodeHashIncrement;
+    populate_base(
+      type,
+      storage_id,
+      key,
+      key_length,
+      bin_bits,
+      hash,
+      &addendum,
+      payload_offset,
+      sizeof(PAYLOAD));
+    value_type_ = to_value_type<PAYLOAD>();
+  }
+
+  ValueType get_value_type() const ALWAYS_INLINE {
+    return static_cast<ValueType>(value_type_);
+  }
+
+  /**
+   * @returns whether the record still has the payload range this log increments.
+   * A blind increment has no read-set on the record, so the commit protocol calls this under
+   * the record lock in case the record was deleted and re-inserted with a shorter payload.
+   */
+  bool            fits_record(const xct::LockableXctId* owner_id) const ALWAYS_INLINE {
+    // In the HashDataPage slot, lengthes come right after TID. [3] is payload_length_.
+    const uint16_t* lengthes = reinterpret_cast<const uint16_t*>(owner_id + 1);
+    return payload_offset_ + payload_count_ <= lengthes[3];
+  }
+
+  void            apply_record(
+    thread::Thread* /*context*/,
+    StorageId /*storage_id*/,
+    xct::LockableXctId* owner_id,
+    char* data) ALWAYS_INLINE {
+    ASSERT_ND(!owner_id->xct_id_.is_deleted());
+    ASSERT_ND(!owner_id->xct_id_.is_next_layer());
+    ASSERT_ND(!owner_id->xct_id_.is_moved());
+
+    uint16_t key_length_aligned = get_key_length_aligned();
+    assert_record_and_log_keys(owner_id, data);
+
+#ifndef NDEBUG
+    uint16_t* lengthes = reinterpret_cast<uint16_t*>(owner_id + 1);
+    ASSERT_ND(payload_offset_ + payload_count_ <= lengthes[3]);  // aren't we over-running?
+#endif  // NDEBUG
+
+    add_value(get_value_type(), data + key_length_aligned + payload_offset_, get_payload());
+  }
+
+  void            assert_valid() ALWAYS_INLINE {
+    assert_valid_generic();
+    assert_type();
+    ASSERT_ND(header_.log_length_ == calculate_log_length(key_length_, payload_count_));
+    ASSERT_ND(header_.get_type() == log::kLogCodeHashIncrement);
+    ASSERT_ND(payload_count_ == get_value_size(get_value_type()));
+  }
+
+  friend std::ostream& operator<<(std::ostream& o, const HashIncrementLogType& v);
+};
+
 }  // namespace hash
 }  // namespace storage
 }  // namespace foedus
@@ -39,13 +39,25 @@ namespace hash {
  */
 struct HashMetadata CXX11_FINAL : public Metadata {
   HashMetadata()
-    : Metadata(0, kHashStorage, ""), bin_bits_(kHashMinBinBits), pad1_(0), pad2_(0), pad3_(0) {}
+    : Metadata(0, kHashStorage, ""),
+      bin_bits_(kHashMinBinBits),
+      pad1_(0),
+      resize_chain_length_threshold_(0),
+      pad3_(0) {}
   HashMetadata(StorageId id, const StorageName& name, uint8_t bin_bits)
-    : Metadata(id, kHashStorage, name), bin_bits_(bin_bits), pad1_(0), pad2_(0), pad3_(0) {
+    : Metadata(id, kHashStorage, name),
+      bin_bits_(bin_bits),
+      pad1_(0),
+      resize_chain_length_threshold_(0),
+      pad3_(0) {
   }
   /** This one is for newly creating a storage. */
   HashMetadata(const StorageName& name, uint8_t bin_bits = kHashMinBinBits)
-    : Metadata(0, kHashStorage, name), bin_bits_(bin_bits), pad1_(0), pad2_(0), pad3_(0) {
+    : Metadata(0, kHashStorage, name),
+      bin_bits_(bin_bits),
+      pad1_(0),
+      resize_chain_length_threshold_(0),
+      pad3_(0) {
   }
 
   /**
@@ -70,13 +82,26 @@ struct HashMetadata CXX11_FINAL : public Metadata {
   /**
    * Number of bins in exponent of two.
    * Recommended to use set_capacity() to set this value.
+   * This is not immutable. The storage doubles its bins when it outgrows them.
    * @invariant kHashMinBinBits <= bin_bits_ <= kHashMaxBinBits
+   * @see resize_chain_length_threshold_
+   * @see HashStorage::request_resize()
    */
   uint8_t   bin_bits_;
 
   // just for valgrind when this metadata is written to file. ggr
   uint8_t   pad1_;
-  uint16_t  pad2_;
+
+  /**
+   * When the bins a snapshot composed for this storage have more data pages than this value
+   * on average, the storage doubles its bins in the following snapshot.
+   * In percent of one page. For example, 150 means we double the bins when a bin has
+   * 1.5 data pages (one head page and 0.5 next-pages) on average.
+   * Default is 0, meaning the storage never resizes itself.
+   * Regardless of this value, you can explicitly resize via HashStorage::request_resize().
+   */
+  uint16_t  resize_chain_length_threshold_;
+
   uint32_t  pad3_;
 };
 
@@ -32,6 +32,7 @@
 #include "foedus/storage/hash/hash_combo.hpp"
 #include "foedus/storage/hash/hash_hashinate.hpp"
 #include "foedus/storage/hash/hash_id.hpp"
+#include "foedus/storage/hash/hash_tag_search.hpp"
 #include "foedus/xct/xct_id.hpp"
 
 namespace foedus {
@@ -229,6 +230,10 @@ class HashDataPage final {
   inline DataPageBloomFilter& bloom_filter() ALWAYS_INLINE { return bloom_filter_; }
 
   inline uint16_t           get_record_count() const ALWAYS_INLINE { return header_.key_count_; }
+  inline uint8_t            get_tag(DataPageSlotIndex record) const ALWAYS_INLINE {
+    ASSERT_ND(record < kHashDataPageTagCount);
+    return tags_[record];
+  }
 
   inline const Slot&        get_slot(DataPageSlotIndex record) const ALWAYS_INLINE {
     return reinterpret_cast<const Slot*>(this + 1)[-record - 1];
@@ -260,6 +265,11 @@ class HashDataPage final {
 
   /** Returns usable space in bytes. */
   inline uint16_t     available_space() const {
+    // tags_ has a fixed number of entries. Tiny records (eg zero-length keys in release build)
+    // would otherwise let more records than that into a page.
+    if (get_record_count() >= kHashDataPageTagCount) {
+      return 0;
+    }
     uint16_t consumed = next_offset() + get_record_count() * sizeof(Slot);
     ASSERT_ND(consumed <= sizeof(data_));
     if (consumed > sizeof(data_)) {  // just to be conservative on release build
@@ -336,6 +346,19 @@ class HashDataPage final {
     const void* payload,
     uint16_t payload_length) ALWAYS_INLINE;
 
+  /**
+   * @brief Appends a copy of a record in another page to this page, used when the storage
+   * doubles its bins (HashComposer::drop_volatiles()).
+   * @param[in] from the page that contains the record, which is in the bin this bin is split from
+   * @param[in] index slot index of the record in the page
+   * @pre nobody is accessing this page nor the source page (we are in a pause_accepting_xct)
+   * @pre available_space() >= from.get_slot(index).physical_record_length_ + sizeof(Slot)
+   * @details
+   * Unlike create_record_in_snapshot(), this copies the record as-is, including the deleted
+   * flag and the spare space after the payload.
+   */
+  void copy_record_from(const HashDataPage& from, DataPageSlotIndex index);
+
   /**
    * @brief Search for a physical slot that exactly contains the given key.
    * @param[in] hash hash value of the key.
@@ -427,6 +450,13 @@ class HashDataPage final {
    */
   DataPageBloomFilter bloom_filter_;  // +64 -> 128
 
+  /**
+   * extract_hash_tag() of each record's hash value. tags_[i] corresponds to get_slot(i).
+   * search_key() compares these first, vectorized, so that it touches only the matched slots.
+   * Like slots, a tag is written before the key count is incremented.
+   */
+  uint8_t         tags_[kHashDataPageTagCount];  // +96 -> 224
+
   /**
    * Dynamic data part in this page, which consist of 1) key/payload part growing forward,
    * 2) unused part, and 3) Slot part growing backward.
@@ -474,6 +504,8 @@ inline void HashDataPage::create_record_in_snapshot(
   uint16_t aligned_key_length = assorted::align8(key_length);
   slot.physical_record_length_ = aligned_key_length + assorted::align8(payload_length);
   slot.payload_length_ = payload_length;
+  ASSERT_ND(index < kHashDataPageTagCount);
+  tags_[index] = extract_hash_tag(hash);
 
   ASSERT_ND(reinterpret_cast<uintptr_t>(record_from_offset(slot.offset_)) % 8 == 0);
   char* record = reinterpret_cast<char*>(ASSUME_ALIGNED(record_from_offset(slot.offset_), 8U));
@@ -503,6 +535,10 @@ static_assert(
   sizeof(HashIntermediatePage) == kPageSize,
   "sizeof(HashIntermediatePage) is not kPageSize");
 
+static_assert(
+  kHashDataPageDataSize / (sizeof(HashDataPage::Slot) + 8U) <= kHashDataPageTagCount,
+  "kHashDataPageTagCount is too small for the max number of records in a page.");
+
 static_assert(
   sizeof(HashDataPage) == kPageSize,
   "sizeof(HashDataPage) is not kPageSize");
@@ -58,6 +58,7 @@ namespace hash {
  *  \li Large footprints, which might prohibit large hash-tables and cause lots of L1 misses
  * while partitioning.
  *  \li Users must make sure the initial inserts are well balanced between nodes.
+ *  \li The snapshot that resizes the storage (HashStorage::request_resize()) is not partitioned.
  *
  * @note
  * This is a private implementation-details of \ref HASH, thus file name ends with _impl.
@@ -71,6 +71,22 @@ class HashStorage CXX11_FINAL : public Storage<HashStorageControlBlock> {
   ErrorStack          drop();
   friend std::ostream& operator<<(std::ostream& o, const HashStorage& v);
 
+  /**
+   * @brief Requests to grow the number of hash bins to 2^new_bin_bits.
+   * @param[in] new_bin_bits must be larger than the current get_bin_bits()
+   * @details
+   * This method just records the request and returns immediately. The next snapshot composes
+   * the storage in the new layout, and then the storage switches to new_bin_bits at the end of
+   * the snapshot while transactions are paused for dropping volatile pages.
+   * Until then, get_bin_bits() returns the current value.
+   * If the storage receives no logs until the next snapshot, the request waits for the
+   * snapshot after that.
+   * The storage also requests this by itself when HashMetadata::resize_chain_length_threshold_
+   * is set.
+   * @see foedus::storage::hash::HashComposer
+   */
+  ErrorStack          request_resize(uint8_t new_bin_bits);
+
   /**
    * @copydoc foedus::storage::StorageManager::track_moved_record()
    * @note Implementation note
@@ -552,6 +568,54 @@ class HashStorage CXX11_FINAL : public Storage<HashStorageControlBlock> {
     const HashCombo& combo,
     PAYLOAD* value,
     uint16_t payload_offset);
+
+  /**
+   * @brief This is a faster increment that does not return the value after increment.
+   * @param[in] context Thread context
+   * @param[in] key Arbitrary length of key.
+   * @param[in] key_length Byte size of key.
+   * @param[in] value addendum
+   * @param[in] payload_offset We overwrite to this byte position of the record.
+   * @pre payload_offset + sizeof(PAYLOAD) must be within the record's actual payload size
+   * (returns kErrorCodeStrTooShortPayload if not)
+   * @tparam PAYLOAD primitive type of the payload. all integers and floats are allowed.
+   * @details
+   * Unlike increment_record(), this doesn't read the current value, so it takes only a write
+   * set (HashIncrementLogType), not a read set. The commit protocol confirms that the record
+   * still exists when it locks the record. Hence, concurrent increments on the same record,
+   * such as a counter row, never abort each other.
+   */
+  template <typename PAYLOAD>
+  inline ErrorCode increment_record_oneshot(
+    thread::Thread* context,
+    const void* key,
+    uint16_t key_length,
+    PAYLOAD value,
+    uint16_t payload_offset) {
+    HashCombo c(combo(key, key_length));
+    return increment_record_oneshot(context, key, key_length, c, value, payload_offset);
+  }
+
+  /** Overlord to receive key as a primitive type. */
+  template <typename KEY, typename PAYLOAD>
+  inline ErrorCode increment_record_oneshot(
+    thread::Thread* context,
+    KEY key,
+    PAYLOAD value,
+    uint16_t payload_offset) {
+    HashCombo c(combo<KEY>(&key));
+    return increment_record_oneshot(context, &key, sizeof(key), c, value, payload_offset);
+  }
+
+  /** If you have already computed HashCombo, use this. */
+  template <typename PAYLOAD>
+  ErrorCode       increment_record_oneshot(
+    thread::Thread* context,
+    const void* key,
+    uint16_t key_length,
+    const HashCombo& combo,
+    PAYLOAD value,
+    uint16_t payload_offset);
 };
 }  // namespace hash
 }  // namespace storage
@@ -29,7 +29,9 @@
 #include "foedus/assorted/assorted_func.hpp"
 #include "foedus/assorted/const_div.hpp"
 #include "foedus/cache/fwd.hpp"
+#include "foedus/log/fwd.hpp"
 #include "foedus/memory/fwd.hpp"
+#include "foedus/snapshot/snapshot_id.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
 #include "foedus/storage/fwd.hpp"
 #include "foedus/storage/storage.hpp"
@@ -80,7 +82,57 @@ struct HashStorageControlBlock final {
    * At least 1, and surely within 8 levels.
    */
   uint8_t             levels_;
-  char                padding_[7];
+
+  /**
+   * bin_bits the storage will have after an ongoing resize. 0 if no resize is requested.
+   * Set by HashStorage::request_resize() or by the chain-length check in construct_root().
+   * The next snapshot composes the new layout and switches meta_.bin_bits_ to it.
+   */
+  uint8_t             resize_bin_bits_;
+  /**
+   * bin_bits of the snapshot being constructed. Latched in HashPartitioner::design_partition()
+   * so that all mappers and reducers of one snapshot agree on the layout even if someone
+   * requests a resize in the meantime. Equals meta_.bin_bits_ unless this snapshot resizes.
+   */
+  uint8_t             snapshot_bin_bits_;
+  char                padding_[1];
+  /**
+   * ID of the snapshot that composed this storage with a new bin_bits.
+   * drop_volatiles() of that snapshot rebuilds the volatile pages in the new layout.
+   */
+  snapshot::SnapshotId  resized_snapshot_id_;
+  char                padding2_[2];
+
+  /**
+   * Number of bins composed in the current snapshot, for the chain-length check.
+   * Reset in design_partition(), summed up by reducers.
+   */
+  uint64_t            composed_bins_;
+  /** Number of data pages in composed_bins_. */
+  uint64_t            composed_pages_;
+
+  /** @return whether this snapshot composes a different bin_bits from the current one */
+  bool is_resizing_in_snapshot() const { return snapshot_bin_bits_ != meta_.bin_bits_; }
+  /** @return levels of the snapshot being constructed. levels_ unless resizing */
+  uint8_t get_snapshot_levels() const { return bins_to_level(1ULL << snapshot_bin_bits_); }
+  /** @return the number of child pointers in the root page of the snapshot being constructed */
+  uint16_t get_snapshot_root_children() const {
+    return assorted::int_div_ceil(
+      1ULL << snapshot_bin_bits_,
+      kHashMaxBins[get_snapshot_levels() - 1U]);
+  }
+  /**
+   * Called on the copy of this control block written to the snapshot metadata of the given
+   * snapshot. If the snapshot resized the storage, it must say the new bin_bits although
+   * meta_.bin_bits_ is switched only in HashComposer::drop_volatiles() after that.
+   */
+  void fix_snapshot_metadata(snapshot::SnapshotId snapshot_id) {
+    if (resized_snapshot_id_ == snapshot_id && is_resizing_in_snapshot()) {
+      meta_.bin_bits_ = snapshot_bin_bits_;
+      bin_count_ = 1ULL << snapshot_bin_bits_;
+      levels_ = get_snapshot_levels();
+    }
+  }
 };
 
 /**
@@ -151,6 +203,10 @@ class HashStoragePimpl final : public Attachable<HashStorageControlBlock> {
   ErrorStack  create(const HashMetadata& metadata);
   ErrorStack  load(const StorageControlBlock& snapshot_block);
   ErrorStack  drop();
+  /** @see foedus::storage::hash::HashStorage::request_resize() */
+  ErrorStack  request_resize(uint8_t new_bin_bits);
+  /** Checks if the partitioner memory can accommodate the given number of bins. */
+  ErrorStack  check_partitioner_memory(const HashMetadata& metadata) const;
 
   bool                exists()    const { return control_block_->exists(); }
   StorageId           get_id()    const { return control_block_->meta_.id_; }
@@ -268,6 +324,16 @@ class HashStoragePimpl final : public Attachable<HashStorageControlBlock> {
     PAYLOAD* value,
     uint16_t payload_offset);
 
+  /** @see foedus::storage::hash::HashStorage::increment_record_oneshot() */
+  template <typename PAYLOAD>
+  ErrorCode   increment_record_oneshot(
+    thread::Thread* context,
+    const void* key,
+    uint16_t key_length,
+    const HashCombo& combo,
+    PAYLOAD value,
+    uint16_t payload_offset);
+
   /**
    * Retrieves the root page of this storage.
    */
@@ -371,6 +437,19 @@ class HashStoragePimpl final : public Attachable<HashStorageControlBlock> {
     HashDataPage* bin_head,
     RecordLocation* result);
 
+  /**
+   * Used only by log-replay restart. Locates the record the given hash log applies to.
+   * Insert and update logs create or migrate the physical record so that it can accommodate
+   * the payload, while other logs require the record to exist.
+   * The caller is responsible for locking the record and checking the moved bit before
+   * applying the log.
+   */
+  ErrorCode   locate_record_for_replay(
+    thread::Thread* context,
+    const log::RecordLogType* log_entry,
+    xct::LockableXctId** owner_id,
+    char** payload_address);
+
   ErrorCode   reserve_record(
     thread::Thread* context,
     const void* key,
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_STORAGE_HASH_HASH_TAG_SEARCH_HPP_
+#define FOEDUS_STORAGE_HASH_HASH_TAG_SEARCH_HPP_
+
+#include <stdint.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>  // NOLINT(build/include_alpha)
+#elif defined(__AVX2__)
+#include <immintrin.h>  // NOLINT(build/include_alpha)
+#elif defined(__SSE2__)
+#include <emmintrin.h>  // NOLINT(build/include_alpha)
+#endif  // defined(__aarch64__)
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/compiler.hpp"
+#include "foedus/storage/hash/hash_id.hpp"
+
+/**
+ * @file foedus/storage/hash/hash_tag_search.hpp
+ * @brief Vectorized search over the 8-bit hash tags of a data page.
+ * @ingroup HASH
+ * @details
+ * Each HashDataPage keeps an 8-bit tag of each record's hash value in a contiguous array
+ * next to the bloom filter. Slots themselves are 32 bytes each and interleaved with TIDs and
+ * offsets, so HashDataPage::search_key() first compares tags, 16 or 32 per instruction, and
+ * then touches only the slots whose tags match.
+ *
+ * The implementation is picked at compile time:
+ * \li AArch64: NEON, 16 tags per instruction.
+ * \li x86 with -mavx2: AVX2, 32 tags per instruction.
+ * \li Other x86-64: SSE2, 16 tags per instruction.
+ * \li Otherwise: scalar loop.
+ *
+ * Vectorized paths read whole 16/32 byte chunks even beyond the count, which is fine as far as
+ * the chunk is within the tag array (kHashDataPageTagCount is a multiple of 32). Bits beyond
+ * the count are masked out, so concurrent inserts after the count don't matter.
+ */
+
+namespace foedus {
+namespace storage {
+namespace hash {
+
+/** Max number of tags match_tags() can take at once. One bit for each tag. */
+const uint16_t kHashTagSearchBatch = 32;
+
+/**
+ * @brief Returns the 8-bit tag of a hash value.
+ * @ingroup HASH
+ * @details
+ * All records in a page share the same bin, which is the high bits of hash values, and the
+ * bloom filter uses the lowest bits. To be independent from both, we fold all 8 bytes.
+ */
+inline uint8_t extract_hash_tag(HashValue hash) ALWAYS_INLINE;
+inline uint8_t extract_hash_tag(HashValue hash) {
+  uint64_t folded = hash ^ (hash >> 32);
+  folded ^= folded >> 16;
+  folded ^= folded >> 8;
+  return static_cast<uint8_t>(folded);
+}
+
+/**
+ * @brief Scalar version of match_tags(). Always available.
+ * @ingroup HASH
+ */
+inline uint32_t match_tags_scalar(const uint8_t* tags, uint16_t count, uint8_t tag) ALWAYS_INLINE;
+inline uint32_t match_tags_scalar(const uint8_t* tags, uint16_t count, uint8_t tag) {
+  ASSERT_ND(count <= kHashTagSearchBatch);
+  uint32_t ret = 0;
+  for (uint16_t i = 0; i < count; ++i) {
+    if (tags[i] == tag) {
+      ret |= (1U << i);
+    }
+  }
+  return ret;
+}
+
+/**
+ * @brief Returns a bitmask of tags[0, count) that are equal to the given tag.
+ * @ingroup HASH
+ * @param[in] tags first tag to compare. tags[0, kHashTagSearchBatch) must be readable.
+ * @param[in] count number of tags to compare. at most kHashTagSearchBatch.
+ * @param[in] tag the tag to search for
+ * @return i-th bit is on iff tags[i] == tag.
+ */
+inline uint32_t match_tags(const uint8_t* tags, uint16_t count, uint8_t tag) ALWAYS_INLINE;
+inline uint32_t match_tags(const uint8_t* tags, uint16_t count, uint8_t tag) {
+  ASSERT_ND(count <= kHashTagSearchBatch);
+  if (count == 0) {
+    return 0;
+  }
+  uint32_t ret;
+#if defined(__aarch64__)
+  // NEON has no movemask. Weight each byte with its bit and then sum up each half.
+  static const uint8_t kWeights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+  const uint8x16_t weights = vld1q_u8(kWeights);
+  const uint8x16_t key = vdupq_n_u8(tag);
+  ret = 0;
+  for (uint16_t i = 0; i < kHashTagSearchBatch; i += 16U) {
+    const uint8x16_t bits = vandq_u8(vceqq_u8(vld1q_u8(tags + i), key), weights);
+    const uint32_t low = vaddv_u8(vget_low_u8(bits));
+    const uint32_t high = vaddv_u8(vget_high_u8(bits));
+    ret |= (low | (high << 8)) << i;
+  }
+#elif defined(__AVX2__)
+  const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags));
+  const __m256i eq = _mm256_cmpeq_epi8(values, _mm256_set1_epi8(tag));
+  ret = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+#elif defined(__SSE2__)
+  const __m128i key = _mm_set1_epi8(tag);
+  const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags));
+  const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + 16));
+  ret = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(low, key)))
+    | (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(high, key))) << 16);
+#else  // defined(__aarch64__)
+  return match_tags_scalar(tags, count, tag);
+#endif  // defined(__aarch64__)
+  if (count < kHashTagSearchBatch) {
+    ret &= (1U << count) - 1U;
+  }
+  return ret;
+}
+
+/** Name of the implementation match_tags() uses in this build. For experiments and logging. */
+inline const char* get_tag_search_implementation() {
+#if defined(__aarch64__)
+  return "neon";
+#elif defined(__AVX2__)
+  return "avx2";
+#elif defined(__SSE2__)
+  return "sse2";
+#else  // defined(__aarch64__)
+  return "scalar";
+#endif  // defined(__aarch64__)
+}
+
+}  // namespace hash
+}  // namespace storage
+}  // namespace foedus
+#endif  // FOEDUS_STORAGE_HASH_HASH_TAG_SEARCH_HPP_
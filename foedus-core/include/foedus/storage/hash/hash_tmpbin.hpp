@@ -26,6 +26,7 @@
 #include "foedus/cxx11.hpp"
 #include "foedus/assorted/assorted_func.hpp"
 #include "foedus/memory/aligned_memory.hpp"
+#include "foedus/storage/increment.hpp"
 #include "foedus/storage/hash/fwd.hpp"
 #include "foedus/storage/hash/hash_hashinate.hpp"
 #include "foedus/storage/hash/hash_id.hpp"
@@ -257,6 +258,22 @@ class HashTmpBin CXX11_FINAL {
     uint16_t payload_offset,
     uint16_t payload_count);
 
+  /**
+   * @brief Adds the addendum of the given type to a part of the record of the given key.
+   * @details
+   * Same as overwrite_record() except that this folds an increment log into the record.
+   * If there is no existing record of the key, or such a record is already logically deleted,
+   * this method returns an error (kErrorCodeStrKeyNotFound). Mustn't happen either.
+   */
+  ErrorCode increment_record(
+    xct::XctId xct_id,
+    const void* key,
+    uint16_t key_length,
+    HashValue hash,
+    ValueType value_type,
+    const void* addendum,
+    uint16_t payload_offset);
+
   /**
    * @brief Updates a record of the given key with the given payload, which might change length.
    * @details
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_STORAGE_INCREMENT_HPP_
+#define FOEDUS_STORAGE_INCREMENT_HPP_
+#include <stdint.h>
+
+#include "foedus/assert_nd.hpp"
+
+/**
+ * @file foedus/storage/increment.hpp
+ * @brief Primitive value types and helpers shared by the increment log types of all storages.
+ * @ingroup STORAGE
+ */
+namespace foedus {
+namespace storage {
+
+/**
+ * @brief Primitive type of the addendum in increment operations.
+ * @ingroup STORAGE
+ * @details
+ * Used in array::ArrayIncrementLogType, hash::HashIncrementLogType and
+ * masstree::MasstreeIncrementLogType.
+ */
+enum ValueType {
+  kUnknown = 0,
+  kI8 = 1,
+  kI16,
+  kI32,
+  kU8,
+  kU16,
+  kU32,
+  kFloat,
+  kBool,
+  // above are 32bits or less, below are 64 bits
+  kI64,
+  kU64,
+  kDouble,
+};
+template <typename T> ValueType to_value_type();
+template <> inline ValueType to_value_type<bool>() { return kBool; }
+template <> inline ValueType to_value_type<int8_t>() { return kI8; }
+template <> inline ValueType to_value_type<int16_t>() { return kI16; }
+template <> inline ValueType to_value_type<int32_t>() { return kI32; }
+template <> inline ValueType to_value_type<int64_t>() { return kI64; }
+template <> inline ValueType to_value_type<uint8_t>() { return kU8; }
+template <> inline ValueType to_value_type<uint16_t>() { return kU16; }
+template <> inline ValueType to_value_type<uint32_t>() { return kU32; }
+template <> inline ValueType to_value_type<uint64_t>() { return kU64; }
+template <> inline ValueType to_value_type<float>() { return kFloat; }
+template <> inline ValueType to_value_type<double>() { return kDouble ; }
+
+template <typename T>
+inline void add_to(void* destination, const void* added) {
+  *(reinterpret_cast< T* >(destination)) += *(reinterpret_cast< const T* >(added));
+}
+
+/** @brief Adds the value of the given type to the destination. */
+inline void add_value(ValueType value_type, void* destination, const void* added) {
+  switch (value_type) {
+    case kI8:
+      add_to<int8_t>(destination, added);
+      break;
+    case kI16:
+      add_to<int16_t>(destination, added);
+      break;
+    case kI32:
+      add_to<int32_t>(destination, added);
+      break;
+    case kBool:
+    case kU8:
+      add_to<uint8_t>(destination, added);
+      break;
+    case kU16:
+      add_to<uint16_t>(destination, added);
+      break;
+    case kU32:
+      add_to<uint32_t>(destination, added);
+      break;
+    case kFloat:
+      add_to<float>(destination, added);
+      break;
+    case kI64:
+      add_to<int64_t>(destination, added);
+      break;
+    case kU64:
+      add_to<uint64_t>(destination, added);
+      break;
+    case kDouble:
+      add_to<double>(destination, added);
+      break;
+    default:
+      ASSERT_ND(false);
+      break;
+  }
+}
+
+/** @returns byte size of the given value type */
+inline uint16_t get_value_size(ValueType value_type) {
+  switch (value_type) {
+    case kI8:
+    case kU8:
+    case kBool:
+      return 1U;
+    case kI16:
+    case kU16:
+      return 2U;
+    case kI32:
+    case kU32:
+    case kFloat:
+      return 4U;
+    case kI64:
+    case kU64:
+    case kDouble:
+      return 8U;
+    default:
+      ASSERT_ND(false);
+      return 0;
+  }
+}
+
+}  // namespace storage
+}  // namespace foedus
+#endif  // FOEDUS_STORAGE_INCREMENT_HPP_
@@ -98,7 +98,10 @@ class MasstreeComposer final {
   bool is_updated_pointer(
     const Composer::DropVolatilesArguments& args,
     SnapshotPagePointer pointer) const;
-  bool is_to_keep_volatile(uint8_t layer, uint16_t btree_level) const;
+  bool is_to_keep_volatile(
+    const Composer::DropVolatilesArguments& args,
+    uint8_t layer,
+    uint16_t btree_level) const;
 
   /** used only when "page" is guaranteed to be dropped. */
   void drop_foster_twins(const Composer::DropVolatilesArguments& args, MasstreePage* page);
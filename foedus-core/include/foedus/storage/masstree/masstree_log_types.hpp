@@ -27,6 +27,7 @@
 #include "foedus/assorted/assorted_func.hpp"
 #include "foedus/log/common_log_types.hpp"
 #include "foedus/log/log_type.hpp"
+#include "foedus/storage/increment.hpp"
 #include "foedus/storage/page.hpp"
 #include "foedus/storage/record.hpp"
 #include "foedus/storage/storage_id.hpp"
@@ -75,20 +76,23 @@ inline uint8_t extract_page_layer(const void* in_page_pointer) {
 }
 
 /**
- * @brief A base class for MasstreeInsertLogType/MasstreeDeleteLogType/MasstreeOverwriteLogType.
+ * @brief A base class for MasstreeInsertLogType/MasstreeDeleteLogType/MasstreeOverwriteLogType
+ * and MasstreeIncrementLogType.
  * @ingroup MASSTREE LOGTYPE
  * @details
  * This defines a common layout for the log types so that composer/partitioner can easier
  * handle these log types. This means we waste a bit (eg delete log type doesn't need payload
  * offset/count), but we anyway have extra space if we want to have data_ 8-byte aligned.
- * data_ always starts with the key, followed by payload for insert/overwrite.
+ * data_ always starts with the key, followed by payload for insert/overwrite
+ * (addendum for increment).
  */
 struct MasstreeCommonLogType : public log::RecordLogType {
   LOG_TYPE_NO_CONSTRUCT(MasstreeCommonLogType)
   KeyLength       key_length_;        // +2 => 18
   PayloadLength   payload_offset_;    // +2 => 20
   PayloadLength   payload_count_;     // +2 => 22
-  uint16_t        reserved_;          // +2 => 24
+  /** ValueType of the addendum. Used only in MasstreeIncrementLogType, 0 otherwise */
+  uint16_t        value_type_;        // +2 => 24
   /**
    * Full key and (if exists) payload data, both of which are padded to 8 bytes.
    * By padding key part to 8 bytes, slicing becomes more efficient.
@@ -127,7 +131,7 @@ struct MasstreeCommonLogType : public log::RecordLogType {
     key_length_ = key_length;
     payload_offset_ = payload_offset;
     payload_count_ = payload_count;
-    reserved_ = 0;
+    value_type_ = kUnknown;
 
     std::memcpy(aligned_data_, key, key_length);
     KeyLength aligned_key_length = assorted::align8(key_length);
@@ -472,6 +476,68 @@ struct MasstreeOverwriteLogType : public MasstreeCommonLogType {
   friend std::ostream& operator<<(std::ostream& o, const MasstreeOverwriteLogType& v);
 };
 
+/**
+ * @brief Log type of masstree-storage's blind increment operation.
+ * @ingroup MASSTREE LOGTYPE
+ * @details
+ * Counterpart of ArrayIncrementLogType in masstree, used by increment_record_oneshot().
+ * The payload part holds the addendum (payload_count_ is its size) and value_type_ tells its
+ * primitive type. This log doesn't rely on the current value, so the transaction takes only
+ * a write set. Concurrent increments on the same record are serialized by the record lock at
+ * commit time and never abort each other.
+ */
+struct MasstreeIncrementLogType : public MasstreeCommonLogType {
+  LOG_TYPE_NO_CONSTRUCT(MasstreeIncrementLogType)
+
+  template <typename PAYLOAD>
+  void            populate(
+    StorageId   storage_id,
+    const void* key,
+    KeyLength   key_length,
+    PAYLOAD     addendum,
+    PayloadLength payload_offset) {
+    log::LogCode type = log::kLogCodeMasstreeIncrement;
+    ASSERT_ND(key_length > 0U);
+    populate_base(type, storage_id, key, key_length, &addendum, payload_offset, sizeof(PAYLOAD));
+    value_type_ = to_value_type<PAYLOAD>();
+  }
+
+  ValueType get_value_type() const ALWAYS_INLINE {
+    return static_cast<ValueType>(value_type_);
+  }
+
+  /**
+   * @returns whether the record still has the payload range this log increments.
+   * A blind increment has no read-set on the record, so the commit protocol calls this under
+   * the record lock in case the record was deleted and re-inserted with a shorter payload.
+   */
+  bool            fits_record(const xct::LockableXctId* owner_id) const ALWAYS_INLINE {
+    // In the MasstreeBorderPage slot, lengthes come right after TID. [3] is payload_length_.
+    const uint16_t* lengthes = reinterpret_cast<const uint16_t*>(owner_id + 1);
+    return payload_offset_ + payload_count_ <= lengthes[3];
+  }
+
+  void            apply_record(
+    thread::Thread* /*context*/,
+    StorageId /*storage_id*/,
+    xct::LockableXctId* owner_id,
+    char* data) const ALWAYS_INLINE {
+    RecordAddresses addresses = apply_record_prepare(owner_id, data);
+    ASSERT_ND(!owner_id->xct_id_.is_deleted());
+    ASSERT_ND(*addresses.record_payload_count_ >= payload_count_ + payload_offset_);
+    add_value(get_value_type(), addresses.record_payload_ + payload_offset_, get_payload());
+  }
+
+  void            assert_valid() const ALWAYS_INLINE {
+    assert_valid_generic();
+    ASSERT_ND(header_.log_length_ == calculate_log_length(key_length_, payload_count_));
+    ASSERT_ND(header_.get_type() == log::kLogCodeMasstreeIncrement);
+    ASSERT_ND(payload_count_ == get_value_size(get_value_type()));
+  }
+
+  friend std::ostream& operator<<(std::ostream& o, const MasstreeIncrementLogType& v);
+};
+
 
 }  // namespace masstree
 }  // namespace storage
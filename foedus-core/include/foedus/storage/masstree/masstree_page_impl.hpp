@@ -37,6 +37,7 @@
 #include "foedus/storage/storage_id.hpp"
 #include "foedus/storage/masstree/fwd.hpp"
 #include "foedus/storage/masstree/masstree_id.hpp"
+#include "foedus/storage/masstree/masstree_slice_search.hpp"
 #include "foedus/thread/fwd.hpp"
 #include "foedus/xct/fwd.hpp"
 #include "foedus/xct/xct_id.hpp"
@@ -299,12 +300,7 @@ class MasstreeIntermediatePage final : public MasstreePage {
     uint8_t find_pointer(KeySlice slice) const ALWAYS_INLINE {
       uint8_t key_count = key_count_;
       ASSERT_ND(key_count <= kMaxIntermediateMiniSeparators);
-      for (uint8_t i = 0; i < key_count; ++i) {
-        if (slice < separators_[i]) {
-          return i;
-        }
-      }
-      return key_count;
+      return find_separator(separators_, key_count, slice);
     }
   };
 
@@ -324,12 +320,7 @@ class MasstreeIntermediatePage final : public MasstreePage {
   uint8_t find_minipage(KeySlice slice) const ALWAYS_INLINE {
     uint8_t key_count = get_key_count();
     ASSERT_ND(key_count <= kMaxIntermediateSeparators);
-    for (uint8_t i = 0; i < key_count; ++i) {
-      if (slice < separators_[i]) {
-        return i;
-      }
-    }
-    return key_count;
+    return find_separator(separators_, key_count, slice);
   }
   MiniPage&         get_minipage(uint8_t index) ALWAYS_INLINE { return mini_pages_[index]; }
   const MiniPage&   get_minipage(uint8_t index) const ALWAYS_INLINE { return mini_pages_[index]; }
@@ -1183,27 +1174,24 @@ inline SlotIndex MasstreeBorderPage::find_key(
   prefetch_additional_if_needed(key_count);
 
   // one slice might be used for up to 10 keys, length 0 to 8 and pointer to next layer.
-  if (remainder <= sizeof(KeySlice)) {
-    // then we are looking for length 0-8 only.
-    for (SlotIndex i = 0; i < key_count; ++i) {
-      const KeySlice rec_slice = get_slice(i);
-      if (LIKELY(slice != rec_slice)) {
-        continue;
-      }
-      // no suffix nor next layer, so just compare length. if not match, continue
-      const KeyLength klen = get_remainder_length(i);
-      if (klen == remainder) {
-        return i;
-      }
-    }
-  } else {
-    // then we are only looking for length>8.
-    for (SlotIndex i = 0; i < key_count; ++i) {
-      const KeySlice rec_slice = get_slice(i);
-      if (LIKELY(slice != rec_slice)) {
+  // we first find slots of the same slice in a vectorized fashion, then check each of them.
+  for (SlotIndex base = 0; base < key_count; base += kSliceSearchBatch) {
+    const SlotIndex count = std::min<SlotIndex>(key_count - base, kSliceSearchBatch);
+    uint64_t matches = match_slices(slices_ + base, count, slice);
+    for (; matches != 0; matches &= matches - 1U) {
+      const SlotIndex i = base + __builtin_ctzll(matches);
+      ASSERT_ND(get_slice(i) == slice);
+      if (remainder <= sizeof(KeySlice)) {
+        // then we are looking for length 0-8 only.
+        // no suffix nor next layer, so just compare length. if not match, continue
+        const KeyLength klen = get_remainder_length(i);
+        if (klen == remainder) {
+          return i;
+        }
         continue;
       }
 
+      // then we are only looking for length>8.
       if (does_point_to_layer(i)) {
         // as it points to next layer, no need to check suffix. We are sure this is it.
         // so far we don't delete layers, so in this case the record is always valid.
@@ -1226,7 +1214,7 @@ inline SlotIndex MasstreeBorderPage::find_key(
 
       // The record has > 8 bytes key of the same slice. it must be the only such record in this
       // page because otherwise we must have created a next layer!
-      break;  // no more check needed
+      return kBorderPageMaxSlots;  // no more check needed
     }
   }
   return kBorderPageMaxSlots;
@@ -1241,11 +1229,16 @@ inline SlotIndex MasstreeBorderPage::find_key_normalized(
   if (from_index == 0) {  // we don't need prefetching in second time
     prefetch_additional_if_needed(to_index);
   }
-  for (SlotIndex i = from_index; i < to_index; ++i) {
-    const KeySlice rec_slice = get_slice(i);
-    const KeyLength klen = get_remainder_length(i);
-    if (UNLIKELY(slice == rec_slice && klen == sizeof(KeySlice))) {
-      return i;
+  for (SlotIndex base = from_index; base < to_index; base += kSliceSearchBatch) {
+    const SlotIndex count = std::min<SlotIndex>(to_index - base, kSliceSearchBatch);
+    uint64_t matches = match_slices(slices_ + base, count, slice);
+    for (; matches != 0; matches &= matches - 1U) {
+      const SlotIndex i = base + __builtin_ctzll(matches);
+      ASSERT_ND(get_slice(i) == slice);
+      const KeyLength klen = get_remainder_length(i);
+      if (klen == sizeof(KeySlice)) {
+        return i;
+      }
     }
   }
   return kBorderPageMaxSlots;
@@ -1263,22 +1256,18 @@ inline MasstreeBorderPage::FindKeyForReserveResult MasstreeBorderPage::find_key_
   if (from_index == 0) {
     prefetch_additional_if_needed(to_index);
   }
-  if (remainder <= sizeof(KeySlice)) {
-    for (SlotIndex i = from_index; i < to_index; ++i) {
-      const KeySlice rec_slice = get_slice(i);
-      if (LIKELY(slice != rec_slice)) {
-        continue;
-      }
-      const KeyLength klen = get_remainder_length(i);
-      if (klen == remainder) {
-        ASSERT_ND(!does_point_to_layer(i));
-        return FindKeyForReserveResult(i, kExactMatchLocalRecord);
-      }
-    }
-  } else {
-    for (SlotIndex i = from_index; i < to_index; ++i) {
-      const KeySlice rec_slice = get_slice(i);
-      if (LIKELY(slice != rec_slice)) {
+  for (SlotIndex base = from_index; base < to_index; base += kSliceSearchBatch) {
+    const SlotIndex count = std::min<SlotIndex>(to_index - base, kSliceSearchBatch);
+    uint64_t matches = match_slices(slices_ + base, count, slice);
+    for (; matches != 0; matches &= matches - 1U) {
+      const SlotIndex i = base + __builtin_ctzll(matches);
+      ASSERT_ND(get_slice(i) == slice);
+      if (remainder <= sizeof(KeySlice)) {
+        const KeyLength klen = get_remainder_length(i);
+        if (klen == remainder) {
+          ASSERT_ND(!does_point_to_layer(i));
+          return FindKeyForReserveResult(i, kExactMatchLocalRecord);
+        }
         continue;
       }
 
@@ -226,7 +226,8 @@ inline const MasstreeCommonLogType* resolve_log(
   ASSERT_ND(rec->header_.get_type() == log::kLogCodeMasstreeInsert
     || rec->header_.get_type() == log::kLogCodeMasstreeDelete
     || rec->header_.get_type() == log::kLogCodeMasstreeUpdate
-    || rec->header_.get_type() == log::kLogCodeMasstreeOverwrite);
+    || rec->header_.get_type() == log::kLogCodeMasstreeOverwrite
+    || rec->header_.get_type() == log::kLogCodeMasstreeIncrement);
   return rec;
 }
 
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_STORAGE_MASSTREE_MASSTREE_SLICE_SEARCH_HPP_
+#define FOEDUS_STORAGE_MASSTREE_MASSTREE_SLICE_SEARCH_HPP_
+
+#include <stdint.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>  // NOLINT(build/include_alpha)
+#elif defined(__AVX2__)
+#include <immintrin.h>  // NOLINT(build/include_alpha)
+#elif defined(__SSE2__)
+#include <emmintrin.h>  // NOLINT(build/include_alpha)
+#if defined(__SSE4_1__)
+#include <smmintrin.h>  // NOLINT(build/include_alpha)
+#endif  // defined(__SSE4_1__)
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>  // NOLINT(build/include_alpha)
+#endif  // defined(__SSE4_2__)
+#endif  // defined(__aarch64__)
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/compiler.hpp"
+#include "foedus/storage/masstree/masstree_id.hpp"
+
+/**
+ * @file foedus/storage/masstree/masstree_slice_search.hpp
+ * @brief Vectorized searches over the key slices of border pages and the separators of
+ * intermediate pages.
+ * @ingroup MASSTREE
+ * @details
+ * Slots in a volatile border page are not sorted, so finding a key ends with a linear scan
+ * over slices_. The methods here compare several slices per instruction and return a bitmask
+ * of matching slots, which the caller then verifies one by one (remainder length, suffix, etc).
+ * Remainder lengths are not compared here because they are in the Slot part at the end of the
+ * page (32 bytes apart), so gathering them costs more than checking the few matched slots.
+ *
+ * The implementation is picked at compile time:
+ * \li AArch64: NEON, 2 slices per instruction.
+ * \li x86 with -mavx2: AVX2, 4 slices per instruction.
+ * \li Other x86-64: SSE2 (SSE4.1's pcmpeqq if available), 2 slices per instruction.
+ * \li Otherwise: scalar loop.
+ *
+ * All of them read only slices[0, count), so it's safe to use on volatile pages where slices
+ * after the current key count might be being written.
+ *
+ * find_separator() is the counterpart for intermediate pages and mini-pages. Separators are
+ * sorted, so the index to follow is simply the number of separators that are not larger than
+ * the searching slice. We count it without branches, which avoids mispredicting the loop exit
+ * at every level of every traversal. KeySlice is unsigned, so x86 flips the sign bit before
+ * the signed 64-bit comparison (AVX2, or SSE4.2's pcmpgtq). SSE2 has no 64-bit comparison,
+ * so it uses the branchless scalar loop.
+ */
+
+namespace foedus {
+namespace storage {
+namespace masstree {
+
+/**
+ * Max number of slices match_slices() can take at once. One bit for each slice.
+ * Callers search a page in batches of this size so that they can stop at the first match without
+ * scanning the whole page. 32 slices are 4 cachelines.
+ */
+const SlotIndex kSliceSearchBatch = 32;
+
+/**
+ * @brief Scalar version of match_slices(). Always available, used for the tail part.
+ * @ingroup MASSTREE
+ */
+inline uint64_t match_slices_scalar(
+  const KeySlice* slices,
+  SlotIndex count,
+  KeySlice slice) ALWAYS_INLINE;
+inline uint64_t match_slices_scalar(const KeySlice* slices, SlotIndex count, KeySlice slice) {
+  ASSERT_ND(count <= kSliceSearchBatch);
+  uint64_t ret = 0;
+  for (SlotIndex i = 0; i < count; ++i) {
+    if (slices[i] == slice) {
+      ret |= (1ULL << i);
+    }
+  }
+  return ret;
+}
+
+/**
+ * @brief Returns a bitmask of slices[0, count) that are equal to the given slice.
+ * @ingroup MASSTREE
+ * @param[in] slices first slice to compare. no alignment requirement.
+ * @param[in] count number of slices to compare. at most kSliceSearchBatch.
+ * @param[in] slice the slice to search for
+ * @return i-th bit is on iff slices[i] == slice.
+ */
+inline uint64_t match_slices(
+  const KeySlice* slices,
+  SlotIndex count,
+  KeySlice slice) ALWAYS_INLINE;
+inline uint64_t match_slices(const KeySlice* slices, SlotIndex count, KeySlice slice) {
+  ASSERT_ND(count <= kSliceSearchBatch);
+  uint64_t ret = 0;
+  SlotIndex i = 0;
+#if defined(__aarch64__)
+  const uint64x2_t key = vdupq_n_u64(slice);
+  for (; i + 2U <= count; i += 2U) {
+    const uint64x2_t eq = vceqq_u64(vld1q_u64(slices + i), key);
+    const uint64_t mask = (vgetq_lane_u64(eq, 0) & 1U) | ((vgetq_lane_u64(eq, 1) & 1U) << 1);
+    ret |= mask << i;
+  }
+#elif defined(__AVX2__)
+  const __m256i key = _mm256_set1_epi64x(slice);
+  for (; i + 4U <= count; i += 4U) {
+    const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(slices + i));
+    const __m256i eq = _mm256_cmpeq_epi64(values, key);
+    const uint64_t mask = _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+    ret |= mask << i;
+  }
+#elif defined(__SSE2__)
+  const __m128i key = _mm_set1_epi64x(slice);
+  for (; i + 2U <= count; i += 2U) {
+    const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(slices + i));
+#if defined(__SSE4_1__)
+    const __m128i eq = _mm_cmpeq_epi64(values, key);
+#else  // defined(__SSE4_1__)
+    // SSE2 has no 64-bit compare. both 32-bit halves must match.
+    const __m128i eq32 = _mm_cmpeq_epi32(values, key);
+    const __m128i eq = _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+#endif  // defined(__SSE4_1__)
+    const uint64_t mask = _mm_movemask_pd(_mm_castsi128_pd(eq));
+    ret |= mask << i;
+  }
+#endif  // defined(__aarch64__)
+  if (i < count) {
+    ret |= match_slices_scalar(slices + i, count - i, slice) << i;
+  }
+  return ret;
+}
+
+/**
+ * @brief Scalar version of find_separator(). Always available, used for the tail part.
+ * @ingroup MASSTREE
+ */
+inline uint8_t find_separator_scalar(
+  const KeySlice* separators,
+  uint8_t count,
+  KeySlice slice) ALWAYS_INLINE;
+inline uint8_t find_separator_scalar(const KeySlice* separators, uint8_t count, KeySlice slice) {
+  uint8_t ret = 0;
+  for (uint8_t i = 0; i < count; ++i) {
+    ret += (separators[i] <= slice) ? 1U : 0U;
+  }
+  return ret;
+}
+
+/**
+ * @brief Returns the index of the pointer to follow in an intermediate page or a mini-page.
+ * @ingroup MASSTREE
+ * @param[in] separators sorted separators. no alignment requirement.
+ * @param[in] count number of separators, or the key count of the page.
+ * @param[in] slice the slice to search for
+ * @return the smallest i such that slice < separators[i], or count if there is no such i.
+ * @details
+ * If separators are not sorted (eg being modified by a concurrent split), this returns
+ * a meaningless value that is still at most count. Callers verify the page version anyway.
+ */
+inline uint8_t find_separator(
+  const KeySlice* separators,
+  uint8_t count,
+  KeySlice slice) ALWAYS_INLINE;
+inline uint8_t find_separator(const KeySlice* separators, uint8_t count, KeySlice slice) {
+  uint8_t ret = 0;
+  uint8_t i = 0;
+#if defined(__aarch64__)
+  const uint64x2_t key = vdupq_n_u64(slice);
+  uint64x2_t sum = vdupq_n_u64(0);
+  for (; i + 2U <= count; i += 2U) {
+    // each lane is all-ones (-1) iff separator <= slice
+    sum = vsubq_u64(sum, vcleq_u64(vld1q_u64(separators + i), key));
+  }
+  ret = static_cast<uint8_t>(vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1));
+#elif defined(__AVX2__)
+  const __m256i sign = _mm256_set1_epi64x(0x8000000000000000LL);
+  const __m256i key = _mm256_xor_si256(_mm256_set1_epi64x(slice), sign);
+  for (; i + 4U <= count; i += 4U) {
+    const __m256i values = _mm256_xor_si256(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(separators + i)),
+      sign);
+    // each lane is all-ones iff separator > slice
+    const __m256i gt = _mm256_cmpgt_epi64(values, key);
+    const uint32_t mask = _mm256_movemask_pd(_mm256_castsi256_pd(gt));
+    ret += 4U - __builtin_popcount(mask);
+  }
+#elif defined(__SSE4_2__)
+  const __m128i sign = _mm_set1_epi64x(0x8000000000000000LL);
+  const __m128i key = _mm_xor_si128(_mm_set1_epi64x(slice), sign);
+  for (; i + 2U <= count; i += 2U) {
+    const __m128i values = _mm_xor_si128(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(separators + i)),
+      sign);
+    const __m128i gt = _mm_cmpgt_epi64(values, key);
+    const uint32_t mask = _mm_movemask_pd(_mm_castsi128_pd(gt));
+    ret += 2U - __builtin_popcount(mask);
+  }
+#endif  // defined(__aarch64__)
+  if (i < count) {
+    ret += find_separator_scalar(separators + i, count - i, slice);
+  }
+  ASSERT_ND(ret <= count);
+  return ret;
+}
+
+/** Name of the implementation match_slices() uses in this build. For experiments and logging. */
+inline const char* get_slice_search_implementation() {
+#if defined(__aarch64__)
+  return "neon";
+#elif defined(__AVX2__)
+  return "avx2";
+#elif defined(__SSE4_1__)
+  return "sse4.1";
+#elif defined(__SSE2__)
+  return "sse2";
+#else  // defined(__aarch64__)
+  return "scalar";
+#endif  // defined(__aarch64__)
+}
+
+/** Name of the implementation find_separator() uses in this build. */
+inline const char* get_separator_search_implementation() {
+#if defined(__aarch64__)
+  return "neon";
+#elif defined(__AVX2__)
+  return "avx2";
+#elif defined(__SSE4_2__)
+  return "sse4.2";
+#else  // defined(__aarch64__)
+  return "scalar";
+#endif  // defined(__aarch64__)
+}
+
+}  // namespace masstree
+}  // namespace storage
+}  // namespace foedus
+#endif  // FOEDUS_STORAGE_MASSTREE_MASSTREE_SLICE_SEARCH_HPP_
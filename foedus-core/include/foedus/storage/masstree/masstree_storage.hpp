@@ -521,6 +521,41 @@ class MasstreeStorage CXX11_FINAL : public Storage<MasstreeStorageControlBlock>
     PAYLOAD* value,
     PayloadLength payload_offset);
 
+  /**
+   * @brief This is a faster increment that does not return the value after increment.
+   * @param[in] context Thread context
+   * @param[in] key Arbitrary length of key that is lexicographically (big-endian) evaluated.
+   * @param[in] key_length Byte size of key.
+   * @param[in] value addendum
+   * @param[in] payload_offset We overwrite to this byte position of the record.
+   * @pre payload_offset + sizeof(PAYLOAD) must be within the record's actual payload size
+   * (returns kErrorCodeStrTooShortPayload if not)
+   * @tparam PAYLOAD primitive type of the payload. all integers and floats are allowed.
+   * @details
+   * Unlike increment_record(), this doesn't read the current value, so it takes only a write
+   * set (MasstreeIncrementLogType), not a read set. The commit protocol confirms that the
+   * record still exists when it locks the record. Hence, concurrent increments on the same
+   * record, such as a counter row, never abort each other.
+   */
+  template <typename PAYLOAD>
+  ErrorCode   increment_record_oneshot(
+    thread::Thread* context,
+    const void* key,
+    KeyLength key_length,
+    PAYLOAD value,
+    PayloadLength payload_offset);
+
+  /**
+   * @brief For primitive key.
+   * @see increment_record_oneshot()
+   */
+  template <typename PAYLOAD>
+  ErrorCode   increment_record_oneshot_normalized(
+    thread::Thread* context,
+    KeySlice key,
+    PAYLOAD value,
+    PayloadLength payload_offset);
+
   // TODO(Hideaki): Extend/shrink/update methods for payload. A bit faster than delete + insert.
 
   ErrorStack  verify_single_thread(thread::Thread* context);
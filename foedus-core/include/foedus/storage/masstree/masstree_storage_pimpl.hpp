@@ -28,6 +28,7 @@
 #include "foedus/cxx11.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/cache/fwd.hpp"
+#include "foedus/log/fwd.hpp"
 #include "foedus/memory/fwd.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
 #include "foedus/storage/fwd.hpp"
@@ -137,6 +138,17 @@ class MasstreeStoragePimpl final : public Attachable<MasstreeStorageControlBlock
     MasstreeBorderPage** out_page,
     SlotIndex* record_index,
     xct::XctId* observed);
+  /**
+   * Used only by log-replay restart. Locates the record the given masstree log applies to.
+   * Insert and update logs physically reserve (or expand) the record as needed, while other
+   * logs require the record to exist. The caller is responsible for locking the record
+   * and checking the moved/next-layer bits before applying the log.
+   */
+  ErrorCode locate_record_for_replay(
+    thread::Thread* context,
+    const log::RecordLogType* log_entry,
+    xct::LockableXctId** owner_id,
+    char** payload_address);
   /** Identifies page and record for the normalized key */
   ErrorCode locate_record_normalized(
     thread::Thread* context,
@@ -334,6 +346,18 @@ class MasstreeStoragePimpl final : public Attachable<MasstreeStorageControlBlock
     PAYLOAD* value,
     PayloadLength payload_offset);
 
+  /** implementation of increment_record_oneshot family. use with locate_record()  */
+  template <typename PAYLOAD>
+  ErrorCode increment_oneshot_general(
+    thread::Thread* context,
+    MasstreeBorderPage* border,
+    SlotIndex index,
+    xct::XctId observed,
+    const void* be_key,
+    KeyLength key_length,
+    PAYLOAD value,
+    PayloadLength payload_offset);
+
   /** These are defined in masstree_storage_verify.cpp */
   ErrorStack verify_single_thread(thread::Thread* context);
   ErrorStack verify_single_thread_layer(
@@ -225,6 +225,12 @@ struct PageVersionLockScope {
   bool released_;
 };
 
+/**
+ * @brief Maximum value of PageHeader::hotness_.
+ * @ingroup STORAGE
+ */
+const uint8_t kMaxPageHotness = 0xFFU;
+
 /**
  * @brief Just a marker to denote that a memory region represents a data page.
  * @ingroup STORAGE
@@ -301,7 +307,17 @@ struct PageHeader CXX11_FINAL {
    * Depending on page type, this might not be even maintained (eg implicit in sequential pages).
    */
   uint8_t       stat_last_updater_node_;       // +1 -> 23
-  uint8_t       reserved_;       // +1 -> 24
+  /**
+   * A loosely maintained statistics for volatile pages.
+   * How often transactions have aborted because of races on records in this page.
+   * Incremented (without atomic operation, saturating at kMaxPageHotness) when a transaction
+   * fails to verify a record in this page at commit time. Halved when a snapshot visits
+   * this page to drop volatile pages, so that a page cools down when the contention is gone.
+   * Serializable transactions take record locks during execution, rather than at commit time,
+   * on records they write in pages whose hotness reaches XctOptions::hot_threshold_.
+   * See xct::Xct::lock_hot_record().
+   */
+  uint8_t       hotness_;       // +1 -> 24
   /**
    * Used in several storage types as concurrency control mechanism for the page.
    */
@@ -330,7 +346,7 @@ struct PageHeader CXX11_FINAL {
     masstree_layer_ = 0;
     masstree_in_layer_level_ = 0;
     stat_last_updater_node_ = page_id.components.numa_node;
-    reserved_ = 0;
+    hotness_ = 0;
     page_version_.reset();
   }
 
@@ -347,10 +363,21 @@ struct PageHeader CXX11_FINAL {
     masstree_layer_ = 0;
     masstree_in_layer_level_ = 0;
     stat_last_updater_node_ = extract_numa_node_from_snapshot_pointer(page_id);
-    reserved_ = 0;
+    hotness_ = 0;
     page_version_.reset();
   }
 
+  /** @returns whether the page is hot enough to take record locks during execution. */
+  bool      is_hot(uint16_t threshold) const ALWAYS_INLINE { return hotness_ >= threshold; }
+  /** Racy increment of hotness_. It's just a statistics, so we don't care lost increments. */
+  void      increment_hotness() ALWAYS_INLINE {
+    if (hotness_ < kMaxPageHotness) {
+      ++hotness_;
+    }
+  }
+  /** Racy decay of hotness_. Called for each volatile page the snapshot keeps. */
+  void      decay_hotness() ALWAYS_INLINE { hotness_ >>= 1; }
+
   void      increment_key_count() ALWAYS_INLINE {
     ASSERT_ND(snapshot_ || page_version_.is_locked());
     ++key_count_;
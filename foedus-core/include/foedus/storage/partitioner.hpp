@@ -136,6 +136,35 @@ class Partitioner CXX11_FINAL : public Attachable<PartitionerMetadata> {
    */
   void partition_batch(const PartitionBatchArguments& args);
 
+  /** Arguments for group_by_partition() */
+  struct GroupByPartitionArguments {
+    /** positions of log records, usually the log_positions_ passed to partition_batch(). */
+    const snapshot::BufferPosition* log_positions_;
+    /** partition of each log record, usually the results_ of partition_batch(). */
+    const PartitionId*              partitions_;
+    /** number of entries to process. */
+    uint32_t                        logs_count_;
+    /** number of partitions. All partitions_[i] must be less than this. */
+    uint16_t                        partition_count_;
+    /** [OUT] grouped positions are written to this buffer of at least logs_count_ entries. */
+    snapshot::BufferPosition*       output_buffer_;
+    /**
+     * [OUT] Positions of partition p are output_buffer_[partition_begins_[p],
+     * partition_begins_[p + 1]). This must have at least partition_count_ + 1 entries.
+     */
+    uint32_t*                       partition_begins_;
+  };
+
+  /**
+   * @brief Reorders log positions so that logs of the same partition are contiguous.
+   * @details
+   * Called from log mappers after partition_batch() for all storage types.
+   * Partition IDs are small integers, so this is a one-pass counting (radix) sort: a histogram
+   * of partitions, its prefix sum, and then a scatter. The order within each partition is
+   * preserved. This doesn't depend on the storage type, thus a static method.
+   */
+  static void group_by_partition(const GroupByPartitionArguments& args);
+
   /** Arguments for sort_batch() */
   struct SortBatchArguments {
     /** Converts from positions to physical pointers. */
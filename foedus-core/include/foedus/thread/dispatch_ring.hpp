@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_THREAD_DISPATCH_RING_HPP_
+#define FOEDUS_THREAD_DISPATCH_RING_HPP_
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "foedus/error_code.hpp"
+#include "foedus/proc/proc_id.hpp"
+#include "foedus/soc/shared_polling.hpp"
+#include "foedus/thread/thread_id.hpp"
+
+namespace foedus {
+namespace thread {
+
+/**
+ * @brief One procedure invocation in DispatchRing.
+ * @ingroup THREAD
+ * @details
+ * Input and output are inlined so that a dispatch needs no other shared memory.
+ * This is backed by shared memory. Not instantiated, just reinterpret_cast.
+ */
+struct DispatchSlot {
+  enum Constants {
+    /** Max byte size of the input of a dispatched procedure. */
+    kInputSize = 1 << 10,
+    /** Max byte size of the output of a dispatched procedure. */
+    kOutputSize = 1 << 11,
+  };
+  DispatchSlot() = delete;
+  ~DispatchSlot() = delete;
+
+  /**
+   * Who owns this slot, in the style of a bounded MPMC queue.
+   * position: free for the producer of the position.
+   * position + 1: queued, free for the consumer of the position.
+   * The slot becomes free for position + kSlots only after the client collects the result.
+   */
+  std::atomic<uint64_t> sequence_;
+  /** Set by the executing worker after it writes the result and output. */
+  std::atomic<bool>     completed_;
+  /** Result of the procedure. The detailed error stack is logged by the worker. */
+  ErrorCode             result_;
+  uint32_t              input_len_;
+  uint32_t              output_len_;
+  /** The worker that ran the procedure, which might be a different worker in the node. */
+  ThreadId              executed_by_;
+  proc::ProcName        proc_name_;
+  char                  input_[kInputSize];
+  char                  output_[kOutputSize];
+};
+
+/**
+ * @brief Lock-free queue of procedure invocations for one worker thread.
+ * @ingroup THREAD
+ * @details
+ * ThreadPool::impersonate() hands over exactly one task through ThreadControlBlock, and both
+ * the client and the worker sleep/wake on condition variables for each task.
+ * For short procedures, this round trip costs as much as the procedure itself.
+ * A dispatch ring instead lets clients (in any SOC) queue many invocations to a worker and
+ * collect their results later, possibly in batches.
+ *
+ * @par Protocol
+ * Clients claim a slot at the tail, write the procedure name and input, then publish it.
+ * The owner worker, or an idle worker in the same node (work stealing), claims the oldest
+ * published slot at the head, runs it, writes the result in the slot, and sets completed_.
+ * The slot remains occupied until the client collects the result, so a client that never
+ * collects eventually gets kErrorCodeThrDispatchRingFull.
+ *
+ * @par Polling
+ * A worker that has just run a dispatched task busy-polls its ring (and its peers' rings) for
+ * kBusyPollRounds rounds because more tasks likely follow. After that, it goes back to sleep on
+ * ThreadControlBlock::wakeup_cond_ unless its ring or a peer's ring has a queued task.
+ * dispatch() signals the owner worker and one idle peer in the same node, so that a task
+ * queued to a busy worker is stolen without waiting for the peer's sleep to time out.
+ *
+ * This is backed by shared memory. Not instantiated, just reinterpret_cast.
+ */
+struct DispatchRing {
+  enum Constants {
+    /** Number of slots in each ring. Must be a power of two. */
+    kSlots = 64,
+    /** A worker busy-polls for this number of rounds after it runs a dispatched task. */
+    kBusyPollRounds = 1 << 14,
+  };
+  DispatchRing() = delete;
+  ~DispatchRing() = delete;
+
+  void initialize();
+
+  /**
+   * Queues an invocation.
+   * @return kErrorCodeThrDispatchRingFull or kErrorCodeThrDispatchTooLarge if failed
+   */
+  ErrorCode       enqueue(
+    const proc::ProcName& proc_name,
+    const void* input,
+    uint32_t input_len,
+    uint64_t* position);
+  /**
+   * Claims the oldest queued invocation to run it.
+   * @return null if there is no queued invocation
+   */
+  DispatchSlot*   dequeue();
+  /** Called by the worker after it ran the invocation in the slot. */
+  void            complete(DispatchSlot* slot);
+  /** Called by the client after it read the result, which makes the slot reusable. */
+  void            release(uint64_t position);
+
+  /** Whether there might be a queued invocation. */
+  bool            has_queued() const {
+    return head_.load(std::memory_order_acquire) != tail_.load(std::memory_order_acquire);
+  }
+  DispatchSlot*   get_slot(uint64_t position) { return &slots_[position % kSlots]; }
+  const DispatchSlot* get_slot(uint64_t position) const { return &slots_[position % kSlots]; }
+  bool            is_completed(uint64_t position) const {
+    return get_slot(position)->completed_.load(std::memory_order_acquire);
+  }
+
+  /** Next position clients claim. On its own cacheline as all clients write to it. */
+  std::atomic<uint64_t> tail_;
+  char                  tail_padding_[64 - sizeof(std::atomic<uint64_t>)];
+  /** Next position workers claim. */
+  std::atomic<uint64_t> head_;
+  char                  head_padding_[64 - sizeof(std::atomic<uint64_t>)];
+  /** Workers signal this after completing an invocation in this ring. Clients wait on it. */
+  soc::SharedPolling    complete_cond_;
+  /** Number of invocations queued to this ring. */
+  std::atomic<uint64_t> stat_dispatched_;
+  /** Number of invocations in this ring run by another worker. */
+  std::atomic<uint64_t> stat_stolen_;
+
+  DispatchSlot          slots_[kSlots];
+};
+
+}  // namespace thread
+}  // namespace foedus
+#endif  // FOEDUS_THREAD_DISPATCH_RING_HPP_
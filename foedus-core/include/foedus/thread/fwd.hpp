@@ -25,8 +25,11 @@
  */
 namespace foedus {
 namespace thread {
+struct  DispatchRing;
+struct  DispatchSlot;
 struct  ImpersonateSession;
 class   Rendezvous;
+struct  SnapshotCacheScanScope;
 class   StoppableThread;
 class   Thread;
 struct  ThreadControlBlock;
@@ -96,6 +96,8 @@ class Thread CXX11_FINAL : public virtual Initializable {
   uint64_t      get_snapshot_cache_misses() const;
   /** [statistics] resets the above two */
   void          reset_snapshot_cache_counts() const;
+  /** [statistics] commit/abort counters of this thread, which precommit_xct() updates. */
+  xct::XctStatistics& get_xct_statistics();
 
   /** Shorthand for get_global_volatile_page_resolver.resolve_offset() */
   storage::Page* resolve(storage::VolatilePagePointer ptr) const;
@@ -139,6 +141,15 @@ class Thread CXX11_FINAL : public virtual Initializable {
     const storage::SnapshotPagePointer* page_ids,
     storage::Page** out);
 
+  /**
+   * Whether snapshot pages this thread newly reads are installed to the snapshot cache at
+   * a low priority, so that a scan does not flush the hot pages. Usually set via
+   * SnapshotCacheScanScope rather than directly.
+   * @see cache::CacheHashtable::install()
+   */
+  bool          is_snapshot_cache_scan() const;
+  void          set_snapshot_cache_scan(bool value);
+
   /**
    * Read a snapshot page using the thread-local file descriptor set.
    * @attention this method always READs, so no caching done. Actually, this method is used
@@ -270,8 +281,23 @@ class Thread CXX11_FINAL : public virtual Initializable {
    */
   void          collect_retired_volatile_page(storage::VolatilePagePointer ptr);
 
-  /** Unconditionally takes MCS lock on the given mcs_lock. */
+  /**
+   * Unconditionally takes MCS lock on the given mcs_lock.
+   * If the current transaction retains record locks taken during execution
+   * (see xct::Xct::lock_hot_record()), this method releases them before waiting for the lock.
+   */
   xct::McsBlockIndex  mcs_acquire_lock(xct::McsLock* mcs_lock);
+  /**
+   * Unconditionally takes MCS lock on the given mcs_lock, keeping the record locks the
+   * current transaction retains. The caller must make sure the lock comes after all of them
+   * in the canonical order. See xct::Xct::is_canonical_hot_lock_order().
+   */
+  xct::McsBlockIndex  mcs_acquire_lock_canonical(xct::McsLock* mcs_lock);
+  /**
+   * Takes MCS lock on the given mcs_lock only if it is not locked by anyone.
+   * @return MCS block index of the lock. 0 if the lock is held by someone else.
+   */
+  xct::McsBlockIndex  mcs_try_acquire_lock(xct::McsLock* mcs_lock);
   /**
    * Unconditionally takes multiple MCS locks.
    * @return MCS block index of the \e first lock acqired. As this is done in a row,
@@ -324,6 +350,25 @@ class Thread CXX11_FINAL : public virtual Initializable {
   ThreadPimpl*    pimpl_;
 };
 
+/**
+ * @brief Tags snapshot-page reads of the thread as a \e scan while this object is alive.
+ * @ingroup THREAD
+ * @details
+ * Cursors and bulk readers that touch many pages only once use this so that the pages they
+ * bring into the snapshot cache are evicted earlier than the hot working set.
+ * The previous value is restored on destruction, so nesting is fine.
+ */
+struct SnapshotCacheScanScope {
+  explicit SnapshotCacheScanScope(Thread* context)
+    : context_(context), previous_(context->is_snapshot_cache_scan()) {
+    context_->set_snapshot_cache_scan(true);
+  }
+  ~SnapshotCacheScanScope() { context_->set_snapshot_cache_scan(previous_); }
+
+  Thread* const context_;
+  const bool    previous_;
+};
+
 }  // namespace thread
 }  // namespace foedus
 #endif  // FOEDUS_THREAD_THREAD_HPP_
@@ -217,6 +217,19 @@ enum ThreadStatus {
   kTerminated,
 };
 
+/**
+ * @brief Identifies a procedure invocation queued by ThreadPool::dispatch().
+ * @ingroup THREAD
+ * @details
+ * A plain value. Pass it to ThreadPool::collect_dispatch() to receive the result.
+ */
+struct DispatchTicket {
+  /** The worker thread whose dispatch ring holds the invocation. */
+  ThreadId  thread_id_;
+  /** Position of the invocation in the ring. */
+  uint64_t  position_;
+};
+
 }  // namespace thread
 }  // namespace foedus
 #endif  // FOEDUS_THREAD_THREAD_ID_HPP_
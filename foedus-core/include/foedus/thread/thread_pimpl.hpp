@@ -37,6 +37,7 @@
 #include "foedus/thread/thread_id.hpp"
 #include "foedus/xct/xct.hpp"
 #include "foedus/xct/xct_id.hpp"
+#include "foedus/xct/xct_statistics.hpp"
 
 namespace foedus {
 namespace thread {
@@ -62,6 +63,7 @@ struct ThreadControlBlock {
     my_thread_id_ = my_thread_id;
     stat_snapshot_cache_hits_ = 0;
     stat_snapshot_cache_misses_ = 0;
+    stat_xct_.reset();
   }
   void uninitialize() {
     task_mutex_.uninitialize();
@@ -133,6 +135,9 @@ struct ThreadControlBlock {
 
   uint64_t            stat_snapshot_cache_hits_;
   uint64_t            stat_snapshot_cache_misses_;
+
+  /** Commit/abort counters of this thread. Only this thread writes to it. */
+  xct::XctStatistics  stat_xct_;
 };
 
 /**
@@ -163,6 +168,16 @@ class ThreadPimpl final : public DefaultInitializable {
    * it and re-sets current_task_ when it's done. It exists when exit_requested_ is set.
    */
   void        handle_tasks();
+  /** Sub-routine of handle_tasks() to run the task set by ThreadRef::try_impersonate(). */
+  void        run_impersonated_task();
+  /**
+   * Sub-routine of handle_tasks() to run one task in the dispatch ring of this thread, or of
+   * another thread in this node if this thread's ring is empty (work stealing).
+   * @return whether we ran a task
+   */
+  bool        run_dispatched_task();
+  /** Whether the dispatch ring of this thread or of a peer in this node has a queued task. */
+  bool        has_queued_dispatch();
   /** initializes the thread's policy/priority */
   void        set_thread_schedule();
   bool        is_stop_requested() const;
@@ -258,6 +273,10 @@ class ThreadPimpl final : public DefaultInitializable {
 
   /** Unconditionally takes MCS lock on the given mcs_lock. */
   xct::McsBlockIndex  mcs_acquire_lock(xct::McsLock* mcs_lock);
+  /** Same as above, but keeps locks taken during execution. */
+  xct::McsBlockIndex  mcs_acquire_lock_canonical(xct::McsLock* mcs_lock);
+  /** Takes MCS lock only if it's not locked. 0 if failed */
+  xct::McsBlockIndex  mcs_try_acquire_lock(xct::McsLock* mcs_lock);
   /** This doesn't use any atomic operation to take a lock. only allowed when there is no race */
   xct::McsBlockIndex  mcs_initial_lock(xct::McsLock* mcs_lock);
   /** Unlcok an MCS lock acquired by this thread. */
@@ -321,6 +340,11 @@ class ThreadPimpl final : public DefaultInitializable {
   cache::CacheHashtable*  snapshot_cache_hashtable_;
   /** shorthand for node_memory_->get_snapshot_pool() */
   memory::PagePool*       snapshot_page_pool_;
+  /**
+   * Whether snapshot pages this thread newly reads are installed at a low priority.
+   * @see SnapshotCacheScanScope
+   */
+  bool                    snapshot_cache_scan_;
 
   /** Page resolver to convert all page ID to page pointer. */
   memory::GlobalVolatilePageResolver global_volatile_page_resolver_;
@@ -354,6 +378,8 @@ class ThreadPimpl final : public DefaultInitializable {
   ThreadControlBlock*     control_block_;
   void*                   task_input_memory_;
   void*                   task_output_memory_;
+  /** Procedure invocations dispatched to this thread. */
+  DispatchRing*           dispatch_ring_;
 
   /** Pre-allocated MCS blocks. index 0 is not used so that successor_block=0 means null. */
   xct::McsBlock*          mcs_blocks_;
@@ -22,6 +22,7 @@
 #include <iosfwd>
 
 #include "foedus/cxx11.hpp"
+#include "foedus/error_code.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/initializable.hpp"
 #include "foedus/proc/proc_id.hpp"
@@ -111,6 +112,21 @@ namespace thread {
  *   return 0;
  * }
  * @endcode
+ *
+ * @section DISPATCH Dispatch
+ * For short procedures, the cost to wake up an impersonated thread and to wait for its completion
+ * is comparable to the procedure itself. ThreadPool#dispatch() instead queues invocations to
+ * a lock-free ring of each worker thread in shared memory, and the client collects the results
+ * later, by polling or in batches. Workers busy-poll the ring while invocations keep coming,
+ * and idle workers in the same NUMA node take invocations queued to busy workers.
+ * @code{.cpp}
+ * foedus::thread::DispatchTicket tickets[16];
+ * for (uint32_t i = 0; i < 16; ++i) {
+ *   COERCE_ERROR_CODE(pool->dispatch(core, "my_proc", &i, sizeof(i), tickets + i));
+ * }
+ * foedus::ErrorCode results[16];
+ * pool->collect_dispatches(16, tickets, results);
+ * @endcode
  */
 
 /**
@@ -233,6 +249,65 @@ class ThreadPool CXX11_FINAL : public virtual Initializable {
     return session.get_result();
   }
 
+  /**
+   * @brief Queues an invocation of the procedure to the given worker thread without waiting.
+   * @param[in] core the worker thread whose dispatch ring receives the invocation. An idle
+   * worker in the same NUMA node might run it instead.
+   * @param[in] proc_name the name of the procedure to run.
+   * @param[in] task_input input data of arbitrary format for the procedure.
+   * @param[in] task_input_size byte size of the input data, up to 1kb.
+   * @param[out] ticket identifies the invocation to collect its result.
+   * @details
+   * Unlike impersonate(), this doesn't occupy the worker thread. Clients can queue many
+   * invocations to the same worker and collect the results later, which avoids the wake-up
+   * round trip of impersonation for each short procedure.
+   * Each invocation must be collected by collect_dispatch() or collect_dispatches().
+   * Otherwise the ring eventually becomes full.
+   * The output of a dispatched procedure can be up to 2kb.
+   * @return kErrorCodeThrDispatchRingFull if the worker has too many uncollected invocations,
+   * kErrorCodeThrDispatchTooLarge if the input is too large.
+   */
+  ErrorCode dispatch(
+    ThreadId core,
+    const proc::ProcName& proc_name,
+    const void* task_input,
+    uint32_t task_input_size,
+    DispatchTicket* ticket);
+
+  /** Returns whether the dispatched invocation has completed. Never blocks. */
+  bool is_dispatch_completed(const DispatchTicket& ticket) const;
+
+  /**
+   * @brief Waits for the completion of the dispatched invocation and receives its result.
+   * @param[in] ticket the invocation
+   * @param[out] output_buffer receives the output of the procedure, up to output_buffer_size.
+   * Can be null if the output is not needed.
+   * @param[in] output_buffer_size byte size of output_buffer
+   * @param[out] output_size receives the byte size of the output. Can be null.
+   * @details
+   * The invocation is forgotten after this, so call this only once for each ticket.
+   * @return the error code of the procedure, kErrorCodeSessionExpired if the ticket was
+   * already collected, or kErrorCodeBeingShutdown if the workers are terminating before
+   * completing it.
+   */
+  ErrorCode collect_dispatch(
+    const DispatchTicket& ticket,
+    void* output_buffer = CXX11_NULLPTR,
+    uint32_t output_buffer_size = 0,
+    uint32_t* output_size = CXX11_NULLPTR);
+
+  /**
+   * @brief Batched version of collect_dispatch() without outputs.
+   * @param[in] count number of tickets
+   * @param[in] tickets the invocations
+   * @param[out] results receives the error code of each procedure
+   * @return number of invocations that returned kErrorCodeOk
+   */
+  uint32_t collect_dispatches(
+    uint32_t count,
+    const DispatchTicket* tickets,
+    ErrorCode* results);
+
   /** Returns the pimpl of this object. Use it only when you know what you are doing. */
   ThreadPoolPimpl*    get_pimpl() const { return pimpl_; }
 
@@ -20,6 +20,7 @@
 #include <iosfwd>
 #include <vector>
 
+#include "foedus/error_code.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/initializable.hpp"
 #include "foedus/memory/fwd.hpp"
@@ -63,6 +64,20 @@ class ThreadPoolPimpl final : public DefaultInitializable {
     uint64_t task_input_size,
     ImpersonateSession *session);
 
+  ErrorCode dispatch(
+    ThreadId core,
+    const proc::ProcName& proc_name,
+    const void* task_input,
+    uint32_t task_input_size,
+    DispatchTicket* ticket);
+  bool is_dispatch_completed(const DispatchTicket& ticket);
+  ErrorCode collect_dispatch(
+    const DispatchTicket& ticket,
+    void* output_buffer,
+    uint32_t output_buffer_size,
+    uint32_t* output_size);
+  uint32_t collect_dispatches(uint32_t count, const DispatchTicket* tickets, ErrorCode* results);
+
   ThreadGroupRef*     get_group(ThreadGroupId numa_node) { return &groups_[numa_node]; }
   ThreadGroup*        get_local_group() const { return local_group_; }
   ThreadRef*          get_thread(ThreadId id);
@@ -23,6 +23,7 @@
 
 #include "foedus/cxx11.hpp"
 #include "foedus/epoch.hpp"
+#include "foedus/error_code.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/proc/proc_id.hpp"
 #include "foedus/thread/fwd.hpp"
@@ -55,6 +56,16 @@ class ThreadRef CXX11_FINAL {
     uint64_t task_input_size,
     ImpersonateSession *session);
 
+  /**
+   * Queues an invocation of the procedure to the dispatch ring of this thread.
+   * @see ThreadPool::dispatch()
+   */
+  ErrorCode     dispatch(
+    const proc::ProcName& proc_name,
+    const void* task_input,
+    uint32_t task_input_size,
+    DispatchTicket* ticket);
+
   Engine*       get_engine() const { return engine_; }
   ThreadId      get_thread_id() const { return id_; }
   ThreadGroupId get_numa_node() const { return decompose_numa_node(id_); }
@@ -62,6 +73,7 @@ class ThreadRef CXX11_FINAL {
   void*         get_task_output_memory() const { return task_output_memory_; }
   xct::McsBlock* get_mcs_blocks() const { return mcs_blocks_; }
   ThreadControlBlock* get_control_block() const { return control_block_; }
+  DispatchRing* get_dispatch_ring() const { return dispatch_ring_; }
 
   /** @see foedus::xct::InCommitEpochGuard  */
   Epoch         get_in_commit_epoch() const;
@@ -69,6 +81,8 @@ class ThreadRef CXX11_FINAL {
   uint64_t      get_snapshot_cache_hits() const;
   uint64_t      get_snapshot_cache_misses() const;
   void          reset_snapshot_cache_counts() const;
+  const xct::XctStatistics& get_xct_statistics() const;
+  void          reset_xct_statistics() const;
 
   friend std::ostream& operator<<(std::ostream& o, const ThreadRef& v);
 
@@ -84,6 +98,9 @@ class ThreadRef CXX11_FINAL {
 
   /** Pre-allocated MCS blocks. index 0 is not used so that successor_block=0 means null. */
   xct::McsBlock*        mcs_blocks_;
+
+  /** Procedure invocations dispatched to this thread. */
+  DispatchRing*         dispatch_ring_;
 };
 
 
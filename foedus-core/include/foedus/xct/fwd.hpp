@@ -24,6 +24,7 @@
  */
 namespace foedus {
 namespace xct {
+struct  HotLockAccess;
 struct  InCommitEpochGuard;
 struct  LockableXctId;
 struct  LockFreeWriteXctAccess;
@@ -38,6 +39,7 @@ struct  XctId;
 class   XctManager;
 struct  XctManagerControlBlock;
 class   XctManagerPimpl;
+struct  XctStatistics;
 }  // namespace xct
 }  // namespace foedus
 #endif  // FOEDUS_XCT_FWD_HPP_
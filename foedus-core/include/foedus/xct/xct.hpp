@@ -59,6 +59,8 @@ class Xct {
   enum Constants {
     kMaxPointerSets = 1024,
     kMaxPageVersionSets = 1024,
+    /** Maximum number of record locks a transaction takes during execution. */
+    kMaxHotLocks = 256,
   };
 
   Xct(Engine* engine, thread::ThreadId thread_id);
@@ -67,7 +69,10 @@ class Xct {
   Xct(const Xct& other) CXX11_FUNC_DELETE;
   Xct& operator=(const Xct& other) CXX11_FUNC_DELETE;
 
-  void initialize(memory::NumaCoreMemory* core_memory, uint32_t* mcs_block_current);
+  void initialize(
+    thread::Thread* context,
+    memory::NumaCoreMemory* core_memory,
+    uint32_t* mcs_block_current);
 
   /**
    * Begins the transaction.
@@ -81,6 +86,8 @@ class Xct {
     read_set_size_ = 0;
     write_set_size_ = 0;
     lock_free_write_set_size_ = 0;
+    hot_lock_set_size_ = 0;
+    hot_lock_max_address_ = 0;
     *mcs_block_current_ = 0;
     local_work_memory_cur_ = 0;
   }
@@ -90,6 +97,7 @@ class Xct {
    */
   void                deactivate() {
     ASSERT_ND(active_);
+    ASSERT_ND(hot_lock_set_size_ == 0);
     active_ = false;
     *mcs_block_current_ = 0;
   }
@@ -113,11 +121,13 @@ class Xct {
   uint32_t            get_read_set_size() const { return read_set_size_; }
   uint32_t            get_write_set_size() const { return write_set_size_; }
   uint32_t            get_lock_free_write_set_size() const { return lock_free_write_set_size_; }
+  uint32_t            get_hot_lock_set_size() const { return hot_lock_set_size_; }
   const PointerAccess*   get_pointer_set() const { return pointer_set_; }
   const PageVersionAccess*  get_page_version_set() const { return page_version_set_; }
   ReadXctAccess*      get_read_set()  { return read_set_; }
   WriteXctAccess*     get_write_set() { return write_set_; }
   LockFreeWriteXctAccess* get_lock_free_write_set() { return lock_free_write_set_; }
+  const HotLockAccess*    get_hot_lock_set() const { return hot_lock_set_; }
 
 
   /**
@@ -230,6 +240,65 @@ class Xct {
     storage::StorageId storage_id,
     log::RecordLogType* log_entry);
 
+  /**
+   * @returns whether the record is in a page hot enough to lock it during execution.
+   * When the feature is disabled, this doesn't even look at the page header.
+   * @see XctOptions::hot_threshold_
+   */
+  bool                is_hot_record(const LockableXctId* owner_id_address) const ALWAYS_INLINE {
+    return hot_threshold_ <= storage::kMaxPageHotness
+      && storage::to_page(owner_id_address)->get_header().is_hot(hot_threshold_);
+  }
+
+  /**
+   * @brief Locks the given record during execution because it is in a hot page.
+   * @details
+   * Only writes take the lock. Records have only exclusive locks, so locking reads would
+   * serialize read-only transactions against each other. Reads stay optimistic.
+   * The lock is kept until the end of this transaction, so that other transactions can't
+   * modify the record in the meantime. This does not replace read-set/write-set. The commit
+   * protocol still verifies them as usual, but it will not fail on this record.
+   *
+   * Unlike commit-time locking, we can't sort the records to lock. To avoid deadlocks,
+   * we wait for the lock only when the record comes after all records we have locked so far
+   * in the canonical (address) order. Otherwise, we just try the lock once.
+   * If it fails, or if we already have kMaxHotLocks locks, we simply stay optimistic
+   * for this record.
+   */
+  void                lock_hot_record(LockableXctId* owner_id_address);
+
+  /** @returns whether this transaction retains a lock on the record taken during execution */
+  bool                is_hot_locked(const LockableXctId* owner_id_address) const;
+
+  /**
+   * @returns whether this transaction can unconditionally wait for a lock on the record
+   * without risking deadlocks, which means the record comes after all records this transaction
+   * retains hot locks on.
+   */
+  bool                is_canonical_hot_lock_order(
+    const LockableXctId* owner_id_address) const ALWAYS_INLINE {
+    return hot_lock_set_size_ == 0
+      || reinterpret_cast<uintptr_t>(owner_id_address) > hot_lock_max_address_;
+  }
+
+  /**
+   * @brief Passes the ownership of the lock on the record to the caller, a write-set.
+   * @return the MCS block index of the lock. 0 if this transaction doesn't retain the lock.
+   * @details
+   * The caller is responsible for releasing the lock afterwards.
+   */
+  McsBlockIndex       take_over_hot_lock(const LockableXctId* owner_id_address);
+
+  /**
+   * @brief Gives up the lock taken during execution, if any, on the given lock.
+   * @details
+   * The system transaction that is about to lock it calls this to avoid self-deadlock.
+   */
+  void                release_hot_lock(const McsLock* lock);
+
+  /** Releases all locks taken during execution, except ones taken over by write-sets. */
+  void                release_hot_locks();
+
   void                remember_previous_xct_id(XctId new_id) {
     ASSERT_ND(id_.before(new_id));
     id_ = new_id;
@@ -278,9 +347,15 @@ class Xct {
    */
   XctId               id_;
 
+  /** The thread that runs this transaction */
+  thread::Thread*     context_;
+
   /** Level of isolation for this transaction. */
   IsolationLevel      isolation_level_;
 
+  /** Copy of XctOptions::hot_threshold_ */
+  uint16_t            hot_threshold_;
+
   /** Whether the object is an active transaction. */
   bool                active_;
 
@@ -316,6 +391,11 @@ class Xct {
   PageVersionAccess*  page_version_set_;
   uint32_t            page_version_set_size_;
 
+  HotLockAccess*      hot_lock_set_;
+  uint32_t            hot_lock_set_size_;
+  /** Largest address in hot_lock_set_. Valid only when hot_lock_set_size_ > 0. */
+  uintptr_t           hot_lock_max_address_;
+
   void*               local_work_memory_;
   uint64_t            local_work_memory_size_;
   /** This value is reset to zero for each transaction, and always <= local_work_memory_size_ */
@@ -432,6 +512,10 @@ inline ErrorCode Xct::add_to_write_set(
   log::invoke_assert_valid(log_entry);
 #endif  // NDEBUG
 
+  if (isolation_level_ == kSerializable && UNLIKELY(is_hot_record(owner_id_address))) {
+    lock_hot_record(owner_id_address);
+  }
+
   write_set_[write_set_size_].storage_id_ = storage_id;
   write_set_[write_set_size_].mcs_block_ = 0;
   write_set_[write_set_size_].write_set_ordinal_ = write_set_size_;
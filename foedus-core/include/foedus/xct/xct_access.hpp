@@ -183,6 +183,26 @@ struct LockFreeWriteXctAccess {
   // no need for compare method or storing version/record/etc. it's lock-free!
 };
 
+/**
+ * @brief Represents a record lock a serializable transaction took during its execution
+ * because the record is in a hot page.
+ * @ingroup XCT
+ * @see Xct::lock_hot_record()
+ */
+struct HotLockAccess {
+  friend std::ostream& operator<<(std::ostream& o, const HotLockAccess& v);
+
+  /** Pointer to the locked record. */
+  LockableXctId*        owner_id_address_;
+
+  /**
+   * The MCS block index for the lock.
+   * 0 if the lock is now owned by a write-set of the same record (see
+   * Xct::take_over_hot_lock()) or if we have given up the lock.
+   */
+  McsBlockIndex         mcs_block_;
+};
+
 inline bool ReadXctAccess::compare(const ReadXctAccess &left, const ReadXctAccess& right) {
   return reinterpret_cast<uintptr_t>(left.owner_id_address_)
     < reinterpret_cast<uintptr_t>(right.owner_id_address_);
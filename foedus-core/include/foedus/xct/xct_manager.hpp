@@ -17,6 +17,8 @@
  */
 #ifndef FOEDUS_XCT_XCT_MANAGER_HPP_
 #define FOEDUS_XCT_XCT_MANAGER_HPP_
+#include "foedus/epoch.hpp"
+#include "foedus/error_code.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/initializable.hpp"
 #include "foedus/thread/fwd.hpp"
@@ -24,6 +26,19 @@
 #include "foedus/xct/xct_id.hpp"
 namespace foedus {
 namespace xct {
+/**
+ * @brief A function the commit notifier invokes for a transaction registered via
+ * XctManager::register_commit_callback().
+ * @param[in] result kErrorCodeOk when the durable global epoch has reached commit_epoch.
+ * kErrorCodeXctCommitCallbackCancelled when the engine shut down before that.
+ * @param[in] commit_epoch the commit epoch given to register_commit_callback()
+ * @param[in] user_data the opaque pointer given to register_commit_callback()
+ * @details
+ * The callback is invoked on the commit notifier thread, not on the worker thread.
+ * It must return quickly because it delays all other callbacks in the same batch.
+ */
+typedef void (*CommitCallback)(ErrorCode result, Epoch commit_epoch, void* user_data);
+
 /**
  * @brief Xct Manager class that provides API to begin/abort/commit transaction.
  * @ingroup XCT
@@ -103,6 +118,30 @@ class XctManager CXX11_FINAL : public virtual Initializable {
    */
   ErrorCode   wait_for_commit(Epoch commit_epoch, int64_t wait_microseconds = -1);
 
+  /**
+   * @brief Asynchronously notifies the given callback when the commit epoch becomes durable.
+   * @param[in] context Thread context of the worker that precommitted the transaction
+   * @param[in] commit_epoch commit epoch returned by precommit_xct()
+   * @param[in] callback invoked once the durable global epoch reaches commit_epoch
+   * @param[in] user_data opaque pointer passed to callback as it is
+   * @return kErrorCodeXctCommitCallbackCancelled if the engine is shutting down, in which case
+   * the callback is never invoked.
+   * @details
+   * This is the \e group-commit alternative to wait_for_commit().
+   * Instead of blocking the worker thread until the epoch becomes durable, the worker registers
+   * a callback and moves on to its next transaction right away.
+   * The commit notifier thread of the worker's SOC waits for each advancement of the durable
+   * global epoch and fires all callbacks that became durable in one batch.
+   * So, there is only one waiter per SOC, rather than one per in-flight commit.
+   * This method does not request an immediate epoch advancement. Transactions are made durable
+   * with the regular epoch advancement, or earlier with XctOptions::epoch_advance_min_interval_ms_.
+   */
+  ErrorCode   register_commit_callback(
+    thread::Thread* context,
+    Epoch commit_epoch,
+    CommitCallback callback,
+    void* user_data);
+
   /**
    * @brief Aborts the currently running transaction on the thread.
    * @param[in,out] context Thread context
@@ -18,7 +18,9 @@
 #ifndef FOEDUS_XCT_XCT_MANAGER_PIMPL_HPP_
 #define FOEDUS_XCT_XCT_MANAGER_PIMPL_HPP_
 #include <atomic>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include "foedus/epoch.hpp"
 #include "foedus/fwd.hpp"
@@ -30,6 +32,7 @@
 #include "foedus/thread/stoppable_thread_impl.hpp"
 #include "foedus/xct/fwd.hpp"
 #include "foedus/xct/xct_id.hpp"
+#include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
 namespace xct {
@@ -43,6 +46,7 @@ struct XctManagerControlBlock {
     current_global_epoch_advanced_.initialize();
     epoch_chime_wakeup_.initialize();
     new_transaction_paused_ = false;
+    commit_callbacks_pending_ = 0;
   }
   void uninitialize() {
   }
@@ -86,6 +90,25 @@ struct XctManagerControlBlock {
    * This is used only once per several minutes, so no need for optimization. Keep it simple!
    */
   std::atomic<bool>                 new_transaction_paused_;
+
+  /**
+   * Number of commit callbacks registered in all SOCs that are not invoked yet.
+   * The epoch chime checks this to adaptively advance epochs.
+   * @see XctOptions::epoch_advance_min_interval_ms_
+   */
+  std::atomic<uint64_t>             commit_callbacks_pending_;
+};
+
+/** A commit callback waiting in the commit notifier until its commit epoch becomes durable. */
+struct PendingCommitCallback {
+  Epoch           commit_epoch_;
+  CommitCallback  callback_;
+  void*           user_data_;
+
+  /** For std::push_heap/pop_heap, which put the \e largest one at front. */
+  static bool later_than(const PendingCommitCallback& left, const PendingCommitCallback& right) {
+    return left.commit_epoch_ > right.commit_epoch_;
+  }
 };
 
 /**
@@ -120,6 +143,10 @@ class XctManagerPimpl final : public DefaultInitializable {
   ErrorCode   abort_xct(thread::Thread* context);
 
   ErrorCode   wait_for_commit(Epoch commit_epoch, int64_t wait_microseconds);
+  ErrorCode   register_commit_callback(
+    Epoch commit_epoch,
+    CommitCallback callback,
+    void* user_data);
   void        set_requested_global_epoch(Epoch request);
   void        advance_current_global_epoch();
   void        wait_for_current_global_epoch(Epoch target_epoch, int64_t wait_microseconds);
@@ -194,10 +221,38 @@ class XctManagerPimpl final : public DefaultInitializable {
    * This method exits when this object's uninitialize() is called.
    */
   void        handle_epoch_chime();
+  /**
+   * @brief Sleeps in the epoch chime when XctOptions::epoch_advance_min_interval_ms_ is enabled.
+   * @details
+   * Sleeps min_interval_microsec at a time, up to interval_microsec in total.
+   * Returns early when someone requests an immediate advancement, or when some commit callback
+   * is waiting while all loggers are idle.
+   */
+  void        handle_epoch_chime_wait_adaptive(
+    uint64_t interval_microsec,
+    uint64_t min_interval_microsec);
+  /** Whether loggers have made all loggable epochs (current global epoch - 2) durable. */
+  bool        are_loggers_idle() const;
   /** Makes sure all worker threads will commit with an epoch larger than grace_epoch. */
   void        handle_epoch_chime_wait_grace_period(Epoch grace_epoch);
   bool        is_stop_requested() const;
 
+  /**
+   * @brief Main routine for commit_notifier_thread_.
+   * @details
+   * Waits for each advancement of the durable global epoch and invokes all commit callbacks
+   * whose commit epoch became durable.
+   * Upon uninitialize(), invokes the remaining callbacks with
+   * kErrorCodeXctCommitCallbackCancelled (or kErrorCodeOk if they became durable meanwhile).
+   */
+  void        handle_commit_notifier();
+  /**
+   * Pops all commit callbacks whose commit epoch is durable_epoch or older, or all of them
+   * if durable_epoch is invalid, and then invokes them with the given result.
+   * @return commit epoch of the oldest remaining callback. Invalid if there is none.
+   */
+  Epoch       invoke_commit_callbacks(Epoch durable_epoch, ErrorCode result);
+
   /** Pause all begin_xct until you call resume_accepting_xct() */
   void        pause_accepting_xct();
   /** Make sure you call this after pause_accepting_xct(). */
@@ -212,6 +267,21 @@ class XctManagerPimpl final : public DefaultInitializable {
    * Launched only in master engine.
    */
   std::thread epoch_chime_thread_;
+
+  /**
+   * This thread invokes commit callbacks registered in this engine.
+   * Launched only in SOC engines, namely one thread per NUMA node.
+   */
+  std::thread                         commit_notifier_thread_;
+  std::atomic<bool>                   commit_notifier_stop_requested_;
+  /** Protects commit_callbacks_ */
+  std::mutex                          commit_callbacks_mutex_;
+  /** Heap of commit callbacks, ordered by PendingCommitCallback::later_than. */
+  std::vector<PendingCommitCallback>  commit_callbacks_;
+  /** Number of entries in commit_callbacks_, readable without the mutex. */
+  std::atomic<uint32_t>               commit_callbacks_count_;
+  /** Fired when commit_callbacks_ becomes non-empty or the notifier is requested to stop. */
+  thread::ConditionVariable           commit_callbacks_registered_;
 };
 static_assert(
   sizeof(XctManagerControlBlock) <= soc::GlobalMemoryAnchors::kXctManagerMemorySize,
@@ -45,6 +45,12 @@ struct XctOptions CXX11_FINAL : public virtual externalize::Externalizable {
     kDefaultLocalWorkMemorySizeMb = 2,
     /** Default value for epoch_advance_interval_ms_. */
     kDefaultEpochAdvanceIntervalMs = 20,
+    /** Default value for epoch_advance_min_interval_ms_. 0 disables adaptive advancement. */
+    kDefaultEpochAdvanceMinIntervalMs = 0,
+    /** A value for hot_threshold_ that disables locking during execution. */
+    kHotThresholdNever = 256,
+    /** Default value for hot_threshold_. Disabled until we measure a good value. */
+    kDefaultHotThreshold = kHotThresholdNever,
   };
 
   /**
@@ -97,6 +103,41 @@ struct XctOptions CXX11_FINAL : public virtual externalize::Externalizable {
    * until the epoch advances.
    */
   uint32_t    epoch_advance_interval_ms_;
+
+  /**
+   * @brief Minimal intervals in milliseconds between \e adaptive epoch advancements.
+   * @details
+   * Default is 0, which disables adaptive epoch advancement.
+   * When this value is positive and smaller than epoch_advance_interval_ms_, the epoch chime
+   * checks every this milliseconds whether some commit callback (see
+   * XctManager::register_commit_callback()) is waiting while all loggers are idle, namely
+   * they have already made all loggable epochs durable.
+   * If so, it advances the epoch without waiting for epoch_advance_interval_ms_, which cuts
+   * the latency of durable commits in a lightly loaded engine.
+   * When loggers are busy, epochs keep advancing every epoch_advance_interval_ms_ so that
+   * commits are batched as usual.
+   */
+  uint32_t    epoch_advance_min_interval_ms_;
+
+  /**
+   * @brief Page hotness above which serializable transactions lock records during execution.
+   * @details
+   * Default is kHotThresholdNever, which disables this feature. Each abort due to a changed
+   * record increments the hotness of the page that contains the record
+   * (storage::PageHeader::hotness_), and each snapshot halves it.
+   * When a serializable transaction writes a record in a page whose hotness is this
+   * value or more, it takes the record lock right away and keeps it until the end of the
+   * transaction, rather than taking it only at commit time.
+   * This prevents other transactions from changing the record during the execution,
+   * so it avoids repeated aborts on highly contended records.
+   * Reads stay optimistic because records have only exclusive locks. Locking them would
+   * serialize read-only transactions on hot pages.
+   * The transaction still verifies its read-set at commit time as usual.
+   * kHotThresholdNever (or any value larger than 255) disables this feature.
+   * 0 makes every serializable transaction lock all records it writes, which is
+   * mostly for testing.
+   */
+  uint16_t    hot_threshold_;
 };
 }  // namespace xct
 }  // namespace foedus
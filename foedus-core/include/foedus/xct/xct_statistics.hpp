@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_XCT_XCT_STATISTICS_HPP_
+#define FOEDUS_XCT_XCT_STATISTICS_HPP_
+
+#include <stdint.h>
+
+#include <cstring>
+#include <iosfwd>
+
+#include "foedus/debugging/latency_histogram.hpp"
+#include "foedus/log/log_type.hpp"
+
+namespace foedus {
+namespace xct {
+
+/**
+ * @brief Why precommit_xct() or the user aborted a transaction.
+ * @ingroup XCT
+ */
+enum AbortReason {
+  /** A record in the read set was modified by another transaction. */
+  kAbortReasonReadSetChanged = 0,
+  /** A record moved (split/next-layer) and we could not track where it went. */
+  kAbortReasonRecordMoved,
+  /** A record was locked by another transaction, or an out-of-order try-lock failed. */
+  kAbortReasonLockConflict,
+  /** A blind write hit a record that was concurrently deleted. */
+  kAbortReasonDeletedRecord,
+  /** A volatile pointer in the pointer set was changed. */
+  kAbortReasonPointerSetChanged,
+  /** A page version in the page version set was changed. */
+  kAbortReasonPageVersionSetChanged,
+  /** The user called abort_xct(). */
+  kAbortReasonUser,
+  kAbortReasonCount,
+};
+
+/** Returns a short name of the abort reason for reporting. */
+const char* get_abort_reason_name(AbortReason reason);
+
+/**
+ * @brief Per-thread counters of transaction outcomes.
+ * @ingroup XCT
+ * @details
+ * Each worker thread has its own instance in its ThreadControlBlock, so counting needs neither
+ * atomics nor locks. Because the control block is in shared memory, any SOC engine can read
+ * (and sum up) the counters of all threads while they are running.
+ * See foedus::debugging::EngineStatistics for the aggregated view.
+ */
+struct XctStatistics {
+  enum Constants {
+    /**
+     * Record log codes (see log_type.xmacro) are 0x00XX. We count applied logs by the lower
+     * bits of the code, which tells both the storage type and the operation.
+     */
+    kLogCodeSlots = 64,
+  };
+
+  void      reset() { std::memset(this, 0, sizeof(*this)); }
+  /** Adds all counters in the other object to this object. */
+  void      add(const XctStatistics& other);
+
+  uint64_t  get_commits() const { return committed_readonly_ + committed_readwrite_; }
+  uint64_t  get_aborts() const {
+    uint64_t ret = 0;
+    for (uint16_t i = 0; i < kAbortReasonCount; ++i) {
+      ret += aborts_[i];
+    }
+    return ret;
+  }
+
+  void      record_abort(AbortReason reason) { ++aborts_[reason]; }
+  void      record_applied_log(log::LogCode code) {
+    ++applied_logs_[static_cast<uint16_t>(code) % kLogCodeSlots];
+  }
+
+  /** Writes counters in XML. Applied logs are reported by log type name. */
+  friend std::ostream& operator<<(std::ostream& o, const XctStatistics& v);
+  /** Same as above in a JSON object. */
+  void      describe_json(std::ostream* o) const;
+
+  uint64_t  committed_readonly_;
+  uint64_t  committed_readwrite_;
+  uint64_t  aborts_[kAbortReasonCount];
+  /** Number of record logs applied by committed transactions, indexed by code % kLogCodeSlots */
+  uint64_t  applied_logs_[kLogCodeSlots];
+  /** CPU cycles (RDTSC) spent in precommit_xct(), whether it committed or aborted. */
+  debugging::LatencyHistogram precommit_cycles_;
+};
+
+}  // namespace xct
+}  // namespace foedus
+#endif  // FOEDUS_XCT_XCT_STATISTICS_HPP_
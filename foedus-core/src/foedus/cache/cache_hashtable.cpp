@@ -20,6 +20,8 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <cstring>
 #include <ostream>
 
 #include "foedus/assorted/assorted_func.hpp"
@@ -57,6 +59,18 @@ uint32_t determine_overflow_list_size(BucketId physical_buckets) {
   return overflow_size;
 }
 
+uint32_t determine_ghost_count(BucketId physical_buckets) {
+  // The hashtable has 16x-ish more buckets than pages. The ghost history should remember
+  // about as many evicted pages as the cache holds, like A1out of 2Q. Power of 2 for masking.
+  const uint32_t kGhostFraction = 16U;
+  const uint32_t kGhostMinSize = 256U;
+  uint32_t ghost_count = kGhostMinSize;
+  while (ghost_count * 2U <= physical_buckets / kGhostFraction) {
+    ghost_count *= 2U;
+  }
+  return ghost_count;
+}
+
 HashFunc::HashFunc(BucketId physical_buckets)
   : logical_buckets_(determine_logical_buckets(physical_buckets)),
     physical_buckets_(physical_buckets),
@@ -67,7 +81,8 @@ CacheHashtable::CacheHashtable(BucketId physical_buckets, uint16_t numa_node)
   : numa_node_(numa_node),
   overflow_buckets_count_(determine_overflow_list_size(physical_buckets)),
   hash_func_(physical_buckets),
-  clockhand_(0) {
+  clockhand_(0),
+  ghost_admissions_(0) {
   buckets_memory_.alloc(
     sizeof(CacheBucket) * physical_buckets,
     1U << 21,
@@ -108,10 +123,39 @@ CacheHashtable::CacheHashtable(BucketId physical_buckets, uint16_t numa_node)
       overflow_buckets_[i].next_ = 0;
     }
   }
+
+  // for ghost history
+  uint32_t ghost_count = determine_ghost_count(physical_buckets);
+  ghost_memory_.alloc(
+    sizeof(PageIdTag) * ghost_count,
+    1U << 21,
+    memory::AlignedMemory::kNumaAllocOnnode,
+    numa_node);
+  ghost_tags_ = reinterpret_cast<PageIdTag*>(ghost_memory_.get_block());
+  ghost_mask_ = ghost_count - 1U;
+  std::memset(ghost_tags_, 0, sizeof(PageIdTag) * ghost_count);
 }
 
+uint16_t CacheHashtable::determine_initial_refcount(PageIdTag tag, bool scan) {
+  if (scan) {
+    // we don't even check the ghost. a repeated scan should not promote its pages.
+    return kInitialRefCount;
+  }
+  PageIdTag* ghost = ghost_tags_ + (tag & ghost_mask_);
+  if (*ghost == tag) {
+    // evicted recently and requested again. it's likely in the working set.
+    *ghost = 0;
+    ++ghost_admissions_;
+    return kGhostInitialRefCount;
+  }
+  return kInitialRefCount;
+}
 
-ErrorCode CacheHashtable::install(storage::SnapshotPagePointer page_id, ContentId content) {
+
+ErrorCode CacheHashtable::install(
+  storage::SnapshotPagePointer page_id,
+  ContentId content,
+  bool scan) {
   ASSERT_ND(content != 0);
 
   // Grab a bucket to install a new page.
@@ -123,6 +167,7 @@ ErrorCode CacheHashtable::install(storage::SnapshotPagePointer page_id, ContentI
 
   CacheBucket new_bucket;
   new_bucket.reset(content, tag);
+  const uint16_t initial_refcount = determine_initial_refcount(tag, scan);
 
   // An opportunistic optimization. if the exact bucket already has the same page_id,
   // most likely someone else is trying to install it at the same time. let's wait.
@@ -130,7 +175,7 @@ ErrorCode CacheHashtable::install(storage::SnapshotPagePointer page_id, ContentI
     if (!buckets_[bucket].is_content_set()) {
       // looks like this is empty!
       buckets_[bucket] = new_bucket;  // 8-byte implicitly-atomic write
-      refcounts_[bucket].count_ = 1;
+      refcounts_[bucket].count_ = initial_refcount;
       // this might be immediately overwritten by someone else, but that's fine.
       // that only causes a future cache miss. no correctness issue.
       return kErrorCodeOk;
@@ -161,7 +206,7 @@ ErrorCode CacheHashtable::install(storage::SnapshotPagePointer page_id, ContentI
   ASSERT_ND(new_overflow_entry < overflow_buckets_count_);
   overflow_free_buckets_head_ = overflow_buckets_[new_overflow_entry].next_;
   overflow_buckets_[new_overflow_entry].next_ = overflow_buckets_head_;
-  overflow_buckets_[new_overflow_entry].refcount_.count_ = 1;
+  overflow_buckets_[new_overflow_entry].refcount_.count_ = initial_refcount;
   overflow_buckets_[new_overflow_entry].bucket_ = new_bucket;
   assorted::memory_fence_release();
   overflow_buckets_head_ = new_overflow_entry;
@@ -206,7 +251,8 @@ void CacheHashtable::evict(CacheHashtable::EvictArgs* args) {
   clockhand_ = cur;
   LOG(INFO) << "Snapshot-Cache eviction completed at node-" << numa_node_
     << ", clockhand_=" << clockhand_ << ", #evicted=" << args->evicted_count_
-    << ", looped-over the whole hashtable for " << loops << " times";
+    << ", looped-over the whole hashtable for " << loops << " times"
+    << ", #ghost_admissions=" << ghost_admissions_;
 }
 
 BucketId CacheHashtable::evict_main_loop(
@@ -256,6 +302,7 @@ BucketId CacheHashtable::evict_main_loop(
           bool still_non_zero = base[i].decrement(decrements);
           if (!still_non_zero) {
             args->add_evicted(buckets_[bucket + i].get_content_id());
+            add_ghost(buckets_[bucket + i].get_tag());
             buckets_[bucket + i].data_ = 0;
           }
         }
@@ -298,6 +345,7 @@ void CacheHashtable::evict_overflow_loop(CacheHashtable::EvictArgs* args, uint16
         bool still_non_zero = cur_entry->refcount_.decrement(decrements);
         if (!still_non_zero) {
           args->add_evicted(cur_entry->bucket_.get_content_id());
+          add_ghost(cur_entry->bucket_.get_tag());
           CacheOverflowEntry* prev_entry = overflow_buckets_ + prev;
           prev_entry->next_ = next;
           cur_entry->bucket_.data_ = 0;
@@ -315,6 +363,7 @@ void CacheHashtable::evict_overflow_loop(CacheHashtable::EvictArgs* args, uint16
       bool still_non_zero = cur_entry->refcount_.decrement(decrements);
       if (!still_non_zero) {
         args->add_evicted(cur_entry->bucket_.get_content_id());
+        add_ghost(cur_entry->bucket_.get_tag());
         overflow_buckets_head_ = cur_entry->next_;
         cur_entry->bucket_.data_ = 0;
         cur_entry->next_ = evicted_head;
@@ -372,6 +421,66 @@ CacheHashtable::Stat CacheHashtable::get_stat_single_thread() const {
   return result;
 }
 
+/** Position of the highest bit, 0-15. count must be non-zero. */
+inline uint16_t get_refcount_level(uint16_t count) {
+  ASSERT_ND(count > 0);
+  return 31 - __builtin_clz(count);
+}
+
+uint32_t CacheHashtable::collect_hot_contents(
+  uint16_t min_refcount,
+  uint32_t max_count,
+  ContentId* out) const {
+  ASSERT_ND(min_refcount > 0);
+  // First, a histogram of refcounts in powers of 2 to determine the threshold.
+  const uint16_t kLevels = 16;
+  uint64_t candidates[kLevels];
+  std::memset(candidates, 0, sizeof(candidates));
+  const BucketId end = get_physical_buckets();
+  for (BucketId i = 0; i < end; ++i) {
+    uint16_t count = refcounts_[i].count_;
+    if (count >= min_refcount && buckets_[i].is_content_set()) {
+      ++candidates[get_refcount_level(count)];
+    }
+  }
+  for (OverflowPointer i = overflow_buckets_head_; i != 0; i = overflow_buckets_[i].next_) {
+    uint16_t count = overflow_buckets_[i].refcount_.count_;
+    if (count >= min_refcount && overflow_buckets_[i].bucket_.is_content_set()) {
+      ++candidates[get_refcount_level(count)];
+    }
+  }
+
+  uint32_t threshold = min_refcount;
+  uint64_t total = 0;
+  for (int16_t level = kLevels - 1; level >= 0; --level) {
+    total += candidates[level];
+    if (total > max_count) {
+      uint32_t level_threshold = 1U << std::min<int16_t>(level + 1, kLevels - 1);
+      threshold = std::max<uint32_t>(threshold, level_threshold);
+      break;
+    }
+  }
+
+  // Then collect them. Because of races, we might see more than max_count. Just stop there.
+  uint32_t collected = 0;
+  for (BucketId i = 0; i < end && collected < max_count; ++i) {
+    ContentId content = buckets_[i].get_content_id();
+    if (refcounts_[i].count_ >= threshold && content != 0) {
+      out[collected] = content;
+      ++collected;
+    }
+  }
+  for (OverflowPointer i = overflow_buckets_head_;
+      i != 0 && collected < max_count;
+      i = overflow_buckets_[i].next_) {
+    ContentId content = overflow_buckets_[i].bucket_.get_content_id();
+    if (overflow_buckets_[i].refcount_.count_ >= threshold && content != 0) {
+      out[collected] = content;
+      ++collected;
+    }
+  }
+  return collected;
+}
 
 ErrorCode CacheHashtable::find_batch(
   uint16_t batch_size,
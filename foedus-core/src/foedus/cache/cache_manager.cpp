@@ -36,6 +36,10 @@ ErrorStack CacheManager::initialize_once() { return pimpl_->initialize_once(); }
 ErrorStack CacheManager::uninitialize_once() { return pimpl_->uninitialize_once(); }
 std::string CacheManager::describe() const { return pimpl_->describe(); }
 ErrorStack CacheManager::stop_cleaner() { return pimpl_->stop_cleaner(); }
+bool CacheManager::is_warm_start_done() const { return pimpl_->warm_start_done_.load(); }
+uint64_t CacheManager::get_warm_start_page_count() const {
+  return pimpl_->warm_start_page_count_.load();
+}
 
 }  // namespace cache
 }  // namespace foedus
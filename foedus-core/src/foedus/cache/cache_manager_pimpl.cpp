@@ -19,17 +19,25 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <chrono>
+#include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
+#include "foedus/assorted/assorted_func.hpp"
 #include "foedus/cache/cache_hashtable.hpp"
+#include "foedus/cache/snapshot_file_set.hpp"
 #include "foedus/debugging/stop_watch.hpp"
+#include "foedus/fs/filesystem.hpp"
 #include "foedus/memory/engine_memory.hpp"
 #include "foedus/memory/numa_node_memory.hpp"
 #include "foedus/savepoint/savepoint_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/page.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
@@ -41,7 +49,12 @@ CacheManagerPimpl::CacheManagerPimpl(Engine* engine)
   pool_(nullptr),
   hashtable_(nullptr),
   reclaimed_pages_(nullptr),
-  reclaimed_pages_count_(0) {
+  reclaimed_pages_count_(0),
+  warm_start_done_(true),
+  warm_start_page_count_(0),
+  manifest_max_pages_(0),
+  manifest_snapshot_id_(snapshot::kNullSnapshotId),
+  manifest_written_(false) {
 }
 
 ErrorStack CacheManagerPimpl::initialize_once() {
@@ -85,6 +98,12 @@ ErrorStack CacheManagerPimpl::initialize_once() {
   ASSERT_ND(urgent_threshold_ >= cleaner_threshold_);
   ASSERT_ND(total_pages_ >= urgent_threshold_);
 
+  // the warm-start should not push the cache over the eviction threshold.
+  manifest_max_pages_ = total_pages_ * options.snapshot_cache_eviction_threshold_;
+  manifest_snapshot_id_ = engine_->get_snapshot_manager()->get_previous_snapshot_id();
+  manifest_written_ = false;
+  manifest_watch_.start();
+
   reclaimed_pages_memory_.alloc(
     total_pages_ * sizeof(memory::PagePoolOffset),
     1ULL << 21,
@@ -96,6 +115,15 @@ ErrorStack CacheManagerPimpl::initialize_once() {
   stop_requested_.store(false);
   cleaner_ = std::move(std::thread(&CacheManagerPimpl::handle_cleaner, this));
 
+  // and the warm-start thread, which runs concurrently with transactions.
+  warm_start_page_count_.store(0);
+  if (options.snapshot_cache_warm_start_ && fs::exists(get_manifest_path())) {
+    warm_start_done_.store(false);
+    warmer_ = std::move(std::thread(&CacheManagerPimpl::handle_warmer, this));
+  } else {
+    warm_start_done_.store(true);
+  }
+
   return kRetOk;
 }
 
@@ -107,6 +135,14 @@ ErrorStack CacheManagerPimpl::uninitialize_once() {
 
   LOG(INFO) << "Uninitializing Snapshot Cache... " << describe();
   CHECK_ERROR(stop_cleaner());
+  if (engine_->get_options().cache_.snapshot_cache_warm_start_) {
+    // No one is using the cache at this point. Not being able to write the manifest is
+    // not a reason to fail the shutdown. It just makes the next start-up a bit slower.
+    ErrorStack manifest_error = save_manifest();
+    if (manifest_error.is_error()) {
+      LOG(WARNING) << "Failed to write out the manifest of the snapshot cache: " << manifest_error;
+    }
+  }
 
   pool_ = nullptr;
   hashtable_ = nullptr;
@@ -120,6 +156,10 @@ void CacheManagerPimpl::handle_cleaner() {
   LOG(INFO) << "Here we go. Cleaner thread: " << describe();
 
   const uint32_t kIntervalMs = 5;  // should be a bit shorter than epoch-advance interval
+  const uint64_t kManifestIntervalPercent = 90;  // when to write out the manifest
+  const uint64_t manifest_delay_ns
+    = engine_->get_options().snapshot_.snapshot_interval_milliseconds_
+      * kManifestIntervalPercent * 10000ULL;  // ms * percent / 100 -> ns
   while (!stop_requested_) {
     DVLOG(2) << "Cleaner thread came in: " << describe();
     ASSERT_ND(reclaimed_pages_count_ == 0);
@@ -179,6 +219,26 @@ void CacheManagerPimpl::handle_cleaner() {
       DVLOG(2) << "Still enough free pages. do nothing";
     }
 
+    if (!stop_requested_ && engine_->get_options().cache_.snapshot_cache_warm_start_) {
+      // Also write out the manifest once per snapshot interval. Right after a snapshot, the cache
+      // still holds pages of the previous snapshot, which the workload no longer reads.
+      // The pages of the new snapshot get hot over the interval, so we write it out shortly
+      // before the next snapshot.
+      snapshot::SnapshotId snapshot_id
+        = engine_->get_snapshot_manager()->get_previous_snapshot_id_weak();
+      if (snapshot_id != manifest_snapshot_id_) {
+        manifest_snapshot_id_ = snapshot_id;
+        manifest_written_ = false;
+        manifest_watch_.start();
+      } else if (!manifest_written_ && manifest_watch_.peek_elapsed_ns() >= manifest_delay_ns) {
+        ErrorStack manifest_error = save_manifest();
+        if (manifest_error.is_error()) {
+          LOG(WARNING) << "Failed to write out the manifest of snapshot cache: " << manifest_error;
+        }
+        manifest_written_ = true;
+      }
+    }
+
     if (!stop_requested_) {
       std::this_thread::sleep_for(std::chrono::milliseconds(kIntervalMs));
     }
@@ -203,12 +263,236 @@ ErrorStack CacheManagerPimpl::stop_cleaner() {
       LOG(INFO) << "Requesting Cache Cleaner to stop...";
       cleaner_.join();
     }
+    if (warmer_.joinable()) {
+      LOG(INFO) << "Requesting Cache Warmer to stop...";
+      warmer_.join();
+    }
   } else {
     LOG(INFO) << "Cache Cleaner seems already stop-requested";
   }
   return kRetOk;
 }
 
+fs::Path CacheManagerPimpl::get_manifest_path() const {
+  uint16_t node = engine_->get_soc_id();
+  fs::Path path(engine_->get_options().snapshot_.convert_folder_path_pattern(node));
+  path /= std::string("snapshot_cache_manifest_node_") + std::to_string(node) + ".bin";
+  return path;
+}
+
+ErrorStack CacheManagerPimpl::save_manifest() {
+  debugging::StopWatch watch;
+  std::vector<ContentId> contents(manifest_max_pages_);
+  // pages accessed at least once more after they were installed
+  uint32_t count = hashtable_->collect_hot_contents(
+    CacheHashtable::kInitialRefCount + 1U,
+    manifest_max_pages_,
+    &contents[0]);
+
+  // The hashtable knows only tags. The page image knows its ID.
+  std::vector<storage::SnapshotPagePointer> page_ids;
+  page_ids.reserve(count);
+  const storage::Page* base = pool_->get_base();
+  for (uint32_t i = 0; i < count; ++i) {
+    const storage::PageHeader& header = base[contents[i]].get_header();
+    if (header.snapshot_ && header.page_id_ != 0) {
+      page_ids.push_back(header.page_id_);
+    }
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  page_ids.erase(std::unique(page_ids.begin(), page_ids.end()), page_ids.end());
+  if (page_ids.empty()) {
+    VLOG(0) << "No hot pages in snapshot cache. We don't write out the manifest";
+    return kRetOk;
+  }
+
+  fs::Path path = get_manifest_path();
+  fs::Path folder = path.parent_path();
+  if (!fs::exists(folder) && !fs::create_directories(folder, true)) {
+    return ERROR_STACK_MSG(kErrorCodeFsMkdirFailed, folder.c_str());
+  }
+
+  // same as savepoint. write to a temporary file, then rename.
+  fs::Path tmp_path(path);
+  tmp_path += ".tmp_";
+  tmp_path += fs::unique_name("%%%%%%%%");
+  CacheManifestHeader header;
+  header.magic_ = CacheManifestHeader::kMagic;
+  header.node_ = engine_->get_soc_id();
+  header.page_count_ = page_ids.size();
+  {
+    std::ofstream file(tmp_path.c_str(), std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(
+      reinterpret_cast<const char*>(&page_ids[0]),
+      sizeof(storage::SnapshotPagePointer) * page_ids.size());
+    file.flush();
+    if (!file) {
+      fs::remove(tmp_path);
+      return ERROR_STACK_MSG(kErrorCodeFsWriteFail, tmp_path.c_str());
+    }
+  }
+  if (!fs::durable_atomic_rename(tmp_path, path)) {
+    std::stringstream custom_message;
+    custom_message << "dest file=" << path << ", src file=" << tmp_path
+      << ", err=" << assorted::os_error();
+    return ERROR_STACK_MSG(kErrorCodeFsWriteFail, custom_message.str().c_str());
+  }
+  watch.stop();
+  LOG(INFO) << "Wrote out the manifest of snapshot cache in node-" << header.node_ << " with "
+    << header.page_count_ << " pages in " << watch.elapsed_ms() << "ms";
+  return kRetOk;
+}
+
+ErrorStack CacheManagerPimpl::load_manifest(
+  std::vector<storage::SnapshotPagePointer>* page_ids) const {
+  page_ids->clear();
+  fs::Path path = get_manifest_path();
+  if (!fs::exists(path)) {
+    return kRetOk;
+  }
+  std::ifstream file(path.c_str(), std::ios::binary);
+  CacheManifestHeader header;
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!file
+    || header.magic_ != CacheManifestHeader::kMagic
+    || header.node_ != engine_->get_soc_id()
+    || sizeof(header) + header.page_count_ * sizeof(storage::SnapshotPagePointer)
+      != fs::file_size(path)) {
+    return ERROR_STACK_MSG(kErrorCodeCacheManifestCorrupted, path.c_str());
+  }
+
+  // the cache might be smaller than when we wrote out the manifest.
+  page_ids->resize(std::min<uint64_t>(header.page_count_, manifest_max_pages_));
+  if (!page_ids->empty()) {
+    file.read(
+      reinterpret_cast<char*>(&(*page_ids)[0]),
+      sizeof(storage::SnapshotPagePointer) * page_ids->size());
+    if (!file) {
+      page_ids->clear();
+      return ERROR_STACK_MSG(kErrorCodeCacheManifestCorrupted, path.c_str());
+    }
+  }
+  return kRetOk;
+}
+
+/**
+ * Installs pages read by SnapshotFileSet::read_pages_batch() during warm-start.
+ * Similar to thread::BatchReadInstaller, but the buffers are directly grabbed from the pool.
+ */
+struct WarmStartInstaller {
+  CacheManagerPimpl*            pimpl_;
+  uint16_t                      count_;
+  uint16_t                      installed_count_;
+  storage::SnapshotPagePointer  page_ids_[SnapshotFileSet::kMaxAsyncReads];
+  memory::PagePoolOffset        offsets_[SnapshotFileSet::kMaxAsyncReads];
+  void*                         buffers_[SnapshotFileSet::kMaxAsyncReads];
+  /** Whether the page is installed or returned to the pool. */
+  bool                          done_[SnapshotFileSet::kMaxAsyncReads];
+
+  static ErrorCode on_completion(uint16_t index, void* arg) {
+    WarmStartInstaller* installer = reinterpret_cast<WarmStartInstaller*>(arg);
+    ASSERT_ND(index < installer->count_);
+    CacheManagerPimpl* pimpl = installer->pimpl_;
+    const storage::Page* page = pimpl->pool_->get_base() + installer->offsets_[index];
+    if (page->get_header().page_id_ != installer->page_ids_[index]) {
+      // The manifest is stale. Whatever, just skip it.
+      DVLOG(0) << "Page ID mismatch in warm-start. page_id=" << installer->page_ids_[index];
+      pimpl->pool_->release_one(installer->offsets_[index]);
+    } else {
+      CHECK_ERROR_CODE(pimpl->hashtable_->install(
+        installer->page_ids_[index],
+        installer->offsets_[index]));
+      ++installer->installed_count_;
+    }
+    installer->done_[index] = true;
+    return kErrorCodeOk;
+  }
+
+  /** Returns the pages that are not installed yet to the pool. Used on errors. */
+  void release_remaining() {
+    for (uint16_t i = 0; i < count_; ++i) {
+      if (!done_[i]) {
+        pimpl_->pool_->release_one(offsets_[i]);
+        done_[i] = true;
+      }
+    }
+  }
+};
+
+void CacheManagerPimpl::handle_warmer() {
+  std::vector<storage::SnapshotPagePointer> page_ids;
+  ErrorStack load_error = load_manifest(&page_ids);
+  if (load_error.is_error()) {
+    LOG(WARNING) << "Could not read the manifest of snapshot cache. Skipped warm-start: "
+      << load_error;
+    warm_start_done_.store(true);
+    return;
+  }
+
+  LOG(INFO) << "Warming up snapshot cache in node-" << engine_->get_soc_id() << " with "
+    << page_ids.size() << " pages...";
+  debugging::StopWatch watch;
+  SnapshotFileSet files(engine_);
+  ErrorStack init_error = files.initialize();
+  if (init_error.is_error()) {
+    // warm-start is just an optimization. the engine works fine without it.
+    LOG(WARNING) << "Could not open snapshot files. Skipped warm-start: " << init_error;
+    warm_start_done_.store(true);
+    return;
+  }
+  bool pool_full = false;
+  for (uint64_t pos = 0; pos < page_ids.size() && !stop_requested_ && !pool_full;) {
+    WarmStartInstaller installer;
+    installer.pimpl_ = this;
+    installer.count_ = 0;
+    installer.installed_count_ = 0;
+    for (; pos < page_ids.size() && installer.count_ < SnapshotFileSet::kMaxAsyncReads; ++pos) {
+      storage::SnapshotPagePointer page_id = page_ids[pos];
+      ContentId existing = hashtable_->find(page_id);
+      if (existing != 0 && pool_->get_base()[existing].get_header().page_id_ == page_id) {
+        continue;  // a transaction already read it
+      }
+      memory::PagePoolOffset offset;
+      if (pool_->get_stat().allocated_pages_ >= cleaner_threshold_
+        || pool_->grab_one(&offset) != kErrorCodeOk) {
+        pool_full = true;
+        break;
+      }
+      installer.page_ids_[installer.count_] = page_id;
+      installer.offsets_[installer.count_] = offset;
+      installer.buffers_[installer.count_] = pool_->get_base() + offset;
+      installer.done_[installer.count_] = false;
+      ++installer.count_;
+    }
+    if (installer.count_ == 0) {
+      continue;
+    }
+
+    ErrorCode read_error = files.read_pages_batch(
+      installer.count_,
+      installer.page_ids_,
+      installer.buffers_,
+      WarmStartInstaller::on_completion,
+      &installer);
+    warm_start_page_count_ += installer.installed_count_;
+    if (read_error != kErrorCodeOk) {
+      installer.release_remaining();
+      LOG(WARNING) << "Error while warm-start of snapshot cache. Stopped warm-start: "
+        << get_error_name(read_error);
+      break;
+    }
+  }
+  ErrorStack uninit_error = files.uninitialize();
+  if (uninit_error.is_error()) {
+    LOG(WARNING) << "Error while closing snapshot files after warm-start: " << uninit_error;
+  }
+  watch.stop();
+  LOG(INFO) << "Warmed up snapshot cache in node-" << engine_->get_soc_id() << " with "
+    << warm_start_page_count_ << " pages in " << watch.elapsed_ms() << "ms"
+    << (pool_full ? ". Stopped because the cache is full" : "");
+  warm_start_done_.store(true);
+}
 
 std::string CacheManagerPimpl::describe() const {
   if (pool_ == nullptr) {
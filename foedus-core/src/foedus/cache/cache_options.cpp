@@ -27,6 +27,7 @@ CacheOptions::CacheOptions() {
   private_snapshot_cache_initial_grab_ = memory::PagePoolOffsetChunk::kMaxSize / 2;
   snapshot_cache_eviction_threshold_ = 0.75;
   snapshot_cache_urgent_threshold_ = 0.9;
+  snapshot_cache_warm_start_ = true;
 }
 ErrorStack CacheOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_cache_enabled_);
@@ -38,6 +39,7 @@ ErrorStack CacheOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_cache_urgent_threshold_);
   ASSERT_ND(snapshot_cache_urgent_threshold_ >= snapshot_cache_eviction_threshold_);
   ASSERT_ND(snapshot_cache_urgent_threshold_ <= 1);
+  EXTERNALIZE_LOAD_ELEMENT(element, snapshot_cache_warm_start_);
   return kRetOk;
 }
 ErrorStack CacheOptions::save(tinyxml2::XMLElement* element) const {
@@ -62,6 +64,8 @@ ErrorStack CacheOptions::save(tinyxml2::XMLElement* element) const {
     snapshot_cache_urgent_threshold_,
     "When the cache eviction performs in an urgent mode, which immediately advances"
     " the current epoch to release pages");
+  EXTERNALIZE_SAVE_ELEMENT(element, snapshot_cache_warm_start_,
+    "Whether to warm up the snapshot cache after restart from a manifest of hot pages.");
   return kRetOk;
 }
 
@@ -17,13 +17,22 @@
  */
 #include "foedus/cache/snapshot_file_set.hpp"
 
+#include <unistd.h>
+#include <glog/logging.h>
+#include <linux/aio_abi.h>
+#include <sys/syscall.h>
+
+#include <cerrno>
+#include <cstring>
 #include <map>
 #include <ostream>
+#include <string>
 #include <utility>
 
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
 #include "foedus/error_stack_batch.hpp"
+#include "foedus/assorted/assorted_func.hpp"
 #include "foedus/fs/direct_io_file.hpp"
 #include "foedus/fs/path.hpp"
 #include "foedus/storage/page.hpp"
@@ -31,7 +40,30 @@
 namespace foedus {
 namespace cache {
 
-SnapshotFileSet::SnapshotFileSet(Engine* engine) : engine_(engine) {
+// glibc doesn't provide wrappers for the native AIO syscalls. We don't want to depend on libaio
+// just for these, so we call them directly.
+inline int aio_setup(unsigned nr_events, aio_context_t* context) {
+  return ::syscall(__NR_io_setup, nr_events, context);
+}
+inline int aio_destroy(aio_context_t context) {
+  return ::syscall(__NR_io_destroy, context);
+}
+inline int aio_submit(
+  aio_context_t context,
+  long nr,  // NOLINT(runtime/int) as in the syscall
+  struct iocb** iocbpp) {
+  return ::syscall(__NR_io_submit, context, nr, iocbpp);
+}
+inline int aio_getevents(
+  aio_context_t context,
+  long min_nr,  // NOLINT(runtime/int)
+  long nr,  // NOLINT(runtime/int)
+  struct io_event* events) {
+  return ::syscall(__NR_io_getevents, context, min_nr, nr, events, nullptr);
+}
+
+SnapshotFileSet::SnapshotFileSet(Engine* engine)
+  : engine_(engine), aio_context_(0), aio_unavailable_(false) {
 }
 
 ErrorStack SnapshotFileSet::initialize_once() {
@@ -41,6 +73,12 @@ ErrorStack SnapshotFileSet::initialize_once() {
 ErrorStack SnapshotFileSet::uninitialize_once() {
   ErrorStackBatch batch;
   close_all();
+  if (aio_context_ != 0) {
+    if (aio_destroy(aio_context_) != 0) {
+      LOG(WARNING) << "io_destroy() failed: " << assorted::os_error();
+    }
+    aio_context_ = 0;
+  }
   return SUMMARIZE_ERROR_BATCH(batch);
 }
 
@@ -124,6 +162,127 @@ ErrorCode SnapshotFileSet::read_pages(
   return kErrorCodeOk;
 }
 
+bool SnapshotFileSet::prepare_async_reads() {
+  if (aio_context_ != 0) {
+    return true;
+  } else if (aio_unavailable_) {
+    return false;
+  }
+  aio_context_t context = 0;
+  if (aio_setup(kMaxAsyncReads, &context) != 0) {
+    LOG(WARNING) << "io_setup() failed. Snapshot pages will be read synchronously: "
+      << assorted::os_error();
+    aio_unavailable_ = true;
+    return false;
+  }
+  aio_context_ = context;
+  return true;
+}
+
+ErrorCode SnapshotFileSet::read_pages_batch_sync(
+  uint16_t from,
+  uint16_t count,
+  const storage::SnapshotPagePointer* page_ids,
+  void* const* outs,
+  PageReadCompletion on_completion,
+  void* completion_arg) {
+  for (uint16_t i = from; i < count; ++i) {
+    CHECK_ERROR_CODE(read_page(page_ids[i], outs[i]));
+    if (on_completion) {
+      CHECK_ERROR_CODE(on_completion(i, completion_arg));
+    }
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode SnapshotFileSet::read_pages_batch(
+  uint16_t count,
+  const storage::SnapshotPagePointer* page_ids,
+  void* const* outs,
+  PageReadCompletion on_completion,
+  void* completion_arg) {
+  ASSERT_ND(count <= kMaxAsyncReads);
+  if (UNLIKELY(count > kMaxAsyncReads)) {
+    return kErrorCodeInvalidParameter;
+  } else if (count <= 1U || !prepare_async_reads()) {
+    return read_pages_batch_sync(0, count, page_ids, outs, on_completion, completion_arg);
+  }
+
+  struct iocb iocbs[kMaxAsyncReads];
+  struct iocb* iocb_pointers[kMaxAsyncReads];
+  for (uint16_t i = 0; i < count; ++i) {
+    fs::DirectIoFile* file;
+    CHECK_ERROR_CODE(get_or_open_file(page_ids[i], &file));  // nothing is outstanding yet
+    storage::SnapshotLocalPageId local_page_id
+      = storage::extract_local_page_id_from_snapshot_pointer(page_ids[i]);
+    std::memset(iocbs + i, 0, sizeof(struct iocb));
+    iocbs[i].aio_data = i;
+    iocbs[i].aio_lio_opcode = IOCB_CMD_PREAD;
+    iocbs[i].aio_fildes = file->get_descriptor();
+    iocbs[i].aio_buf = reinterpret_cast<uintptr_t>(outs[i]);
+    iocbs[i].aio_nbytes = sizeof(storage::Page);
+    iocbs[i].aio_offset = local_page_id * sizeof(storage::Page);
+    iocb_pointers[i] = iocbs + i;
+  }
+
+  // io_submit() might accept only some of them.
+  uint16_t submitted = 0;
+  while (submitted < count) {
+    int ret = aio_submit(aio_context_, count - submitted, iocb_pointers + submitted);
+    if (ret > 0) {
+      submitted += ret;
+    } else if (ret < 0 && errno == EINTR) {
+      continue;
+    } else {
+      LOG(WARNING) << "io_submit() failed. Reading the rest synchronously: "
+        << assorted::os_error();
+      break;
+    }
+  }
+
+  // Reap completions as they arrive. Even after an error, we must wait for all outstanding
+  // reads because the kernel is still writing into the caller's buffers.
+  ErrorCode result = kErrorCodeOk;
+  struct io_event events[kMaxAsyncReads];
+  for (uint16_t outstanding = submitted; outstanding > 0;) {
+    int reaped = aio_getevents(aio_context_, 1, outstanding, events);
+    if (reaped < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // We can't return while the kernel might write into the buffers.
+      LOG(FATAL) << "io_getevents() failed: " << assorted::os_error();
+    }
+    outstanding -= reaped;
+    for (int e = 0; e < reaped; ++e) {
+      uint16_t index = events[e].data;
+      ASSERT_ND(index < submitted);
+      if (result != kErrorCodeOk) {
+        continue;
+      } else if (events[e].res != static_cast<int64_t>(sizeof(storage::Page))) {
+        LOG(ERROR) << "Asynchronous read of a snapshot page failed. page_id="
+          << assorted::Hex(page_ids[index]) << ", res=" << static_cast<int64_t>(events[e].res)
+          << (events[e].res < 0 ? assorted::os_error(-events[e].res) : std::string());
+        result = kErrorCodeFsTooShortRead;
+        continue;
+      }
+      ASSERT_ND(reinterpret_cast<storage::Page*>(outs[index])->get_header().page_id_
+        == page_ids[index]);
+      if (on_completion) {
+        result = on_completion(index, completion_arg);
+      }
+    }
+  }
+  CHECK_ERROR_CODE(result);
+  return read_pages_batch_sync(
+    submitted,
+    count,
+    page_ids,
+    outs,
+    on_completion,
+    completion_arg);
+}
+
 std::ostream& operator<<(std::ostream& o, const SnapshotFileSet& v) {
   o << "<SnapshotFileSet>";
   for (const auto& snapshot : v.files_) {
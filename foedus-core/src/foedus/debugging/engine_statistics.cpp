@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/debugging/engine_statistics.hpp"
+
+#include <algorithm>
+#include <ostream>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/assorted/atomic_fences.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/log/logger_ref.hpp"
+#include "foedus/thread/thread_id.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/thread/thread_ref.hpp"
+
+namespace foedus {
+namespace debugging {
+
+void EngineStatistics::clear() {
+  thread_count_ = 0;
+  logger_count_ = 0;
+  xct_.reset();
+  snapshot_cache_hits_ = 0;
+  snapshot_cache_misses_ = 0;
+  log_written_bytes_ = 0;
+  log_raw_bytes_ = 0;
+  log_stolen_bytes_ = 0;
+  log_max_epoch_lag_ = 0;
+  log_fsyncs_ = 0;
+  log_fsync_latency_ns_.reset();
+}
+
+void EngineStatistics::collect(Engine* engine) {
+  clear();
+  assorted::memory_fence_acquire();
+  const EngineOptions& options = engine->get_options();
+  thread::ThreadPool* pool = engine->get_thread_pool();
+  for (thread::ThreadGroupId node = 0; node < options.thread_.group_count_; ++node) {
+    for (uint16_t ordinal = 0; ordinal < options.thread_.thread_count_per_group_; ++ordinal) {
+      thread::ThreadRef* thread = pool->get_thread_ref(thread::compose_thread_id(node, ordinal));
+      xct_.add(thread->get_xct_statistics());
+      snapshot_cache_hits_ += thread->get_snapshot_cache_hits();
+      snapshot_cache_misses_ += thread->get_snapshot_cache_misses();
+      ++thread_count_;
+    }
+  }
+
+  log::LogManager* log_manager = engine->get_log_manager();
+  const uint32_t loggers = options.thread_.group_count_ * options.log_.loggers_per_node_;
+  for (log::LoggerId id = 0; id < loggers; ++id) {
+    log::LoggerRef logger = log_manager->get_logger(id);
+    log_written_bytes_ += logger.get_stat_written_bytes();
+    log_raw_bytes_ += logger.get_stat_raw_log_bytes();
+    log_stolen_bytes_ += logger.get_stat_stolen_log_bytes();
+    log_max_epoch_lag_ = std::max(log_max_epoch_lag_, logger.get_stat_max_epoch_lag());
+    log_fsyncs_ += logger.get_stat_fsyncs();
+    log_fsync_latency_ns_.merge(logger.get_stat_fsync_latency_ns());
+    ++logger_count_;
+  }
+}
+
+std::ostream& operator<<(std::ostream& o, const EngineStatistics& v) {
+  o << "<EngineStatistics>"
+    << "<thread_count_>" << v.thread_count_ << "</thread_count_>"
+    << "<logger_count_>" << v.logger_count_ << "</logger_count_>"
+    << v.xct_
+    << "<snapshot_cache_hits_>" << v.snapshot_cache_hits_ << "</snapshot_cache_hits_>"
+    << "<snapshot_cache_misses_>" << v.snapshot_cache_misses_ << "</snapshot_cache_misses_>"
+    << "<snapshot_cache_hit_ratio_>" << v.get_snapshot_cache_hit_ratio()
+      << "</snapshot_cache_hit_ratio_>"
+    << "<log_written_bytes_>" << v.log_written_bytes_ << "</log_written_bytes_>"
+    << "<log_raw_bytes_>" << v.log_raw_bytes_ << "</log_raw_bytes_>"
+    << "<log_stolen_bytes_>" << v.log_stolen_bytes_ << "</log_stolen_bytes_>"
+    << "<log_max_epoch_lag_>" << v.log_max_epoch_lag_ << "</log_max_epoch_lag_>"
+    << "<log_fsyncs_>" << v.log_fsyncs_ << "</log_fsyncs_>"
+    << "<log_fsync_latency_ns_>" << v.log_fsync_latency_ns_ << "</log_fsync_latency_ns_>"
+    << "</EngineStatistics>";
+  return o;
+}
+
+void EngineStatistics::describe_json(std::ostream* o) const {
+  *o << "{\"thread_count\": " << thread_count_
+    << ", \"logger_count\": " << logger_count_
+    << ", \"xct\": ";
+  xct_.describe_json(o);
+  *o << ", \"snapshot_cache\": {\"hits\": " << snapshot_cache_hits_
+    << ", \"misses\": " << snapshot_cache_misses_
+    << ", \"hit_ratio\": " << get_snapshot_cache_hit_ratio() << "}"
+    << ", \"log\": {\"written_bytes\": " << log_written_bytes_
+    << ", \"raw_bytes\": " << log_raw_bytes_
+    << ", \"stolen_bytes\": " << log_stolen_bytes_
+    << ", \"max_epoch_lag\": " << log_max_epoch_lag_
+    << ", \"fsyncs\": " << log_fsyncs_
+    << ", \"fsync_latency_ns\": ";
+  log_fsync_latency_ns_.describe_json(o);
+  *o << "}}";
+}
+
+}  // namespace debugging
+}  // namespace foedus
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/debugging/latency_histogram.hpp"
+
+#include <ostream>
+
+namespace foedus {
+namespace debugging {
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+  count_ += other.count_;
+  sum_ += other.sum_;
+  if (other.max_ > max_) {
+    max_ = other.max_;
+  }
+  for (uint16_t i = 0; i < kBuckets; ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+}
+
+uint64_t LatencyHistogram::get_percentile(double percentile) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  uint64_t threshold = static_cast<uint64_t>(count_ * percentile / 100.0);
+  if (threshold == 0) {
+    threshold = 1;
+  }
+  uint64_t cumulative = 0;
+  for (uint16_t i = 0; i < kBuckets; ++i) {
+    cumulative += buckets_[i];
+    if (cumulative >= threshold) {
+      if (i + 1U == kBuckets) {
+        return max_;
+      }
+      // the exclusive upper bound of the bucket, but never beyond the observed max
+      uint64_t upper = get_bucket_lower_bound(i + 1U) - 1U;
+      return upper < max_ ? upper : max_;
+    }
+  }
+  // buckets are read without synchronization, so this might happen in a race.
+  return max_;
+}
+
+std::ostream& operator<<(std::ostream& o, const LatencyHistogram& v) {
+  o << "<count_>" << v.get_count() << "</count_>"
+    << "<average_>" << v.get_average() << "</average_>"
+    << "<p50_>" << v.get_percentile(50) << "</p50_>"
+    << "<p90_>" << v.get_percentile(90) << "</p90_>"
+    << "<p99_>" << v.get_percentile(99) << "</p99_>"
+    << "<p999_>" << v.get_percentile(99.9) << "</p999_>"
+    << "<max_>" << v.get_max() << "</max_>";
+  return o;
+}
+
+void LatencyHistogram::describe_json(std::ostream* o) const {
+  *o << "{\"count\": " << get_count()
+    << ", \"average\": " << get_average()
+    << ", \"p50\": " << get_percentile(50)
+    << ", \"p90\": " << get_percentile(90)
+    << ", \"p99\": " << get_percentile(99)
+    << ", \"p999\": " << get_percentile(99.9)
+    << ", \"max\": " << get_max() << "}";
+}
+
+}  // namespace debugging
+}  // namespace foedus
@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/log/change_stream.hpp"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/fs/direct_io_file.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/fs/path.hpp"
+#include "foedus/log/common_log_types.hpp"
+#include "foedus/log/log_compression.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/log/log_type.hpp"
+#include "foedus/log/logger_ref.hpp"
+#include "foedus/thread/thread_id.hpp"
+
+namespace foedus {
+namespace log {
+
+/** All I/O in log files must be aligned to this size. */
+const uint64_t kChangeStreamIoAlignment = 1ULL << 12;
+inline uint64_t align_change_stream_io_floor(uint64_t offset) {
+  return (offset / kChangeStreamIoAlignment) * kChangeStreamIoAlignment;
+}
+inline uint64_t align_change_stream_io_ceil(uint64_t offset) {
+  return align_change_stream_io_floor(offset + kChangeStreamIoAlignment - 1U);
+}
+
+ChangeStream::ChangeStream(Engine* engine, ChangeStreamId id, storage::StorageId storage_id)
+  : engine_(engine), id_(id), storage_id_(storage_id) {
+  ASSERT_ND(id < kMaxChangeStreams);
+  fetched_epoch_ = engine_->get_log_manager()->get_change_stream_cursor(id_);
+  if (!fetched_epoch_.is_valid()) {
+    // This consumer has never acknowledged anything. Everything is new to it.
+    fetched_epoch_ = Epoch(Epoch::kEpochInitialDurable);
+  }
+  const EngineOptions& options = engine_->get_options();
+  const uint32_t logger_count = options.log_.loggers_per_node_ * options.thread_.group_count_;
+  LoggerPosition beginning = {0, 0};
+  positions_.resize(logger_count, beginning);
+  for (LoggerId logger_id = 0; logger_id < logger_count; ++logger_id) {
+    // The cursor is persisted only as an epoch. If the logger's epoch history since this run
+    // covers it, we start from there. Otherwise (the cursor is from before restart), we read
+    // all log files from the beginning and skip logs until the cursor.
+    LoggerPosition* position = &positions_[logger_id];
+    LoggerRef logger = engine_->get_log_manager()->get_logger(logger_id);
+    if (!logger.find_epoch_position(fetched_epoch_, &position->ordinal_, &position->offset_)) {
+      *position = beginning;
+    }
+  }
+  // Read buffers are allocated on the first read.
+  read_buffers_.resize(logger_count);
+}
+
+ErrorStack ChangeStream::fetch(uint32_t max_epochs, uint64_t wait_microseconds) {
+  ASSERT_ND(max_epochs > 0);
+  changes_.clear();
+  staged_.clear();
+  decompressed_.clear();
+
+  LogManager* log_manager = engine_->get_log_manager();
+  Epoch durable_epoch = log_manager->get_durable_global_epoch();
+  if (durable_epoch <= fetched_epoch_ && wait_microseconds > 0) {
+    log_manager->wait_for_durable_global_epoch_advance(durable_epoch, wait_microseconds);
+    durable_epoch = log_manager->get_durable_global_epoch();
+  }
+  if (durable_epoch <= fetched_epoch_) {
+    return kRetOk;
+  }
+  Epoch until_epoch = fetched_epoch_;
+  for (uint32_t i = 0; i < max_epochs && until_epoch < durable_epoch; ++i) {
+    ++until_epoch;
+  }
+
+  const uint32_t logger_count = positions_.size();
+  std::vector<LoggerScan> scans(logger_count);
+  Epoch complete_epoch;
+  while (true) {
+    complete_epoch = until_epoch;
+    for (LoggerId logger_id = 0; logger_id < logger_count; ++logger_id) {
+      CHECK_ERROR(read_logger(logger_id, until_epoch, &scans[logger_id]));
+      if (scans[logger_id].complete_epoch_ < complete_epoch) {
+        complete_epoch = scans[logger_id].complete_epoch_;
+      }
+    }
+    if (complete_epoch > fetched_epoch_) {
+      break;
+    }
+
+    // Some logger has more logs in the next epoch than its read buffer can hold. Retry.
+    bool expanded = false;
+    for (LoggerId logger_id = 0; logger_id < logger_count; ++logger_id) {
+      if (scans[logger_id].buffer_full_ && scans[logger_id].complete_epoch_ <= fetched_epoch_) {
+        memory::AlignedMemory* buffer = &read_buffers_[logger_id];
+        const uint64_t new_size = buffer->get_size() * 2U;
+        LOG(INFO) << *this << " expands the read buffer of Logger-" << logger_id << " to "
+          << new_size << " bytes";
+        buffer->alloc(
+          new_size,
+          kChangeStreamIoAlignment,
+          memory::AlignedMemory::kPosixMemalign,
+          0);
+        expanded = true;
+      }
+    }
+    if (!expanded) {
+      return ERROR_STACK_MSG(kErrorCodeInvalidParameter, "change stream made no progress");
+    }
+    staged_.clear();
+    decompressed_.clear();
+  }
+
+  // Some loggers might have read logs beyond complete_epoch. Next fetch re-reads them.
+  for (LoggerId logger_id = 0; logger_id < logger_count; ++logger_id) {
+    const LoggerScan& scan = scans[logger_id];
+    positions_[logger_id] = scan.end_;
+    for (uint32_t i = 0; i < scan.epoch_begins_.size(); ++i) {
+      if (scan.epoch_begins_[i].first > complete_epoch) {
+        positions_[logger_id] = scan.epoch_begins_[i].second;
+        break;
+      }
+    }
+  }
+
+  std::stable_sort(
+    staged_.begin(),
+    staged_.end(),
+    [](const StagedChange& left, const StagedChange& right) {
+      return left.xct_id_.before(right.xct_id_);
+    });
+  changes_.reserve(staged_.size());
+  for (uint32_t i = 0; i < staged_.size(); ++i) {
+    const StagedChange& staged = staged_[i];
+    if (staged.xct_id_.get_epoch() > complete_epoch) {
+      continue;
+    }
+    const char* base;
+    if (staged.source_ == kDecompressed) {
+      base = decompressed_.data();
+    } else {
+      base = reinterpret_cast<const char*>(read_buffers_[staged.source_].get_block());
+    }
+    changes_.push_back(reinterpret_cast<const RecordLogType*>(base + staged.position_));
+  }
+  fetched_epoch_ = complete_epoch;
+  DVLOG(1) << *this << " fetched " << changes_.size() << " changes";
+  return kRetOk;
+}
+
+ErrorStack ChangeStream::read_logger(LoggerId logger_id, Epoch until_epoch, LoggerScan* scan) {
+  const EngineOptions& options = engine_->get_options();
+  LoggerRef logger = engine_->get_log_manager()->get_logger(logger_id);
+  // Like restart, we don't rely on epoch histories, which are not carried over restarts.
+  // We remember where we stopped and only need to know where the durable logs end.
+  const LogRange log_range = logger.get_log_range(Epoch(), until_epoch);
+  scan->complete_epoch_ = until_epoch;
+  scan->max_epoch_ = Epoch();
+  scan->buffer_full_ = false;
+  scan->end_ = positions_[logger_id];
+  scan->epoch_begins_.clear();
+
+  memory::AlignedMemory* buffer = &read_buffers_[logger_id];
+  if (buffer->is_null()) {
+    buffer->alloc(
+      kInitialReadBufferSize,
+      kChangeStreamIoAlignment,
+      memory::AlignedMemory::kPosixMemalign,
+      0);
+  }
+  const thread::ThreadGroupId node = logger_id / options.log_.loggers_per_node_;
+  LoggerPosition* cur = &scan->end_;
+  while (cur->ordinal_ < log_range.end_file_ordinal
+    || (cur->ordinal_ == log_range.end_file_ordinal && cur->offset_ < log_range.end_offset)) {
+    fs::Path path(options.log_.construct_suffixed_log_path(node, logger_id, cur->ordinal_));
+    const bool last_file = cur->ordinal_ == log_range.end_file_ordinal;
+    const uint64_t end_infile
+      = last_file ? log_range.end_offset : align_change_stream_io_floor(fs::file_size(path));
+    if (cur->offset_ >= end_infile) {
+      ++cur->ordinal_;
+      cur->offset_ = 0;
+      continue;
+    }
+
+    // direct I/O: read from an aligned position, then skip the first few bytes.
+    const uint64_t buf_infile_aligned = align_change_stream_io_floor(cur->offset_);
+    const uint64_t needed_size = align_change_stream_io_ceil(end_infile - buf_infile_aligned);
+    const uint64_t read_size = std::min<uint64_t>(buffer->get_size(), needed_size);
+    fs::DirectIoFile file(path, options.log_.emulation_);
+    WRAP_ERROR_CODE(file.open(true, false, false, false));
+    WRAP_ERROR_CODE(file.seek(buf_infile_aligned, fs::DirectIoFile::kDirectIoSeekSet));
+    WRAP_ERROR_CODE(file.read(read_size, buffer));
+    file.close();
+
+    const uint64_t valid_size = std::min<uint64_t>(read_size, end_infile - buf_infile_aligned);
+    uint64_t consumed;
+    bool hit_until;
+    WRAP_ERROR_CODE(scan_buffer(
+      logger_id,
+      cur->offset_ - buf_infile_aligned,
+      valid_size,
+      buf_infile_aligned,
+      until_epoch,
+      scan,
+      &consumed,
+      &hit_until));
+    cur->offset_ += consumed;
+    if (hit_until) {
+      return kRetOk;
+    }
+
+    if (read_size < needed_size) {
+      if (consumed == 0) {
+        // a read buffer is much larger than any log.
+        LOG(ERROR) << *this << " inconsistent log entry in Logger-" << logger_id
+          << ". offset=" << cur->offset_ << ", file=" << file;
+        return ERROR_STACK_MSG(kErrorCodeSnapshotInvalidLogEnd, path.c_str());
+      }
+      if (!scan->max_epoch_.is_valid()) {
+        continue;  // nothing picked up yet, so we can reuse the buffer.
+      }
+      // The logs of the last epoch we saw might continue beyond the buffer.
+      scan->complete_epoch_ = scan->max_epoch_.one_less();
+      scan->buffer_full_ = true;
+      return kRetOk;
+    }
+
+    if (!last_file) {
+      // A logger switches files only at epoch boundaries, so we have all logs in the epochs
+      // we saw. We don't go on to the next file in this fetch as it would overwrite the buffer.
+      ++cur->ordinal_;
+      cur->offset_ = 0;
+      if (scan->max_epoch_.is_valid()) {
+        scan->complete_epoch_ = scan->max_epoch_;
+        return kRetOk;
+      }
+    }
+  }
+  return kRetOk;
+}
+
+ErrorCode ChangeStream::scan_buffer(
+  LoggerId logger_id,
+  uint64_t begin,
+  uint64_t end,
+  uint64_t infile_base,
+  Epoch until_epoch,
+  LoggerScan* scan,
+  uint64_t* consumed,
+  bool* hit_until) {
+  const char* buffer = reinterpret_cast<const char*>(read_buffers_[logger_id].get_block());
+  *hit_until = false;
+  uint64_t cur = begin;
+  while (cur + sizeof(LogHeader) <= end) {
+    const LogHeader* header = reinterpret_cast<const LogHeader*>(buffer + cur);
+    ASSERT_ND(header->log_length_ > 0);
+    if (header->log_length_ + cur > end) {
+      break;  // this log goes beyond this read. read from here again.
+    }
+    const LogCode type = header->get_type();
+    if (type == kLogCodeEpochMarker || type == kLogCodeFiller) {
+      cur += header->log_length_;
+      continue;
+    }
+
+    Epoch epoch;
+    uint64_t decompressed_base = 0;
+    if (type == kLogCodeCompressedBlock) {
+      // A block has no epoch of its own. It contains logs of one epoch, so decompress it first.
+      const CompressedBlockLogType* block = reinterpret_cast<const CompressedBlockLogType*>(header);
+      block->assert_valid();
+      decompressed_base = decompressed_.size();
+      decompressed_.resize(decompressed_base + block->raw_length_);
+      char* logs = decompressed_.data() + decompressed_base;
+      if (!decompress_log_block(
+        block->get_data(),
+        block->compressed_length_,
+        logs,
+        block->raw_length_)) {
+        LOG(ERROR) << *this << " failed to decompress a block: " << *block;
+        return kErrorCodeLogCorruptedCompressedBlock;
+      }
+      for (uint32_t inner = 0; inner < block->raw_length_;) {
+        const LogHeader* inner_header = reinterpret_cast<const LogHeader*>(logs + inner);
+        ASSERT_ND(inner_header->log_length_ > 0);
+        inner += inner_header->log_length_;
+        if (inner_header->get_type() != kLogCodeFiller) {
+          epoch = inner_header->xct_id_.get_epoch();
+          break;
+        }
+      }
+      if (!epoch.is_valid() || epoch <= fetched_epoch_ || epoch > until_epoch) {
+        decompressed_.resize(decompressed_base);
+      }
+    } else {
+      epoch = header->xct_id_.get_epoch();
+    }
+
+    if (epoch.is_valid() && epoch > until_epoch) {
+      *hit_until = true;
+      break;
+    }
+    cur += header->log_length_;
+    if (!epoch.is_valid() || epoch <= fetched_epoch_) {
+      continue;
+    }
+
+    // a logger writes out epochs in order.
+    ASSERT_ND(!scan->max_epoch_.is_valid() || epoch >= scan->max_epoch_);
+    if (!scan->max_epoch_.is_valid() || epoch > scan->max_epoch_) {
+      LoggerPosition position = {scan->end_.ordinal_, infile_base + cur - header->log_length_};
+      scan->epoch_begins_.push_back(std::pair<Epoch, LoggerPosition>(epoch, position));
+      scan->max_epoch_ = epoch;
+    }
+    if (type == kLogCodeCompressedBlock) {
+      const CompressedBlockLogType* block = reinterpret_cast<const CompressedBlockLogType*>(header);
+      for (uint32_t inner = 0; inner < block->raw_length_;) {
+        const LogHeader* inner_header
+          = reinterpret_cast<const LogHeader*>(decompressed_.data() + decompressed_base + inner);
+        if (inner_header->get_type() != kLogCodeFiller) {
+          stage_change(kDecompressed, decompressed_base + inner, inner_header);
+        }
+        inner += inner_header->log_length_;
+      }
+    } else {
+      stage_change(logger_id, cur - header->log_length_, header);
+    }
+  }
+  *consumed = cur - begin;
+  return kErrorCodeOk;
+}
+
+void ChangeStream::stage_change(uint32_t source, uint64_t position, const LogHeader* header) {
+  ASSERT_ND(header->get_kind() == kRecordLogs);
+  if (storage_id_ != 0 && header->storage_id_ != storage_id_) {
+    return;
+  }
+  StagedChange staged;
+  staged.xct_id_ = header->xct_id_;
+  staged.source_ = source;
+  staged.position_ = position;
+  staged_.push_back(staged);
+}
+
+void ChangeStream::ack() {
+  engine_->get_log_manager()->set_change_stream_cursor(id_, fetched_epoch_);
+}
+
+std::ostream& operator<<(std::ostream& o, const ChangeStream& v) {
+  o << "<ChangeStream>"
+    << "<id_>" << v.id_ << "</id_>"
+    << "<storage_id_>" << v.storage_id_ << "</storage_id_>"
+    << "<fetched_epoch_>" << v.fetched_epoch_ << "</fetched_epoch_>"
+    << "<changes_>" << v.changes_.size() << "</changes_>"
+    << "</ChangeStream>";
+  return o;
+}
+
+}  // namespace log
+}  // namespace foedus
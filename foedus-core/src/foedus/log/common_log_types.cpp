@@ -17,6 +17,7 @@
  */
 #include "foedus/log/common_log_types.hpp"
 
+#include <cstring>
 #include <ostream>
 
 #include "foedus/engine.hpp"
@@ -39,6 +40,14 @@ std::ostream& operator<<(std::ostream& o, const FillerLogType &v) {
   return o;
 }
 
+std::ostream& operator<<(std::ostream& o, const CompressedBlockLogType &v) {
+  o << "<CompressedBlock>" << v.header_
+    << "<raw_length_>" << v.raw_length_ << "</raw_length_>"
+    << "<compressed_length_>" << v.compressed_length_ << "</compressed_length_>"
+    << "</CompressedBlock>";
+  return o;
+}
+
 std::ostream& operator<<(std::ostream& o, const EpochMarkerLogType& v) {
   o << "<EpochMarker>" << v.header_
     << "<old_epoch_>" << v.old_epoch_ << "</old_epoch_>"
@@ -74,6 +83,20 @@ void EpochMarkerLogType::populate(Epoch old_epoch, Epoch new_epoch,
   assert_valid();
 }
 
+void CompressedBlockLogType::populate(uint32_t raw_length, uint32_t compressed_length) {
+  header_.storage_id_ = 0;
+  header_.log_length_ = calculate_log_length(compressed_length);
+  header_.log_type_code_ = get_log_code<CompressedBlockLogType>();
+  header_.xct_id_ = xct::XctId();
+  raw_length_ = raw_length;
+  compressed_length_ = compressed_length;
+  std::memset(
+    get_data() + compressed_length,
+    0,
+    header_.log_length_ - sizeof(CompressedBlockLogType) - compressed_length);
+  assert_valid();
+}
+
 void FillerLogType::populate(uint64_t size) {
   ASSERT_ND(size < (1 << 16));
   header_.storage_id_ = 0;
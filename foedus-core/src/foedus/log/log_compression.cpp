@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/log/log_compression.hpp"
+
+#include <cstring>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/compiler.hpp"
+#include "foedus/log/common_log_types.hpp"
+
+namespace foedus {
+namespace log {
+
+/** Shortest match we encode. */
+const uint32_t kMinMatch = 4;
+/** Matches can point back at most this many bytes. */
+const uint32_t kMaxOffset = (1U << 16) - 1U;
+/** log2 of the number of entries in the hash table of compress_log_block(). */
+const uint32_t kHashBits = 12;
+
+inline uint32_t read_u32(const char* address) {
+  uint32_t ret;
+  std::memcpy(&ret, address, sizeof(ret));
+  return ret;
+}
+
+inline uint32_t hash_u32(uint32_t value) {
+  return (value * 2654435761U) >> (32U - kHashBits);
+}
+
+/** Appends a length in the 255-byte continuation format. @return false if out of capacity */
+inline bool write_extra_length(uint32_t length, char* out, uint32_t capacity, uint32_t* pos) {
+  for (; length >= 255U; length -= 255U) {
+    if (*pos >= capacity) {
+      return false;
+    }
+    out[(*pos)++] = static_cast<char>(255);
+  }
+  if (*pos >= capacity) {
+    return false;
+  }
+  out[(*pos)++] = static_cast<char>(length);
+  return true;
+}
+
+/** Reads a length in the 255-byte continuation format. @return false if out of input */
+inline bool read_extra_length(const uint8_t* in, uint32_t size, uint32_t* pos, uint32_t* length) {
+  while (true) {
+    if (*pos >= size) {
+      return false;
+    }
+    uint8_t value = in[(*pos)++];
+    *length += value;
+    if (value != 255U) {
+      return true;
+    }
+  }
+}
+
+/** Appends one sequence. match_length is 0 for the last sequence. */
+inline bool write_sequence(
+  const char* literals,
+  uint32_t literal_length,
+  uint32_t offset,
+  uint32_t match_length,
+  char* out,
+  uint32_t capacity,
+  uint32_t* pos) {
+  ASSERT_ND(match_length == 0 || match_length >= kMinMatch);
+  const uint32_t match_code = match_length == 0 ? 0 : match_length - kMinMatch;
+  if (*pos >= capacity) {
+    return false;
+  }
+  uint8_t token = (literal_length >= 15U ? 15U : literal_length) << 4;
+  token |= (match_code >= 15U ? 15U : match_code);
+  out[(*pos)++] = static_cast<char>(token);
+  if (literal_length >= 15U
+    && !write_extra_length(literal_length - 15U, out, capacity, pos)) {
+    return false;
+  }
+  if (*pos + literal_length > capacity) {
+    return false;
+  }
+  std::memcpy(out + *pos, literals, literal_length);
+  *pos += literal_length;
+  if (match_length == 0) {
+    return true;
+  }
+  if (*pos + 2U > capacity) {
+    return false;
+  }
+  ASSERT_ND(offset > 0 && offset <= kMaxOffset);
+  out[(*pos)++] = static_cast<char>(offset & 0xFFU);
+  out[(*pos)++] = static_cast<char>(offset >> 8);
+  if (match_code >= 15U && !write_extra_length(match_code - 15U, out, capacity, pos)) {
+    return false;
+  }
+  return true;
+}
+
+uint32_t compress_log_block(
+  const char* raw,
+  uint32_t raw_size,
+  char* out,
+  uint32_t out_capacity) {
+  ASSERT_ND(raw_size <= CompressedBlockLogType::kMaxRawSize);
+  // positions+1 of the last occurrence of each 4-byte hash. 0 means none.
+  uint32_t table[1U << kHashBits];
+  std::memset(table, 0, sizeof(table));
+
+  uint32_t written = 0;
+  uint32_t anchor = 0;  // beginning of literals not yet written
+  uint32_t pos = 0;
+  while (pos + kMinMatch <= raw_size) {
+    const uint32_t value = read_u32(raw + pos);
+    const uint32_t hash = hash_u32(value);
+    const uint32_t candidate = table[hash];
+    table[hash] = pos + 1U;
+    if (candidate == 0
+      || pos - (candidate - 1U) > kMaxOffset
+      || read_u32(raw + candidate - 1U) != value) {
+      ++pos;
+      continue;
+    }
+
+    const uint32_t match_from = candidate - 1U;
+    uint32_t match_length = kMinMatch;
+    while (pos + match_length < raw_size
+      && raw[match_from + match_length] == raw[pos + match_length]) {
+      ++match_length;
+    }
+    if (!write_sequence(
+      raw + anchor,
+      pos - anchor,
+      pos - match_from,
+      match_length,
+      out,
+      out_capacity,
+      &written)) {
+      return 0;
+    }
+    pos += match_length;
+    anchor = pos;
+  }
+
+  if (!write_sequence(raw + anchor, raw_size - anchor, 0, 0, out, out_capacity, &written)) {
+    return 0;
+  }
+  return written;
+}
+
+bool decompress_log_block(
+  const char* compressed,
+  uint32_t compressed_size,
+  char* out,
+  uint32_t raw_size) {
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(compressed);
+  uint32_t pos = 0;
+  uint32_t written = 0;
+  while (true) {
+    if (pos >= compressed_size) {
+      return false;  // the last sequence is missing
+    }
+    const uint8_t token = in[pos++];
+    uint32_t literal_length = token >> 4;
+    if (literal_length == 15U && !read_extra_length(in, compressed_size, &pos, &literal_length)) {
+      return false;
+    }
+    if (pos + literal_length > compressed_size || written + literal_length > raw_size) {
+      return false;
+    }
+    std::memcpy(out + written, in + pos, literal_length);
+    pos += literal_length;
+    written += literal_length;
+    if (pos == compressed_size) {
+      return written == raw_size;  // the last sequence
+    }
+
+    if (pos + 2U > compressed_size) {
+      return false;
+    }
+    const uint32_t offset = in[pos] | (static_cast<uint32_t>(in[pos + 1U]) << 8);
+    pos += 2U;
+    uint32_t match_length = token & 0x0FU;
+    if (match_length == 15U && !read_extra_length(in, compressed_size, &pos, &match_length)) {
+      return false;
+    }
+    match_length += kMinMatch;
+    if (offset == 0 || offset > written || written + match_length > raw_size) {
+      return false;
+    }
+    // the match might overlap with itself (eg repeated bytes), so copy byte by byte.
+    const char* from = out + written - offset;
+    for (uint32_t i = 0; i < match_length; ++i) {
+      out[written + i] = from[i];
+    }
+    written += match_length;
+  }
+}
+
+}  // namespace log
+}  // namespace foedus
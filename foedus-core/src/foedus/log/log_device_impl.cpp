@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/log/log_device_impl.hpp"
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif  // __x86_64__
+#include <fcntl.h>
+#include <unistd.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/assorted/assorted_func.hpp"
+#include "foedus/debugging/rdtsc.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/log/common_log_types.hpp"
+#include "foedus/log/log_options.hpp"
+#include "foedus/memory/memory_id.hpp"
+
+namespace foedus {
+namespace log {
+
+LogDevice* LogDevice::create(const fs::Path& path, const LogOptions& options) {
+  if (options.device_type_ == kLogDevicePmem) {
+    uint64_t initial_mapped_size = std::min<uint64_t>(
+      static_cast<uint64_t>(options.log_file_size_mb_) << 20,
+      PmemLogDevice::kInitialMappedSize);
+    return new PmemLogDevice(path, initial_mapped_size, options.emulation_);
+  } else {
+    return new DirectIoLogDevice(path, options.emulation_);
+  }
+}
+
+std::ostream& operator<<(std::ostream& o, const LogDevice& v) {
+  o << "<LogDevice>"
+    << "<type>" << v.get_device_name() << "</type>"
+    << "<path>" << v.get_path() << "</path>"
+    << "<opened>" << v.is_opened() << "</opened>"
+    << "<current_offset>" << v.get_current_offset() << "</current_offset>"
+    << "</LogDevice>";
+  return o;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+///       DirectIoLogDevice
+///
+////////////////////////////////////////////////////////////////////////////////
+ErrorCode DirectIoLogDevice::open() {
+  CHECK_ERROR_CODE(file_.open(true, true, true, true));
+  current_offset_ = file_.get_current_offset();
+  return kErrorCodeOk;
+}
+
+ErrorCode DirectIoLogDevice::append(uint64_t bytes, const void* buffer) {
+  ASSERT_ND(bytes % FillerLogType::kLogWriteUnitSize == 0);
+  CHECK_ERROR_CODE(file_.write_raw(bytes, buffer));
+  current_offset_ = file_.get_current_offset();
+  return kErrorCodeOk;
+}
+
+ErrorCode DirectIoLogDevice::truncate(uint64_t new_length) {
+  CHECK_ERROR_CODE(file_.truncate(new_length, true));
+  current_offset_ = file_.get_current_offset();
+  return kErrorCodeOk;
+}
+
+bool DirectIoLogDevice::make_durable() {
+  // fsync the file AND the parent folder
+  return fs::fsync(path_, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+///       PmemLogDevice
+///
+////////////////////////////////////////////////////////////////////////////////
+/** The best cache-flush instruction on this CPU. Same for all cores, so checked only once. */
+enum CacheFlushInstruction {
+  kClflush = 0,
+  kClflushopt,
+  kClwb,
+};
+
+CacheFlushInstruction detect_cache_flush_instruction() {
+#if defined(__x86_64__)
+  if (__get_cpuid_max(0, nullptr) >= 7U) {
+    uint32_t eax, ebx, ecx, edx;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    if (ebx & (1U << 24)) {
+      return kClwb;
+    } else if (ebx & (1U << 23)) {
+      return kClflushopt;
+    }
+  }
+#endif  // __x86_64__
+  return kClflush;
+}
+
+const uint64_t kCacheLineSize = 64;
+
+/**
+ * Writes back the cache lines in the range without waiting for completion. Needs an sfence.
+ * The instructions are spelled in bytes as older assemblers don't know clwb/clflushopt.
+ */
+void flush_cache_lines(const char* from, uint64_t bytes) {
+#if defined(__x86_64__)
+  static const CacheFlushInstruction kInstruction = detect_cache_flush_instruction();
+  const char* end = from + bytes;
+  for (const char* line = from; line < end; line += kCacheLineSize) {
+    if (kInstruction == kClwb) {
+      asm volatile(".byte 0x66; xsaveopt %0" : "+m" (*const_cast<char*>(line)));
+    } else if (kInstruction == kClflushopt) {
+      asm volatile(".byte 0x66; clflush %0" : "+m" (*const_cast<char*>(line)));
+    } else {
+      asm volatile("clflush %0" : "+m" (*const_cast<char*>(line)));
+    }
+  }
+#else  // __x86_64__
+  // No cache-line flush for this architecture. PmemLogDevice never sets dax_ in this case.
+  ASSERT_ND(false);
+#endif  // __x86_64__
+}
+
+PmemLogDevice::PmemLogDevice(
+  const fs::Path& path,
+  uint64_t initial_mapped_size,
+  const fs::DeviceEmulationOptions& emulation)
+  : LogDevice(path),
+    emulation_(emulation),
+    initial_mapped_size_(
+      assorted::align<uint64_t, memory::kHugepageSize>(
+        std::max<uint64_t>(initial_mapped_size, FillerLogType::kLogWriteUnitSize))),
+    descriptor_(-1),
+    mapped_(nullptr),
+    mapped_size_(0),
+    durable_offset_(0),
+    dax_(false) {
+}
+
+PmemLogDevice::~PmemLogDevice() {
+  close();
+}
+
+ErrorCode PmemLogDevice::open() {
+  if (is_opened()) {
+    return kErrorCodeFsAlreadyOpened;
+  }
+  fs::Path folder(path_.parent_path());
+  if (!fs::exists(folder) && !fs::create_directories(folder, true) && !fs::exists(folder)) {
+    LOG(ERROR) << "PmemLogDevice::open(): failed to create parent folder: " << folder
+      << ". err=" << assorted::os_error();
+    return kErrorCodeFsMkdirFailed;
+  }
+
+  mode_t permissions = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH;
+  descriptor_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_LARGEFILE, permissions);
+  if (descriptor_ < 0) {
+    LOG(ERROR) << "PmemLogDevice::open(): failed to open: " << path_
+      << ". err=" << assorted::os_error();
+    return kErrorCodeFsFailedToOpen;
+  }
+  current_offset_ = fs::file_size(path_);
+  durable_offset_ = current_offset_;
+  ASSERT_ND(current_offset_ % FillerLogType::kLogWriteUnitSize == 0);
+  uint64_t mapped_size = std::max<uint64_t>(
+    initial_mapped_size_,
+    assorted::align<uint64_t, memory::kHugepageSize>(current_offset_));
+  CHECK_ERROR_CODE(map_file(mapped_size));
+  if (!dax_ && !emulation_.null_device_) {
+    LOG(WARNING) << "PmemLogDevice: " << path_ << " is not on a DAX filesystem. Falling back to"
+      << " msync() to make logs durable. Use it only for testing and performance experiments.";
+  }
+  LOG(INFO) << "PmemLogDevice::open(): successfully opened. " << *this;
+  return kErrorCodeOk;
+}
+
+ErrorCode PmemLogDevice::map_file(uint64_t mapped_size) {
+  ASSERT_ND(is_opened());
+  ASSERT_ND(mapped_ == nullptr);
+  ASSERT_ND(mapped_size % memory::kHugepageSize == 0);
+  if (emulation_.null_device_) {
+    mapped_size_ = mapped_size;
+    return kErrorCodeOk;
+  }
+
+  // Preallocate the blocks so that page faults on the mapping never allocate blocks.
+  // Some filesystems don't support fallocate. Then a sparse file is the best we can do.
+  int ret = ::posix_fallocate(descriptor_, 0, mapped_size);
+  if (ret != 0) {
+    LOG(WARNING) << "PmemLogDevice: posix_fallocate() failed on " << path_ << ". err="
+      << assorted::os_error(ret) << ". falling back to ftruncate().";
+    if (::ftruncate(descriptor_, mapped_size) != 0) {
+      LOG(ERROR) << "PmemLogDevice: ftruncate() failed. " << *this
+        << " err=" << assorted::os_error();
+      return kErrorCodeFsTruncateFailed;
+    }
+  }
+  // make the preallocation and the file itself (if newly created) durable.
+  // This is the only place we call fsync other than truncate.
+  if (!fs::fsync(path_, true)) {
+    return kErrorCodeFsSyncFailed;
+  }
+
+  void* mapped = MAP_FAILED;
+  dax_ = false;
+#if defined(__x86_64__) && defined(MAP_SYNC) && defined(MAP_SHARED_VALIDATE)
+  // MAP_SYNC succeeds only on DAX. Then, the filesystem metadata are always in sync, and
+  // flushing cache lines is enough to make the data durable.
+  mapped = ::mmap(
+    nullptr,
+    mapped_size,
+    PROT_READ | PROT_WRITE,
+    MAP_SHARED_VALIDATE | MAP_SYNC,
+    descriptor_,
+    0);
+  dax_ = (mapped != MAP_FAILED);
+#endif  // defined(__x86_64__) && defined(MAP_SYNC) && defined(MAP_SHARED_VALIDATE)
+  if (mapped == MAP_FAILED) {
+    mapped = ::mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor_, 0);
+  }
+  if (mapped == MAP_FAILED) {
+    LOG(ERROR) << "PmemLogDevice: mmap() failed. " << *this << " err=" << assorted::os_error();
+    return kErrorCodeFsFailedToOpen;
+  }
+  mapped_ = reinterpret_cast<char*>(mapped);
+  mapped_size_ = mapped_size;
+  return kErrorCodeOk;
+}
+
+void PmemLogDevice::unmap_file() {
+  if (mapped_) {
+    if (::munmap(mapped_, mapped_size_) != 0) {
+      LOG(ERROR) << "PmemLogDevice: munmap() failed. " << *this << " err=" << assorted::os_error();
+    }
+    mapped_ = nullptr;
+  }
+  mapped_size_ = 0;
+}
+
+bool PmemLogDevice::close() {
+  if (!is_opened()) {
+    return true;
+  }
+  unmap_file();
+  bool ret = true;
+  // trim the preallocated region so that readers see the exact log size.
+  if (!emulation_.null_device_ && ::ftruncate(descriptor_, current_offset_) != 0) {
+    LOG(ERROR) << "PmemLogDevice::close(): ftruncate() failed. " << *this
+      << " err=" << assorted::os_error();
+    ret = false;
+  }
+  if (::close(descriptor_) != 0) {
+    LOG(ERROR) << "PmemLogDevice::close(): error:" << assorted::os_error() << " file=" << *this;
+    ret = false;
+  }
+  descriptor_ = -1;
+  LOG(INFO) << "PmemLogDevice::close(): closed. " << *this;
+  return ret;
+}
+
+ErrorCode PmemLogDevice::append(uint64_t bytes, const void* buffer) {
+  ASSERT_ND(bytes % FillerLogType::kLogWriteUnitSize == 0);
+  if (!is_opened()) {
+    LOG(ERROR) << "File not opened yet, or closed. this=" << *this;
+    return kErrorCodeFsNotOpened;
+  }
+  if (current_offset_ + bytes > mapped_size_) {
+    // Rare. Grow the file geometrically and remap.
+    uint64_t new_size = assorted::align<uint64_t, memory::kHugepageSize>(
+      std::max<uint64_t>(current_offset_ + bytes, mapped_size_ * 2U));
+    LOG(INFO) << "PmemLogDevice: growing " << path_ << " from " << mapped_size_ << " to "
+      << new_size << " bytes";
+    if (!make_durable()) {
+      return kErrorCodeFsSyncFailed;
+    }
+    unmap_file();
+    CHECK_ERROR_CODE(map_file(new_size));
+  }
+
+  if (!emulation_.null_device_) {
+    char* position = mapped_ + current_offset_;
+    std::memcpy(position, buffer, bytes);
+    if (dax_) {
+      flush_cache_lines(position, bytes);
+    }
+  }
+  current_offset_ += bytes;
+  if (emulation_.emulated_write_kb_cycles_ > 0) {
+    debugging::wait_rdtsc_cycles(emulation_.emulated_write_kb_cycles_ * (bytes >> 10));
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode PmemLogDevice::truncate(uint64_t new_length) {
+  ASSERT_ND(new_length % FillerLogType::kLogWriteUnitSize == 0);
+  LOG(INFO) << "PmemLogDevice::truncate(): truncating " << *this << " to " << new_length
+    << " bytes..";
+  if (!is_opened()) {
+    return kErrorCodeFsNotOpened;
+  }
+  if (emulation_.null_device_) {
+    current_offset_ = new_length;
+    durable_offset_ = new_length;
+    return kErrorCodeOk;
+  }
+
+  // drop the mapping, durably truncate the file, then preallocate and map it again.
+  const uint64_t mapped_size = mapped_size_;
+  unmap_file();
+  if (::ftruncate(descriptor_, new_length) != 0) {
+    LOG(ERROR) << "PmemLogDevice::truncate(): failed. this=" << *this
+      << " err=" << assorted::os_error();
+    return kErrorCodeFsTruncateFailed;
+  }
+  if (!fs::fsync(path_, true)) {
+    return kErrorCodeFsSyncFailed;
+  }
+  current_offset_ = new_length;
+  durable_offset_ = new_length;
+  return map_file(mapped_size);
+}
+
+bool PmemLogDevice::make_durable() {
+  ASSERT_ND(durable_offset_ <= current_offset_);
+  if (emulation_.null_device_ || durable_offset_ == current_offset_) {
+    return true;
+  }
+  if (dax_) {
+    // cache lines were already flushed in append(). wait for their completion.
+#if defined(__x86_64__)
+    asm volatile("sfence" ::: "memory");
+#endif  // __x86_64__
+  } else {
+    // msync needs page-aligned address. log offsets are 4kb-aligned, so are pages.
+    ASSERT_ND(durable_offset_ % FillerLogType::kLogWriteUnitSize == 0);
+    int ret = ::msync(mapped_ + durable_offset_, current_offset_ - durable_offset_, MS_SYNC);
+    if (ret != 0) {
+      LOG(ERROR) << "PmemLogDevice::make_durable(): msync() failed. " << *this
+        << " err=" << assorted::os_error();
+      return false;
+    }
+  }
+  durable_offset_ = current_offset_;
+  return true;
+}
+
+}  // namespace log
+}  // namespace foedus
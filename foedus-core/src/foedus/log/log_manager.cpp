@@ -46,6 +46,11 @@ void LogManager::announce_new_durable_global_epoch(Epoch new_epoch) {
 ErrorCode   LogManager::wait_until_durable(Epoch commit_epoch, int64_t wait_microseconds) {
   return pimpl_->wait_until_durable(commit_epoch, wait_microseconds);
 }
+void        LogManager::wait_for_durable_global_epoch_advance(
+  Epoch observed_epoch,
+  uint64_t wait_microseconds) {
+  pimpl_->wait_for_durable_global_epoch_advance(observed_epoch, wait_microseconds);
+}
 LoggerRef   LogManager::get_logger(LoggerId logger_id) {
   ASSERT_ND(logger_id < pimpl_->logger_refs_.size());
   return pimpl_->logger_refs_[logger_id];
@@ -57,6 +62,15 @@ ErrorStack LogManager::refresh_global_durable_epoch() {
 void LogManager::copy_logger_states(savepoint::Savepoint* new_savepoint) {
   pimpl_->copy_logger_states(new_savepoint);
 }
+void LogManager::copy_change_stream_cursors(savepoint::Savepoint* new_savepoint) {
+  pimpl_->copy_change_stream_cursors(new_savepoint);
+}
+Epoch LogManager::get_change_stream_cursor(ChangeStreamId id) const {
+  return pimpl_->get_change_stream_cursor(id);
+}
+void LogManager::set_change_stream_cursor(ChangeStreamId id, Epoch epoch) {
+  pimpl_->set_change_stream_cursor(id, epoch);
+}
 
 MetaLogBuffer* LogManager::get_meta_buffer() {
   return &pimpl_->meta_buffer_;
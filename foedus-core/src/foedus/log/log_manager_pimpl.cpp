@@ -93,6 +93,10 @@ ErrorStack LogManagerPimpl::initialize_once() {
     control_block_->durable_global_epoch_
       = engine_->get_savepoint_manager()->get_initial_durable_epoch().value();
     LOG(INFO) << "durable_global_epoch_=" << get_durable_global_epoch();
+    for (ChangeStreamId id = 0; id < kMaxChangeStreams; ++id) {
+      control_block_->change_stream_cursors_[id]
+        = engine_->get_savepoint_manager()->get_change_stream_cursor(id).value();
+    }
     meta_logger_ = new MetaLogger(engine_);
     CHECK_ERROR(meta_logger_->initialize());
   } else {
@@ -121,7 +125,8 @@ ErrorStack LogManagerPimpl::initialize_once() {
         node,
         j,
         fs::Path(folder),
-        assigned_thread_ids);
+        assigned_thread_ids,
+        &loggers_);
       CHECK_OUTOFMEMORY(logger);
       loggers_.push_back(logger);
     }
@@ -163,6 +168,10 @@ ErrorStack LogManagerPimpl::uninitialize_once() {
   } else {
     ASSERT_ND(meta_logger_ == nullptr);
   }
+  // with work stealing, a logger thread might touch other loggers. stop all of them first.
+  for (Logger* logger : loggers_) {
+    logger->stop_logger_thread();
+  }
   batch.uninitialize_and_delete_all(&loggers_);
   logger_refs_.clear();
   if (engine_->is_master()) {
@@ -265,6 +274,17 @@ ErrorCode LogManagerPimpl::wait_until_durable(Epoch commit_epoch, int64_t wait_m
   VLOG(0) << "durable epoch advanced. durable_global_epoch_=" << get_durable_global_epoch();
   return kErrorCodeOk;
 }
+void LogManagerPimpl::wait_for_durable_global_epoch_advance(
+  Epoch observed_epoch,
+  uint64_t wait_microseconds) {
+  uint64_t demand = control_block_->durable_global_epoch_advanced_.acquire_ticket();
+  // the check AFTER acquiring the ticket is required to avoid lost signal
+  if (observed_epoch < get_durable_global_epoch()) {
+    return;
+  }
+  control_block_->durable_global_epoch_advanced_.timedwait(demand, wait_microseconds);
+}
+
 void LogManagerPimpl::announce_new_durable_global_epoch(Epoch new_epoch) {
   ASSERT_ND(new_epoch >= Epoch(control_block_->durable_global_epoch_));
   control_block_->durable_global_epoch_ = new_epoch.value();
@@ -283,5 +303,12 @@ void LogManagerPimpl::copy_logger_states(savepoint::Savepoint* new_savepoint) {
   }
 }
 
+void LogManagerPimpl::copy_change_stream_cursors(savepoint::Savepoint* new_savepoint) {
+  new_savepoint->change_stream_cursors_.resize(kMaxChangeStreams);
+  for (ChangeStreamId id = 0; id < kMaxChangeStreams; ++id) {
+    new_savepoint->change_stream_cursors_[id] = control_block_->change_stream_cursors_[id];
+  }
+}
+
 }  // namespace log
 }  // namespace foedus
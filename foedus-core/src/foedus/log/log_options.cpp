@@ -31,6 +31,9 @@ LogOptions::LogOptions() {
   log_buffer_kb_ = kDefaultLogBufferKb;
   log_file_size_mb_ = kDefaultLogSizeMb;
   flush_at_shutdown_ = true;
+  device_type_ = kLogDeviceDirectIo;
+  compress_logs_ = false;
+  logger_work_stealing_ = false;
 }
 
 std::string LogOptions::convert_folder_path_pattern(int node, int logger) const {
@@ -58,6 +61,9 @@ ErrorStack LogOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, log_buffer_kb_);
   EXTERNALIZE_LOAD_ELEMENT(element, log_file_size_mb_);
   EXTERNALIZE_LOAD_ELEMENT(element, flush_at_shutdown_);
+  EXTERNALIZE_LOAD_ENUM_ELEMENT_OPTIONAL(element, device_type_, kLogDeviceDirectIo);
+  EXTERNALIZE_LOAD_ELEMENT_OPTIONAL(element, compress_logs_, false);
+  EXTERNALIZE_LOAD_ELEMENT_OPTIONAL(element, logger_work_stealing_, false);
   CHECK_ERROR(get_child_element(element, "LogDeviceEmulationOptions", &emulation_))
   return kRetOk;
 }
@@ -87,6 +93,15 @@ ErrorStack LogOptions::save(tinyxml2::XMLElement* element) const {
   EXTERNALIZE_SAVE_ELEMENT(element, log_file_size_mb_, "Size in MB of files loggers write out");
   EXTERNALIZE_SAVE_ELEMENT(element, flush_at_shutdown_,
       "Whether to flush transaction logs and take savepoint when uninitialize() is called");
+  EXTERNALIZE_SAVE_ENUM_ELEMENT(element, device_type_,
+      "Type of the device loggers write log files to. 0: block device with direct I/O and"
+      " fsync (default), 1: persistent memory on a DAX filesystem, written via mmap.");
+  EXTERNALIZE_SAVE_ELEMENT(element, compress_logs_,
+      "Whether loggers compress logs in blocks before writing them out. Readers handle both"
+      " compressed and raw logs, so this can be changed on restart.");
+  EXTERNALIZE_SAVE_ELEMENT(element, logger_work_stealing_,
+      "Whether loggers in the same NUMA node write out each other's thread buffers in the same"
+      " epoch to balance skewed log volumes. Meaningful only when loggers_per_node_ > 1.");
   CHECK_ERROR(add_child_element(element, "LogDeviceEmulationOptions",
           "[Experiments-only] Settings to emulate slower logging device", emulation_));
   return kRetOk;
@@ -22,6 +22,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cstring>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
@@ -35,9 +36,10 @@
 #include "foedus/error_stack_batch.hpp"
 #include "foedus/assorted/atomic_fences.hpp"
 #include "foedus/debugging/stop_watch.hpp"
-#include "foedus/fs/direct_io_file.hpp"
 #include "foedus/fs/filesystem.hpp"
 #include "foedus/log/common_log_types.hpp"
+#include "foedus/log/log_compression.hpp"
+#include "foedus/log/log_device_impl.hpp"
 #include "foedus/log/log_manager.hpp"
 #include "foedus/log/log_type.hpp"
 #include "foedus/log/thread_log_buffer.hpp"
@@ -56,6 +58,9 @@
 namespace foedus {
 namespace log {
 
+/** Size of Logger::compress_buffer_. Much larger than a compressed block (at most 64kb). */
+const uint64_t kCompressBufferSize = 1ULL << 20;
+
 inline bool is_log_aligned(uint64_t offset) {
   return offset % FillerLogType::kLogWriteUnitSize == 0;
 }
@@ -94,18 +99,15 @@ ErrorStack Logger::initialize_once() {
     id_,
     control_block_->current_ordinal_);
   // open the log file
-  current_file_ = new fs::DirectIoFile(current_file_path_,
-                     engine_->get_options().log_.emulation_);
-  WRAP_ERROR_CODE(current_file_->open(true, true, true, true));
+  current_file_ = LogDevice::create(current_file_path_, engine_->get_options().log_);
+  WRAP_ERROR_CODE(current_file_->open());
   if (control_block_->current_file_durable_offset_ < current_file_->get_current_offset()) {
     // there are non-durable regions as an incomplete remnant of previous execution.
     // probably there was a crash. in this case, we discard the non-durable regions.
     LOG(ERROR) << "Logger-" << id_ << "'s log file has a non-durable region. Probably there"
       << " was a crash. Will truncate it to " << control_block_->current_file_durable_offset_
       << " from " << current_file_->get_current_offset();
-    WRAP_ERROR_CODE(current_file_->truncate(
-      control_block_->current_file_durable_offset_,
-      true));  // sync right now
+    WRAP_ERROR_CODE(current_file_->truncate(control_block_->current_file_durable_offset_));
   }
   ASSERT_ND(control_block_->current_file_durable_offset_ == current_file_->get_current_offset());
   LOG(INFO) << "Initialized logger: " << *this;
@@ -116,6 +118,7 @@ ErrorStack Logger::initialize_once() {
       engine_->get_thread_pool()->get_pimpl()->get_local_group()->get_thread(
         thread::decompose_numa_local_ordinal(thread_id)));
   }
+  claims_.reset(new ThreadLogClaim[assigned_threads_.size()]);
 
   // grab a buffer to pad incomplete blocks for direct file I/O
   CHECK_ERROR(engine_->get_memory_manager()->get_local_memory()->allocate_numa_memory(
@@ -124,6 +127,14 @@ ErrorStack Logger::initialize_once() {
   ASSERT_ND(fill_buffer_.get_size() >= FillerLogType::kLogWriteUnitSize);
   ASSERT_ND(fill_buffer_.get_alignment() >= FillerLogType::kLogWriteUnitSize);
   LOG(INFO) << "Logger-" << id_ << " grabbed a padding buffer. size=" << fill_buffer_.get_size();
+  if (engine_->get_options().log_.compress_logs_) {
+    CHECK_ERROR(engine_->get_memory_manager()->get_local_memory()->allocate_numa_memory(
+      kCompressBufferSize, &compress_buffer_));
+    ASSERT_ND(!compress_buffer_.is_null());
+    ASSERT_ND(compress_buffer_.get_alignment() >= FillerLogType::kLogWriteUnitSize);
+    LOG(INFO) << "Logger-" << id_ << " compresses logs. buffer size="
+      << compress_buffer_.get_size();
+  }
   CHECK_ERROR(write_dummy_epoch_mark());
 
   // log file and buffer prepared. let's launch the logger thread
@@ -136,23 +147,27 @@ ErrorStack Logger::initialize_once() {
 ErrorStack Logger::uninitialize_once() {
   LOG(INFO) << "Uninitializing Logger-" << id_ << ": " << *this;
   ErrorStackBatch batch;
-  if (logger_thread_.joinable()) {
-    {
-      control_block_->stop_requested_ = true;
-      control_block_->wakeup_cond_.signal();
-    }
-    logger_thread_.join();
-  }
+  stop_logger_thread();
   if (current_file_) {
     current_file_->close();
     delete current_file_;
     current_file_ = nullptr;
   }
   fill_buffer_.release_block();
+  compress_buffer_.release_block();
   control_block_->uninitialize();
   return SUMMARIZE_ERROR_BATCH(batch);
 }
 
+void Logger::stop_logger_thread() {
+  if (logger_thread_.joinable()) {
+    {
+      control_block_->stop_requested_ = true;
+      control_block_->wakeup_cond_.signal();
+    }
+    logger_thread_.join();
+  }
+}
 
 void Logger::handle_logger() {
   LOG(INFO) << "Logger-" << id_ << " started. pin on NUMA node-" << static_cast<int>(numa_node_);
@@ -183,6 +198,11 @@ void Logger::handle_logger() {
         DVLOG(2) << "Logger-" << id_ << " is well catching up. will sleep.";
         break;
       }
+      if (engine_->get_options().log_.logger_work_stealing_
+        && is_ahead_of_node_loggers(durable_epoch)) {
+        DVLOG(2) << "Logger-" << id_ << " waits for other loggers in the node to catch up.";
+        break;
+      }
 
       // just for debug out
       debugging::StopWatch watch;
@@ -220,9 +240,11 @@ ErrorStack Logger::update_durable_epoch(Epoch new_durable_epoch, bool had_any_lo
       << " to " << new_durable_epoch;
 
     // BEFORE updating the epoch, fsync the file AND the parent folder
-    if (!fs::fsync(current_file_path_, true)) {
+    if (!fsync_current_file()) {
       return ERROR_STACK_MSG(kErrorCodeFsSyncFailed, to_string().c_str());
     }
+    control_block_->stat_written_bytes_
+      += current_file_->get_current_offset() - control_block_->current_file_durable_offset_;
     control_block_->current_file_durable_offset_ = current_file_->get_current_offset();
     VLOG(0) << "Logger-" << id_ << " fsynced the current file ("
       << control_block_->current_file_durable_offset_ << "  bytes so far) and its folder";
@@ -253,6 +275,19 @@ ErrorStack Logger::update_durable_epoch(Epoch new_durable_epoch, bool had_any_lo
   assert_consistent();
   return kRetOk;
 }
+bool Logger::fsync_current_file() {
+  debugging::StopWatch watch;
+  bool ret;
+  if (current_file_) {
+    ret = current_file_->make_durable();
+  } else {
+    ret = fs::fsync(current_file_path_, true);
+  }
+  control_block_->stat_fsync_latency_ns_.add(watch.stop());
+  ++control_block_->stat_fsyncs_;
+  return ret;
+}
+
 ErrorStack Logger::write_dummy_epoch_mark() {
   CHECK_ERROR(log_epoch_switch(get_durable_epoch()));
   LOG(INFO) << "Logger-" << id_ << " wrote out a dummy epoch marker at the beginning";
@@ -284,7 +319,7 @@ ErrorStack Logger::log_epoch_switch(Epoch new_epoch) {
     + sizeof(EpochMarkerLogType));
   filler_log->populate(fill_buffer_.get_size() - sizeof(EpochMarkerLogType));
 
-  WRAP_ERROR_CODE(current_file_->write(fill_buffer_.get_size(), fill_buffer_));
+  WRAP_ERROR_CODE(current_file_->append(fill_buffer_.get_size(), fill_buffer_.get_block()));
   control_block_->marked_epoch_ = new_epoch;
   add_epoch_history(*epoch_marker);
 
@@ -302,11 +337,13 @@ ErrorStack Logger::switch_file_if_required() {
   LOG(INFO) << "Logger-" << id_ << " moving on to next file. " << *this;
 
   // Close the current one. Immediately call fsync on it AND the parent folder.
+  control_block_->stat_written_bytes_
+    += current_file_->get_current_offset() - control_block_->current_file_durable_offset_;
   current_file_->close();
   delete current_file_;
   current_file_ = nullptr;
   control_block_->current_file_durable_offset_ = 0;
-  if (!fs::fsync(current_file_path_, true)) {
+  if (!fsync_current_file()) {
     return ERROR_STACK_MSG(kErrorCodeFsSyncFailed, to_string().c_str());
   }
 
@@ -315,9 +352,8 @@ ErrorStack Logger::switch_file_if_required() {
     id_,
     ++control_block_->current_ordinal_);
   LOG(INFO) << "Logger-" << id_ << " next file=" << current_file_path_;
-  current_file_ = new fs::DirectIoFile(current_file_path_,
-                      engine_->get_options().log_.emulation_);
-  WRAP_ERROR_CODE(current_file_->open(true, true, true, true));
+  current_file_ = LogDevice::create(current_file_path_, engine_->get_options().log_);
+  WRAP_ERROR_CODE(current_file_->open());
   ASSERT_ND(current_file_->get_current_offset() == 0);
   LOG(INFO) << "Logger-" << id_ << " moved on to next file. " << *this;
   CHECK_ERROR(write_dummy_epoch_mark());
@@ -326,51 +362,136 @@ ErrorStack Logger::switch_file_if_required() {
 
 ErrorStack Logger::write_one_epoch(Epoch write_epoch) {
   ASSERT_ND(get_durable_epoch().one_more() == write_epoch);
-  ASSERT_ND(write_epoch.one_more() < engine_->get_xct_manager()->get_current_global_epoch());
+  Epoch current_epoch = engine_->get_xct_manager()->get_current_global_epoch();
+  ASSERT_ND(write_epoch.one_more() < current_epoch);
+  control_block_->stat_max_epoch_lag_ = std::max<uint64_t>(
+    control_block_->stat_max_epoch_lag_,
+    current_epoch.subtract(write_epoch));
+  const bool stealing = engine_->get_options().log_.logger_work_stealing_;
   bool had_any_log = false;
-  for (thread::Thread* the_thread : assigned_threads_) {
-    ThreadLogBuffer& buffer = the_thread->get_thread_log_buffer();
-    ThreadLogBuffer::OffsetRange range = buffer.get_logs_to_write(write_epoch);
-    ASSERT_ND(range.begin_ <= buffer.get_meta().buffer_size_);
-    ASSERT_ND(range.end_ <= buffer.get_meta().buffer_size_);
-    if (range.begin_ > buffer.get_meta().buffer_size_
-      || range.end_ > buffer.get_meta().buffer_size_) {
-      LOG(FATAL) << "Logger-" << id_ << " reported an invalid buffer range for epoch-"
-        << write_epoch << ". begin=" << range.begin_ << ", end=" << range.end_
-          << " while log buffer size=" << buffer.get_meta().buffer_size_
-          << ". " << *this;
+  for (uint32_t i = 0; i < assigned_threads_.size(); ++i) {
+    ThreadLogClaim& claim = claims_[i];
+    Epoch::EpochInteger claimed = claim.claimed_epoch_.load(std::memory_order_acquire);
+    if (Epoch(claimed).is_valid() && Epoch(claimed) == write_epoch) {
+      ASSERT_ND(stealing);
+      continue;  // another logger in this node took it
+    }
+    // Only we take the buffer for the first time, so an invalid epoch is also ours to take.
+    ASSERT_ND(!Epoch(claimed).is_valid() || Epoch(claimed).one_more() == write_epoch);
+    if (!claim.claimed_epoch_.compare_exchange_strong(claimed, write_epoch.value())) {
+      ASSERT_ND(stealing);
+      ASSERT_ND(Epoch(claimed) == write_epoch);  // stolen just now
+      continue;
     }
 
-    if (!range.is_empty()) {
-      if (had_any_log == false) {
-        // First log for this epoch. Now we write out an epoch mark.
-        // If no buffers have any logs, we don't even bother writing out an epoch mark.
-        VLOG(1) << "Logger-" << id_ << " has a non-empty epoch-" << write_epoch;
-        had_any_log = true;
-        CHECK_ERROR(log_epoch_switch(write_epoch));
-      }
+    // another logger might be still writing out the previous epoch of the buffer.
+    SPINLOCK_WHILE(claim.written_epoch_.load(std::memory_order_acquire) != claimed) {
+      assorted::memory_fence_acquire();
+    }
+    ThreadLogBuffer& buffer = assigned_threads_[i]->get_thread_log_buffer();
+    CHECK_ERROR(write_thread_logs(&buffer, write_epoch, &had_any_log));
+    claim.written_epoch_.store(write_epoch.value(), std::memory_order_release);
+  }
+  if (stealing) {
+    CHECK_ERROR(steal_node_logs(write_epoch, &had_any_log));
+  }
+  CHECK_ERROR(update_durable_epoch(write_epoch, had_any_log));
+  if (stealing) {
+    wakeup_node_loggers();
+  }
+  return kRetOk;
+}
 
-      if (range.begin_ < range.end_) {
-        CHECK_ERROR(write_one_epoch_piece(buffer, write_epoch, range.begin_, range.end_));
-      } else {
-        // oh, it wraps around.
-        // let's write up to the end of the circular buffer, then from the beginning.
-        // we can simply write out logs upto the end without worrying about the case where a log
-        // entry spans the end of circular buffer. Because we avoid that in ThreadLogBuffer.
-        // (see reserve_new_log()). So, we can separately handle the two writes by calling itself
-        // again, which adds padding if they need.
-        VLOG(0) << "Wraps around. from_offset=" << range.begin_ << ", upto_offset=" << range.end_;
-        uint64_t capacity = buffer.get_meta().buffer_size_;
-        CHECK_ERROR(write_one_epoch_piece(buffer, write_epoch, range.begin_, capacity));
-        CHECK_ERROR(write_one_epoch_piece(buffer, write_epoch, 0, range.end_));
+ErrorStack Logger::write_thread_logs(
+  ThreadLogBuffer* buffer,
+  Epoch write_epoch,
+  bool* had_any_log) {
+  ThreadLogBuffer::OffsetRange range = buffer->get_logs_to_write(write_epoch);
+  ASSERT_ND(range.begin_ <= buffer->get_meta().buffer_size_);
+  ASSERT_ND(range.end_ <= buffer->get_meta().buffer_size_);
+  if (range.begin_ > buffer->get_meta().buffer_size_
+    || range.end_ > buffer->get_meta().buffer_size_) {
+    LOG(FATAL) << "Logger-" << id_ << " reported an invalid buffer range for epoch-"
+      << write_epoch << ". begin=" << range.begin_ << ", end=" << range.end_
+        << " while log buffer size=" << buffer->get_meta().buffer_size_
+        << ". " << *this;
+  }
+
+  if (!range.is_empty()) {
+    if (*had_any_log == false) {
+      // First log for this epoch. Now we write out an epoch mark.
+      // If no buffers have any logs, we don't even bother writing out an epoch mark.
+      VLOG(1) << "Logger-" << id_ << " has a non-empty epoch-" << write_epoch;
+      *had_any_log = true;
+      CHECK_ERROR(log_epoch_switch(write_epoch));
+    }
+
+    if (range.begin_ < range.end_) {
+      CHECK_ERROR(write_one_epoch_piece(*buffer, write_epoch, range.begin_, range.end_));
+    } else {
+      // oh, it wraps around.
+      // let's write up to the end of the circular buffer, then from the beginning.
+      // we can simply write out logs upto the end without worrying about the case where a log
+      // entry spans the end of circular buffer. Because we avoid that in ThreadLogBuffer.
+      // (see reserve_new_log()). So, we can separately handle the two writes by calling itself
+      // again, which adds padding if they need.
+      VLOG(0) << "Wraps around. from_offset=" << range.begin_ << ", upto_offset=" << range.end_;
+      uint64_t capacity = buffer->get_meta().buffer_size_;
+      CHECK_ERROR(write_one_epoch_piece(*buffer, write_epoch, range.begin_, capacity));
+      CHECK_ERROR(write_one_epoch_piece(*buffer, write_epoch, 0, range.end_));
+    }
+  }
+  buffer->on_log_written(write_epoch);
+  return kRetOk;
+}
+
+ErrorStack Logger::steal_node_logs(Epoch write_epoch, bool* had_any_log) {
+  const uint64_t raw_bytes_before = control_block_->stat_raw_log_bytes_;
+  for (Logger* other : *node_loggers_) {
+    if (other == this) {
+      continue;
+    }
+    // The owner goes from the first thread, so we go from the last to not collide with it.
+    for (uint32_t i = other->assigned_threads_.size(); i > 0; --i) {
+      ThreadLogClaim& claim = other->claims_[i - 1];
+      Epoch::EpochInteger claimed = claim.claimed_epoch_.load(std::memory_order_acquire);
+      if (!Epoch(claimed).is_valid() || Epoch(claimed).one_more() != write_epoch) {
+        continue;  // the owner already took it, or is not in this epoch yet.
+      }
+      if (claim.written_epoch_.load(std::memory_order_acquire) != claimed) {
+        continue;  // the previous epoch is still being written out. we never wait here.
       }
+      if (!claim.claimed_epoch_.compare_exchange_strong(claimed, write_epoch.value())) {
+        continue;
+      }
+      ThreadLogBuffer& buffer = other->assigned_threads_[i - 1]->get_thread_log_buffer();
+      DVLOG(1) << "Logger-" << id_ << " steals Thread-" << buffer.get_thread_id()
+        << "'s logs in epoch-" << write_epoch << " from Logger-" << other->id_;
+      CHECK_ERROR(write_thread_logs(&buffer, write_epoch, had_any_log));
+      claim.written_epoch_.store(write_epoch.value(), std::memory_order_release);
     }
-    buffer.on_log_written(write_epoch);
   }
-  CHECK_ERROR(update_durable_epoch(write_epoch, had_any_log));
+  control_block_->stat_stolen_log_bytes_ += control_block_->stat_raw_log_bytes_ - raw_bytes_before;
   return kRetOk;
 }
 
+bool Logger::is_ahead_of_node_loggers(Epoch durable_epoch) const {
+  for (const Logger* other : *node_loggers_) {
+    if (other != this && other->get_durable_epoch() < durable_epoch) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Logger::wakeup_node_loggers() {
+  for (Logger* other : *node_loggers_) {
+    if (other != this) {
+      other->wakeup();
+    }
+  }
+}
+
 ErrorStack Logger::write_one_epoch_piece(
   const ThreadLogBuffer& buffer,
   Epoch write_epoch,
@@ -388,6 +509,10 @@ ErrorStack Logger::write_one_epoch_piece(
 
   const char* raw_buffer = buffer.get_buffer();
   assert_written_logs(write_epoch, raw_buffer + from_offset, upto_offset - from_offset);
+  control_block_->stat_raw_log_bytes_ += upto_offset - from_offset;
+  if (!compress_buffer_.is_null()) {
+    return write_compressed_logs(raw_buffer + from_offset, upto_offset - from_offset);
+  }
 
   // 1) First-4kb. Do we have to pad at the beginning?
   if (!is_log_aligned(from_offset)) {
@@ -424,7 +549,9 @@ ErrorStack Logger::write_one_epoch_piece(
       FillerLogType* end_filler_log = reinterpret_cast<FillerLogType*>(buf);
       end_filler_log->populate(end_fill_size);
     }
-    WRAP_ERROR_CODE(current_file_->write(FillerLogType::kLogWriteUnitSize, fill_buffer_));
+    WRAP_ERROR_CODE(current_file_->append(
+      FillerLogType::kLogWriteUnitSize,
+      fill_buffer_.get_block()));
     from_offset += copy_size;
   }
 
@@ -441,7 +568,7 @@ ErrorStack Logger::write_one_epoch_piece(
   if (middle_size > 0) {
     // debugging::StopWatch watch;
     VLOG(1) << "Writing middle regions: " << middle_size << " bytes from " << from_offset;
-    WRAP_ERROR_CODE(current_file_->write_raw(middle_size, raw_buffer + from_offset));
+    WRAP_ERROR_CODE(current_file_->append(middle_size, raw_buffer + from_offset));
     // watch.stop();
     // mm, in fact too noisy... Maybe VLOG(0). but we need this information for the paper
     // LOG(INFO) << "Wrote middle regions of " << middle_size << " bytes in "
@@ -472,7 +599,81 @@ ErrorStack Logger::write_one_epoch_piece(
   FillerLogType* filler_log = reinterpret_cast<FillerLogType*>(buf);
   filler_log->populate(fill_size);
 
-  WRAP_ERROR_CODE(current_file_->write(FillerLogType::kLogWriteUnitSize, fill_buffer_));
+  WRAP_ERROR_CODE(current_file_->append(
+    FillerLogType::kLogWriteUnitSize,
+    fill_buffer_.get_block()));
+  return kRetOk;
+}
+
+ErrorStack Logger::write_compressed_logs(const char* logs, uint64_t bytes) {
+  // Logs are given at an arbitrary offset, but what we write out always starts at an aligned
+  // file offset because every piece is padded to 4kb. So, we stage the blocks from the
+  // beginning of compress_buffer_ and write out its aligned part whenever it gets full.
+  char* const staged = reinterpret_cast<char*>(compress_buffer_.get_block());
+  const uint64_t capacity = compress_buffer_.get_size();
+  uint64_t staged_size = 0;
+  uint64_t cur = 0;
+  while (cur < bytes) {
+    // collect complete logs into a block of up to kMaxRawSize.
+    uint64_t block_end = cur;
+    while (block_end < bytes) {
+      const LogHeader* header = reinterpret_cast<const LogHeader*>(logs + block_end);
+      ASSERT_ND(header->log_length_ > 0);
+      if (block_end + header->log_length_ - cur > CompressedBlockLogType::kMaxRawSize) {
+        break;
+      }
+      block_end += header->log_length_;
+    }
+    if (block_end == cur) {
+      // a log larger than kMaxRawSize. it goes out as it is.
+      block_end += reinterpret_cast<const LogHeader*>(logs + cur)->log_length_;
+    }
+    const uint64_t raw_size = block_end - cur;
+    ASSERT_ND(block_end <= bytes);
+
+    // anything we append below is at most 64kb (log_length_ is 16 bits).
+    if (staged_size + (1U << 16) > capacity) {
+      const uint64_t aligned_size = align_log_floor(staged_size);
+      WRAP_ERROR_CODE(current_file_->append(aligned_size, staged));
+      std::memmove(staged, staged + aligned_size, staged_size - aligned_size);
+      staged_size -= aligned_size;
+    }
+
+    // it's worth it only when the block log, including its header and padding, is smaller.
+    uint32_t compressed_size = 0;
+    CompressedBlockLogType* block = reinterpret_cast<CompressedBlockLogType*>(staged + staged_size);
+    const uint64_t overhead = sizeof(CompressedBlockLogType) + 8U;
+    if (raw_size <= CompressedBlockLogType::kMaxRawSize && raw_size > overhead) {
+      compressed_size = compress_log_block(
+        logs + cur,
+        raw_size,
+        block->get_data(),
+        raw_size - overhead);
+    }
+    if (compressed_size > 0) {
+      block->populate(raw_size, compressed_size);
+      ASSERT_ND(block->header_.log_length_ < raw_size);
+      staged_size += block->header_.log_length_;
+    } else {
+      std::memcpy(staged + staged_size, logs + cur, raw_size);
+      staged_size += raw_size;
+    }
+    cur = block_end;
+  }
+  ASSERT_ND(cur == bytes);
+
+  // pad the last 4kb
+  if (!is_log_aligned(staged_size)) {
+    const uint64_t fill_size = align_log_ceil(staged_size) - staged_size;
+    ASSERT_ND(fill_size % 8 == 0);
+    FillerLogType* filler_log = reinterpret_cast<FillerLogType*>(staged + staged_size);
+    filler_log->populate(fill_size);
+    staged_size += fill_size;
+  }
+  ASSERT_ND(is_log_aligned(staged_size));
+  if (staged_size > 0) {
+    WRAP_ERROR_CODE(current_file_->append(staged_size, staged));
+  }
   return kRetOk;
 }
 
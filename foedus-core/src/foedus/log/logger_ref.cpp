@@ -42,6 +42,30 @@ Epoch LoggerRef::get_durable_epoch() const {
   return Epoch(control_block_->durable_epoch_);
 }
 
+uint64_t LoggerRef::get_stat_written_bytes() const {
+  return control_block_->stat_written_bytes_;
+}
+
+uint64_t LoggerRef::get_stat_raw_log_bytes() const {
+  return control_block_->stat_raw_log_bytes_;
+}
+
+uint64_t LoggerRef::get_stat_stolen_log_bytes() const {
+  return control_block_->stat_stolen_log_bytes_;
+}
+
+uint64_t LoggerRef::get_stat_max_epoch_lag() const {
+  return control_block_->stat_max_epoch_lag_;
+}
+
+uint64_t LoggerRef::get_stat_fsyncs() const {
+  return control_block_->stat_fsyncs_;
+}
+
+const debugging::LatencyHistogram& LoggerRef::get_stat_fsync_latency_ns() const {
+  return control_block_->stat_fsync_latency_ns_;
+}
+
 void LoggerRef::wakeup_for_durable_epoch(Epoch desired_durable_epoch) {
   assorted::memory_fence_acquire();
   if (get_durable_epoch() < desired_durable_epoch) {
@@ -151,5 +175,30 @@ LogRange LoggerRef::get_log_range(Epoch prev_epoch, Epoch until_epoch) {
   return result;
 }
 
+bool LoggerRef::find_epoch_position(
+  Epoch prev_epoch,
+  LogFileOrdinal* ordinal,
+  uint64_t* offset) {
+  ASSERT_ND(prev_epoch.is_valid());
+  soc::SharedMutexScope scope(&control_block_->epoch_history_mutex_);
+  const uint32_t head = control_block_->epoch_history_head_;
+  const uint32_t count = control_block_->epoch_history_count_;
+  // Logs in epochs after the old epoch of the oldest history are all after that epoch marker.
+  // If prev_epoch is older than it, some logs we need are before the history.
+  if (count == 0 || control_block_->epoch_histories_[head].old_epoch_ > prev_epoch) {
+    return false;
+  }
+  for (uint32_t pos = 0; pos < count; ++pos) {
+    uint32_t abs_pos = control_block_->wrap_epoch_history_index(head + pos);
+    const EpochHistory& cur = control_block_->epoch_histories_[abs_pos];
+    *ordinal = cur.log_file_ordinal_;
+    *offset = cur.log_file_offset_;
+    if (cur.new_epoch_ > prev_epoch) {
+      break;
+    }
+  }
+  return true;
+}
+
 }  // namespace log
 }  // namespace foedus
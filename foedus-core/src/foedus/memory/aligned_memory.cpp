@@ -29,6 +29,8 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "foedus/assert_nd.hpp"
 #include "foedus/assorted/assorted_func.hpp"
@@ -65,7 +67,7 @@ char* alloc_mmap(uint64_t size, uint64_t alignment) {
   // std::lock_guard<std::mutex> guard(mmap_allocate_mutex);
   // we don't use MAP_POPULATE because it will block here and also serialize hugepage allocation!
   // even if we run mmap in parallel, linux serializes the looooong population in all numa nodes.
-  // lame. we will memset right after this.
+  // lame. we will prefault right after this.
   int pagesize;
   if (alignment >= (1ULL << 30)) {
     if (is_1gb_hugepage_enabled()) {
@@ -114,7 +116,8 @@ void AlignedMemory::alloc(
   uint64_t size,
   uint64_t alignment,
   AllocType alloc_type,
-  int numa_node) noexcept {
+  int numa_node,
+  bool prefault) noexcept {
   release_block();
   ASSERT_ND(block_ == nullptr);
   size_ = size;
@@ -171,13 +174,73 @@ void AlignedMemory::alloc(
   }
 
   debugging::StopWatch watch2;
-  std::memset(block_, 0, size_);  // see class comment for why we do this immediately
+  if (alloc_type_ == kPosixMemalign) {
+    std::memset(block_, 0, size_);  // see class comment for why we do this immediately
+  } else if (prefault) {
+    prefault_memory(block_, size_, numa_node);
+  } else if (::numa_available() >= 0) {
+    // pages are faulted in later by arbitrary threads. the preferred node must stick to the block
+    uint64_t nodemask = 1ULL << assorted::mod_numa_node(numa_node);
+    if (::mbind(block_, size_, MPOL_PREFERRED, &nodemask, sizeof(nodemask) * 8, 0) != 0) {
+      LOG(WARNING) << "mbind() failed. Pages might be allocated on other nodes. error="
+        << assorted::os_error() << *this;
+    }
+  }
   watch2.stop();
   if (::numa_available() >= 0) {
     ::numa_set_preferred(original_node);
   }
   LOG(INFO) << "Allocated memory in " << watch.elapsed_ns() << "+"
-    << watch2.elapsed_ns() << " ns (alloc+memset)." << *this;
+    << watch2.elapsed_ns() << " ns (alloc+" << (prefault ? "prefault" : "lazy") << ")." << *this;
+}
+
+/** We don't bother to spawn threads for blocks smaller than this. */
+const uint64_t kPrefaultParallelThreshold = 1ULL << 28;
+/** Each thread faults in at least this much */
+const uint64_t kPrefaultBytesPerThread = 1ULL << 27;
+const uint64_t kPrefaultStride = 1ULL << 12;
+
+void prefault_range(char* block, uint64_t size, int numa_node, bool pin) {
+  if (pin && ::numa_available() >= 0) {
+    int node = assorted::mod_numa_node(numa_node);
+    ::numa_run_on_node(node);
+    ::numa_set_preferred(node);
+  }
+  volatile char* address = block;
+  for (uint64_t offset = 0; offset < size; offset += kPrefaultStride) {
+    address[offset] = 0;
+  }
+}
+
+void prefault_memory(void* block, uint64_t size, int numa_node) {
+  char* address = reinterpret_cast<char*>(block);
+  uint32_t threads = 1;
+  if (size >= kPrefaultParallelThreshold) {
+    uint32_t cpus_per_node = std::thread::hardware_concurrency();
+    if (::numa_available() >= 0) {
+      cpus_per_node /= std::max(1, ::numa_num_configured_nodes());
+    }
+    threads = std::min<uint64_t>(size / kPrefaultBytesPerThread, cpus_per_node);
+  }
+  if (threads <= 1U) {
+    // the caller has already set the preferred node of this thread
+    prefault_range(address, size, numa_node, false);
+    return;
+  }
+
+  uint64_t per_thread = assorted::align<uint64_t, kPrefaultStride>(size / threads);
+  std::vector< std::thread > workers;
+  for (uint64_t offset = 0; offset < size; offset += per_thread) {
+    workers.emplace_back(
+      prefault_range,
+      address + offset,
+      std::min<uint64_t>(per_thread, size - offset),
+      numa_node,
+      true);
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
 }
 ErrorCode AlignedMemory::assure_capacity(
   uint64_t required_size,
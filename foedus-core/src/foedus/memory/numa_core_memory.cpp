@@ -59,6 +59,7 @@ uint64_t NumaCoreMemory::calculate_local_small_memory_size(const EngineOptions&
   memory_size += static_cast<uint64_t>(options.thread_.thread_count_per_group_) << 12;
   memory_size += sizeof(xct::PageVersionAccess) * xct::Xct::kMaxPageVersionSets;
   memory_size += sizeof(xct::PointerAccess) * xct::Xct::kMaxPointerSets;
+  memory_size += sizeof(xct::HotLockAccess) * xct::Xct::kMaxHotLocks;
   const xct::XctOptions& xct_opt = options.xct_;
   const uint16_t nodes = options.thread_.group_count_;
   memory_size += sizeof(xct::ReadXctAccess) * xct_opt.max_read_set_size_;
@@ -98,6 +99,8 @@ ErrorStack NumaCoreMemory::initialize_once() {
   memory += sizeof(xct::PageVersionAccess) * xct::Xct::kMaxPageVersionSets;
   small_thread_local_memory_pieces_.xct_pointer_access_memory_ = memory;
   memory += sizeof(xct::PointerAccess) * xct::Xct::kMaxPointerSets;
+  small_thread_local_memory_pieces_.xct_hot_lock_memory_ = memory;
+  memory += sizeof(xct::HotLockAccess) * xct::Xct::kMaxHotLocks;
   small_thread_local_memory_pieces_.xct_read_access_memory_ = memory;
   memory += sizeof(xct::ReadXctAccess) * xct_opt.max_read_set_size_;
   small_thread_local_memory_pieces_.xct_write_access_memory_ = memory;
@@ -73,15 +73,16 @@ ErrorStack NumaNodeMemory::initialize_once() {
     std::string("VolatilePool-")
     + std::to_string(static_cast<int>(numa_node_)));
 
-  // snapshot pool is SOC-local
+  // snapshot pool is SOC-local.
+  // Its pages are always overwritten by reads before used, so we don't prefault them here.
   uint64_t snapshot_pool_bytes
     = static_cast<uint64_t>(engine_->get_options().cache_.snapshot_cache_size_mb_per_node_) << 20;
   if (engine_->get_options().memory_.rigorous_page_boundary_check_) {
     // mprotect raises EINVAL if the underlying pages are hugepages.
     LOG(INFO) << "rigorous_page_boundary_check_ is specified, so disabled hugepages.";
-    allocate_numa_memory(snapshot_pool_bytes, &snapshot_pool_memory_);
+    allocate_numa_memory(snapshot_pool_bytes, &snapshot_pool_memory_, false);
   } else {
-    allocate_huge_numa_memory(snapshot_pool_bytes, &snapshot_pool_memory_);
+    allocate_huge_numa_memory(snapshot_pool_bytes, &snapshot_pool_memory_, false);
   }
   snapshot_pool_control_block_.alloc(1 << 12, 1 << 12, AlignedMemory::kNumaAllocOnnode, numa_node_);
   snapshot_pool_.attach(
@@ -151,7 +152,8 @@ ErrorStack NumaNodeMemory::initialize_log_buffers_memory() {
   uint64_t size_per_core_ = static_cast<uint64_t>(engine_->get_options().log_.log_buffer_kb_) << 10;
   uint64_t private_total = (cores_ * size_per_core_);
   LOG(INFO) << "Initializing log_buffer_memory_. total_size=" << private_total;
-  CHECK_ERROR(allocate_huge_numa_memory(private_total, &log_buffer_memory_));
+  // log buffers are written before read, so they are faulted in as transactions use them.
+  CHECK_ERROR(allocate_huge_numa_memory(private_total, &log_buffer_memory_, false));
   LOG(INFO) << "log_buffer_memory_ allocated. addr=" << log_buffer_memory_.get_block();
   for (auto ordinal = 0; ordinal < cores_; ++ordinal) {
     AlignedMemorySlice piece(&log_buffer_memory_, size_per_core_ * ordinal, size_per_core_);
@@ -201,15 +203,16 @@ ErrorStack NumaNodeMemory::uninitialize_once() {
 ErrorStack NumaNodeMemory::allocate_numa_memory_general(
   uint64_t size,
   uint64_t alignment,
-  AlignedMemory *out) const {
+  AlignedMemory *out,
+  bool prefault) const {
   ASSERT_ND(out);
   if (engine_->get_options().memory_.use_mmap_hugepages_ &&
     alignment >= kHugepageSize
     && size >= (1ULL << 30) * 8 / 10) {
     LOG(INFO) << "This is a big memory allocation. Let's use the mmap hugepage (1GB pages)";
-    out->alloc(size, 1ULL << 30, AlignedMemory::kNumaMmapOneGbPages, numa_node_);
+    out->alloc(size, 1ULL << 30, AlignedMemory::kNumaMmapOneGbPages, numa_node_, prefault);
   } else {
-    out->alloc(size, alignment, AlignedMemory::kNumaAllocOnnode, numa_node_);
+    out->alloc(size, alignment, AlignedMemory::kNumaAllocOnnode, numa_node_, prefault);
   }
   if (out->is_null()) {
     return ERROR_STACK(kErrorCodeOutofmemory);
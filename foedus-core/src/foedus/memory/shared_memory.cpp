@@ -37,6 +37,7 @@
 #include "foedus/assorted/assorted_func.hpp"
 #include "foedus/debugging/rdtsc.hpp"
 #include "foedus/fs/filesystem.hpp"
+#include "foedus/memory/aligned_memory.hpp"
 #include "foedus/memory/memory_id.hpp"
 
 namespace foedus {
@@ -147,10 +148,12 @@ ErrorStack SharedMemory::alloc(
     return ERROR_STACK_MSG(kErrorCodeSocShmAllocFailed, str.c_str());
   }
 
-  std::memset(block_, 0, size_);  // see class comment for why we do this immediately
-  // This memset takes a very long time due to the issue in linux kernel:
+  // see class comment for why we do this immediately. shmget() gives zero-filled memory, so
+  // touching each page is enough. This used to be a memset, which took a very long time due to
+  // the issue in linux kernel:
   // https://git.kernel.org/cgit/linux/kernel/git/torvalds/linux.git/commit/?id=8382d914ebf72092aa15cdc2a5dcedb2daa0209d
   // In linux 3.15 and later, this problem gets resolved and highly parallelizable.
+  prefault_memory(block_, size_, numa_node);
   return kRetOk;
 }
 
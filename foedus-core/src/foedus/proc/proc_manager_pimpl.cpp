@@ -28,6 +28,7 @@
 #include "foedus/error_stack_batch.hpp"
 #include "foedus/assorted/atomic_fences.hpp"
 #include "foedus/assorted/dumb_spinlock.hpp"
+#include "foedus/restart/log_replayer_impl.hpp"
 #include "foedus/soc/soc_manager.hpp"
 
 namespace foedus {
@@ -49,6 +50,12 @@ ErrorStack ProcManagerPimpl::initialize_once() {
   if (!engine_->is_master()) {
     LOG(INFO) << "Initializing ProcManager(" << engine_->describe_short() << ")..";
     get_local_data()->control_block_->initialize();
+    // Engine-internal procedures. These must be available before the master's restart manager
+    // launches them, thus registered here rather than after the engine initialization.
+    ProcAndName log_replay(restart::kLogReplayProcName, restart::LogReplayer::replay_proc);
+    if (insert(log_replay, get_local_data()) == kLocalProcInvalid) {
+      return ERROR_STACK(kErrorCodeProcProcAlreadyExists);
+    }
   }
 
   // TODO(Hideaki) load shared libraries
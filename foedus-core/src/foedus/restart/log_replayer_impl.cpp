@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/restart/log_replayer_impl.hpp"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/assorted/atomic_fences.hpp"
+#include "foedus/debugging/stop_watch.hpp"
+#include "foedus/fs/direct_io_file.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/log/common_log_types.hpp"
+#include "foedus/log/log_compression.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/log/log_type.hpp"
+#include "foedus/log/log_type_invoke.hpp"
+#include "foedus/log/logger_ref.hpp"
+#include "foedus/memory/memory_id.hpp"
+#include "foedus/proc/proc_id.hpp"
+#include "foedus/storage/storage.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_log_types.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/storage/array/array_storage_pimpl.hpp"
+#include "foedus/storage/hash/hash_hashinate.hpp"
+#include "foedus/storage/hash/hash_log_types.hpp"
+#include "foedus/storage/hash/hash_storage.hpp"
+#include "foedus/storage/hash/hash_storage_pimpl.hpp"
+#include "foedus/storage/masstree/masstree_log_types.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/storage/masstree/masstree_storage_pimpl.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace restart {
+
+/** All I/O in log files must be aligned to this size. */
+const uint64_t kIoAlignment = 1ULL << 12;
+inline uint64_t align_io_floor(uint64_t offset) { return (offset / kIoAlignment) * kIoAlignment; }
+inline uint64_t align_io_ceil(uint64_t offset) {
+  return align_io_floor(offset + kIoAlignment - 1U);
+}
+
+/**
+ * We begin/abort a dummy transaction after this number of applied logs.
+ * This is just to reset the MCS block counter in the transaction.
+ */
+const uint32_t kLogsPerXct = 1U << 10;
+
+LogReplayer::LogReplayer(Engine* engine, thread::Thread* context, const LogReplayerInput& input)
+  : engine_(engine),
+    context_(context),
+    input_(input),
+    snapshot_epoch_(input.snapshot_epoch_),
+    durable_epoch_(input.durable_epoch_) {
+  std::memset(&stat_, 0, sizeof(stat_));
+}
+
+std::string LogReplayer::to_string() const {
+  std::stringstream str;
+  str << "LogReplayer-" << input_.worker_ordinal_ << "/" << input_.worker_count_;
+  return str.str();
+}
+
+ErrorStack LogReplayer::replay_proc(const proc::ProcArguments& args) {
+  ASSERT_ND(args.input_len_ == sizeof(LogReplayerInput));
+  ASSERT_ND(args.output_buffer_size_ >= sizeof(LogReplayerOutput));
+  const LogReplayerInput* input = reinterpret_cast<const LogReplayerInput*>(args.input_buffer_);
+  LogReplayer replayer(args.engine_, args.context_, *input);
+  LogReplayerOutput* output = reinterpret_cast<LogReplayerOutput*>(args.output_buffer_);
+  CHECK_ERROR(replayer.replay(output));
+  *args.output_used_ = sizeof(LogReplayerOutput);
+  return kRetOk;
+}
+
+ErrorStack LogReplayer::replay(LogReplayerOutput* output) {
+  debugging::StopWatch watch;
+  const EngineOptions& options = engine_->get_options();
+  io_buffer_.alloc(
+    static_cast<uint64_t>(options.snapshot_.log_mapper_io_buffer_mb_) << 20,
+    memory::kHugepageSize,
+    memory::AlignedMemory::kNumaAllocOnnode,
+    context_->get_numa_node());
+
+  // 1. read all loggers' files and stage logs in this partition
+  const uint32_t logger_count = options.log_.loggers_per_node_ * options.thread_.group_count_;
+  for (log::LoggerId logger_id = 0; logger_id < logger_count; ++logger_id) {
+    CHECK_ERROR(stage_logger(logger_id));
+  }
+  io_buffer_.release_block();
+  watch.stop();
+  LOG(INFO) << to_string() << " staged " << stat_.partition_logs_ << " out of "
+    << stat_.read_logs_ << " logs in " << watch.elapsed_sec() << "s";
+
+  // 2. sort them in serialization order. stable, so logs of the same xct keep their order.
+  watch.start();
+  const char* base = staged_data_.data();
+  std::stable_sort(
+    staged_logs_.begin(),
+    staged_logs_.end(),
+    [](const StagedLog& left, const StagedLog& right) {
+      return left.xct_id_.before(right.xct_id_);
+    });
+  watch.stop();
+  LOG(INFO) << to_string() << " sorted in " << watch.elapsed_sec() << "s";
+
+  // 3. apply them
+  watch.start();
+  xct::XctManager* xct_manager = engine_->get_xct_manager();
+  for (uint64_t i = 0; i < staged_logs_.size(); i += kLogsPerXct) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context_, xct::kDirtyRead));
+    const uint64_t end = std::min<uint64_t>(staged_logs_.size(), i + kLogsPerXct);
+    for (uint64_t j = i; j < end; ++j) {
+      const log::RecordLogType* entry
+        = reinterpret_cast<const log::RecordLogType*>(base + staged_logs_[j].position_);
+      ErrorCode code = apply_log(entry);
+      if (code != kErrorCodeOk) {
+        LOG(ERROR) << to_string() << " failed to apply log: " << entry->header_;
+        WRAP_ERROR_CODE(xct_manager->abort_xct(context_));
+        return ERROR_STACK(code);
+      }
+    }
+    WRAP_ERROR_CODE(xct_manager->abort_xct(context_));
+  }
+  watch.stop();
+  LOG(INFO) << to_string() << " applied " << stat_.applied_logs_ << " logs in "
+    << watch.elapsed_sec() << "s";
+
+  staged_logs_.clear();
+  staged_data_.clear();
+  *output = stat_;
+  return kRetOk;
+}
+
+ErrorStack LogReplayer::stage_logger(log::LoggerId logger_id) {
+  const EngineOptions& options = engine_->get_options();
+  log::LoggerRef logger = engine_->get_log_manager()->get_logger(logger_id);
+  // Epoch histories are not carried over restarts. At this point, the logger only knows the
+  // dummy epoch marker it has just written at the end of the file, so we can't locate the
+  // snapshot epoch with it. Instead, we read from the beginning and filter by epoch.
+  const log::LogRange log_range = logger.get_log_range(Epoch(), durable_epoch_);
+  if (log_range.is_empty()) {
+    VLOG(0) << to_string() << " Logger-" << logger_id << " has no logs to replay";
+    return kRetOk;
+  }
+
+  const thread::ThreadGroupId node = logger_id / options.log_.loggers_per_node_;
+  char* buffer = reinterpret_cast<char*>(io_buffer_.get_block());
+  for (log::LogFileOrdinal ordinal = log_range.begin_file_ordinal;
+        ordinal <= log_range.end_file_ordinal;
+        ++ordinal) {
+    fs::Path path(options.log_.construct_suffixed_log_path(node, logger_id, ordinal));
+    const uint64_t file_size = align_io_floor(fs::file_size(path));
+    uint64_t next_infile = ordinal == log_range.begin_file_ordinal ? log_range.begin_offset : 0;
+    const uint64_t end_infile
+      = ordinal == log_range.end_file_ordinal ? log_range.end_offset : file_size;
+    ASSERT_ND(end_infile <= file_size);
+
+    fs::DirectIoFile file(path, options.log_.emulation_);
+    WRAP_ERROR_CODE(file.open(true, false, false, false));
+    while (next_infile < end_infile) {
+      // direct I/O: read from an aligned position, then skip the first few bytes.
+      const uint64_t buf_infile_aligned = align_io_floor(next_infile);
+      const uint64_t read_size = std::min<uint64_t>(
+        io_buffer_.get_size(),
+        align_io_ceil(end_infile - buf_infile_aligned));
+      WRAP_ERROR_CODE(file.seek(buf_infile_aligned, fs::DirectIoFile::kDirectIoSeekSet));
+      WRAP_ERROR_CODE(file.read(read_size, &io_buffer_));
+      const uint64_t skipped = next_infile - buf_infile_aligned;
+      const uint64_t valid_size = std::min<uint64_t>(read_size, end_infile - buf_infile_aligned);
+      uint64_t consumed;
+      WRAP_ERROR_CODE(stage_buffer(buffer + skipped, valid_size - skipped, &consumed));
+      if (consumed == 0) {
+        // a log never spans two files, and a read buffer is much larger than any log.
+        LOG(ERROR) << to_string() << " inconsistent end of log entry. offset=" << next_infile
+          << ", file=" << file;
+        return ERROR_STACK_MSG(kErrorCodeSnapshotInvalidLogEnd, path.c_str());
+      }
+      next_infile += consumed;
+    }
+    file.close();
+  }
+  return kRetOk;
+}
+
+ErrorCode LogReplayer::stage_buffer(
+  const char* buffer,
+  uint64_t buffer_size,
+  uint64_t* consumed) {
+  uint64_t cur = 0;
+  while (cur + sizeof(log::LogHeader) <= buffer_size) {
+    const log::LogHeader* header = reinterpret_cast<const log::LogHeader*>(buffer + cur);
+    ASSERT_ND(header->log_length_ > 0);
+    if (header->log_length_ + cur > buffer_size) {
+      break;  // this log goes beyond this read. read from here again.
+    }
+    cur += header->log_length_;
+    const log::LogCode type = header->get_type();
+    if (type == log::kLogCodeEpochMarker || type == log::kLogCodeFiller) {
+      continue;
+    } else if (type == log::kLogCodeCompressedBlock) {
+      const log::CompressedBlockLogType* block
+        = reinterpret_cast<const log::CompressedBlockLogType*>(header);
+      block->assert_valid();
+      decompress_buffer_.resize(block->raw_length_);
+      char* logs = decompress_buffer_.data();
+      if (!log::decompress_log_block(
+        block->get_data(),
+        block->compressed_length_,
+        logs,
+        block->raw_length_)) {
+        LOG(ERROR) << to_string() << " failed to decompress a block: " << *block;
+        return kErrorCodeLogCorruptedCompressedBlock;
+      }
+      for (uint32_t inner = 0; inner < block->raw_length_;) {
+        const log::LogHeader* inner_header = reinterpret_cast<const log::LogHeader*>(logs + inner);
+        ASSERT_ND(inner_header->log_length_ > 0);
+        inner += inner_header->log_length_;
+        if (inner_header->get_type() != log::kLogCodeFiller) {
+          stage_log(inner_header);
+        }
+      }
+      continue;
+    }
+    stage_log(header);
+  }
+  *consumed = cur;
+  return kErrorCodeOk;
+}
+
+void LogReplayer::stage_log(const log::LogHeader* header) {
+  ASSERT_ND(header->get_kind() == log::kRecordLogs);
+  ++stat_.read_logs_;
+  const Epoch epoch = header->xct_id_.get_epoch();
+  if ((snapshot_epoch_.is_valid() && epoch <= snapshot_epoch_) || epoch > durable_epoch_) {
+    return;
+  }
+  if (!engine_->get_storage_manager()->get_storage(header->storage_id_)->exists()) {
+    // the storage was dropped since then.
+    return;
+  }
+  const log::RecordLogType* entry = reinterpret_cast<const log::RecordLogType*>(header);
+  if (get_partition(entry) != input_.worker_ordinal_) {
+    return;
+  }
+  ++stat_.partition_logs_;
+  StagedLog staged;
+  staged.xct_id_ = header->xct_id_;
+  staged.position_ = staged_data_.size();
+  staged_logs_.push_back(staged);
+  const char* address = reinterpret_cast<const char*>(header);
+  staged_data_.insert(staged_data_.end(), address, address + header->log_length_);
+}
+
+uint16_t LogReplayer::get_partition(const log::RecordLogType* entry) const {
+  if (input_.worker_count_ == 1U) {
+    return 0;
+  }
+  const storage::StorageId storage_id = entry->header_.storage_id_;
+  uint64_t hash;
+  switch (entry->header_.get_type()) {
+  case log::kLogCodeArrayOverwrite:
+  case log::kLogCodeArrayIncrement:
+    hash = storage::hash::hashinate<storage::array::ArrayOffset>(
+      reinterpret_cast<const storage::array::ArrayCommonUpdateLogType*>(entry)->offset_);
+    break;
+  case log::kLogCodeHashOverwrite:
+  case log::kLogCodeHashInsert:
+  case log::kLogCodeHashDelete:
+  case log::kLogCodeHashUpdate:
+  case log::kLogCodeHashIncrement:
+    hash = reinterpret_cast<const storage::hash::HashCommonLogType*>(entry)->hash_;
+    break;
+  case log::kLogCodeMasstreeOverwrite:
+  case log::kLogCodeMasstreeInsert:
+  case log::kLogCodeMasstreeDelete:
+  case log::kLogCodeMasstreeUpdate:
+  case log::kLogCodeMasstreeIncrement:
+    {
+      const storage::masstree::MasstreeCommonLogType* casted
+        = reinterpret_cast<const storage::masstree::MasstreeCommonLogType*>(entry);
+      hash = storage::hash::hashinate(casted->get_key(), casted->key_length_);
+    }
+    break;
+  default:
+    // sequential storage has no key. appends to one storage go to one worker.
+    hash = 0;
+    break;
+  }
+  return static_cast<uint16_t>((hash + storage_id) % input_.worker_count_);
+}
+
+ErrorCode LogReplayer::apply_log(const log::RecordLogType* entry) {
+  const storage::StorageId storage_id = entry->header_.storage_id_;
+  storage::StorageControlBlock* block = engine_->get_storage_manager()->get_storage(storage_id);
+  const storage::StorageType storage_type = block->meta_.type_;
+  // invoke_apply_record() takes non-const pointers, but none of the apply methods modify logs.
+  void* mutable_entry = const_cast<log::RecordLogType*>(entry);
+  if (storage_type == storage::kSequentialStorage) {
+    // lock-free write set. just append it.
+    log::invoke_apply_record(mutable_entry, context_, storage_id, nullptr, nullptr);
+    ++stat_.applied_logs_;
+    return kErrorCodeOk;
+  }
+
+  const xct::XctId log_xct_id = entry->header_.xct_id_;
+  while (true) {
+    xct::LockableXctId* owner_id = nullptr;
+    char* payload_address = nullptr;
+    if (storage_type == storage::kArrayStorage) {
+      storage::array::ArrayStorage storage(engine_, block);
+      CHECK_ERROR_CODE(storage::array::ArrayStoragePimpl(&storage).locate_record_for_replay(
+        context_,
+        entry,
+        &owner_id,
+        &payload_address));
+    } else if (storage_type == storage::kHashStorage) {
+      storage::hash::HashStorage storage(engine_, block);
+      CHECK_ERROR_CODE(storage::hash::HashStoragePimpl(&storage).locate_record_for_replay(
+        context_,
+        entry,
+        &owner_id,
+        &payload_address));
+    } else {
+      ASSERT_ND(storage_type == storage::kMasstreeStorage);
+      storage::masstree::MasstreeStorage storage(engine_, block);
+      CHECK_ERROR_CODE(storage::masstree::MasstreeStoragePimpl(&storage).locate_record_for_replay(
+        context_,
+        entry,
+        &owner_id,
+        &payload_address));
+    }
+    ASSERT_ND(owner_id);
+
+    xct::McsLockScope scope(context_, owner_id);
+    if (UNLIKELY(owner_id->xct_id_.is_moved() || owner_id->xct_id_.is_next_layer())) {
+      // the record was migrated after we located it. locate it again.
+      VLOG(0) << to_string() << " the record was moved during replay. retry";
+      continue;
+    }
+    // same protocol as XctManagerPimpl::precommit_xct_apply()
+    owner_id->xct_id_.set_being_written();
+    assorted::memory_fence_release();
+    log::invoke_apply_record(mutable_entry, context_, storage_id, owner_id, payload_address);
+    assorted::memory_fence_release();
+    xct::XctId new_xct_id = log_xct_id;
+    new_xct_id.clear_status_bits();
+    if (owner_id->xct_id_.is_deleted()) {
+      new_xct_id.set_deleted();
+    }
+    owner_id->xct_id_ = new_xct_id;  // also clears being_written
+    ++stat_.applied_logs_;
+    return kErrorCodeOk;
+  }
+}
+
+}  // namespace restart
+}  // namespace foedus
@@ -19,20 +19,28 @@
 
 #include <glog/logging.h>
 
+#include <cstring>
+#include <vector>
+
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
 #include "foedus/epoch.hpp"
 #include "foedus/error_stack_batch.hpp"
+#include "foedus/debugging/stop_watch.hpp"
 #include "foedus/fs/direct_io_file.hpp"
 #include "foedus/log/common_log_types.hpp"
 #include "foedus/log/log_manager.hpp"
 #include "foedus/memory/aligned_memory.hpp"
+#include "foedus/restart/log_replayer_impl.hpp"
 #include "foedus/savepoint/savepoint_manager.hpp"
 #include "foedus/snapshot/snapshot_manager.hpp"
 #include "foedus/snapshot/snapshot_manager_pimpl.hpp"
 #include "foedus/soc/soc_manager.hpp"
 #include "foedus/storage/storage_log_types.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_log_types.hpp"
+#include "foedus/thread/impersonate_session.hpp"
+#include "foedus/thread/thread_pool.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
@@ -92,6 +100,12 @@ ErrorStack RestartManagerPimpl::recover() {
 
   LOG(INFO) << "There are logs that are durable but not yet snapshotted.";
   CHECK_ERROR(redo_meta_logs(durable_epoch, snapshot_epoch));
+  if (engine_->get_options().restart_.enable_log_replay_) {
+    LOG(INFO) << "Replaying logs instead of taking a snapshot..";
+    CHECK_ERROR(replay_logs(durable_epoch, snapshot_epoch));
+    LOG(INFO) << "Finished log replay during start-up. Now we can start processing transaction";
+    return kRetOk;
+  }
   LOG(INFO) << "Launching snapshot..";
   snapshot::SnapshotManagerPimpl* snapshot_pimpl = engine_->get_snapshot_manager()->get_pimpl();
   snapshot::Snapshot the_snapshot;
@@ -141,7 +155,10 @@ ErrorStack RestartManagerPimpl::redo_meta_logs(Epoch durable_epoch, Epoch snapsh
     }
     Epoch epoch = entry->header_.xct_id_.get_epoch();
     ASSERT_ND(epoch <= durable_epoch);
-    if (snapshot_epoch.is_valid() && epoch < snapshot_epoch) {
+    // Every metadata operation is applied to the storage control block before
+    // MetaLogBuffer::commit() issues its epoch. A snapshot of that epoch is taken only after the
+    // epoch is durable, so the snapshot metadata already reflects the operation.
+    if (snapshot_epoch.is_valid() && epoch <= snapshot_epoch) {
       continue;
     }
     switch (type) {
@@ -159,6 +176,13 @@ ErrorStack RestartManagerPimpl::redo_meta_logs(Epoch durable_epoch, Epoch snapsh
           entry->header_.storage_id_);
         ++processed;
         break;
+      case log::kLogCodeArrayExtend:
+        LOG(INFO) << "Redoing EXTEND ARRAY-" << entry->header_.storage_id_;
+        reinterpret_cast<storage::array::ArrayExtendLogType*>(entry)->apply_storage(
+          engine_,
+          entry->header_.storage_id_);
+        ++processed;
+        break;
       default:
         LOG(ERROR) << "Unexpected log type in metadata log:" << entry->header_;
     }
@@ -169,5 +193,65 @@ ErrorStack RestartManagerPimpl::redo_meta_logs(Epoch durable_epoch, Epoch snapsh
   return kRetOk;
 }
 
+ErrorStack RestartManagerPimpl::replay_logs(Epoch durable_epoch, Epoch snapshot_epoch) {
+  const EngineOptions& options = engine_->get_options();
+  const uint16_t soc_count = options.thread_.group_count_;
+  uint16_t threads_per_node = options.restart_.replay_threads_per_node_;
+  if (threads_per_node == 0 || threads_per_node > options.thread_.thread_count_per_group_) {
+    threads_per_node = options.thread_.thread_count_per_group_;
+  }
+  const uint16_t worker_count = threads_per_node * soc_count;
+  LOG(INFO) << "Replaying logs from " << snapshot_epoch << " to " << durable_epoch << " with "
+    << worker_count << " workers";
+
+  debugging::StopWatch watch;
+  thread::ThreadPool* pool = engine_->get_thread_pool();
+  std::vector<thread::ImpersonateSession> sessions(worker_count);
+  ErrorStackBatch batch;
+  for (uint16_t ordinal = 0; ordinal < worker_count; ++ordinal) {
+    LogReplayerInput input;
+    input.worker_ordinal_ = ordinal;
+    input.worker_count_ = worker_count;
+    input.snapshot_epoch_ = snapshot_epoch.value();
+    input.durable_epoch_ = durable_epoch.value();
+    const thread::ThreadGroupId node = ordinal / threads_per_node;
+    if (!pool->impersonate_on_numa_node(
+      node,
+      kLogReplayProcName,
+      &input,
+      sizeof(input),
+      &sessions[ordinal])) {
+      LOG(ERROR) << "Couldn't launch log replayer-" << ordinal << " on node-" << node;
+      batch.emprace_back(ERROR_STACK(kErrorCodeThrNoThreadAvailable));
+      break;
+    }
+  }
+
+  LogReplayerOutput total;
+  std::memset(&total, 0, sizeof(total));
+  for (thread::ImpersonateSession& session : sessions) {
+    if (!session.is_valid()) {
+      continue;
+    }
+    ErrorStack result = session.get_result();
+    if (result.is_error()) {
+      batch.push_back(result);
+    } else {
+      ASSERT_ND(session.get_output_size() == sizeof(LogReplayerOutput));
+      LogReplayerOutput output;
+      session.get_output(&output);
+      total.read_logs_ += output.read_logs_;
+      total.partition_logs_ += output.partition_logs_;
+      total.applied_logs_ += output.applied_logs_;
+    }
+    session.release();
+  }
+  CHECK_ERROR(SUMMARIZE_ERROR_BATCH(batch));
+  watch.stop();
+  LOG(INFO) << "Replayed logs in " << watch.elapsed_sec() << "s. applied=" << total.applied_logs_
+    << ", staged=" << total.partition_logs_ << ", read (sum of all workers)=" << total.read_logs_;
+  return kRetOk;
+}
+
 }  // namespace restart
 }  // namespace foedus
@@ -20,14 +20,26 @@
 namespace foedus {
 namespace restart {
 RestartOptions::RestartOptions() {
+  enable_log_replay_ = false;
+  replay_threads_per_node_ = kDefaultReplayThreadsPerNode;
 }
 
-ErrorStack RestartOptions::load(tinyxml2::XMLElement* /*element*/) {
+ErrorStack RestartOptions::load(tinyxml2::XMLElement* element) {
+  EXTERNALIZE_LOAD_ELEMENT(element, enable_log_replay_);
+  EXTERNALIZE_LOAD_ELEMENT(element, replay_threads_per_node_);
   return kRetOk;
 }
 
 ErrorStack RestartOptions::save(tinyxml2::XMLElement* element) const {
   CHECK_ERROR(insert_comment(element, "Set of options for restart manager"));
+
+  EXTERNALIZE_SAVE_ELEMENT(element, enable_log_replay_,
+    "Whether to recover by replaying durable logs onto volatile pages in parallel.\n"
+    " If false (default), restart takes a snapshot of not-yet-snapshotted logs before accepting"
+    " transactions. If true, restart skips the startup snapshot.");
+  EXTERNALIZE_SAVE_ELEMENT(element, replay_threads_per_node_,
+    "Number of worker threads in each NUMA node to replay logs in parallel."
+    " Used only when enable_log_replay_ is true. 0 (default) means all threads in the node.");
   return kRetOk;
 }
 
@@ -45,6 +45,8 @@ ErrorStack Savepoint::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, oldest_log_files_offset_begin_);
   EXTERNALIZE_LOAD_ELEMENT(element, current_log_files_);
   EXTERNALIZE_LOAD_ELEMENT(element, current_log_files_offset_durable_);
+  CHECK_ERROR(get_element(element, "change_stream_cursors_", &change_stream_cursors_, true));
+  change_stream_cursors_.resize(log::kMaxChangeStreams, Epoch::kEpochInvalid);
   assert_epoch_values();
   return kRetOk;
 }
@@ -73,6 +75,8 @@ ErrorStack Savepoint::save(tinyxml2::XMLElement* element) const {
                "Indicates the log file each logger is currently appending to");
   EXTERNALIZE_SAVE_ELEMENT(element, current_log_files_offset_durable_,
             "Indicates the exclusive end of durable region in the current log file");
+  EXTERNALIZE_SAVE_ELEMENT(element, change_stream_cursors_,
+            "Epoch up to which each change stream consumer has acknowledged changes");
   return kRetOk;
 }
 
@@ -88,6 +92,7 @@ void Savepoint::populate_empty(log::LoggerId logger_count) {
   oldest_log_files_offset_begin_.resize(logger_count, 0);
   current_log_files_.resize(logger_count, 0);
   current_log_files_offset_durable_.resize(logger_count, 0);
+  change_stream_cursors_.resize(log::kMaxChangeStreams, Epoch::kEpochInvalid);
   assert_epoch_values();
 }
 
@@ -111,6 +116,13 @@ void FixedSavepoint::update(
     logger_info_[i].current_log_file_ = src.current_log_files_[i];
     logger_info_[i].current_log_file_offset_durable_ = src.current_log_files_offset_durable_[i];
   }
+  for (uint16_t i = 0; i < log::kMaxChangeStreams; ++i) {
+    if (i < src.change_stream_cursors_.size()) {
+      change_stream_cursors_[i] = src.change_stream_cursors_[i];
+    } else {
+      change_stream_cursors_[i] = Epoch::kEpochInvalid;
+    }
+  }
 }
 
 }  // namespace savepoint
@@ -17,6 +17,7 @@
  */
 #include "foedus/savepoint/savepoint_manager.hpp"
 
+#include "foedus/assert_nd.hpp"
 #include "foedus/savepoint/savepoint_manager_pimpl.hpp"
 
 namespace foedus {
@@ -73,5 +74,10 @@ void SavepointManager::get_meta_logger_offsets(
   *durable_offset = pimpl_->control_block_->savepoint_.meta_log_durable_offset_;
 }
 
+Epoch SavepointManager::get_change_stream_cursor(log::ChangeStreamId id) const {
+  ASSERT_ND(id < log::kMaxChangeStreams);
+  return Epoch(pimpl_->control_block_->savepoint_.change_stream_cursors_[id]);
+}
+
 }  // namespace savepoint
 }  // namespace foedus
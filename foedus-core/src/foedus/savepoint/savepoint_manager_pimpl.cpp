@@ -177,6 +177,7 @@ void SavepointManagerPimpl::savepoint_main() {
       new_savepoint.durable_epoch_ = new_durable_epoch.value();
       new_savepoint.earliest_epoch_ = engine_->get_earliest_epoch().value();
       engine_->get_log_manager()->copy_logger_states(&new_savepoint);
+      engine_->get_log_manager()->copy_change_stream_cursors(&new_savepoint);
 
       if (control_block_->new_snapshot_id_ != snapshot::kNullSnapshotId) {
         new_savepoint.latest_snapshot_id_ = control_block_->new_snapshot_id_;
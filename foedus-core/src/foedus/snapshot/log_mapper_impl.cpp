@@ -20,6 +20,7 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <cstring>
 #include <ostream>
 #include <string>
 
@@ -32,6 +33,8 @@
 #include "foedus/debugging/stop_watch.hpp"
 #include "foedus/fs/direct_io_file.hpp"
 #include "foedus/fs/filesystem.hpp"
+#include "foedus/log/common_log_types.hpp"
+#include "foedus/log/log_compression.hpp"
 #include "foedus/log/log_manager.hpp"
 #include "foedus/log/log_type.hpp"
 #include "foedus/log/logger_impl.hpp"
@@ -39,6 +42,7 @@
 #include "foedus/snapshot/log_gleaner_impl.hpp"
 #include "foedus/snapshot/log_reducer_impl.hpp"
 #include "foedus/snapshot/snapshot.hpp"
+#include "foedus/soc/soc_id.hpp"
 #include "foedus/storage/partitioner.hpp"
 #include "foedus/storage/storage_manager.hpp"
 #include "foedus/storage/hash/hash_log_types.hpp"
@@ -57,6 +61,8 @@ uint16_t calculate_logger_id(Engine* engine, uint16_t local_ordinal) {
 
 LogMapper::LogMapper(Engine* engine, uint16_t local_ordinal)
   : MapReduceBase(engine, calculate_logger_id(engine, local_ordinal)),
+    io_read_size_(0),
+    decompressed_size_(0),
     processed_log_count_(0) {
   clear_storage_buckets();
 }
@@ -66,8 +72,10 @@ ErrorStack LogMapper::initialize_once() {
 
   uint64_t io_buffer_size = static_cast<uint64_t>(option.log_mapper_io_buffer_mb_) << 20;
   io_buffer_size = assorted::align<uint64_t, memory::kHugepageSize>(io_buffer_size);
+  io_read_size_ = io_buffer_size;
+  decompressed_size_ = 0;
   io_buffer_.alloc(
-    io_buffer_size,
+    io_buffer_size + kDecompressAreaSize,
     memory::kHugepageSize,
     memory::AlignedMemory::kNumaAllocOnnode,
     numa_node_);
@@ -106,8 +114,8 @@ ErrorStack LogMapper::initialize_once() {
   tmp_offset += kSendBufferSize;
   tmp_position_array_slice_ = memory::AlignedMemorySlice(&tmp_memory_, tmp_offset, kBucketSize);
   tmp_offset += kBucketSize;
-  tmp_sort_array_slice_ = memory::AlignedMemorySlice(&tmp_memory_, tmp_offset, kBucketSize << 1);
-  tmp_offset += kBucketSize << 1;
+  tmp_grouped_array_slice_ = memory::AlignedMemorySlice(&tmp_memory_, tmp_offset, kBucketSize);
+  tmp_offset += kBucketSize;
   const uint64_t hashlist_bytesize = kBucketHashListMaxCount * sizeof(BucketHashList);
   tmp_hashlist_buffer_slice_ = memory::AlignedMemorySlice(
     &tmp_memory_, tmp_offset, hashlist_bytesize);
@@ -158,7 +166,7 @@ ErrorStack LogMapper::handle_process() {
   // Lengthy, but otherwise it's so confusing.
   processed_log_count_ = 0;
   IoBufStatus status;
-  status.size_inbuf_aligned_ = io_buffer_.get_size();
+  status.size_inbuf_aligned_ = io_read_size_;
   status.cur_file_ordinal_ = log_range.begin_file_ordinal;
   status.ended_ = false;
   status.first_read_ = true;
@@ -204,7 +212,7 @@ ErrorStack LogMapper::handle_process() {
       WRAP_ERROR_CODE(file.seek(status.buf_infile_aligned_, fs::DirectIoFile::kDirectIoSeekSet));
       DVLOG(1) << to_string() << " seeked to: " << assorted::Hex(status.buf_infile_aligned_);
       status.end_inbuf_aligned_ = std::min(
-        io_buffer_.get_size(),
+        io_read_size_,
         align_io_ceil(status.end_infile_ - status.buf_infile_aligned_));
       ASSERT_ND(status.end_inbuf_aligned_ % kIoAlignment == 0);
       WRAP_ERROR_CODE(file.read(status.end_inbuf_aligned_, &io_buffer_));
@@ -255,6 +263,7 @@ ErrorStack LogMapper::handle_process_buffer(const fs::DirectIoFile &file, IoBufS
   // many temporary memory are used only within this method and completely cleared out
   // for every call.
   clear_storage_buckets();
+  decompressed_size_ = 0;
 
   char* buffer = reinterpret_cast<char*>(io_buffer_.get_block());
   status->more_in_the_file_ = false;
@@ -270,7 +279,8 @@ ErrorStack LogMapper::handle_process_buffer(const fs::DirectIoFile &file, IoBufS
     ASSERT_ND(!status->first_read_ || header->get_type() == log::kLogCodeEpochMarker);
     ASSERT_ND(header->get_kind() == log::kRecordLogs
       || header->get_type() == log::kLogCodeEpochMarker
-      || header->get_type() == log::kLogCodeFiller);
+      || header->get_type() == log::kLogCodeFiller
+      || header->get_type() == log::kLogCodeCompressedBlock);
 
     if (UNLIKELY(header->log_length_ + status->cur_inbuf_ > status->end_inbuf_aligned_)) {
       // if a log goes beyond this read, stop processing here and read from that offset again.
@@ -307,23 +317,12 @@ ErrorStack LogMapper::handle_process_buffer(const fs::DirectIoFile &file, IoBufS
       }
     } else if (UNLIKELY(header->get_type() == log::kLogCodeFiller)) {
       // skip filler log
+    } else if (UNLIKELY(header->get_type() == log::kLogCodeCompressedBlock)) {
+      CHECK_ERROR(handle_compressed_block(
+        file,
+        reinterpret_cast<const log::CompressedBlockLogType*>(header)));
     } else {
-      bool bucketed = bucket_log(header->storage_id_, status->cur_inbuf_);
-      if (UNLIKELY(!bucketed)) {
-        // need to add a new bucket
-        bool added = add_new_bucket(header->storage_id_);
-        if (added) {
-          bucketed = bucket_log(header->storage_id_, status->cur_inbuf_);
-          ASSERT_ND(bucketed);
-        } else {
-          // runs out of bucket_memory. have to flush now.
-          flush_all_buckets();
-          added = add_new_bucket(header->storage_id_);
-          ASSERT_ND(added);
-          bucketed = bucket_log(header->storage_id_, status->cur_inbuf_);
-          ASSERT_ND(bucketed);
-        }
-      }
+      bucket_log_or_flush(header->storage_id_, status->cur_inbuf_);
     }
 
     status->cur_inbuf_ += header->log_length_;
@@ -343,6 +342,62 @@ ErrorStack LogMapper::handle_process_buffer(const fs::DirectIoFile &file, IoBufS
   return kRetOk;
 }
 
+ErrorStack LogMapper::handle_compressed_block(
+  const fs::DirectIoFile &file,
+  const log::CompressedBlockLogType* block) {
+  block->assert_valid();
+  if (decompressed_size_ + block->raw_length_ > kDecompressAreaSize) {
+    // the decompress area is full. positions in it are no longer needed after flushing.
+    flush_all_buckets();
+    decompressed_size_ = 0;
+  }
+  const uint64_t begin_inbuf = io_read_size_ + decompressed_size_;
+  char* logs = reinterpret_cast<char*>(io_buffer_.get_block()) + begin_inbuf;
+  if (!log::decompress_log_block(
+    block->get_data(),
+    block->compressed_length_,
+    logs,
+    block->raw_length_)) {
+    LOG(ERROR) << to_string() << " failed to decompress a block. file=" << file
+      << ", log=" << *block;
+    return ERROR_STACK_MSG(kErrorCodeLogCorruptedCompressedBlock, file.get_path().c_str());
+  }
+  decompressed_size_ += block->raw_length_;
+
+  for (uint64_t cur = 0; cur < block->raw_length_; ++processed_log_count_) {
+    const log::LogHeader* header = reinterpret_cast<const log::LogHeader*>(logs + cur);
+    ASSERT_ND(header->log_length_ > 0);
+    ASSERT_ND(cur + header->log_length_ <= block->raw_length_);
+    // a block contains only what the logger copied from worker threads' buffers
+    ASSERT_ND(header->get_kind() == log::kRecordLogs
+      || header->get_type() == log::kLogCodeFiller);
+    if (header->get_type() != log::kLogCodeFiller) {
+      bucket_log_or_flush(header->storage_id_, begin_inbuf + cur);
+    }
+    cur += header->log_length_;
+  }
+  return kRetOk;
+}
+
+inline void LogMapper::bucket_log_or_flush(storage::StorageId storage_id, uint64_t pos) {
+  bool bucketed = bucket_log(storage_id, pos);
+  if (UNLIKELY(!bucketed)) {
+    // need to add a new bucket
+    bool added = add_new_bucket(storage_id);
+    if (added) {
+      bucketed = bucket_log(storage_id, pos);
+      ASSERT_ND(bucketed);
+    } else {
+      // runs out of bucket_memory. have to flush now.
+      flush_all_buckets();
+      added = add_new_bucket(storage_id);
+      ASSERT_ND(added);
+      bucketed = bucket_log(storage_id, pos);
+      ASSERT_ND(bucketed);
+    }
+  }
+}
+
 inline bool LogMapper::bucket_log(storage::StorageId storage_id, uint64_t pos) {
   BucketHashList* hashlist = find_storage_hashlist(storage_id);
   if (UNLIKELY(hashlist == nullptr)) {
@@ -447,8 +502,8 @@ void LogMapper::flush_bucket(const BucketHashList& hashlist) {
   // temporary variables to store partitioning results
   BufferPosition* position_array = reinterpret_cast<BufferPosition*>(
     tmp_position_array_slice_.get_block());
-  PartitionSortEntry* sort_array = reinterpret_cast<PartitionSortEntry*>(
-    tmp_sort_array_slice_.get_block());
+  BufferPosition* grouped_array = reinterpret_cast<BufferPosition*>(
+    tmp_grouped_array_slice_.get_block());
   storage::PartitionId* partition_array = reinterpret_cast<storage::PartitionId*>(
     tmp_partition_array_slice_.get_block());
   LogBuffer log_buffer(reinterpret_cast<char*>(io_buffer_.get_block()));
@@ -490,38 +545,33 @@ void LogMapper::flush_bucket(const BucketHashList& hashlist) {
           partition_array};
         partitioner.partition_batch(args);
 
-        // sort the log positions by the calculated partitions
-        std::memset(sort_array, 0, sizeof(PartitionSortEntry) * bucket->counts_);
-        for (uint32_t i = 0; i < bucket->counts_; ++i) {
-          sort_array[i].set(partition_array[i], bucket->log_positions_[i]);
-        }
-        std::sort(sort_array, sort_array + bucket->counts_);
+        // group the log positions by the calculated partitions
+        const uint16_t partition_count = engine_->get_soc_count();
+        uint32_t partition_begins[soc::kMaxSocs + 1U];
+        storage::Partitioner::GroupByPartitionArguments group_args = {
+          position_array,
+          partition_array,
+          bucket->counts_,
+          partition_count,
+          grouped_array,
+          partition_begins};
+        storage::Partitioner::group_by_partition(group_args);
 
-        // let's reuse the current bucket as a temporary memory to hold sorted entries.
+        // let's reuse the current bucket as a temporary memory to hold grouped entries.
         // buckets are discarded after the flushing, so this doesn't cause any issue.
-        const uint32_t original_count = bucket->counts_;
-        storage::PartitionId current_partition = sort_array[0].partition_;
-        bucket->log_positions_[0] = sort_array[0].position_;
-        bucket->counts_ = 1;
-        for (uint32_t i = 1; i < original_count; ++i) {
-          if (current_partition == sort_array[i].partition_) {
-            bucket->log_positions_[bucket->counts_] = sort_array[i].position_;
-            ++bucket->counts_;
-            ASSERT_ND(bucket->counts_ <= original_count);
-          } else {
-            // the current partition has ended.
-            // let's send out these log entries to this partition
-            send_bucket_partition(bucket, current_partition);
-            // this is the beginning of next partition
-            current_partition = sort_array[i].partition_;
-            bucket->log_positions_[0] = sort_array[i].position_;
-            bucket->counts_ = 1;
+        for (uint16_t partition = 0; partition < partition_count; ++partition) {
+          const uint32_t begin = partition_begins[partition];
+          const uint32_t end = partition_begins[partition + 1U];
+          if (begin == end) {
+            continue;
           }
+          std::memcpy(
+            bucket->log_positions_,
+            grouped_array + begin,
+            sizeof(BufferPosition) * (end - begin));
+          bucket->counts_ = end - begin;
+          send_bucket_partition(bucket, static_cast<storage::PartitionId>(partition));
         }
-
-        ASSERT_ND(bucket->counts_ > 0);
-        // send out the last partition
-        send_bucket_partition(bucket, current_partition);
       } else {
         // in this case, it's same as single partition regarding this storage.
         send_bucket_partition(bucket, 0);
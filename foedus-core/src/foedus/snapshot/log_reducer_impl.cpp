@@ -71,13 +71,7 @@ ErrorStack LogReducer::initialize_once() {
 
   const SnapshotOptions& option = engine_->get_options().snapshot_;
 
-  uint64_t dump_buffer_size = static_cast<uint64_t>(option.log_reducer_dump_io_buffer_mb_) << 20;
-  dump_io_buffer_.alloc(
-    dump_buffer_size,
-    memory::kHugepageSize,
-    memory::AlignedMemory::kNumaAllocOnnode,
-    get_numa_node());
-  ASSERT_ND(!dump_io_buffer_.is_null());
+  alloc_dump_io_buffer();
 
   // start from 1/16 of the main buffer. Should be big enough.
   sort_buffer_.alloc(
@@ -131,7 +125,24 @@ ErrorStack LogReducer::uninitialize_once() {
   return SUMMARIZE_ERROR_BATCH(batch);
 }
 
+void LogReducer::alloc_dump_io_buffer() {
+  const SnapshotOptions& option = engine_->get_options().snapshot_;
+  uint64_t dump_buffer_size = static_cast<uint64_t>(option.log_reducer_dump_io_buffer_mb_) << 20;
+  dump_io_buffer_.alloc(
+    dump_buffer_size,
+    memory::kHugepageSize,
+    memory::AlignedMemory::kNumaAllocOnnode,
+    get_numa_node());
+  ASSERT_ND(!dump_io_buffer_.is_null());
+}
+
 ErrorStack LogReducer::handle_process() {
+  // The reducer object lives across snapshots. The gleaner cleared the control block,
+  // and merge_sort() of the previous snapshot released the dump IO buffer.
+  sorted_runs_ = 0;
+  if (dump_io_buffer_.is_null()) {
+    alloc_dump_io_buffer();
+  }
   while (true) {
     std::this_thread::sleep_for(std::chrono::milliseconds(10));
     WRAP_ERROR_CODE(check_cancelled());
@@ -861,10 +872,11 @@ ErrorCode LogReducer::merge_sort_advance_sort_buffers(
     uint64_t skip_bytes = from_buffer_position(next_header->block_length_);
     next_block_header_pos += skip_bytes;
     VLOG(1) << to_string() << " skipped a filler block. " << skip_bytes << " bytes";
-    if (next_block_header_pos + sizeof(FullBlockHeader)
-      > buffer->get_offset() + buffer->get_buffer_size()) {
+    if (next_block_header_pos < buffer->get_total_size()
+      && next_block_header_pos + sizeof(FullBlockHeader)
+        > buffer->get_offset() + buffer->get_buffer_size()) {
       // we have to at least read the header of next block. if we unluckily hit
-      // the boundary here, wind it.
+      // the boundary here, wind it. a filler at the end of the file has no next block.
       LOG(INFO) << to_string() << " wow, we unluckily hit buffer boundary while skipping"
         << " a filler block. it's rare!";
       CHECK_ERROR_CODE(buffer->wind(next_block_header_pos));
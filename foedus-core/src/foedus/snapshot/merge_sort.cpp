@@ -20,6 +20,7 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <cstring>
 
 #include "foedus/epoch.hpp"
 #include "foedus/assorted/assorted_func.hpp"
@@ -43,6 +44,11 @@ const MergeSort::InputIndex kInvalidInput = static_cast<MergeSort::InputIndex>(-
  * This means we have to memmove 5% everytime, but instead we can avoid many-small batches.
  */
 const float kWindowMoveThreshold = 0.95;
+/**
+ * Head of a run that has no more entries. No SortEntry has this value because its position
+ * is less than kMaxMergedPosition, thus its lowest 23 bits are never all 1.
+ */
+const __uint128_t kExhaustedRun = ~static_cast<__uint128_t>(0);
 
 
 uint16_t extract_shortest_key_length(SortedBuffer* const* inputs, uint16_t inputs_count) {
@@ -88,6 +94,15 @@ MergeSort::MergeSort(
   position_entries_ = nullptr;
   original_pages_ = nullptr;
   inputs_status_ = nullptr;
+  merge_entries_ = nullptr;
+  run_begins_ = nullptr;
+  run_cursors_ = nullptr;
+  loser_heads_ = nullptr;
+  loser_tree_ = nullptr;
+  loser_tree_leaves_ = 1;
+  while (loser_tree_leaves_ < inputs_count_) {
+    loser_tree_leaves_ <<= 1;
+  }
 }
 
 ErrorStack MergeSort::initialize_once() {
@@ -95,10 +110,13 @@ ErrorStack MergeSort::initialize_once() {
   // it (at most kLogChunk-1 such tuples). so, conservatively chunk_batch_size_ + inputs_count_.
   uint32_t buffer_capacity = kLogChunk * (chunk_batch_size_ + inputs_count_);
   buffer_capacity_ = assorted::align<uint32_t, 512U>(buffer_capacity);
-  uint64_t byte_size = buffer_capacity_ * (sizeof(SortEntry) + sizeof(PositionEntry));
+  uint64_t byte_size = buffer_capacity_ * (sizeof(SortEntry) * 2U + sizeof(PositionEntry));
   ASSERT_ND(byte_size % 4096U == 0);
   byte_size += storage::kPageSize * (max_original_pages_ + 1U);
   byte_size += sizeof(InputStatus) * inputs_count_;
+  byte_size += sizeof(__uint128_t) * loser_tree_leaves_;
+  byte_size += sizeof(MergedPosition) * (inputs_count_ * 2U + 1U);
+  byte_size += sizeof(InputIndex) * loser_tree_leaves_;
   WRAP_ERROR_CODE(work_memory_->assure_capacity(byte_size));
 
   // assign pointers
@@ -115,6 +133,16 @@ ErrorStack MergeSort::initialize_once() {
   offset += sizeof(storage::Page) * (max_original_pages_ + 1U);
   inputs_status_ = reinterpret_cast<InputStatus*>(block + offset);
   offset += sizeof(InputStatus) * inputs_count_;
+  merge_entries_ = reinterpret_cast<SortEntry*>(block + offset);
+  offset += sizeof(SortEntry) * buffer_capacity;
+  loser_heads_ = reinterpret_cast<__uint128_t*>(block + offset);
+  offset += sizeof(__uint128_t) * loser_tree_leaves_;
+  run_begins_ = reinterpret_cast<MergedPosition*>(block + offset);
+  offset += sizeof(MergedPosition) * (inputs_count_ + 1U);
+  run_cursors_ = reinterpret_cast<MergedPosition*>(block + offset);
+  offset += sizeof(MergedPosition) * inputs_count_;
+  loser_tree_ = reinterpret_cast<InputIndex*>(block + offset);
+  offset += sizeof(InputIndex) * loser_tree_leaves_;
   ASSERT_ND(offset == byte_size);
 
   // initialize inputs_status_
@@ -413,17 +441,25 @@ void MergeSort::batch_sort(MergeSort::InputIndex min_input) {
   batch_sort_prepare(min_input);
   ASSERT_ND(current_count_ <= buffer_capacity_);
 
-  // First, sort it with std::sort, which is (*) smart enough to switch to heap sort for this case.
-  // (*) at least gcc's does.
+  // If SortEntry alone determines the order, merge the sorted runs of inputs.
+  // Otherwise, sort it with std::sort, which is (*) smart enough to switch to heap sort for
+  // this case. (*) at least gcc's does.
   debugging::StopWatch sort_watch;
-  std::sort(&(sort_entries_->data_), &(sort_entries_[current_count_].data_));
+  bool merged = false;
+  if (is_merge_runs_applicable()) {
+    merged = batch_sort_merge_runs();
+  }
+  if (!merged) {
+    std::sort(&(sort_entries_->data_), &(sort_entries_[current_count_].data_));
+  }
   sort_watch.stop();
-  VLOG(1) << "Storage-" << id_ << ", merge sort (main) of " << current_count_ << " logs in "
-    << sort_watch.elapsed_ms() << "ms";
+  VLOG(1) << "Storage-" << id_ << ", merge sort (main" << (merged ? ", loser tree" : "")
+    << ") of " << current_count_ << " logs in " << sort_watch.elapsed_ms() << "ms";
 
   // We need additional sorting just for masstree.
   // Array never needs it because 8-byte is enough to compare precisely.
   // Hash neither because it doesn't need the inputs to be fully sorted. Bin-sort is enough.
+  // (the key is the bin in kHashMaxBinBits. see HashCommonLogType::get_sort_bin())
   // Sequential doesn't need any sorting at all.
   if (type_ == storage::kMasstreeStorage
     && (shortest_key_length_ != 8U || longest_key_length_ != 8U)) {
@@ -441,6 +477,7 @@ void MergeSort::batch_sort_prepare(MergeSort::InputIndex min_input) {
     for (InputIndex i = 0; i < inputs_count_; ++i) {
       InputStatus* status = inputs_status_ + i;
       ASSERT_ND(status->is_last_chunk_overall());
+      run_begins_[i] = current_count_;
       if (status->is_ended()) {
         continue;
       }
@@ -452,6 +489,7 @@ void MergeSort::batch_sort_prepare(MergeSort::InputIndex min_input) {
     const log::RecordLogType* threshold = inputs_status_[min_input].get_chunk_log();
     for (InputIndex i = 0; i < inputs_count_; ++i) {
       InputStatus* status = inputs_status_ + i;
+      run_begins_[i] = current_count_;
       if (status->is_ended()) {
         continue;
       }
@@ -494,6 +532,78 @@ void MergeSort::batch_sort_prepare(MergeSort::InputIndex min_input) {
       status->assert_consistent();
     }
   }
+  run_begins_[inputs_count_] = current_count_;
+}
+
+/**
+ * Builds the subtree of the loser tree rooted at the given node.
+ * @return the winner of the subtree, which is recorded in the parent.
+ */
+MergeSort::InputIndex build_loser_tree(
+  uint32_t node,
+  uint32_t leaves,
+  const __uint128_t* heads,
+  MergeSort::InputIndex* tree) {
+  if (node >= leaves) {
+    return node - leaves;
+  }
+  MergeSort::InputIndex left = build_loser_tree(node * 2U, leaves, heads, tree);
+  MergeSort::InputIndex right = build_loser_tree(node * 2U + 1U, leaves, heads, tree);
+  if (heads[right] < heads[left]) {
+    tree[node] = left;
+    return right;
+  } else {
+    tree[node] = right;
+    return left;
+  }
+}
+
+bool MergeSort::batch_sort_merge_runs() {
+  ASSERT_ND(is_merge_runs_applicable());
+  ASSERT_ND(run_begins_[0] == 0);
+  ASSERT_ND(run_begins_[inputs_count_] == current_count_);
+  // Inputs are sorted, so each run must be sorted, too. We confirm it rather than assume it
+  // because a wrong assumption here would silently break the snapshot. It's a sequential read,
+  // cheap compared to the merge itself.
+  for (InputIndex i = 0; i < inputs_count_; ++i) {
+    for (MergedPosition pos = run_begins_[i] + 1U; pos < run_begins_[i + 1U]; ++pos) {
+      if (UNLIKELY(sort_entries_[pos].data_ < sort_entries_[pos - 1U].data_)) {
+        LOG(WARNING) << "Storage-" << id_ << ", input-" << i << " is not sorted. Falling back"
+          << " to std::sort";
+        return false;
+      }
+    }
+  }
+
+  const uint32_t leaves = loser_tree_leaves_;
+  for (uint32_t leaf = 0; leaf < leaves; ++leaf) {
+    if (leaf < inputs_count_ && run_begins_[leaf] < run_begins_[leaf + 1U]) {
+      run_cursors_[leaf] = run_begins_[leaf];
+      loser_heads_[leaf] = sort_entries_[run_begins_[leaf]].data_;
+    } else {
+      loser_heads_[leaf] = kExhaustedRun;
+    }
+  }
+
+  // Each step outputs the winner and replays its matches from the leaf to the root.
+  // No two entries are equal (positions differ), so we don't care about stability.
+  InputIndex winner = build_loser_tree(1U, leaves, loser_heads_, loser_tree_);
+  for (MergedPosition out = 0; out < current_count_; ++out) {
+    ASSERT_ND(winner < inputs_count_);
+    ASSERT_ND(loser_heads_[winner] != kExhaustedRun);
+    merge_entries_[out].data_ = loser_heads_[winner];
+    MergedPosition next = ++run_cursors_[winner];
+    loser_heads_[winner]
+      = next < run_begins_[winner + 1U] ? sort_entries_[next].data_ : kExhaustedRun;
+    for (uint32_t node = (winner + leaves) >> 1; node > 0; node >>= 1) {
+      InputIndex loser = loser_tree_[node];
+      bool swap = loser_heads_[loser] < loser_heads_[winner];
+      loser_tree_[node] = swap ? winner : loser;
+      winner = swap ? loser : winner;
+    }
+  }
+  std::memcpy(sort_entries_, merge_entries_, sizeof(SortEntry) * current_count_);
+  return true;
 }
 
 void MergeSort::batch_sort_adjust_sort() {
@@ -645,7 +755,7 @@ inline uint16_t MergeSort::populate_entry_hash(InputIndex input_index, uint64_t
   uint16_t key_length = the_log->key_length_;
   ASSERT_ND(key_length >= shortest_key_length_);
   ASSERT_ND(key_length <= longest_key_length_);
-  storage::hash::HashBin bin = the_log->hash_ >> (64U - the_log->bin_bits_);
+  storage::hash::HashBin bin = the_log->get_sort_bin();
   sort_entries_[current_count_].set(
     bin,
     compressed_epoch,
@@ -723,7 +833,7 @@ void MergeSort::assert_sorted() {
       ASSERT_ND(type_ == storage::kHashStorage);
       const auto* casted = reinterpret_cast<const storage::hash::HashCommonLogType*>(cur);
       casted->assert_type();
-      storage::hash::HashBin bin = casted->hash_ >> (64U - casted->bin_bits_);
+      storage::hash::HashBin bin = casted->get_sort_bin();
       dummy.set(
         bin,
         compressed_epoch,
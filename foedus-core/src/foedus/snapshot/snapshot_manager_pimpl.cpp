@@ -23,6 +23,7 @@
 #include <map>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "foedus/engine.hpp"
@@ -103,6 +104,8 @@ ErrorStack SnapshotManagerPimpl::initialize_once() {
 
   // in child engines, we instantiate local mappers/reducer objects (but not the threads yet)
   previous_snapshot_time_ = std::chrono::system_clock::now();
+  previous_evict_time_ = previous_snapshot_time_;
+  evict_pressure_ = 0;
   stop_requested_ = false;
   if (!engine_->is_master()) {
     local_reducer_ = new LogReducer(engine_);
@@ -218,10 +221,14 @@ void SnapshotManagerPimpl::handle_snapshot() {
     } else if (std::chrono::system_clock::now() >= until) {
       triggered = true;
       LOG(INFO) << "Snapshot interval has elapsed. snapshotting..";
-    } else {
-      // TASK(Hideaki): check free pages in page pool and compare with configuration.
+    } else if (get_option().snapshot_trigger_page_pool_percent_ < 100U
+        && is_volatile_pool_short(get_option().snapshot_trigger_page_pool_percent_)) {
+      triggered = true;
+      LOG(INFO) << "Volatile page pool is running out of free pages. snapshotting..";
     }
 
+    // Storage-shape changes (eg ArrayStorage::extend()) wait until we are done.
+    soc::SharedMutexScope shape_scope(&control_block_->shape_mutex_);
     if (triggered) {
       Snapshot new_snapshot;
       ErrorStack stack = handle_snapshot_triggered(&new_snapshot);
@@ -230,6 +237,7 @@ void SnapshotManagerPimpl::handle_snapshot() {
       }
     } else {
       VLOG(1) << "Snapshotting not triggered. going to sleep again";
+      handle_volatile_page_eviction();
     }
   }
 
@@ -376,6 +384,7 @@ ErrorStack SnapshotManagerPimpl::handle_snapshot_triggered(Snapshot *new_snapsho
   Epoch::EpochInteger epoch_after = new_snapshot_epoch.value();
   control_block_->previous_snapshot_id_ = snapshot_id;
   previous_snapshot_time_ = std::chrono::system_clock::now();
+  evict_pressure_ = 0;  // the new snapshot dropped pages. start over.
 
   control_block_->snapshot_epoch_ = epoch_after;
   assorted::memory_fence_release();
@@ -439,7 +448,7 @@ ErrorStack SnapshotManagerPimpl::snapshot_metadata(
   LOG(INFO) << "New snapshot metadata file fullpath=" << file;
 
   debugging::StopWatch stop_watch;
-  CHECK_ERROR(metadata.save_to_file(file));
+  CHECK_ERROR(metadata.save_to_binary_file(file));
   stop_watch.stop();
   LOG(INFO) << "Wrote a snapshot metadata file. size=" << fs::file_size(file) << " bytes"
     << ", elapsed time to write=" << stop_watch.elapsed_ms() << "ms. now fsyncing...";
@@ -447,6 +456,16 @@ ErrorStack SnapshotManagerPimpl::snapshot_metadata(
   fs::fsync(file, true);
   stop_watch.stop();
   LOG(INFO) << "fsynced the file and the folder! elapsed=" << stop_watch.elapsed_ms() << "ms.";
+
+  if (get_option().export_metadata_xml_) {
+    // only for human eyes. we never read it unless the binary file is missing.
+    fs::Path xml_file = get_snapshot_metadata_xml_file_path(new_snapshot.id_);
+    stop_watch.start();
+    CHECK_ERROR(metadata.save_to_file(xml_file));
+    stop_watch.stop();
+    LOG(INFO) << "Exported the snapshot metadata to " << xml_file << ". size="
+      << fs::file_size(xml_file) << " bytes, elapsed=" << stop_watch.elapsed_ms() << "ms.";
+  }
   return kRetOk;
 }
 
@@ -454,10 +473,16 @@ ErrorStack SnapshotManagerPimpl::read_snapshot_metadata(
   SnapshotId snapshot_id,
   SnapshotMetadata* out) {
   fs::Path file = get_snapshot_metadata_file_path(snapshot_id);
-  LOG(INFO) << "Reading snapshot metadata file fullpath=" << file;
-
   debugging::StopWatch stop_watch;
-  CHECK_ERROR(out->load_from_file(file));
+  if (fs::exists(file)) {
+    LOG(INFO) << "Reading snapshot metadata file fullpath=" << file;
+    CHECK_ERROR(out->load_from_binary_file(file));
+  } else {
+    // Snapshots taken before the binary format only have the xml file.
+    file = get_snapshot_metadata_xml_file_path(snapshot_id);
+    LOG(INFO) << "Binary snapshot metadata file not found. Reading xml file fullpath=" << file;
+    CHECK_ERROR(out->load_from_file(file));
+  }
   stop_watch.stop();
   LOG(INFO) << "Read a snapshot metadata file. size=" << fs::file_size(file) << " bytes"
     << ", elapsed time to read+parse=" << stop_watch.elapsed_ms() << "ms.";
@@ -478,6 +503,14 @@ ErrorStack SnapshotManagerPimpl::snapshot_savepoint(const Snapshot& new_snapshot
 }
 
 fs::Path SnapshotManagerPimpl::get_snapshot_metadata_file_path(SnapshotId snapshot_id) const {
+  fs::Path folder(get_option().get_primary_folder_path());
+  fs::Path file(folder);
+  file /= std::string("snapshot_metadata_")
+    + std::to_string(snapshot_id) + std::string(".bin");
+  return file;
+}
+
+fs::Path SnapshotManagerPimpl::get_snapshot_metadata_xml_file_path(SnapshotId snapshot_id) const {
   fs::Path folder(get_option().get_primary_folder_path());
   fs::Path file(folder);
   file /= std::string("snapshot_metadata_")
@@ -529,7 +562,8 @@ ErrorStack SnapshotManagerPimpl::drop_volatile_pages(
       new_snapshot,
       new_root_page_pointers,
       result_memory.get_block(),
-      node);
+      node,
+      0);
   }
 
   for (std::thread& thr : threads) {
@@ -574,7 +608,8 @@ ErrorStack SnapshotManagerPimpl::drop_volatile_pages(
       0,
       false,
       dropped_chunks,
-      &dropped_count};
+      &dropped_count,
+      0};
     storage::Composer composer(engine_, id);
     composer.drop_root_volatile(args);
     LOG(INFO) << "As a result, we dropped " << dropped_count << " pages from storage-" << id;
@@ -596,7 +631,8 @@ void SnapshotManagerPimpl::drop_volatile_pages_parallel(
   const Snapshot& new_snapshot,
   const std::map<storage::StorageId, storage::SnapshotPagePointer>& new_root_page_pointers,
   void* result_memory,
-  uint16_t parallel_id) {
+  uint16_t parallel_id,
+  uint16_t evict_pressure) {
   // this thread is pinned on its own socket. We use the same partitioning scheme as reducer
   // so that this method mostly hits local pages
   thread::NumaThreadScope numa_scope(parallel_id);
@@ -635,11 +671,15 @@ void SnapshotManagerPimpl::drop_volatile_pages_parallel(
         parallel_id,
         true,
         dropped_chunks,
-        &dropped_count};
+        &dropped_count,
+        evict_pressure};
       debugging::StopWatch watch;
       storage::Composer::DropResult result = composer.drop_volatiles(args);
+      // array's extend() might have reset root_page_pointer_ after the snapshot
       ASSERT_ND(engine_->get_storage_manager()->get_storage(id)->root_page_pointer_.
-        snapshot_pointer_ == new_root_page_pointer);
+        snapshot_pointer_ == new_root_page_pointer
+        || (evict_pressure > 0U && engine_->get_storage_manager()->get_storage(id)->
+          root_page_pointer_.snapshot_pointer_ == 0));
       ASSERT_ND(engine_->get_storage_manager()->get_storage(id)->meta_.root_snapshot_page_id_
         == new_root_page_pointer);
       dropped_count_total += dropped_count;
@@ -674,5 +714,127 @@ void SnapshotManagerPimpl::drop_volatile_pages_parallel(
   chunks_memory.release_block();
 }
 
+bool SnapshotManagerPimpl::is_volatile_pool_short(uint16_t free_percent) const {
+  const uint16_t soc_count = engine_->get_soc_count();
+  for (uint16_t node = 0; node < soc_count; ++node) {
+    const memory::PagePool* volatile_pool
+      = engine_->get_memory_manager()->get_node_memory(node)->get_volatile_pool();
+    memory::PagePool::Stat stat = volatile_pool->get_stat();
+    ASSERT_ND(stat.allocated_pages_ <= stat.total_pages_);
+    uint64_t free_pages = stat.total_pages_ - stat.allocated_pages_;
+    if (free_pages * 100U < stat.total_pages_ * free_percent) {
+      VLOG(0) << "Node-" << node << " has only " << free_pages << " free volatile pages out of "
+        << stat.total_pages_;
+      return true;
+    }
+  }
+  return false;
+}
+
+void SnapshotManagerPimpl::handle_volatile_page_eviction() {
+  const uint16_t evict_percent = get_option().volatile_page_evict_percent_;
+  if (evict_percent == 0) {
+    return;
+  }
+  Epoch snapshot_epoch = get_snapshot_epoch();
+  if (!snapshot_epoch.is_valid()) {
+    return;  // nothing to evict to.
+  }
+  if (!is_volatile_pool_short(evict_percent)) {
+    if (evict_pressure_ > 0) {
+      LOG(INFO) << "Volatile page pool has enough free pages now. resetting evict pressure";
+      evict_pressure_ = 0;
+    }
+    return;
+  }
+
+  // Each eviction pass pauses transactions. Let's not do it too frequently.
+  const uint32_t kEvictIntervalMs = 1000;
+  const uint16_t kMaxEvictPressure = 16;
+  std::chrono::system_clock::time_point until
+    = previous_evict_time_ + std::chrono::milliseconds(kEvictIntervalMs);
+  if (std::chrono::system_clock::now() < until) {
+    return;
+  }
+  if (evict_pressure_ < kMaxEvictPressure) {
+    ++evict_pressure_;
+  }
+
+  Snapshot latest_snapshot;
+  latest_snapshot.id_ = get_previous_snapshot_id();
+  latest_snapshot.base_epoch_ = Epoch();
+  latest_snapshot.valid_until_epoch_ = snapshot_epoch;
+  latest_snapshot.max_storage_id_ = engine_->get_storage_manager()->get_largest_storage_id();
+  ErrorStack stack = evict_volatile_pages(latest_snapshot, evict_pressure_);
+  if (stack.is_error()) {
+    LOG(ERROR) << "Volatile page eviction failed:" << stack;
+  }
+  previous_evict_time_ = std::chrono::system_clock::now();
+}
+
+ErrorStack SnapshotManagerPimpl::evict_volatile_pages(
+  const Snapshot& latest_snapshot,
+  uint16_t evict_pressure) {
+  ASSERT_ND(engine_->is_master());
+  ASSERT_ND(evict_pressure > 0);
+  LOG(INFO) << "Evicting volatile pages based on snapshot-" << latest_snapshot.id_
+    << ". evict_pressure=" << evict_pressure;
+
+  // Storages that are already in a snapshot. Others have nothing to evict.
+  std::map<storage::StorageId, storage::SnapshotPagePointer> root_page_pointers;
+  storage::StorageManager* storage_manager = engine_->get_storage_manager();
+  for (storage::StorageId id = 1; id <= latest_snapshot.max_storage_id_; ++id) {
+    storage::StorageControlBlock* block = storage_manager->get_storage(id);
+    if (!block->exists()) {
+      continue;
+    }
+    // Not root_page_pointer_, which array's extend() resets until the next snapshot.
+    // The composers keep volatile pages that have no snapshot version anyways.
+    storage::SnapshotPagePointer root_pointer = block->meta_.root_snapshot_page_id_;
+    if (root_pointer != 0) {
+      root_page_pointers.insert(std::pair<storage::StorageId, storage::SnapshotPagePointer>(
+        id,
+        root_pointer));
+    }
+  }
+  if (root_page_pointers.empty()) {
+    LOG(INFO) << "No storage has snapshot pages yet. nothing to evict";
+    return kRetOk;
+  }
+
+  const uint16_t soc_count = engine_->get_soc_count();
+  memory::AlignedMemory result_memory;  // we don't use the results. no drop_root here.
+  result_memory.alloc(
+    sizeof(storage::Composer::DropResult) * soc_count * (latest_snapshot.max_storage_id_ + 2U),
+    1U << 12,
+    memory::AlignedMemory::kNumaAllocOnnode,
+    0);
+
+  // Same as drop_volatile_pages(). we pause transactions while we drop pages.
+  engine_->get_xct_manager()->pause_accepting_xct();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  debugging::StopWatch stop_watch;
+  std::vector< std::thread > threads;
+  for (uint16_t node = 0; node < soc_count; ++node) {
+    threads.emplace_back(
+      &SnapshotManagerPimpl::drop_volatile_pages_parallel,
+      this,
+      latest_snapshot,
+      root_page_pointers,
+      result_memory.get_block(),
+      node,
+      evict_pressure);
+  }
+  for (std::thread& thr : threads) {
+    thr.join();
+  }
+  engine_->get_xct_manager()->resume_accepting_xct();
+  stop_watch.stop();
+  LOG(INFO) << "Total: Evicted volatile pages in " << stop_watch.elapsed_ms() << "ms.";
+
+  result_memory.release_block();
+  return kRetOk;
+}
+
 }  // namespace snapshot
 }  // namespace foedus
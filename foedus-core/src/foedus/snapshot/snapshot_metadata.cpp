@@ -20,9 +20,14 @@
 #include <tinyxml2.h>
 #include <glog/logging.h>
 
+#include <cstring>
 #include <memory>
 
+#include "foedus/assorted/assorted_func.hpp"
 #include "foedus/externalize/externalizable.hpp"
+#include "foedus/fs/direct_io_file.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/fs/path.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
 #include "foedus/storage/metadata.hpp"
 
@@ -97,6 +102,152 @@ ErrorStack SnapshotMetadata::save(tinyxml2::XMLElement* element) const {
   // </storages>
   return kRetOk;
 }
+/** "FOEDUSSM" in little endian. */
+const uint64_t kBinaryMagic = 0x4D53535544454F46ULL;
+/** Increment this whenever the layout of the header or StorageControlBlock changes. */
+const uint32_t kBinaryFormatVersion = 1;
+/** The header page as well as each control block is this size. */
+const uint64_t kBinaryPageSize = soc::GlobalMemoryAnchors::kStorageMemorySize;
+
+/**
+ * The first page of a binary snapshot metadata file.
+ * The rest of the page is zero-filled.
+ */
+struct BinaryHeader {
+  uint64_t            magic_;
+  uint32_t            format_version_;
+  uint32_t            control_block_size_;
+  SnapshotId          id_;
+  uint16_t            filler_;
+  storage::StorageId  largest_storage_id_;
+  Epoch::EpochInteger base_epoch_;
+  Epoch::EpochInteger valid_until_epoch_;
+  /** Byte size of the control blocks following the header page. */
+  uint64_t            body_size_;
+  /** Checksum of this header (with this field being zero) and the body. */
+  uint64_t            checksum_;
+};
+
+/** FNV-1a over 8-byte words. sizes are always multiples of 8 here. */
+uint64_t compute_checksum(uint64_t seed, const void* data, uint64_t size) {
+  ASSERT_ND(size % sizeof(uint64_t) == 0);
+  const uint64_t kPrime = 0x100000001B3ULL;
+  const uint64_t* words = reinterpret_cast<const uint64_t*>(data);
+  uint64_t hash = seed;
+  for (uint64_t i = 0; i < size / sizeof(uint64_t); ++i) {
+    hash ^= words[i];
+    hash *= kPrime;
+  }
+  return hash;
+}
+
+uint64_t compute_checksum(const BinaryHeader& header, const void* body) {
+  const uint64_t kOffsetBasis = 0xCBF29CE484222325ULL;
+  BinaryHeader copied = header;
+  copied.checksum_ = 0;
+  uint64_t hash = compute_checksum(kOffsetBasis, &copied, sizeof(copied));
+  return compute_checksum(hash, body, header.body_size_);
+}
+
+ErrorStack SnapshotMetadata::save_to_binary_file(const fs::Path& path) const {
+  const uint64_t body_size = static_cast<uint64_t>(largest_storage_id_ + 1) * kBinaryPageSize;
+  // storage_control_blocks_ might be preceded by the header page if we loaded it from a file
+  const uint64_t body_offset = reinterpret_cast<const char*>(storage_control_blocks_)
+    - reinterpret_cast<const char*>(storage_control_blocks_memory_.get_block());
+  ASSERT_ND(storage_control_blocks_);
+  ASSERT_ND(body_offset % kBinaryPageSize == 0);
+  ASSERT_ND(storage_control_blocks_memory_.get_size() >= body_offset + body_size);
+  memory::AlignedMemorySlice body(
+    const_cast<memory::AlignedMemory*>(&storage_control_blocks_memory_),
+    body_offset,
+    body_size);
+
+  memory::AlignedMemory header_page;
+  header_page.alloc(kBinaryPageSize, kBinaryPageSize, memory::AlignedMemory::kPosixMemalign, 0);
+  std::memset(header_page.get_block(), 0, kBinaryPageSize);
+  BinaryHeader* header = reinterpret_cast<BinaryHeader*>(header_page.get_block());
+  header->magic_ = kBinaryMagic;
+  header->format_version_ = kBinaryFormatVersion;
+  header->control_block_size_ = kBinaryPageSize;
+  header->id_ = id_;
+  header->largest_storage_id_ = largest_storage_id_;
+  header->base_epoch_ = base_epoch_;
+  header->valid_until_epoch_ = valid_until_epoch_;
+  header->body_size_ = body_size;
+  header->checksum_ = compute_checksum(*header, storage_control_blocks_);
+
+  if (fs::exists(path)) {
+    fs::remove(path);
+  }
+  fs::DirectIoFile file(path);
+  WRAP_ERROR_CODE(file.open(false, true, false, true));
+  WRAP_ERROR_CODE(file.write(kBinaryPageSize, header_page));
+  WRAP_ERROR_CODE(file.write(body_size, body));
+  file.close();
+  return kRetOk;
+}
+
+ErrorStack SnapshotMetadata::load_from_binary_file(const fs::Path& path) {
+  clear();
+  const uint64_t file_size = fs::file_size(path);
+  if (file_size < kBinaryPageSize * 2U || file_size % kBinaryPageSize != 0) {
+    LOG(ERROR) << "Snapshot metadata file " << path << " has an invalid size: " << file_size;
+    return ERROR_STACK(kErrorCodeSnapshotMetadataCorrupted);
+  }
+
+  // Read the entire file at once. The body is then directly usable as the control blocks.
+  storage_control_blocks_memory_.alloc(
+    file_size,
+    kBinaryPageSize,
+    memory::AlignedMemory::kNumaAllocOnnode,
+    0);
+  char* image = reinterpret_cast<char*>(storage_control_blocks_memory_.get_block());
+  {
+    fs::DirectIoFile file(path);
+    WRAP_ERROR_CODE(file.open(true, false, false, false));
+    WRAP_ERROR_CODE(file.read(file_size, &storage_control_blocks_memory_));
+    file.close();
+  }
+
+  const BinaryHeader* header = reinterpret_cast<const BinaryHeader*>(image);
+  if (header->magic_ != kBinaryMagic
+    || header->format_version_ != kBinaryFormatVersion
+    || header->control_block_size_ != kBinaryPageSize
+    || header->body_size_ != file_size - kBinaryPageSize
+    || header->body_size_
+      != static_cast<uint64_t>(header->largest_storage_id_ + 1) * kBinaryPageSize) {
+    LOG(ERROR) << "Snapshot metadata file " << path << " has an invalid header. magic="
+      << assorted::Hex(header->magic_) << ", version=" << header->format_version_
+      << ", body_size=" << header->body_size_ << ", file_size=" << file_size;
+    storage_control_blocks_memory_.release_block();
+    return ERROR_STACK(kErrorCodeSnapshotMetadataCorrupted);
+  }
+  if (header->checksum_ != compute_checksum(*header, image + kBinaryPageSize)) {
+    LOG(ERROR) << "Snapshot metadata file " << path << " has a wrong checksum.";
+    storage_control_blocks_memory_.release_block();
+    return ERROR_STACK(kErrorCodeSnapshotMetadataCorrupted);
+  }
+
+  id_ = header->id_;
+  base_epoch_ = header->base_epoch_;
+  valid_until_epoch_ = header->valid_until_epoch_;
+  largest_storage_id_ = header->largest_storage_id_;
+  storage_control_blocks_
+    = reinterpret_cast<storage::StorageControlBlock*>(image + kBinaryPageSize);
+
+  // The image is a copy of shared memory at the time of snapshot. Runtime-only states
+  // in it are meaningless now, so reset them as if they were loaded from xml.
+  for (storage::StorageId id = 0; id <= largest_storage_id_; ++id) {
+    storage::StorageControlBlock* block = storage_control_blocks_ + id;
+    std::memset(
+      reinterpret_cast<void*>(&block->status_mutex_),
+      0,
+      sizeof(block->status_mutex_));
+    block->root_page_pointer_.volatile_pointer_.word = 0;
+  }
+  return kRetOk;
+}
+
 void SnapshotMetadata::assign(const externalize::Externalizable* /*other*/) {
   ASSERT_ND(false);  // should not be called
 }
@@ -26,6 +26,7 @@ namespace snapshot {
 SnapshotOptions::SnapshotOptions() {
   folder_path_pattern_ = "snapshots/node_$NODE$";
   snapshot_trigger_page_pool_percent_ = kDefaultSnapshotTriggerPagePoolPercent;
+  volatile_page_evict_percent_ = kDefaultVolatilePageEvictPercent;
   snapshot_interval_milliseconds_ = kDefaultSnapshotIntervalMilliseconds;
   log_mapper_bucket_kb_ = kDefaultLogMapperBucketKb;
   log_mapper_io_buffer_mb_ = kDefaultLogMapperIoBufferMb;
@@ -35,6 +36,7 @@ SnapshotOptions::SnapshotOptions() {
   log_reducer_read_io_buffer_kb_ = kDefaultLogReducerReadIoBufferKb;
   snapshot_writer_page_pool_size_mb_ = kDefaultSnapshotWriterPagePoolSizeMb;
   snapshot_writer_intermediate_pool_size_mb_ = kDefaultSnapshotWriterIntermediatePoolSizeMb;
+  export_metadata_xml_ = false;
 }
 
 std::string SnapshotOptions::convert_folder_path_pattern(int node) const {
@@ -53,6 +55,10 @@ std::string SnapshotOptions::construct_snapshot_file_path(int snapshot_id, int n
 ErrorStack SnapshotOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, folder_path_pattern_);
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_trigger_page_pool_percent_);
+  EXTERNALIZE_LOAD_ELEMENT_OPTIONAL(
+    element,
+    volatile_page_evict_percent_,
+    static_cast<uint16_t>(kDefaultVolatilePageEvictPercent));
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_interval_milliseconds_);
   EXTERNALIZE_LOAD_ELEMENT(element, log_mapper_bucket_kb_);
   EXTERNALIZE_LOAD_ELEMENT(element, log_mapper_io_buffer_mb_);
@@ -62,6 +68,7 @@ ErrorStack SnapshotOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, log_reducer_read_io_buffer_kb_);
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_writer_page_pool_size_mb_);
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_writer_intermediate_pool_size_mb_);
+  EXTERNALIZE_LOAD_ELEMENT_OPTIONAL(element, export_metadata_xml_, false);
   CHECK_ERROR(get_child_element(element, "SnapshotDeviceEmulationOptions", &emulation_))
   return kRetOk;
 }
@@ -77,6 +84,10 @@ ErrorStack SnapshotOptions::save(tinyxml2::XMLElement* element) const {
   EXTERNALIZE_SAVE_ELEMENT(element, snapshot_trigger_page_pool_percent_,
     "When the main page pool runs under this percent (roughly calculated) of free pages,\n"
     " snapshot manager starts snapshotting to drop volatile pages even before the interval.");
+  EXTERNALIZE_SAVE_ELEMENT(element, volatile_page_evict_percent_,
+    "When the volatile page pool of any node runs under this percent of free pages,\n"
+    " snapshot manager evicts volatile pages whose content is same as the latest snapshot"
+    " even between snapshots. 0 (default) disables it.");
   EXTERNALIZE_SAVE_ELEMENT(element, snapshot_interval_milliseconds_,
     "Interval in milliseconds to take snapshots.");
   EXTERNALIZE_SAVE_ELEMENT(element, log_mapper_bucket_kb_,
@@ -101,6 +112,8 @@ ErrorStack SnapshotOptions::save(tinyxml2::XMLElement* element) const {
   EXTERNALIZE_SAVE_ELEMENT(element, snapshot_writer_intermediate_pool_size_mb_,
     "The size in MB of additional page pool for one snapshot writer just for holding"
     " intermediate pages.");
+  EXTERNALIZE_SAVE_ELEMENT(element, export_metadata_xml_,
+    "Whether to additionally write out the snapshot metadata as an xml file for debugging.");
   CHECK_ERROR(add_child_element(element, "SnapshotDeviceEmulationOptions",
           "[Experiments-only] Settings to emulate slower data device", emulation_));
   return kRetOk;
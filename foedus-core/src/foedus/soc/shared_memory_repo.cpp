@@ -454,6 +454,10 @@ void SharedMemoryRepo::set_node_memory_anchors(
     thread_anchor.mcs_lock_memories_ = reinterpret_cast<xct::McsBlock*>(base + total);
     total += ThreadMemoryAnchors::kMcsLockMemorySize;
     put_node_memory_boundary(node, &total, "thread_mcs_lock_memories_boundary", reset_boundaries);
+
+    thread_anchor.dispatch_ring_memory_ = reinterpret_cast<thread::DispatchRing*>(base + total);
+    total += ThreadMemoryAnchors::kDispatchRingMemorySize;
+    put_node_memory_boundary(node, &total, "thread_dispatch_ring_boundary", reset_boundaries);
   }
 
   // This is larger than others (except volatile pool). we place this at the end.
@@ -504,6 +508,7 @@ uint64_t SharedMemoryRepo::calculate_node_memory_size(const EngineOptions& optio
   total += threads_per_node * (ThreadMemoryAnchors::kTaskInputMemorySize + kBoundarySize);
   total += threads_per_node * (ThreadMemoryAnchors::kTaskOutputMemorySize + kBoundarySize);
   total += threads_per_node * (ThreadMemoryAnchors::kMcsLockMemorySize + kBoundarySize);
+  total += threads_per_node * (ThreadMemoryAnchors::kDispatchRingMemorySize + kBoundarySize);
 
   total +=
     (static_cast<uint64_t>(options.snapshot_.log_reducer_buffer_mb_) << 20)
@@ -127,9 +127,19 @@ ErrorStack ArrayComposer::construct_root(const Composer::ConstructRootArguments&
       WRAP_ERROR_CODE(args.previous_snapshot_files_->read_page(page_id, root_page));
       ASSERT_ND(root_page->header().storage_id_ == storage_id_);
       ASSERT_ND(root_page->header().page_id_ == page_id);
-      ASSERT_ND(root_page->get_array_range() == range);
+      ASSERT_ND(root_page->get_array_range().begin_ == 0);
+      ASSERT_ND(root_page->get_array_range().end_ <= range.end_);
+    }
+    if (page_id != 0 && root_page->get_level() == levels - 1U) {
+      if (root_page->get_array_range().end_ < range.end_) {
+        // the array was extended since the previous snapshot
+        root_page->extend_array_range(range.end_);
+      }
       root_page->header().page_id_ = new_page_id;
     } else {
+      // initial snapshot, or the array got more levels since the previous snapshot.
+      // in the latter case, the previous root is now under the first child, which is
+      // one of the pointers in root_info_pages.
       root_page->initialize_snapshot_page(
         system_initial_epoch,
         storage_id_,
@@ -149,8 +159,12 @@ ErrorStack ArrayComposer::construct_root(const Composer::ConstructRootArguments&
       for (uint16_t j = 0; j < root_children; ++j) {
         SnapshotPagePointer pointer = casted->pointers_[j];
         if (pointer != 0) {
-          ASSERT_ND(extract_snapshot_id_from_snapshot_pointer(pointer) == new_snapshot_id);
           DualPagePointer& record = root_page->get_interior_record(j);
+          // either written in this snapshot or a subtree of the previous snapshot we didn't modify.
+          // the latter might be the previous root if the array got more levels.
+          ASSERT_ND(extract_snapshot_id_from_snapshot_pointer(pointer) == new_snapshot_id
+            || pointer == record.snapshot_pointer_
+            || record.snapshot_pointer_ == 0);
           // partitioning has no overlap, so this must be the only overwriting pointer
           ASSERT_ND(record.snapshot_pointer_ == 0 ||
             extract_snapshot_id_from_snapshot_pointer(record.snapshot_pointer_)
@@ -212,6 +226,8 @@ ArrayComposeContext::ArrayComposeContext(
     offset_intervals_[level] = offset_intervals_[level - 1] * kInteriorFanout;
   }
   std::memset(cur_path_, 0, sizeof(cur_path_));
+  previous_size_ = 0;
+  previous_levels_ = 0;
 
   allocated_pages_ = 0;
   allocated_intermediates_ = 0;
@@ -230,6 +246,7 @@ ArrayComposeContext::ArrayComposeContext(
 ErrorStack ArrayComposeContext::execute() {
   std::memset(root_info_page_, 0, kPageSize);
   root_info_page_->header_.storage_id_ = storage_id_;
+  CHECK_ERROR(read_previous_shape());
 
   if (levels_ <= 1U) {
     // this storage has only one page. This is very special and trivial.
@@ -287,6 +304,11 @@ ErrorStack ArrayComposeContext::execute() {
 
   if (processed_any) {
     CHECK_ERROR(finalize());
+  } else if (!is_initial_snapshot() && previous_size_ < storage_.get_array_size()) {
+    // no logs for us, but the array was extended. we still have to write out the new shape.
+    LOG(INFO) << "No logs, but array-" << storage_id_ << " was extended. Filling empty pages";
+    CHECK_ERROR(init_root_page());
+    CHECK_ERROR(finalize());
   } else {
     LOG(ERROR) << "wtf? no logs? storage-" << storage_id_;
   }
@@ -383,11 +405,10 @@ uint16_t ArrayComposeContext::get_root_children() const {
 ErrorStack ArrayComposeContext::finalize() {
   ASSERT_ND(levels_ > 1U);
 
-  ArrayRange last_range = cur_path_[0]->get_array_range();
-  if (is_initial_snapshot() && last_range.end_ < storage_.get_array_size()) {
-    VLOG(0) << "Need to fill out empty pages in initial snapshot of array-" << storage_id_
-      << ", from " << last_range.end_ << " to the end of array";
-    WRAP_ERROR_CODE(create_empty_pages(last_range.end_, storage_.get_array_size()));
+  // cur_path_[0] is null only when we received no logs
+  ArrayOffset last_end = cur_path_[0] == nullptr ? 0 : cur_path_[0]->get_array_range().end_;
+  if (last_end < storage_.get_array_size()) {
+    WRAP_ERROR_CODE(fill_empty_pages(last_end, storage_.get_array_size()));
   }
 
   // flush the main buffer. now we finalized all leaf pages
@@ -475,8 +496,9 @@ ErrorStack ArrayComposeContext::finalize() {
       }
       root_info_page_->pointers_[j] = pointer.snapshot_pointer_;
     } else {
-      ASSERT_ND((!is_initial_snapshot() && page_id != 0 && snapshot_id != snapshot_id_)
-        || (is_initial_snapshot() && page_id == 0));
+      ASSERT_ND((page_id != 0)
+        == has_previous_page(levels_ - 2U, j * offset_intervals_[levels_ - 2U]));
+      ASSERT_ND(snapshot_id != snapshot_id_);
     }
   }
   for (uint16_t j = root_children; j < kInteriorFanout; ++j) {
@@ -519,13 +541,67 @@ ErrorStack ArrayComposeContext::init_root_page() {
   ASSERT_ND(allocated_intermediates_ == 0);
   allocated_intermediates_ = 1;
 
-  WRAP_ERROR_CODE(read_or_init_page(previous_root_page_pointer_, 0, level, range, page));
+  // if the array got more levels since the previous snapshot, we need a new root page.
+  SnapshotPagePointer old_page_id = 0;
+  if (previous_levels_ == levels_) {
+    old_page_id = previous_root_page_pointer_;
+  }
+  WRAP_ERROR_CODE(read_or_init_page(old_page_id, 0, level, range, page));
   cur_path_[level] = page;
   return kRetOk;
 }
 
+ErrorStack ArrayComposeContext::read_previous_shape() {
+  ASSERT_ND(previous_size_ == 0);
+  ASSERT_ND(previous_levels_ == 0);
+  if (is_initial_snapshot()) {
+    return kRetOk;
+  }
+
+  // we don't use intermediate pages yet. borrow it to read the page.
+  ArrayPage* page = intermediate_base_;
+  WRAP_ERROR_CODE(previous_snapshot_files_->read_page(previous_root_page_pointer_, page));
+  ASSERT_ND(page->header().storage_id_ == storage_id_);
+  ASSERT_ND(page->header().page_id_ == previous_root_page_pointer_);
+  ASSERT_ND(page->get_array_range().begin_ == 0);
+  previous_size_ = page->get_array_range().end_;
+  previous_levels_ = page->get_level() + 1U;
+  ASSERT_ND(previous_size_ <= storage_.get_array_size());
+  ASSERT_ND(previous_levels_ <= levels_);
+  if (previous_size_ < storage_.get_array_size()) {
+    LOG(INFO) << "Array-" << storage_id_ << " was extended from " << previous_size_
+      << " records (" << static_cast<int>(previous_levels_) << " levels) since the previous"
+      << " snapshot. Now " << storage_.get_array_size() << " records ("
+      << static_cast<int>(levels_) << " levels)";
+  }
+  return kRetOk;
+}
+
+ErrorCode ArrayComposeContext::fill_empty_pages(ArrayOffset from, ArrayOffset to) {
+  // the previous snapshot has pages upto previous_size_ (0 if initial snapshot)
+  if (from < previous_size_) {
+    from = previous_size_;
+  }
+  if (from >= to) {
+    return kErrorCodeOk;
+  }
+  VLOG(0) << "Need to fill out empty pages in array-" << storage_id_
+    << ", from " << from << " to " << to;
+
+  if (!is_initial_snapshot() && from == previous_size_) {
+    // the right-most pages in the previous snapshot got larger ranges. create_empty_pages()
+    // continues from them, so we switch to them first, which also writes them out.
+    const uint16_t bucket = (previous_size_ - 1U) / offset_intervals_[levels_ - 2U];
+    if (!partitioning_data_->partitionable_
+      || partitioning_data_->bucket_owners_[bucket] == snapshot_writer_->get_numa_node()) {
+      CHECK_ERROR_CODE(update_cur_path(previous_size_ - 1U));
+    }
+  }
+  return create_empty_pages(from, to);
+}
+
 ErrorCode ArrayComposeContext::create_empty_pages(ArrayOffset from, ArrayOffset to) {
-  ASSERT_ND(is_initial_snapshot());  // this must be called only at initial snapshot
+  ASSERT_ND(from >= previous_size_);  // the previous snapshot already has pages there
   ASSERT_ND(levels_ > 1U);  // single-page array is handled separately, and no need for this func.
   ASSERT_ND(from < to);
   ASSERT_ND(to <= storage_.get_array_size());
@@ -717,10 +793,8 @@ ErrorCode ArrayComposeContext::update_cur_path(ArrayOffset next_offset) {
   ArrayRange next_range = to_leaf_range(next_offset);
   ArrayOffset jump_from = cur_path_[0] == nullptr ? 0 : cur_path_[0]->get_array_range().end_;
   ArrayOffset jump_to = next_range.begin_;
-  if (jump_to > jump_from && is_initial_snapshot()) {
-    VLOG(0) << "Need to fill out empty pages in initial snapshot of array-" << storage_id_
-      << ", from " << jump_from << " to " << jump_to;
-    CHECK_ERROR_CODE(create_empty_pages(jump_from, jump_to));
+  if (jump_to > jump_from) {
+    CHECK_ERROR_CODE(fill_empty_pages(jump_from, jump_to));
   }
 
   // then switch pages. we might have to switch parent pages, too.
@@ -748,8 +822,7 @@ ErrorCode ArrayComposeContext::update_cur_path(ArrayOffset next_offset) {
     DualPagePointer& pointer = parent->get_interior_record(i);
     ASSERT_ND(pointer.volatile_pointer_.is_null());
     SnapshotPagePointer old_page_id = pointer.snapshot_pointer_;
-    ASSERT_ND((!is_initial_snapshot() && old_page_id != 0)
-      || (is_initial_snapshot() && old_page_id == 0));
+    ASSERT_ND((old_page_id != 0) == has_previous_page(level, child_range.begin_));
 
     ArrayPage* page;
     SnapshotPagePointer new_page_id;
@@ -795,10 +868,16 @@ inline ErrorCode ArrayComposeContext::read_or_init_page(
     ASSERT_ND(page->header().storage_id_ == storage_id_);
     ASSERT_ND(page->header().page_id_ == old_page_id);
     ASSERT_ND(page->get_level() == level);
-    ASSERT_ND(page->get_array_range() == range);
+    ASSERT_ND(page->get_array_range().begin_ == range.begin_);
+    ASSERT_ND(page->get_array_range().end_ <= range.end_);
+    if (page->get_array_range().end_ < range.end_) {
+      // a right-most page in the previous snapshot. the array was extended since then.
+      ASSERT_ND(page->get_array_range().end_ == previous_size_);
+      page->extend_array_range(range.end_);
+    }
     page->header().page_id_ = new_page_id;
   } else {
-    ASSERT_ND(is_initial_snapshot());
+    ASSERT_ND(!has_previous_page(level, range.begin_));
     page->initialize_snapshot_page(
       system_initial_epoch_,
       storage_id_,
@@ -806,6 +885,11 @@ inline ErrorCode ArrayComposeContext::read_or_init_page(
       payload_size_,
       level,
       range);
+    if (previous_levels_ > 0 && level == previous_levels_ && range.begin_ == 0) {
+      // the array got more levels since the previous snapshot. the previous root is
+      // the first child of this page.
+      page->get_interior_record(0).snapshot_pointer_ = previous_root_page_pointer_;
+    }
   }
   return kErrorCodeOk;
 }
@@ -946,6 +1030,7 @@ Composer::DropResult ArrayComposer::drop_volatiles(const Composer::DropVolatiles
   // we might drop the root page later, just like non-single-page cases.
   if (volatile_page->is_leaf()) {
     LOG(INFO) << "Single-page array skipped by .";
+    volatile_page->header().decay_hotness();
     return result;
   }
 
@@ -957,7 +1042,11 @@ Composer::DropResult ArrayComposer::drop_volatiles(const Composer::DropVolatiles
   for (uint16_t i = 0; i < kInteriorFanout; ++i) {
     DualPagePointer& child_pointer = volatile_page->get_interior_record(i);
     if (!child_pointer.volatile_pointer_.is_null()) {
-      ASSERT_ND(child_pointer.snapshot_pointer_ != 0);
+      if (child_pointer.snapshot_pointer_ == 0) {
+        // a range added by ArrayStorage::extend(), not written to snapshot yet. keep it.
+        result.dropped_all_ = false;
+        continue;
+      }
       uint16_t partition = extract_numa_node_from_snapshot_pointer(child_pointer.snapshot_pointer_);
       if (!args.partitioned_drop_ || partition == args.my_partition_) {
         result.combine(drop_volatiles_recurse(args, &child_pointer));
@@ -974,7 +1063,7 @@ void ArrayComposer::drop_root_volatile(const Composer::DropVolatilesArguments& a
       << " is configured to keep all volatile pages.";
     return;
   }
-  if (is_to_keep_volatile(storage_.get_levels() - 1U)) {
+  if (is_to_keep_volatile(args, storage_.get_levels() - 1U)) {
     LOG(INFO) << "Oh, but Storage-" << storage_.get_name() << " is configured to keep"
       << " the root page.";
     return;
@@ -985,6 +1074,12 @@ void ArrayComposer::drop_root_volatile(const Composer::DropVolatilesArguments& a
     LOG(INFO) << "Oh, but root volatile page already null";
     return;
   }
+  if (root_pointer->snapshot_pointer_ == 0) {
+    // a root page added by ArrayStorage::extend(), not written to snapshot yet.
+    LOG(INFO) << "Oh, but the root volatile page of Storage-" << storage_.get_name()
+      << " has no snapshot version yet";
+    return;
+  }
 
   if (volatile_page->is_leaf()) {
     // if this is a single-level array. we now have to check epochs of records in the root page.
@@ -1040,8 +1135,13 @@ inline Composer::DropResult ArrayComposer::drop_volatiles_recurse(
   ASSERT_ND(pointer->snapshot_pointer_ == 0
     || extract_snapshot_id_from_snapshot_pointer(pointer->snapshot_pointer_)
         != snapshot::kNullSnapshotId);
-  // The snapshot pointer CAN be null.
-  // It means that this subtree has not constructed a new snapshot page in this snapshot.
+  if (pointer->snapshot_pointer_ == 0) {
+    // The snapshot pointer CAN be null. It means that this subtree has no snapshot page yet,
+    // for example it's a range added by ArrayStorage::extend(). We must keep it.
+    Composer::DropResult result(args);
+    result.dropped_all_ = false;
+    return result;
+  }
   ArrayPage* child_page = resolve_volatile(pointer->volatile_pointer_);
   if (child_page->is_leaf()) {
     return drop_volatiles_leaf(args, pointer, child_page);
@@ -1067,7 +1167,7 @@ Composer::DropResult ArrayComposer::drop_volatiles_intermediate(
   }
 
   if (result.dropped_all_) {
-    if (is_to_keep_volatile(volatile_page->get_level())) {
+    if (is_to_keep_volatile(args, volatile_page->get_level())) {
       DVLOG(2) << "Exempted";
       result.dropped_all_ = false;
     } else {
@@ -1088,7 +1188,8 @@ inline Composer::DropResult ArrayComposer::drop_volatiles_leaf(
   ASSERT_ND(!volatile_page->header().snapshot_);
   ASSERT_ND(volatile_page->is_leaf());
   Composer::DropResult result(args);
-  if (is_to_keep_volatile(volatile_page->get_level())) {
+  volatile_page->header().decay_hotness();  // in case we keep it
+  if (is_to_keep_volatile(args, volatile_page->get_level())) {
     DVLOG(2) << "Exempted";
     result.dropped_all_ = false;
     return result;
@@ -1112,10 +1213,14 @@ inline Composer::DropResult ArrayComposer::drop_volatiles_leaf(
   }
   return result;
 }
-inline bool ArrayComposer::is_to_keep_volatile(uint16_t level) {
+inline bool ArrayComposer::is_to_keep_volatile(
+  const Composer::DropVolatilesArguments& args,
+  uint16_t level) {
   uint16_t threshold = storage_.get_array_metadata()->snapshot_drop_volatile_pages_threshold_;
   uint16_t array_levels = storage_.get_levels();
   ASSERT_ND(level < array_levels);
+  // the volatile page evictor keeps fewer levels as the memory pressure persists
+  threshold = threshold > args.evict_pressure_ ? threshold - args.evict_pressure_ : 0;
   // examples:
   // when threshold=0, all levels (0~array_levels-1) should return false.
   // when threshold=1, only root level (array_levels-1) should return true
@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/storage/array/array_cursor.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <ostream>
+
+#include "foedus/assorted/assorted_func.hpp"
+#include "foedus/assorted/atomic_fences.hpp"
+#include "foedus/assorted/cacheline.hpp"
+#include "foedus/storage/page.hpp"
+#include "foedus/storage/array/array_page_impl.hpp"
+#include "foedus/storage/array/array_storage_pimpl.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/xct/xct.hpp"
+
+namespace foedus {
+namespace storage {
+namespace array {
+
+static_assert(
+  static_cast<int>(ArrayCursor::kPrefetchLeaves) <= thread::Thread::kMaxFindPagesBatch,
+  "kPrefetchLeaves must fit in one batched snapshot read");
+
+ArrayCursor::ArrayCursor(ArrayStorage storage, thread::Thread* context)
+  : storage_(storage),
+    context_(context),
+    current_xct_(&context->get_current_xct()) {
+  ASSERT_ND(storage_.exists());
+  payload_size_ = storage_.get_payload_size();
+  dirty_read_ = false;
+  begin_ = 0;
+  end_ = 0;
+  cur_offset_ = 0;
+  std::memset(path_, 0, sizeof(path_));
+  path_lowest_level_ = 0;
+  levels_ = 0;
+  cur_page_ = nullptr;
+  cur_page_snapshot_ = false;
+  cur_index_ = 0;
+  cur_page_end_index_ = 0;
+  cur_record_ = nullptr;
+  prefetched_parent_ = nullptr;
+  prefetched_end_index_ = 0;
+}
+
+ErrorCode ArrayCursor::open(ArrayOffset begin, ArrayOffset end) {
+  thread::SnapshotCacheScanScope scan_scope(context_);
+  ArrayStoragePimpl pimpl(&storage_);
+  route_finder_ = pimpl.control_block_->route_finder_;
+  levels_ = pimpl.get_levels();
+  ASSERT_ND(route_finder_.get_levels() == levels_);
+  dirty_read_ = current_xct_->get_isolation_level() == xct::kDirtyRead;
+  end_ = std::min<ArrayOffset>(end, pimpl.get_array_size());
+  begin_ = std::min<ArrayOffset>(begin, end_);
+  cur_offset_ = begin_;
+  cur_page_ = nullptr;
+  cur_record_ = nullptr;
+  prefetched_parent_ = nullptr;
+  prefetched_end_index_ = 0;
+
+  ArrayPage* root;
+  CHECK_ERROR_CODE(pimpl.get_root_page(context_, false, &root));
+  ASSERT_ND(root->get_level() + 1U == levels_);
+  std::memset(path_, 0, sizeof(path_));
+  path_[levels_ - 1U] = root;
+  path_lowest_level_ = levels_ - 1U;
+  if (cur_offset_ >= end_) {
+    return kErrorCodeOk;  // empty range
+  }
+  CHECK_ERROR_CODE(locate_page());
+  return protect_record();
+}
+
+ErrorCode ArrayCursor::next() {
+  if (!is_valid_record()) {
+    return kErrorCodeOk;
+  }
+  thread::SnapshotCacheScanScope scan_scope(context_);
+  ++cur_offset_;
+  ++cur_index_;
+  if (cur_index_ >= cur_page_end_index_) {
+    CHECK_ERROR_CODE(proceed_page());
+    if (!is_valid_record()) {
+      return kErrorCodeOk;
+    }
+  }
+  cur_record_ = cur_page_->get_leaf_record(cur_index_, payload_size_);
+  return protect_record();
+}
+
+ErrorCode ArrayCursor::locate_page() {
+  ASSERT_ND(cur_offset_ < end_);
+  // go up until the page contains cur_offset_. the root contains all offsets.
+  while (!path_[path_lowest_level_]->get_array_range().contains(cur_offset_)) {
+    ASSERT_ND(path_lowest_level_ + 1U < levels_);
+    ++path_lowest_level_;
+  }
+
+  // then go down
+  ArrayStoragePimpl pimpl(&storage_);
+  LookupRoute route = route_finder_.find_route(cur_offset_);
+  while (path_lowest_level_ > 0) {
+    ArrayPage* parent = path_[path_lowest_level_];
+    const uint16_t index = route.route[path_lowest_level_];
+    if (path_lowest_level_ == 1U) {
+      CHECK_ERROR_CODE(prefetch_leaves(parent, index));
+    }
+    ArrayPage* child;
+    CHECK_ERROR_CODE(pimpl.follow_pointer(
+      context_,
+      parent->header().snapshot_,
+      false,
+      &parent->get_interior_record(index),
+      &child,
+      parent,
+      index));
+    --path_lowest_level_;
+    path_[path_lowest_level_] = child;
+  }
+
+  enter_page(path_[0]);
+  ASSERT_ND(cur_index_ == route.route[0]);
+  return kErrorCodeOk;
+}
+
+ErrorCode ArrayCursor::proceed_page() {
+  ASSERT_ND(cur_page_);
+  cur_offset_ = cur_page_->get_array_range().begin_ + cur_page_end_index_;
+  cur_page_ = nullptr;
+  cur_record_ = nullptr;
+  if (cur_offset_ >= end_) {
+    cur_offset_ = end_;
+    return kErrorCodeOk;  // reached the end
+  }
+  return locate_page();
+}
+
+void ArrayCursor::enter_page(ArrayPage* page) {
+  ASSERT_ND(page->is_leaf());
+  const ArrayRange& range = page->get_array_range();
+  ASSERT_ND(range.contains(cur_offset_));
+  cur_page_ = page;
+  cur_page_snapshot_ = page->header().snapshot_;
+  cur_index_ = cur_offset_ - range.begin_;
+  cur_page_end_index_ = std::min<ArrayOffset>(range.end_, end_) - range.begin_;
+  ASSERT_ND(cur_index_ < cur_page_end_index_);
+  ASSERT_ND(cur_page_end_index_ <= route_finder_.get_records_in_leaf());
+  cur_record_ = page->get_leaf_record(cur_index_, payload_size_);
+}
+
+ErrorCode ArrayCursor::protect_record() {
+  ASSERT_ND(is_valid_record());
+  if (cur_page_snapshot_ || dirty_read_) {
+    return kErrorCodeOk;
+  }
+  xct::XctId observed = cur_record_->owner_id_.xct_id_;
+  assorted::memory_fence_consume();  // finalize observed BEFORE the caller reads the record.
+  return current_xct_->add_to_read_set(storage_.get_id(), observed, &cur_record_->owner_id_);
+}
+
+ErrorCode ArrayCursor::prefetch_leaves(const ArrayPage* parent, uint16_t index) {
+  ASSERT_ND(parent->get_level() == 1U);
+  if (parent == prefetched_parent_ && index < prefetched_end_index_) {
+    return kErrorCodeOk;  // already prefetched
+  }
+
+  // leaf pages in [index, index + kPrefetchLeaves) that overlap with the range
+  const ArrayOffset leaf_records = route_finder_.get_records_in_leaf();
+  const ArrayOffset begin = parent->get_array_range().begin_;
+  uint16_t end_index = index;
+  while (end_index < index + kPrefetchLeaves
+    && end_index < kInteriorFanout
+    && begin + end_index * leaf_records < end_) {
+    ++end_index;
+  }
+  prefetched_parent_ = parent;
+  prefetched_end_index_ = end_index;
+
+  SnapshotPagePointer snapshot_ids[kPrefetchLeaves];
+  uint16_t snapshot_count = 0;
+  for (uint16_t i = index; i < end_index; ++i) {
+    const DualPagePointer& pointer = parent->get_interior_record(i);
+    VolatilePagePointer volatile_pointer = pointer.volatile_pointer_;
+    if (!parent->header().snapshot_ && !volatile_pointer.is_null()) {
+      const Page* page = context_->resolve(volatile_pointer);
+      assorted::prefetch_cachelines(page, kPageSize / assorted::kCachelineSize);
+    } else if (pointer.snapshot_pointer_ != 0) {
+      snapshot_ids[snapshot_count] = pointer.snapshot_pointer_;
+      ++snapshot_count;
+    }
+  }
+
+  if (snapshot_count > 0) {
+    // we just want them in the snapshot cache. follow_pointer() will find them there.
+    Page* snapshot_pages[kPrefetchLeaves];
+    CHECK_ERROR_CODE(context_->find_or_read_snapshot_pages_batch(
+      snapshot_count,
+      snapshot_ids,
+      snapshot_pages));
+  }
+  return kErrorCodeOk;
+}
+
+template <typename T>
+ErrorCode ArrayCursor::aggregate(
+  uint16_t payload_offset,
+  ArrayAggregate<T>* out,
+  ArrayRecordFilter filter,
+  void* user_data) {
+  ASSERT_ND(payload_offset + sizeof(T) <= payload_size_);
+  out->count_ = 0;
+  out->sum_ = 0;
+  out->min_ = std::numeric_limits<T>::max();
+  out->max_ = std::numeric_limits<T>::lowest();
+  thread::SnapshotCacheScanScope scan_scope(context_);
+  // open()/next() already took the read-set of the current record. proceed_page() doesn't.
+  bool cur_protected = true;
+  while (is_valid_record()) {
+    CHECK_ERROR_CODE(aggregate_page<T>(payload_offset, cur_protected, out, filter, user_data));
+    cur_protected = false;
+    CHECK_ERROR_CODE(proceed_page());
+  }
+  return kErrorCodeOk;
+}
+
+template <typename T>
+ErrorCode ArrayCursor::aggregate_page(
+  uint16_t payload_offset,
+  bool cur_protected,
+  ArrayAggregate<T>* out,
+  ArrayRecordFilter filter,
+  void* user_data) {
+  ASSERT_ND(is_valid_record());
+  const uint16_t record_size = kRecordOverhead + assorted::align8(payload_size_);
+  const uint16_t count = cur_page_end_index_ - cur_index_;
+  const ArrayOffset first_offset = cur_offset_;
+  char* const first_record = reinterpret_cast<char*>(cur_record_);
+  if ((cur_page_snapshot_ || dirty_read_) && filter == nullptr) {
+    // The common case in analytic queries. Just a strided loop over the page memory,
+    // which the compiler can unroll and vectorize.
+    const char* values = first_record + kRecordOverhead + payload_offset;
+    T sum = 0;
+    T min_value = out->min_;
+    T max_value = out->max_;
+    for (uint16_t i = 0; i < count; ++i) {
+      const T value = *reinterpret_cast<const T*>(values + i * record_size);
+      sum += value;
+      min_value = std::min<T>(min_value, value);
+      max_value = std::max<T>(max_value, value);
+    }
+    out->count_ += count;
+    out->sum_ += sum;
+    out->min_ = min_value;
+    out->max_ = max_value;
+    return kErrorCodeOk;
+  }
+
+  for (uint16_t i = 0; i < count; ++i) {
+    Record* record = reinterpret_cast<Record*>(first_record + i * record_size);
+    const bool protect = !cur_page_snapshot_ && !dirty_read_ && (i > 0 || !cur_protected);
+    xct::XctId observed = record->owner_id_.xct_id_;
+    if (protect) {
+      assorted::memory_fence_consume();  // finalize observed BEFORE reading the record.
+    }
+    if (filter == nullptr || filter(first_offset + i, record->payload_, user_data)) {
+      const T value = *reinterpret_cast<const T*>(record->payload_ + payload_offset);
+      ++out->count_;
+      out->sum_ += value;
+      out->min_ = std::min<T>(out->min_, value);
+      out->max_ = std::max<T>(out->max_, value);
+    }
+    if (protect) {
+      // we take read-set even for filtered-out records. the filter result might change.
+      CHECK_ERROR_CODE(current_xct_->add_to_read_set(
+        storage_.get_id(),
+        observed,
+        &record->owner_id_));
+    }
+  }
+  return kErrorCodeOk;
+}
+
+std::ostream& operator<<(std::ostream& o, const ArrayCursor& v) {
+  o << "<ArrayCursor>" << std::endl;
+  o << "  <storage_id_>" << v.storage_.get_id() << "</storage_id_>" << std::endl;
+  o << "  <begin_>" << v.begin_ << "</begin_>" << std::endl;
+  o << "  <end_>" << v.end_ << "</end_>" << std::endl;
+  o << "  <cur_offset_>" << v.cur_offset_ << "</cur_offset_>" << std::endl;
+  o << "  <cur_index_>" << v.cur_index_ << "</cur_index_>" << std::endl;
+  o << "  <cur_page_snapshot_>" << v.cur_page_snapshot_ << "</cur_page_snapshot_>" << std::endl;
+  o << "  <is_valid_record>" << v.is_valid_record() << "</is_valid_record>" << std::endl;
+  o << "</ArrayCursor>";
+  return o;
+}
+
+// Explicit instantiations for each primitive type. bool is excluded as it has no sum.
+#define EX_AGGREGATE(x) template ErrorCode ArrayCursor::aggregate< x > \
+  (uint16_t payload_offset, ArrayAggregate< x >* out, ArrayRecordFilter filter, void* user_data)
+INSTANTIATE_ALL_INTEGER_TYPES(EX_AGGREGATE);
+EX_AGGREGATE(float);  // NOLINT(readability/function)
+EX_AGGREGATE(double);  // NOLINT(readability/function)
+
+}  // namespace array
+}  // namespace storage
+}  // namespace foedus
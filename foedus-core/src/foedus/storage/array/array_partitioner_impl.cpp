@@ -142,8 +142,9 @@ ErrorStack ArrayPartitioner::design_partition(
     } else {
       // if no volatile page, see snapshot page owner.
       partition = extract_numa_node_from_snapshot_pointer(pointer.snapshot_pointer_);
-      // this ignores the case where neither snapshot/volatile page is there.
-      // however, as we create all pages at ArrayStorage::create(), this so far never happens.
+      // Neither of them exists for a range added by ArrayStorage::extend() until the first
+      // snapshot after that. Such children go to node-0 here. The second path below spreads
+      // them out if node-0 receives too many.
     }
     ASSERT_ND(partition < total_partitions);
     if (counts[partition] >= excessive_count) {
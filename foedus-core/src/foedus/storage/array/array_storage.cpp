@@ -57,6 +57,14 @@ ErrorStack ArrayStorage::load(const StorageControlBlock& snapshot_block) {
   return ArrayStoragePimpl(this).load(snapshot_block);
 }
 
+ErrorStack ArrayStorage::extend(ArrayOffset new_array_size, Epoch* commit_epoch) {
+  return ArrayStoragePimpl(this).extend(new_array_size, commit_epoch);
+}
+
+void ArrayStorage::apply_extend(const ArrayExtendLogType& the_log) {
+  ArrayStoragePimpl(this).apply_extend(the_log);
+}
+
 std::ostream& operator<<(std::ostream& o, const ArrayStorage& v) {
   o << "<ArrayStorage>"
     << "<id>" << v.get_id() << "</id>"
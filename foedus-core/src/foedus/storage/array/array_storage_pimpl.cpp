@@ -19,22 +19,33 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "foedus/engine.hpp"
 #include "foedus/assorted/assorted_func.hpp"
+#include "foedus/assorted/atomic_fences.hpp"
 #include "foedus/assorted/cacheline.hpp"
 #include "foedus/cache/snapshot_file_set.hpp"
 #include "foedus/debugging/stop_watch.hpp"
+#include "foedus/log/log_manager.hpp"
 #include "foedus/log/log_type.hpp"
+#include "foedus/log/meta_log_buffer.hpp"
 #include "foedus/log/thread_log_buffer.hpp"
 #include "foedus/memory/engine_memory.hpp"
 #include "foedus/memory/memory_id.hpp"
 #include "foedus/memory/numa_node_memory.hpp"
 #include "foedus/memory/page_pool.hpp"
+#include "foedus/memory/page_resolver.hpp"
 #include "foedus/savepoint/savepoint_manager.hpp"
 #include "foedus/snapshot/snapshot.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/snapshot/snapshot_manager_pimpl.hpp"
+#include "foedus/soc/shared_mutex.hpp"
 #include "foedus/storage/record.hpp"
 #include "foedus/storage/storage_manager.hpp"
 #include "foedus/storage/storage_manager_pimpl.hpp"
@@ -251,6 +262,17 @@ std::vector<uint64_t> ArrayStoragePimpl::calculate_offset_intervals(
   return offset_intervals;
 }
 
+void ArrayStoragePimpl::set_levels(uint8_t levels) {
+  ASSERT_ND(levels > 0);
+  ASSERT_ND(levels <= kMaxLevels);
+  control_block_->levels_ = levels;
+  control_block_->route_finder_ = LookupRouteFinder(levels, get_payload_size());
+  control_block_->intervals_[0] = control_block_->route_finder_.get_records_in_leaf();
+  for (uint16_t level = 1; level < levels; ++level) {
+    control_block_->intervals_[level] = control_block_->intervals_[level - 1U] * kInteriorFanout;
+  }
+}
+
 ErrorStack ArrayStoragePimpl::load_empty() {
   const uint16_t levels = calculate_levels(control_block_->meta_);
   const uint32_t payload_size = control_block_->meta_.payload_size_;
@@ -258,15 +280,10 @@ ErrorStack ArrayStoragePimpl::load_empty() {
   if (array_size > kMaxArrayOffset) {
     return ERROR_STACK(kErrorCodeStrTooLargeArray);
   }
-  control_block_->levels_ = levels;
-  control_block_->route_finder_ = LookupRouteFinder(levels, payload_size);
+  set_levels(levels);
   control_block_->root_page_pointer_.snapshot_pointer_ = 0;
   control_block_->root_page_pointer_.volatile_pointer_.word = 0;
   control_block_->meta_.root_snapshot_page_id_ = 0;
-  control_block_->intervals_[0] = control_block_->route_finder_.get_records_in_leaf();
-  for (uint16_t level = 1; level < levels; ++level) {
-    control_block_->intervals_[level] = control_block_->intervals_[level - 1U] * kInteriorFanout;
-  }
 
   VolatilePagePointer volatile_pointer;
   ArrayPage* volatile_root;
@@ -302,9 +319,8 @@ ErrorStack ArrayStoragePimpl::load(const StorageControlBlock& snapshot_block) {
   control_block_->meta_ = static_cast<const ArrayMetadata&>(snapshot_block.meta_);
   const ArrayMetadata& meta = control_block_->meta_;
   ASSERT_ND(meta.root_snapshot_page_id_ != 0);
-  const uint16_t levels = calculate_levels(meta);
-  control_block_->levels_ = levels;
-  control_block_->route_finder_ = LookupRouteFinder(levels, get_payload_size());
+  const ArrayOffset array_size = meta.array_size_;
+  set_levels(calculate_levels(meta));
   control_block_->root_page_pointer_.snapshot_pointer_ = meta.root_snapshot_page_id_;
   control_block_->root_page_pointer_.volatile_pointer_.word = 0;
 
@@ -323,6 +339,19 @@ ErrorStack ArrayStoragePimpl::load(const StorageControlBlock& snapshot_block) {
       &volatile_root));
     control_block_->root_page_pointer_.volatile_pointer_ = volatile_pointer;
     CHECK_ERROR(fileset.uninitialize());
+
+    // If extend() happened after the snapshot, the snapshot pages still have the old shape.
+    // We start from that shape and extend the volatile pages, just like extend() did.
+    const ArrayRange& root_range = reinterpret_cast<ArrayPage*>(volatile_root)->get_array_range();
+    if (root_range.end_ < array_size) {
+      LOG(INFO) << "Array-storage " << meta.name_ << " was extended after the snapshot."
+        << " Extending volatile pages from " << root_range.end_ << " to " << array_size;
+      control_block_->meta_.array_size_ = root_range.end_;
+      set_levels(reinterpret_cast<ArrayPage*>(volatile_root)->get_level() + 1U);
+      CHECK_ERROR(extend_volatile_tree(array_size));
+      ASSERT_ND(get_array_size() == array_size);
+      ASSERT_ND(get_levels() == calculate_levels(meta));
+    }
   } else {
     LOG(INFO) << "Loading an empty array-storage-" << get_meta();
     CHECK_ERROR(load_empty());
@@ -333,6 +362,208 @@ ErrorStack ArrayStoragePimpl::load(const StorageControlBlock& snapshot_block) {
   return kRetOk;
 }
 
+ErrorStack ArrayStoragePimpl::extend(ArrayOffset new_array_size, Epoch* commit_epoch) {
+  LOG(INFO) << "Extending " << get_meta().name_ << " to " << new_array_size << " records."
+    << " old size=" << get_array_size();
+  if (new_array_size > kMaxArrayOffset) {
+    LOG(ERROR) << "extend() was called with a too large size: " << new_array_size;
+    return ERROR_STACK(kErrorCodeStrTooLargeArray);
+  }
+
+  // Snapshotting reads the shape of the tree in many places, so we never change it in the
+  // middle of it. This also serializes concurrent extend() calls.
+  snapshot::SnapshotManagerPimpl* snapshot_pimpl = engine_->get_snapshot_manager()->get_pimpl();
+  soc::SharedMutexScope shape_scope(&snapshot_pimpl->control_block_->shape_mutex_);
+  if (new_array_size <= get_array_size()) {
+    LOG(INFO) << "Already has " << get_array_size() << " records. Requested = " << new_array_size;
+    return kRetOk;
+  }
+
+  // Lookups read the root pointer, levels, and ranges of right-most pages without any
+  // protection. Like drop_volatile_pages() in snapshot, we pause transactions meanwhile.
+  xct::XctManager* xct_manager = engine_->get_xct_manager();
+  xct_manager->pause_accepting_xct();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));  // almost forever in OLTP xcts.
+  ErrorStack result = extend_volatile_tree(new_array_size);
+  if (!result.is_error()) {
+    // Log this operation as a metadata operation. We get a commit_epoch here.
+    // Transactions that use the new records start after this, thus in the same or later epoch.
+    char log_buffer[sizeof(ArrayExtendLogType)];
+    std::memset(log_buffer, 0, sizeof(log_buffer));
+    ArrayExtendLogType* the_log = reinterpret_cast<ArrayExtendLogType*>(log_buffer);
+    the_log->header_.storage_id_ = get_id();
+    the_log->header_.log_type_code_ = log::get_log_code<ArrayExtendLogType>();
+    the_log->header_.log_length_ = sizeof(ArrayExtendLogType);
+    the_log->new_array_size_ = new_array_size;
+    engine_->get_log_manager()->get_meta_buffer()->commit(the_log, commit_epoch);
+  }
+  xct_manager->resume_accepting_xct();
+  CHECK_ERROR(result);
+
+  LOG(INFO) << "Extended " << get_meta().name_ << ". levels=" << static_cast<int>(get_levels());
+  return kRetOk;
+}
+
+void ArrayStoragePimpl::apply_extend(const ArrayExtendLogType& the_log) {
+  // this method is called only during restart, so no race.
+  ASSERT_ND(exists());
+  if (the_log.new_array_size_ <= get_array_size()) {
+    // the snapshot we loaded already contains this extension
+    LOG(INFO) << "Skipped redo-log of extension on array storage-" << get_meta().name_
+      << ". size=" << get_array_size();
+    return;
+  }
+  ErrorStack result = extend_volatile_tree(the_log.new_array_size_);
+  if (result.is_error()) {
+    LOG(FATAL) << "apply_extend() failed. " << result << " Failed to restart the engine";
+  }
+  LOG(INFO) << "Applied redo-log of extension on array storage-" << get_meta().name_
+    << ". size=" << get_array_size();
+}
+
+ErrorStack ArrayStoragePimpl::extend_volatile_tree(ArrayOffset new_array_size) {
+  const ArrayOffset old_array_size = get_array_size();
+  const uint8_t old_levels = get_levels();
+  ASSERT_ND(old_array_size < new_array_size);
+  ASSERT_ND(new_array_size <= kMaxArrayOffset);
+
+  uint64_t intervals[kMaxLevels];
+  intervals[0] = control_block_->route_finder_.get_records_in_leaf();
+  for (uint8_t level = 1; level < kMaxLevels; ++level) {
+    intervals[level] = intervals[level - 1U] * kInteriorFanout;
+  }
+  uint8_t new_levels = old_levels;
+  while (intervals[new_levels - 1U] < new_array_size) {
+    ++new_levels;
+    ASSERT_ND(new_levels <= kMaxLevels);
+  }
+
+  // path[level] is the page whose range ends at old_array_size in the level.
+  // pointers[level] points to it. We stop at a full page or a page not created yet.
+  // Their descendants are not affected.
+  ArrayPage* path[kMaxLevels];
+  DualPagePointer* pointers[kMaxLevels];
+  std::memset(path, 0, sizeof(path));
+  std::memset(pointers, 0, sizeof(pointers));
+  const memory::GlobalVolatilePageResolver& resolver
+    = engine_->get_memory_manager()->get_global_volatile_page_resolver();
+  uint8_t lowest_level = old_levels - 1U;
+  DualPagePointer* root_pointer = &control_block_->root_page_pointer_;
+  pointers[lowest_level] = root_pointer;
+
+  // First, make the right-most pages volatile. This part might fail, but it doesn't change
+  // anything logically. It's same as installing volatile pages for a write.
+  {
+    cache::SnapshotFileSet fileset(engine_);
+    CHECK_ERROR(fileset.initialize());
+    UninitializeGuard fileset_guard(&fileset, UninitializeGuard::kWarnIfUninitializeError);
+    if (root_pointer->volatile_pointer_.is_null()) {
+      // the snapshot might have dropped even the root (snapshot_drop_volatile_pages_threshold_)
+      ASSERT_ND(root_pointer->snapshot_pointer_ != 0);
+      VolatilePagePointer volatile_pointer;
+      Page* volatile_page;
+      CHECK_ERROR(engine_->get_memory_manager()->load_one_volatile_page(
+        &fileset,
+        root_pointer->snapshot_pointer_,
+        &volatile_pointer,
+        &volatile_page));
+      root_pointer->volatile_pointer_ = volatile_pointer;
+    }
+    path[lowest_level] = reinterpret_cast<ArrayPage*>(
+      resolver.resolve_offset(root_pointer->volatile_pointer_));
+    ASSERT_ND(path[lowest_level]->get_level() == lowest_level);
+
+    while (lowest_level > 0) {
+      const ArrayRange& range = path[lowest_level]->get_array_range();
+      ASSERT_ND(range.end_ == old_array_size);
+      const uint64_t child_interval = intervals[lowest_level - 1U];
+      const uint16_t index = (old_array_size - 1U - range.begin_) / child_interval;
+      if (range.begin_ + (index + 1U) * child_interval == old_array_size) {
+        break;  // the child is full.
+      }
+      DualPagePointer* pointer = &path[lowest_level]->get_interior_record(index);
+      if (pointer->volatile_pointer_.is_null()) {
+        if (pointer->snapshot_pointer_ == 0) {
+          break;  // not created yet. array_volatile_page_init() will use the new range.
+        }
+        VolatilePagePointer volatile_pointer;
+        Page* volatile_page;
+        CHECK_ERROR(engine_->get_memory_manager()->load_one_volatile_page(
+          &fileset,
+          pointer->snapshot_pointer_,
+          &volatile_pointer,
+          &volatile_page));
+        pointer->volatile_pointer_ = volatile_pointer;
+      }
+      --lowest_level;
+      pointers[lowest_level] = pointer;
+      path[lowest_level] = reinterpret_cast<ArrayPage*>(
+        resolver.resolve_offset(pointer->volatile_pointer_));
+      ASSERT_ND(path[lowest_level]->get_level() == lowest_level);
+    }
+    CHECK_ERROR(fileset.uninitialize());
+  }
+
+  // Then, grab new root pages if we need more levels. If this fails, we give them back.
+  VolatilePagePointer new_root_pointers[kMaxLevels];
+  ArrayPage* new_roots[kMaxLevels];
+  const thread::ThreadGroupId node = root_pointer->volatile_pointer_.components.numa_node;
+  for (uint8_t level = old_levels; level < new_levels; ++level) {
+    ErrorStack grabbed = engine_->get_memory_manager()->grab_one_volatile_page(
+      node,
+      new_root_pointers + level,
+      reinterpret_cast<Page**>(new_roots + level));
+    if (grabbed.is_error()) {
+      memory::PageReleaseBatch release_batch(engine_);
+      for (uint8_t grabbed_level = old_levels; grabbed_level < level; ++grabbed_level) {
+        release_batch.release(new_root_pointers[grabbed_level]);
+      }
+      release_batch.release_all();
+      return grabbed;
+    }
+  }
+
+  // From here, nothing fails.
+  // The snapshot versions of the right-most pages we extend still have the old ranges, so we
+  // forget them. The next snapshot writes new ones. Meanwhile, snapshot-drop and the evictor
+  // keep these volatile pages because they have no snapshot version.
+  // A full page (only the old root can be full here) keeps its range and snapshot version.
+  for (uint8_t level = lowest_level; level < old_levels; ++level) {
+    const ArrayOffset new_end = std::min<ArrayOffset>(
+      path[level]->get_array_range().begin_ + intervals[level],
+      new_array_size);
+    if (new_end != path[level]->get_array_range().end_) {
+      path[level]->extend_array_range(new_end);
+      pointers[level]->snapshot_pointer_ = 0;
+    }
+  }
+
+  // Each new root page has the previous root as its first child.
+  const Epoch initial_epoch = engine_->get_savepoint_manager()->get_initial_current_epoch();
+  VolatilePagePointer child = control_block_->root_page_pointer_.volatile_pointer_;
+  SnapshotPagePointer child_snapshot = control_block_->root_page_pointer_.snapshot_pointer_;
+  for (uint8_t level = old_levels; level < new_levels; ++level) {
+    ArrayPage* page = new_roots[level];
+    page->initialize_volatile_page(
+      initial_epoch,
+      get_id(),
+      new_root_pointers[level],
+      get_payload_size(),
+      level,
+      ArrayRange(0, intervals[level], new_array_size));
+    page->get_interior_record(0).volatile_pointer_ = child;
+    page->get_interior_record(0).snapshot_pointer_ = child_snapshot;
+    child = new_root_pointers[level];
+    child_snapshot = 0;
+  }
+
+  control_block_->root_page_pointer_.volatile_pointer_ = child;
+  control_block_->root_page_pointer_.snapshot_pointer_ = child_snapshot;
+  control_block_->meta_.array_size_ = new_array_size;
+  set_levels(new_levels);
+  assorted::memory_fence_release();
+  return kRetOk;
+}
 
 inline ErrorCode ArrayStoragePimpl::locate_record_for_read(
   thread::Thread* context,
@@ -369,6 +600,22 @@ inline ErrorCode ArrayStoragePimpl::locate_record_for_write(
   return kErrorCodeOk;
 }
 
+ErrorCode ArrayStoragePimpl::locate_record_for_replay(
+  thread::Thread* context,
+  const log::RecordLogType* log_entry,
+  xct::LockableXctId** owner_id,
+  char** payload_address) {
+  ASSERT_ND(log_entry->header_.get_type() == log::kLogCodeArrayOverwrite
+    || log_entry->header_.get_type() == log::kLogCodeArrayIncrement);
+  const ArrayCommonUpdateLogType* casted
+    = reinterpret_cast<const ArrayCommonUpdateLogType*>(log_entry);
+  Record* record = nullptr;
+  CHECK_ERROR_CODE(locate_record_for_write(context, casted->offset_, &record));
+  *owner_id = &record->owner_id_;
+  *payload_address = record->payload_;
+  return kErrorCodeOk;
+}
+
 inline ErrorCode ArrayStoragePimpl::get_record(
   thread::Thread* context,
   ArrayOffset offset,
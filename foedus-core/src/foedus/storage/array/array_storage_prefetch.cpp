@@ -20,6 +20,8 @@
 #include <glog/logging.h>
 
 #include "foedus/assert_nd.hpp"
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
 #include "foedus/debugging/stop_watch.hpp"
 #include "foedus/storage/page_prefetch.hpp"
 #include "foedus/storage/array/array_page_impl.hpp"
@@ -69,6 +71,36 @@ ErrorCode ArrayStoragePimpl::prefetch_pages_recurse(
   ArrayRange range(from, to);
   ASSERT_ND(page_range.overlaps(range));  // otherwise why we came here...
   ASSERT_ND(page_range.begin_ + (interval * kInteriorFanout) >= page_range.end_);  // probably==
+  if (snp_on && context->get_engine()->get_options().cache_.snapshot_cache_enabled_) {
+    // Read all snapshot children we will follow in batches, so that their reads are outstanding
+    // together. The find_or_read_a_snapshot_page() calls below then hit the snapshot cache.
+    SnapshotPagePointer batch_ids[thread::Thread::kMaxFindPagesBatch];
+    Page* batch_pages[thread::Thread::kMaxFindPagesBatch];
+    uint16_t batch_size = 0;
+    for (uint16_t i = 0; i < kInteriorFanout; ++i) {
+      ArrayRange child_range(
+        page_range.begin_ + i * interval,
+        page_range.begin_ + (i + 1U) * interval);
+      SnapshotPagePointer pointer = page->get_interior_record(i).snapshot_pointer_;
+      if (pointer == 0 || !range.overlaps(child_range)) {
+        continue;
+      }
+      batch_ids[batch_size] = pointer;
+      ++batch_size;
+      if (batch_size == thread::Thread::kMaxFindPagesBatch) {
+        CHECK_ERROR_CODE(context->find_or_read_snapshot_pages_batch(
+          batch_size,
+          batch_ids,
+          batch_pages));
+        batch_size = 0;
+      }
+    }
+    CHECK_ERROR_CODE(context->find_or_read_snapshot_pages_batch(
+      batch_size,
+      batch_ids,
+      batch_pages));
+  }
+
   for (uint16_t i = 0; i < kInteriorFanout; ++i) {
     ArrayRange child_range(
       page_range.begin_ + i * interval,
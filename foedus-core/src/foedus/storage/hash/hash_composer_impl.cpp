@@ -30,6 +30,7 @@
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
 #include "foedus/assorted/assorted_func.hpp"
+#include "foedus/assorted/raw_atomics.hpp"
 #include "foedus/cache/snapshot_file_set.hpp"
 #include "foedus/debugging/stop_watch.hpp"
 #include "foedus/fs/direct_io_file.hpp"
@@ -131,22 +132,25 @@ ErrorStack HashComposer::construct_root(const Composer::ConstructRootArguments&
 
   // compose() created root_info_pages that contain pointers to fill in the root page,
   // so we just find non-zero entry and copy it to root page.
-  const uint8_t levels = storage_.get_levels();
+  HashStorageControlBlock* control_block = storage_.get_control_block();
+  const uint8_t levels = control_block->get_snapshot_levels();
+  const bool resizing = control_block->is_resizing_in_snapshot();
 
   HashIntermediatePage* root_page = reinterpret_cast<HashIntermediatePage*>(
     args.gleaner_resource_->tmp_root_page_memory_.get_block());
   SnapshotPagePointer old_root_page_id = storage_.get_metadata()->root_snapshot_page_id_;
-  if (old_root_page_id != 0) {
+  if (old_root_page_id != 0 && !resizing) {
     WRAP_ERROR_CODE(args.previous_snapshot_files_->read_page(old_root_page_id, root_page));
     ASSERT_ND(root_page->header().storage_id_ == storage_id_);
     ASSERT_ND(root_page->header().page_id_ == old_root_page_id);
-    ASSERT_ND(root_page->get_level() + 1U == storage_.get_levels());
+    ASSERT_ND(root_page->get_level() + 1U == levels);
     root_page->header().page_id_ = 0;
   } else {
+    // when resizing, compose() has written out all bins in the new layout. start from scratch.
     root_page->initialize_snapshot_page(
       storage_id_,
       0,  // new page ID not known at this point
-      storage_.get_levels() - 1U,
+      levels - 1U,
       0);
   }
 
@@ -197,15 +201,102 @@ ErrorStack HashComposer::construct_root(const Composer::ConstructRootArguments&
 
   *args.new_root_page_pointer_ = new_root_page_id;
   // AFTER writing out the root page, install the pointer to new root page
-  storage_.get_control_block()->root_page_pointer_.snapshot_pointer_ = new_root_page_id;
-  storage_.get_control_block()->meta_.root_snapshot_page_id_ = new_root_page_id;
+  control_block->root_page_pointer_.snapshot_pointer_ = new_root_page_id;
+  control_block->meta_.root_snapshot_page_id_ = new_root_page_id;
+  HashIntermediatePage* volatile_root
+    = resolve_intermediate(control_block->root_page_pointer_.volatile_pointer_);
+  if (!resizing && levels > 1U && volatile_root) {
+    CHECK_ERROR(install_snapshot_intermediate_pointers(
+      args.previous_snapshot_files_,
+      root_page,
+      volatile_root));
+  }
+  if (resizing) {
+    // meta_.bin_bits_ is switched in drop_volatiles(). Until then, volatile pages and
+    // transactions keep using the old layout. The snapshot metadata gets the new bin_bits
+    // in StorageManager::clone_all_storage_metadata().
+    control_block->resized_snapshot_id_ = args.snapshot_writer_->get_snapshot_id();
+    LOG(INFO) << to_string() << " composed the new layout. bin_bits="
+      << static_cast<int>(control_block->snapshot_bin_bits_);
+  }
+
+  check_chain_length();
+  return kRetOk;
+}
+
+void HashComposer::check_chain_length() {
+  HashStorageControlBlock* control_block = storage_.get_control_block();
+  const uint16_t threshold = control_block->meta_.resize_chain_length_threshold_;
+  const uint64_t bins = control_block->composed_bins_;
+  const uint64_t pages = control_block->composed_pages_;
+  if (threshold == 0 || bins == 0) {
+    return;
+  }
+
+  // in percent of one page, same as the threshold
+  const uint64_t average_chain_length = pages * 100ULL / bins;
+  VLOG(0) << to_string() << " composed " << bins << " bins with " << pages << " data pages."
+    << " average chain length=" << average_chain_length << "%, threshold=" << threshold << "%";
+  if (average_chain_length <= threshold) {
+    return;
+  }
+
+  const uint8_t new_bin_bits = control_block->snapshot_bin_bits_ + 1U;
+  if (new_bin_bits > kHashMaxBinBits) {
+    LOG(WARNING) << to_string() << " has long chains, but it already has the max bin_bits";
+    return;
+  }
+  LOG(INFO) << to_string() << " has long chains. average chain length=" << average_chain_length
+    << "%, threshold=" << threshold << "%. Requesting to resize to bin_bits="
+    << static_cast<int>(new_bin_bits);
+  HashStorage storage(engine_, control_block);
+  ErrorStack ret = storage.request_resize(new_bin_bits);
+  if (ret.is_error()) {
+    // not a critical error. the storage just keeps the current bins.
+    LOG(WARNING) << to_string() << " couldn't request resize: " << ret;
+  }
+}
+
+ErrorStack HashComposer::install_snapshot_intermediate_pointers(
+  cache::SnapshotFileSet* fileset,
+  const HashIntermediatePage* snapshot_page,
+  HashIntermediatePage* volatile_page) const {
+  ASSERT_ND(snapshot_page->get_level() == volatile_page->get_level());
+  ASSERT_ND(snapshot_page->get_bin_range() == volatile_page->get_bin_range());
+  if (volatile_page->get_level() == 0) {
+    return kRetOk;  // pointers to data pages are installed in compose()
+  }
+
+  // one page per level is enough because we go down depth-first
+  memory::AlignedMemory child_memory;
+  for (uint16_t i = 0; i < kHashIntermediatePageFanout; ++i) {
+    DualPagePointer* pointer = volatile_page->get_pointer_address(i);
+    SnapshotPagePointer snapshot_pointer = snapshot_page->get_pointer(i).snapshot_pointer_;
+    if (pointer->volatile_pointer_.is_null() || snapshot_pointer == 0) {
+      continue;
+    }
+    pointer->snapshot_pointer_ = snapshot_pointer;
+    if (volatile_page->get_level() == 1U) {
+      continue;  // the child is a level-0 page. no need to read the snapshot page.
+    }
+    if (child_memory.is_null()) {
+      child_memory.alloc(kPageSize, kPageSize, memory::AlignedMemory::kNumaAllocOnnode, 0);
+    }
+    HashIntermediatePage* snapshot_child
+      = reinterpret_cast<HashIntermediatePage*>(child_memory.get_block());
+    WRAP_ERROR_CODE(fileset->read_page(snapshot_pointer, snapshot_child));
+    CHECK_ERROR(install_snapshot_intermediate_pointers(
+      fileset,
+      snapshot_child,
+      resolve_intermediate(pointer->volatile_pointer_)));
+  }
   return kRetOk;
 }
 
 ErrorStack HashComposer::construct_root_single_level(
   const Composer::ConstructRootArguments& args,
   HashIntermediatePage* root_page) {
-  ASSERT_ND(storage_.get_levels() == 1U);
+  ASSERT_ND(storage_.get_control_block()->get_snapshot_levels() == 1U);
   LOG(INFO) << to_string() << " construct_root() Single-level path";
   snapshot::SnapshotId new_snapshot_id = args.snapshot_writer_->get_snapshot_id();
 
@@ -214,7 +305,7 @@ ErrorStack HashComposer::construct_root_single_level(
   HashComposedBinsPage* buffer = reinterpret_cast<HashComposedBinsPage*>(
     args.gleaner_resource_->writer_pool_memory_.get_block());  // whatever memory. just 1 thread.
   uint32_t buffer_pages = args.gleaner_resource_->writer_pool_memory_.get_size() / kPageSize;
-  uint16_t root_children = storage_.get_root_children();
+  uint16_t root_children = storage_.get_control_block()->get_snapshot_root_children();
   ASSERT_ND(buffer_pages > root_children);
   for (uint32_t i = 0; i < args.root_info_pages_count_; ++i) {
     const HashRootInfoPage* casted
@@ -261,7 +352,8 @@ ErrorStack HashComposer::construct_root_multi_level(
   uint16_t numa_node,
   HashIntermediatePage* root_page) {
   const uint16_t nodes = engine_->get_soc_count();
-  const uint16_t root_children = storage_.get_root_children();
+  const uint16_t root_children = storage_.get_control_block()->get_snapshot_root_children();
+  const uint8_t levels = storage_.get_control_block()->get_snapshot_levels();
   ASSERT_ND(numa_node < nodes);
   thread::NumaThreadScope numa_scope(numa_node);
 
@@ -353,7 +445,7 @@ ErrorStack HashComposer::construct_root_multi_level(
       WRAP_ERROR_CODE(snapshot_writer->dump_pages(0, writer_buffer_pos));
 
       // higher-levels need to set page IDs because we couldn't know their page IDs back then.
-      if (storage_.get_levels() == 2U) {
+      if (levels == 2U) {
         // 2-level means root's child is level-0 page, thus no "higher-level".
         ASSERT_ND(writer_higher_buffer_pos == 0);
       } else {
@@ -362,7 +454,7 @@ ErrorStack HashComposer::construct_root_multi_level(
           = reinterpret_cast<HashIntermediatePage*>(snapshot_writer->get_intermediate_base());
         // the first page is always the root-child because we open it first
         HashIntermediatePage* root_child = higher_base + 0;
-        ASSERT_ND(root_child->get_level() == storage_.get_levels() - 2U);
+        ASSERT_ND(root_child->get_level() == levels - 2U);
         ASSERT_ND(root_page->get_pointer(index).snapshot_pointer_ == 0);
         // and this is the highest level for this sub-tree, so there is no pointer to this page.
         // hence, page_id==0 means null.
@@ -449,25 +541,31 @@ HashComposeContext::HashComposeContext(
     previous_snapshot_files_(previous_snapshot_files),
     root_info_page_(reinterpret_cast<HashRootInfoPage*>(root_info_page)),
     partitionable_(engine_->get_soc_count() > 1U),
-    levels_(storage_.get_levels()),
-    bin_bits_(storage_.get_bin_bits()),
-    bin_shifts_(storage_.get_bin_shifts()),
-    root_children_(storage_.get_root_children()),
+    levels_(storage_.get_control_block()->get_snapshot_levels()),
+    bin_bits_(storage_.get_control_block()->snapshot_bin_bits_),
+    bin_shifts_(64U - bin_bits_),
+    root_children_(storage_.get_control_block()->get_snapshot_root_children()),
     numa_node_(snapshot_writer->get_numa_node()),
-    total_bin_count_(storage_.get_bin_count()),
+    total_bin_count_(1ULL << bin_bits_),
     previous_root_page_pointer_(storage_.get_metadata()->root_snapshot_page_id_),
+    previous_levels_(storage_.get_levels()),
+    resize_shifts_(bin_bits_ - storage_.get_bin_bits()),
     volatile_resolver_(engine->get_memory_manager()->get_global_volatile_page_resolver()) {
+  ASSERT_ND(bin_bits_ >= storage_.get_bin_bits());
   cur_path_memory_.alloc(
     kPageSize * kHashMaxLevels,
     kPageSize,
     memory::AlignedMemory::kNumaAllocOnnode,
     numa_node_);
   cur_path_ = reinterpret_cast<HashIntermediatePage*>(cur_path_memory_.get_block());
-  cur_path_lowest_level_ = levels_;
+  cur_path_lowest_level_ = previous_levels_;
   cur_path_valid_range_ = HashBinRange(0, 0);
 
   cur_bin_ = kCurBinNotOpened;
   cur_intermediate_tail_ = nullptr;
+  resize_next_bin_ = 0;
+  composed_bins_ = 0;
+  composed_pages_ = 0;
 
   data_page_io_memory_.alloc(
     kPageSize,
@@ -504,15 +602,20 @@ ErrorStack HashComposeContext::execute() {
     }
     processed_any = true;
     const snapshot::MergeSort::SortEntry* sort_entries = merge_sort_->get_sort_entries();
+    // sort key is the bin in kHashMaxBinBits. see HashCommonLogType::get_sort_bin()
+    const uint8_t key_shifts = kHashMaxBinBits - bin_bits_;
     uint64_t cur = 0;
     while (cur < count) {
-      HashBin head_bin = sort_entries[cur].get_key();
-      ASSERT_ND(head_bin < storage_.get_bin_count());
+      HashBin head_bin = sort_entries[cur].get_key() >> key_shifts;
+      ASSERT_ND(head_bin < total_bin_count_);
       if (cur_bin_ != head_bin) {
         // now we have to finalize the previous bin and switch to a new bin!
         ASSERT_ND(cur_bin_ == kCurBinNotOpened || cur_bin_ < head_bin);  // sorted by bins
         CHECK_ERROR(close_cur_bin());
         ASSERT_ND(cur_bin_ == kCurBinNotOpened);
+        if (is_resizing()) {
+          CHECK_ERROR(carry_over_bins(head_bin));
+        }
         CHECK_ERROR(open_cur_bin(head_bin));
         ASSERT_ND(cur_bin_ == head_bin);
       }
@@ -521,7 +624,7 @@ ErrorStack HashComposeContext::execute() {
       uint64_t next;
       for (next = cur + 1U; LIKELY(next < count); ++next) {
         // this check uses sort_entries which are nicely contiguous.
-        HashBin bin = sort_entries[next].get_key();
+        HashBin bin = sort_entries[next].get_key() >> key_shifts;
         ASSERT_ND(bin >= head_bin);
         if (UNLIKELY(bin != head_bin)) {
           break;
@@ -553,7 +656,7 @@ ErrorCode HashComposeContext::apply_batch(uint64_t cur, uint64_t next) {
       const HashCommonLogType* log = reinterpret_cast<const HashCommonLogType*>(logs[i]);
       log->assert_type();
       HashValue hash = log->hash_;
-      ASSERT_ND(cur_bin_ == (hash >> storage_.get_bin_shifts()));
+      ASSERT_ND(cur_bin_ == (hash >> bin_shifts_));
       if (log->header_.get_type() == log::kLogCodeHashOverwrite) {
         CHECK_ERROR_CODE(cur_bin_table_.overwrite_record(
           log->header_.xct_id_,
@@ -563,6 +666,16 @@ ErrorCode HashComposeContext::apply_batch(uint64_t cur, uint64_t next) {
           log->get_payload(),
           log->payload_offset_,
           log->payload_count_));
+      } else if (log->header_.get_type() == log::kLogCodeHashIncrement) {
+        const HashIncrementLogType* casted = reinterpret_cast<const HashIncrementLogType*>(log);
+        CHECK_ERROR_CODE(cur_bin_table_.increment_record(
+          log->header_.xct_id_,
+          log->get_key(),
+          log->key_length_,
+          hash,
+          casted->get_value_type(),
+          log->get_payload(),
+          log->payload_offset_));
       } else if (log->header_.get_type() == log::kLogCodeHashInsert) {
         CHECK_ERROR_CODE(cur_bin_table_.insert_record(
           log->header_.xct_id_,
@@ -596,6 +709,9 @@ ErrorCode HashComposeContext::apply_batch(uint64_t cur, uint64_t next) {
 
 ErrorStack HashComposeContext::finalize() {
   CHECK_ERROR(close_cur_bin());
+  if (is_resizing()) {
+    CHECK_ERROR(carry_over_bins(total_bin_count_));
+  }
 
   // flush the main buffer. now we finalized all data pages
   if (allocated_pages_ > 0) {
@@ -605,8 +721,18 @@ ErrorStack HashComposeContext::finalize() {
 
   // as soon as we flush out all data pages, we can install snapshot pointers to them.
   // this is just about data pages (head pages in each bin), not intermediate pages
-  uint64_t installed_count = 0;
-  CHECK_ERROR(install_snapshot_data_pages(&installed_count));
+  if (is_resizing()) {
+    // volatile pages are still in the old layout. HashComposer::drop_volatiles() replaces them.
+    VLOG(0) << "HashStorage-" << storage_id_ << " is resizing. Not installing pointers";
+  } else {
+    uint64_t installed_count = 0;
+    CHECK_ERROR(install_snapshot_data_pages(&installed_count));
+  }
+
+  // for the chain-length check in HashComposer::construct_root(). reducers run concurrently.
+  HashStorageControlBlock* control_block = storage_.get_control_block();
+  assorted::raw_atomic_fetch_add<uint64_t>(&control_block->composed_bins_, composed_bins_);
+  assorted::raw_atomic_fetch_add<uint64_t>(&control_block->composed_pages_, composed_pages_);
 
   // then dump out HashComposedBinsPage.
   // we stored them in a separate buffer, and now finally we can get their page IDs.
@@ -679,24 +805,24 @@ SnapshotPagePointer HashComposeContext::get_cur_path_bin_head(HashBin bin) const
     return 0;
   }
   ASSERT_ND(cur_path_[0].get_bin_range().contains(bin));
-  uint16_t index = bin - cur_path_[0].get_bin_range().end_;
+  uint16_t index = bin - cur_path_[0].get_bin_range().begin_;
   return cur_path_[0].get_pointer(index).snapshot_pointer_;
 }
 
 ErrorStack HashComposeContext::init_cur_path() {
   if (previous_root_page_pointer_ == 0) {
     ASSERT_ND(is_initial_snapshot());
-    std::memset(cur_path_, 0, kPageSize * levels_);
-    cur_path_lowest_level_ = levels_;
-    cur_path_valid_range_ = HashBinRange(0, kHashMaxBins[levels_]);
+    std::memset(cur_path_, 0, kPageSize * previous_levels_);
+    cur_path_lowest_level_ = previous_levels_;
+    cur_path_valid_range_ = HashBinRange(0, kHashMaxBins[previous_levels_]);
   } else {
     ASSERT_ND(!is_initial_snapshot());
-    HashIntermediatePage* root = get_cur_path_page(levels_ - 1U);
+    HashIntermediatePage* root = get_cur_path_page(previous_levels_ - 1U);
     WRAP_ERROR_CODE(previous_snapshot_files_->read_page(previous_root_page_pointer_, root));
     ASSERT_ND(root->header().storage_id_ == storage_id_);
     ASSERT_ND(root->header().page_id_ == previous_root_page_pointer_);
-    ASSERT_ND(root->get_level() + 1U == levels_);
-    ASSERT_ND(root->get_bin_range() == HashBinRange(0ULL, kHashMaxBins[levels_]));
+    ASSERT_ND(root->get_level() + 1U == previous_levels_);
+    ASSERT_ND(root->get_bin_range() == HashBinRange(0ULL, kHashMaxBins[previous_levels_]));
     cur_path_lowest_level_ = root->get_level();
     cur_path_valid_range_ = root->get_bin_range();
 
@@ -712,7 +838,7 @@ ErrorStack HashComposeContext::init_cur_path() {
         ASSERT_ND(child->header().storage_id_ == storage_id_);
         ASSERT_ND(child->header().page_id_ == pointer);
         ASSERT_ND(child->get_level() + 1U == parent->get_level());
-        ASSERT_ND(child->get_bin_range() == HashBinRange(0ULL, parent->get_level()));
+        ASSERT_ND(child->get_bin_range() == HashBinRange(0ULL, kHashMaxBins[parent->get_level()]));
         cur_path_lowest_level_ = child->get_level();
         cur_path_valid_range_ = child->get_bin_range();
         parent = child;
@@ -727,7 +853,7 @@ inline ErrorCode HashComposeContext::update_cur_path_if_needed(HashBin bin) {
 
   // Even when LIKELY mis-predicts, the penalty is amortized by the page-read cost.
   if (LIKELY(is_initial_snapshot()
-    || levels_ == 1U
+    || previous_levels_ == 1U
     || (cur_path_valid_range_.contains(bin) && cur_path_lowest_level_ == 0))) {
     return kErrorCodeOk;
   }
@@ -737,13 +863,16 @@ inline ErrorCode HashComposeContext::update_cur_path_if_needed(HashBin bin) {
 
 ErrorCode HashComposeContext::update_cur_path(HashBin bin) {
   ASSERT_ND(!is_initial_snapshot());
-  ASSERT_ND(!cur_path_valid_range_.contains(bin));
-  ASSERT_ND(levels_ > 1U);  // otherwise no page switch should happen
+  // cur_path_valid_range_ might contain bin if cur_path_lowest_level_ > 0, meaning the child
+  // page doesn't exist in previous snapshot. then we just check again below.
+  ASSERT_ND(!cur_path_valid_range_.contains(bin) || cur_path_lowest_level_ > 0);
+  ASSERT_ND(previous_levels_ > 1U);  // otherwise no page switch should happen
   ASSERT_ND(verify_cur_path());
 
   // goes up until cur_path_valid_range_.contains(bin)
   while (!cur_path_valid_range_.contains(bin)) {
-    ASSERT_ND(cur_path_lowest_level_ + 1U < levels_);  // otherwise even root doesn't contain it
+    // otherwise even root doesn't contain it
+    ASSERT_ND(cur_path_lowest_level_ + 1U < previous_levels_);
     ++cur_path_lowest_level_;
     cur_path_valid_range_ = get_cur_path_lowest()->get_bin_range();
     ASSERT_ND(get_cur_path_lowest()->get_bin_range() == cur_path_valid_range_);
@@ -755,7 +884,7 @@ ErrorCode HashComposeContext::update_cur_path(HashBin bin) {
 #ifndef NDEBUG
   // route[level+1] is the ordinal in intermediate page of the level+1, pointing to the child.
   // thus cur_path[level] should have that pointer as its page ID.
-  for (uint8_t level = cur_path_lowest_level_; level + 1U < levels_; ++level) {
+  for (uint8_t level = cur_path_lowest_level_; level + 1U < previous_levels_; ++level) {
     SnapshotPagePointer child_id = get_cur_path_page(level)->header().page_id_;
     HashIntermediatePage* parent = get_cur_path_page(level + 1U);
     ASSERT_ND(parent->get_pointer(route.route[level + 1U]).snapshot_pointer_ == child_id);
@@ -770,7 +899,7 @@ ErrorCode HashComposeContext::update_cur_path(HashBin bin) {
       // the page doesn't exist in previous snapshot. that's fine.
       break;
     } else {
-      HashIntermediatePage* child = get_cur_path_page(cur_path_lowest_level_ + 1U);
+      HashIntermediatePage* child = get_cur_path_page(cur_path_lowest_level_ - 1U);
       CHECK_ERROR_CODE(previous_snapshot_files_->read_page(pointer, child));
       ASSERT_ND(child->header().storage_id_ == storage_id_);
       ASSERT_ND(child->header().page_id_ == pointer);
@@ -789,12 +918,12 @@ ErrorCode HashComposeContext::update_cur_path(HashBin bin) {
 
 bool HashComposeContext::verify_cur_path() const {
   if (is_initial_snapshot()) {
-    ASSERT_ND(cur_path_lowest_level_ == levels_);
+    ASSERT_ND(cur_path_lowest_level_ == previous_levels_);
   } else {
-    ASSERT_ND(cur_path_lowest_level_ < levels_);
+    ASSERT_ND(cur_path_lowest_level_ < previous_levels_);
   }
   for (uint8_t level = cur_path_lowest_level_; level < kHashMaxLevels; ++level) {
-    if (level >= levels_) {
+    if (level >= previous_levels_) {
       ASSERT_ND(cur_path_[level].header().page_id_ == 0);
       continue;
     }
@@ -827,22 +956,29 @@ ErrorStack HashComposeContext::close_cur_bin() {
   // we flush pages so far via a very conservative estimate.
   // assuming each bin receives a small number of records, this doesn't harm anything.
   uint32_t physical_records = cur_bin_table_.get_physical_record_count();
+  if (is_resizing() && physical_records == 0) {
+    // the bin is new in this layout, so there is no previous page to overwrite. skip it.
+    cur_bin_ = kCurBinNotOpened;
+    return kRetOk;
+  }
   if (UNLIKELY(physical_records > 1000U)) {
     LOG(WARNING) << "A hash bin has more than 1000 records?? That's an unexpected usage."
       << " There is either a skew or mis-sizing.";
   }
-  uint64_t remaining_buffer = allocated_pages_ - max_pages_;
-  if (UNLIKELY(remaining_buffer < physical_records)) {  // super-conservative. one-record per page.
+  uint64_t remaining_buffer = max_pages_ - allocated_pages_;
+  // super-conservative. one-record per page, plus the head page.
+  if (UNLIKELY(remaining_buffer < physical_records + 1U) && allocated_pages_ > 0) {
     WRAP_ERROR_CODE(dump_data_pages());
   }
 
   const SnapshotPagePointer base_pointer = snapshot_writer_->get_next_page_id();
   HashDataPage* head_page = page_base_ + allocated_pages_;
   SnapshotPagePointer head_page_id = base_pointer + allocated_pages_;
-  const uint8_t bin_bits = storage_.get_bin_bits();
-  const uint8_t bin_shifts = storage_.get_bin_shifts();
+  const uint8_t bin_bits = bin_bits_;
+  const uint8_t bin_shifts = bin_shifts_;
   head_page->initialize_snapshot_page(storage_id_, head_page_id, cur_bin_, bin_bits, bin_shifts);
   ++allocated_pages_;
+  ++composed_pages_;
   ASSERT_ND(allocated_pages_ <= max_pages_);
 
   HashDataPage* cur_page = head_page;
@@ -850,7 +986,7 @@ ErrorStack HashComposeContext::close_cur_bin() {
   const uint32_t end = cur_bin_table_.get_records_consumed();
   for (uint32_t i = begin; i < end; ++i) {
     HashTmpBin::Record* record = cur_bin_table_.get_record(i);
-    ASSERT_ND(cur_bin_ == (record->hash_ >> storage_.get_bin_shifts()));
+    ASSERT_ND(cur_bin_ == (record->hash_ >> bin_shifts_));
     if (record->xct_id_.is_deleted()) {
       continue;
     }
@@ -865,6 +1001,7 @@ ErrorStack HashComposeContext::close_cur_bin() {
       cur_page = next_page;
 
       ++allocated_pages_;
+      ++composed_pages_;
       ASSERT_ND(allocated_pages_ <= max_pages_);
     }
 
@@ -881,6 +1018,7 @@ ErrorStack HashComposeContext::close_cur_bin() {
 
   // finally, register the head page in intermediate page. the bin is now closed.
   WRAP_ERROR_CODE(append_to_intermediate(head_page_id, cur_bin_));
+  ++composed_bins_;
   cur_bin_ = kCurBinNotOpened;
 
   return kRetOk;
@@ -888,20 +1026,22 @@ ErrorStack HashComposeContext::close_cur_bin() {
 
 ErrorStack HashComposeContext::open_cur_bin(HashBin bin) {
   ASSERT_ND(cur_bin_ == kCurBinNotOpened);
+  // the bin in previous snapshot. same as bin unless resizing.
+  const HashBin previous_bin = bin >> resize_shifts_;
   // switch to an intermediate page containing this bin
-  WRAP_ERROR_CODE(update_cur_path_if_needed(bin));
+  WRAP_ERROR_CODE(update_cur_path_if_needed(previous_bin));
 
   cur_bin_table_.clean_quick();
 
   // Load-up the cur_bin_table_ with existing records in previous snapshot
-  SnapshotPagePointer page_id = get_cur_path_bin_head(bin);
+  SnapshotPagePointer page_id = get_cur_path_bin_head(previous_bin);
   while (page_id) {
     HashDataPage* page = reinterpret_cast<HashDataPage*>(data_page_io_memory_.get_block());
     // hopefully, most of this read will be sequential. so underlying HW will pre-fetch and cache
     WRAP_ERROR_CODE(previous_snapshot_files_->read_page(page_id, page));
     ASSERT_ND(page->header().storage_id_ == storage_id_);
     ASSERT_ND(page->header().page_id_ == page_id);
-    ASSERT_ND(page->get_bin() == bin);
+    ASSERT_ND(page->get_bin() == previous_bin);
     ASSERT_ND(page->next_page().volatile_pointer_.is_null());
     uint16_t records = page->get_record_count();
     for (uint16_t i = 0; i < records; ++i) {
@@ -909,6 +1049,9 @@ ErrorStack HashComposeContext::open_cur_bin(HashBin bin) {
       ASSERT_ND(!slot.tid_.xct_id_.is_deleted());
       ASSERT_ND(!slot.tid_.xct_id_.is_moved());
       ASSERT_ND(!slot.tid_.xct_id_.is_being_written());
+      if (is_resizing() && (slot.hash_ >> bin_shifts_) != bin) {
+        continue;  // goes to another bin split from previous_bin
+      }
       const char* data = page->record_from_offset(slot.offset_);
       WRAP_ERROR_CODE(cur_bin_table_.insert_record(
         slot.tid_.xct_id_,
@@ -922,6 +1065,31 @@ ErrorStack HashComposeContext::open_cur_bin(HashBin bin) {
   }
 
   cur_bin_ = bin;
+  resize_next_bin_ = bin + 1U;
+  return kRetOk;
+}
+
+ErrorStack HashComposeContext::carry_over_bins(HashBin until) {
+  ASSERT_ND(is_resizing());
+  ASSERT_ND(cur_bin_ == kCurBinNotOpened);
+  ASSERT_ND(until <= total_bin_count_);
+  if (is_initial_snapshot()) {
+    resize_next_bin_ = until;  // nothing to carry over
+    return kRetOk;
+  }
+
+  while (resize_next_bin_ < until) {
+    const HashBin bin = resize_next_bin_;
+    const HashBin previous_bin = bin >> resize_shifts_;
+    WRAP_ERROR_CODE(update_cur_path_if_needed(previous_bin));
+    if (get_cur_path_bin_head(previous_bin) == 0) {
+      ++resize_next_bin_;  // empty in previous snapshot
+      continue;
+    }
+    CHECK_ERROR(open_cur_bin(bin));
+    ASSERT_ND(resize_next_bin_ == bin + 1U);
+    CHECK_ERROR(close_cur_bin());
+  }
   return kRetOk;
 }
 
@@ -934,7 +1102,7 @@ ErrorStack HashComposeContext::init_intermediates() {
   ASSERT_ND(allocated_intermediates_ == 0);
   ASSERT_ND(intermediate_base_
     == reinterpret_cast<HashComposedBinsPage*>(snapshot_writer_->get_intermediate_base()));
-  uint16_t count = storage_.get_root_children();
+  uint16_t count = root_children_;
   if (max_intermediates_ < count) {
     return ERROR_STACK_MSG(kErrorCodeInternalError, "max_intermediates weirdly too small");
   }
@@ -1163,6 +1331,17 @@ ErrorStack HashComposeContext::install_snapshot_data_pages_root_child(
 ///
 /////////////////////////////////////////////////////////////////////////////
 Composer::DropResult HashComposer::drop_volatiles(const Composer::DropVolatilesArguments& args) {
+  if (storage_.get_control_block()->resized_snapshot_id_ == args.snapshot_.id_) {
+    if (args.evict_pressure_ > 0) {
+      // drop_volatiles_resized() already rebuilt the volatile pages after the snapshot.
+      // the volatile page evictor doesn't touch them until the next snapshot.
+      Composer::DropResult result(args);
+      result.dropped_all_ = false;
+      return result;
+    }
+    return drop_volatiles_resized(args);
+  }
+
   Composer::DropResult result(args);
   if (storage_.get_hash_metadata()->keeps_all_volatile_pages()) {
     LOG(INFO) << "Keep-all-volatile: Storage-" << storage_.get_name()
@@ -1212,6 +1391,11 @@ void HashComposer::drop_volatiles_child(
       args.snapshot_.valid_until_epoch_)) {
       drop_volatile_entire_bin(args, child_pointer);
     } else {
+      for (HashDataPage* cur = resolve_data(child_pointer->volatile_pointer_);
+            cur;
+            cur = resolve_data(cur->next_page().volatile_pointer_)) {
+        cur->header().decay_hotness();
+      }
       result->dropped_all_ = false;
       // in hash composer, we currently do not emit accurate information on this.
       // we are not using this information anyway.
@@ -1226,7 +1410,7 @@ void HashComposer::drop_root_volatile(const Composer::DropVolatilesArguments& ar
       << " is configured to keep all volatile pages.";
     return;
   }
-  if (is_to_keep_volatile(storage_.get_levels() - 1U)) {
+  if (is_to_keep_volatile(args, storage_.get_levels() - 1U)) {
     LOG(INFO) << "Oh, but Storage-" << storage_.get_name() << " is configured to keep"
       << " the root page.";
     return;
@@ -1300,7 +1484,7 @@ inline Composer::DropResult HashComposer::drop_volatiles_recurse(
     }
   }
   if (result.dropped_all_) {
-    if (is_to_keep_volatile(page->get_level())) {
+    if (is_to_keep_volatile(args, page->get_level())) {
       DVLOG(2) << "Exempted";
       result.dropped_all_ = false;
     } else {
@@ -1330,7 +1514,220 @@ bool HashComposer::can_drop_volatile_bin(VolatilePagePointer head, Epoch valid_u
 }
 
 
-inline bool HashComposer::is_to_keep_volatile(uint16_t level) {
+Composer::DropResult HashComposer::drop_volatiles_resized(
+  const Composer::DropVolatilesArguments& args) {
+  // We never drop the new root page. Other threads must not try either.
+  Composer::DropResult result(args);
+  result.dropped_all_ = false;
+  result.max_observed_ = args.snapshot_.valid_until_epoch_.one_more();
+  if (args.partitioned_drop_ && args.my_partition_ != 0) {
+    // node-0 composed all bins of the resizing snapshot, so node-0 rebuilds everything, too.
+    return result;
+  }
+
+  debugging::StopWatch watch;
+  ErrorStack ret = rebuild_volatiles(args);
+  if (ret.is_error()) {
+    // The snapshot is already written out in the new layout, and we can't report an error
+    // from here. This happens only when we run out of volatile pages or snapshot reads fail,
+    // either of which will be a fatal error soon anyways.
+    LOG(FATAL) << to_string() << " failed to rebuild volatile pages in the new layout: " << ret;
+  }
+  watch.stop();
+  LOG(INFO) << to_string() << " switched to bin_bits=" << static_cast<int>(storage_.get_bin_bits())
+    << ". rebuilt volatile pages in " << watch.elapsed_ms() << "ms";
+  return result;
+}
+
+ErrorStack HashComposer::rebuild_volatiles(const Composer::DropVolatilesArguments& args) {
+  HashStorageControlBlock* control_block = storage_.get_control_block();
+  ASSERT_ND(control_block->is_resizing_in_snapshot());
+  ASSERT_ND(control_block->snapshot_bin_bits_ > control_block->meta_.bin_bits_);
+  DualPagePointer* root_pointer = &control_block->root_page_pointer_;
+  ASSERT_ND(root_pointer->snapshot_pointer_ == control_block->meta_.root_snapshot_page_id_);
+  ASSERT_ND(extract_snapshot_id_from_snapshot_pointer(root_pointer->snapshot_pointer_)
+    == args.snapshot_.id_);
+
+  cache::SnapshotFileSet fileset(engine_);
+  CHECK_ERROR(fileset.initialize());
+  UninitializeGuard fileset_guard(&fileset, UninitializeGuard::kWarnIfUninitializeError);
+
+  // The new root page is a volatile image of the new snapshot root, like HashStorage::load().
+  VolatilePagePointer new_root_pointer;
+  HashIntermediatePage* new_root;
+  CHECK_ERROR(engine_->get_memory_manager()->load_one_volatile_page(
+    &fileset,
+    root_pointer->snapshot_pointer_,
+    &new_root_pointer,
+    reinterpret_cast<Page**>(&new_root)));
+  ASSERT_ND(new_root->get_level() + 1U == control_block->get_snapshot_levels());
+
+  HashIntermediatePage* old_root = resolve_intermediate(root_pointer->volatile_pointer_);
+  if (old_root == nullptr) {
+    LOG(INFO) << "No volatile root page. Probably while restart";
+  } else {
+    CHECK_ERROR(rebuild_volatiles_recurse(args, &fileset, old_root, new_root));
+    args.drop(engine_, root_pointer->volatile_pointer_);
+  }
+
+  // Switch to the new layout. Transactions are paused, so nobody sees the intermediate state.
+  control_block->meta_.bin_bits_ = control_block->snapshot_bin_bits_;
+  control_block->bin_count_ = 1ULL << control_block->meta_.bin_bits_;
+  control_block->levels_ = control_block->get_snapshot_levels();
+  root_pointer->volatile_pointer_ = new_root_pointer;
+  if (control_block->resize_bin_bits_ <= control_block->meta_.bin_bits_) {
+    control_block->resize_bin_bits_ = 0;  // otherwise someone requested even larger bins
+  }
+  ASSERT_ND(!control_block->is_resizing_in_snapshot());
+
+  CHECK_ERROR(fileset.uninitialize());
+  return kRetOk;
+}
+
+ErrorStack HashComposer::rebuild_volatiles_recurse(
+  const Composer::DropVolatilesArguments& args,
+  cache::SnapshotFileSet* fileset,
+  HashIntermediatePage* old_page,
+  HashIntermediatePage* new_root) {
+  const bool keep_all = storage_.get_hash_metadata()->keeps_all_volatile_pages();
+  const Epoch valid_until = args.snapshot_.valid_until_epoch_;
+  for (uint16_t i = 0; i < kHashIntermediatePageFanout; ++i) {
+    DualPagePointer* child_pointer = old_page->get_pointer_address(i);
+    if (child_pointer->volatile_pointer_.is_null()) {
+      continue;
+    }
+    if (old_page->get_level() > 0) {
+      HashIntermediatePage* child = resolve_intermediate(child_pointer->volatile_pointer_);
+      CHECK_ERROR(rebuild_volatiles_recurse(args, fileset, child, new_root));
+      args.drop(engine_, child_pointer->volatile_pointer_);
+      child_pointer->volatile_pointer_.clear();
+    } else {
+      // Bins without new records are entirely in the new snapshot. Otherwise move them.
+      if (keep_all
+        || !can_drop_volatile_bin(child_pointer->volatile_pointer_, valid_until)) {
+        CHECK_ERROR(split_volatile_bin(
+          fileset,
+          resolve_data(child_pointer->volatile_pointer_),
+          new_root));
+      }
+      drop_volatile_entire_bin(args, child_pointer);
+    }
+  }
+  return kRetOk;
+}
+
+ErrorStack HashComposer::split_volatile_bin(
+  cache::SnapshotFileSet* fileset,
+  const HashDataPage* old_head,
+  HashIntermediatePage* new_root) {
+  const uint8_t new_bin_shifts = 64U - storage_.get_control_block()->snapshot_bin_bits_;
+  // new pages are on the same node as the old pages. the same threads will probably use them.
+  const thread::ThreadGroupId node
+    = construct_volatile_page_pointer(old_head->header().page_id_).components.numa_node;
+  for (const HashDataPage* page = old_head;
+        page;
+        page = resolve_data(page->next_page().volatile_pointer_)) {
+    for (DataPageSlotIndex i = 0; i < page->get_record_count(); ++i) {
+      const HashDataPage::Slot& slot = page->get_slot(i);
+      if (slot.tid_.is_moved()) {
+        continue;  // the record is somewhere later in this bin.
+      }
+      HashDataPage* tail;
+      CHECK_ERROR(locate_rebuilt_bin_tail(
+        fileset,
+        new_root,
+        slot.hash_ >> new_bin_shifts,
+        slot.physical_record_length_ + sizeof(HashDataPage::Slot),
+        node,
+        &tail));
+      tail->copy_record_from(*page, i);
+    }
+  }
+  return kRetOk;
+}
+
+ErrorStack HashComposer::locate_rebuilt_bin_tail(
+  cache::SnapshotFileSet* fileset,
+  HashIntermediatePage* new_root,
+  HashBin bin,
+  uint16_t required_space,
+  thread::ThreadGroupId node,
+  HashDataPage** tail) {
+  memory::EngineMemory* memory = engine_->get_memory_manager();
+  const uint8_t bin_bits = storage_.get_control_block()->snapshot_bin_bits_;
+
+  // go down to the level-0 page, installing volatile intermediate pages if not exists.
+  HashIntermediatePage* page = new_root;
+  while (page->get_level() > 0) {
+    const HashBinRange& range = page->get_bin_range();
+    ASSERT_ND(range.contains(bin));
+    uint16_t index = (bin - range.begin_) / kHashMaxBins[page->get_level()];
+    DualPagePointer* pointer = page->get_pointer_address(index);
+    if (pointer->volatile_pointer_.is_null()) {
+      HashIntermediatePage* child;
+      if (pointer->snapshot_pointer_ != 0) {
+        CHECK_ERROR(memory->load_one_volatile_page(
+          fileset,
+          pointer->snapshot_pointer_,
+          &pointer->volatile_pointer_,
+          reinterpret_cast<Page**>(&child)));
+      } else {
+        CHECK_ERROR(memory->grab_one_volatile_page(
+          node,
+          &pointer->volatile_pointer_,
+          reinterpret_cast<Page**>(&child)));
+        child->initialize_volatile_page(
+          storage_id_,
+          pointer->volatile_pointer_,
+          page,
+          page->get_level() - 1U,
+          range.begin_ + index * kHashMaxBins[page->get_level()]);
+      }
+    }
+    page = resolve_intermediate(pointer->volatile_pointer_);
+    ASSERT_ND(page->get_bin_range().contains(bin));
+  }
+
+  // then the tail of the bin, appending a new data page if needed.
+  DualPagePointer* pointer = page->get_pointer_address(bin - page->get_bin_range().begin_);
+  const Page* parent = reinterpret_cast<const Page*>(page);
+  HashDataPage* prev = nullptr;
+  while (!pointer->volatile_pointer_.is_null()) {
+    HashDataPage* cur = resolve_data(pointer->volatile_pointer_);
+    if (cur->next_page().volatile_pointer_.is_null()
+      && cur->available_space() >= required_space) {
+      *tail = cur;
+      return kRetOk;
+    }
+    pointer = cur->next_page_address();
+    parent = reinterpret_cast<const Page*>(cur);
+    prev = cur;
+  }
+
+  HashDataPage* new_page;
+  CHECK_ERROR(memory->grab_one_volatile_page(
+    node,
+    &pointer->volatile_pointer_,
+    reinterpret_cast<Page**>(&new_page)));
+  new_page->initialize_volatile_page(
+    storage_id_,
+    pointer->volatile_pointer_,
+    parent,
+    bin,
+    bin_bits,
+    64U - bin_bits);
+  if (prev) {
+    // same as HashStoragePimpl::append_next_volatile_page(). readers check this bit.
+    prev->header().page_version_.set_has_next_page();
+  }
+  ASSERT_ND(new_page->available_space() >= required_space);
+  *tail = new_page;
+  return kRetOk;
+}
+
+inline bool HashComposer::is_to_keep_volatile(
+  const Composer::DropVolatilesArguments& args,
+  uint16_t level) {
   /*
   uint16_t threshold = storage_.get_hash_metadata()->snapshot_drop_volatile_pages_threshold_;
   uint16_t hash_levels = storage_.get_levels();
@@ -1341,6 +1738,12 @@ inline bool HashComposer::is_to_keep_volatile(uint16_t level) {
   // when threshold=2, upto hash_levels-2..
   return threshold + level >= hash_levels;
   */
+  // the volatile page evictor keeps only the root level, then nothing.
+  if (args.evict_pressure_ >= 2U) {
+    return false;
+  } else if (args.evict_pressure_ == 1U) {
+    return level + 1U >= storage_.get_levels();
+  }
   return level + 2U > storage_.get_levels();  // TASK(Hideaki) should be a config
 }
 
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/storage/hash/hash_cursor.hpp"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+
+#include "foedus/assorted/assorted_func.hpp"
+#include "foedus/assorted/atomic_fences.hpp"
+#include "foedus/assorted/cacheline.hpp"
+#include "foedus/storage/page.hpp"
+#include "foedus/storage/hash/hash_page_impl.hpp"
+#include "foedus/storage/hash/hash_storage_pimpl.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/xct/xct.hpp"
+
+namespace foedus {
+namespace storage {
+namespace hash {
+
+HashCursor::HashCursor(HashStorage storage, thread::Thread* context)
+  : storage_(storage),
+    context_(context),
+    current_xct_(&context->get_current_xct()) {
+  ASSERT_ND(storage_.exists());
+  begin_bin_ = 0;
+  end_bin_ = 0;
+  cur_bin_ = 0;
+  std::memset(path_, 0, sizeof(path_));
+  path_lowest_level_ = 0;
+  levels_ = 0;
+  cur_page_ = nullptr;
+  cur_page_snapshot_ = false;
+  cur_slot_ = 0;
+  cur_page_record_count_ = 0;
+  cur_record_ = nullptr;
+  cur_hash_ = 0;
+  cur_key_length_ = 0;
+  cur_payload_length_ = 0;
+}
+
+HashBinRange HashCursor::get_partition_range(
+  HashBin bin_count,
+  uint32_t partition,
+  uint32_t partition_count) {
+  ASSERT_ND(partition < partition_count);
+  // bin_count might be 2^48, so bin_count * partition might overflow. divide first.
+  const HashBin per_partition = bin_count / partition_count;
+  const HashBin remainder = bin_count % partition_count;
+  HashBin begin = per_partition * partition + std::min<HashBin>(partition, remainder);
+  HashBin end = begin + per_partition + (partition < remainder ? 1U : 0U);
+  ASSERT_ND(end <= bin_count);
+  return HashBinRange(begin, end);
+}
+
+ErrorCode HashCursor::open_partition(uint32_t partition, uint32_t partition_count) {
+  HashBinRange range = get_partition_range(storage_.get_bin_count(), partition, partition_count);
+  return open(range.begin_, range.end_);
+}
+
+ErrorCode HashCursor::open(HashBin begin_bin, HashBin end_bin) {
+  levels_ = storage_.get_levels();
+  begin_bin_ = begin_bin;
+  end_bin_ = std::min<HashBin>(end_bin, storage_.get_bin_count());
+  cur_bin_ = begin_bin_;
+  cur_page_ = nullptr;
+  cur_record_ = nullptr;
+
+  HashStoragePimpl pimpl(&storage_);
+  HashIntermediatePage* root;
+  CHECK_ERROR_CODE(pimpl.get_root_page(context_, false, &root));
+  ASSERT_ND(root->get_level() + 1U == levels_);
+  std::memset(path_, 0, sizeof(path_));
+  path_[levels_ - 1U] = root;
+  path_lowest_level_ = levels_ - 1U;
+  return locate_record();
+}
+
+ErrorCode HashCursor::next() {
+  if (!is_valid_record()) {
+    return kErrorCodeOk;
+  }
+  cur_record_ = nullptr;
+  return locate_record();
+}
+
+ErrorCode HashCursor::locate_bin() {
+  ASSERT_ND(cur_page_ == nullptr);
+  HashStoragePimpl pimpl(&storage_);
+  while (cur_bin_ < end_bin_) {
+    // go up until the page contains cur_bin_. the root contains all bins.
+    while (!path_[path_lowest_level_]->get_bin_range().contains(cur_bin_)) {
+      ASSERT_ND(path_lowest_level_ + 1U < levels_);
+      ++path_lowest_level_;
+    }
+
+    // then go down
+    HashIntermediatePage* parent = path_[path_lowest_level_];
+    const uint8_t level = parent->get_level();
+    const HashBinRange& range = parent->get_bin_range();
+    const uint16_t index = (cur_bin_ - range.begin_) / kHashMaxBins[level];
+    ASSERT_ND(index < kHashIntermediatePageFanout);
+    Page* child;
+    CHECK_ERROR_CODE(pimpl.follow_page(context_, false, parent, index, &child));
+    if (child == nullptr) {
+      // The entire sub-tree (or bin) is empty. We skip all bins under it.
+      // Like locate_bin() in pimpl, protect the result with a pointer set.
+      if (!parent->header().snapshot_) {
+        VolatilePagePointer volatile_null;
+        volatile_null.clear();
+        CHECK_ERROR_CODE(current_xct_->add_to_pointer_set(
+          &parent->get_pointer(index).volatile_pointer_,
+          volatile_null));
+      }
+      cur_bin_ = range.begin_ + (index + 1ULL) * kHashMaxBins[level];
+      continue;
+    }
+
+    if (level == 0) {
+      ASSERT_ND(reinterpret_cast<HashDataPage*>(child)->get_bin() == cur_bin_);
+      prefetch_following_bins(parent, index);
+      enter_page(reinterpret_cast<HashDataPage*>(child));
+      return kErrorCodeOk;
+    }
+    path_[level - 1U] = reinterpret_cast<HashIntermediatePage*>(child);
+    path_lowest_level_ = level - 1U;
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode HashCursor::locate_record() {
+  ASSERT_ND(cur_record_ == nullptr);
+  while (true) {
+    if (cur_page_ == nullptr) {
+      CHECK_ERROR_CODE(locate_bin());
+      if (cur_page_ == nullptr) {
+        ASSERT_ND(cur_bin_ >= end_bin_);
+        return kErrorCodeOk;  // reached the end
+      }
+    }
+
+    if (cur_slot_ >= cur_page_record_count_) {
+      CHECK_ERROR_CODE(proceed_page());
+      continue;
+    }
+
+    const HashDataPage::Slot* slot = cur_page_->get_slot_address(cur_slot_);
+    ++cur_slot_;
+    xct::XctId observed = slot->tid_.xct_id_;
+    if (!cur_page_snapshot_) {
+      assorted::memory_fence_consume();  // finalize observed BEFORE reading the record.
+      if (observed.is_moved()) {
+        continue;  // we will see it later in this bin.
+      }
+      // we take read-set even for deleted records. otherwise we miss concurrent re-inserts.
+      CHECK_ERROR_CODE(current_xct_->add_to_read_set(
+        storage_.get_id(),
+        observed,
+        const_cast<xct::LockableXctId*>(&slot->tid_)));
+    }
+    if (observed.is_deleted()) {
+      continue;
+    }
+
+    ASSERT_ND((slot->hash_ >> storage_.get_bin_shifts()) == cur_bin_);
+    cur_record_ = cur_page_->record_from_offset(slot->offset_);
+    cur_hash_ = slot->hash_;
+    cur_key_length_ = slot->key_length_;
+    cur_payload_length_ = slot->payload_length_;
+    return kErrorCodeOk;
+  }
+}
+
+ErrorCode HashCursor::proceed_page() {
+  ASSERT_ND(cur_page_);
+  ASSERT_ND(cur_slot_ >= cur_page_record_count_);
+  if (cur_page_snapshot_) {
+    // snapshot world. no race.
+    SnapshotPagePointer next = cur_page_->next_page().snapshot_pointer_;
+    if (next) {
+      Page* next_page;
+      CHECK_ERROR_CODE(context_->find_or_read_a_snapshot_page(next, &next_page));
+      enter_page(reinterpret_cast<HashDataPage*>(next_page));
+      return kErrorCodeOk;
+    }
+  } else {
+    // same protocol as HashStoragePimpl::locate_record(). we must not move on to the next page
+    // or the next bin without confirming that we have read all records in this page.
+    PageVersionStatus page_status = cur_page_->header().page_version_.status_;
+    assorted::memory_fence_consume();
+    uint16_t record_count_again = cur_page_->get_record_count();
+    if (UNLIKELY(record_count_again != cur_page_record_count_)) {
+      DVLOG(0) << "Concurrent insertion during the scan. Reads them too";
+      cur_page_record_count_ = record_count_again;
+      return kErrorCodeOk;
+    }
+    VolatilePagePointer next = cur_page_->next_page().volatile_pointer_;
+    if (UNLIKELY(!page_status.has_next_page() && !next.is_null())) {
+      DVLOG(0) << "Concurrent next-page installation during the scan. Retries";
+      assorted::memory_fence_consume();
+      return kErrorCodeOk;  // locate_record() calls us again
+    }
+
+    if (!next.is_null()) {
+      enter_page(context_->resolve_cast<HashDataPage>(next));
+      return kErrorCodeOk;
+    }
+
+    // this is the tail page. protect the bin from concurrent inserts.
+    CHECK_ERROR_CODE(current_xct_->add_to_page_version_set(
+      &cur_page_->header().page_version_,
+      page_status));
+  }
+
+  // done with this bin.
+  cur_page_ = nullptr;
+  ++cur_bin_;
+  return kErrorCodeOk;
+}
+
+void HashCursor::enter_page(HashDataPage* page) {
+  ASSERT_ND(page->header().get_page_type() == kHashDataPageType);
+  cur_page_ = page;
+  cur_page_snapshot_ = page->header().snapshot_;
+  cur_slot_ = 0;
+  cur_page_record_count_ = page->get_record_count();
+  assorted::memory_fence_consume();
+  if (cur_page_record_count_ > 0) {
+    // slots grow backward from the end of page. prefetch all of them
+    const HashDataPage::Slot* last_slot = page->get_slot_address(cur_page_record_count_ - 1U);
+    const int cachelines = assorted::int_div_ceil(
+      cur_page_record_count_ * sizeof(HashDataPage::Slot),
+      assorted::kCachelineSize);
+    assorted::prefetch_cachelines(last_slot, cachelines);
+  }
+}
+
+void HashCursor::prefetch_following_bins(const HashIntermediatePage* page, uint16_t index) const {
+  ASSERT_ND(page->get_level() == 0);
+  if (page->header().snapshot_) {
+    return;  // snapshot pages are not in memory. nothing to prefetch
+  }
+  const HashBin begin = page->get_bin_range().begin_;
+  for (uint16_t i = index + 1U;
+        i <= index + kPrefetchBins && i < kHashIntermediatePageFanout && begin + i < end_bin_;
+        ++i) {
+    VolatilePagePointer pointer = page->get_pointer(i).volatile_pointer_;
+    if (!pointer.is_null()) {
+      const char* head = reinterpret_cast<const char*>(context_->resolve(pointer));
+      assorted::prefetch_cacheline(head);  // header, which has the record count
+      assorted::prefetch_cacheline(head + kPageSize - assorted::kCachelineSize);  // first slots
+    }
+  }
+}
+
+std::ostream& operator<<(std::ostream& o, const HashCursor& v) {
+  o << "<HashCursor>" << std::endl;
+  o << "  <storage_id_>" << v.storage_.get_id() << "</storage_id_>" << std::endl;
+  o << "  <begin_bin_>" << v.begin_bin_ << "</begin_bin_>" << std::endl;
+  o << "  <end_bin_>" << v.end_bin_ << "</end_bin_>" << std::endl;
+  o << "  <cur_bin_>" << v.cur_bin_ << "</cur_bin_>" << std::endl;
+  o << "  <cur_slot_>" << v.cur_slot_ << "</cur_slot_>" << std::endl;
+  o << "  <cur_page_snapshot_>" << v.cur_page_snapshot_ << "</cur_page_snapshot_>" << std::endl;
+  o << "  <is_valid_record>" << v.is_valid_record() << "</is_valid_record>" << std::endl;
+  o << "</HashCursor>";
+  return o;
+}
+
+}  // namespace hash
+}  // namespace storage
+}  // namespace foedus
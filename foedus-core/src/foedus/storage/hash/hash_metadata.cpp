@@ -39,12 +39,23 @@ std::ostream& operator<<(std::ostream& o, const HashMetadata& v) {
 ErrorStack HashMetadataSerializer::load(tinyxml2::XMLElement* element) {
   CHECK_ERROR(load_base(element));
   CHECK_ERROR(get_element(element, "bin_bits_", &data_casted_->bin_bits_))
+  CHECK_ERROR(get_element(
+    element,
+    "resize_chain_length_threshold_",
+    &data_casted_->resize_chain_length_threshold_,
+    true,
+    static_cast<uint16_t>(0)))
   return kRetOk;
 }
 
 ErrorStack HashMetadataSerializer::save(tinyxml2::XMLElement* element) const {
   CHECK_ERROR(save_base(element));
   CHECK_ERROR(add_element(element, "bin_bits_", "", data_casted_->bin_bits_));
+  CHECK_ERROR(add_element(
+    element,
+    "resize_chain_length_threshold_",
+    "Doubles the bins when bins have more data pages than this on average, in percent",
+    data_casted_->resize_chain_length_threshold_));
   return kRetOk;
 }
 
@@ -23,6 +23,7 @@
 #include "foedus/assorted/assorted_func.hpp"
 #include "foedus/storage/hash/hash_hashinate.hpp"
 #include "foedus/storage/hash/hash_id.hpp"
+#include "foedus/storage/hash/hash_tag_search.hpp"
 
 namespace foedus {
 namespace storage {
@@ -106,6 +107,7 @@ void HashDataPage::assert_entries_impl() const {
     }
     HashValue hash = hashinate(record_from_offset(slot->offset_), slot->key_length_);
     ASSERT_ND(slot->hash_ == hash);
+    ASSERT_ND(tags_[i] == extract_hash_tag(hash));
     HashBin bin = hash >> bin_shifts;
     ASSERT_ND(bin_ == bin);
 
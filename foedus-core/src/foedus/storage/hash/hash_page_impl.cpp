@@ -19,6 +19,7 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <thread>
@@ -122,29 +123,38 @@ DataPageSlotIndex HashDataPage::search_key(
     return kSlotNotFound;
   }
 
-  // then most likely this page contains it. let's check one by one.
-  for (uint16_t i = 0; i < record_count; ++i) {
-    const Slot& s = get_slot(i);
-    if (LIKELY(s.hash_ != hash) || s.key_length_ != key_length) {
-      continue;
-    }
-    xct::XctId xid = s.tid_.xct_id_;
-    if (xid.is_moved()) {
-      // not so rare. this happens.
-      DVLOG(1) << "Hash matched, but the record was moved";
-      continue;
-    }
+  // then most likely this page contains it. compare tags to find candidate slots,
+  // and check only them one by one.
+  ASSERT_ND(record_count <= kHashDataPageTagCount);
+  const uint8_t tag = extract_hash_tag(hash);
+  for (uint16_t base = 0; base < record_count; base += kHashTagSearchBatch) {
+    const uint16_t count = std::min<uint16_t>(record_count - base, kHashTagSearchBatch);
+    uint32_t candidates = match_tags(tags_ + base, count, tag);
+    while (candidates != 0) {
+      const uint16_t i = base + __builtin_ctz(candidates);
+      candidates &= candidates - 1U;
+      const Slot& s = get_slot(i);
+      if (LIKELY(s.hash_ != hash) || s.key_length_ != key_length) {
+        continue;
+      }
+      xct::XctId xid = s.tid_.xct_id_;
+      if (xid.is_moved()) {
+        // not so rare. this happens.
+        DVLOG(1) << "Hash matched, but the record was moved";
+        continue;
+      }
 
-    const char* data = record_from_offset(s.offset_);
-    if (s.key_length_ == key_length && std::memcmp(data, key, key_length) == 0) {
-      *observed = xid;
-      return i;
+      const char* data = record_from_offset(s.offset_);
+      if (s.key_length_ == key_length && std::memcmp(data, key, key_length) == 0) {
+        *observed = xid;
+        return i;
+      }
+      // hash matched, but key didn't match? wow, that's rare
+      DLOG(INFO) << "Hash matched, but key didn't match. interesting. hash="
+        << assorted::Hex(hash, 16) << ", key="
+        << assorted::HexString(std::string(reinterpret_cast<const char*>(key), key_length))
+        << ", key_slot="  << assorted::HexString(std::string(data, s.key_length_));
     }
-    // hash matched, but key didn't match? wow, that's rare
-    DLOG(INFO) << "Hash matched, but key didn't match. interesting. hash="
-      << assorted::Hex(hash, 16) << ", key="
-      << assorted::HexString(std::string(reinterpret_cast<const char*>(key), key_length))
-      << ", key_slot="  << assorted::HexString(std::string(data, s.key_length_));
   }
 
   // should be 1~2%
@@ -178,6 +188,8 @@ DataPageSlotIndex HashDataPage::reserve_record(
     0);
   initial_id.set_deleted();
   slot.tid_.xct_id_ = initial_id;
+  ASSERT_ND(index < kHashDataPageTagCount);
+  tags_[index] = extract_hash_tag(hash);
 
   // we install the fingerprint to bloom filter BEFORE we increment key count.
   // it's okay for concurrent reads to see false positives, but false negatives are wrong!
@@ -191,6 +203,32 @@ DataPageSlotIndex HashDataPage::reserve_record(
   return index;
 }
 
+void HashDataPage::copy_record_from(const HashDataPage& from, DataPageSlotIndex index) {
+  ASSERT_ND(!header_.snapshot_);
+  const Slot& from_slot = from.get_slot(index);
+  ASSERT_ND(!from_slot.tid_.is_moved());
+  ASSERT_ND(!from_slot.tid_.is_keylocked());
+  ASSERT_ND((from_slot.hash_ >> get_bin_shifts()) == bin_);
+  ASSERT_ND(available_space() >= from_slot.physical_record_length_ + sizeof(Slot));
+  DataPageSlotIndex new_index = get_record_count();
+  Slot& slot = get_slot(new_index);
+  slot.tid_.reset();
+  slot.tid_.xct_id_ = from_slot.tid_.xct_id_;
+  slot.offset_ = next_offset();
+  slot.physical_record_length_ = from_slot.physical_record_length_;
+  slot.key_length_ = from_slot.key_length_;
+  slot.payload_length_ = from_slot.payload_length_;
+  slot.hash_ = from_slot.hash_;
+  ASSERT_ND(new_index < kHashDataPageTagCount);
+  tags_[new_index] = from.get_tag(index);
+  std::memcpy(
+    record_from_offset(slot.offset_),
+    from.record_from_offset(from_slot.offset_),
+    from_slot.physical_record_length_);
+
+  bloom_filter_.add(DataPageBloomFilter::extract_fingerprint(slot.hash_));
+  header_.increment_key_count();
+}
 
 void hash_intermediate_volatile_page_init(const VolatilePageInitArguments& args) {
   ASSERT_ND(args.parent_);  // because this is always called for non-root pages.
@@ -75,16 +75,33 @@ ErrorStack HashPartitioner::design_partition(
 
   soc::SharedMutexScope mutex_scope(&metadata_->mutex_);
   ASSERT_ND(!metadata_->valid_);
-  HashBin total_bin_count = storage.get_bin_count();
-  uint16_t node_count = engine_->get_soc_count();
+
+  // Latch the layout of this snapshot. If someone has requested a resize, this snapshot
+  // composes the storage in the new layout. All mappers/reducers see the latched value.
+  uint8_t bin_bits = storage.get_bin_bits();
+  if (control_block->resize_bin_bits_ > bin_bits) {
+    bin_bits = control_block->resize_bin_bits_;
+    LOG(INFO) << "Hash-" << id_ << " will be resized from bin_bits="
+      << static_cast<int>(storage.get_bin_bits()) << " to " << static_cast<int>(bin_bits)
+      << " in this snapshot";
+  }
+  control_block->snapshot_bin_bits_ = bin_bits;
+  control_block->composed_bins_ = 0;
+  control_block->composed_pages_ = 0;
+
+  // The resizing snapshot reads and writes every bin. So far we let node-0 do everything
+  // rather than partitioning the new bins, which have no volatile pages to check the owner of.
+  const bool resizing = control_block->is_resizing_in_snapshot();
+  HashBin total_bin_count = 1ULL << bin_bits;
+  uint16_t node_count = resizing ? 1U : engine_->get_soc_count();
   uint64_t bytes = HashPartitionerData::object_size(node_count, total_bin_count);
   WRAP_ERROR_CODE(metadata_->allocate_data(engine_, &mutex_scope, bytes));
   data_ = reinterpret_cast<HashPartitionerData*>(metadata_->locate_data(engine_));
 
-  data_->levels_ = storage.get_levels();
-  ASSERT_ND(storage.get_levels() >= 1U);
-  data_->bin_bits_ = storage.get_bin_bits();
-  data_->bin_shifts_ = storage.get_bin_shifts();
+  data_->levels_ = control_block->get_snapshot_levels();
+  ASSERT_ND(data_->levels_ >= 1U);
+  data_->bin_bits_ = bin_bits;
+  data_->bin_shifts_ = 64U - bin_bits;
   data_->partitionable_ = node_count > 1U;
   data_->total_bin_count_ = total_bin_count;
 
@@ -187,8 +204,7 @@ void HashPartitioner::partition_batch(const Partitioner::PartitionBatchArguments
     return;
   }
 
-  HashStorage storage(engine_, id_);
-  uint8_t bin_shifts = storage.get_bin_shifts();
+  const uint8_t bin_shifts = data_->bin_shifts_;
   for (uint32_t i = 0; i < args.logs_count_; ++i) {
     const HashCommonLogType *log = reinterpret_cast<const HashCommonLogType*>(
       args.log_buffer_.resolve(args.log_positions_[i]));
@@ -196,14 +212,15 @@ void HashPartitioner::partition_batch(const Partitioner::PartitionBatchArguments
     ASSERT_ND(log->header_.storage_id_ == id_);
     HashValue hash = log->hash_;
     HashBin bin = hash >> bin_shifts;
-    ASSERT_ND(bin < storage.get_bin_count());
+    ASSERT_ND(bin < data_->total_bin_count_);
     args.results_[i] = data_->bin_owners_[bin];
   }
 }
 
 /**
   * Used in sort_batch().
-  * \li 0-5 bytes: HashBin, the most significant.
+  * \li 0-5 bytes: HashBin in kHashMaxBinBits, the most significant. See
+  * HashCommonLogType::get_sort_bin().
   * \li 6-7 bytes: compressed epoch (difference from base_epoch)
   * \li 8-11 bytes: in-epoch-ordinal
   * \li 12-15 bytes: BufferPosition (doesn't have to be sorted together, but for simplicity)
@@ -234,7 +251,6 @@ struct SortEntry {
 /** subroutine of sort_batch */
 // __attribute__ ((noinline))  // was useful to forcibly show it on cpu profile. nothing more.
 void prepare_sort_entries(
-  uint8_t bin_shifts,
   const Partitioner::SortBatchArguments& args,
   SortEntry* entries) {
   // CPU profile of partition_hash_perf: ??%.
@@ -246,10 +262,9 @@ void prepare_sort_entries(
     Epoch epoch = log_entry->header_.xct_id_.get_epoch();
     ASSERT_ND(epoch.subtract(base_epoch) < (1U << 16));
     uint16_t compressed_epoch = epoch.subtract(base_epoch);
-    // this is expensive.. should keep hash in log entries
-    HashValue hash = log_entry->hash_;
+    // not the bin in current bin_bits so that the result is consistent with MergeSort
     entries[i].set(
-      hash >> bin_shifts,
+      log_entry->get_sort_bin(),
       compressed_epoch,
       log_entry->header_.xct_id_.get_ordinal(),
       args.log_positions_[i]);
@@ -341,7 +356,7 @@ void HashPartitioner::sort_batch(const Partitioner::SortBatchArguments& args) co
 
   ASSERT_ND(sizeof(SortEntry) == 16U);
   SortEntry* entries = reinterpret_cast<SortEntry*>(args.work_memory_->get_block());
-  prepare_sort_entries(data_->bin_shifts_, args, entries);
+  prepare_sort_entries(args, entries);
 
   debugging::StopWatch stop_watch;
   // Gave up non-gcc support because of aarch64 support. yes, we can also assume __uint128_t.
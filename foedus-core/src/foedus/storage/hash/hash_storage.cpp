@@ -74,6 +74,10 @@ ErrorStack  HashStorage::drop() {
   HashStoragePimpl pimpl(this);
   return pimpl.drop();
 }
+ErrorStack  HashStorage::request_resize(uint8_t new_bin_bits) {
+  HashStoragePimpl pimpl(this);
+  return pimpl.request_resize(new_bin_bits);
+}
 
 const HashMetadata* HashStorage::get_hash_metadata() const  { return &control_block_->meta_; }
 
@@ -238,6 +242,24 @@ ErrorCode HashStorage::increment_record(
     payload_offset);
 }
 
+template <typename PAYLOAD>
+ErrorCode HashStorage::increment_record_oneshot(
+  thread::Thread* context,
+  const void* key,
+  uint16_t key_length,
+  const HashCombo& combo,
+  PAYLOAD value,
+  uint16_t payload_offset) {
+  HashStoragePimpl pimpl(this);
+  return pimpl.increment_record_oneshot(
+    context,
+    key,
+    key_length,
+    combo,
+    value,
+    payload_offset);
+}
+
 std::ostream& operator<<(std::ostream& o, const HashStorage& v) {
   o << "<HashStorage>"
     << "<id>" << v.get_id() << "</id>"
@@ -301,6 +323,15 @@ INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_3);
     x* value, \
     uint16_t payload_offset)
 INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_5);
+
+#define EXPIN_6(x) template ErrorCode HashStorage::increment_record_oneshot< x > \
+  (thread::Thread* context, \
+    const void* key, \
+    uint16_t key_length, \
+    const HashCombo& combo, \
+    x value, \
+    uint16_t payload_offset)
+INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_6);
 // @endcond
 
 
@@ -77,26 +77,15 @@ ErrorStack HashStoragePimpl::create(const HashMetadata& metadata) {
     return ERROR_STACK(kErrorCodeStrAlreadyExists);
   }
 
-  // hash-specific check.
-  // Due to the current design of hash_partitioner, we spend hashbins bytes
-  // out of the partitioner memory.
-  uint64_t required_partitioner_bytes = metadata.get_bin_count() + 4096ULL;
-  uint64_t partitioner_bytes
-    = engine_->get_options().storage_.partitioner_data_memory_mb_ * (1ULL << 20);
-  // we don't bother checking other storages' consumption. the config might later change anyways.
-  // Instead, leave a bit of margin (25%) for others.
-  if (partitioner_bytes < required_partitioner_bytes * 1.25) {
-    std::stringstream str;
-    str << metadata << ".\n"
-      << "To accomodate this number of hash bins, partitioner_data_memory_mb_ must be"
-      << " at least " << (required_partitioner_bytes * 1.25 / (1ULL << 20));
-    return ERROR_STACK_MSG(kErrorCodeStrHashBinsTooMany, str.str().c_str());
-  }
+  CHECK_ERROR(check_partitioner_memory(metadata));
 
   control_block_->meta_ = metadata;
   LOG(INFO) << "Newly creating an hash-storage " << get_name();
   control_block_->bin_count_ = 1ULL << get_bin_bits();
   control_block_->levels_ = bins_to_level(control_block_->bin_count_);
+  control_block_->resize_bin_bits_ = 0;
+  control_block_->snapshot_bin_bits_ = get_bin_bits();
+  control_block_->resized_snapshot_id_ = snapshot::kNullSnapshotId;
   ASSERT_ND(control_block_->levels_ >= 1U);
   ASSERT_ND(control_block_->bin_count_ <= fanout_power(control_block_->levels_));
   ASSERT_ND(control_block_->bin_count_ > fanout_power(control_block_->levels_ - 1U));
@@ -132,11 +121,65 @@ ErrorStack HashStoragePimpl::create(const HashMetadata& metadata) {
   return kRetOk;
 }
 
+ErrorStack HashStoragePimpl::check_partitioner_memory(const HashMetadata& metadata) const {
+  // hash-specific check.
+  // Due to the current design of hash_partitioner, we spend hashbins bytes
+  // out of the partitioner memory.
+  uint64_t required_partitioner_bytes = metadata.get_bin_count() + 4096ULL;
+  uint64_t partitioner_bytes
+    = engine_->get_options().storage_.partitioner_data_memory_mb_ * (1ULL << 20);
+  // we don't bother checking other storages' consumption. the config might later change anyways.
+  // Instead, leave a bit of margin (25%) for others.
+  if (partitioner_bytes < required_partitioner_bytes * 1.25) {
+    std::stringstream str;
+    str << metadata << ".\n"
+      << "To accomodate this number of hash bins, partitioner_data_memory_mb_ must be"
+      << " at least " << (required_partitioner_bytes * 1.25 / (1ULL << 20));
+    return ERROR_STACK_MSG(kErrorCodeStrHashBinsTooMany, str.str().c_str());
+  }
+  return kRetOk;
+}
+
+ErrorStack HashStoragePimpl::request_resize(uint8_t new_bin_bits) {
+  if (!exists()) {
+    return ERROR_STACK(kErrorCodeStrAlreadyDropped);
+  }
+  if (new_bin_bits <= get_bin_bits() || new_bin_bits > kHashMaxBinBits) {
+    std::stringstream str;
+    str << "Hash storage " << get_name() << " can't resize from bin_bits="
+      << static_cast<int>(get_bin_bits()) << " to " << static_cast<int>(new_bin_bits)
+      << ". It can only grow up to " << static_cast<int>(kHashMaxBinBits);
+    return ERROR_STACK_MSG(kErrorCodeInvalidParameter, str.str().c_str());
+  }
+  HashMetadata new_meta = get_meta();
+  new_meta.bin_bits_ = new_bin_bits;
+  CHECK_ERROR(check_partitioner_memory(new_meta));
+
+  // just a request. the next snapshot does the actual work. see HashComposer.
+  // if there are concurrent requests, the larger one wins.
+  uint8_t cur = control_block_->resize_bin_bits_;
+  while (cur < new_bin_bits) {
+    if (assorted::raw_atomic_compare_exchange_strong<uint8_t>(
+      &control_block_->resize_bin_bits_,
+      &cur,
+      new_bin_bits)) {
+      LOG(INFO) << "Hash storage " << get_name() << " will resize from bin_bits="
+        << static_cast<int>(get_bin_bits()) << " to " << static_cast<int>(new_bin_bits)
+        << " in the next snapshot";
+      break;
+    }
+  }
+  return kRetOk;
+}
+
 ErrorStack HashStoragePimpl::load(const StorageControlBlock& snapshot_block) {
   control_block_->meta_ = static_cast<const HashMetadata&>(snapshot_block.meta_);
   const HashMetadata& meta = control_block_->meta_;
   control_block_->bin_count_ = 1ULL << get_bin_bits();
   control_block_->levels_ = bins_to_level(control_block_->bin_count_);
+  control_block_->resize_bin_bits_ = 0;
+  control_block_->snapshot_bin_bits_ = get_bin_bits();
+  control_block_->resized_snapshot_id_ = snapshot::kNullSnapshotId;
   control_block_->root_page_pointer_.snapshot_pointer_ = meta.root_snapshot_page_id_;
   control_block_->root_page_pointer_.volatile_pointer_.word = 0;
 
@@ -192,6 +235,9 @@ ErrorCode HashStoragePimpl::get_record(
 
   xct::Xct& cur_xct = context->get_current_xct();
   CHECK_ERROR_CODE(cur_xct.add_to_read_set(get_id(), location.observed_, &location.slot_->tid_));
+  if (location.observed_.is_deleted()) {
+    return kErrorCodeStrKeyNotFound;  // protected by the read set
+  }
   // here, we do NOT have to do another optimistic-read protocol because we already took
   // the owner_id into read-set. If this read is corrupted, we will be aware of it at commit time.
   uint16_t payload_length = location.slot_->payload_length_;
@@ -237,6 +283,9 @@ ErrorCode HashStoragePimpl::get_record_part(
 
   xct::Xct& cur_xct = context->get_current_xct();
   CHECK_ERROR_CODE(cur_xct.add_to_read_set(get_id(), location.observed_, &location.slot_->tid_));
+  if (location.observed_.is_deleted()) {
+    return kErrorCodeStrKeyNotFound;  // protected by the read set
+  }
   uint16_t payload_length = location.slot_->payload_length_;
   if (payload_length < payload_offset + payload_count) {
     LOG(WARNING) << "short record " << combo;  // probably this is a rare error. so warn.
@@ -619,6 +668,116 @@ ErrorCode HashStoragePimpl::increment_record(
     log_entry);
 }
 
+template <typename PAYLOAD>
+ErrorCode HashStoragePimpl::increment_record_oneshot(
+  thread::Thread* context,
+  const void* key,
+  uint16_t key_length,
+  const HashCombo& combo,
+  PAYLOAD value,
+  uint16_t payload_offset) {
+  HashDataPage* bin_head;
+  CHECK_ERROR_CODE(locate_bin(context, true, combo, &bin_head));
+  ASSERT_ND(bin_head);
+  RecordLocation location;
+  CHECK_ERROR_CODE(locate_record(
+    context,
+    true,
+    false,
+    0,
+    key,
+    key_length,
+    combo,
+    bin_head,
+    &location));
+
+  xct::Xct& cur_xct = context->get_current_xct();
+  if (!location.slot_) {
+    return kErrorCodeStrKeyNotFound;  // protected by page version set, so we are done
+  } else if (location.observed_.is_deleted()) {
+    CHECK_ERROR_CODE(cur_xct.add_to_read_set(get_id(), location.observed_, &location.slot_->tid_));
+    return kErrorCodeStrKeyNotFound;  // protected by the read set
+  } else if (location.slot_->payload_length_ < payload_offset + sizeof(PAYLOAD)) {
+    LOG(WARNING) << "short record " << combo;  // probably this is a rare error. so warn.
+    CHECK_ERROR_CODE(cur_xct.add_to_read_set(get_id(), location.observed_, &location.slot_->tid_));
+    return kErrorCodeStrTooShortPayload;  // protected by the read set
+  }
+
+  uint16_t log_length
+    = HashIncrementLogType::calculate_log_length(key_length, sizeof(PAYLOAD));
+  HashIncrementLogType* log_entry = reinterpret_cast<HashIncrementLogType*>(
+    context->get_thread_log_buffer().reserve_new_log(log_length));
+  log_entry->populate<PAYLOAD>(
+    get_id(),
+    key,
+    key_length,
+    get_bin_bits(),
+    combo.hash_,
+    value,
+    payload_offset);
+
+  // No read set. precommit_xct_lock() confirms that the record still exists.
+  return cur_xct.add_to_write_set(
+    get_id(),
+    &location.slot_->tid_,
+    location.record_,
+    log_entry);
+}
+
+ErrorCode HashStoragePimpl::locate_record_for_replay(
+  thread::Thread* context,
+  const log::RecordLogType* log_entry,
+  xct::LockableXctId** owner_id,
+  char** payload_address) {
+  const HashCommonLogType* casted = reinterpret_cast<const HashCommonLogType*>(log_entry);
+  const log::LogCode type = log_entry->header_.get_type();
+  const bool create = type == log::kLogCodeHashInsert || type == log::kLogCodeHashUpdate;
+  const void* key = casted->get_key();
+  const uint16_t key_length = casted->key_length_;
+  const uint16_t payload_count = casted->payload_count_;
+  HashCombo combo(key, key_length, get_meta());
+
+  HashDataPage* bin_head;
+  CHECK_ERROR_CODE(locate_bin(context, true, combo, &bin_head));
+  ASSERT_ND(bin_head);
+  RecordLocation location;
+  CHECK_ERROR_CODE(locate_record(
+    context,
+    true,
+    create,
+    payload_count,
+    key,
+    key_length,
+    combo,
+    bin_head,
+    &location));
+  if (location.slot_ == nullptr) {
+    ASSERT_ND(!create);
+    return kErrorCodeStrKeyNotFound;
+  }
+
+  // same as upsert_record(), make sure the physical record is long enough for the new payload.
+  while (create && payload_count > location.slot_->get_max_payload()) {
+    HashDataPage* cur_page = reinterpret_cast<HashDataPage*>(to_page(location.slot_));
+    DataPageSlotIndex cur_index = cur_page->to_slot_index(location.slot_);
+    CHECK_ERROR_CODE(migrate_record(
+      context,
+      key,
+      key_length,
+      combo,
+      cur_page,
+      cur_index,
+      payload_count,
+      &location));
+    ASSERT_ND(location.slot_);
+    ASSERT_ND(location.record_);
+  }
+
+  *owner_id = &location.slot_->tid_;
+  *payload_address = location.record_;
+  return kErrorCodeOk;
+}
+
 ErrorCode HashStoragePimpl::get_root_page(
   thread::Thread* context,
   bool for_write,
@@ -801,6 +960,9 @@ ErrorCode HashStoragePimpl::follow_page_bin_head(
             ASSERT_ND(target->volatile_pointer_.is_null());
             target->volatile_pointer_ = next_page_id;
             target->snapshot_pointer_ = 0;  // will be no longer used, let's clear them
+            // snapshot pages don't have this bit. without it, readers think a next page
+            // is being installed concurrently and retry forever.
+            cur_page->header().page_version_.set_has_next_page();
 
             storage::Page* snapshot_page;
             last_error = context->find_or_read_a_snapshot_page(next, &snapshot_page);
@@ -1415,6 +1577,15 @@ ErrorCode HashStoragePimpl::append_next_volatile_page(
   x* value, \
   uint16_t payload_offset)
 INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_5I);
+
+#define EXPIN_6I(x) template ErrorCode HashStoragePimpl::increment_record_oneshot< x > \
+  (thread::Thread* context, \
+  const void* key, \
+  uint16_t key_length, \
+  const HashCombo& combo, \
+  x value, \
+  uint16_t payload_offset)
+INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_6I);
 // @endcond
 
 }  // namespace hash
@@ -226,6 +226,42 @@ ErrorCode HashTmpBin::overwrite_record(
   return kErrorCodeOk;
 }
 
+ErrorCode HashTmpBin::increment_record(
+  xct::XctId xct_id,
+  const void* key,
+  uint16_t key_length,
+  HashValue hash,
+  ValueType value_type,
+  const void* addendum,
+  uint16_t payload_offset) {
+  ASSERT_ND(!xct_id.is_deleted());
+  ASSERT_ND(hashinate(key, key_length) == hash);
+  SearchResult result = search_bucket(key, key_length, hash);
+  if (UNLIKELY(result.found_ == 0)) {
+    DLOG(WARNING) << "HashTmpBin::increment_record() hit KeyNotFound case 1. This must not"
+      << " happen except unit testcases.";
+    return kErrorCodeStrKeyNotFound;
+  } else {
+    Record* record = get_record(result.found_);
+    ASSERT_ND(record->hash_ == hash);
+    if (UNLIKELY(record->xct_id_.is_deleted())) {
+      DLOG(WARNING) << "HashTmpBin::increment_record() hit KeyNotFound case 2. This must not"
+        << " happen except unit testcases.";
+      return kErrorCodeStrKeyNotFound;
+    } else if (UNLIKELY(
+        record->payload_length_ < payload_offset + get_value_size(value_type))) {
+      DLOG(WARNING) << "HashTmpBin::increment_record() hit TooShortPayload case. This must not"
+        << " happen except unit testcases.";
+      return kErrorCodeStrTooShortPayload;
+    }
+    ASSERT_ND(record->xct_id_.compare_epoch_and_orginal(xct_id) < 0);
+    record->xct_id_ = xct_id;
+    add_value(value_type, record->get_payload() + payload_offset, addendum);
+  }
+
+  return kErrorCodeOk;
+}
+
 ErrorCode HashTmpBin::update_record(
   xct::XctId xct_id,
   const void* key,
@@ -427,7 +427,9 @@ ErrorStack MasstreeComposeContext::execute() {
         } else if (log_type == log::kLogCodeMasstreeUpdate) {
           CHECK_ERROR(execute_update_group(cur, cur + group.count_));
         } else {
-          ASSERT_ND(log_type == log::kLogCodeMasstreeOverwrite);
+          // increments are applied one by one just like overwrites
+          ASSERT_ND(log_type == log::kLogCodeMasstreeOverwrite
+            || log_type == log::kLogCodeMasstreeIncrement);
           CHECK_ERROR(execute_overwrite_group(cur, cur + group.count_));
         }
       }
@@ -457,6 +459,8 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
 
   // Let's say I:Insert, U:Update, D:Delete, O:Overwrite
   // overwrite: this is the easiest one that is nullified by following delete/update.
+  // increment: same as overwrite in this regard, so we treat it as an "O" below. The only
+  // difference is that we must not skip it even when a later overwrite covers a part of it.
   // insert: if there is following delete, everything in-between disappear, including insert/delete.
   // update: nullified by following delete/update
   // delete: strongest. never nullified except the insert-delete pairing.
@@ -521,7 +525,8 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
           break;
         default:
           ASSERT_ND(log_type_j == log::kLogCodeMasstreeUpdate
-            || log_type_j == log::kLogCodeMasstreeOverwrite);
+            || log_type_j == log::kLogCodeMasstreeOverwrite
+            || log_type_j == log::kLogCodeMasstreeIncrement);
           ASSERT_ND((!starts_with_insert && insert_count == delete_count)
             || (starts_with_insert && insert_count == delete_count + 1U));
           break;
@@ -589,6 +594,10 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
       next_to_check = next + 1U;
       last_active_delete = to;
     }
+  } else if (starts_with_insert) {
+    // No delete at all, so it's "I..." where ... has no I/D. The insert is active.
+    last_active_insert = from;
+    next_to_check = from + 1U;
   }
 
   // From now on, we are sure there is no more delete or insert.
@@ -613,8 +622,9 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
         is_last_active_update_merged = false;
       }
     } else {
-      // Overwrites are just skipped.
-      ASSERT_ND(log_type == log::kLogCodeMasstreeOverwrite);
+      // Overwrites (and increments) are just skipped.
+      ASSERT_ND(log_type == log::kLogCodeMasstreeOverwrite
+        || log_type == log::kLogCodeMasstreeIncrement);
       ASSERT_ND(starts_with_insert || last_active_insert != to);
     }
   }
@@ -659,8 +669,9 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
 
     // Process the I/U as usual. This also makes sure that the tail-record is the key.
   } else {
-    ASSERT_ND(log::kLogCodeMasstreeOverwrite == merge_sort_->get_log_type_from_sort_position(cur));
-    // All logs are overwrites.
+    ASSERT_ND(log::kLogCodeMasstreeOverwrite == merge_sort_->get_log_type_from_sort_position(cur)
+      || log::kLogCodeMasstreeIncrement == merge_sort_->get_log_type_from_sort_position(cur));
+    // All logs are overwrites or increments.
     // Even in this case, we must process the first log as usual so that
     // the tail-record in the tail page points to the record.
   }
@@ -671,7 +682,7 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
     return kRetOk;
   }
 
-  // All the followings are overwrites.
+  // All the followings are overwrites or increments.
   // Process the remaining overwrites in a tight loop.
   // We made sure sure the tail-record in the tail page points to the record.
   PathLevel* last = get_last_level();
@@ -684,19 +695,34 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
   char* record = page->get_record(index);
 
   for (uint32_t i = cur; i < to; ++i) {
-    const MasstreeOverwriteLogType* casted =
-      reinterpret_cast<const MasstreeOverwriteLogType*>(merge_sort_->resolve_sort_position(i));
-    ASSERT_ND(casted->header_.get_type() == log::kLogCodeMasstreeOverwrite);
-    ASSERT_ND(page->equal_key(index, casted->get_key(), casted->key_length_));
+    const MasstreeCommonLogType* entry =
+      reinterpret_cast<const MasstreeCommonLogType*>(merge_sort_->resolve_sort_position(i));
+    ASSERT_ND(page->equal_key(index, entry->get_key(), entry->key_length_));
+    if (entry->header_.get_type() == log::kLogCodeMasstreeIncrement) {
+      // snapshot records are never locked, so add the value directly rather than apply_record()
+      const MasstreeIncrementLogType* casted
+        = reinterpret_cast<const MasstreeIncrementLogType*>(entry);
+      ASSERT_ND(page->get_payload_length(index)
+        >= casted->payload_offset_ + casted->payload_count_);
+      add_value(
+        casted->get_value_type(),
+        page->get_record_payload(index) + casted->payload_offset_,
+        casted->get_payload());
+      continue;
+    }
+    ASSERT_ND(entry->header_.get_type() == log::kLogCodeMasstreeOverwrite);
+    const MasstreeOverwriteLogType* casted
+      = reinterpret_cast<const MasstreeOverwriteLogType*>(entry);
 
     // Also, we look for a chance to ignore redundant overwrites.
     // If next overwrite log covers the same or more data range, we can skip the log.
+    // An increment doesn't cover anything because it depends on the value before it.
     // Ideally, we should have removed such logs back in mappers.
-    if (i < to) {
-      const MasstreeOverwriteLogType* next =
-        reinterpret_cast<const MasstreeOverwriteLogType*>(
-          merge_sort_->resolve_sort_position(i + 1U));
-      if ((next->payload_offset_ <= casted->payload_offset_)
+    if (i + 1U < to) {
+      const MasstreeCommonLogType* next =
+        reinterpret_cast<const MasstreeCommonLogType*>(merge_sort_->resolve_sort_position(i + 1U));
+      if (next->header_.get_type() == log::kLogCodeMasstreeOverwrite
+        && (next->payload_offset_ <= casted->payload_offset_)
         && (next->payload_offset_ + next->payload_count_
           >= casted->payload_offset_ + casted->payload_count_)) {
         DVLOG(3) << "Skipped redundant overwrites";
@@ -1100,6 +1126,18 @@ inline ErrorStack MasstreeComposeContext::execute_a_log(uint32_t cur) {
     const MasstreeOverwriteLogType* casted
       = reinterpret_cast<const MasstreeOverwriteLogType*>(entry);
     casted->apply_record(nullptr, id_, page->get_owner_id(index), record);
+  } else if (entry->header_.get_type() == log::kLogCodeMasstreeIncrement) {
+    // [Increment] the record has the value as of the previous log. add to it.
+    SlotIndex index = key_count - 1;
+    ASSERT_ND(!page->does_point_to_layer(index));
+    ASSERT_ND(page->equal_key(index, key, key_length));
+    const MasstreeIncrementLogType* casted
+      = reinterpret_cast<const MasstreeIncrementLogType*>(entry);
+    ASSERT_ND(page->get_payload_length(index) >= casted->payload_offset_ + casted->payload_count_);
+    add_value(
+      casted->get_value_type(),
+      page->get_record_payload(index) + casted->payload_offset_,
+      casted->get_payload());
   } else {
     // DELETE/INSERT/UPDATE
     ASSERT_ND(
@@ -2633,7 +2671,7 @@ void MasstreeComposer::drop_root_volatile(const Composer::DropVolatilesArguments
     return;
   }
 
-  if (is_to_keep_volatile(0, volatile_page->get_btree_level())) {
+  if (is_to_keep_volatile(args, 0, volatile_page->get_btree_level())) {
     LOG(INFO) << "Oh, but " << storage_ << " is configured to keep the root page.";
     return;
   }
@@ -2737,7 +2775,7 @@ inline Composer::DropResult MasstreeComposer::drop_volatiles_recurse(
   ASSERT_ND(result.dropped_all_);
   bool updated_pointer = is_updated_pointer(args, pointer->snapshot_pointer_);
   if (updated_pointer) {
-    if (is_to_keep_volatile(page->get_layer(), page->get_btree_level())) {
+    if (is_to_keep_volatile(args, page->get_layer(), page->get_btree_level())) {
       DVLOG(2) << "Exempted";
       result.dropped_all_ = false;  // max_observed is satisfactory, but we chose to not drop.
     } else {
@@ -2815,6 +2853,7 @@ inline Composer::DropResult MasstreeComposer::drop_volatiles_border(
   }
 
   ASSERT_ND(!page->has_foster_child());
+  page->header().decay_hotness();  // in case we keep it
   const SlotIndex key_count = page->get_key_count();
   for (SlotIndex i = 0; i < key_count; ++i) {
     if (page->does_point_to_layer(i)) {
@@ -2834,18 +2873,23 @@ inline bool MasstreeComposer::is_updated_pointer(
   snapshot::SnapshotId snapshot_id = extract_snapshot_id_from_snapshot_pointer(pointer);
   return (pointer != 0 && args.snapshot_.id_ == snapshot_id);
 }
-inline bool MasstreeComposer::is_to_keep_volatile(uint8_t layer, uint16_t btree_level) const {
+inline bool MasstreeComposer::is_to_keep_volatile(
+  const Composer::DropVolatilesArguments& args,
+  uint8_t layer,
+  uint16_t btree_level) const {
   const MasstreeMetadata* meta = storage_.get_masstree_metadata();
+  // the volatile page evictor keeps fewer layers/levels as the memory pressure persists
+  const uint16_t pressure = args.evict_pressure_;
   // snapshot_drop_volatile_pages_layer_threshold_:
   // Number of B-trie layers of volatile pages to keep after each snapshotting.
   // Ex. 0 drops all (always false).
-  if (layer < meta->snapshot_drop_volatile_pages_layer_threshold_) {
+  if (layer + pressure < meta->snapshot_drop_volatile_pages_layer_threshold_) {
     return true;
   }
   // snapshot_drop_volatile_pages_btree_levels_:
   // Volatile pages of this B-tree level or higher are always kept after each snapshotting.
   // Ex. 0 keeps all. 0xFF drops all.
-  return (btree_level >= meta->snapshot_drop_volatile_pages_btree_levels_);
+  return (btree_level >= meta->snapshot_drop_volatile_pages_btree_levels_ + pressure);
 }
 
 std::ostream& operator<<(std::ostream& o, const MasstreeComposeContext::PathLevel& v) {
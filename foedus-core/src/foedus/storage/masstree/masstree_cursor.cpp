@@ -31,6 +31,7 @@
 #include "foedus/storage/masstree/masstree_retry_impl.hpp"
 #include "foedus/storage/masstree/masstree_storage.hpp"
 #include "foedus/storage/masstree/masstree_storage_pimpl.hpp"
+#include "foedus/thread/thread.hpp"
 #include "foedus/xct/xct.hpp"
 
 
@@ -175,6 +176,8 @@ ErrorCode MasstreeCursor::next() {
     return kErrorCodeOk;
   }
 
+  // pages we newly read while walking over records are inserted at a low priority.
+  thread::SnapshotCacheScanScope scan_scope(context_);
   assert_route();
   while (true) {
     CHECK_ERROR_CODE(proceed_route());
@@ -927,6 +930,7 @@ ErrorCode MasstreeCursor::open(
     return kErrorCodeXctNoXct;
   }
 
+  thread::SnapshotCacheScanScope scan_scope(context_);
   forward_cursor_ = forward_cursor;
   reached_end_ = false;
   for_writes_ = for_writes;
@@ -90,6 +90,16 @@ std::ostream& operator<<(std::ostream& o, const MasstreeOverwriteLogType& v) {
     << "</MasstreeOverwriteLog>";
   return o;
 }
+std::ostream& operator<<(std::ostream& o, const MasstreeIncrementLogType& v) {
+  o << "<MasstreeIncrementLog>"
+    << "<key_length_>" << v.key_length_ << "</key_length_>"
+    << "<key_>" << assorted::Top(v.get_key(), v.key_length_) << "</key_>"
+    << "<payload_offset_>" << v.payload_offset_ << "</payload_offset_>"
+    << "<value_type_>" << v.value_type_ << "</value_type_>"
+    << "<addendum_>" << assorted::Top(v.get_payload(), v.payload_count_) << "</addendum_>"
+    << "</MasstreeIncrementLog>";
+  return o;
+}
 
 }  // namespace masstree
 }  // namespace storage
@@ -450,7 +450,8 @@ void prepare_sort_entries(const Partitioner::SortBatchArguments& args, SortEntry
     ASSERT_ND(log_entry->header_.log_type_code_ == log::kLogCodeMasstreeInsert
       || log_entry->header_.log_type_code_ == log::kLogCodeMasstreeDelete
       || log_entry->header_.log_type_code_ == log::kLogCodeMasstreeUpdate
-      || log_entry->header_.log_type_code_ == log::kLogCodeMasstreeOverwrite);
+      || log_entry->header_.log_type_code_ == log::kLogCodeMasstreeOverwrite
+      || log_entry->header_.log_type_code_ == log::kLogCodeMasstreeIncrement);
     ASSERT_ND(log_entry->key_length_ == sizeof(KeySlice));
     Epoch epoch = log_entry->header_.xct_id_.get_epoch();
     ASSERT_ND(epoch.subtract(base_epoch) < (1U << 16));
@@ -664,6 +664,71 @@ ErrorCode MasstreeStorage::increment_record_normalized(
     payload_offset);
 }
 
+template <typename PAYLOAD>
+ErrorCode MasstreeStorage::increment_record_oneshot(
+  thread::Thread* context,
+  const void* key,
+  KeyLength key_length,
+  PAYLOAD value,
+  PayloadLength payload_offset) {
+  // Automatically switch to faster implementation for 8-byte keys
+  if (key_length == sizeof(KeySlice)) {
+    KeySlice slice = normalize_be_bytes_full(key);
+    return increment_record_oneshot_normalized<PAYLOAD>(context, slice, value, payload_offset);
+  }
+
+  MasstreeBorderPage* border;
+  SlotIndex index;
+  xct::XctId observed;
+  MasstreeStoragePimpl pimpl(this);
+  CHECK_ERROR_CODE(pimpl.locate_record(
+    context,
+    key,
+    key_length,
+    true,
+    &border,
+    &index,
+    &observed));
+  return pimpl.increment_oneshot_general<PAYLOAD>(
+    context,
+    border,
+    index,
+    observed,
+    key,
+    key_length,
+    value,
+    payload_offset);
+}
+
+template <typename PAYLOAD>
+ErrorCode MasstreeStorage::increment_record_oneshot_normalized(
+  thread::Thread* context,
+  KeySlice key,
+  PAYLOAD value,
+  PayloadLength payload_offset) {
+  MasstreeBorderPage* border;
+  SlotIndex index;
+  xct::XctId observed;
+  MasstreeStoragePimpl pimpl(this);
+  CHECK_ERROR_CODE(pimpl.locate_record_normalized(
+    context,
+    key,
+    true,
+    &border,
+    &index,
+    &observed));
+  uint64_t be_key = assorted::htobe<uint64_t>(key);
+  return pimpl.increment_oneshot_general<PAYLOAD>(
+    context,
+    border,
+    index,
+    observed,
+    &be_key,
+    sizeof(be_key),
+    value,
+    payload_offset);
+}
+
 ErrorStack MasstreeStorage::verify_single_thread(thread::Thread* context) {
   return MasstreeStoragePimpl(this).verify_single_thread(context);
 }
@@ -739,6 +804,15 @@ INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_5);
 #define EXPIN_6(x) template ErrorCode MasstreeStorage::increment_record_normalized< x > \
   (thread::Thread* context, KeySlice key, x* value, PayloadLength payload_offset)
 INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_6);
+
+#define EXPIN_7(x) template ErrorCode MasstreeStorage::increment_record_oneshot< x > \
+  (thread::Thread* context, const void* key, KeyLength key_length, x value, \
+  PayloadLength payload_offset)
+INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_7);
+
+#define EXPIN_8(x) template ErrorCode MasstreeStorage::increment_record_oneshot_normalized< x > \
+  (thread::Thread* context, KeySlice key, x value, PayloadLength payload_offset)
+INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_8);
 // @endcond
 
 }  // namespace masstree
@@ -417,6 +417,44 @@ ErrorCode MasstreeStoragePimpl::locate_record(
   }
 }
 
+ErrorCode MasstreeStoragePimpl::locate_record_for_replay(
+  thread::Thread* context,
+  const log::RecordLogType* log_entry,
+  xct::LockableXctId** owner_id,
+  char** payload_address) {
+  const MasstreeCommonLogType* casted = reinterpret_cast<const MasstreeCommonLogType*>(log_entry);
+  const log::LogCode type = log_entry->header_.get_type();
+  MasstreeBorderPage* border;
+  SlotIndex index;
+  xct::XctId observed;
+  if (type == log::kLogCodeMasstreeInsert || type == log::kLogCodeMasstreeUpdate) {
+    CHECK_ERROR_CODE(reserve_record(
+      context,
+      casted->get_key(),
+      casted->key_length_,
+      casted->payload_count_,
+      casted->payload_count_,
+      &border,
+      &index,
+      &observed));
+  } else {
+    ASSERT_ND(type == log::kLogCodeMasstreeDelete
+      || type == log::kLogCodeMasstreeOverwrite
+      || type == log::kLogCodeMasstreeIncrement);
+    CHECK_ERROR_CODE(locate_record(
+      context,
+      casted->get_key(),
+      casted->key_length_,
+      true,
+      &border,
+      &index,
+      &observed));
+  }
+  *owner_id = border->get_owner_id(index);
+  *payload_address = border->get_record(index);
+  return kErrorCodeOk;
+}
+
 ErrorCode MasstreeStoragePimpl::locate_record_normalized(
   thread::Thread* context,
   KeySlice key,
@@ -1432,6 +1470,45 @@ ErrorCode MasstreeStoragePimpl::increment_general(
     log_entry);
 }
 
+template <typename PAYLOAD>
+ErrorCode MasstreeStoragePimpl::increment_oneshot_general(
+  thread::Thread* context,
+  MasstreeBorderPage* border,
+  SlotIndex index,
+  xct::XctId observed,
+  const void* be_key,
+  KeyLength key_length,
+  PAYLOAD value,
+  PayloadLength payload_offset) {
+  if (observed.is_deleted()) {
+    // in this case, we don't need a page-version set. the physical record is surely there.
+    return kErrorCodeStrKeyNotFound;
+  }
+  CHECK_ERROR_CODE(check_next_layer_bit(observed));
+  if (border->get_payload_length(index) < payload_offset + sizeof(PAYLOAD)) {
+    LOG(WARNING) << "short record ";  // probably this is a rare error. so warn.
+    return kErrorCodeStrTooShortPayload;
+  }
+
+  uint16_t log_length = MasstreeIncrementLogType::calculate_log_length(key_length, sizeof(PAYLOAD));
+  MasstreeIncrementLogType* log_entry = reinterpret_cast<MasstreeIncrementLogType*>(
+    context->get_thread_log_buffer().reserve_new_log(log_length));
+  log_entry->populate<PAYLOAD>(
+    get_id(),
+    be_key,
+    key_length,
+    value,
+    payload_offset);
+  border->header().stat_last_updater_node_ = context->get_numa_node();
+
+  // No read set. precommit_xct_lock() confirms that the record still exists.
+  return context->get_current_xct().add_to_write_set(
+    get_id(),
+    border->get_owner_id(index),
+    border->get_record(index),
+    log_entry);
+}
+
 inline xct::TrackMovedRecordResult MasstreeStoragePimpl::track_moved_record(
   xct::LockableXctId* old_address,
   xct::WriteXctAccess* write_set) {
@@ -1449,6 +1526,10 @@ inline xct::TrackMovedRecordResult MasstreeStoragePimpl::track_moved_record(
   (thread::Thread* context, MasstreeBorderPage* border, SlotIndex index, xct::XctId observed, \
   const void* be_key, KeyLength key_length, x* value, PayloadLength payload_offset)
 INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_5);
+#define EXPIN_6(x) template ErrorCode MasstreeStoragePimpl::increment_oneshot_general< x > \
+  (thread::Thread* context, MasstreeBorderPage* border, SlotIndex index, xct::XctId observed, \
+  const void* be_key, KeyLength key_length, x value, PayloadLength payload_offset)
+INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_6);
 // @endcond
 
 }  // namespace masstree
@@ -68,6 +68,7 @@ std::ostream& operator<<(std::ostream& o, const PageHeader& v) {
     << "</masstree_in_layer_level_>";
   o << std::endl << "<stat_last_updater_node_>" << static_cast<int>(v.stat_last_updater_node_)
     << "</stat_last_updater_node_>";
+  o << "<hotness_>" << static_cast<int>(v.hotness_) << "</hotness_>";
   o << v.page_version_;
   o << "</PageHeader>";
   return o;
@@ -19,11 +19,13 @@
 
 #include <glog/logging.h>
 
+#include <cstring>
 #include <ostream>
 
 #include "foedus/engine.hpp"
 #include "foedus/assorted/assorted_func.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
+#include "foedus/soc/soc_id.hpp"
 #include "foedus/soc/soc_manager.hpp"
 #include "foedus/storage/storage.hpp"
 #include "foedus/storage/storage_manager.hpp"
@@ -126,6 +128,38 @@ void Partitioner::partition_batch(const Partitioner::PartitionBatchArguments& ar
   }
 }
 
+void Partitioner::group_by_partition(const Partitioner::GroupByPartitionArguments& args) {
+  ASSERT_ND(args.partition_count_ > 0);
+  ASSERT_ND(args.partition_count_ <= soc::kMaxSocs);
+  uint32_t* begins = args.partition_begins_;
+  std::memset(begins, 0, sizeof(uint32_t) * (args.partition_count_ + 1U));
+
+  // histogram. begins[p + 1] counts partition p so that the prefix sum below gives begins.
+  for (uint32_t i = 0; i < args.logs_count_; ++i) {
+    ASSERT_ND(args.partitions_[i] < args.partition_count_);
+    ++begins[args.partitions_[i] + 1U];
+  }
+  for (uint16_t p = 0; p < args.partition_count_; ++p) {
+    begins[p + 1U] += begins[p];
+  }
+  ASSERT_ND(begins[args.partition_count_] == args.logs_count_);
+
+  // scatter. The number of partitions is the number of NUMA nodes, so the cursors and
+  // the destination cachelines stay in L1 without software write-combining buffers.
+  uint32_t cursors[soc::kMaxSocs];
+  std::memcpy(cursors, begins, sizeof(uint32_t) * args.partition_count_);
+  for (uint32_t i = 0; i < args.logs_count_; ++i) {
+    const PartitionId partition = args.partitions_[i];
+    args.output_buffer_[cursors[partition]] = args.log_positions_[i];
+    ++cursors[partition];
+  }
+#ifndef NDEBUG
+  for (uint16_t p = 0; p < args.partition_count_; ++p) {
+    ASSERT_ND(cursors[p] == begins[p + 1U]);
+  }
+#endif  // NDEBUG
+}
+
 void Partitioner::sort_batch(const Partitioner::SortBatchArguments& args) {
   switch (type_) {
   case kArrayStorage: return array::ArrayPartitioner(this).sort_batch(args);
@@ -48,6 +48,7 @@
 #include "foedus/storage/hash/hash_log_types.hpp"
 #include "foedus/storage/hash/hash_metadata.hpp"
 #include "foedus/storage/hash/hash_storage.hpp"
+#include "foedus/storage/hash/hash_storage_pimpl.hpp"
 #include "foedus/storage/masstree/masstree_log_types.hpp"
 #include "foedus/storage/masstree/masstree_metadata.hpp"
 #include "foedus/storage/masstree/masstree_storage.hpp"
@@ -227,6 +228,11 @@ ErrorStack StorageManagerPimpl::drop_storage(StorageId id, Epoch *commit_epoch)
     LOG(FATAL) << "WTF:" << type;
   }
 
+  // Mark it before we issue the epoch of the log, like create_storage() creates the storage
+  // before logging. A snapshot in the epoch of the log then sees it dropped.
+  block->status_ = kMarkedForDeath;
+  ASSERT_ND(!block->exists());
+
   char log_buffer[1 << 12];
   std::memset(log_buffer, 0, sizeof(log_buffer));
   DropLogType* drop_log = reinterpret_cast<DropLogType*>(log_buffer);
@@ -234,8 +240,6 @@ ErrorStack StorageManagerPimpl::drop_storage(StorageId id, Epoch *commit_epoch)
   engine_->get_log_manager()->get_meta_buffer()->commit(drop_log, commit_epoch);
 
   ASSERT_ND(commit_epoch->is_valid());
-  block->status_ = kMarkedForDeath;
-  ASSERT_ND(!block->exists());
   block->uninitialize();
   LOG(INFO) << "Dropped storage " << id << "(" << name << ")";
   return kRetOk;
@@ -416,6 +420,14 @@ ErrorStack StorageManagerPimpl::clone_all_storage_metadata(
     metadata->storage_control_blocks_memory_.get_block());
   std::memcpy(metadata->storage_control_blocks_, storages_, memory_size);
 
+  // A hash storage resized in this snapshot switches its bin_bits a bit later.
+  for (StorageId id = 1; id <= metadata->largest_storage_id_; ++id) {
+    StorageControlBlock* block = metadata->storage_control_blocks_ + id;
+    if (block->exists() && block->meta_.type_ == kHashStorage) {
+      reinterpret_cast<hash::HashStorageControlBlock*>(block)->fix_snapshot_metadata(metadata->id_);
+    }
+  }
+
   stop_watch.stop();
   LOG(INFO) << "Duplicated metadata of " << metadata->largest_storage_id_
     << " storages  in " << stop_watch.elapsed_ms() << " milliseconds";
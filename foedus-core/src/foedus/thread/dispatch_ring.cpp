@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/thread/dispatch_ring.hpp"
+
+#include <cstring>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/soc/shared_memory_repo.hpp"
+
+namespace foedus {
+namespace thread {
+
+void DispatchRing::initialize() {
+  static_assert((kSlots & (kSlots - 1)) == 0, "kSlots must be a power of two");
+  tail_.store(0);
+  head_.store(0);
+  complete_cond_.initialize();
+  stat_dispatched_.store(0);
+  stat_stolen_.store(0);
+  for (uint64_t i = 0; i < kSlots; ++i) {
+    slots_[i].sequence_.store(i);
+    slots_[i].completed_.store(false);
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+ErrorCode DispatchRing::enqueue(
+  const proc::ProcName& proc_name,
+  const void* input,
+  uint32_t input_len,
+  uint64_t* position) {
+  if (input_len > static_cast<uint32_t>(DispatchSlot::kInputSize)) {
+    return kErrorCodeThrDispatchTooLarge;
+  }
+  uint64_t pos = tail_.load(std::memory_order_relaxed);
+  DispatchSlot* slot;
+  while (true) {
+    slot = get_slot(pos);
+    const uint64_t sequence = slot->sequence_.load(std::memory_order_acquire);
+    if (sequence == pos) {
+      if (tail_.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed)) {
+        break;
+      }
+      // pos is reloaded by the failed CAS
+    } else if (sequence < pos) {
+      // the previous invocation in this slot is still running or not collected yet
+      return kErrorCodeThrDispatchRingFull;
+    } else {
+      pos = tail_.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->completed_.store(false, std::memory_order_relaxed);
+  slot->result_ = kErrorCodeOk;
+  slot->input_len_ = input_len;
+  slot->output_len_ = 0;
+  slot->executed_by_ = 0;
+  slot->proc_name_ = proc_name;
+  if (input_len > 0) {
+    std::memcpy(slot->input_, input, input_len);
+  }
+  ++stat_dispatched_;
+  slot->sequence_.store(pos + 1U, std::memory_order_release);  // publish it
+  *position = pos;
+  return kErrorCodeOk;
+}
+
+DispatchSlot* DispatchRing::dequeue() {
+  uint64_t pos = head_.load(std::memory_order_relaxed);
+  while (true) {
+    DispatchSlot* slot = get_slot(pos);
+    const uint64_t sequence = slot->sequence_.load(std::memory_order_acquire);
+    if (sequence == pos + 1U) {
+      if (head_.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed)) {
+        return slot;
+      }
+    } else if (sequence < pos + 1U) {
+      return nullptr;  // not queued (or not published yet)
+    } else {
+      pos = head_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void DispatchRing::complete(DispatchSlot* slot) {
+  slot->completed_.store(true, std::memory_order_release);
+  complete_cond_.signal();
+}
+
+void DispatchRing::release(uint64_t position) {
+  DispatchSlot* slot = get_slot(position);
+  ASSERT_ND(slot->sequence_.load() == position + 1U);
+  ASSERT_ND(slot->completed_.load());
+  slot->sequence_.store(position + kSlots, std::memory_order_release);
+}
+
+static_assert(
+  sizeof(DispatchRing) <= soc::ThreadMemoryAnchors::kDispatchRingMemorySize,
+  "DispatchRing doesn't fit in kDispatchRingMemorySize");
+
+}  // namespace thread
+}  // namespace foedus
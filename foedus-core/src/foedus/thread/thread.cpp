@@ -69,6 +69,10 @@ void Thread::reset_snapshot_cache_counts() const {
   pimpl_->control_block_->stat_snapshot_cache_misses_ = 0;
 }
 
+xct::XctStatistics& Thread::get_xct_statistics() {
+  return pimpl_->control_block_->stat_xct_;
+}
+
 xct::Xct&   Thread::get_current_xct()   { return pimpl_->current_xct_; }
 bool        Thread::is_running_xct()    const { return pimpl_->current_xct_.is_active(); }
 
@@ -101,6 +105,9 @@ ErrorCode Thread::find_or_read_snapshot_pages_batch(
   return pimpl_->find_or_read_snapshot_pages_batch(batch_size, page_ids, out);
 }
 
+bool Thread::is_snapshot_cache_scan() const { return pimpl_->snapshot_cache_scan_; }
+void Thread::set_snapshot_cache_scan(bool value) { pimpl_->snapshot_cache_scan_ = value; }
+
 ErrorCode Thread::install_a_volatile_page(
   storage::DualPagePointer* pointer,
   storage::Page** installed_page) {
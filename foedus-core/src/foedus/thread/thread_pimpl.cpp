@@ -40,6 +40,7 @@
 #include "foedus/proc/proc_manager.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
 #include "foedus/soc/soc_manager.hpp"
+#include "foedus/thread/dispatch_ring.hpp"
 #include "foedus/thread/numa_thread_scope.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
@@ -63,12 +64,14 @@ ThreadPimpl::ThreadPimpl(
     node_memory_(nullptr),
     snapshot_cache_hashtable_(nullptr),
     snapshot_page_pool_(nullptr),
+    snapshot_cache_scan_(false),
     log_buffer_(engine, id),
     current_xct_(engine, id),
     snapshot_file_set_(engine),
     control_block_(nullptr),
     task_input_memory_(nullptr),
     task_output_memory_(nullptr),
+    dispatch_ring_(nullptr),
     mcs_blocks_(nullptr) {
 }
 
@@ -82,6 +85,8 @@ ErrorStack ThreadPimpl::initialize_once() {
   task_input_memory_ = anchors->task_input_memory_;
   task_output_memory_ = anchors->task_output_memory_;
   mcs_blocks_ = anchors->mcs_lock_memories_;
+  dispatch_ring_ = anchors->dispatch_ring_memory_;
+  dispatch_ring_->initialize();
 
   pool_pimpl_ = engine_->get_thread_pool()->get_pimpl();
   node_memory_ = engine_->get_memory_manager()->get_local_memory();
@@ -92,7 +97,7 @@ ErrorStack ThreadPimpl::initialize_once() {
     snapshot_cache_hashtable_ = nullptr;
   }
   snapshot_page_pool_ = node_memory_->get_snapshot_pool();
-  current_xct_.initialize(core_memory_, &control_block_->mcs_block_current_);
+  current_xct_.initialize(holder_, core_memory_, &control_block_->mcs_block_current_);
   CHECK_ERROR(snapshot_file_set_.initialize());
   CHECK_ERROR(log_buffer_.initialize());
   global_volatile_page_resolver_
@@ -153,64 +158,145 @@ void ThreadPimpl::handle_tasks() {
   set_thread_schedule();
   ASSERT_ND(control_block_->status_ == kNotInitialized);
   control_block_->status_ = kWaitingForTask;
+  // After running a dispatched task, we busy-poll for a while as more tasks likely follow.
+  // Initially there is no such reason, so we sleep as before.
+  uint32_t idle_rounds = DispatchRing::kBusyPollRounds;
   while (!is_stop_requested()) {
     assorted::spinlock_yield();
+    if (control_block_->status_ == kWaitingForExecution) {
+      run_impersonated_task();
+      continue;
+    }
+    if (run_dispatched_task()) {
+      idle_rounds = 0;
+      continue;
+    }
+    if (idle_rounds < DispatchRing::kBusyPollRounds) {
+      ++idle_rounds;
+      continue;
+    }
     {
       uint64_t demand = control_block_->wakeup_cond_.acquire_ticket();
       if (is_stop_requested()) {
         break;
       }
       // these two status are "not urgent".
-      if (control_block_->status_ == kWaitingForTask
-        || control_block_->status_ == kWaitingForClientRelease) {
+      if ((control_block_->status_ == kWaitingForTask
+        || control_block_->status_ == kWaitingForClientRelease)
+        && !has_queued_dispatch()) {
         VLOG(0) << "Thread-" << id_ << " sleeping...";
         control_block_->wakeup_cond_.timedwait(demand, 100000ULL, 1U << 16, 1U << 13);
       }
     }
     VLOG(0) << "Thread-" << id_ << " woke up. status=" << control_block_->status_;
-    if (control_block_->status_ == kWaitingForExecution) {
-      control_block_->output_len_ = 0;
-      control_block_->status_ = kRunningTask;
-      const proc::ProcName& proc_name = control_block_->proc_name_;
-      VLOG(0) << "Thread-" << id_ << " retrieved a task: " << proc_name;
-      proc::Proc proc = nullptr;
-      ErrorStack result = engine_->get_proc_manager()->get_proc(proc_name, &proc);
-      if (result.is_error()) {
-        // control_block_->proc_result_
-        LOG(ERROR) << "Thread-" << id_ << " couldn't find procedure: " << proc_name;
-      } else {
-        uint32_t output_used = 0;
-        proc::ProcArguments args = {
-          engine_,
-          holder_,
-          task_input_memory_,
-          control_block_->input_len_,
-          task_output_memory_,
-          soc::ThreadMemoryAnchors::kTaskOutputMemorySize,
-          &output_used,
-        };
-        result = proc(args);
-        VLOG(0) << "Thread-" << id_ << " run(task) returned. result =" << result
-          << ", output_used=" << output_used;
-        control_block_->output_len_ = output_used;
-      }
-      if (result.is_error()) {
-        control_block_->proc_result_.from_error_stack(result);
-      } else {
-        control_block_->proc_result_.clear();
-      }
-      control_block_->status_ = kWaitingForClientRelease;
-      {
-        // Wakeup the client if it's waiting.
-        control_block_->task_complete_cond_.signal();
-      }
-      VLOG(0) << "Thread-" << id_ << " finished a task. result =" << result;
-    }
   }
   ASSERT_ND(is_stop_requested());
   control_block_->status_ = kTerminated;
   LOG(INFO) << "Thread-" << id_ << " exits";
 }
+
+void ThreadPimpl::run_impersonated_task() {
+  ASSERT_ND(control_block_->status_ == kWaitingForExecution);
+  control_block_->output_len_ = 0;
+  control_block_->status_ = kRunningTask;
+  const proc::ProcName& proc_name = control_block_->proc_name_;
+  VLOG(0) << "Thread-" << id_ << " retrieved a task: " << proc_name;
+  proc::Proc proc = nullptr;
+  ErrorStack result = engine_->get_proc_manager()->get_proc(proc_name, &proc);
+  if (result.is_error()) {
+    // control_block_->proc_result_
+    LOG(ERROR) << "Thread-" << id_ << " couldn't find procedure: " << proc_name;
+  } else {
+    uint32_t output_used = 0;
+    proc::ProcArguments args = {
+      engine_,
+      holder_,
+      task_input_memory_,
+      control_block_->input_len_,
+      task_output_memory_,
+      soc::ThreadMemoryAnchors::kTaskOutputMemorySize,
+      &output_used,
+    };
+    result = proc(args);
+    VLOG(0) << "Thread-" << id_ << " run(task) returned. result =" << result
+      << ", output_used=" << output_used;
+    control_block_->output_len_ = output_used;
+  }
+  if (result.is_error()) {
+    control_block_->proc_result_.from_error_stack(result);
+  } else {
+    control_block_->proc_result_.clear();
+  }
+  control_block_->status_ = kWaitingForClientRelease;
+  {
+    // Wakeup the client if it's waiting.
+    control_block_->task_complete_cond_.signal();
+  }
+  VLOG(0) << "Thread-" << id_ << " finished a task. result =" << result;
+}
+
+bool ThreadPimpl::has_queued_dispatch() {
+  if (dispatch_ring_->has_queued()) {
+    return true;
+  }
+  const uint16_t thread_per_group = engine_->get_options().thread_.thread_count_per_group_;
+  for (uint16_t i = 0; i < thread_per_group; ++i) {
+    ThreadRef* peer = pool_pimpl_->get_thread(compose_thread_id(numa_node_, i));
+    if (peer->get_dispatch_ring()->has_queued()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPimpl::run_dispatched_task() {
+  DispatchRing* ring = dispatch_ring_;
+  DispatchSlot* slot = ring->dequeue();
+  if (slot == nullptr) {
+    // Our ring is empty. Take a task queued to a busy peer in this node, if any.
+    const uint16_t thread_per_group = engine_->get_options().thread_.thread_count_per_group_;
+    const ThreadLocalOrdinal my_ordinal = decompose_numa_local_ordinal(id_);
+    for (uint16_t i = 1; i < thread_per_group && slot == nullptr; ++i) {
+      const ThreadLocalOrdinal victim = (my_ordinal + i) % thread_per_group;
+      ring = pool_pimpl_->get_thread(compose_thread_id(numa_node_, victim))->get_dispatch_ring();
+      if (ring->has_queued()) {
+        slot = ring->dequeue();
+      }
+    }
+    if (slot == nullptr) {
+      return false;
+    }
+    ++ring->stat_stolen_;
+  }
+
+  proc::Proc proc = nullptr;
+  ErrorStack result = engine_->get_proc_manager()->get_proc(slot->proc_name_, &proc);
+  uint32_t output_used = 0;
+  if (result.is_error()) {
+    LOG(ERROR) << "Thread-" << id_ << " couldn't find procedure: " << slot->proc_name_;
+  } else {
+    proc::ProcArguments args = {
+      engine_,
+      holder_,
+      slot->input_,
+      slot->input_len_,
+      slot->output_,
+      DispatchSlot::kOutputSize,
+      &output_used,
+    };
+    result = proc(args);
+    if (result.is_error()) {
+      LOG(ERROR) << "Thread-" << id_ << " dispatched procedure " << slot->proc_name_
+        << " failed: " << result;
+    }
+  }
+  slot->result_ = result.get_error_code();
+  slot->output_len_ = output_used;
+  slot->executed_by_ = id_;
+  ring->complete(slot);
+  return true;
+}
+
 void ThreadPimpl::set_thread_schedule() {
   // this code totally assumes pthread. maybe ifdef to handle Windows.. later!
   SPINLOCK_WHILE(raw_thread_set_ == false) {
@@ -642,7 +728,7 @@ ErrorCode ThreadPimpl::find_or_read_a_snapshot_page(
       }
       CHECK_ERROR_CODE(on_snapshot_cache_miss(page_id, &offset));
       ASSERT_ND(offset != 0);
-      CHECK_ERROR_CODE(snapshot_cache_hashtable_->install(page_id, offset));
+      CHECK_ERROR_CODE(snapshot_cache_hashtable_->install(page_id, offset, snapshot_cache_scan_));
       ++control_block_->stat_snapshot_cache_misses_;
     } else {
       ++control_block_->stat_snapshot_cache_hits_;
@@ -667,6 +753,49 @@ static_assert(
     <= static_cast<int>(cache::CacheHashtable::kMaxFindBatchSize),
   "Booo");
 
+/**
+ * Installs snapshot pages read by SnapshotFileSet::read_pages_batch() into the snapshot cache
+ * as each read completes.
+ */
+struct BatchReadInstaller {
+  ThreadPimpl*                pimpl_;
+  storage::Page**             out_;
+  uint16_t                    miss_count_;
+  /** Index in the original batch for each miss */
+  uint16_t                    miss_batch_index_[Thread::kMaxFindPagesBatch];
+  storage::SnapshotPagePointer miss_page_ids_[Thread::kMaxFindPagesBatch];
+  memory::PagePoolOffset      miss_offsets_[Thread::kMaxFindPagesBatch];
+  void*                       miss_buffers_[Thread::kMaxFindPagesBatch];
+
+  static ErrorCode on_completion(uint16_t index, void* arg) {
+    BatchReadInstaller* installer = reinterpret_cast<BatchReadInstaller*>(arg);
+    ASSERT_ND(index < installer->miss_count_);
+    ThreadPimpl* pimpl = installer->pimpl_;
+    memory::PagePoolOffset offset = installer->miss_offsets_[index];
+    CHECK_ERROR_CODE(pimpl->snapshot_cache_hashtable_->install(
+      installer->miss_page_ids_[index],
+      offset,
+      pimpl->snapshot_cache_scan_));
+    installer->out_[installer->miss_batch_index_[index]]
+      = pimpl->snapshot_page_pool_->get_base() + offset;
+    return kErrorCodeOk;
+  }
+
+  /** Returns the pages that are not installed yet to the free pool. Used on errors. */
+  void release_remaining() {
+    for (uint16_t m = 0; m < miss_count_; ++m) {
+      if (out_[miss_batch_index_[m]] == nullptr) {
+        pimpl_->core_memory_->release_free_snapshot_page(miss_offsets_[m]);
+      }
+    }
+  }
+};
+
+static_assert(
+  static_cast<int>(Thread::kMaxFindPagesBatch)
+    <= static_cast<int>(cache::SnapshotFileSet::kMaxAsyncReads),
+  "Booo");
+
 ErrorCode ThreadPimpl::find_or_read_snapshot_pages_batch(
   uint16_t batch_size,
   const storage::SnapshotPagePointer* page_ids,
@@ -682,31 +811,72 @@ ErrorCode ThreadPimpl::find_or_read_snapshot_pages_batch(
     ASSERT_ND(engine_->get_options().cache_.snapshot_cache_enabled_);
     memory::PagePoolOffset offsets[Thread::kMaxFindPagesBatch];
     CHECK_ERROR_CODE(snapshot_cache_hashtable_->find_batch(batch_size, page_ids, offsets));
+
+    // First, resolve hits and grab buffer pages for misses. We then read all the misses at once
+    // so that they are outstanding together, rather than paying a device round trip for each.
+    BatchReadInstaller installer;
+    installer.pimpl_ = this;
+    installer.out_ = out;
+    installer.miss_count_ = 0;
     for (uint16_t b = 0; b < batch_size; ++b) {
       memory::PagePoolOffset offset = offsets[b];
       storage::SnapshotPagePointer page_id = page_ids[b];
+      out[b] = nullptr;
       if (page_id == 0) {
-        out[b] = nullptr;
         continue;
       } else if (b > 0 && page_ids[b - 1] == page_id) {
         ASSERT_ND(offsets[b - 1] == offset);
-        out[b] = out[b - 1];
-        continue;
+        continue;  // resolved below
       }
       if (offset == 0 || snapshot_page_pool_->get_base()[offset].get_header().page_id_ != page_id) {
         if (offset != 0) {
           DVLOG(0) << "Interesting, this race is rare, but possible. offset=" << offset;
         }
-        CHECK_ERROR_CODE(on_snapshot_cache_miss(page_id, &offset));
-        ASSERT_ND(offset != 0);
-        CHECK_ERROR_CODE(snapshot_cache_hashtable_->install(page_id, offset));
+        memory::PagePoolOffset new_offset = core_memory_->grab_free_snapshot_page();
+        if (UNLIKELY(new_offset == 0)) {
+          LOG(ERROR) << "Could not grab free snapshot page while cache miss. thread=" << *holder_
+            << ", page_id=" << assorted::Hex(page_id);
+          installer.release_remaining();
+          return kErrorCodeCacheNoFreePages;
+        }
+        uint16_t m = installer.miss_count_;
+        installer.miss_batch_index_[m] = b;
+        installer.miss_page_ids_[m] = page_id;
+        installer.miss_offsets_[m] = new_offset;
+        installer.miss_buffers_[m] = snapshot_page_pool_->get_base() + new_offset;
+        ++installer.miss_count_;
         ++control_block_->stat_snapshot_cache_misses_;
       } else {
         ++control_block_->stat_snapshot_cache_hits_;
+        out[b] = snapshot_page_pool_->get_base() + offset;
+      }
+    }
+
+    if (installer.miss_count_ > 0) {
+      // Each page is installed into the hashtable as soon as its read completes.
+      ErrorCode read_result = snapshot_file_set_.read_pages_batch(
+        installer.miss_count_,
+        installer.miss_page_ids_,
+        installer.miss_buffers_,
+        BatchReadInstaller::on_completion,
+        &installer);
+      if (read_result != kErrorCodeOk) {
+        LOG(ERROR) << "Failed to read snapshot pages. thread=" << *holder_;
+        installer.release_remaining();
+        return read_result;
       }
-      ASSERT_ND(offset != 0);
-      out[b] = snapshot_page_pool_->get_base() + offset;
     }
+
+    for (uint16_t b = 1; b < batch_size; ++b) {
+      if (page_ids[b] != 0 && page_ids[b - 1] == page_ids[b]) {
+        out[b] = out[b - 1];
+      }
+    }
+#ifndef NDEBUG
+    for (uint16_t b = 0; b < batch_size; ++b) {
+      ASSERT_ND(page_ids[b] == 0 || out[b] != nullptr);
+    }
+#endif  // NDEBUG
   } else {
     ASSERT_ND(!engine_->get_options().cache_.snapshot_cache_enabled_);
     for (uint16_t b = 0; b < batch_size; ++b) {
@@ -808,6 +978,12 @@ bool ThreadPimpl::is_volatile_page_retired(storage::VolatilePagePointer ptr) {
 xct::McsBlockIndex Thread::mcs_acquire_lock(xct::McsLock* mcs_lock) {
   return pimpl_->mcs_acquire_lock(mcs_lock);
 }
+xct::McsBlockIndex Thread::mcs_acquire_lock_canonical(xct::McsLock* mcs_lock) {
+  return pimpl_->mcs_acquire_lock_canonical(mcs_lock);
+}
+xct::McsBlockIndex Thread::mcs_try_acquire_lock(xct::McsLock* mcs_lock) {
+  return pimpl_->mcs_try_acquire_lock(mcs_lock);
+}
 xct::McsBlockIndex Thread::mcs_acquire_lock_batch(xct::McsLock** mcs_locks, uint16_t batch_size) {
   // lock in address order. so, no deadlock possible
   // we have to lock them whether the record is deleted or not. all physical records.
@@ -909,6 +1085,50 @@ void spin_until(COND spin_while_cond) {
 }
 
 xct::McsBlockIndex ThreadPimpl::mcs_acquire_lock(xct::McsLock* mcs_lock) {
+  if (UNLIKELY(current_xct_.get_hot_lock_set_size() > 0)) {
+    // The current transaction retains record locks taken during execution. This is usually
+    // a system transaction (eg record migration, page split) in the middle of it.
+    // Waiting for another lock while retaining them might cause deadlocks, for example with
+    // a thread that splits the page and waits for the record lock we retain.
+    // So, we give them up unless we can get the lock right now. They are just an optimization,
+    // and the commit protocol verifies the records anyway.
+    current_xct_.release_hot_lock(mcs_lock);  // we might be locking the record itself
+    xct::McsBlockIndex block_index = mcs_try_acquire_lock(mcs_lock);
+    if (block_index != 0) {
+      return block_index;
+    }
+    DVLOG(0) << "Giving up hot locks to wait for another lock. me=" << id_;
+    current_xct_.release_hot_locks();
+  }
+  return mcs_acquire_lock_canonical(mcs_lock);
+}
+
+xct::McsBlockIndex ThreadPimpl::mcs_try_acquire_lock(xct::McsLock* mcs_lock) {
+  ASSERT_ND(!control_block_->mcs_waiting_);
+  assert_mcs_aligned(mcs_lock);
+  uint32_t* address = &(mcs_lock->data_);
+  if (assorted::atomic_load_acquire<uint32_t>(address) != 0) {
+    return 0;  // locked by someone (or by a guest). don't bother CAS.
+  }
+
+  // we consume the MCS block only when we got the lock.
+  ASSERT_ND(current_xct_.get_mcs_block_current() < 0xFFFFU);
+  xct::McsBlockIndex block_index = current_xct_.get_mcs_block_current() + 1U;
+  xct::McsBlock* my_block = mcs_blocks_ + block_index;
+  my_block->clear_successor_release();
+  uint32_t expected = 0;
+  uint32_t desired = xct::McsLock::to_int(id_, block_index);
+  if (assorted::raw_atomic_compare_exchange_strong<uint32_t>(address, &expected, desired)) {
+    ASSERT_ND(mcs_lock->is_locked());
+    xct::McsBlockIndex incremented = current_xct_.increment_mcs_block_current();
+    ASSERT_ND(incremented == block_index);
+    DVLOG(2) << "Okay, got a lock by try. me=" << id_;
+    return incremented;
+  }
+  return 0;
+}
+
+xct::McsBlockIndex ThreadPimpl::mcs_acquire_lock_canonical(xct::McsLock* mcs_lock) {
   // Basically _all_ writes in this function must come with some memory barrier. Be careful!
   // Also, the performance of this method really matters, especially that of common path.
   // Check objdump -d. Everything in common path should be inlined.
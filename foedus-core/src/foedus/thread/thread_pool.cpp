@@ -63,6 +63,34 @@ bool ThreadPool::impersonate_on_numa_core(
   return pimpl_->impersonate_on_numa_core(core, proc_name, task_input, task_input_size, session);
 }
 
+ErrorCode ThreadPool::dispatch(
+  ThreadId core,
+  const proc::ProcName& proc_name,
+  const void* task_input,
+  uint32_t task_input_size,
+  DispatchTicket* ticket) {
+  return pimpl_->dispatch(core, proc_name, task_input, task_input_size, ticket);
+}
+
+bool ThreadPool::is_dispatch_completed(const DispatchTicket& ticket) const {
+  return pimpl_->is_dispatch_completed(ticket);
+}
+
+ErrorCode ThreadPool::collect_dispatch(
+  const DispatchTicket& ticket,
+  void* output_buffer,
+  uint32_t output_buffer_size,
+  uint32_t* output_size) {
+  return pimpl_->collect_dispatch(ticket, output_buffer, output_buffer_size, output_size);
+}
+
+uint32_t ThreadPool::collect_dispatches(
+  uint32_t count,
+  const DispatchTicket* tickets,
+  ErrorCode* results) {
+  return pimpl_->collect_dispatches(count, tickets, results);
+}
+
 ThreadGroupRef* ThreadPool::get_group_ref(ThreadGroupId numa_node) {
   return pimpl_->get_group(numa_node);
 }
@@ -19,6 +19,9 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <ostream>
 
 #include "foedus/assert_nd.hpp"
@@ -28,6 +31,7 @@
 #include "foedus/assorted/atomic_fences.hpp"
 #include "foedus/memory/engine_memory.hpp"
 #include "foedus/memory/memory_id.hpp"
+#include "foedus/thread/dispatch_ring.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_group.hpp"
 #include "foedus/thread/thread_id.hpp"
@@ -118,6 +122,84 @@ bool ThreadPoolPimpl::impersonate_on_numa_core(
   return thread->try_impersonate(proc_name, task_input, task_input_size, session);
 }
 
+ErrorCode ThreadPoolPimpl::dispatch(
+  ThreadId core,
+  const proc::ProcName& proc_name,
+  const void* task_input,
+  uint32_t task_input_size,
+  DispatchTicket* ticket) {
+  ThreadRef* thread = get_thread(core);
+  CHECK_ERROR_CODE(thread->dispatch(proc_name, task_input, task_input_size, ticket));
+  // The worker might be busy with other invocations. Wake up an idle peer in the same node,
+  // too, which steals from the ring. Otherwise a sleeping peer notices it only after timeout.
+  const ThreadGroupId node = decompose_numa_node(core);
+  const ThreadLocalOrdinal ordinal = decompose_numa_local_ordinal(core);
+  const uint16_t thread_per_group = engine_->get_options().thread_.thread_count_per_group_;
+  for (uint16_t i = 1; i < thread_per_group; ++i) {
+    const ThreadLocalOrdinal peer = (ordinal + i) % thread_per_group;
+    ThreadControlBlock* block = get_thread(compose_thread_id(node, peer))->get_control_block();
+    if (block->status_ == kWaitingForTask || block->status_ == kWaitingForClientRelease) {
+      block->wakeup_cond_.signal();
+      break;
+    }
+  }
+  return kErrorCodeOk;
+}
+
+bool ThreadPoolPimpl::is_dispatch_completed(const DispatchTicket& ticket) {
+  return get_thread(ticket.thread_id_)->get_dispatch_ring()->is_completed(ticket.position_);
+}
+
+ErrorCode ThreadPoolPimpl::collect_dispatch(
+  const DispatchTicket& ticket,
+  void* output_buffer,
+  uint32_t output_buffer_size,
+  uint32_t* output_size) {
+  ThreadRef* thread = get_thread(ticket.thread_id_);
+  DispatchRing* ring = thread->get_dispatch_ring();
+  const DispatchSlot* slot = ring->get_slot(ticket.position_);
+  if (slot->sequence_.load(std::memory_order_acquire) != ticket.position_ + 1U) {
+    return kErrorCodeSessionExpired;
+  }
+  while (!ring->is_completed(ticket.position_)) {
+    uint64_t demand = ring->complete_cond_.acquire_ticket();
+    if (ring->is_completed(ticket.position_)) {
+      break;
+    }
+    const ThreadStatus status = thread->get_control_block()->status_;
+    if (status == kWaitingForTerminate || status == kTerminated) {
+      LOG(WARNING) << "Thread-" << ticket.thread_id_ << " is terminating. The dispatched"
+        << " invocation at " << ticket.position_ << " will never complete";
+      return kErrorCodeBeingShutdown;
+    }
+    ring->complete_cond_.timedwait(demand, 100000ULL);
+  }
+
+  const ErrorCode result = slot->result_;
+  if (output_buffer) {
+    std::memcpy(output_buffer, slot->output_, std::min(output_buffer_size, slot->output_len_));
+  }
+  if (output_size) {
+    *output_size = slot->output_len_;
+  }
+  ring->release(ticket.position_);
+  return result;
+}
+
+uint32_t ThreadPoolPimpl::collect_dispatches(
+  uint32_t count,
+  const DispatchTicket* tickets,
+  ErrorCode* results) {
+  uint32_t succeeded = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    results[i] = collect_dispatch(tickets[i], nullptr, 0, nullptr);
+    if (results[i] == kErrorCodeOk) {
+      ++succeeded;
+    }
+  }
+  return succeeded;
+}
+
 std::ostream& operator<<(std::ostream& o, const ThreadPoolPimpl& v) {
   o << "<ThreadPool>";
   o << "<groups>";
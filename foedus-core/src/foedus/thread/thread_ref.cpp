@@ -26,6 +26,7 @@
 #include "foedus/assorted/atomic_fences.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
 #include "foedus/soc/soc_manager.hpp"
+#include "foedus/thread/dispatch_ring.hpp"
 #include "foedus/thread/impersonate_session.hpp"
 #include "foedus/thread/thread_id.hpp"
 #include "foedus/thread/thread_pimpl.hpp"
@@ -39,7 +40,8 @@ ThreadRef::ThreadRef()
   control_block_(nullptr),
   task_input_memory_(nullptr),
   task_output_memory_(nullptr),
-  mcs_blocks_(nullptr) {}
+  mcs_blocks_(nullptr),
+  dispatch_ring_(nullptr) {}
 
 ThreadRef::ThreadRef(Engine* engine, ThreadId id) : engine_(engine), id_(id) {
   soc::SharedMemoryRepo* memory_repo = engine->get_soc_manager()->get_shared_memory_repo();
@@ -48,6 +50,7 @@ ThreadRef::ThreadRef(Engine* engine, ThreadId id) : engine_(engine), id_(id) {
   task_input_memory_ = anchors->task_input_memory_;
   task_output_memory_ = anchors->task_output_memory_;
   mcs_blocks_ = anchors->mcs_lock_memories_;
+  dispatch_ring_ = anchors->dispatch_ring_memory_;
 }
 
 bool ThreadRef::try_impersonate(
@@ -94,6 +97,27 @@ bool ThreadRef::try_impersonate(
   return true;
 }
 
+ErrorCode ThreadRef::dispatch(
+  const proc::ProcName& proc_name,
+  const void* task_input,
+  uint32_t task_input_size,
+  DispatchTicket* ticket) {
+  if (UNLIKELY(control_block_->status_ == kNotInitialized)) {
+    // The worker thread has not initialized the ring yet.
+    while (control_block_->status_ == kNotInitialized) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      assorted::memory_fence_acquire();
+    }
+  }
+  uint64_t position;
+  CHECK_ERROR_CODE(dispatch_ring_->enqueue(proc_name, task_input, task_input_size, &position));
+  ticket->thread_id_ = id_;
+  ticket->position_ = position;
+  // waking up doesn't need mutex. it's cheap if the worker is busy-polling.
+  control_block_->wakeup_cond_.signal();
+  return kErrorCodeOk;
+}
+
 ThreadGroupRef::ThreadGroupRef() : engine_(nullptr), group_id_(0) {
 }
 
@@ -123,6 +147,14 @@ void ThreadRef::reset_snapshot_cache_counts() const {
   control_block_->stat_snapshot_cache_misses_ = 0;
 }
 
+const xct::XctStatistics& ThreadRef::get_xct_statistics() const {
+  return control_block_->stat_xct_;
+}
+
+void ThreadRef::reset_xct_statistics() const {
+  control_block_->stat_xct_.reset();
+}
+
 Epoch ThreadGroupRef::get_min_in_commit_epoch() const {
   assorted::memory_fence_acquire();
   Epoch ret = INVALID_EPOCH;
@@ -48,14 +48,23 @@ Xct::Xct(Engine* engine, thread::ThreadId thread_id) : engine_(engine), thread_i
   max_lock_free_write_set_size_ = 0;
   pointer_set_size_ = 0;
   page_version_set_size_ = 0;
+  hot_lock_set_ = nullptr;
+  hot_lock_set_size_ = 0;
+  hot_lock_max_address_ = 0;
+  context_ = nullptr;
   isolation_level_ = kSerializable;
+  hot_threshold_ = XctOptions::kHotThresholdNever;
   mcs_block_current_ = nullptr;
   local_work_memory_ = nullptr;
   local_work_memory_size_ = 0;
   local_work_memory_cur_ = 0;
 }
 
-void Xct::initialize(memory::NumaCoreMemory* core_memory, uint32_t* mcs_block_current) {
+void Xct::initialize(
+  thread::Thread* context,
+  memory::NumaCoreMemory* core_memory,
+  uint32_t* mcs_block_current) {
+  context_ = context;
   id_.set_epoch(engine_->get_savepoint_manager()->get_initial_current_epoch());
   id_.set_ordinal(0);  // ordinal 0 is possible only as a dummy "latest" XctId
   ASSERT_ND(id_.is_valid());
@@ -76,6 +85,10 @@ void Xct::initialize(memory::NumaCoreMemory* core_memory, uint32_t* mcs_block_cu
   pointer_set_size_ = 0;
   page_version_set_ = reinterpret_cast<PageVersionAccess*>(pieces.xct_page_version_memory_);
   page_version_set_size_ = 0;
+  hot_lock_set_ = reinterpret_cast<HotLockAccess*>(pieces.xct_hot_lock_memory_);
+  hot_lock_set_size_ = 0;
+  hot_lock_max_address_ = 0;
+  hot_threshold_ = xct_opt.hot_threshold_;
   mcs_block_current_ = mcs_block_current;
   *mcs_block_current_ = 0;
   local_work_memory_ = core_memory->get_local_work_memory();
@@ -117,6 +130,89 @@ void Xct::issue_next_id(XctId max_xct_id, Epoch *epoch)  {
   }
 }
 
+void Xct::lock_hot_record(LockableXctId* owner_id_address) {
+  ASSERT_ND(active_);
+  ASSERT_ND(isolation_level_ == kSerializable);
+  // TASK(Hideaki) sequential search as pointer set. the hot lock set should be small, though.
+  for (uint32_t i = 0; i < hot_lock_set_size_; ++i) {
+    if (hot_lock_set_[i].owner_id_address_ == owner_id_address) {
+      return;  // already locked (or given up) in this transaction
+    }
+  }
+  if (UNLIKELY(hot_lock_set_size_ >= kMaxHotLocks)) {
+    DVLOG(1) << "Too many hot locks. Stays optimistic for the rest of this transaction";
+    return;
+  }
+
+  McsLock* lock = owner_id_address->get_key_lock();
+  McsBlockIndex block;
+  if (is_canonical_hot_lock_order(owner_id_address)) {
+    block = context_->mcs_acquire_lock_canonical(lock);
+  } else {
+    // might cause a deadlock if we wait. just try once.
+    block = context_->mcs_try_acquire_lock(lock);
+    if (block == 0) {
+      DVLOG(1) << "Failed to lock a hot record out of canonical order. Stays optimistic";
+      return;
+    }
+  }
+  ASSERT_ND(block != 0);
+  ASSERT_ND(owner_id_address->is_keylocked());
+  hot_lock_set_[hot_lock_set_size_].owner_id_address_ = owner_id_address;
+  hot_lock_set_[hot_lock_set_size_].mcs_block_ = block;
+  ++hot_lock_set_size_;
+  uintptr_t address = reinterpret_cast<uintptr_t>(owner_id_address);
+  if (hot_lock_set_size_ == 1U || address > hot_lock_max_address_) {
+    hot_lock_max_address_ = address;
+  }
+}
+
+bool Xct::is_hot_locked(const LockableXctId* owner_id_address) const {
+  for (uint32_t i = 0; i < hot_lock_set_size_; ++i) {
+    if (hot_lock_set_[i].owner_id_address_ == owner_id_address) {
+      return hot_lock_set_[i].mcs_block_ != 0;
+    }
+  }
+  return false;
+}
+
+McsBlockIndex Xct::take_over_hot_lock(const LockableXctId* owner_id_address) {
+  for (uint32_t i = 0; i < hot_lock_set_size_; ++i) {
+    if (hot_lock_set_[i].owner_id_address_ == owner_id_address) {
+      McsBlockIndex block = hot_lock_set_[i].mcs_block_;
+      hot_lock_set_[i].mcs_block_ = 0;
+      return block;
+    }
+  }
+  return 0;
+}
+
+void Xct::release_hot_lock(const McsLock* lock) {
+  for (uint32_t i = 0; i < hot_lock_set_size_; ++i) {
+    HotLockAccess& access = hot_lock_set_[i];
+    if (access.owner_id_address_->get_key_lock() == lock) {
+      if (access.mcs_block_ != 0) {
+        DVLOG(0) << "Giving up a hot lock to avoid self-deadlock";
+        context_->mcs_release_lock(access.owner_id_address_->get_key_lock(), access.mcs_block_);
+        access.mcs_block_ = 0;
+      }
+      return;
+    }
+  }
+}
+
+void Xct::release_hot_locks() {
+  for (uint32_t i = 0; i < hot_lock_set_size_; ++i) {
+    HotLockAccess& access = hot_lock_set_[i];
+    if (access.mcs_block_ != 0) {
+      context_->mcs_release_lock(access.owner_id_address_->get_key_lock(), access.mcs_block_);
+      access.mcs_block_ = 0;
+    }
+  }
+  hot_lock_set_size_ = 0;
+  hot_lock_max_address_ = 0;
+}
+
 std::ostream& operator<<(std::ostream& o, const Xct& v) {
   o << "<Xct>"
     << "<active_>" << v.is_active() << "</active_>";
@@ -126,6 +222,7 @@ std::ostream& operator<<(std::ostream& o, const Xct& v) {
       << "<write_set_size>" << v.get_write_set_size() << "</write_set_size>"
       << "<pointer_set_size>" << v.get_pointer_set_size() << "</pointer_set_size>"
       << "<page_version_set_size>" << v.get_page_version_set_size() << "</page_version_set_size>"
+      << "<hot_lock_set_size>" << v.get_hot_lock_set_size() << "</hot_lock_set_size>"
       << "<lock_free_write_set_size>" << v.get_lock_free_write_set_size()
         << "</lock_free_write_set_size>";
   }
@@ -76,5 +76,13 @@ std::ostream& operator<<(std::ostream& o, const LockFreeWriteXctAccess& v) {
   return o;
 }
 
+std::ostream& operator<<(std::ostream& o, const HotLockAccess& v) {
+  o << "<HotLockAccess>"
+    << "<record_address>" << v.owner_id_address_ << "</record_address>"
+    << "<mcs_block_>" << v.mcs_block_ << "</mcs_block_>"
+    << "</HotLockAccess>";
+  return o;
+}
+
 }  // namespace xct
 }  // namespace foedus
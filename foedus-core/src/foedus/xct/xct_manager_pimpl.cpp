@@ -31,6 +31,7 @@
 #include "foedus/assorted/atomic_fences.hpp"
 #include "foedus/assorted/cacheline.hpp"
 #include "foedus/cache/cache_manager.hpp"
+#include "foedus/debugging/rdtsc.hpp"
 #include "foedus/debugging/stop_watch.hpp"
 #include "foedus/log/log_manager.hpp"
 #include "foedus/log/log_type_invoke.hpp"
@@ -38,8 +39,11 @@
 #include "foedus/savepoint/savepoint.hpp"
 #include "foedus/savepoint/savepoint_manager.hpp"
 #include "foedus/soc/soc_manager.hpp"
+#include "foedus/storage/page.hpp"
 #include "foedus/storage/record.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/hash/hash_log_types.hpp"
+#include "foedus/storage/masstree/masstree_log_types.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
 #include "foedus/thread/thread_ref.hpp"
@@ -48,6 +52,7 @@
 #include "foedus/xct/xct_access.hpp"
 #include "foedus/xct/xct_manager.hpp"
 #include "foedus/xct/xct_options.hpp"
+#include "foedus/xct/xct_statistics.hpp"
 
 namespace foedus {
 namespace xct {
@@ -69,6 +74,18 @@ void        XctManager::advance_current_global_epoch() { pimpl_->advance_current
 ErrorCode   XctManager::wait_for_commit(Epoch commit_epoch, int64_t wait_microseconds) {
   return pimpl_->wait_for_commit(commit_epoch, wait_microseconds);
 }
+ErrorCode   XctManager::register_commit_callback(
+  thread::Thread* context,
+  Epoch commit_epoch,
+  CommitCallback callback,
+  void* user_data) {
+  // The commit notifier runs in each SOC engine. Route to the SOC of the worker.
+  XctManager* local = context->get_engine()->get_xct_manager();
+  if (local != this) {
+    return local->register_commit_callback(context, commit_epoch, callback, user_data);
+  }
+  return pimpl_->register_commit_callback(commit_epoch, callback, user_data);
+}
 
 ErrorCode   XctManager::begin_xct(thread::Thread* context, IsolationLevel isolation_level) {
   return pimpl_->begin_xct(context, isolation_level);
@@ -95,6 +112,11 @@ ErrorStack XctManagerPimpl::initialize_once() {
     control_block_->requested_global_epoch_ = control_block_->current_global_epoch_.load();
     control_block_->epoch_chime_terminate_requested_ = false;
     epoch_chime_thread_ = std::move(std::thread(&XctManagerPimpl::handle_epoch_chime, this));
+  } else {
+    commit_notifier_stop_requested_ = false;
+    commit_callbacks_count_ = 0;
+    commit_notifier_thread_ = std::move(
+      std::thread(&XctManagerPimpl::handle_commit_notifier, this));
   }
   return kRetOk;
 }
@@ -116,6 +138,10 @@ ErrorStack XctManagerPimpl::uninitialize_once() {
       epoch_chime_thread_.join();
     }
     control_block_->uninitialize();
+  } else if (commit_notifier_thread_.joinable()) {
+    commit_notifier_stop_requested_ = true;
+    commit_callbacks_registered_.notify_all();
+    commit_notifier_thread_.join();
   }
   return SUMMARIZE_ERROR_BATCH(batch);
 }
@@ -138,14 +164,21 @@ void XctManagerPimpl::handle_epoch_chime() {
     assorted::memory_fence_acquire();
   }
   uint64_t interval_microsec = engine_->get_options().xct_.epoch_advance_interval_ms_ * 1000ULL;
-  LOG(INFO) << "epoch_chime_thread now starts processing. interval_microsec=" << interval_microsec;
+  uint64_t min_interval_microsec
+    = engine_->get_options().xct_.epoch_advance_min_interval_ms_ * 1000ULL;
+  const bool adaptive = min_interval_microsec > 0 && min_interval_microsec < interval_microsec;
+  LOG(INFO) << "epoch_chime_thread now starts processing. interval_microsec=" << interval_microsec
+    << ", adaptive=" << adaptive << ", min_interval_microsec=" << min_interval_microsec;
   while (!is_stop_requested()) {
     {
       uint64_t demand = control_block_->epoch_chime_wakeup_.acquire_ticket();
       if (is_stop_requested()) {
         break;
       }
-      if (get_requested_global_epoch() <= get_current_global_epoch())  {  // otherwise no sleep
+      if (adaptive) {
+        handle_epoch_chime_wait_adaptive(interval_microsec, min_interval_microsec);
+      } else if (get_requested_global_epoch() <= get_current_global_epoch())  {
+        // otherwise no sleep
         bool signaled = control_block_->epoch_chime_wakeup_.timedwait(
           demand,
           interval_microsec,
@@ -181,6 +214,37 @@ void XctManagerPimpl::handle_epoch_chime() {
   LOG(INFO) << "epoch_chime_thread ended.";
 }
 
+void XctManagerPimpl::handle_epoch_chime_wait_adaptive(
+  uint64_t interval_microsec,
+  uint64_t min_interval_microsec) {
+  // We check the condition only after sleeping at least min_interval_microsec. Otherwise we
+  // would keep advancing epochs back-to-back while loggers have nothing to write.
+  for (uint64_t slept = 0; slept < interval_microsec; slept += min_interval_microsec) {
+    uint64_t demand = control_block_->epoch_chime_wakeup_.acquire_ticket();
+    if (is_stop_requested() || get_requested_global_epoch() > get_current_global_epoch()) {
+      return;
+    }
+    bool signaled = control_block_->epoch_chime_wakeup_.timedwait(
+      demand,
+      min_interval_microsec,
+      soc::kDefaultPollingSpins,
+      min_interval_microsec);
+    if (signaled || is_stop_requested()) {
+      return;
+    }
+    if (control_block_->commit_callbacks_pending_.load() > 0 && are_loggers_idle()) {
+      VLOG(1) << "epoch_chime_thread. commit callbacks are waiting on idle loggers. advance now";
+      return;
+    }
+  }
+}
+
+bool XctManagerPimpl::are_loggers_idle() const {
+  // Loggers can write out logs up to current-2 because current-1 is the grace epoch.
+  Epoch loggable_epoch = get_current_global_epoch().one_less().one_less();
+  return engine_->get_log_manager()->get_durable_global_epoch() >= loggable_epoch;
+}
+
 void XctManagerPimpl::handle_epoch_chime_wait_grace_period(Epoch grace_epoch) {
   ASSERT_ND(engine_->is_master());
   ASSERT_ND(grace_epoch.one_more() == get_current_global_epoch());
@@ -297,6 +361,106 @@ ErrorCode XctManagerPimpl::wait_for_commit(Epoch commit_epoch, int64_t wait_micr
   return engine_->get_log_manager()->wait_until_durable(commit_epoch, wait_microseconds);
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////
+///
+///       Commit Notifier related methods
+///
+////////////////////////////////////////////////////////////////////////////////////////////
+ErrorCode XctManagerPimpl::register_commit_callback(
+  Epoch commit_epoch,
+  CommitCallback callback,
+  void* user_data) {
+  ASSERT_ND(!engine_->is_master());
+  ASSERT_ND(commit_epoch.is_valid());
+  ASSERT_ND(callback);
+  PendingCommitCallback entry = {commit_epoch, callback, user_data};
+  bool was_empty;
+  {
+    // The notifier drains all callbacks after commit_notifier_stop_requested_ is set, taking
+    // this mutex. Checking the flag in the same critical section avoids leaking callbacks.
+    std::lock_guard<std::mutex> guard(commit_callbacks_mutex_);
+    if (commit_notifier_stop_requested_) {
+      return kErrorCodeXctCommitCallbackCancelled;
+    }
+    was_empty = commit_callbacks_.empty();
+    ++control_block_->commit_callbacks_pending_;
+    commit_callbacks_.push_back(entry);
+    std::push_heap(
+      commit_callbacks_.begin(),
+      commit_callbacks_.end(),
+      PendingCommitCallback::later_than);
+    ++commit_callbacks_count_;
+  }
+  if (was_empty) {
+    // the notifier might be sleeping because there was no callback
+    commit_callbacks_registered_.notify_one();
+  }
+  return kErrorCodeOk;
+}
+
+Epoch XctManagerPimpl::invoke_commit_callbacks(Epoch durable_epoch, ErrorCode result) {
+  std::vector<PendingCommitCallback> batch;
+  Epoch oldest_remaining;
+  {
+    std::lock_guard<std::mutex> guard(commit_callbacks_mutex_);
+    while (!commit_callbacks_.empty()) {
+      const PendingCommitCallback& oldest = commit_callbacks_.front();
+      if (durable_epoch.is_valid() && oldest.commit_epoch_ > durable_epoch) {
+        oldest_remaining = oldest.commit_epoch_;
+        break;
+      }
+      batch.push_back(oldest);
+      std::pop_heap(
+        commit_callbacks_.begin(),
+        commit_callbacks_.end(),
+        PendingCommitCallback::later_than);
+      commit_callbacks_.pop_back();
+    }
+    commit_callbacks_count_ -= batch.size();
+  }
+
+  // Invoke them out of the critical section so that workers can keep registering.
+  for (const PendingCommitCallback& entry : batch) {
+    entry.callback_(result, entry.commit_epoch_, entry.user_data_);
+  }
+  control_block_->commit_callbacks_pending_ -= batch.size();
+  if (!batch.empty()) {
+    DVLOG(1) << "Invoked " << batch.size() << " commit callbacks. durable_epoch=" << durable_epoch;
+  }
+  return oldest_remaining;
+}
+
+void XctManagerPimpl::handle_commit_notifier() {
+  LOG(INFO) << "commit_notifier_thread started.";
+  ASSERT_ND(!engine_->is_master());
+  SPINLOCK_WHILE(!commit_notifier_stop_requested_ && !is_initialized()) {
+    assorted::memory_fence_acquire();
+  }
+  // we anyway wake up this often to check commit_notifier_stop_requested_
+  const uint64_t kPollMicrosec = 100000ULL;
+  log::LogManager* log_manager = engine_->get_log_manager();
+  while (!commit_notifier_stop_requested_) {
+    Epoch durable_epoch = log_manager->get_durable_global_epoch();
+    Epoch oldest_remaining = invoke_commit_callbacks(durable_epoch, kErrorCodeOk);
+    if (commit_notifier_stop_requested_) {
+      break;
+    }
+    if (oldest_remaining.is_valid()) {
+      // Only this thread waits for the durable epoch on behalf of all workers in this SOC.
+      log_manager->wait_for_durable_global_epoch_advance(durable_epoch, kPollMicrosec);
+    } else {
+      commit_callbacks_registered_.wait_for(
+        std::chrono::microseconds(kPollMicrosec),
+        [this]{ return commit_callbacks_count_ > 0 || commit_notifier_stop_requested_; });
+    }
+  }
+
+  // Some of them might have become durable meanwhile. Others are cancelled.
+  invoke_commit_callbacks(log_manager->get_durable_global_epoch(), kErrorCodeOk);
+  invoke_commit_callbacks(Epoch(), kErrorCodeXctCommitCallbackCancelled);
+  LOG(INFO) << "commit_notifier_thread ended.";
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 ///
 ///       User transactions related methods
@@ -344,6 +508,7 @@ ErrorCode XctManagerPimpl::precommit_xct(thread::Thread* context, Epoch *commit_
   }
   ASSERT_ND(current_xct.assert_related_read_write());
 
+  const uint64_t started = debugging::get_rdtsc();
   bool success;
   bool read_only = context->get_current_xct().is_read_only();
   if (read_only) {
@@ -353,8 +518,16 @@ ErrorCode XctManagerPimpl::precommit_xct(thread::Thread* context, Epoch *commit_
   }
 
   ASSERT_ND(current_xct.assert_related_read_write());
+  current_xct.release_hot_locks();
   current_xct.deactivate();
+  XctStatistics& stat = context->get_xct_statistics();
+  stat.precommit_cycles_.add(debugging::get_rdtsc() - started);
   if (success) {
+    if (read_only) {
+      ++stat.committed_readonly_;
+    } else {
+      ++stat.committed_readwrite_;
+    }
     return kErrorCodeOk;
   } else {
     DLOG(WARNING) << *context << " Aborting because of contention";
@@ -421,6 +594,37 @@ bool XctManagerPimpl::precommit_xct_readwrite(thread::Thread* context, Epoch *co
 }
 
 
+/**
+ * A record verification failed. Make the page hotter so that following transactions
+ * lock records in the page during execution. See XctOptions::hot_threshold_.
+ */
+inline void increment_hotness(const LockableXctId* owner_id_address) {
+  storage::to_page(owner_id_address)->get_header().increment_hotness();
+}
+
+/**
+ * A blind write (eg increment_record_oneshot()) checked the payload length at execution time,
+ * but it has no read set on the record. Called under the record lock.
+ * @returns whether the record still has the payload range the write modifies.
+ */
+inline bool blind_write_fits_record(const WriteXctAccess* entry) {
+  switch (entry->log_entry_->header_.get_type()) {
+    case log::kLogCodeMasstreeIncrement:
+      return reinterpret_cast<const storage::masstree::MasstreeIncrementLogType*>(
+        entry->log_entry_)->fits_record(entry->owner_id_address_);
+    case log::kLogCodeHashIncrement:
+      return reinterpret_cast<const storage::hash::HashIncrementLogType*>(
+        entry->log_entry_)->fits_record(entry->owner_id_address_);
+    default:
+      return true;
+  }
+}
+
+/** Counts why this thread's precommit_xct() is about to fail. See XctStatistics. */
+inline void record_abort(thread::Thread* context, AbortReason reason) {
+  context->get_xct_statistics().record_abort(reason);
+}
+
 bool XctManagerPimpl::precommit_xct_lock_track_write(WriteXctAccess* entry) {
   ASSERT_ND(entry->owner_id_address_->needs_track_moved());
   storage::StorageManager* st = engine_->get_storage_manager();
@@ -492,6 +696,7 @@ bool XctManagerPimpl::precommit_xct_lock(thread::Thread* context, XctId* max_xct
       WriteXctAccess* entry = write_set + i;
       if (UNLIKELY(entry->owner_id_address_->needs_track_moved())) {
         if (!precommit_xct_lock_track_write(entry)) {
+          record_abort(context, kAbortReasonRecordMoved);
           return false;
         }
       }
@@ -544,8 +749,26 @@ bool XctManagerPimpl::precommit_xct_lock(thread::Thread* context, XctId* max_xct
           << ":" << entry->owner_id_address_
           << ". Will lock/unlock at the last one";
       } else {
-        entry->mcs_block_ = context->mcs_acquire_lock(
-          entry->owner_id_address_->get_key_lock());
+        // If we locked it during execution (hot record), the write set just takes it over.
+        entry->mcs_block_ = current_xct.take_over_hot_lock(entry->owner_id_address_);
+        if (entry->mcs_block_ != 0) {
+          DVLOG(1) << *context << " Took over a hot lock on "
+            << st->get_name(entry->storage_id_) << ":" << entry->owner_id_address_;
+        } else if (current_xct.is_canonical_hot_lock_order(entry->owner_id_address_)) {
+          entry->mcs_block_ = context->mcs_acquire_lock_canonical(
+            entry->owner_id_address_->get_key_lock());
+        } else {
+          // We retain a hot lock that comes after this record in the address order.
+          // Waiting for this lock might cause a deadlock, so we just try once.
+          entry->mcs_block_ = context->mcs_try_acquire_lock(
+            entry->owner_id_address_->get_key_lock());
+          if (entry->mcs_block_ == 0) {
+            DLOG(INFO) << *context << " Failed to lock a record out of canonical order. abort";
+            record_abort(context, kAbortReasonLockConflict);
+            precommit_xct_unlock(context);
+            return false;
+          }
+        }
         if (UNLIKELY(entry->owner_id_address_->needs_track_moved())) {
           VLOG(0) << *context << " Interesting. moved-bit conflict in "
             << st->get_name(entry->storage_id_)
@@ -560,6 +783,31 @@ bool XctManagerPimpl::precommit_xct_lock(thread::Thread* context, XctId* max_xct
         ASSERT_ND(!entry->owner_id_address_->is_next_layer());
         ASSERT_ND(entry->owner_id_address_->is_keylocked());
         max_xct_id->store_max(entry->owner_id_address_->xct_id_);
+
+        // A blind write (eg increment_record_oneshot()) has no related read set that confirms
+        // the record still exists with the same payload. If our first write on this record is
+        // such a write, we confirm it here under the lock. A concurrent delete followed by an
+        // insert might have left a shorter payload in the same slot.
+        const WriteXctAccess* first = entry;
+        while (first != write_set && (first - 1)->owner_id_address_ == entry->owner_id_address_) {
+          --first;
+        }
+        if (first->related_read_ == nullptr) {
+          if (entry->owner_id_address_->xct_id_.is_deleted()) {
+            DLOG(WARNING) << *context << " blind write to a concurrently deleted record. abort";
+            record_abort(context, kAbortReasonDeletedRecord);
+            precommit_xct_unlock(context);
+            return false;
+          }
+          for (const WriteXctAccess* cur = first; cur <= entry; ++cur) {
+            if (!blind_write_fits_record(cur)) {
+              DLOG(WARNING) << *context << " blind write to a concurrently shrunk record. abort";
+              record_abort(context, kAbortReasonDeletedRecord);
+              precommit_xct_unlock(context);
+              return false;
+            }
+          }
+        }
       }
 
       // If we have to abort, we should abort early to not waste time.
@@ -568,6 +816,8 @@ bool XctManagerPimpl::precommit_xct_lock(thread::Thread* context, XctId* max_xct
         ASSERT_ND(entry->related_read_->owner_id_address_ == entry->owner_id_address_);
         if (entry->owner_id_address_->xct_id_ != entry->related_read_->observed_owner_id_) {
           DLOG(WARNING) << *context << " related read set changed. abort early";
+          increment_hotness(entry->owner_id_address_);
+          record_abort(context, kAbortReasonReadSetChanged);
           precommit_xct_unlock(context);
           return false;
         }
@@ -611,11 +861,14 @@ bool XctManagerPimpl::precommit_xct_verify_readonly(thread::Thread* context, Epo
         << ", now_xid=" << access.owner_id_address_->xct_id_;
     if (UNLIKELY(access.owner_id_address_->needs_track_moved())) {
       if (!precommit_xct_verify_track_read(&access)) {
+        record_abort(context, kAbortReasonRecordMoved);
         return false;
       }
     }
     if (access.observed_owner_id_ != access.owner_id_address_->xct_id_) {
       DLOG(WARNING) << *context << " read set changed by other transaction. will abort";
+      increment_hotness(access.owner_id_address_);
+      record_abort(context, kAbortReasonReadSetChanged);
       return false;
     }
 
@@ -677,18 +930,25 @@ bool XctManagerPimpl::precommit_xct_verify_readwrite(thread::Thread* context, Xc
     // if the rare event (yet another concurrent split) happens, we just abort the transaction.
     if (UNLIKELY(access.owner_id_address_->needs_track_moved())) {
       if (!precommit_xct_verify_track_read(&access)) {
+        record_abort(context, kAbortReasonRecordMoved);
         return false;
       }
     }
 
     if (access.observed_owner_id_ != access.owner_id_address_->xct_id_) {
       DLOG(WARNING) << *context << " read set changed by other transaction. will abort";
+      increment_hotness(access.owner_id_address_);
+      record_abort(context, kAbortReasonReadSetChanged);
       return false;
     }
     max_xct_id->store_max(access.observed_owner_id_);
     if (access.owner_id_address_->is_keylocked()) {
       DVLOG(2) << *context
         << " read set contained a locked record. was it myself who locked it?";
+      if (current_xct.is_hot_locked(access.owner_id_address_)) {
+        DVLOG(2) << *context << " yes, we locked it during execution. go on.";
+        continue;
+      }
       // write set is sorted. so we can do binary search.
       WriteXctAccess dummy;
       dummy.owner_id_address_ = access.owner_id_address_;
@@ -711,6 +971,7 @@ bool XctManagerPimpl::precommit_xct_verify_readwrite(thread::Thread* context, Xc
 
       if (!found) {
         DLOG(WARNING) << *context << " no, not me. will abort";
+        record_abort(context, kAbortReasonLockConflict);
         return false;
       } else {
         DVLOG(2) << *context << " okay, myself. go on.";
@@ -742,6 +1003,7 @@ bool XctManagerPimpl::precommit_xct_verify_pointer_set(thread::Thread* context)
     const PointerAccess& access = pointer_set[i];
     if (access.address_->word !=  access.observed_.word) {
       DLOG(WARNING) << *context << " volatile ptr is changed by other transaction. will abort";
+      record_abort(context, kAbortReasonPointerSetChanged);
       return false;
     }
   }
@@ -762,6 +1024,7 @@ bool XctManagerPimpl::precommit_xct_verify_page_version_set(thread::Thread* cont
     if (access.address_->status_ != access.observed_) {
       DLOG(WARNING) << *context << " page version is changed by other transaction. will abort"
         " observed=" << access.observed_ << ", now=" << access.address_->status_;
+      record_abort(context, kAbortReasonPageVersionSetChanged);
       return false;
     }
   }
@@ -789,8 +1052,10 @@ void XctManagerPimpl::precommit_xct_apply(
   new_deleted_xct_id.set_deleted();  // used if the record after apply is in deleted state.
 
   DVLOG(1) << *context << " generated new xct id=" << new_xct_id;
+  XctStatistics& stat = context->get_xct_statistics();
   for (uint32_t i = 0; i < write_set_size; ++i) {
     WriteXctAccess& write = write_set[i];
+    stat.record_applied_log(write.log_entry_->header_.get_type());
     DVLOG(2) << *context << " Applying/Unlocking "
       << engine_->get_storage_manager()->get_name(write.storage_id_)
       << ":" << write.owner_id_address_;
@@ -849,6 +1114,7 @@ void XctManagerPimpl::precommit_xct_apply(
   // lock-free write-set doesn't have to worry about lock or ordering.
   for (uint32_t i = 0; i < lock_free_write_set_size; ++i) {
     LockFreeWriteXctAccess& write = lock_free_write_set[i];
+    stat.record_applied_log(write.log_entry_->header_.get_type());
     DVLOG(2) << *context << " Applying Lock-Free write "
       << engine_->get_storage_manager()->get_name(write.storage_id_);
     write.log_entry_->header_.set_xct_id(new_xct_id);
@@ -875,6 +1141,7 @@ void XctManagerPimpl::precommit_xct_unlock(thread::Thread* context) {
     }
   }
   assorted::memory_fence_release();
+  context->get_current_xct().release_hot_locks();
   DLOG(INFO) << *context << " unlocked write set without applying";
 }
 
@@ -884,6 +1151,8 @@ ErrorCode XctManagerPimpl::abort_xct(thread::Thread* context) {
     return kErrorCodeXctNoXct;
   }
   DVLOG(1) << *context << " Aborted transaction in thread-" << context->get_thread_id();
+  record_abort(context, kAbortReasonUser);
+  current_xct.release_hot_locks();
   current_xct.deactivate();
   context->get_thread_log_buffer().discard_current_xct_log();
   return kErrorCodeOk;
@@ -25,6 +25,8 @@ XctOptions::XctOptions() {
   max_lock_free_write_set_size_ = kDefaultMaxLockFreeWriteSetSize;
   local_work_memory_size_mb_ = kDefaultLocalWorkMemorySizeMb;
   epoch_advance_interval_ms_ = kDefaultEpochAdvanceIntervalMs;
+  epoch_advance_min_interval_ms_ = kDefaultEpochAdvanceMinIntervalMs;
+  hot_threshold_ = kDefaultHotThreshold;
 }
 
 ErrorStack XctOptions::load(tinyxml2::XMLElement* element) {
@@ -33,6 +35,8 @@ ErrorStack XctOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, max_lock_free_write_set_size_);
   EXTERNALIZE_LOAD_ELEMENT(element, local_work_memory_size_mb_);
   EXTERNALIZE_LOAD_ELEMENT(element, epoch_advance_interval_ms_);
+  EXTERNALIZE_LOAD_ELEMENT(element, epoch_advance_min_interval_ms_);
+  EXTERNALIZE_LOAD_ELEMENT(element, hot_threshold_);
   return kRetOk;
 }
 
@@ -58,6 +62,15 @@ ErrorStack XctOptions::save(tinyxml2::XMLElement* element) const {
     " out savepoint file for each non-empty epoch. However, too infrequent epoch advancement\n"
     " would increase the latency of queries because transactions are not deemed as commit"
     " until the epoch advances.");
+  EXTERNALIZE_SAVE_ELEMENT(element, epoch_advance_min_interval_ms_,
+    "Minimal intervals in milliseconds between adaptive epoch advancements. Default is 0,"
+    " which disables it.\n If positive and smaller than epoch_advance_interval_ms_, the epoch"
+    " advances early when commit callbacks are waiting and all loggers are idle.");
+  EXTERNALIZE_SAVE_ELEMENT(element, hot_threshold_,
+    "Page hotness above which serializable transactions lock records they write during"
+    " execution. Each abort due to a changed record increments the hotness of the page\n"
+    " that contains the record, and each snapshot halves it."
+    " 256 or larger (default) disables locking during execution.");
   return kRetOk;
 }
 
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/xct/xct_statistics.hpp"
+
+#include <ostream>
+
+namespace foedus {
+namespace xct {
+
+const char* get_abort_reason_name(AbortReason reason) {
+  switch (reason) {
+    case kAbortReasonReadSetChanged: return "read_set_changed";
+    case kAbortReasonRecordMoved: return "record_moved";
+    case kAbortReasonLockConflict: return "lock_conflict";
+    case kAbortReasonDeletedRecord: return "deleted_record";
+    case kAbortReasonPointerSetChanged: return "pointer_set_changed";
+    case kAbortReasonPageVersionSetChanged: return "page_version_set_changed";
+    case kAbortReasonUser: return "user";
+    default: return "UNKNOWN";
+  }
+}
+
+void XctStatistics::add(const XctStatistics& other) {
+  committed_readonly_ += other.committed_readonly_;
+  committed_readwrite_ += other.committed_readwrite_;
+  for (uint16_t i = 0; i < kAbortReasonCount; ++i) {
+    aborts_[i] += other.aborts_[i];
+  }
+  for (uint16_t i = 0; i < kLogCodeSlots; ++i) {
+    applied_logs_[i] += other.applied_logs_[i];
+  }
+  precommit_cycles_.merge(other.precommit_cycles_);
+}
+
+/** Record log codes are 0x00XX, so a slot that has a valid record log code is the code itself */
+inline bool is_record_log_slot(uint16_t slot) {
+  log::LogCode code = static_cast<log::LogCode>(slot);
+  return log::is_valid_log_type(code) && log::get_log_code_kind(code) == log::kRecordLogs;
+}
+
+std::ostream& operator<<(std::ostream& o, const XctStatistics& v) {
+  o << "<XctStatistics>"
+    << "<committed_readonly_>" << v.committed_readonly_ << "</committed_readonly_>"
+    << "<committed_readwrite_>" << v.committed_readwrite_ << "</committed_readwrite_>"
+    << "<aborts_ total=\"" << v.get_aborts() << "\">";
+  for (uint16_t i = 0; i < kAbortReasonCount; ++i) {
+    const char* name = get_abort_reason_name(static_cast<AbortReason>(i));
+    o << "<" << name << ">" << v.aborts_[i] << "</" << name << ">";
+  }
+  o << "</aborts_><applied_logs_>";
+  for (uint16_t i = 0; i < XctStatistics::kLogCodeSlots; ++i) {
+    if (v.applied_logs_[i] > 0 && is_record_log_slot(i)) {
+      const char* name = log::get_log_type_name(static_cast<log::LogCode>(i));
+      o << "<" << name << ">" << v.applied_logs_[i] << "</" << name << ">";
+    }
+  }
+  o << "</applied_logs_>"
+    << "<precommit_cycles_>" << v.precommit_cycles_ << "</precommit_cycles_>"
+    << "</XctStatistics>";
+  return o;
+}
+
+void XctStatistics::describe_json(std::ostream* o) const {
+  *o << "{\"committed_readonly\": " << committed_readonly_
+    << ", \"committed_readwrite\": " << committed_readwrite_
+    << ", \"aborts\": {\"total\": " << get_aborts();
+  for (uint16_t i = 0; i < kAbortReasonCount; ++i) {
+    *o << ", \"" << get_abort_reason_name(static_cast<AbortReason>(i)) << "\": " << aborts_[i];
+  }
+  *o << "}, \"applied_logs\": {";
+  bool first = true;
+  for (uint16_t i = 0; i < kLogCodeSlots; ++i) {
+    if (applied_logs_[i] > 0 && is_record_log_slot(i)) {
+      *o << (first ? "" : ", ") << "\""
+        << log::get_log_type_name(static_cast<log::LogCode>(i)) << "\": " << applied_logs_[i];
+      first = false;
+    }
+  }
+  *o << "}, \"precommit_cycles\": ";
+  precommit_cycles_.describe_json(o);
+  *o << "}";
+}
+
+}  // namespace xct
+}  // namespace foedus
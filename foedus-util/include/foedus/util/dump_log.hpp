@@ -42,6 +42,8 @@ namespace util {
   X(kNoEpochMarkerAtBeginning, "The log file does not start with epoch marker.")\
   X(kEpochMarkerDoesNotMatch, "From field of epoch marker is inconsistent")\
   X(kEpochMarkerIncorrectOffset, "Offset field of epoch marker is wrong")\
+  X(kCorruptedCompressedBlock, \
+    "A compressed block of logs could not be decompressed. A bug or corrupt log.")\
   X(kTooManyInconsistencies, "Too many inconsistencies found.")
 /**
  * Represents one inconsistency found in log files.
@@ -145,6 +147,12 @@ struct DumpLog {
     virtual void process(log::LogHeader *entry, uint64_t offset) = 0;
   };
   void parse_log_file(uint32_t file_index, ParserCallback* callback);
+  /** Decompresses the block and passes each log in it to the callback with the block's offset */
+  void parse_compressed_block(
+    uint32_t file_index,
+    uint64_t offset,
+    log::CompressedBlockLogType* block,
+    ParserCallback* callback);
 };
 
 }  // namespace util
@@ -21,6 +21,7 @@
 #include "foedus/fs/direct_io_file.hpp"
 #include "foedus/fs/filesystem.hpp"
 #include "foedus/log/common_log_types.hpp"
+#include "foedus/log/log_compression.hpp"
 #include "foedus/log/log_type.hpp"
 #include "foedus/log/log_type_invoke.hpp"
 #include "foedus/memory/aligned_memory.hpp"
@@ -28,6 +29,7 @@
 #include <stdint.h>
 #include <algorithm>
 #include <iostream>
+#include <vector>
 
 namespace foedus {
 namespace util {
@@ -215,6 +217,13 @@ void DumpLog::parse_log_file(uint32_t file_index, ParserCallback* callback) {
       }
 
       callback->process(header, cur_offset);
+      if (header->get_type() == log::kLogCodeCompressedBlock) {
+        parse_compressed_block(
+          file_index,
+          cur_offset,
+          reinterpret_cast<log::CompressedBlockLogType*>(header),
+          callback);
+      }
     } else {
       result_inconsistencies_.emplace_back(
         LogInconsistency(LogInconsistency::kMissingLogLength, file_index, cur_offset,
@@ -239,6 +248,48 @@ void DumpLog::parse_log_file(uint32_t file_index, ParserCallback* callback) {
   file.close();
 }
 
+void DumpLog::parse_compressed_block(
+  uint32_t file_index,
+  uint64_t offset,
+  log::CompressedBlockLogType* block,
+  ParserCallback* callback) {
+  std::vector<char> logs(block->raw_length_);
+  if (block->raw_length_ == 0
+    || block->raw_length_ > log::CompressedBlockLogType::kMaxRawSize
+    || block->header_.log_length_
+      < log::CompressedBlockLogType::calculate_log_length(block->compressed_length_)
+    || !log::decompress_log_block(
+      block->get_data(),
+      block->compressed_length_,
+      logs.data(),
+      block->raw_length_)) {
+    result_inconsistencies_.emplace_back(LogInconsistency(
+      LogInconsistency::kCorruptedCompressedBlock, file_index, offset, block->header_));
+    return;
+  }
+  for (uint32_t cur = 0; cur < block->raw_length_;) {
+    log::LogHeader* header = reinterpret_cast<log::LogHeader*>(logs.data() + cur);
+    if (header->log_length_ == 0
+      || header->log_length_ % 8 != 0
+      || cur + header->log_length_ > block->raw_length_) {
+      result_inconsistencies_.emplace_back(LogInconsistency(
+        LogInconsistency::kCorruptedCompressedBlock, file_index, offset, *header));
+      return;
+    }
+    if (!log::is_valid_log_type(header->get_type())) {
+      result_inconsistencies_.emplace_back(LogInconsistency(
+        LogInconsistency::kMissingLogTypeCode, file_index, offset, *header));
+    } else {
+      if (header->get_kind() == log::kRecordLogs && header->storage_id_ == 0) {
+        result_inconsistencies_.emplace_back(LogInconsistency(
+          LogInconsistency::kMissingStorageId, file_index, offset, *header));
+      }
+      callback->process(header, offset);
+    }
+    cur += header->log_length_;
+  }
+}
+
 std::ostream& operator<<(std::ostream& o, const LogInconsistency& v) {
   o << "<inconsistency"
     << " file_index=\"" << v.file_index_ << "\""
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/cache/cache_manager.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_cache_warm_start.cpp
+ * Warm-start of the snapshot cache from the manifest of hot pages written before restart.
+ */
+namespace foedus {
+namespace cache {
+DEFINE_TEST_CASE_PACKAGE(CacheWarmStartTest, foedus.cache);
+
+const storage::StorageName kName("test");
+// With 8-byte payloads, a few dozen leaf pages. They all fit in the tiny snapshot cache.
+const uint32_t kPayload = sizeof(uint64_t);
+const uint32_t kRecords = 4096;
+
+ErrorStack populate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint32_t offset = 0; offset < kRecords; ++offset) {
+    uint64_t value = offset * 3ULL;
+    WRAP_ERROR_CODE(array.overwrite_record_primitive<uint64_t>(context, offset, value, 0));
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack read_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSnapshot));
+  for (uint32_t offset = 0; offset < kRecords; ++offset) {
+    uint64_t value;
+    WRAP_ERROR_CODE(array.get_record_primitive<uint64_t>(context, offset, &value, 0));
+    EXPECT_EQ(offset * 3ULL, value) << offset;
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+/** Input is whether we expect warm-start */
+ErrorStack after_restart_task(const proc::ProcArguments& args) {
+  const bool warm_start = *reinterpret_cast<const bool*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  // the cache manager of the node this thread belongs to
+  CacheManager* cache_manager = args.engine_->get_cache_manager();
+  for (uint32_t i = 0; i < 10000U && !cache_manager->is_warm_start_done(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_TRUE(cache_manager->is_warm_start_done());
+  if (warm_start) {
+    EXPECT_GT(cache_manager->get_warm_start_page_count(), 0U);
+  } else {
+    EXPECT_EQ(0U, cache_manager->get_warm_start_page_count());
+  }
+
+  context->reset_snapshot_cache_counts();
+  CHECK_ERROR(read_task(args));
+  uint64_t hits = context->get_snapshot_cache_hits();
+  uint64_t misses = context->get_snapshot_cache_misses();
+  if (warm_start) {
+    // a few misses are possible because of the loose hashtable, but almost all should be hits.
+    EXPECT_LT(misses * 10U, hits) << misses;
+  } else {
+    EXPECT_GT(misses, 0U);
+  }
+  return kRetOk;
+}
+
+void test_warm_start(bool warm_start) {
+  EngineOptions options = get_tiny_options();
+  options.cache_.snapshot_cache_warm_start_ = warm_start;
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("populate_task", populate_task);
+    engine.get_proc_manager()->pre_register("read_task", read_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::array::ArrayStorage out;
+      storage::array::ArrayMetadata meta(kName, kPayload, kRecords);
+      // drop all volatile pages in the snapshot so that reads go through the snapshot cache
+      meta.snapshot_drop_volatile_pages_threshold_ = 0;
+      Epoch commit_epoch;
+      COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &out, &commit_epoch));
+      thread::ThreadPool* pool = engine.get_thread_pool();
+      COERCE_ERROR(pool->impersonate_synchronous("populate_task"));
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      COERCE_ERROR(pool->impersonate_synchronous("read_task"));
+      COERCE_ERROR(pool->impersonate_synchronous("read_task"));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("after_restart_task", after_restart_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      thread::ThreadPool* pool = engine.get_thread_pool();
+      COERCE_ERROR(pool->impersonate_synchronous(
+        "after_restart_task",
+        &warm_start,
+        sizeof(warm_start)));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+TEST(CacheWarmStartTest, WarmStart) { test_warm_start(true); }
+TEST(CacheWarmStartTest, Disabled) { test_warm_start(false); }
+
+}  // namespace cache
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(CacheWarmStartTest, foedus.cache);
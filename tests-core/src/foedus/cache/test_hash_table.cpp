@@ -224,6 +224,71 @@ TEST(HashTableTest, EvictLittleOverflow) { test_evict(12345, 2000); }
 // these take long time if run with the same scale. so, one tenth.
 TEST(HashTableTest, EvictManyOverflow) { test_evict(1234, 500); }
 TEST(HashTableTest, EvictMostlyOverflow) { test_evict(1234, 1000); }
+
+TEST(HashTableTest, ScanResistance) {
+  CacheHashtable hashtable(123456, 0);
+  const uint32_t kHotPages = 100;
+  const uint32_t kScanPages = 1000;
+  // a hot working set accessed a few times
+  for (uint32_t i = 0; i < kHotPages; ++i) {
+    storage::SnapshotPagePointer pointer = storage::to_snapshot_page_pointer(1, 0, i);
+    EXPECT_EQ(kErrorCodeOk, hashtable.install(pointer, i + 42));
+    for (uint32_t rep = 0; rep < 3U; ++rep) {
+      EXPECT_EQ(i + 42U, hashtable.find(pointer)) << i;
+    }
+  }
+  // a scan that touches each page only once
+  for (uint32_t i = 0; i < kScanPages; ++i) {
+    storage::SnapshotPagePointer pointer = storage::to_snapshot_page_pointer(2, 0, i);
+    EXPECT_EQ(kErrorCodeOk, hashtable.install(pointer, i + 42 + kHotPages, true));
+  }
+
+  uint32_t evicted[kHotPages + kScanPages];
+  CacheHashtable::EvictArgs args = { kScanPages, 0, evicted };
+  hashtable.evict(&args);
+  EXPECT_EQ(kScanPages, args.evicted_count_);
+  for (uint32_t i = 0; i < args.evicted_count_; ++i) {
+    EXPECT_LE(42U + kHotPages, evicted[i]) << i;  // only the scanned pages are evicted
+  }
+  for (uint32_t i = 0; i < kHotPages; ++i) {
+    storage::SnapshotPagePointer pointer = storage::to_snapshot_page_pointer(1, 0, i);
+    EXPECT_EQ(i + 42U, hashtable.find(pointer)) << i;
+  }
+  COERCE_ERROR(hashtable.verify_single_thread());
+}
+
+TEST(HashTableTest, GhostAdmission) {
+  CacheHashtable hashtable(123456, 0);
+  const uint32_t kNewPages = 100;
+  storage::SnapshotPagePointer ghost_pointer = storage::to_snapshot_page_pointer(1, 0, 12345);
+  EXPECT_EQ(kErrorCodeOk, hashtable.install(ghost_pointer, 42));
+
+  uint32_t evicted[kNewPages];
+  CacheHashtable::EvictArgs args = { 1, 0, evicted };
+  hashtable.evict(&args);
+  EXPECT_EQ(1U, args.evicted_count_);
+  EXPECT_EQ(42U, evicted[0]);
+  EXPECT_EQ(0U, hashtable.find(ghost_pointer));
+  EXPECT_EQ(0U, hashtable.get_ghost_admissions());
+
+  // re-requested soon after eviction. it is now protected better than new pages.
+  EXPECT_EQ(kErrorCodeOk, hashtable.install(ghost_pointer, 43));
+  EXPECT_EQ(1U, hashtable.get_ghost_admissions());
+  for (uint32_t i = 0; i < kNewPages; ++i) {
+    storage::SnapshotPagePointer pointer = storage::to_snapshot_page_pointer(2, 0, i);
+    EXPECT_EQ(kErrorCodeOk, hashtable.install(pointer, i + 100));
+  }
+  EXPECT_EQ(1U, hashtable.get_ghost_admissions());
+
+  args.target_count_ = kNewPages;
+  args.evicted_count_ = 0;
+  hashtable.evict(&args);
+  EXPECT_EQ(kNewPages, args.evicted_count_);
+  for (uint32_t i = 0; i < args.evicted_count_; ++i) {
+    EXPECT_NE(43U, evicted[i]) << i;
+  }
+  EXPECT_EQ(43U, hashtable.find(ghost_pointer));
+}
 }  // namespace cache
 }  // namespace foedus
 
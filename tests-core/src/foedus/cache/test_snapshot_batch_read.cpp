@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_page_impl.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_snapshot_batch_read.cpp
+ * Batched snapshot-page reads that keep several reads outstanding on cache misses.
+ */
+namespace foedus {
+namespace cache {
+DEFINE_TEST_CASE_PACKAGE(SnapshotBatchReadTest, foedus.cache);
+
+const storage::StorageName kName("test");
+// With 8-byte payloads, 1024 records fill several leaf pages under one interior page.
+const uint32_t kPayload = sizeof(uint64_t);
+const uint32_t kRecords = 1024;
+
+ErrorStack populate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint32_t offset = 0; offset < kRecords; ++offset) {
+    uint64_t value = offset * 3ULL;
+    WRAP_ERROR_CODE(array.overwrite_record_primitive<uint64_t>(context, offset, value, 0));
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack batch_read_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  storage::SnapshotPagePointer root_id = array.get_array_metadata()->root_snapshot_page_id_;
+  EXPECT_NE(0U, root_id);
+  storage::Page* root_page;
+  WRAP_ERROR_CODE(context->find_or_read_a_snapshot_page(root_id, &root_page));
+  storage::array::ArrayPage* parent = reinterpret_cast<storage::array::ArrayPage*>(root_page);
+  EXPECT_FALSE(parent->is_leaf());
+  // the root might have only a few children. go down to the left-most page above leaves.
+  while (parent->get_level() > 1U) {
+    storage::Page* child_page;
+    WRAP_ERROR_CODE(context->find_or_read_a_snapshot_page(
+      parent->get_interior_record(0).snapshot_pointer_,
+      &child_page));
+    parent = reinterpret_cast<storage::array::ArrayPage*>(child_page);
+  }
+
+  // leaf pages under it, plus a null pointer and a duplicate in the middle.
+  storage::SnapshotPagePointer ids[thread::Thread::kMaxFindPagesBatch];
+  uint16_t count = 0;
+  for (uint16_t i = 0; i < storage::array::kInteriorFanout; ++i) {
+    storage::SnapshotPagePointer child = parent->get_interior_record(i).snapshot_pointer_;
+    if (child == 0) {
+      break;
+    }
+    ids[count] = child;
+    ++count;
+    if (count == 3U) {
+      ids[count] = child;
+      ++count;
+      ids[count] = 0;
+      ++count;
+    }
+    if (count + 3U > thread::Thread::kMaxFindPagesBatch) {
+      break;
+    }
+  }
+  EXPECT_GT(count, 5U);
+
+  storage::Page* pages[thread::Thread::kMaxFindPagesBatch];
+  WRAP_ERROR_CODE(context->find_or_read_snapshot_pages_batch(count, ids, pages));
+  for (uint16_t b = 0; b < count; ++b) {
+    if (ids[b] == 0) {
+      EXPECT_TRUE(pages[b] == nullptr) << b;
+      continue;
+    }
+    EXPECT_TRUE(pages[b] != nullptr) << b;
+    EXPECT_EQ(ids[b], pages[b]->get_header().page_id_) << b;
+    EXPECT_TRUE(pages[b]->get_header().snapshot_) << b;
+  }
+  EXPECT_EQ(pages[2], pages[3]);
+
+  // now they are cached. we should get the same pages from the cache.
+  storage::Page* again[thread::Thread::kMaxFindPagesBatch];
+  WRAP_ERROR_CODE(context->find_or_read_snapshot_pages_batch(count, ids, again));
+  for (uint16_t b = 0; b < count; ++b) {
+    EXPECT_EQ(pages[b], again[b]) << b;
+  }
+  return kRetOk;
+}
+
+ErrorStack prefetch_verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  WRAP_ERROR_CODE(array.prefetch_pages(context, false, true, 0, kRecords));
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSnapshot));
+  for (uint32_t offset = 0; offset < kRecords; ++offset) {
+    uint64_t value;
+    WRAP_ERROR_CODE(array.get_record_primitive<uint64_t>(context, offset, &value, 0));
+    EXPECT_EQ(offset * 3ULL, value) << offset;
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+void test_batch_read(const char* task) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("populate_task", populate_task);
+  engine.get_proc_manager()->pre_register("batch_read_task", batch_read_task);
+  engine.get_proc_manager()->pre_register("prefetch_verify_task", prefetch_verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::array::ArrayStorage out;
+    storage::array::ArrayMetadata meta(kName, kPayload, kRecords);
+    Epoch commit_epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &out, &commit_epoch));
+    thread::ThreadPool* pool = engine.get_thread_pool();
+    COERCE_ERROR(pool->impersonate_synchronous("populate_task"));
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    COERCE_ERROR(pool->impersonate_synchronous(task));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(SnapshotBatchReadTest, BatchRead) { test_batch_read("batch_read_task"); }
+TEST(SnapshotBatchReadTest, Prefetch) { test_batch_read("prefetch_verify_task"); }
+
+}  // namespace cache
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(SnapshotBatchReadTest, foedus.cache);
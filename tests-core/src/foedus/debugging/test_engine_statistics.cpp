@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/debugging/engine_statistics.hpp"
+#include "foedus/debugging/latency_histogram.hpp"
+#include "foedus/log/log_type.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+#include "foedus/xct/xct_statistics.hpp"
+
+/**
+ * @file test_engine_statistics.cpp
+ * Statistics counters of threads and loggers, and their aggregation in EngineStatistics.
+ */
+namespace foedus {
+namespace debugging {
+DEFINE_TEST_CASE_PACKAGE(EngineStatisticsTest, foedus.debugging);
+
+const uint32_t kRecords = 16;
+const uint32_t kReadWrites = 10;
+const uint32_t kReadOnlys = 5;
+const uint32_t kUserAborts = 3;
+
+TEST(EngineStatisticsTest, Histogram) {
+  for (uint64_t value = 0; value < 100000ULL; ++value) {
+    uint16_t bucket = LatencyHistogram::to_bucket(value);
+    EXPECT_LE(LatencyHistogram::get_bucket_lower_bound(bucket), value) << value;
+    EXPECT_GT(LatencyHistogram::get_bucket_lower_bound(bucket + 1U), value) << value;
+  }
+  EXPECT_EQ(LatencyHistogram::kBuckets - 1, LatencyHistogram::to_bucket(0xFFFFFFFFFFFFFFFFULL));
+
+  LatencyHistogram histogram;
+  histogram.reset();
+  EXPECT_EQ(0U, histogram.get_percentile(50));
+  for (uint64_t value = 1; value <= 1000U; ++value) {
+    histogram.add(value);
+  }
+  EXPECT_EQ(1000U, histogram.get_count());
+  EXPECT_EQ(1000U, histogram.get_max());
+  EXPECT_DOUBLE_EQ(500.5, histogram.get_average());
+  // buckets are at most 25% wide
+  EXPECT_GE(histogram.get_percentile(50), 500U);
+  EXPECT_LE(histogram.get_percentile(50), 625U);
+  EXPECT_GE(histogram.get_percentile(99), 990U);
+  EXPECT_LE(histogram.get_percentile(99), 1000U);
+  EXPECT_EQ(1000U, histogram.get_percentile(100));
+
+  LatencyHistogram other;
+  other.reset();
+  other.add(5000U);
+  histogram.merge(other);
+  EXPECT_EQ(1001U, histogram.get_count());
+  EXPECT_EQ(5000U, histogram.get_max());
+}
+
+ErrorStack workload_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  storage::array::ArrayStorage array(args.engine_, "test");
+  Epoch commit_epoch;
+  for (uint32_t i = 0; i < kReadWrites; ++i) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    uint64_t data = i;
+    WRAP_ERROR_CODE(array.overwrite_record(context, i % kRecords, &data));
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  for (uint32_t i = 0; i < kReadOnlys; ++i) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    uint64_t data;
+    WRAP_ERROR_CODE(array.get_record(context, i % kRecords, &data));
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  for (uint32_t i = 0; i < kUserAborts; ++i) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    WRAP_ERROR_CODE(xct_manager->abort_xct(context));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+
+  // this thread's own counters
+  const xct::XctStatistics& stat = context->get_xct_statistics();
+  EXPECT_EQ(kReadWrites, stat.committed_readwrite_);
+  EXPECT_EQ(kReadOnlys, stat.committed_readonly_);
+  EXPECT_EQ(kUserAborts, stat.aborts_[xct::kAbortReasonUser]);
+  EXPECT_EQ(kUserAborts, stat.get_aborts());
+  return kRetOk;
+}
+
+TEST(EngineStatisticsTest, Collect) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("workload_task", workload_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::array::ArrayStorage out;
+    storage::array::ArrayMetadata meta("test", sizeof(uint64_t), kRecords);
+    Epoch commit_epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &out, &commit_epoch));
+
+    EngineStatistics before;
+    before.collect(&engine);
+    EXPECT_EQ(options.thread_.get_total_thread_count(), before.thread_count_);
+    EXPECT_EQ(0U, before.xct_.get_commits());
+
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("workload_task"));
+
+    EngineStatistics after;
+    after.collect(&engine);
+    EXPECT_EQ(kReadWrites, after.xct_.committed_readwrite_);
+    EXPECT_EQ(kReadOnlys, after.xct_.committed_readonly_);
+    EXPECT_EQ(kUserAborts, after.xct_.aborts_[xct::kAbortReasonUser]);
+    EXPECT_EQ(kUserAborts, after.xct_.get_aborts());
+    EXPECT_EQ(
+      kReadWrites,
+      after.xct_.applied_logs_[log::kLogCodeArrayOverwrite % xct::XctStatistics::kLogCodeSlots]);
+    EXPECT_EQ(kReadWrites + kReadOnlys, after.xct_.precommit_cycles_.get_count());
+    EXPECT_GT(after.logger_count_, 0U);
+    EXPECT_GT(after.log_written_bytes_, before.log_written_bytes_);
+    EXPECT_GT(after.log_fsyncs_, before.log_fsyncs_);
+    EXPECT_EQ(after.log_fsyncs_, after.log_fsync_latency_ns_.get_count());
+
+    std::stringstream xml;
+    xml << after;
+    std::cout << xml.str() << std::endl;
+    EXPECT_NE(std::string::npos, xml.str().find("<kLogCodeArrayOverwrite>10<"));
+    std::stringstream json;
+    after.describe_json(&json);
+    std::cout << json.str() << std::endl;
+    EXPECT_NE(std::string::npos, json.str().find("\"committed_readwrite\": 10"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+}  // namespace debugging
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(EngineStatisticsTest, foedus.debugging);
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/log/change_stream.hpp"
+#include "foedus/log/common_log_types.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/log/log_type.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_log_types.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_change_stream.cpp
+ * ChangeStream, which follows committed record logs of a storage in durable log files.
+ */
+namespace foedus {
+namespace log {
+DEFINE_TEST_CASE_PACKAGE(ChangeStreamTest, foedus.log);
+
+const uint32_t kRecords = 128;
+const uint32_t kThreads = 2;
+const storage::StorageName kName("test");
+const storage::StorageName kOtherName("other");
+const ChangeStreamId kFilteredStream = 3;
+const ChangeStreamId kAllStream = 5;
+
+struct WriteInput {
+  uint32_t  id_;
+  uint32_t  batch_;
+};
+
+/** We embed the batch, the thread, and the offset in each payload. */
+uint64_t to_value(uint32_t batch, uint32_t id, uint64_t offset) {
+  return (static_cast<uint64_t>(batch) << 32) | (static_cast<uint64_t>(id) << 16) | offset;
+}
+
+ErrorStack write_task(const proc::ProcArguments& args) {
+  const WriteInput* input = reinterpret_cast<const WriteInput*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  storage::array::ArrayStorage other(args.engine_, kOtherName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  // a few records per xct so that changes span several xcts and maybe several epochs.
+  for (uint64_t i = 0; i < kRecords; i += 8U) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint64_t offset = i; offset < i + 8U; ++offset) {
+      uint64_t data = to_value(input->batch_, input->id_, offset);
+      WRAP_ERROR_CODE(array.overwrite_record(context, offset, &data, 0, sizeof(data)));
+    }
+    WRAP_ERROR_CODE(other.overwrite_record(context, input->id_, &i, 0, sizeof(i)));
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+/** Runs the proc on each core (thus each logger). */
+void write_on_each_core(Engine* engine, uint32_t batch) {
+  thread::ThreadPool* pool = engine->get_thread_pool();
+  for (uint32_t i = 0; i < kThreads; ++i) {
+    WriteInput input = {i, batch};
+    COERCE_ERROR(pool->impersonate_on_numa_core_synchronous(i, "write", &input, sizeof(input)));
+  }
+}
+
+/** Fetches up to the current durable epoch and verifies the changes. */
+void fetch_all(
+  Engine* engine,
+  storage::StorageId test_id,
+  ChangeStream* stream,
+  uint32_t expected_batch,
+  uint32_t* test_changes,
+  uint32_t* other_changes) {
+  const Epoch durable_epoch = engine->get_log_manager()->get_durable_global_epoch();
+  *test_changes = 0;
+  *other_changes = 0;
+  xct::XctId prev_xct_id;
+  while (stream->get_fetched_epoch() < durable_epoch) {
+    const Epoch prev_fetched = stream->get_fetched_epoch();
+    // a few epochs at a time to test continuation
+    COERCE_ERROR(stream->fetch(2));
+    EXPECT_GT(stream->get_fetched_epoch(), prev_fetched);
+    for (uint32_t i = 0; i < stream->get_change_count(); ++i) {
+      const RecordLogType* change = stream->get_change(i);
+      const xct::XctId& xct_id = change->header_.xct_id_;
+      EXPECT_GT(xct_id.get_epoch(), prev_fetched) << i;
+      EXPECT_LE(xct_id.get_epoch(), stream->get_fetched_epoch()) << i;
+      if (prev_xct_id.is_valid()) {
+        EXPECT_FALSE(xct_id.before(prev_xct_id)) << i;
+      }
+      prev_xct_id = xct_id;
+      EXPECT_EQ(kLogCodeArrayOverwrite, change->header_.get_type()) << i;
+      const storage::array::ArrayOverwriteLogType* log
+        = reinterpret_cast<const storage::array::ArrayOverwriteLogType*>(change);
+      if (change->header_.storage_id_ != test_id) {
+        ++(*other_changes);
+        continue;
+      }
+      uint64_t value;
+      std::memcpy(&value, log->payload_, sizeof(value));
+      EXPECT_EQ(log->offset_, value & 0xFFFFU) << i;
+      EXPECT_GE(value >> 32, expected_batch) << i;
+      ++(*test_changes);
+    }
+  }
+}
+
+void test_change_stream(bool compress_logs) {
+  EngineOptions options = get_tiny_options();
+  options.thread_.thread_count_per_group_ = kThreads;
+  options.log_.loggers_per_node_ = kThreads;
+  options.log_.compress_logs_ = compress_logs;
+  options.restart_.enable_log_replay_ = true;
+  storage::StorageId test_id;
+  Epoch acked_epoch;
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("write", write_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::array::ArrayStorage out;
+      Epoch commit_epoch;
+      storage::array::ArrayMetadata meta(kName, sizeof(uint64_t), kRecords);
+      COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &out, &commit_epoch));
+      test_id = out.get_id();
+      storage::array::ArrayMetadata other_meta(kOtherName, sizeof(uint64_t), kThreads);
+      COERCE_ERROR(engine.get_storage_manager()->create_array(&other_meta, &out, &commit_epoch));
+      write_on_each_core(&engine, 0);
+
+      LogManager* log_manager = engine.get_log_manager();
+      EXPECT_FALSE(log_manager->get_change_stream_cursor(kFilteredStream).is_valid());
+      ChangeStream filtered(&engine, kFilteredStream, test_id);
+      uint32_t test_changes;
+      uint32_t other_changes;
+      fetch_all(&engine, test_id, &filtered, 0, &test_changes, &other_changes);
+      EXPECT_EQ(kRecords * kThreads, test_changes);
+      EXPECT_EQ(0U, other_changes);
+
+      ChangeStream all(&engine, kAllStream);
+      fetch_all(&engine, test_id, &all, 0, &test_changes, &other_changes);
+      EXPECT_EQ(kRecords * kThreads, test_changes);
+      EXPECT_EQ(kRecords * kThreads / 8U, other_changes);
+
+      // nothing new. the durable epoch might have advanced without logs, though.
+      const Epoch fetched = filtered.get_fetched_epoch();
+      COERCE_ERROR(filtered.fetch());
+      EXPECT_GE(filtered.get_fetched_epoch(), fetched);
+      EXPECT_EQ(0U, filtered.get_change_count());
+
+      // only the filtered stream acknowledges. the next writes take a savepoint with it.
+      filtered.ack();
+      acked_epoch = filtered.get_fetched_epoch();
+      EXPECT_EQ(acked_epoch, log_manager->get_change_stream_cursor(kFilteredStream));
+      EXPECT_FALSE(log_manager->get_change_stream_cursor(kAllStream).is_valid());
+      write_on_each_core(&engine, 1);
+
+      // a new stream in the same run resumes from the acknowledged epoch, too
+      ChangeStream resumed(&engine, kFilteredStream, test_id);
+      EXPECT_EQ(acked_epoch, resumed.get_fetched_epoch());
+      fetch_all(&engine, test_id, &resumed, 1, &test_changes, &other_changes);
+      EXPECT_EQ(kRecords * kThreads, test_changes);
+      EXPECT_EQ(0U, other_changes);
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  {
+    Engine engine(options);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      LogManager* log_manager = engine.get_log_manager();
+      EXPECT_EQ(acked_epoch, log_manager->get_change_stream_cursor(kFilteredStream));
+
+      // the filtered stream resumes from the acknowledged epoch
+      ChangeStream filtered(&engine, kFilteredStream, test_id);
+      EXPECT_EQ(acked_epoch, filtered.get_fetched_epoch());
+      uint32_t test_changes;
+      uint32_t other_changes;
+      fetch_all(&engine, test_id, &filtered, 1, &test_changes, &other_changes);
+      EXPECT_EQ(kRecords * kThreads, test_changes);
+      EXPECT_EQ(0U, other_changes);
+
+      // the other stream never acknowledged, so it receives everything again
+      ChangeStream all(&engine, kAllStream);
+      fetch_all(&engine, test_id, &all, 0, &test_changes, &other_changes);
+      EXPECT_EQ(kRecords * kThreads * 2U, test_changes);
+      EXPECT_EQ(kRecords * kThreads * 2U / 8U, other_changes);
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+TEST(ChangeStreamTest, Array) { test_change_stream(false); }
+TEST(ChangeStreamTest, ArrayCompressed) { test_change_stream(true); }
+
+}  // namespace log
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(ChangeStreamTest, foedus.log);
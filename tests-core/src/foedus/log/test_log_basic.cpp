@@ -90,8 +90,9 @@ ErrorStack test_write_log(const proc::ProcArguments& args) {
   return kRetOk;
 }
 
-TEST(LogBasicTest, WriteLog) {
+void test_write_log_device(LogDeviceType device_type) {
   EngineOptions options = get_tiny_options();
+  options.log_.device_type_ = device_type;
   Engine engine(options);
   engine.get_proc_manager()->pre_register(proc::ProcAndName("test_write_log", test_write_log));
   COERCE_ERROR(engine.initialize());
@@ -103,6 +104,9 @@ TEST(LogBasicTest, WriteLog) {
   cleanup_test(options);
 }
 
+TEST(LogBasicTest, WriteLog) { test_write_log_device(kLogDeviceDirectIo); }
+TEST(LogBasicTest, WriteLogPmem) { test_write_log_device(kLogDevicePmem); }
+
 ErrorStack test_buffer_wrap_around(const proc::ProcArguments& args) {
   thread::Thread* context = args.context_;
   xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
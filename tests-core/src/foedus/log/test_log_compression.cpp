@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <cstring>
+#include <vector>
+
+#include "foedus/test_common.hpp"
+#include "foedus/assorted/uniform_random.hpp"
+#include "foedus/log/common_log_types.hpp"
+#include "foedus/log/log_compression.hpp"
+/**
+ * @file test_log_compression.cpp
+ * Testcases for the block codec loggers use to compress logs.
+ */
+namespace foedus {
+namespace log {
+DEFINE_TEST_CASE_PACKAGE(LogCompressionTest, foedus.log);
+
+const uint32_t kBlockSize = CompressedBlockLogType::kMaxRawSize;
+
+/** Compresses, decompresses, and checks the result. @return compressed size */
+uint32_t round_trip(const std::vector<char>& raw) {
+  const uint32_t raw_size = raw.size();
+  std::vector<char> compressed(raw_size * 2U + 64U);
+  uint32_t compressed_size = compress_log_block(
+    raw.data(),
+    raw_size,
+    compressed.data(),
+    compressed.size());
+  EXPECT_GT(compressed_size, 0U);
+  std::vector<char> decompressed(raw_size + 1U);
+  EXPECT_TRUE(decompress_log_block(
+    compressed.data(),
+    compressed_size,
+    decompressed.data(),
+    raw_size));
+  EXPECT_EQ(0, std::memcmp(raw.data(), decompressed.data(), raw_size));
+  return compressed_size;
+}
+
+TEST(LogCompressionTest, Empty) {
+  std::vector<char> raw;
+  round_trip(raw);
+}
+
+TEST(LogCompressionTest, Repetitive) {
+  // something like a series of overwrite logs on consecutive keys
+  std::vector<char> raw(kBlockSize);
+  for (uint32_t i = 0; i < kBlockSize / 8U; ++i) {
+    uint64_t value = (i % 4U == 0) ? (0x12340000ULL | (i / 4U)) : 0x0022003000000005ULL;
+    std::memcpy(raw.data() + i * 8U, &value, sizeof(value));
+  }
+  uint32_t compressed_size = round_trip(raw);
+  EXPECT_LT(compressed_size, kBlockSize / 4U);
+}
+
+TEST(LogCompressionTest, Random) {
+  assorted::UniformRandom rnd(1234);
+  for (uint32_t size = 1; size <= kBlockSize; size *= 3U) {
+    std::vector<char> raw(size);
+    for (uint32_t i = 0; i < size; ++i) {
+      raw[i] = static_cast<char>(rnd.next_uint32());
+    }
+    round_trip(raw);
+  }
+}
+
+TEST(LogCompressionTest, NoRoom) {
+  assorted::UniformRandom rnd(1234);
+  std::vector<char> raw(kBlockSize);
+  for (uint32_t i = 0; i < kBlockSize; ++i) {
+    raw[i] = static_cast<char>(rnd.next_uint32());
+  }
+  // random data never shrinks. the logger then writes out the raw logs.
+  std::vector<char> compressed(kBlockSize);
+  EXPECT_EQ(0U, compress_log_block(raw.data(), kBlockSize, compressed.data(), kBlockSize));
+}
+
+TEST(LogCompressionTest, Corrupted) {
+  std::vector<char> raw(kBlockSize, 'a');
+  std::vector<char> compressed(kBlockSize);
+  uint32_t compressed_size = compress_log_block(
+    raw.data(),
+    kBlockSize,
+    compressed.data(),
+    kBlockSize);
+  EXPECT_GT(compressed_size, 0U);
+  std::vector<char> decompressed(kBlockSize);
+  // wrong raw size
+  EXPECT_FALSE(decompress_log_block(
+    compressed.data(),
+    compressed_size,
+    decompressed.data(),
+    kBlockSize - 8U));
+  // truncated
+  EXPECT_FALSE(decompress_log_block(
+    compressed.data(),
+    compressed_size - 1U,
+    decompressed.data(),
+    kBlockSize));
+}
+
+}  // namespace log
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(LogCompressionTest, foedus.log);
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/debugging/engine_statistics.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/log/log_options.hpp"
+#include "foedus/log/logger_ref.hpp"
+#include "foedus/log/thread_log_buffer.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_logger_work_stealing.cpp
+ * Skewed logging with two loggers in a node. The threads of logger-0 write most of the logs,
+ * so logger-1 might steal their buffers. Logs must stay durable and replayable wherever they go.
+ */
+namespace foedus {
+namespace log {
+DEFINE_TEST_CASE_PACKAGE(LoggerWorkStealingTest, foedus.log);
+
+const uint32_t kThreads = 4;
+const uint32_t kLoggers = 2;
+const uint32_t kRecords = 1024;
+const uint32_t kHeavyRounds = 200;
+const uint32_t kLightRounds = 2;
+const storage::StorageName kName("test");
+
+/** Threads 0 and 1 are assigned to logger-0, and they are the heavy ones. */
+uint32_t get_rounds(uint32_t id) { return id < kThreads / kLoggers ? kHeavyRounds : kLightRounds; }
+
+EngineOptions get_stealing_options(bool stealing) {
+  EngineOptions options = get_tiny_options();
+  options.thread_.thread_count_per_group_ = kThreads;
+  options.log_.loggers_per_node_ = kLoggers;
+  options.log_.logger_work_stealing_ = stealing;
+  options.restart_.enable_log_replay_ = true;
+  return options;
+}
+
+/** Output is the number of bytes this thread put in its log buffer, including fillers */
+ErrorStack write_task(const proc::ProcArguments& args) {
+  uint32_t id = *reinterpret_cast<const uint32_t*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  const ThreadLogBufferMeta& meta = context->get_thread_log_buffer().get_meta();
+  uint64_t log_bytes = 0;
+  Epoch commit_epoch;
+  // each thread overwrites its own records. no conflicts.
+  for (uint32_t round = 0; round < get_rounds(id); ++round) {
+    const uint64_t tail_before = meta.offset_tail_;
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint64_t i = id; i < kRecords; i += kThreads) {
+      uint64_t data = round * kRecords + i;
+      WRAP_ERROR_CODE(array.overwrite_record(context, i, &data));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+    // one transaction is much smaller than the circular buffer
+    log_bytes += (meta.offset_tail_ + meta.buffer_size_ - tail_before) % meta.buffer_size_;
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  EXPECT_GE(args.engine_->get_log_manager()->get_durable_global_epoch(), commit_epoch);
+  *reinterpret_cast<uint64_t*>(args.output_buffer_) = log_bytes;
+  *args.output_used_ = sizeof(log_bytes);
+  return kRetOk;
+}
+
+ErrorStack verify_task(const proc::ProcArguments& args) {
+  xct::IsolationLevel isolation = *reinterpret_cast<const xct::IsolationLevel*>(
+    args.input_buffer_);
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, isolation));
+  for (uint64_t i = 0; i < kRecords; ++i) {
+    uint64_t data;
+    WRAP_ERROR_CODE(array.get_record(context, i, &data));
+    EXPECT_EQ((get_rounds(i % kThreads) - 1U) * kRecords + i, data) << i;
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+void test_skewed(bool stealing, bool take_snapshot) {
+  EngineOptions options = get_stealing_options(stealing);
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("write", write_task);
+    engine.get_proc_manager()->pre_register("verify", verify_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::array::ArrayStorage out;
+      Epoch commit_epoch;
+      storage::array::ArrayMetadata meta(kName, sizeof(uint64_t), kRecords);
+      COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &out, &commit_epoch));
+
+      thread::ThreadPool* pool = engine.get_thread_pool();
+      std::vector<thread::ImpersonateSession> sessions;
+      for (uint32_t i = 0; i < kThreads; ++i) {
+        thread::ImpersonateSession session;
+        EXPECT_TRUE(pool->impersonate_on_numa_core(i, "write", &i, sizeof(i), &session));
+        sessions.emplace_back(std::move(session));
+      }
+      uint64_t total_log_bytes = 0;
+      for (uint32_t i = 0; i < kThreads; ++i) {
+        COERCE_ERROR(sessions[i].get_result());
+        uint64_t log_bytes;
+        EXPECT_EQ(sizeof(log_bytes), sessions[i].get_output_size());
+        sessions[i].get_output(&log_bytes);
+        total_log_bytes += log_bytes;
+        sessions[i].release();
+      }
+
+      debugging::EngineStatistics stat;
+      stat.collect(&engine);
+      EXPECT_EQ(kLoggers, stat.logger_count_);
+      // Whether and how much logger-1 steals depends on timing, but every byte in the
+      // thread log buffers must be written out by exactly one logger.
+      EXPECT_EQ(total_log_bytes, stat.log_raw_bytes_);
+      EXPECT_GE(stat.log_raw_bytes_, stat.log_stolen_bytes_);
+      EXPECT_GE(stat.log_max_epoch_lag_, 2U);  // loggers never write the current/grace epoch
+      if (!stealing) {
+        EXPECT_EQ(0U, stat.log_stolen_bytes_);
+      }
+      for (LoggerId id = 0; id < kLoggers; ++id) {
+        LoggerRef logger = engine.get_log_manager()->get_logger(id);
+        LOG(INFO) << "Logger-" << id << ": raw_bytes=" << logger.get_stat_raw_log_bytes()
+          << ", stolen_bytes=" << logger.get_stat_stolen_log_bytes()
+          << ", max_epoch_lag=" << logger.get_stat_max_epoch_lag();
+      }
+
+      xct::IsolationLevel isolation = xct::kSerializable;
+      COERCE_ERROR(pool->impersonate_synchronous("verify", &isolation, sizeof(isolation)));
+      if (take_snapshot) {
+        engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+        isolation = xct::kSnapshot;
+        COERCE_ERROR(pool->impersonate_synchronous("verify", &isolation, sizeof(isolation)));
+      }
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  {
+    // restart. the logs are replayed from both loggers' files
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("verify", verify_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      xct::IsolationLevel isolation = xct::kSerializable;
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous(
+        "verify",
+        &isolation,
+        sizeof(isolation)));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+TEST(LoggerWorkStealingTest, NoStealing) { test_skewed(false, false); }
+TEST(LoggerWorkStealingTest, Stealing) { test_skewed(true, false); }
+TEST(LoggerWorkStealingTest, StealingSnapshot) { test_skewed(true, true); }
+
+}  // namespace log
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(LoggerWorkStealingTest, foedus.log);
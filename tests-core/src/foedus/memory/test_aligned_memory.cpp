@@ -95,6 +95,24 @@ TEST(AlignedMemoryTest, Slice) {
   EXPECT_EQ(2 << 18, pointer_distance(memory.get_block(), slice4.get_block()));
   EXPECT_EQ(1 << 18, slice4.get_size());
 }
+
+void test_zeroed(bool prefault, uint64_t size) {
+  for (AlignedMemory::AllocType type = AlignedMemory::kPosixMemalign;
+      type <= AlignedMemory::kNumaAllocOnnode;
+      type = static_cast<AlignedMemory::AllocType>(static_cast<int>(type) + 1)) {
+    AlignedMemory memory;
+    memory.alloc(size, 1 << 12, type, 0, prefault);
+    EXPECT_FALSE(memory.is_null());
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(memory.get_block());
+    for (uint64_t i = 0; i < memory.get_size() / sizeof(uint64_t); i += 61) {
+      EXPECT_EQ(0U, words[i]) << type << ":" << i;
+    }
+  }
+}
+
+TEST(AlignedMemoryTest, Zeroed) { test_zeroed(true, 1 << 20); }
+TEST(AlignedMemoryTest, ZeroedLazy) { test_zeroed(false, 1 << 20); }
+TEST(AlignedMemoryTest, ZeroedParallel) { test_zeroed(true, 1ULL << 28); }
 }  // namespace memory
 }  // namespace foedus
 
@@ -23,6 +23,7 @@
 #include "foedus/engine_options.hpp"
 #include "foedus/test_common.hpp"
 #include "foedus/log/log_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
 #include "foedus/storage/storage_manager.hpp"
 #include "foedus/storage/array/array_metadata.hpp"
 #include "foedus/storage/array/array_storage.hpp"
@@ -221,6 +222,70 @@ TEST(RestartMetaTest, CreateDropCreate) {
   cleanup_test(options);
 }
 
+/**
+ * Metadata logs in exactly the snapshot epoch are already in the snapshot metadata.
+ * Restart must not redo them, but must redo the ones after it.
+ * The snapshot epoch is that of CREATE, or of DROP if drop is true.
+ */
+void test_snapshot_epoch(bool drop) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  COERCE_ERROR(engine.initialize());
+  storage::StorageId test_id = 0;
+  storage::StorageId seq_id;
+  {
+    UninitializeGuard guard(&engine);
+    storage::StorageManager* str_manager = engine.get_storage_manager();
+    snapshot::SnapshotManager* snapshot_manager = engine.get_snapshot_manager();
+    Epoch commit_epoch;
+    if (drop) {
+      storage::masstree::MasstreeStorage out2;
+      storage::masstree::MasstreeMetadata meta2("test2");
+      COERCE_ERROR(str_manager->create_masstree(&meta2, &out2, &commit_epoch));
+      COERCE_ERROR(str_manager->drop_storage(out2.get_id(), &commit_epoch));
+    } else {
+      storage::masstree::MasstreeStorage out;
+      storage::masstree::MasstreeMetadata meta("test");
+      COERCE_ERROR(str_manager->create_masstree(&meta, &out, &commit_epoch));
+      test_id = out.get_id();
+    }
+    COERCE_ERROR(engine.get_xct_manager()->wait_for_commit(commit_epoch));
+    snapshot_manager->trigger_snapshot_immediate(true, commit_epoch);
+    EXPECT_EQ(commit_epoch, snapshot_manager->get_snapshot_epoch());
+
+    // CREATE after the snapshot epoch. This must be redone.
+    storage::sequential::SequentialMetadata meta3("test3");
+    storage::sequential::SequentialStorage out3;
+    COERCE_ERROR(str_manager->create_sequential(&meta3, &out3, &commit_epoch));
+    seq_id = out3.get_id();
+    COERCE_ERROR(engine.get_xct_manager()->wait_for_commit(commit_epoch));
+    EXPECT_LT(snapshot_manager->get_snapshot_epoch(), commit_epoch);
+    COERCE_ERROR(engine.uninitialize());
+  }
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    if (drop) {
+      storage::masstree::MasstreeStorage out2(&engine, "test2");
+      EXPECT_FALSE(out2.exists());
+    } else {
+      storage::masstree::MasstreeStorage out(&engine, "test");
+      EXPECT_TRUE(out.exists());
+      EXPECT_EQ(test_id, out.get_id());
+    }
+
+    storage::sequential::SequentialStorage out3(&engine, "test3");
+    EXPECT_TRUE(out3.exists());
+    EXPECT_EQ(seq_id, out3.get_id());
+
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(RestartMetaTest, SnapshotEpochCreate) { test_snapshot_epoch(false); }
+TEST(RestartMetaTest, SnapshotEpochDrop) { test_snapshot_epoch(true); }
+
 }  // namespace restart
 }  // namespace foedus
 
@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/log/log_options.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/storage/hash/hash_metadata.hpp"
+#include "foedus/storage/hash/hash_storage.hpp"
+#include "foedus/storage/masstree/masstree_metadata.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_restart_replay.cpp
+ * Testcases for restart with log replay instead of the startup snapshot.
+ * Two threads write to the same records via two loggers so that the replay must
+ * respect the serialization order across loggers.
+ */
+namespace foedus {
+namespace restart {
+DEFINE_TEST_CASE_PACKAGE(RestartReplayTest, foedus.restart);
+
+const uint32_t kRecords = 256;
+const uint32_t kThreads = 2;
+const storage::StorageName kName("test");
+
+EngineOptions get_replay_options() {
+  EngineOptions options = get_tiny_options();
+  options.thread_.thread_count_per_group_ = kThreads;
+  options.log_.loggers_per_node_ = kThreads;
+  options.restart_.enable_log_replay_ = true;
+  return options;
+}
+
+/** Runs the proc on each core (thus each logger) one by one. */
+void run_on_each_core(Engine* engine, const char* proc_name) {
+  thread::ThreadPool* pool = engine->get_thread_pool();
+  for (uint32_t i = 0; i < kThreads; ++i) {
+    COERCE_ERROR(pool->impersonate_on_numa_core_synchronous(i, proc_name, &i, sizeof(i)));
+  }
+}
+
+ErrorStack array_write_task(const proc::ProcArguments& args) {
+  uint32_t id = *reinterpret_cast<const uint32_t*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  // each thread writes a different half of the payload. then thread-0 overwrites again.
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t i = 0; i < kRecords; ++i) {
+    uint64_t data = i * (id + 1U);
+    WRAP_ERROR_CODE(array.overwrite_record(context, i, &data, id * sizeof(data), sizeof(data)));
+  }
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  if (id == 1U) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint64_t i = 0; i < kRecords; i += 2U) {
+      uint64_t data = i + 1000U;
+      WRAP_ERROR_CODE(array.overwrite_record(context, i, &data, 0, sizeof(data)));
+      WRAP_ERROR_CODE(array.increment_record<uint64_t>(context, i, &data, sizeof(data)));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack array_verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t i = 0; i < kRecords; ++i) {
+    uint64_t data[2];
+    WRAP_ERROR_CODE(array.get_record(context, i, data));
+    if (i % 2U == 0) {
+      EXPECT_EQ(i + 1000U, data[0]) << i;
+      EXPECT_EQ(i * 2U + i + 1000U, data[1]) << i;
+    } else {
+      EXPECT_EQ(i, data[0]) << i;
+      EXPECT_EQ(i * 2U, data[1]) << i;
+    }
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+void test_array(log::LogDeviceType device_type, bool compress_logs) {
+  EngineOptions options = get_replay_options();
+  options.log_.device_type_ = device_type;
+  options.log_.compress_logs_ = compress_logs;
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("write", array_write_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::array::ArrayStorage out;
+      Epoch commit_epoch;
+      storage::array::ArrayMetadata meta(kName, sizeof(uint64_t) * 2U, kRecords);
+      COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &out, &commit_epoch));
+      run_on_each_core(&engine, "write");
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("verify", array_verify_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      // no startup snapshot
+      EXPECT_FALSE(engine.get_snapshot_manager()->get_snapshot_epoch().is_valid());
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("verify"));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+TEST(RestartReplayTest, Array) { test_array(log::kLogDeviceDirectIo, false); }
+TEST(RestartReplayTest, ArrayPmem) { test_array(log::kLogDevicePmem, false); }
+TEST(RestartReplayTest, ArrayCompressed) { test_array(log::kLogDeviceDirectIo, true); }
+
+ErrorStack masstree_write_task(const proc::ProcArguments& args) {
+  uint32_t id = *reinterpret_cast<const uint32_t*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  storage::masstree::MasstreeStorage masstree(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t i = 0; i < kRecords; ++i) {
+    if (id == 0) {
+      // thread-0 inserts all records
+      WRAP_ERROR_CODE(masstree.insert_record_normalized(context, i, &i, sizeof(i)));
+    } else if (i % 2U == 1U) {
+      // then thread-1 deletes odd records and overwrites even records
+      WRAP_ERROR_CODE(masstree.delete_record_normalized(context, i));
+    } else {
+      uint64_t data = i * 3U;
+      WRAP_ERROR_CODE(masstree.overwrite_record_normalized(context, i, &data, 0, sizeof(data)));
+    }
+  }
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  if (id == 1U) {
+    // and re-inserts a few of the deleted records with a longer payload
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint64_t i = 1; i < kRecords; i += 4U) {
+      uint64_t data[2] = {i * 5U, i * 7U};
+      WRAP_ERROR_CODE(masstree.insert_record_normalized(context, i, data, sizeof(data)));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack masstree_verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::masstree::MasstreeStorage masstree(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t i = 0; i < kRecords; ++i) {
+    uint64_t data[2];
+    storage::masstree::PayloadLength capacity = sizeof(data);
+    ErrorCode code = masstree.get_record_normalized(context, i, data, &capacity);
+    if (i % 2U == 0) {
+      EXPECT_EQ(kErrorCodeOk, code) << i;
+      EXPECT_EQ(sizeof(uint64_t), capacity) << i;
+      EXPECT_EQ(i * 3U, data[0]) << i;
+    } else if (i % 4U == 1U) {
+      EXPECT_EQ(kErrorCodeOk, code) << i;
+      EXPECT_EQ(sizeof(data), capacity) << i;
+      EXPECT_EQ(i * 5U, data[0]) << i;
+      EXPECT_EQ(i * 7U, data[1]) << i;
+    } else {
+      EXPECT_EQ(kErrorCodeStrKeyNotFound, code) << i;
+    }
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+void test_masstree(bool compress_logs) {
+  EngineOptions options = get_replay_options();
+  options.log_.compress_logs_ = compress_logs;
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("write", masstree_write_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::masstree::MasstreeStorage out;
+      Epoch commit_epoch;
+      storage::masstree::MasstreeMetadata meta(kName);
+      COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &out, &commit_epoch));
+      run_on_each_core(&engine, "write");
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("verify", masstree_verify_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      EXPECT_FALSE(engine.get_snapshot_manager()->get_snapshot_epoch().is_valid());
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("verify"));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+TEST(RestartReplayTest, Masstree) { test_masstree(false); }
+TEST(RestartReplayTest, MasstreeCompressed) { test_masstree(true); }
+
+ErrorStack hash_write_task(const proc::ProcArguments& args) {
+  uint32_t id = *reinterpret_cast<const uint32_t*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  storage::hash::HashStorage hash(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t i = 0; i < kRecords; ++i) {
+    if (id == 0) {
+      WRAP_ERROR_CODE(hash.insert_record(context, i, &i, sizeof(i)));
+    } else if (i % 2U == 1U) {
+      WRAP_ERROR_CODE(hash.delete_record(context, i));
+    } else {
+      uint64_t data = i * 3U;
+      WRAP_ERROR_CODE(hash.overwrite_record(context, i, &data, 0, sizeof(data)));
+    }
+  }
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  if (id == 1U) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint64_t i = 1; i < kRecords; i += 4U) {
+      uint64_t data[2] = {i * 5U, i * 7U};
+      WRAP_ERROR_CODE(hash.insert_record(context, i, data, sizeof(data)));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack hash_verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::hash::HashStorage hash(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t i = 0; i < kRecords; ++i) {
+    uint64_t data[2];
+    uint16_t capacity = sizeof(data);
+    ErrorCode code = hash.get_record(context, i, data, &capacity);
+    if (i % 2U == 0) {
+      EXPECT_EQ(kErrorCodeOk, code) << i;
+      EXPECT_EQ(sizeof(uint64_t), capacity) << i;
+      EXPECT_EQ(i * 3U, data[0]) << i;
+    } else if (i % 4U == 1U) {
+      EXPECT_EQ(kErrorCodeOk, code) << i;
+      EXPECT_EQ(sizeof(data), capacity) << i;
+      EXPECT_EQ(i * 5U, data[0]) << i;
+      EXPECT_EQ(i * 7U, data[1]) << i;
+    } else {
+      EXPECT_EQ(kErrorCodeStrKeyNotFound, code) << i;
+    }
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+TEST(RestartReplayTest, Hash) {
+  EngineOptions options = get_replay_options();
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("write", hash_write_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::hash::HashStorage out;
+      Epoch commit_epoch;
+      storage::hash::HashMetadata meta(kName, 8);
+      COERCE_ERROR(engine.get_storage_manager()->create_hash(&meta, &out, &commit_epoch));
+      run_on_each_core(&engine, "write");
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("verify", hash_verify_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      EXPECT_FALSE(engine.get_snapshot_manager()->get_snapshot_epoch().is_valid());
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("verify"));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+void test_after_snapshot(bool compress_logs) {
+  // some logs are in the snapshot, some are replayed.
+  EngineOptions options = get_replay_options();
+  options.log_.compress_logs_ = compress_logs;
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("write", array_write_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::array::ArrayStorage out;
+      Epoch commit_epoch;
+      storage::array::ArrayMetadata meta(kName, sizeof(uint64_t) * 2U, kRecords);
+      COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &out, &commit_epoch));
+      uint32_t id = 0;
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_on_numa_core_synchronous(
+        id, "write", &id, sizeof(id)));
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      id = 1;
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_on_numa_core_synchronous(
+        id, "write", &id, sizeof(id)));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("verify", array_verify_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      EXPECT_TRUE(engine.get_snapshot_manager()->get_snapshot_epoch().is_valid());
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("verify"));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+TEST(RestartReplayTest, AfterSnapshot) { test_after_snapshot(false); }
+TEST(RestartReplayTest, AfterSnapshotCompressed) { test_after_snapshot(true); }
+
+}  // namespace restart
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(RestartReplayTest, foedus.restart);
@@ -144,6 +144,8 @@ struct TestBase {
 
   virtual uint16_t get_input_count() const = 0;
   virtual SortedBuffer** get_inputs() = 0;
+  /** Which input the i-th log is placed in. */
+  virtual uint16_t to_input_index(uint64_t i) const { return i % get_input_count(); }
 
   template <typename VERIFY>
   void merge_inputs(
@@ -185,7 +187,7 @@ struct TestBase {
           EXPECT_EQ(merge_sort.resolve_sort_position(i), merge_sort.resolve_merged_position(i));
           EXPECT_EQ(0, pos.input_index_);
         } else {
-          EXPECT_EQ(accumulative_i % get_input_count(), pos.input_index_);
+          EXPECT_EQ(to_input_index(accumulative_i), pos.input_index_);
         }
 
         if (storage_type == storage::kArrayStorage) {
@@ -422,6 +424,76 @@ struct MultiInputsTest : public TestBase {
   DumpFileSortedBuffer* io_buffer_;
 };
 
+/**
+ * testcase for many in-memory inputs, which exercises the loser-tree merge with a number of
+ * inputs that is not a power of two. Input-k takes keys whose (i / 2) % kManyInputs == k.
+ * kDuplicates makes each pair of 2m and 2m+1 full duplicates, whose order is defined only by
+ * buffer position. Hence each pair goes to the same input.
+ */
+const uint16_t kManyInputs = 5;
+struct ManyInputsTest : public TestBase {
+  ManyInputsTest(
+    TestKeyDistribution distribution,
+    uint32_t shortest_key_length,
+    uint32_t longest_key_length,
+    uint64_t max_log_length)
+    : TestBase(distribution, shortest_key_length, longest_key_length, max_log_length) {
+    for (uint16_t k = 0; k < kManyInputs; ++k) {
+      buffers_[k] = nullptr;
+      if (k > 0) {
+        memories_[k].alloc(capacity_, 1U << 21, memory::AlignedMemory::kNumaAllocOnnode, 0);
+      }
+    }
+  }
+
+  ~ManyInputsTest() {
+    // buffers_[0] is inmemory_buffer_, deleted by TestBase
+    for (uint16_t k = 1; k < kManyInputs; ++k) {
+      delete buffers_[k];
+      buffers_[k] = nullptr;
+    }
+  }
+
+  template <typename POPULATE>
+  void prepare_inputs(POPULATE populate) {
+    char payload[kPayload];
+    std::memset(payload, 0, kPayload);
+    for (uint16_t k = 0; k < kManyInputs; ++k) {
+      uint64_t cur = 0;
+      memory::AlignedMemory* memory = (k == 0) ? &memory_ : &memories_[k];
+      char* buf = reinterpret_cast<char*>(memory->get_block());
+      for (uint64_t i = 0; i < kLogsPerInput * kManyInputs; ++i) {
+        if (to_input_index(i) == k) {
+          cur = invoke_populate(i, cur, buf, payload, populate);
+        }
+      }
+      buffers_[k] = new InMemorySortedBuffer(buf, cur);
+      buffers_[k]->set_current_block(
+        kStorageId,
+        kLogsPerInput,
+        0,
+        cur,
+        shortest_key_length_,
+        longest_key_length_);
+    }
+    inmemory_buffer_ = buffers_[0];
+  }
+
+  uint16_t get_input_count() const override { return kManyInputs; }
+  uint16_t to_input_index(uint64_t i) const override { return (i / 2U) % kManyInputs; }
+  SortedBuffer** get_inputs() override {
+    for (uint16_t k = 0; k < kManyInputs; ++k) {
+      inputs_[k] = buffers_[k];
+    }
+    return inputs_;
+  }
+
+  SortedBuffer* inputs_[kManyInputs];
+  InMemorySortedBuffer* buffers_[kManyInputs];
+  /** memories_[0] is not used. Input-0 uses memory_ */
+  memory::AlignedMemory memories_[kManyInputs];
+};
+
 ///////////////////////////////////////////////////
 /// Array testcases
 ///////////////////////////////////////////////////
@@ -453,6 +525,14 @@ void test_multi_inputs_array(TestKeyDistribution distribution) {
   impl.merge_inputs(storage::kArrayStorage, array_verify);
 }
 
+void test_many_inputs_array(TestKeyDistribution distribution) {
+  const uint16_t kLen = sizeof(storage::array::ArrayOffset);
+  uint16_t length = storage::array::ArrayOverwriteLogType::calculate_log_length(kPayload);
+  ManyInputsTest impl(distribution, kLen, kLen, length);
+  impl.prepare_inputs(array_populate);
+  impl.merge_inputs(storage::kArrayStorage, array_verify);
+}
+
 ///////////////////////////////////////////////////
 /// Hash testcases
 /// Here, "key" for merge-sort must have unique hashbin. Further,
@@ -661,6 +741,14 @@ void test_multi_inputs_masstree_normalized(TestKeyDistribution distribution) {
   impl.merge_inputs(storage::kMasstreeStorage, masstree_normalized_verify);
 }
 
+void test_many_inputs_masstree_normalized(TestKeyDistribution distribution) {
+  const uint16_t kLen = sizeof(storage::masstree::KeySlice);
+  uint16_t length = storage::masstree::MasstreeInsertLogType::calculate_log_length(kLen, kPayload);
+  ManyInputsTest impl(distribution, kLen, kLen, length);
+  impl.prepare_inputs(masstree_normalized_populate);
+  impl.merge_inputs(storage::kMasstreeStorage, masstree_normalized_verify);
+}
+
 // varlen key is a bit tricky. test requirements:
 //  1) involve keys whose length are less than or larger than 8 bytes
 //  2) involve keys whose first 8 bytes are not enough to determine the comparison result
@@ -754,6 +842,12 @@ TEST(MergeSortTest, MultiInputsDistinctOrdinalArray) {
 TEST(MergeSortTest, MultiInputsDuplicatesArray) {
   test_multi_inputs_array(kDuplicates);
 }
+TEST(MergeSortTest, ManyInputsDistinctKeyArray) {
+  test_many_inputs_array(kDistinctKey);
+}
+TEST(MergeSortTest, ManyInputsDuplicatesArray) {
+  test_many_inputs_array(kDuplicates);
+}
 
 TEST(MergeSortTest, SingleInputDistinctKeyHashFixlen) {
   test_single_input_hash_fixlen(kDistinctKey);
@@ -832,6 +926,12 @@ TEST(MergeSortTest, MultiInputsDistinctOrdinalMasstreeNormalized) {
 TEST(MergeSortTest, MultiInputsDuplicatesMasstreeNormalized) {
   test_multi_inputs_masstree_normalized(kDuplicates);
 }
+TEST(MergeSortTest, ManyInputsDistinctKeyMasstreeNormalized) {
+  test_many_inputs_masstree_normalized(kDistinctKey);
+}
+TEST(MergeSortTest, ManyInputsDuplicatesMasstreeNormalized) {
+  test_many_inputs_masstree_normalized(kDuplicates);
+}
 
 TEST(MergeSortTest, SingleInputDistinctKeyMasstreeVarlen) {
   test_single_input_masstree_varlen(kDistinctKey);
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "foedus/test_common.hpp"
+#include "foedus/assorted/uniform_random.hpp"
+#include "foedus/snapshot/snapshot_id.hpp"
+#include "foedus/soc/soc_id.hpp"
+#include "foedus/storage/partitioner.hpp"
+
+/**
+ * @file test_partition_grouping.cpp
+ * Testcase for Partitioner::group_by_partition(), which log mappers use to group logs.
+ */
+namespace foedus {
+namespace snapshot {
+DEFINE_TEST_CASE_PACKAGE(PartitionGroupingTest, foedus.snapshot);
+
+/** Groups and then verifies the output against a straightforward per-partition scan. */
+void test_grouping(
+  const std::vector<storage::PartitionId>& partitions,
+  uint16_t partition_count) {
+  const uint32_t count = partitions.size();
+  std::vector<BufferPosition> positions(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    positions[i] = i * 3U + 7U;  // arbitrary, but distinct
+  }
+  std::vector<BufferPosition> output(count + 1U, 0);
+  uint32_t begins[soc::kMaxSocs + 1U];
+  storage::Partitioner::GroupByPartitionArguments args = {
+    positions.data(),
+    partitions.data(),
+    count,
+    partition_count,
+    output.data(),
+    begins};
+  storage::Partitioner::group_by_partition(args);
+
+  EXPECT_EQ(0U, begins[0]);
+  EXPECT_EQ(count, begins[partition_count]);
+  for (uint16_t p = 0; p < partition_count; ++p) {
+    std::vector<BufferPosition> expected;
+    for (uint32_t i = 0; i < count; ++i) {
+      if (partitions[i] == p) {
+        expected.push_back(positions[i]);
+      }
+    }
+    ASSERT_EQ(expected.size(), begins[p + 1U] - begins[p]) << p;
+    for (uint32_t j = 0; j < expected.size(); ++j) {
+      // grouping is stable, so the original order within the partition is kept
+      EXPECT_EQ(expected[j], output[begins[p] + j]) << p << ":" << j;
+    }
+  }
+}
+
+TEST(PartitionGroupingTest, Empty) {
+  std::vector<storage::PartitionId> partitions;
+  test_grouping(partitions, 4);
+}
+
+TEST(PartitionGroupingTest, OnePartition) {
+  std::vector<storage::PartitionId> partitions(1000, 0);
+  test_grouping(partitions, 1);
+}
+
+TEST(PartitionGroupingTest, SomeEmpty) {
+  std::vector<storage::PartitionId> partitions;
+  for (uint32_t i = 0; i < 1000U; ++i) {
+    partitions.push_back(i % 3U == 0 ? 1 : 3);
+  }
+  test_grouping(partitions, 4);
+}
+
+TEST(PartitionGroupingTest, Random) {
+  assorted::UniformRandom rnd(1234L);
+  std::vector<storage::PartitionId> partitions;
+  for (uint32_t i = 0; i < 100000U; ++i) {
+    partitions.push_back(rnd.next_uint32() % soc::kMaxSocs);
+  }
+  test_grouping(partitions, soc::kMaxSocs);
+}
+
+}  // namespace snapshot
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(PartitionGroupingTest, foedus.snapshot);
@@ -17,6 +17,7 @@
  */
 #include <gtest/gtest.h>
 
+#include <cstring>
 #include <string>
 
 #include "foedus/engine.hpp"
@@ -30,6 +31,7 @@
 #include "foedus/storage/storage_manager.hpp"
 #include "foedus/storage/array/array_metadata.hpp"
 #include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
@@ -304,6 +306,84 @@ void test_run(
   cleanup_test(options);
 }
 
+/** Overwrites the whole payload of every record with offset * 10 + round. */
+ErrorStack whole_overwrites_task(const proc::ProcArguments& args) {
+  EXPECT_EQ(sizeof(uint32_t), args.input_len_);
+  uint32_t round = *reinterpret_cast<const uint32_t*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  ASSERT_ND(array.exists());
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  char payload[kThreeLevelPayload];
+  std::memset(payload, 0, sizeof(payload));
+  const uint32_t kRecordsPerXct = 64;
+  Epoch commit_epoch;
+  for (uint32_t from = 0; from < kRecords; from += kRecordsPerXct) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint32_t rec = from; rec < from + kRecordsPerXct; ++rec) {
+      *reinterpret_cast<uint64_t*>(payload) = rec * 10ULL + round;
+      WRAP_ERROR_CODE(array.overwrite_record(context, rec, payload));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack verify_whole_overwrites_task(const proc::ProcArguments& args) {
+  EXPECT_EQ(sizeof(uint32_t), args.input_len_);
+  uint32_t round = *reinterpret_cast<const uint32_t*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSnapshot));
+  for (uint32_t rec = 0; rec < kRecords; ++rec) {
+    uint64_t data = 0;
+    WRAP_ERROR_CODE(array.get_record_primitive<uint64_t>(context, rec, &data, 0));
+    EXPECT_EQ(rec * 10ULL + round, data) << rec;
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+/**
+ * Each snapshot receives more logs than a half of the reducer buffer, so the reducer dumps
+ * sorted runs in every snapshot. The reducer object lives across snapshots, and it used to
+ * keep sorted_runs_ and lose dump_io_buffer_ after the first snapshot.
+ */
+TEST(SnapshotArrayTest, SortedRunsAcrossSnapshots) {
+  EngineOptions options = get_tiny_options();
+  options.memory_.page_pool_size_mb_per_node_ *= 4;
+  options.cache_.snapshot_cache_size_mb_per_node_ *= 4;
+  // a round has 1024 * 1500 bytes of logs. larger than a half of the buffer.
+  ASSERT_ND(options.snapshot_.log_reducer_buffer_mb_ <= 2U);
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("whole_overwrites_task", whole_overwrites_task);
+  engine.get_proc_manager()->pre_register(
+    "verify_whole_overwrites_task",
+    verify_whole_overwrites_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::array::ArrayStorage out;
+    Epoch commit_epoch;
+    storage::array::ArrayMetadata meta(kName, kThreeLevelPayload, kRecords);
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &out, &commit_epoch));
+    thread::ThreadPool* pool = engine.get_thread_pool();
+    for (uint32_t round = 1; round <= 3U; ++round) {
+      COERCE_ERROR(pool->impersonate_synchronous("whole_overwrites_task", &round, sizeof(round)));
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      COERCE_ERROR(pool->impersonate_synchronous(
+        "verify_whole_overwrites_task",
+        &round,
+        sizeof(round)));
+    }
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
 TEST(SnapshotArrayTest, OverwritesOneLogger) { test_run(kOv, false, false); }
 TEST(SnapshotArrayTest, OverwritesTwoLoggers) { test_run(kOv, true, false); }
 TEST(SnapshotArrayTest, OverwritesTwoPartitions) { test_run(kOv, true, true); }
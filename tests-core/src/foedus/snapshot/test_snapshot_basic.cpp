@@ -17,6 +17,7 @@
  */
 #include <gtest/gtest.h>
 
+#include <fstream>
 #include <string>
 
 #include "foedus/engine.hpp"
@@ -46,11 +47,19 @@ ErrorStack read_metadata_file(Engine* engine, SnapshotMetadata *metadata) {
   SnapshotManager* manager = engine->get_snapshot_manager();
   SnapshotId snapshot_id = manager->get_previous_snapshot_id();
   EXPECT_NE(kNullSnapshotId, snapshot_id);
-  fs::Path file = manager->get_pimpl()->get_snapshot_metadata_file_path(snapshot_id);
-  CHECK_ERROR(metadata->load_from_file(file));
+  CHECK_ERROR(manager->read_snapshot_metadata(snapshot_id, metadata));
   return kRetOk;
 }
 
+void create_array_and_snapshot(Engine* engine, storage::array::ArrayStorage* out) {
+  Epoch commit_epoch;
+  storage::array::ArrayMetadata meta("test", 16, 100);
+  COERCE_ERROR(engine->get_storage_manager()->create_array(&meta, out, &commit_epoch));
+  EXPECT_TRUE(out->exists());
+  COERCE_ERROR(engine->get_xct_manager()->wait_for_commit(commit_epoch));
+  engine->get_snapshot_manager()->trigger_snapshot_immediate(true);
+}
+
 TEST(SnapshotBasicTest, Empty) {
   EngineOptions options = get_tiny_options();
   Engine engine(options);
@@ -158,6 +167,73 @@ TEST(SnapshotBasicTest, TwoArrayCreate) {
   cleanup_test(options);
 }
 
+TEST(SnapshotBasicTest, ExportXml) {
+  EngineOptions options = get_tiny_options();
+  options.snapshot_.export_metadata_xml_ = true;
+  Engine engine(options);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::array::ArrayStorage out;
+    create_array_and_snapshot(&engine, &out);
+
+    SnapshotManagerPimpl* pimpl = engine.get_snapshot_manager()->get_pimpl();
+    SnapshotId snapshot_id = engine.get_snapshot_manager()->get_previous_snapshot_id();
+    SnapshotMetadata binary;
+    COERCE_ERROR(binary.load_from_binary_file(pimpl->get_snapshot_metadata_file_path(snapshot_id)));
+    SnapshotMetadata xml;
+    COERCE_ERROR(xml.load_from_file(pimpl->get_snapshot_metadata_xml_file_path(snapshot_id)));
+    EXPECT_EQ(xml.id_, binary.id_);
+    EXPECT_EQ(xml.base_epoch_, binary.base_epoch_);
+    EXPECT_EQ(xml.valid_until_epoch_, binary.valid_until_epoch_);
+    EXPECT_EQ(xml.largest_storage_id_, binary.largest_storage_id_);
+
+    storage::array::ArrayMetadata* from_binary = reinterpret_cast<storage::array::ArrayMetadata*>(
+      binary.get_metadata(out.get_id()));
+    storage::array::ArrayMetadata* from_xml = reinterpret_cast<storage::array::ArrayMetadata*>(
+      xml.get_metadata(out.get_id()));
+    EXPECT_EQ(from_xml->id_, from_binary->id_);
+    EXPECT_EQ(from_xml->name_, from_binary->name_);
+    EXPECT_EQ(from_xml->type_, from_binary->type_);
+    EXPECT_EQ(from_xml->root_snapshot_page_id_, from_binary->root_snapshot_page_id_);
+    EXPECT_EQ(from_xml->array_size_, from_binary->array_size_);
+    EXPECT_EQ(from_xml->payload_size_, from_binary->payload_size_);
+
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(SnapshotBasicTest, BinaryCorrupted) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::array::ArrayStorage out;
+    create_array_and_snapshot(&engine, &out);
+
+    SnapshotManagerPimpl* pimpl = engine.get_snapshot_manager()->get_pimpl();
+    SnapshotId snapshot_id = engine.get_snapshot_manager()->get_previous_snapshot_id();
+    fs::Path file = pimpl->get_snapshot_metadata_file_path(snapshot_id);
+    {
+      // flip one byte in the metadata of the array
+      std::fstream stream(file.string(), std::ios::in | std::ios::out | std::ios::binary);
+      stream.seekg((1U + out.get_id()) * 4096U + 128U);
+      char c = static_cast<char>(stream.get());
+      stream.seekp((1U + out.get_id()) * 4096U + 128U);
+      stream.put(static_cast<char>(c ^ 0x5A));
+    }
+    SnapshotMetadata metadata;
+    ErrorStack result = metadata.load_from_binary_file(file);
+    EXPECT_TRUE(result.is_error());
+    EXPECT_EQ(kErrorCodeSnapshotMetadataCorrupted, result.get_error_code());
+
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
 }  // namespace snapshot
 }  // namespace foedus
 
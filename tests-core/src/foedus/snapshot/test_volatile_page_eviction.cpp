@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/memory/engine_memory.hpp"
+#include "foedus/memory/numa_node_memory.hpp"
+#include "foedus/memory/page_pool.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/snapshot/snapshot_options.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_volatile_page_eviction.cpp
+ * Volatile page evictor that drops volatile pages between snapshots.
+ */
+namespace foedus {
+namespace snapshot {
+DEFINE_TEST_CASE_PACKAGE(VolatilePageEvictionTest, foedus.snapshot);
+
+const storage::StorageName kName("test");
+const uint32_t kPayload = sizeof(uint64_t);
+const uint32_t kRecords = 1024;
+
+ErrorStack populate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint32_t offset = 0; offset < kRecords; ++offset) {
+    uint64_t value = offset * 5ULL;
+    WRAP_ERROR_CODE(array.overwrite_record_primitive<uint64_t>(context, offset, value, 0));
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint32_t offset = 0; offset < kRecords; ++offset) {
+    uint64_t value;
+    WRAP_ERROR_CODE(array.get_record_primitive<uint64_t>(context, offset, &value, 0));
+    EXPECT_EQ(offset * 5ULL, value) << offset;
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+uint64_t get_allocated_volatile_pages(Engine* engine) {
+  memory::PagePool* pool = engine->get_memory_manager()->get_node_memory(0)->get_volatile_pool();
+  return pool->get_stat().allocated_pages_;
+}
+
+void test_eviction(uint16_t evict_percent) {
+  EngineOptions options = get_tiny_options();
+  options.snapshot_.volatile_page_evict_percent_ = evict_percent;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("populate_task", populate_task);
+  engine.get_proc_manager()->pre_register("verify_task", verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::array::ArrayStorage out;
+    // keeps all volatile pages after snapshotting. Only the evictor can drop them.
+    storage::array::ArrayMetadata meta(kName, kPayload, kRecords);
+    meta.snapshot_drop_volatile_pages_threshold_ = 8;
+    Epoch commit_epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &out, &commit_epoch));
+    thread::ThreadPool* pool = engine.get_thread_pool();
+    COERCE_ERROR(pool->impersonate_synchronous("populate_task"));
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    const uint64_t after_snapshot = get_allocated_volatile_pages(&engine);
+
+    if (evict_percent > 0) {
+      // the evictor gradually drops more levels. wait until it drops the leaf pages.
+      for (uint32_t i = 0; i < 300U; ++i) {
+        if (get_allocated_volatile_pages(&engine) < after_snapshot) {
+          break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+      EXPECT_LT(get_allocated_volatile_pages(&engine), after_snapshot);
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+      EXPECT_EQ(after_snapshot, get_allocated_volatile_pages(&engine));
+    }
+
+    // whether evicted or not, we must see the same data.
+    COERCE_ERROR(pool->impersonate_synchronous("verify_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(VolatilePageEvictionTest, Disabled) { test_eviction(0); }
+TEST(VolatilePageEvictionTest, Evict) { test_eviction(100); }
+
+}  // namespace snapshot
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(VolatilePageEvictionTest, foedus.snapshot);
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_cursor.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_array_cursor.cpp
+ * Range scans and aggregations with ArrayCursor.
+ */
+namespace foedus {
+namespace storage {
+namespace array {
+DEFINE_TEST_CASE_PACKAGE(ArrayCursorTest, foedus.storage.array);
+
+const StorageName kName("test");
+// With 16-byte payloads, 1024 records span several leaf pages.
+const uint32_t kRecords = 1024;
+
+struct Payload {
+  uint64_t value_;
+  uint32_t category_;
+  uint32_t dummy_;
+};
+
+uint64_t expected_value(uint64_t offset) { return offset * 3ULL; }
+uint32_t expected_category(uint64_t offset) { return offset % 7U; }
+
+ErrorStack populate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  ArrayStorage array(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  const uint32_t kRecordsPerXct = 256;
+  for (uint32_t i = 0; i < kRecords; i += kRecordsPerXct) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint32_t offset = i; offset < i + kRecordsPerXct && offset < kRecords; ++offset) {
+      Payload payload = {expected_value(offset), expected_category(offset), 0};
+      WRAP_ERROR_CODE(array.overwrite_record(context, offset, &payload));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+bool category_filter(ArrayOffset offset, const void* payload, void* user_data) {
+  const Payload* casted = reinterpret_cast<const Payload*>(payload);
+  EXPECT_EQ(expected_value(offset), casted->value_) << offset;
+  return casted->category_ == *reinterpret_cast<uint32_t*>(user_data);
+}
+
+ErrorStack verify_task(const proc::ProcArguments& args) {
+  const xct::IsolationLevel isolation = *reinterpret_cast<const xct::IsolationLevel*>(
+    args.input_buffer_);
+  thread::Thread* context = args.context_;
+  ArrayStorage array(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, isolation));
+
+  // record by record over a range that spans several leaf pages
+  const ArrayOffset kBegin = 123;
+  const ArrayOffset kEnd = 789;
+  ArrayCursor cursor(array, context);
+  WRAP_ERROR_CODE(cursor.open(kBegin, kEnd));
+  ArrayOffset expected = kBegin;
+  while (cursor.is_valid_record()) {
+    EXPECT_EQ(expected, cursor.get_cur_offset());
+    const Payload* payload = reinterpret_cast<const Payload*>(cursor.get_payload());
+    EXPECT_EQ(expected_value(expected), payload->value_) << expected;
+    EXPECT_EQ(expected_category(expected), payload->category_) << expected;
+    ++expected;
+    WRAP_ERROR_CODE(cursor.next());
+  }
+  EXPECT_EQ(kEnd, expected);
+
+  // empty ranges
+  WRAP_ERROR_CODE(cursor.open(kRecords, kRecords + 10U));
+  EXPECT_FALSE(cursor.is_valid_record());
+  WRAP_ERROR_CODE(cursor.open(10, 10));
+  EXPECT_FALSE(cursor.is_valid_record());
+
+  // aggregate all records. the end is clamped to the array size
+  ArrayAggregate<uint64_t> result;
+  const uint32_t read_set_before = context->get_current_xct().get_read_set_size();
+  WRAP_ERROR_CODE(cursor.open());
+  WRAP_ERROR_CODE(cursor.aggregate<uint64_t>(0, &result));
+  EXPECT_FALSE(cursor.is_valid_record());
+  // at most one read-set entry per record, even for the one open() already protected
+  EXPECT_LE(context->get_current_xct().get_read_set_size() - read_set_before, kRecords);
+  EXPECT_EQ(kRecords, result.count_);
+  EXPECT_EQ(expected_value(kRecords) * (kRecords - 1U) / 2U, result.sum_);
+  EXPECT_EQ(0U, result.min_);
+  EXPECT_EQ(expected_value(kRecords - 1U), result.max_);
+
+  // aggregate the rest after reading a few records
+  WRAP_ERROR_CODE(cursor.open(kBegin, kEnd));
+  WRAP_ERROR_CODE(cursor.next());
+  WRAP_ERROR_CODE(cursor.next());
+  ArrayAggregate<uint32_t> categories;
+  WRAP_ERROR_CODE(cursor.aggregate<uint32_t>(sizeof(uint64_t), &categories));
+  EXPECT_EQ(kEnd - kBegin - 2U, categories.count_);
+  EXPECT_EQ(0U, categories.min_);
+  EXPECT_EQ(6U, categories.max_);
+
+  // with a filter
+  uint32_t category = 3;
+  WRAP_ERROR_CODE(cursor.open());
+  WRAP_ERROR_CODE(cursor.aggregate<uint64_t>(0, &result, category_filter, &category));
+  uint64_t expected_count = 0;
+  uint64_t expected_sum = 0;
+  for (uint64_t offset = 0; offset < kRecords; ++offset) {
+    if (expected_category(offset) == category) {
+      ++expected_count;
+      expected_sum += expected_value(offset);
+    }
+  }
+  EXPECT_EQ(expected_count, result.count_);
+  EXPECT_EQ(expected_sum, result.sum_);
+  EXPECT_EQ(expected_value(category), result.min_);
+
+  if (isolation == xct::kSerializable) {
+    EXPECT_GT(context->get_current_xct().get_read_set_size(), 0U);
+  } else {
+    EXPECT_EQ(0U, context->get_current_xct().get_read_set_size());
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+void test_cursor(xct::IsolationLevel isolation, bool take_snapshot) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("populate_task", populate_task);
+  engine.get_proc_manager()->pre_register("verify_task", verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ArrayStorage out;
+    ArrayMetadata meta(kName, sizeof(Payload), kRecords);
+    Epoch commit_epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &out, &commit_epoch));
+    thread::ThreadPool* pool = engine.get_thread_pool();
+    COERCE_ERROR(pool->impersonate_synchronous("populate_task"));
+    if (take_snapshot) {
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    }
+    COERCE_ERROR(pool->impersonate_synchronous("verify_task", &isolation, sizeof(isolation)));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(ArrayCursorTest, Serializable) { test_cursor(xct::kSerializable, false); }
+TEST(ArrayCursorTest, DirtyRead) { test_cursor(xct::kDirtyRead, false); }
+TEST(ArrayCursorTest, Snapshot) { test_cursor(xct::kSnapshot, true); }
+
+}  // namespace array
+}  // namespace storage
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(ArrayCursorTest, foedus.storage.array);
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/memory/engine_memory.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/restart/restart_options.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/snapshot/snapshot_options.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_id.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_page_impl.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/storage/array/array_storage_pimpl.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_array_extend.cpp
+ * Online extension of array storage via ArrayStorage::extend().
+ */
+namespace foedus {
+namespace storage {
+namespace array {
+DEFINE_TEST_CASE_PACKAGE(ArrayExtendTest, foedus.storage.array);
+
+const StorageName kName("test");
+
+/** Records in [0, written_) have offset * 3 + 1, the rest upto the array size are zero. */
+struct ExtendInput {
+  ArrayOffset         from_;
+  ArrayOffset         written_;
+  xct::IsolationLevel isolation_;
+};
+
+ErrorStack write_task(const proc::ProcArguments& args) {
+  const ExtendInput* input = reinterpret_cast<const ExtendInput*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  ArrayStorage array(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  const ArrayOffset kRecordsPerXct = 256;
+  for (ArrayOffset i = input->from_; i < input->written_; i += kRecordsPerXct) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (ArrayOffset offset = i; offset < i + kRecordsPerXct && offset < input->written_;
+          ++offset) {
+      uint64_t value = offset * 3ULL + 1ULL;
+      WRAP_ERROR_CODE(array.overwrite_record_primitive<uint64_t>(context, offset, value, 0));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack verify_task(const proc::ProcArguments& args) {
+  const ExtendInput* input = reinterpret_cast<const ExtendInput*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  ArrayStorage array(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, input->isolation_));
+  for (ArrayOffset offset = 0; offset < array.get_array_size(); ++offset) {
+    uint64_t value;
+    WRAP_ERROR_CODE(array.get_record_primitive<uint64_t>(context, offset, &value, 0));
+    if (offset < input->written_) {
+      EXPECT_EQ(offset * 3ULL + 1ULL, value) << offset;
+    } else {
+      EXPECT_EQ(0U, value) << offset;
+    }
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+void verify(Engine* engine, ArrayOffset written, xct::IsolationLevel isolation) {
+  ExtendInput input = {0, written, isolation};
+  COERCE_ERROR(engine->get_thread_pool()->impersonate_synchronous(
+    "verify_task",
+    &input,
+    sizeof(input)));
+}
+
+void write(Engine* engine, ArrayOffset from, ArrayOffset to) {
+  ExtendInput input = {from, to, xct::kSerializable};
+  COERCE_ERROR(engine->get_thread_pool()->impersonate_synchronous(
+    "write_task",
+    &input,
+    sizeof(input)));
+}
+
+void test_extend(
+  ArrayOffset old_size,
+  ArrayOffset new_size,
+  uint8_t expected_levels,
+  bool take_snapshot,
+  bool drop_all_volatiles = false) {
+  EngineOptions options = get_tiny_options();
+  options.memory_.page_pool_size_mb_per_node_ = 16;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("write_task", write_task);
+  engine.get_proc_manager()->pre_register("verify_task", verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ArrayStorage array;
+    ArrayMetadata meta(kName, sizeof(uint64_t), old_size);
+    if (drop_all_volatiles) {
+      meta.snapshot_drop_volatile_pages_threshold_ = 0;
+    }
+    Epoch commit_epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &array, &commit_epoch));
+    const uint8_t old_levels = array.get_levels();
+    write(&engine, 0, old_size);
+    if (take_snapshot) {
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    }
+    if (drop_all_volatiles) {
+      // extend() must install the root page from the snapshot
+      EXPECT_TRUE(array.get_control_block()->root_page_pointer_.volatile_pointer_.is_null());
+    }
+
+    // not larger. no-op
+    Epoch extend_epoch;
+    COERCE_ERROR(array.extend(old_size, &extend_epoch));
+    EXPECT_EQ(old_size, array.get_array_size());
+    EXPECT_TRUE(array.extend(kMaxArrayOffset + 1ULL, &extend_epoch).is_error());
+    EXPECT_EQ(old_size, array.get_array_size());
+
+    COERCE_ERROR(array.extend(new_size, &extend_epoch));
+    EXPECT_TRUE(extend_epoch.is_valid());
+    EXPECT_EQ(new_size, array.get_array_size());
+    EXPECT_EQ(new_size, array.get_array_metadata()->array_size_);
+    EXPECT_GE(expected_levels, old_levels);
+    EXPECT_EQ(expected_levels, array.get_levels());
+
+    // the new records are zero. the old ones are intact.
+    // (dirty-read because the larger cases exceed the read-set size in one xct)
+    verify(&engine, old_size, xct::kDirtyRead);
+    if (take_snapshot) {
+      verify(&engine, old_size, xct::kSnapshot);
+    }
+    write(&engine, old_size, new_size);
+    verify(&engine, new_size, xct::kDirtyRead);
+    if (take_snapshot) {
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      verify(&engine, new_size, xct::kSnapshot);
+      verify(&engine, new_size, xct::kDirtyRead);
+    }
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+// with 8-byte payload, a leaf has 168 records and 2 levels hold 42336 records.
+TEST(ArrayExtendTest, WithinLeaf) { test_extend(10, 50, 1, false); }
+TEST(ArrayExtendTest, AcrossLeaves) { test_extend(500, 3000, 2, false); }
+TEST(ArrayExtendTest, AddLevel) { test_extend(100, 50000, 3, false); }
+TEST(ArrayExtendTest, Snapshot) { test_extend(500, 3000, 2, true); }
+TEST(ArrayExtendTest, SnapshotAddLevel) { test_extend(500, 50000, 3, true); }
+TEST(ArrayExtendTest, DroppedRoot) { test_extend(500, 3000, 2, true, true); }
+TEST(ArrayExtendTest, DroppedRootAddLevel) { test_extend(500, 50000, 3, true, true); }
+
+TEST(ArrayExtendTest, EvictAfterExtend) {
+  // a single leaf page holds 168 records. It's full, so extend() keeps its snapshot version
+  // as the first child of the new root, and the evictor can drop it right away.
+  const ArrayOffset kOldSize = 168;
+  const ArrayOffset kNewSize = 3000;
+  EngineOptions options = get_tiny_options();
+  options.memory_.page_pool_size_mb_per_node_ = 16;
+  options.snapshot_.volatile_page_evict_percent_ = 100;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("write_task", write_task);
+  engine.get_proc_manager()->pre_register("verify_task", verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ArrayStorage array;
+    ArrayMetadata meta(kName, sizeof(uint64_t), kOldSize);
+    Epoch commit_epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &array, &commit_epoch));
+    EXPECT_EQ(1U, array.get_levels());
+    write(&engine, 0, kOldSize);
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+
+    COERCE_ERROR(array.extend(kNewSize, &commit_epoch));
+    EXPECT_EQ(2U, array.get_levels());
+    const DualPagePointer& root_pointer = array.get_control_block()->root_page_pointer_;
+    EXPECT_EQ(0U, root_pointer.snapshot_pointer_);  // the new root has no snapshot version
+    const memory::GlobalVolatilePageResolver& resolver
+      = engine.get_memory_manager()->get_global_volatile_page_resolver();
+    ArrayPage* root = reinterpret_cast<ArrayPage*>(
+      resolver.resolve_offset(root_pointer.volatile_pointer_));
+    const DualPagePointer& old_root_pointer = root->get_interior_record(0);
+    EXPECT_NE(0U, old_root_pointer.snapshot_pointer_);
+
+    // the old root is not newer than the snapshot. wait until the evictor drops it.
+    for (uint32_t i = 0; i < 300U && !old_root_pointer.volatile_pointer_.is_null(); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    EXPECT_TRUE(old_root_pointer.volatile_pointer_.is_null());
+    EXPECT_FALSE(root_pointer.volatile_pointer_.is_null());
+
+    // the old records now come from the snapshot page
+    verify(&engine, kOldSize, xct::kDirtyRead);
+    write(&engine, kOldSize, kNewSize);
+    verify(&engine, kNewSize, xct::kDirtyRead);
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    verify(&engine, kNewSize, xct::kSnapshot);
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(ArrayExtendTest, Restart) {
+  const ArrayOffset kOldSize = 500;
+  const ArrayOffset kNewSize = 50000;
+  EngineOptions options = get_tiny_options();
+  options.memory_.page_pool_size_mb_per_node_ = 16;
+  options.restart_.enable_log_replay_ = true;
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("write_task", write_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      ArrayStorage array;
+      ArrayMetadata meta(kName, sizeof(uint64_t), kOldSize);
+      Epoch commit_epoch;
+      COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &array, &commit_epoch));
+      write(&engine, 0, kOldSize);
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      COERCE_ERROR(array.extend(kNewSize, &commit_epoch));
+      write(&engine, kOldSize, kNewSize);
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  {
+    // the snapshot has the old size. the extension is redone from the metadata log.
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("verify_task", verify_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      ArrayStorage array(&engine, kName);
+      EXPECT_TRUE(array.exists());
+      EXPECT_EQ(kNewSize, array.get_array_size());
+      verify(&engine, kNewSize, xct::kDirtyRead);
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+}  // namespace array
+}  // namespace storage
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(ArrayExtendTest, foedus.storage.array);
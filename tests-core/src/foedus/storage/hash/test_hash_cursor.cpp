@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/hash/hash_cursor.hpp"
+#include "foedus/storage/hash/hash_metadata.hpp"
+#include "foedus/storage/hash/hash_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_hash_cursor.cpp
+ * Full and partitioned scans with HashCursor over volatile and snapshot pages.
+ */
+namespace foedus {
+namespace storage {
+namespace hash {
+DEFINE_TEST_CASE_PACKAGE(HashCursorTest, foedus.storage.hash);
+
+const StorageName kName("test");
+const uint64_t kDataAddendum = 42U;
+const uint32_t kRecordsPerXct = 32U;
+
+struct ScanInput {
+  /** keys are 0 to records_ - 1 */
+  uint32_t records_;
+  /** every key k where k % deleted_modulo_ == 0 is deleted. 0 if no deletion */
+  uint32_t deleted_modulo_;
+  /** number of partitioned cursors. 0 for a full scan */
+  uint32_t partitions_;
+  xct::IsolationLevel isolation_;
+};
+
+bool is_deleted(const ScanInput* input, uint64_t key) {
+  return input->deleted_modulo_ > 0 && key % input->deleted_modulo_ == 0;
+}
+
+ErrorStack insert_task(const proc::ProcArguments& args) {
+  const ScanInput* input = reinterpret_cast<const ScanInput*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  HashStorage hash(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  for (uint32_t i = 0; i < input->records_; i += kRecordsPerXct) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint64_t key = i; key < input->records_ && key < i + kRecordsPerXct; ++key) {
+      uint64_t value = key + kDataAddendum;
+      WRAP_ERROR_CODE(hash.insert_record(context, &key, sizeof(key), &value, sizeof(value)));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t key = 0; key < input->records_; ++key) {
+    if (is_deleted(input, key)) {
+      WRAP_ERROR_CODE(hash.delete_record(context, &key, sizeof(key)));
+    }
+  }
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack scan_task(const proc::ProcArguments& args) {
+  const ScanInput* input = reinterpret_cast<const ScanInput*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  HashStorage hash(args.engine_, kName);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, input->isolation_));
+
+  std::vector<bool> found(input->records_, false);
+  const uint32_t cursors = input->partitions_ == 0 ? 1U : input->partitions_;
+  HashBin previous_end = 0;
+  for (uint32_t partition = 0; partition < cursors; ++partition) {
+    HashCursor cursor(hash, context);
+    if (input->partitions_ == 0) {
+      WRAP_ERROR_CODE(cursor.open());
+    } else {
+      HashBinRange range = HashCursor::get_partition_range(
+        hash.get_bin_count(),
+        partition,
+        input->partitions_);
+      EXPECT_EQ(previous_end, range.begin_);
+      previous_end = range.end_;
+      WRAP_ERROR_CODE(cursor.open_partition(partition, input->partitions_));
+    }
+
+    HashBin previous_bin = 0;
+    while (cursor.is_valid_record()) {
+      EXPECT_GE(cursor.get_cur_bin(), previous_bin);
+      previous_bin = cursor.get_cur_bin();
+      EXPECT_EQ(sizeof(uint64_t), cursor.get_key_length());
+      EXPECT_EQ(sizeof(uint64_t), cursor.get_payload_length());
+      uint64_t key;
+      uint64_t value;
+      std::memcpy(&key, cursor.get_key(), sizeof(key));
+      std::memcpy(&value, cursor.get_payload(), sizeof(value));
+      EXPECT_EQ(hashinate(&key, sizeof(key)), cursor.get_hash());
+      EXPECT_EQ(cursor.get_hash() >> hash.get_bin_shifts(), cursor.get_cur_bin());
+      EXPECT_LT(key, input->records_);
+      EXPECT_EQ(key + kDataAddendum, value) << key;
+      EXPECT_FALSE(is_deleted(input, key)) << key;
+      if (key < input->records_) {
+        EXPECT_FALSE(found[key]) << key;
+        found[key] = true;
+      }
+      WRAP_ERROR_CODE(cursor.next());
+    }
+  }
+  if (input->partitions_ > 0) {
+    EXPECT_EQ(hash.get_bin_count(), previous_end);
+  }
+  for (uint64_t key = 0; key < input->records_; ++key) {
+    EXPECT_EQ(!is_deleted(input, key), found[key]) << key;
+  }
+
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+void test_scan(
+  uint8_t bin_bits,
+  uint32_t records,
+  uint32_t deleted_modulo,
+  uint32_t partitions,
+  bool take_snapshot) {
+  EngineOptions options = get_tiny_options();
+  options.memory_.page_pool_size_mb_per_node_ = 20;
+  options.cache_.snapshot_cache_size_mb_per_node_ = 20;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("insert_task", insert_task);
+  engine.get_proc_manager()->pre_register("scan_task", scan_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    HashStorage out;
+    Epoch commit_epoch;
+    HashMetadata meta(kName, bin_bits);
+    COERCE_ERROR(engine.get_storage_manager()->create_hash(&meta, &out, &commit_epoch));
+    EXPECT_TRUE(out.exists());
+
+    ScanInput input = {records, deleted_modulo, partitions, xct::kSerializable};
+    thread::ThreadPool* pool = engine.get_thread_pool();
+    if (records > 0) {
+      COERCE_ERROR(pool->impersonate_synchronous("insert_task", &input, sizeof(input)));
+    }
+    COERCE_ERROR(pool->impersonate_synchronous("scan_task", &input, sizeof(input)));
+    if (take_snapshot) {
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      COERCE_ERROR(pool->impersonate_synchronous("scan_task", &input, sizeof(input)));
+      input.isolation_ = xct::kSnapshot;
+      COERCE_ERROR(pool->impersonate_synchronous("scan_task", &input, sizeof(input)));
+    }
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+// A serializable scan takes a page-version set for each non-empty volatile bin and a pointer
+// set for each empty volatile bin, both of which are bounded by xct::kMaxPointerSets.
+// So, we keep the number of bins small in these testcases.
+TEST(HashCursorTest, Empty) { test_scan(7, 0, 0, 0, false); }
+TEST(HashCursorTest, OneLevel) { test_scan(7, 1000, 0, 0, false); }
+TEST(HashCursorTest, TwoLevels) { test_scan(9, 3000, 0, 0, false); }
+TEST(HashCursorTest, Deleted) { test_scan(9, 1000, 3, 0, false); }
+TEST(HashCursorTest, Partitioned) { test_scan(9, 3000, 5, 7, false); }
+TEST(HashCursorTest, Snapshot) { test_scan(9, 3000, 3, 0, true); }
+TEST(HashCursorTest, SnapshotPartitioned) { test_scan(9, 3000, 3, 4, true); }
+
+}  // namespace hash
+}  // namespace storage
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(HashCursorTest, foedus.storage.hash);
@@ -282,9 +282,12 @@ void SortBasicFunctor(Partitioner partitioner, uint32_t /*records*/) {
     uint32_t cur_ordinal = cur->header_.xct_id_.get_ordinal();
     uint32_t pre_ordinal = pre->header_.xct_id_.get_ordinal();
 
-    // results should be ordered by bins
-    EXPECT_TRUE(pre_bin < cur_bin
-      || (pre_bin == cur_bin && pre_ordinal <= cur_ordinal)) << i;
+    // results should be ordered by bins, in the finest bins then by ordinals
+    EXPECT_LE(pre_bin, cur_bin) << i;
+    HashBin cur_sort_bin = cur->get_sort_bin();
+    HashBin pre_sort_bin = pre->get_sort_bin();
+    EXPECT_TRUE(pre_sort_bin < cur_sort_bin
+      || (pre_sort_bin == cur_sort_bin && pre_ordinal <= cur_ordinal)) << i;
   }
 }
 TEST(HashPartitionerTest, Empty) { execute_test(&EmptyFunctor, 16); }
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/hash/hash_id.hpp"
+#include "foedus/storage/hash/hash_metadata.hpp"
+#include "foedus/storage/hash/hash_storage.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_hash_resize.cpp
+ * Resizing hash storage in snapshots, requested manually or by the chain length threshold.
+ */
+namespace foedus {
+namespace storage {
+namespace hash {
+DEFINE_TEST_CASE_PACKAGE(HashResizeTest, foedus.storage.hash);
+
+const StorageName kName("test");
+const uint64_t kDataAddendum = 42U;
+const uint32_t kRecordsPerXct = 32U;
+const uint16_t kMaxPayload = 1024U;
+
+struct InsertInput {
+  uint32_t from_;
+  uint32_t count_;
+  uint16_t payload_;
+};
+
+ErrorStack insert_task(const proc::ProcArguments& args) {
+  EXPECT_EQ(sizeof(InsertInput), args.input_len_);
+  const InsertInput* input = reinterpret_cast<const InsertInput*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  HashStorage hash(args.engine_, kName);
+  ASSERT_ND(hash.exists());
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  char data[kMaxPayload];
+  std::memset(data, 0, sizeof(data));
+  Epoch commit_epoch;
+  for (uint32_t i = 0; i < input->count_; i += kRecordsPerXct) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint32_t j = i; j < input->count_ && j < i + kRecordsPerXct; ++j) {
+      uint64_t key = input->from_ + j;
+      uint64_t value = key + kDataAddendum;
+      std::memcpy(data, &value, sizeof(value));
+      WRAP_ERROR_CODE(hash.insert_record(context, &key, sizeof(key), data, input->payload_));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack verify_task(const proc::ProcArguments& args) {
+  EXPECT_EQ(sizeof(InsertInput), args.input_len_);
+  const InsertInput* input = reinterpret_cast<const InsertInput*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  HashStorage hash(args.engine_, kName);
+  ASSERT_ND(hash.exists());
+  CHECK_ERROR(hash.verify_single_thread(context));
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+
+  char data[kMaxPayload];
+  for (uint32_t i = 0; i < input->count_; ++i) {
+    uint64_t key = input->from_ + i;
+    uint16_t capacity = sizeof(data);
+    ErrorCode ret = hash.get_record(context, &key, sizeof(key), data, &capacity);
+    EXPECT_EQ(kErrorCodeOk, ret) << key;
+    EXPECT_EQ(input->payload_, capacity) << key;
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    EXPECT_EQ(key + kDataAddendum, value) << key;
+  }
+  // and the next key should not exist
+  uint64_t key = input->from_ + input->count_;
+  uint16_t capacity = sizeof(data);
+  EXPECT_EQ(kErrorCodeStrKeyNotFound, hash.get_record(context, &key, sizeof(key), data, &capacity));
+
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+EngineOptions make_options() {
+  EngineOptions options = get_tiny_options();
+  options.memory_.page_pool_size_mb_per_node_ = 20;
+  options.cache_.snapshot_cache_size_mb_per_node_ = 20;
+  return options;
+}
+
+void register_procs(Engine* engine) {
+  engine->get_proc_manager()->pre_register("insert_task", insert_task);
+  engine->get_proc_manager()->pre_register("verify_task", verify_task);
+}
+
+void insert(Engine* engine, uint32_t from, uint32_t count, uint16_t payload) {
+  InsertInput input = {from, count, payload};
+  COERCE_ERROR(engine->get_thread_pool()->impersonate_synchronous(
+    "insert_task",
+    &input,
+    sizeof(input)));
+}
+
+void verify(Engine* engine, uint32_t count, uint16_t payload) {
+  InsertInput input = {0, count, payload};
+  COERCE_ERROR(engine->get_thread_pool()->impersonate_synchronous(
+    "verify_task",
+    &input,
+    sizeof(input)));
+}
+
+/**
+ * Manually resize to bin_bits + 1, then keep inserting with the new bins and
+ * make sure the resized storage survives the next snapshot and restart.
+ */
+void test_manual(uint8_t bin_bits, uint32_t records) {
+  const uint16_t kPayload = sizeof(uint64_t);
+  EngineOptions options = make_options();
+  {
+    Engine engine(options);
+    register_procs(&engine);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      HashStorage out;
+      Epoch commit_epoch;
+      HashMetadata meta(kName, bin_bits);
+      COERCE_ERROR(engine.get_storage_manager()->create_hash(&meta, &out, &commit_epoch));
+      EXPECT_TRUE(out.exists());
+
+      // these are invalid
+      EXPECT_TRUE(out.request_resize(bin_bits).is_error());
+      EXPECT_TRUE(out.request_resize(kHashMaxBinBits + 1U).is_error());
+
+      insert(&engine, 0, records, kPayload);
+      COERCE_ERROR(out.request_resize(bin_bits + 1U));
+      EXPECT_EQ(bin_bits, out.get_bin_bits());  // not yet
+      verify(&engine, records, kPayload);
+
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      EXPECT_EQ(bin_bits + 1U, out.get_bin_bits());
+      EXPECT_EQ(bins_to_level(1ULL << (bin_bits + 1U)), out.get_levels());
+      verify(&engine, records, kPayload);
+
+      // more records on the resized volatile pages, then another snapshot without resize
+      insert(&engine, records, records, kPayload);
+      verify(&engine, records * 2U, kPayload);
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      EXPECT_EQ(bin_bits + 1U, out.get_bin_bits());
+      verify(&engine, records * 2U, kPayload);
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  {
+    Engine engine(options);
+    register_procs(&engine);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      HashStorage out(&engine, kName);
+      EXPECT_EQ(bin_bits + 1U, out.get_bin_bits());
+      verify(&engine, records * 2U, kPayload);
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+TEST(HashResizeTest, OneLevelToTwoLevels) { test_manual(kHashMinBinBits, 1024U); }
+TEST(HashResizeTest, TwoLevels) { test_manual(kHashMinBinBits + 4U, 2048U); }
+
+TEST(HashResizeTest, ChainLengthThreshold) {
+  // large records so that each bin needs a few pages
+  const uint16_t kPayload = 1000U;
+  const uint32_t kRecords = 1U << (kHashMinBinBits + 3U);
+  EngineOptions options = make_options();
+  {
+    Engine engine(options);
+    register_procs(&engine);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      HashStorage out;
+      Epoch commit_epoch;
+      HashMetadata meta(kName, kHashMinBinBits);
+      meta.resize_chain_length_threshold_ = 150U;
+      COERCE_ERROR(engine.get_storage_manager()->create_hash(&meta, &out, &commit_epoch));
+      EXPECT_TRUE(out.exists());
+
+      insert(&engine, 0, kRecords, kPayload);
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      // this snapshot found long chains and requested a resize for the next snapshot
+      EXPECT_EQ(kHashMinBinBits, out.get_bin_bits());
+
+      insert(&engine, kRecords, kRecords, kPayload);
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      EXPECT_EQ(kHashMinBinBits + 1U, out.get_bin_bits());
+      verify(&engine, kRecords * 2U, kPayload);
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  {
+    Engine engine(options);
+    register_procs(&engine);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      HashStorage out(&engine, kName);
+      EXPECT_EQ(kHashMinBinBits + 1U, out.get_bin_bits());
+      EXPECT_EQ(150U, out.get_hash_metadata()->resize_chain_length_threshold_);
+      verify(&engine, kRecords * 2U, kPayload);
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+}  // namespace hash
+}  // namespace storage
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(HashResizeTest, foedus.storage.hash);
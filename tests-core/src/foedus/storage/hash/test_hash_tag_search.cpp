@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include "foedus/test_common.hpp"
+#include "foedus/assorted/uniform_random.hpp"
+#include "foedus/memory/aligned_memory.hpp"
+#include "foedus/storage/hash/hash_hashinate.hpp"
+#include "foedus/storage/hash/hash_page_impl.hpp"
+#include "foedus/storage/hash/hash_tag_search.hpp"
+#include "foedus/xct/xct_id.hpp"
+
+/**
+ * @file test_hash_tag_search.cpp
+ * Vectorized 8-bit hash tag search in data pages.
+ */
+namespace foedus {
+namespace storage {
+namespace hash {
+DEFINE_TEST_CASE_PACKAGE(HashTagSearchTest, foedus.storage.hash);
+
+TEST(HashTagSearchTest, Empty) {
+  uint8_t tags[kHashTagSearchBatch];
+  for (uint16_t i = 0; i < kHashTagSearchBatch; ++i) {
+    tags[i] = 42U;
+  }
+  EXPECT_EQ(0U, match_tags(tags, 0, 42U));
+  EXPECT_EQ(0U, match_tags_scalar(tags, 0, 42U));
+}
+
+TEST(HashTagSearchTest, AllMatch) {
+  std::cout << "implementation: " << get_tag_search_implementation() << std::endl;
+  uint8_t tags[kHashTagSearchBatch];
+  for (uint16_t i = 0; i < kHashTagSearchBatch; ++i) {
+    tags[i] = 0xFFU;
+  }
+  for (uint16_t count = 1; count <= kHashTagSearchBatch; ++count) {
+    const uint32_t expected = count == 32U ? ~0U : (1U << count) - 1U;
+    EXPECT_EQ(expected, match_tags(tags, count, 0xFFU)) << count;
+    EXPECT_EQ(0U, match_tags(tags, count, 0)) << count;
+  }
+}
+
+TEST(HashTagSearchTest, Random) {
+  assorted::UniformRandom rnd(123456L);
+  // a few more than the batch so that we can also test unaligned starting positions.
+  uint8_t tags[kHashTagSearchBatch + 8U];
+  for (uint32_t rep = 0; rep < 100U; ++rep) {
+    // few distinct values so that we have many matches
+    for (uint16_t i = 0; i < kHashTagSearchBatch + 8U; ++i) {
+      tags[i] = 0x7EU + rnd.next_uint32() % 4U;
+    }
+    const uint8_t tag = 0x7EU + rnd.next_uint32() % 4U;
+    for (uint16_t from = 0; from < 8U; ++from) {
+      for (uint16_t count = 0; count <= kHashTagSearchBatch; ++count) {
+        const uint32_t result = match_tags(tags + from, count, tag);
+        EXPECT_EQ(match_tags_scalar(tags + from, count, tag), result)
+          << rep << "," << from << "," << count;
+        for (uint16_t i = 0; i < count; ++i) {
+          EXPECT_EQ(tags[from + i] == tag, ((result >> i) & 1U) != 0) << i;
+        }
+      }
+    }
+  }
+}
+
+TEST(HashTagSearchTest, TagDistribution) {
+  // records in the same page share the high bits (bin). tags must still vary.
+  std::set<uint8_t> tags;
+  for (uint64_t i = 0; i < 1024U; ++i) {
+    tags.insert(extract_hash_tag(0xABCDEF0000000000ULL | (i << 12)));
+  }
+  EXPECT_GT(tags.size(), 200U);
+}
+
+TEST(HashTagSearchTest, FullPage) {
+  // fill a snapshot page with the smallest records. the tags must cover all of them.
+  const uint8_t kBinBits = 4;
+  const uint8_t kBinShifts = 64U - kBinBits;
+  memory::AlignedMemory memory;
+  memory.alloc(kPageSize, kPageSize, memory::AlignedMemory::kPosixMemalign, 0);
+  HashDataPage* page = reinterpret_cast<HashDataPage*>(memory.get_block());
+  page->initialize_snapshot_page(1, 1, 0, kBinBits, kBinShifts);
+
+  xct::XctId xct_id;
+  xct_id.set(1, 1);
+  std::vector<uint64_t> keys;
+  std::vector<uint64_t> others;
+  for (uint64_t key = 0; keys.size() < kHashDataPageTagCount * 2U; ++key) {
+    HashValue hash = hashinate(&key, sizeof(key));
+    if ((hash >> kBinShifts) != 0) {
+      continue;
+    }
+    if (page->available_space() >= HashDataPage::required_space(1U, 0)) {
+      page->create_record_in_snapshot(
+        xct_id,
+        hash,
+        DataPageBloomFilter::extract_fingerprint(hash),
+        &key,
+        sizeof(key),
+        nullptr,
+        0);
+      keys.push_back(key);
+    } else {
+      others.push_back(key);
+      if (others.size() >= 100U) {
+        break;
+      }
+    }
+  }
+  std::cout << page->get_record_count() << " records in a page" << std::endl;
+  EXPECT_LE(page->get_record_count(), kHashDataPageTagCount);
+  EXPECT_EQ(keys.size(), page->get_record_count());
+  page->assert_entries();
+
+  for (uint16_t i = 0; i < keys.size(); ++i) {
+    HashValue hash = hashinate(&keys[i], sizeof(uint64_t));
+    EXPECT_EQ(extract_hash_tag(hash), page->get_tag(i));
+    xct::XctId observed;
+    EXPECT_EQ(i, page->search_key(
+      hash,
+      DataPageBloomFilter::extract_fingerprint(hash),
+      &keys[i],
+      sizeof(uint64_t),
+      page->get_record_count(),
+      &observed)) << i;
+    EXPECT_EQ(xct_id, observed);
+  }
+  for (uint64_t key : others) {
+    HashValue hash = hashinate(&key, sizeof(key));
+    xct::XctId observed;
+    EXPECT_EQ(kSlotNotFound, page->search_key(
+      hash,
+      DataPageBloomFilter::extract_fingerprint(hash),
+      &key,
+      sizeof(key),
+      page->get_record_count(),
+      &observed)) << key;
+  }
+}
+
+TEST(HashTagSearchTest, FullPageMinimalRecords) {
+  // the smallest records: 1-byte keys without payload. the page must be full at the tag count
+  // even though there are still a few bytes left.
+  const uint8_t kBinBits = 1;
+  const uint8_t kBinShifts = 64U - kBinBits;
+  memory::AlignedMemory memory;
+  memory.alloc(kPageSize, kPageSize, memory::AlignedMemory::kPosixMemalign, 0);
+  HashDataPage* page = reinterpret_cast<HashDataPage*>(memory.get_block());
+  page->initialize_snapshot_page(1, 1, 0, kBinBits, kBinShifts);
+
+  xct::XctId xct_id;
+  xct_id.set(1, 1);
+  // 1-byte keys, each in its own 8-byte aligned slot as create_record_in_snapshot() requires
+  std::vector<uint64_t> keys;
+  for (uint64_t key = 0; key < 256U; ++key) {
+    HashValue hash = hashinate(&key, 1U);
+    if ((hash >> kBinShifts) != 0) {
+      continue;
+    }
+    if (page->available_space() < HashDataPage::required_space(1U, 0)) {
+      break;
+    }
+    page->create_record_in_snapshot(
+      xct_id,
+      hash,
+      DataPageBloomFilter::extract_fingerprint(hash),
+      &key,
+      1U,
+      nullptr,
+      0);
+    keys.push_back(key);
+  }
+  EXPECT_EQ(kHashDataPageTagCount, page->get_record_count());
+  EXPECT_EQ(keys.size(), page->get_record_count());
+  // without the tag-count check, a record with an empty key would still fit here.
+  EXPECT_EQ(0U, page->available_space());
+  EXPECT_LT(page->available_space(), HashDataPage::required_space(0, 0));
+
+  for (uint16_t i = 0; i < keys.size(); ++i) {
+    HashValue hash = hashinate(&keys[i], 1U);
+    EXPECT_EQ(extract_hash_tag(hash), page->get_tag(i));
+    xct::XctId observed;
+    EXPECT_EQ(i, page->search_key(
+      hash,
+      DataPageBloomFilter::extract_fingerprint(hash),
+      &keys[i],
+      sizeof(uint8_t),
+      page->get_record_count(),
+      &observed)) << i;
+  }
+}
+
+}  // namespace hash
+}  // namespace storage
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(HashTagSearchTest, foedus.storage.hash);
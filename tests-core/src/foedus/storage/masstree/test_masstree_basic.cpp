@@ -20,6 +20,7 @@
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
@@ -27,12 +28,17 @@
 #include "foedus/test_common.hpp"
 #include "foedus/assorted/uniform_random.hpp"
 #include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/soc/shared_memory_repo.hpp"
+#include "foedus/soc/shared_rendezvous.hpp"
+#include "foedus/soc/soc_manager.hpp"
 #include "foedus/storage/storage_manager.hpp"
 #include "foedus/storage/hash/hash_hashinate.hpp"
 #include "foedus/storage/masstree/masstree_metadata.hpp"
 #include "foedus/storage/masstree/masstree_storage.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
@@ -578,6 +584,230 @@ TEST(MasstreeBasicTest, ExpandInsertNormalized) { test_expand(false, true, false
 TEST(MasstreeBasicTest, ExpandUpdate) { test_expand(true, false, false); }
 TEST(MasstreeBasicTest, ExpandUpdateNextLayer) { test_expand(true, false, true); }
 TEST(MasstreeBasicTest, ExpandUpdateNormalized) { test_expand(true, true, false); }
+
+const uint32_t kIncrementRecords = 64U;
+const uint32_t kIncrementThreads = 4U;
+const uint32_t kIncrementsPerThread = 200U;
+
+/** Records for increment tests have two uint64_t. The first is the key, then the counter. */
+struct CounterRecord {
+  uint64_t key_;
+  uint64_t counter_;
+};
+
+ErrorStack increment_insert_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree(args.engine_, "inc");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t key = 0; key < kIncrementRecords; ++key) {
+    CounterRecord record = {key, 0};
+    WRAP_ERROR_CODE(masstree.insert_record_normalized(context, key, &record, sizeof(record)));
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+
+  // errors are detected at the time of the call, not at the commit
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  EXPECT_EQ(
+    kErrorCodeStrKeyNotFound,
+    masstree.increment_record_oneshot_normalized<uint64_t>(context, kIncrementRecords, 1U, 0));
+  EXPECT_EQ(
+    kErrorCodeStrTooShortPayload,
+    masstree.increment_record_oneshot_normalized<uint64_t>(context, 1U, 1U, 12U));
+  EXPECT_EQ(0U, context->get_current_xct().get_write_set_size());
+  WRAP_ERROR_CODE(xct_manager->abort_xct(context));
+  return kRetOk;
+}
+
+ErrorStack increment_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree(args.engine_, "inc");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  for (uint32_t i = 0; i < kIncrementsPerThread;) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint64_t key = 0; key < kIncrementRecords; ++key) {
+      WRAP_ERROR_CODE(masstree.increment_record_oneshot_normalized<uint64_t>(
+        context,
+        key,
+        key + 1U,
+        sizeof(uint64_t)));
+    }
+    // blind increments never take read-sets
+    EXPECT_EQ(0U, context->get_current_xct().get_read_set_size());
+    EXPECT_EQ(kIncrementRecords, context->get_current_xct().get_write_set_size());
+    ErrorCode result = xct_manager->precommit_xct(context, &commit_epoch);
+    if (result == kErrorCodeXctRaceAbort) {
+      continue;
+    }
+    WRAP_ERROR_CODE(result);
+    ++i;
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack increment_verify_task(const proc::ProcArguments& args) {
+  const xct::IsolationLevel* isolation
+    = reinterpret_cast<const xct::IsolationLevel*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree(args.engine_, "inc");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, *isolation));
+  for (uint64_t key = 0; key < kIncrementRecords; ++key) {
+    CounterRecord record;
+    PayloadLength capacity = sizeof(record);
+    WRAP_ERROR_CODE(masstree.get_record_normalized(context, key, &record, &capacity));
+    EXPECT_EQ(sizeof(record), capacity) << key;
+    EXPECT_EQ(key, record.key_) << key;
+    EXPECT_EQ((key + 1U) * kIncrementsPerThread * kIncrementThreads, record.counter_) << key;
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+TEST(MasstreeBasicTest, Increment) {
+  EngineOptions options = get_tiny_options();
+  options.log_.log_buffer_kb_ = 1 << 12;
+  options.thread_.thread_count_per_group_ = kIncrementThreads;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("increment_insert_task", increment_insert_task);
+  engine.get_proc_manager()->pre_register("increment_task", increment_task);
+  engine.get_proc_manager()->pre_register("increment_verify_task", increment_verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("inc");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    thread::ThreadPool* pool = engine.get_thread_pool();
+    COERCE_ERROR(pool->impersonate_synchronous("increment_insert_task"));
+    std::vector<thread::ImpersonateSession> sessions;
+    for (uint32_t i = 0; i < kIncrementThreads; ++i) {
+      thread::ImpersonateSession session;
+      EXPECT_TRUE(pool->impersonate("increment_task", nullptr, 0, &session));
+      sessions.emplace_back(std::move(session));
+    }
+    for (uint32_t i = 0; i < kIncrementThreads; ++i) {
+      COERCE_ERROR(sessions[i].get_result());
+      sessions[i].release();
+    }
+
+    xct::IsolationLevel isolation = xct::kSerializable;
+    COERCE_ERROR(pool->impersonate_synchronous(
+      "increment_verify_task",
+      &isolation,
+      sizeof(isolation)));
+    // the composer applies the increment logs on top of the snapshot
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    isolation = xct::kSnapshot;
+    COERCE_ERROR(pool->impersonate_synchronous(
+      "increment_verify_task",
+      &isolation,
+      sizeof(isolation)));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+/**
+ * Blind-increments key 0 and, before committing, lets another thread delete the record and
+ * re-insert it with a payload too short for the increment. The commit must abort.
+ */
+ErrorStack blind_increment_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  soc::SharedRendezvous* rendezvous = reinterpret_cast<soc::SharedRendezvous*>(
+    args.engine_->get_soc_manager()->get_shared_memory_repo()->get_global_user_memory());
+  MasstreeStorage masstree(args.engine_, "inc");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  WRAP_ERROR_CODE(masstree.increment_record_oneshot_normalized<uint64_t>(
+    context,
+    0,
+    1U,
+    sizeof(uint64_t)));
+  rendezvous[0].signal();  // incremented
+  rendezvous[1].wait();  // re-inserted
+  Epoch commit_epoch;
+  EXPECT_EQ(kErrorCodeXctRaceAbort, xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack shrink_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree(args.engine_, "inc");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  WRAP_ERROR_CODE(masstree.delete_record_normalized(context, 0));
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  uint64_t short_payload = 42U;
+  WRAP_ERROR_CODE(masstree.insert_record_normalized(
+    context,
+    0,
+    &short_payload,
+    sizeof(short_payload)));
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack shrink_verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree(args.engine_, "inc");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  CounterRecord record;
+  PayloadLength capacity = sizeof(record);
+  WRAP_ERROR_CODE(masstree.get_record_normalized(context, 0, &record, &capacity));
+  EXPECT_EQ(sizeof(uint64_t), capacity);
+  EXPECT_EQ(42U, record.key_);
+  CHECK_ERROR(masstree.verify_single_thread(context));
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+TEST(MasstreeBasicTest, IncrementShrunkRecord) {
+  EngineOptions options = get_tiny_options();
+  options.thread_.thread_count_per_group_ = 2;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("increment_insert_task", increment_insert_task);
+  engine.get_proc_manager()->pre_register("blind_increment_task", blind_increment_task);
+  engine.get_proc_manager()->pre_register("shrink_task", shrink_task);
+  engine.get_proc_manager()->pre_register("shrink_verify_task", shrink_verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("inc");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    thread::ThreadPool* pool = engine.get_thread_pool();
+    COERCE_ERROR(pool->impersonate_synchronous("increment_insert_task"));
+    soc::SharedRendezvous* rendezvous = reinterpret_cast<soc::SharedRendezvous*>(
+      engine.get_soc_manager()->get_shared_memory_repo()->get_global_user_memory());
+    rendezvous[0].initialize();
+    rendezvous[1].initialize();
+    thread::ImpersonateSession session;
+    EXPECT_TRUE(pool->impersonate("blind_increment_task", nullptr, 0, &session));
+    rendezvous[0].wait();
+    COERCE_ERROR(pool->impersonate_synchronous("shrink_task"));
+    rendezvous[1].signal();
+    COERCE_ERROR(session.get_result());
+    session.release();
+    rendezvous[0].uninitialize();
+    rendezvous[1].uninitialize();
+    COERCE_ERROR(pool->impersonate_synchronous("shrink_verify_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
 // TASK(Hideaki): we don't have multi-thread cases here. it's not a "basic" test.
 // no multi-key cases either.
 
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include "foedus/test_common.hpp"
+#include "foedus/assorted/uniform_random.hpp"
+#include "foedus/storage/masstree/masstree_id.hpp"
+#include "foedus/storage/masstree/masstree_slice_search.hpp"
+
+namespace foedus {
+namespace storage {
+namespace masstree {
+DEFINE_TEST_CASE_PACKAGE(MasstreeSliceSearchTest, foedus.storage.masstree);
+
+// a few more than the batch so that we can also test unaligned starting positions.
+const uint32_t kSlices = kSliceSearchBatch + 8U;
+// same as kMaxIntermediateMiniSeparators
+const uint8_t kMaxSeparators = 15U;
+
+TEST(MasstreeSliceSearchTest, Empty) {
+  KeySlice slices[kSlices];
+  for (uint32_t i = 0; i < kSlices; ++i) {
+    slices[i] = 42U;
+  }
+  EXPECT_EQ(0U, match_slices(slices, 0, 42U));
+  EXPECT_EQ(0U, match_slices_scalar(slices, 0, 42U));
+}
+
+TEST(MasstreeSliceSearchTest, AllMatch) {
+  std::cout << "implementation: " << get_slice_search_implementation() << std::endl;
+  KeySlice slices[kSlices];
+  for (uint32_t i = 0; i < kSlices; ++i) {
+    slices[i] = kSupremumSlice;
+  }
+  for (SlotIndex count = 1; count <= kSliceSearchBatch; ++count) {
+    const uint64_t expected = count == 64U ? ~0ULL : (1ULL << count) - 1U;
+    EXPECT_EQ(expected, match_slices(slices, count, kSupremumSlice)) << count;
+    EXPECT_EQ(0U, match_slices(slices, count, kInfimumSlice)) << count;
+  }
+}
+
+TEST(MasstreeSliceSearchTest, HalfMatch) {
+  // only one of the two 32-bit halves matches. SSE2 path must not report them.
+  KeySlice slices[kSlices];
+  const KeySlice kKey = 0x0123456789ABCDEFULL;
+  for (uint32_t i = 0; i < kSlices; ++i) {
+    if (i % 3U == 0) {
+      slices[i] = kKey;
+    } else if (i % 3U == 1U) {
+      slices[i] = (kKey & 0xFFFFFFFF00000000ULL) | 0x12345678U;
+    } else {
+      slices[i] = (kKey & 0x00000000FFFFFFFFULL) | 0x1234567800000000ULL;
+    }
+  }
+  for (SlotIndex from = 0; from < 8U; ++from) {
+    for (SlotIndex count = 0; count <= kSliceSearchBatch; ++count) {
+      EXPECT_EQ(
+        match_slices_scalar(slices + from, count, kKey),
+        match_slices(slices + from, count, kKey)) << from << "," << count;
+    }
+  }
+}
+
+TEST(MasstreeSliceSearchTest, Random) {
+  assorted::UniformRandom rnd(123456L);
+  KeySlice slices[kSlices];
+  for (uint32_t rep = 0; rep < 100U; ++rep) {
+    // few distinct values so that we have many matches
+    for (uint32_t i = 0; i < kSlices; ++i) {
+      slices[i] = static_cast<KeySlice>(rnd.next_uint32() % 4U) << 40;
+    }
+    const KeySlice key = static_cast<KeySlice>(rnd.next_uint32() % 4U) << 40;
+    for (SlotIndex from = 0; from < 8U; ++from) {
+      for (SlotIndex count = 0; count <= kSliceSearchBatch; ++count) {
+        const uint64_t result = match_slices(slices + from, count, key);
+        EXPECT_EQ(match_slices_scalar(slices + from, count, key), result)
+          << rep << "," << from << "," << count;
+        for (SlotIndex i = 0; i < count; ++i) {
+          EXPECT_EQ(slices[from + i] == key, ((result >> i) & 1U) != 0) << i;
+        }
+      }
+    }
+  }
+}
+
+/** the loop find_minipage()/find_pointer() used to have */
+uint8_t find_separator_loop(const KeySlice* separators, uint8_t count, KeySlice slice) {
+  for (uint8_t i = 0; i < count; ++i) {
+    if (slice < separators[i]) {
+      return i;
+    }
+  }
+  return count;
+}
+
+TEST(MasstreeSliceSearchTest, Separators) {
+  std::cout << "implementation: " << get_separator_search_implementation() << std::endl;
+  // KeySlice is unsigned. Values with the highest bit on must come after others.
+  const KeySlice kSeparators[] = {
+    1ULL,
+    1000ULL,
+    0x7FFFFFFFFFFFFFFFULL,
+    0x8000000000000000ULL,
+    0x8000000000000001ULL,
+    0xF000000000000000ULL,
+  };
+  const uint8_t kCount = sizeof(kSeparators) / sizeof(KeySlice);
+  for (uint8_t count = 0; count <= kCount; ++count) {
+    for (uint8_t i = 0; i < kCount; ++i) {
+      const KeySlice keys[] = {kSeparators[i] - 1U, kSeparators[i], kSeparators[i] + 1U};
+      for (KeySlice key : keys) {
+        EXPECT_EQ(
+          find_separator_loop(kSeparators, count, key),
+          find_separator(kSeparators, count, key)) << static_cast<int>(count) << "," << key;
+      }
+    }
+    EXPECT_EQ(0, find_separator(kSeparators, count, kInfimumSlice));
+    EXPECT_EQ(count, find_separator(kSeparators, count, kSupremumSlice));
+  }
+}
+
+TEST(MasstreeSliceSearchTest, SeparatorsRandom) {
+  assorted::UniformRandom rnd(654321L);
+  KeySlice separators[kMaxSeparators];
+  for (uint32_t rep = 0; rep < 1000U; ++rep) {
+    const uint8_t count = rnd.next_uint32() % (kMaxSeparators + 1U);
+    for (uint8_t i = 0; i < count; ++i) {
+      separators[i] = (static_cast<KeySlice>(rnd.next_uint32()) << 32) | rnd.next_uint32();
+    }
+    std::sort(separators, separators + count);
+    for (uint32_t q = 0; q < 20U; ++q) {
+      KeySlice key;
+      if (count > 0 && q % 2U == 0) {
+        key = separators[rnd.next_uint32() % count] + (q % 4U == 0 ? 0 : 1U);
+      } else {
+        key = (static_cast<KeySlice>(rnd.next_uint32()) << 32) | rnd.next_uint32();
+      }
+      const uint8_t expected = find_separator_loop(separators, count, key);
+      EXPECT_EQ(expected, find_separator(separators, count, key)) << rep << "," << q;
+      EXPECT_EQ(expected, find_separator_scalar(separators, count, key)) << rep << "," << q;
+    }
+  }
+}
+
+}  // namespace masstree
+}  // namespace storage
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(MasstreeSliceSearchTest, foedus.storage.masstree);
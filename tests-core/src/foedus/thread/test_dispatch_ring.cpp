@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <stdint.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/soc/shared_memory_repo.hpp"
+#include "foedus/soc/shared_polling.hpp"
+#include "foedus/soc/soc_manager.hpp"
+#include "foedus/thread/dispatch_ring.hpp"
+#include "foedus/thread/impersonate_session.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pimpl.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/thread/thread_ref.hpp"
+
+/**
+ * @file test_dispatch_ring.cpp
+ * Dispatching procedures via DispatchRing instead of impersonation.
+ */
+namespace foedus {
+namespace thread {
+DEFINE_TEST_CASE_PACKAGE(DispatchRingTest, foedus.thread);
+
+struct DispatchOutput {
+  uint64_t  doubled_;
+  ThreadId  executed_by_;
+};
+
+ErrorStack double_task(const proc::ProcArguments& args) {
+  EXPECT_EQ(sizeof(uint64_t), args.input_len_);
+  uint64_t input = *reinterpret_cast<const uint64_t*>(args.input_buffer_);
+  if (input % 7U == 3U) {
+    return ERROR_STACK(kErrorCodeInvalidParameter);
+  }
+  DispatchOutput* output = reinterpret_cast<DispatchOutput*>(args.output_buffer_);
+  output->doubled_ = input * 2U;
+  output->executed_by_ = args.context_->get_thread_id();
+  *args.output_used_ = sizeof(DispatchOutput);
+  return kRetOk;
+}
+
+/** Occupies the thread until the flag in global user memory is set. */
+ErrorStack block_task(const proc::ProcArguments& args) {
+  void* user_memory
+    = args.engine_->get_soc_manager()->get_shared_memory_repo()->get_global_user_memory();
+  std::atomic<bool>* released = reinterpret_cast<std::atomic<bool>*>(user_memory);
+  while (!released->load()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return kRetOk;
+}
+
+void register_procs(Engine* engine) {
+  engine->get_proc_manager()->pre_register("double_task", double_task);
+  engine->get_proc_manager()->pre_register("block_task", block_task);
+}
+
+void verify_result(uint64_t input, ErrorCode result, const DispatchOutput& output) {
+  if (input % 7U == 3U) {
+    EXPECT_EQ(kErrorCodeInvalidParameter, result) << input;
+  } else {
+    EXPECT_EQ(kErrorCodeOk, result) << input;
+    EXPECT_EQ(input * 2U, output.doubled_) << input;
+  }
+}
+
+TEST(DispatchRingTest, Basic) {
+  EngineOptions options = get_tiny_options();
+  options.thread_.thread_count_per_group_ = 1;  // no stealing
+  Engine engine(options);
+  register_procs(&engine);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ThreadPool* pool = engine.get_thread_pool();
+    // more than the ring size, so we collect in windows.
+    const uint64_t kWindow = DispatchRing::kSlots / 2U;
+    for (uint64_t base = 0; base < DispatchRing::kSlots * 4U; base += kWindow) {
+      std::vector<DispatchTicket> tickets(kWindow);
+      for (uint64_t i = 0; i < kWindow; ++i) {
+        uint64_t input = base + i;
+        EXPECT_EQ(
+          kErrorCodeOk,
+          pool->dispatch(0, "double_task", &input, sizeof(input), &tickets[i]));
+      }
+      for (uint64_t i = 0; i < kWindow; ++i) {
+        DispatchOutput output;
+        uint32_t output_size = 0;
+        ErrorCode result
+          = pool->collect_dispatch(tickets[i], &output, sizeof(output), &output_size);
+        verify_result(base + i, result, output);
+        if (result == kErrorCodeOk) {
+          EXPECT_EQ(sizeof(output), output_size);
+          EXPECT_EQ(0, output.executed_by_);
+        }
+      }
+    }
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(DispatchRingTest, Errors) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  register_procs(&engine);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ThreadPool* pool = engine.get_thread_pool();
+    DispatchTicket ticket;
+    char large_input[DispatchSlot::kInputSize + 1];
+    EXPECT_EQ(
+      kErrorCodeThrDispatchTooLarge,
+      pool->dispatch(0, "double_task", large_input, sizeof(large_input), &ticket));
+
+    EXPECT_EQ(kErrorCodeOk, pool->dispatch(0, "no_such_task", nullptr, 0, &ticket));
+    EXPECT_EQ(kErrorCodeProcNotFound, pool->collect_dispatch(ticket));
+    // already collected
+    EXPECT_EQ(kErrorCodeSessionExpired, pool->collect_dispatch(ticket));
+
+    // completed but uncollected invocations keep their slots.
+    std::vector<DispatchTicket> tickets(DispatchRing::kSlots);
+    for (uint64_t i = 0; i < DispatchRing::kSlots; ++i) {
+      EXPECT_EQ(kErrorCodeOk, pool->dispatch(0, "double_task", &i, sizeof(i), &tickets[i]));
+    }
+    uint64_t input = 0;
+    EXPECT_EQ(
+      kErrorCodeThrDispatchRingFull,
+      pool->dispatch(0, "double_task", &input, sizeof(input), &ticket));
+    std::vector<ErrorCode> results(DispatchRing::kSlots);
+    uint32_t succeeded = pool->collect_dispatches(DispatchRing::kSlots, &tickets[0], &results[0]);
+    uint32_t expected_succeeded = 0;
+    for (uint64_t i = 0; i < DispatchRing::kSlots; ++i) {
+      if (i % 7U != 3U) {
+        ++expected_succeeded;
+      }
+      DispatchOutput dummy = {i * 2U, 0};
+      verify_result(i, results[i], dummy);
+    }
+    EXPECT_EQ(expected_succeeded, succeeded);
+    EXPECT_EQ(kErrorCodeOk, pool->dispatch(0, "double_task", &input, sizeof(input), &ticket));
+    EXPECT_EQ(kErrorCodeOk, pool->collect_dispatch(ticket));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(DispatchRingTest, Stealing) {
+  EngineOptions options = get_tiny_options();
+  options.thread_.thread_count_per_group_ = 2;
+  Engine engine(options);
+  register_procs(&engine);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ThreadPool* pool = engine.get_thread_pool();
+    void* user_memory
+      = engine.get_soc_manager()->get_shared_memory_repo()->get_global_user_memory();
+    std::atomic<bool>* released = reinterpret_cast<std::atomic<bool>*>(user_memory);
+    released->store(false);
+
+    // Thread-0 is busy, so Thread-1 must run the invocations queued to Thread-0.
+    ImpersonateSession session;
+    EXPECT_TRUE(pool->impersonate_on_numa_core(0, "block_task", nullptr, 0, &session));
+    ThreadControlBlock* block = pool->get_thread_ref(0)->get_control_block();
+    while (block->status_ != kRunningTask) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // Each dispatch() also wakes up Thread-1, which is idle, rather than letting it sleep.
+    soc::SharedPolling* peer_wakeup = &pool->get_thread_ref(1)->get_control_block()->wakeup_cond_;
+    const uint64_t peer_ticket = peer_wakeup->acquire_ticket();
+    const uint64_t kCount = DispatchRing::kSlots / 2U;
+    std::vector<DispatchTicket> tickets(kCount);
+    for (uint64_t i = 0; i < kCount; ++i) {
+      EXPECT_EQ(kErrorCodeOk, pool->dispatch(0, "double_task", &i, sizeof(i), &tickets[i]));
+    }
+    EXPECT_LE(peer_ticket + kCount, peer_wakeup->acquire_ticket());
+    for (uint64_t i = 0; i < kCount; ++i) {
+      DispatchOutput output;
+      ErrorCode result = pool->collect_dispatch(tickets[i], &output, sizeof(output));
+      verify_result(i, result, output);
+      if (result == kErrorCodeOk) {
+        EXPECT_EQ(1, output.executed_by_) << i;
+      }
+    }
+    DispatchRing* ring = pool->get_thread_ref(0)->get_dispatch_ring();
+    EXPECT_EQ(kCount, ring->stat_stolen_.load());
+    EXPECT_EQ(kCount, ring->stat_dispatched_.load());
+
+    released->store(true);
+    COERCE_ERROR(session.get_result());
+    session.release();
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+}  // namespace thread
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(DispatchRingTest, foedus.thread);
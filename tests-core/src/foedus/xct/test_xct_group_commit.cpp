@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+#include "foedus/xct/xct_options.hpp"
+
+/**
+ * @file test_xct_group_commit.cpp
+ * Commit callbacks invoked by the commit notifier (group commit).
+ */
+namespace foedus {
+namespace xct {
+DEFINE_TEST_CASE_PACKAGE(XctGroupCommitTest, foedus.xct);
+
+const uint32_t kRecords = 16;
+const uint32_t kXcts = 100;
+
+/** Shared with the callbacks. Static because cancelled callbacks run during uninitialize(). */
+struct CallbackState {
+  Engine*                 engine_;
+  std::atomic<uint32_t>   invoked_;
+  std::atomic<uint32_t>   cancelled_;
+  std::atomic<uint32_t>   not_durable_;
+};
+CallbackState callback_state;
+
+void commit_callback(ErrorCode result, Epoch commit_epoch, void* user_data) {
+  CallbackState* state = reinterpret_cast<CallbackState*>(user_data);
+  if (result == kErrorCodeXctCommitCallbackCancelled) {
+    ++state->cancelled_;
+    return;
+  }
+  EXPECT_EQ(kErrorCodeOk, result);
+  if (commit_epoch > state->engine_->get_log_manager()->get_durable_global_epoch()) {
+    ++state->not_durable_;
+  }
+  ++state->invoked_;
+}
+
+ErrorStack commit_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  storage::array::ArrayStorage storage(context->get_engine(), "test");
+  for (uint32_t i = 0; i < kXcts; ++i) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, kSerializable));
+    uint64_t data = i;
+    WRAP_ERROR_CODE(storage.overwrite_record(context, i % kRecords, &data));
+    Epoch commit_epoch;
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+    // Registering the callback never blocks. We immediately move on to the next xct.
+    WRAP_ERROR_CODE(xct_manager->register_commit_callback(
+      context,
+      commit_epoch,
+      commit_callback,
+      &callback_state));
+  }
+
+  SPINLOCK_WHILE(callback_state.invoked_ < kXcts) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return kRetOk;
+}
+
+ErrorStack cancel_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  // an epoch that never becomes durable before the engine shuts down
+  Epoch future_epoch = xct_manager->get_current_global_epoch();
+  for (uint32_t i = 0; i < 1000U; ++i) {
+    future_epoch = future_epoch.one_more();
+  }
+  for (uint32_t i = 0; i < kXcts; ++i) {
+    WRAP_ERROR_CODE(xct_manager->register_commit_callback(
+      context,
+      future_epoch,
+      commit_callback,
+      &callback_state));
+  }
+  return kRetOk;
+}
+
+void test_group_commit(uint32_t min_interval_ms, bool cancel) {
+  EngineOptions options = get_tiny_options();
+  if (min_interval_ms > 0) {
+    // With adaptive advancement, commits should not wait for this long interval.
+    options.xct_.epoch_advance_interval_ms_ = 1000;
+    options.xct_.epoch_advance_min_interval_ms_ = min_interval_ms;
+  }
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("commit_task", commit_task);
+  engine.get_proc_manager()->pre_register("cancel_task", cancel_task);
+  callback_state.engine_ = &engine;
+  callback_state.invoked_ = 0;
+  callback_state.cancelled_ = 0;
+  callback_state.not_durable_ = 0;
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::array::ArrayStorage storage;
+    storage::array::ArrayMetadata meta("test", sizeof(uint64_t), kRecords);
+    Epoch commit_epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &commit_epoch));
+    thread::ThreadPool* pool = engine.get_thread_pool();
+    if (cancel) {
+      COERCE_ERROR(pool->impersonate_synchronous("cancel_task"));
+    } else {
+      COERCE_ERROR(pool->impersonate_synchronous("commit_task"));
+    }
+    COERCE_ERROR(engine.uninitialize());
+  }
+  if (cancel) {
+    EXPECT_EQ(0U, callback_state.invoked_);
+    EXPECT_EQ(kXcts, callback_state.cancelled_);
+  } else {
+    EXPECT_EQ(kXcts, callback_state.invoked_);
+    EXPECT_EQ(0U, callback_state.cancelled_);
+  }
+  EXPECT_EQ(0U, callback_state.not_durable_);
+  cleanup_test(options);
+}
+
+TEST(XctGroupCommitTest, Callbacks) { test_group_commit(0, false); }
+TEST(XctGroupCommitTest, Adaptive) { test_group_commit(1, false); }
+TEST(XctGroupCommitTest, Cancelled) { test_group_commit(0, true); }
+
+}  // namespace xct
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(XctGroupCommitTest, foedus.xct);
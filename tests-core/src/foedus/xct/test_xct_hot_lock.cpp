@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <stdint.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/soc/shared_memory_repo.hpp"
+#include "foedus/soc/shared_rendezvous.hpp"
+#include "foedus/soc/soc_manager.hpp"
+#include "foedus/storage/page.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
+#include "foedus/xct/xct_access.hpp"
+#include "foedus/xct/xct_id.hpp"
+#include "foedus/xct/xct_manager.hpp"
+#include "foedus/xct/xct_options.hpp"
+
+/**
+ * @file test_xct_hot_lock.cpp
+ * Serializable transactions that lock records in hot pages during execution.
+ */
+namespace foedus {
+namespace xct {
+DEFINE_TEST_CASE_PACKAGE(XctHotLockTest, foedus.xct);
+
+const uint32_t kRecords = 16;
+const uint32_t kThreads = 8;
+const uint32_t kIncrementsPerThread = 200;
+
+ErrorStack init_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  storage::StorageManager* str_manager = context->get_engine()->get_storage_manager();
+  Epoch commit_epoch;
+  storage::array::ArrayStorage storage;
+  storage::array::ArrayMetadata meta("test", sizeof(uint64_t), kRecords);
+  CHECK_ERROR(str_manager->create_array(&meta, &storage, &commit_epoch));
+
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  for (uint32_t i = 0; i < kRecords; ++i) {
+    uint64_t data = 0;
+    CHECK_ERROR(storage.overwrite_record(context, i, &data));
+  }
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+/** Runs with hot_threshold_ = 0, so every serializable write locks the record. */
+ErrorStack single_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  Xct& xct = context->get_current_xct();
+  XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  storage::array::ArrayStorage storage(context->get_engine(), "test");
+  Epoch commit_epoch;
+
+  // reads stay optimistic. the write locks, and the write-set takes over the lock at commit.
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  uint64_t data;
+  CHECK_ERROR(storage.get_record(context, 3, &data));
+  EXPECT_EQ(0U, xct.get_hot_lock_set_size());
+  ++data;
+  CHECK_ERROR(storage.overwrite_record(context, 3, &data));
+  EXPECT_EQ(1U, xct.get_hot_lock_set_size());
+  LockableXctId* record3 = xct.get_hot_lock_set()[0].owner_id_address_;
+  EXPECT_TRUE(record3->is_keylocked());
+  EXPECT_TRUE(xct.is_hot_locked(record3));
+  CHECK_ERROR(storage.overwrite_record(context, 3, &data));
+  EXPECT_EQ(1U, xct.get_hot_lock_set_size());  // no duplicates
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  EXPECT_EQ(0U, xct.get_hot_lock_set_size());
+  EXPECT_FALSE(record3->is_keylocked());
+
+  // two records in the descending address order. the second one is not in canonical order,
+  // but it's not contended, so we get the lock by trying it.
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  CHECK_ERROR(storage.overwrite_record(context, 5, &data));
+  LockableXctId* record5 = xct.get_hot_lock_set()[0].owner_id_address_;
+  EXPECT_FALSE(xct.is_canonical_hot_lock_order(record3));
+  CHECK_ERROR(storage.overwrite_record(context, 3, &data));
+  EXPECT_EQ(2U, xct.get_hot_lock_set_size());
+  EXPECT_TRUE(record5->is_keylocked());
+  EXPECT_TRUE(record3->is_keylocked());
+  CHECK_ERROR(xct_manager->abort_xct(context));
+  EXPECT_EQ(0U, xct.get_hot_lock_set_size());
+  EXPECT_FALSE(record5->is_keylocked());
+  EXPECT_FALSE(record3->is_keylocked());
+
+  // read-only transactions don't serialize against each other
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  for (uint32_t i = 0; i < kRecords; ++i) {
+    CHECK_ERROR(storage.get_record(context, i, &data));
+  }
+  EXPECT_EQ(0U, xct.get_hot_lock_set_size());
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+/** Runs with a low hot_threshold_. Nothing is hot without aborts. */
+ErrorStack cold_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  Xct& xct = context->get_current_xct();
+  XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  storage::array::ArrayStorage storage(context->get_engine(), "test");
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  for (uint32_t i = 0; i < kRecords; ++i) {
+    uint64_t data;
+    CHECK_ERROR(storage.get_record(context, i, &data));
+    CHECK_ERROR(storage.overwrite_record(context, i, &data));
+  }
+  EXPECT_EQ(0U, xct.get_hot_lock_set_size());
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+LockableXctId* get_record_address(thread::Thread* context, uint32_t offset) {
+  Xct& xct = context->get_current_xct();
+  XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  storage::array::ArrayStorage storage(context->get_engine(), "test");
+  uint64_t data;
+  COERCE_ERROR_CODE(xct_manager->begin_xct(context, kSerializable));
+  COERCE_ERROR_CODE(storage.get_record(context, offset, &data));
+  LockableXctId* address = xct.get_read_set()[0].owner_id_address_;
+  COERCE_ERROR_CODE(xct_manager->abort_xct(context));
+  return address;
+}
+
+ErrorStack heat_task(const proc::ProcArguments& args) {
+  LockableXctId* address = get_record_address(args.context_, 0);
+  storage::to_page(address)->get_header().hotness_ = 200U;
+  return kRetOk;
+}
+
+ErrorStack check_decay_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  LockableXctId* address = get_record_address(context, 0);
+  const storage::PageHeader& header = storage::to_page(address)->get_header();
+  EXPECT_FALSE(header.snapshot_);
+  EXPECT_EQ(100U, header.hotness_);
+
+  // the default hot_threshold_ never locks, even on a hot page
+  Xct& xct = context->get_current_xct();
+  EXPECT_FALSE(xct.is_hot_record(address));
+  return kRetOk;
+}
+
+ErrorStack try_increment(thread::Thread* context, storage::array::ArrayStorage* storage) {
+  XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  // also read a few other records in the same page in the reverse order
+  for (uint32_t i = kRecords - 1U; i > 0; i -= 5U) {
+    uint64_t data;
+    CHECK_ERROR(storage->get_record(context, i, &data));
+  }
+  uint64_t data;
+  CHECK_ERROR(storage->get_record(context, 0, &data));
+  ++data;
+  CHECK_ERROR(storage->overwrite_record(context, 0, &data));
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack increment_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  void* user_memory
+    = context->get_engine()->get_soc_manager()->get_shared_memory_repo()->get_global_user_memory();
+  soc::SharedRendezvous* rendezvous = reinterpret_cast<soc::SharedRendezvous*>(user_memory);
+  rendezvous->wait();
+  XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  storage::array::ArrayStorage storage(context->get_engine(), "test");
+  for (uint32_t i = 0; i < kIncrementsPerThread; ++i) {
+    while (true) {
+      ErrorStack error_stack = try_increment(context, &storage);
+      if (!error_stack.is_error()) {
+        break;
+      } else if (error_stack.get_error_code() == kErrorCodeXctRaceAbort) {
+        if (context->is_running_xct()) {
+          CHECK_ERROR(xct_manager->abort_xct(context));
+        }
+      } else {
+        COERCE_ERROR(error_stack);
+      }
+    }
+  }
+  return kRetOk;
+}
+
+ErrorStack verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  storage::array::ArrayStorage storage(context->get_engine(), "test");
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  uint64_t data;
+  CHECK_ERROR(storage.get_record(context, 0, &data));
+  EXPECT_EQ(kThreads * kIncrementsPerThread, data);
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+void run_single(uint16_t hot_threshold, const char* task_name, proc::Proc task) {
+  EngineOptions options = get_tiny_options();
+  options.xct_.hot_threshold_ = hot_threshold;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("init_task", init_task);
+  engine.get_proc_manager()->pre_register(task_name, task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("init_task"));
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous(task_name));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(XctHotLockTest, Decay) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("init_task", init_task);
+  engine.get_proc_manager()->pre_register("heat_task", heat_task);
+  engine.get_proc_manager()->pre_register("check_decay_task", check_decay_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("init_task"));
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("heat_task"));
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("check_decay_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+void run_contended(uint16_t hot_threshold) {
+  EngineOptions options = get_tiny_options();
+  options.thread_.thread_count_per_group_ = kThreads;
+  options.xct_.hot_threshold_ = hot_threshold;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("init_task", init_task);
+  engine.get_proc_manager()->pre_register("increment_task", increment_task);
+  engine.get_proc_manager()->pre_register("verify_task", verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    thread::ThreadPool* pool = engine.get_thread_pool();
+    COERCE_ERROR(pool->impersonate_synchronous("init_task"));
+    soc::SharedRendezvous* start_rendezvous
+      = reinterpret_cast<soc::SharedRendezvous*>(
+        engine.get_soc_manager()->get_shared_memory_repo()->get_global_user_memory());
+    start_rendezvous->initialize();
+    std::vector<thread::ImpersonateSession> sessions;
+    for (uint32_t i = 0; i < kThreads; ++i) {
+      thread::ImpersonateSession session;
+      EXPECT_TRUE(pool->impersonate("increment_task", nullptr, 0, &session));
+      sessions.emplace_back(std::move(session));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    start_rendezvous->signal();
+    for (uint32_t i = 0; i < kThreads; ++i) {
+      COERCE_ERROR(sessions[i].get_result());
+      sessions[i].release();
+    }
+    start_rendezvous->uninitialize();
+    COERCE_ERROR(pool->impersonate_synchronous("verify_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(XctHotLockTest, Single) { run_single(0, "single_task", single_task); }
+TEST(XctHotLockTest, Cold) { run_single(10, "cold_task", cold_task); }
+TEST(XctHotLockTest, ContendedAlwaysHot) { run_contended(0); }
+TEST(XctHotLockTest, ContendedWarm) { run_contended(10); }
+TEST(XctHotLockTest, ContendedNever) { run_contended(XctOptions::kHotThresholdNever); }
+
+}  // namespace xct
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(XctHotLockTest, foedus.xct);